@@ -0,0 +1,254 @@
+/*
+ * mcp-arena.c - Bump allocator for short-lived allocations
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+#include "mcp-arena.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+/* Alignment of every allocation; enough for gint64, gdouble and pointers */
+#define ARENA_ALIGN (2 * sizeof (gpointer))
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+#define ARENA_DEFAULT_CHUNK_SIZE (4096)
+
+typedef struct _ArenaChunk ArenaChunk;
+
+struct _ArenaChunk
+{
+    ArenaChunk *next;
+    gsize       size;
+    gsize       used;
+};
+
+/* Chunk payload starts after the header, rounded up to ARENA_ALIGN */
+#define CHUNK_DATA(chunk) ((guint8 *) (chunk) + ARENA_ROUND (sizeof (ArenaChunk)))
+
+struct _McpArena
+{
+    /* Chunk allocations are served from; newest first */
+    ArenaChunk *chunks;
+
+    gsize       chunk_size;
+    gsize       allocated;
+};
+
+static ArenaChunk *
+chunk_new (gsize size)
+{
+    ArenaChunk *chunk;
+
+    chunk = g_malloc (ARENA_ROUND (sizeof (ArenaChunk)) + size);
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+McpArena *
+mcp_arena_new (gsize chunk_size)
+{
+    McpArena *self;
+
+    self = g_new0 (McpArena, 1);
+    self->chunk_size = chunk_size > 0 ? ARENA_ROUND (chunk_size)
+                                      : ARENA_DEFAULT_CHUNK_SIZE;
+
+    return self;
+}
+
+void
+mcp_arena_free (McpArena *self)
+{
+    ArenaChunk *chunk;
+
+    if (self == NULL)
+    {
+        return;
+    }
+
+    chunk = self->chunks;
+    while (chunk != NULL)
+    {
+        ArenaChunk *next = chunk->next;
+
+        g_free (chunk);
+        chunk = next;
+    }
+
+    g_free (self);
+}
+
+void
+mcp_arena_reset (McpArena *self)
+{
+    ArenaChunk *keep = NULL;
+    ArenaChunk *chunk;
+
+    g_return_if_fail (self != NULL);
+
+    /* Keep one regular-sized chunk so the next message starts warm */
+    chunk = self->chunks;
+    while (chunk != NULL)
+    {
+        ArenaChunk *next = chunk->next;
+
+        if (keep == NULL && chunk->size == self->chunk_size)
+        {
+            keep = chunk;
+        }
+        else
+        {
+            self->allocated -= chunk->size;
+            g_free (chunk);
+        }
+        chunk = next;
+    }
+
+    if (keep != NULL)
+    {
+        keep->next = NULL;
+        keep->used = 0;
+    }
+    self->chunks = keep;
+}
+
+gpointer
+mcp_arena_alloc (McpArena *self,
+                 gsize     size)
+{
+    ArenaChunk *chunk;
+    gpointer mem;
+
+    g_return_val_if_fail (self != NULL, NULL);
+
+    size = ARENA_ROUND (MAX (size, 1));
+    chunk = self->chunks;
+
+    if (G_LIKELY (chunk != NULL && chunk->size - chunk->used >= size))
+    {
+        mem = CHUNK_DATA (chunk) + chunk->used;
+        chunk->used += size;
+        return mem;
+    }
+
+    if (size > self->chunk_size / 4)
+    {
+        /* Big allocations get their own chunk, placed behind the
+         * current one so its free space is still used */
+        ArenaChunk *big = chunk_new (size);
+
+        big->used = size;
+        self->allocated += size;
+
+        if (chunk != NULL)
+        {
+            big->next = chunk->next;
+            chunk->next = big;
+        }
+        else
+        {
+            self->chunks = big;
+        }
+
+        return CHUNK_DATA (big);
+    }
+
+    chunk = chunk_new (self->chunk_size);
+    chunk->next = self->chunks;
+    self->chunks = chunk;
+    self->allocated += chunk->size;
+
+    chunk->used = size;
+    return CHUNK_DATA (chunk);
+}
+
+gpointer
+mcp_arena_alloc0 (McpArena *self,
+                  gsize     size)
+{
+    gpointer mem;
+
+    mem = mcp_arena_alloc (self, size);
+    if (mem != NULL)
+    {
+        memset (mem, 0, size);
+    }
+
+    return mem;
+}
+
+gchar *
+mcp_arena_strndup (McpArena    *self,
+                   const gchar *str,
+                   gsize        len)
+{
+    gchar *copy;
+
+    g_return_val_if_fail (self != NULL, NULL);
+
+    if (str == NULL)
+    {
+        return NULL;
+    }
+
+    len = strnlen (str, len);
+    copy = mcp_arena_alloc (self, len + 1);
+    memcpy (copy, str, len);
+    copy[len] = '\0';
+
+    return copy;
+}
+
+gchar *
+mcp_arena_strdup (McpArena    *self,
+                  const gchar *str)
+{
+    g_return_val_if_fail (self != NULL, NULL);
+
+    if (str == NULL)
+    {
+        return NULL;
+    }
+
+    return mcp_arena_strndup (self, str, strlen (str));
+}
+
+gchar *
+mcp_arena_strdup_printf (McpArena    *self,
+                         const gchar *format,
+                         ...)
+{
+    va_list args;
+    gint len;
+    gchar *str;
+
+    g_return_val_if_fail (self != NULL, NULL);
+    g_return_val_if_fail (format != NULL, NULL);
+
+    /* Measure, then format in place; the strings formatted on the
+     * dispatch path are short, so the second pass is cheap */
+    va_start (args, format);
+    len = g_vsnprintf (NULL, 0, format, args);
+    va_end (args);
+
+    str = mcp_arena_alloc (self, (gsize) len + 1);
+
+    va_start (args, format);
+    g_vsnprintf (str, (gulong) len + 1, format, args);
+    va_end (args);
+
+    return str;
+}
+
+gsize
+mcp_arena_get_allocated (McpArena *self)
+{
+    g_return_val_if_fail (self != NULL, 0);
+
+    return self->allocated;
+}
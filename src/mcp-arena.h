@@ -0,0 +1,155 @@
+/*
+ * mcp-arena.h - Bump allocator for short-lived allocations
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * McpArena hands out memory from large chunks and releases all of it at
+ * once.  McpServer borrows one per thread while it dispatches an
+ * incoming message and resets it afterwards, so the bookkeeping for a
+ * request costs no malloc or free calls once the first chunk exists.
+ */
+
+#ifndef MCP_ARENA_H
+#define MCP_ARENA_H
+
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * McpArena:
+ *
+ * An opaque bump allocator.  Memory from an arena is not freed
+ * individually; it all becomes invalid at the next mcp_arena_reset()
+ * or mcp_arena_free().  Anything that must outlive that point has to
+ * be copied out with the regular allocator.
+ *
+ * An arena is not thread-safe.
+ */
+typedef struct _McpArena McpArena;
+
+/**
+ * mcp_arena_new:
+ * @chunk_size: size of each chunk in bytes, or 0 for the default (4 KiB)
+ *
+ * Creates a new arena.  No memory is allocated until the first
+ * allocation.
+ *
+ * Returns: (transfer full): a new #McpArena
+ */
+McpArena *mcp_arena_new (gsize chunk_size);
+
+/**
+ * mcp_arena_free:
+ * @self: (nullable): a #McpArena
+ *
+ * Frees the arena and every allocation made from it.
+ */
+void mcp_arena_free (McpArena *self);
+
+/**
+ * mcp_arena_reset:
+ * @self: a #McpArena
+ *
+ * Invalidates every allocation made from the arena.  The first chunk
+ * is kept for reuse; larger chunks allocated for a burst are freed.
+ */
+void mcp_arena_reset (McpArena *self);
+
+/**
+ * mcp_arena_alloc:
+ * @self: a #McpArena
+ * @size: number of bytes
+ *
+ * Allocates @size bytes, aligned for any basic type.  Requests larger
+ * than the chunk size get a chunk of their own.
+ *
+ * Returns: (transfer none): uninitialized memory owned by the arena
+ */
+gpointer mcp_arena_alloc (McpArena *self,
+                          gsize     size);
+
+/**
+ * mcp_arena_alloc0:
+ * @self: a #McpArena
+ * @size: number of bytes
+ *
+ * Like mcp_arena_alloc(), but the memory is zeroed.
+ *
+ * Returns: (transfer none): zeroed memory owned by the arena
+ */
+gpointer mcp_arena_alloc0 (McpArena *self,
+                           gsize     size);
+
+/**
+ * mcp_arena_new0:
+ * @arena: a #McpArena
+ * @struct_type: the type of the struct to allocate
+ *
+ * Allocates one zeroed @struct_type from @arena.
+ *
+ * Returns: (transfer none): a pointer to the struct
+ */
+#define mcp_arena_new0(arena, struct_type) \
+    ((struct_type *) mcp_arena_alloc0 ((arena), sizeof (struct_type)))
+
+/**
+ * mcp_arena_strndup:
+ * @self: a #McpArena
+ * @str: (nullable): a string
+ * @len: maximum number of bytes to copy
+ *
+ * Copies at most @len bytes of @str into the arena and NUL-terminates
+ * the copy.
+ *
+ * Returns: (transfer none) (nullable): the copy, or %NULL if @str is %NULL
+ */
+gchar *mcp_arena_strndup (McpArena    *self,
+                          const gchar *str,
+                          gsize        len);
+
+/**
+ * mcp_arena_strdup:
+ * @self: a #McpArena
+ * @str: (nullable): a string
+ *
+ * Copies @str into the arena.
+ *
+ * Returns: (transfer none) (nullable): the copy, or %NULL if @str is %NULL
+ */
+gchar *mcp_arena_strdup (McpArena    *self,
+                         const gchar *str);
+
+/**
+ * mcp_arena_strdup_printf:
+ * @self: a #McpArena
+ * @format: a printf() format string
+ * @...: the parameters for @format
+ *
+ * Formats a string directly into the arena.
+ *
+ * Returns: (transfer none): the formatted string
+ */
+gchar *mcp_arena_strdup_printf (McpArena    *self,
+                                const gchar *format,
+                                ...) G_GNUC_PRINTF (2, 3);
+
+/**
+ * mcp_arena_get_allocated:
+ * @self: a #McpArena
+ *
+ * Gets the number of bytes obtained from the system allocator and not
+ * yet released, which is useful for checking how well the chunk size
+ * fits the workload.
+ *
+ * Returns: the number of bytes held in chunks
+ */
+gsize mcp_arena_get_allocated (McpArena *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (McpArena, mcp_arena_free)
+
+G_END_DECLS
+
+#endif /* MCP_ARENA_H */
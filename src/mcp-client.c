@@ -462,6 +462,26 @@ send_initialize_request (McpClient *self)
     json_builder_set_member_name (builder, "protocolVersion");
     json_builder_add_string_value (builder, MCP_PROTOCOL_VERSION);
 
+    /* Let the server pass large resource contents as descriptors */
+    if (self->transport != NULL &&
+        mcp_transport_supports_fd_passing (self->transport) &&
+        mcp_client_capabilities_get_experimental (self->capabilities,
+                                                  MCP_TRANSPORT_FD_PASSING) == NULL)
+    {
+        mcp_client_capabilities_set_experimental (self->capabilities,
+                                                  MCP_TRANSPORT_FD_PASSING, NULL);
+    }
+
+    /* ...or as downloads fetched outside the message stream */
+    if (self->transport != NULL &&
+        mcp_transport_supports_downloads (self->transport) &&
+        mcp_client_capabilities_get_experimental (self->capabilities,
+                                                  MCP_TRANSPORT_DOWNLOAD) == NULL)
+    {
+        mcp_client_capabilities_set_experimental (self->capabilities,
+                                                  MCP_TRANSPORT_DOWNLOAD, NULL);
+    }
+
     json_builder_set_member_name (builder, "capabilities");
     {
         g_autoptr(JsonNode) caps = mcp_client_capabilities_to_json (self->capabilities);
@@ -1545,8 +1565,67 @@ parse_resource_templates_response (JsonNode *result)
     return g_list_reverse (list);
 }
 
+/* The server's reference to data it sent out of band, or NULL */
+static JsonObject *
+get_meta_ref (JsonObject  *item,
+              const gchar *name)
+{
+    JsonObject *meta;
+    JsonNode *ref;
+
+    if (!json_object_has_member (item, "_meta"))
+    {
+        return NULL;
+    }
+
+    meta = json_object_get_object_member (item, "_meta");
+    if (meta == NULL || !json_object_has_member (meta, name))
+    {
+        return NULL;
+    }
+
+    ref = json_object_get_member (meta, name);
+    if (!JSON_NODE_HOLDS_OBJECT (ref))
+    {
+        return NULL;
+    }
+
+    return json_node_get_object (ref);
+}
+
+/*
+ * ResourceRead:
+ *
+ * A resources/read response whose bulk contents are still being
+ * downloaded.  The task completes once every download has finished.
+ */
+typedef struct
+{
+    GTask  *task;
+    GList  *contents;
+    guint   pending;
+    GError *error;
+} ResourceRead;
+
+typedef struct
+{
+    ResourceRead *read;
+    GList        *link;     /* placeholder entry in read->contents */
+    gchar        *url;
+} ResourceDownload;
+
+static void
+resource_download_free (ResourceDownload *download)
+{
+    g_free (download->url);
+    g_free (download);
+}
+
 static GList *
-parse_resource_read_response (JsonNode *result)
+parse_resource_read_response (McpClient  *self,
+                              JsonNode   *result,
+                              GPtrArray  *downloads,
+                              GError    **error)
 {
     GList *list = NULL;
     JsonObject *obj;
@@ -1573,13 +1652,46 @@ parse_resource_read_response (JsonNode *result)
         const gchar *uri = json_object_get_string_member (item, "uri");
         const gchar *mime_type = NULL;
         McpResourceContents *contents = NULL;
+        JsonObject *fd_ref;
+        JsonObject *download_ref;
 
         if (json_object_has_member (item, "mimeType"))
         {
             mime_type = json_object_get_string_member (item, "mimeType");
         }
 
-        if (json_object_has_member (item, "text"))
+        fd_ref = get_meta_ref (item, MCP_TRANSPORT_FD_PASSING);
+        download_ref = get_meta_ref (item, MCP_TRANSPORT_DOWNLOAD);
+
+        if (fd_ref != NULL && json_object_has_member (fd_ref, "handle"))
+        {
+            gint fd;
+
+            fd = mcp_transport_receive_fd (self->transport,
+                                           (gint) json_object_get_int_member (fd_ref, "handle"),
+                                           error);
+            if (fd < 0)
+            {
+                g_list_free_full (list, (GDestroyNotify) mcp_resource_contents_unref);
+                return NULL;
+            }
+            contents = mcp_resource_contents_new_from_fd (uri, fd, mime_type);
+        }
+        else if (download_ref != NULL && json_object_has_member (download_ref, "url"))
+        {
+            ResourceDownload *download;
+
+            /* Replaced by the downloaded data before the task completes */
+            contents = mcp_resource_contents_new_blob (uri, "", mime_type);
+            list = g_list_prepend (list, contents);
+
+            download = g_new0 (ResourceDownload, 1);
+            download->link = list;
+            download->url = g_strdup (json_object_get_string_member (download_ref, "url"));
+            g_ptr_array_add (downloads, download);
+            continue;
+        }
+        else if (json_object_has_member (item, "text"))
         {
             const gchar *text = json_object_get_string_member (item, "text");
             contents = mcp_resource_contents_new_text (uri, text, mime_type);
@@ -1599,6 +1711,91 @@ parse_resource_read_response (JsonNode *result)
     return g_list_reverse (list);
 }
 
+static void
+on_resource_downloaded (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+    ResourceDownload *download = user_data;
+    ResourceRead *read = download->read;
+    g_autoptr(GBytes) bytes = NULL;
+    GError *error = NULL;
+
+    bytes = mcp_transport_download_finish (MCP_TRANSPORT (source), result, &error);
+    if (bytes == NULL)
+    {
+        if (read->error == NULL)
+        {
+            read->error = error;
+        }
+        else
+        {
+            g_error_free (error);
+        }
+    }
+    else
+    {
+        McpResourceContents *placeholder = download->link->data;
+
+        download->link->data = mcp_resource_contents_new_from_bytes (
+            mcp_resource_contents_get_uri (placeholder),
+            bytes,
+            mcp_resource_contents_get_mime_type (placeholder));
+        mcp_resource_contents_unref (placeholder);
+    }
+
+    resource_download_free (download);
+
+    if (--read->pending > 0)
+    {
+        return;
+    }
+
+    if (read->error != NULL)
+    {
+        g_list_free_full (read->contents, (GDestroyNotify) mcp_resource_contents_unref);
+        g_task_return_error (read->task, read->error);
+    }
+    else
+    {
+        g_task_return_pointer (read->task, read->contents, NULL);
+    }
+
+    g_object_unref (read->task);
+    g_free (read);
+}
+
+/*
+ * Fetches the contents the server published as downloads, then
+ * completes @task with @contents.  Takes ownership of the downloads.
+ */
+static void
+fetch_resource_downloads (McpClient *self,
+                          GTask     *task,
+                          GList     *contents,
+                          GPtrArray *downloads)
+{
+    ResourceRead *read;
+    guint i;
+
+    read = g_new0 (ResourceRead, 1);
+    read->task = g_object_ref (task);
+    read->contents = contents;
+    read->pending = downloads->len;
+
+    for (i = 0; i < downloads->len; i++)
+    {
+        ResourceDownload *download = g_ptr_array_index (downloads, i);
+
+        download->read = read;
+        mcp_transport_download_async (self->transport,
+                                      download->url,
+                                      g_task_get_cancellable (task),
+                                      on_resource_downloaded,
+                                      download);
+    }
+}
+
 static GList *
 parse_prompts_response (JsonNode *result)
 {
@@ -1764,8 +1961,26 @@ handle_response (McpClient   *self,
 
             case 5: /* resources/read */
                 {
-                    GList *contents = parse_resource_read_response (result);
-                    g_task_return_pointer (task, contents, NULL);
+                    GError *error = NULL;
+                    GPtrArray *downloads = g_ptr_array_new ();
+                    GList *contents = parse_resource_read_response (self, result,
+                                                                    downloads, &error);
+
+                    if (error != NULL)
+                    {
+                        g_ptr_array_set_free_func (downloads,
+                                                   (GDestroyNotify) resource_download_free);
+                        g_task_return_error (task, error);
+                    }
+                    else if (downloads->len > 0)
+                    {
+                        fetch_resource_downloads (self, task, contents, downloads);
+                    }
+                    else
+                    {
+                        g_task_return_pointer (task, contents, NULL);
+                    }
+                    g_ptr_array_unref (downloads);
                 }
                 break;
 
@@ -167,6 +167,28 @@ mcp_message_type_get_type (void)
     return (GType) GPOINTER_TO_SIZE (g_define_type_id);
 }
 
+GType
+mcp_message_priority_get_type (void)
+{
+    static gpointer g_define_type_id = NULL;
+
+    if (g_once_init_enter_pointer (&g_define_type_id))
+    {
+        static const GEnumValue values[] = {
+            { MCP_MESSAGE_PRIORITY_HIGH, "MCP_MESSAGE_PRIORITY_HIGH", "high" },
+            { MCP_MESSAGE_PRIORITY_NORMAL, "MCP_MESSAGE_PRIORITY_NORMAL", "normal" },
+            { MCP_MESSAGE_PRIORITY_LOW, "MCP_MESSAGE_PRIORITY_LOW", "low" },
+            { 0, NULL, NULL }
+        };
+        GType type_id;
+
+        type_id = g_enum_register_static ("McpMessagePriority", values);
+        g_once_init_leave_pointer (&g_define_type_id, GSIZE_TO_POINTER (type_id));
+    }
+
+    return (GType) GPOINTER_TO_SIZE (g_define_type_id);
+}
+
 /*
  * String conversion utilities
  */
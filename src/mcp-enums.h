@@ -138,6 +138,29 @@ typedef enum {
 GType mcp_message_type_get_type (void) G_GNUC_CONST;
 #define MCP_TYPE_MESSAGE_TYPE (mcp_message_type_get_type ())
 
+/**
+ * McpMessagePriority:
+ * @MCP_MESSAGE_PRIORITY_HIGH: responses, error responses and requests
+ * @MCP_MESSAGE_PRIORITY_NORMAL: notifications such as task status and
+ *   list changes
+ * @MCP_MESSAGE_PRIORITY_LOW: progress and log notifications
+ *
+ * The lane an outgoing message waits in when a transport has to queue
+ * it.  Queued messages leave in priority order and, within a lane, in
+ * the order they were sent.  Cancellation and initialized
+ * notifications go in the high lane, so that later requests cannot
+ * overtake them, and #McpServer sends the response to a request that
+ * has had progress notifications in the low lane, behind them.
+ */
+typedef enum {
+    MCP_MESSAGE_PRIORITY_HIGH,
+    MCP_MESSAGE_PRIORITY_NORMAL,
+    MCP_MESSAGE_PRIORITY_LOW
+} McpMessagePriority;
+
+GType mcp_message_priority_get_type (void) G_GNUC_CONST;
+#define MCP_TYPE_MESSAGE_PRIORITY (mcp_message_priority_get_type ())
+
 /**
  * mcp_log_level_to_string:
  * @level: a #McpLogLevel
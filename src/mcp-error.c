@@ -106,6 +106,8 @@ mcp_error_code_from_json_rpc_code (gint json_rpc_code)
         return MCP_ERROR_TRANSPORT_ERROR;
     case -32002:
         return MCP_ERROR_TIMEOUT;
+    case -32003:
+        return MCP_ERROR_RATE_LIMITED;
     case -32042:
         return MCP_ERROR_URL_ELICITATION_REQUIRED;
     default:
@@ -33,6 +33,7 @@ GQuark mcp_error_quark (void);
  * @MCP_ERROR_CONNECTION_CLOSED: The connection was closed (MCP -32000)
  * @MCP_ERROR_TRANSPORT_ERROR: Transport-level error occurred (MCP -32001)
  * @MCP_ERROR_TIMEOUT: Operation timed out (MCP -32002)
+ * @MCP_ERROR_RATE_LIMITED: Request refused by a rate limit; retryable (MCP -32003)
  * @MCP_ERROR_URL_ELICITATION_REQUIRED: URL mode elicitation required (MCP -32042)
  * @MCP_ERROR_PROTOCOL_VERSION_MISMATCH: Protocol version negotiation failed
  * @MCP_ERROR_NOT_INITIALIZED: Operation attempted before initialization
@@ -58,6 +59,7 @@ typedef enum {
     MCP_ERROR_CONNECTION_CLOSED      = -32000,
     MCP_ERROR_TRANSPORT_ERROR        = -32001,
     MCP_ERROR_TIMEOUT                = -32002,
+    MCP_ERROR_RATE_LIMITED           = -32003,
     MCP_ERROR_URL_ELICITATION_REQUIRED = -32042,
 
     /* Library-specific error codes (positive values) */
@@ -6,9 +6,12 @@
  */
 #include "mcp-http-server-transport.h"
 #include "mcp-error.h"
+#include "mcp-json-parse.h"
+#include "mcp-json-writer.h"
 #undef MCP_COMPILATION
 
 #include <string.h>
+#include <sys/socket.h>
 
 /**
  * SECTION:mcp-http-server-transport
@@ -21,8 +24,49 @@
  * - Server-Sent Events (SSE) to send messages to clients
  *
  * This is the server-side counterpart to #McpHttpTransport.
+ *
+ * SSE events go out one at a time: the next is taken from an
+ * #McpWriteQueue, highest lane first, once libsoup has written the last,
+ * so responses go ahead of notifications queued behind a slow client.
+ *
+ * Bulk resource data can be served outside the message stream: the
+ * transport publishes it at a signed URL under /mcp-download/ that is
+ * valid for #McpHttpServerTransport:download-ttl seconds and answers
+ * GET and HEAD with Content-Length and single byte-range support.  The
+ * data is let go of once a full GET has been served or the URL
+ * expires, and at most #McpHttpServerTransport:download-limit bytes are
+ * held at once.
+ *
+ * Each transport serves one session.  To serve several at once on one
+ * port, run one transport per thread (each with its own thread-default
+ * #GMainContext) or per process, all with
+ * #McpHttpServerTransport:reuse-port set, and let the kernel spread new
+ * connections across them.  Every such shard also listens on a private
+ * loopback port and tags the session ids it issues with it; a POST, SSE
+ * GET or DELETE that lands on another shard is forwarded there, so a
+ * session's messages always reach the shard that owns its SSE stream.
+ * A new session landing on a busy shard is forwarded to a free one in
+ * the same process.
+ *
+ * The tag is signed with the group's shard key, so a client cannot
+ * point a session id at some other loopback port and have its request
+ * (Authorization header included) relayed there.  Only a request that
+ * came in on the private loopback port can claim to have been relayed.
  */
 
+/* Request header marking a request relayed by another shard */
+#define SHARD_FORWARDED_HEADER "Mcp-Shard-Forwarded"
+
+#define SHARD_KEY_SIZE         (32)
+
+/* Hex digits of the signature kept in a session id */
+#define SHARD_SIGNATURE_LENGTH (32)
+
+/* Prefix of the URLs published with mcp_transport_publish_download() */
+#define DOWNLOAD_PATH     "/mcp-download/"
+
+#define DOWNLOAD_KEY_SIZE (32)
+
 struct _McpHttpServerTransport
 {
     GObject parent_instance;
@@ -35,24 +79,66 @@ struct _McpHttpServerTransport
     gboolean require_auth;
     gchar *auth_token;
     GTlsCertificate *tls_certificate;
+    gboolean reuse_port;
+    gchar *shard_key;
 
     /* Server */
     SoupServer *server;
     guint actual_port;
 
+    /* Sharding: private loopback port, and the session used to relay
+     * requests to the shard that owns their session, or to a free one
+     * for a new session */
+    guint        shard_port;
+    SoupSession *forward_session;
+    GList       *forwards;      /* ForwardData being relayed */
+
     /* Client state (single client model) */
     gchar *session_id;
     SoupServerMessage *sse_message;
     gboolean client_connected;
     guint event_id_counter;
 
+    /* SSE events waiting for the last one to be written, by priority */
+    McpWriteQueue *sse_queue;
+    gboolean       sse_writing;
+
     /* Transport state */
     McpTransportState state;
 
     /* Streamable HTTP: pending POST response for inline reply */
     SoupServerMessage *pending_post_msg;
+
+    /* Reused to serialize outgoing messages */
+    McpJsonWriter *writer;
+
+    /* Published downloads: id -> Download */
+    GHashTable *downloads;
+    guint       download_ttl;
+    guint64     download_limit;
+    guint64     download_bytes;     /* held by downloads */
+    GSource    *download_prune_source;
+    gint64      download_prune_at;  /* wall-clock seconds */
+    guint8      download_key[DOWNLOAD_KEY_SIZE];
 };
 
+typedef struct
+{
+    McpHttpServerTransport *owner;
+    GBytes *data;
+    gchar  *mime_type;
+    gint64  expires;      /* wall-clock seconds */
+} Download;
+
+static void
+download_free (Download *download)
+{
+    download->owner->download_bytes -= g_bytes_get_size (download->data);
+    g_bytes_unref (download->data);
+    g_free (download->mime_type);
+    g_free (download);
+}
+
 static void mcp_http_server_transport_iface_init (McpTransportInterface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (McpHttpServerTransport, mcp_http_server_transport, G_TYPE_OBJECT,
@@ -70,6 +156,10 @@ enum
     PROP_REQUIRE_AUTH,
     PROP_AUTH_TOKEN,
     PROP_TLS_CERTIFICATE,
+    PROP_DOWNLOAD_TTL,
+    PROP_DOWNLOAD_LIMIT,
+    PROP_REUSE_PORT,
+    PROP_SHARD_KEY,
     N_PROPERTIES
 };
 
@@ -95,17 +185,247 @@ set_state (McpHttpServerTransport *self,
     mcp_transport_emit_state_changed (MCP_TRANSPORT (self), old_state, new_state);
 }
 
+/* Compares in time independent of where the strings differ */
+static gboolean
+signature_equal (const gchar *a,
+                 const gchar *b)
+{
+    gsize len = strlen (a);
+    guint8 diff = 0;
+    gsize i;
+
+    if (len != strlen (b))
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        diff |= (guint8) (a[i] ^ b[i]);
+    }
+
+    return diff == 0;
+}
+
+/* The key shards in one process share unless one is configured */
+static const guint8 *
+default_shard_key (void)
+{
+    static guint8 key[SHARD_KEY_SIZE];
+    static gsize initialized = 0;
+
+    if (g_once_init_enter (&initialized))
+    {
+        guint i;
+
+        for (i = 0; i < SHARD_KEY_SIZE; i += sizeof (guint32))
+        {
+            guint32 r = g_random_int ();
+
+            memcpy (key + i, &r, sizeof r);
+        }
+        g_once_init_leave (&initialized, 1);
+    }
+
+    return key;
+}
+
+/*
+ * Signs a session's UUID and shard port with the group's shard key
+ */
+static gchar *
+sign_shard (McpHttpServerTransport *self,
+            const gchar            *uuid,
+            gsize                   uuid_len,
+            guint                   port)
+{
+    g_autofree gchar *payload = NULL;
+    gchar *signature;
+
+    payload = g_strdup_printf ("%.*s.%u", (gint) uuid_len, uuid, port);
+    if (self->shard_key != NULL)
+    {
+        signature = g_compute_hmac_for_string (G_CHECKSUM_SHA256,
+                                               (const guchar *) self->shard_key,
+                                               strlen (self->shard_key),
+                                               payload, -1);
+    }
+    else
+    {
+        signature = g_compute_hmac_for_string (G_CHECKSUM_SHA256,
+                                               default_shard_key (), SHARD_KEY_SIZE,
+                                               payload, -1);
+    }
+    signature[SHARD_SIGNATURE_LENGTH] = '\0';
+
+    return signature;
+}
+
 /*
- * Generate a UUID for session ID
+ * Generate a UUID for session ID.  Shards append a signature and their
+ * loopback port so that other shards know where to forward the
+ * session's POSTs.
  */
 static gchar *
-generate_session_id (void)
+generate_session_id (McpHttpServerTransport *self)
 {
     g_autofree gchar *uuid = NULL;
+    g_autofree gchar *signature = NULL;
     uuid = g_uuid_string_random ();
+
+    if (self->shard_port != 0)
+    {
+        signature = sign_shard (self, uuid, strlen (uuid), self->shard_port);
+        return g_strdup_printf ("%s.%s.%u", uuid, signature, self->shard_port);
+    }
+
     return g_steal_pointer (&uuid);
 }
 
+/*
+ * Returns the shard port encoded in a session ID, or 0 if there is none
+ * or its signature does not match
+ */
+static guint
+session_shard_port (McpHttpServerTransport *self,
+                    const gchar            *session_id)
+{
+    g_autofree gchar *signature = NULL;
+    g_autofree gchar *expected = NULL;
+    const gchar *port_dot;
+    const gchar *signature_dot;
+    guint64 port;
+
+    port_dot = strrchr (session_id, '.');
+    if (port_dot == NULL ||
+        !g_ascii_string_to_unsigned (port_dot + 1, 10, 1, G_MAXUINT16, &port, NULL))
+    {
+        return 0;
+    }
+
+    signature_dot = g_strrstr_len (session_id, port_dot - session_id, ".");
+    if (signature_dot == NULL)
+    {
+        return 0;
+    }
+
+    signature = g_strndup (signature_dot + 1, port_dot - signature_dot - 1);
+    expected = sign_shard (self, session_id, signature_dot - session_id, (guint) port);
+    if (!signature_equal (signature, expected))
+    {
+        return 0;
+    }
+
+    return (guint) port;
+}
+
+/*
+ * Whether @msg came in on the private loopback port, which only other
+ * shards are told about, rather than the shared one
+ */
+static gboolean
+received_on_shard_port (McpHttpServerTransport *self,
+                        SoupServerMessage      *msg)
+{
+    GSocketAddress *local;
+
+    local = soup_server_message_get_local_address (msg);
+    return local != NULL && G_IS_INET_SOCKET_ADDRESS (local) &&
+           g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (local)) == self->shard_port;
+}
+
+/*
+ * The shards listening in this process, so that a busy shard can hand
+ * a new session to a free one.  Shards in other processes are not
+ * known here.
+ */
+typedef struct
+{
+    guint  port;
+    gchar *shard_key;
+} ShardEntry;
+
+static GMutex  shard_group_lock;
+static GSList *shard_group = NULL;
+
+static void
+shard_group_add (McpHttpServerTransport *self)
+{
+    ShardEntry *entry;
+
+    entry = g_new0 (ShardEntry, 1);
+    entry->port = self->shard_port;
+    entry->shard_key = g_strdup (self->shard_key);
+
+    g_mutex_lock (&shard_group_lock);
+    shard_group = g_slist_prepend (shard_group, entry);
+    g_mutex_unlock (&shard_group_lock);
+}
+
+static void
+shard_group_remove (McpHttpServerTransport *self)
+{
+    GSList *l;
+
+    g_mutex_lock (&shard_group_lock);
+    for (l = shard_group; l != NULL; l = l->next)
+    {
+        ShardEntry *entry = l->data;
+
+        if (entry->port == self->shard_port)
+        {
+            shard_group = g_slist_delete_link (shard_group, l);
+            g_free (entry->shard_key);
+            g_free (entry);
+            break;
+        }
+    }
+    g_mutex_unlock (&shard_group_lock);
+}
+
+/*
+ * Returns the loopback ports of the other shards in this process that
+ * sign with the same key, starting at a random one so that new
+ * sessions are spread across them
+ */
+static GArray *
+shard_group_ports (McpHttpServerTransport *self)
+{
+    GArray *ports;
+    GSList *l;
+    guint start;
+    guint i;
+
+    ports = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    g_mutex_lock (&shard_group_lock);
+    for (l = shard_group; l != NULL; l = l->next)
+    {
+        ShardEntry *entry = l->data;
+
+        if (entry->port != self->shard_port &&
+            g_strcmp0 (entry->shard_key, self->shard_key) == 0)
+        {
+            g_array_append_val (ports, entry->port);
+        }
+    }
+    g_mutex_unlock (&shard_group_lock);
+
+    if (ports->len > 1)
+    {
+        start = (guint) g_random_int_range (0, (gint32) ports->len);
+        for (i = 0; i < start; i++)
+        {
+            guint port = g_array_index (ports, guint, 0);
+
+            g_array_remove_index (ports, 0);
+            g_array_append_val (ports, port);
+        }
+    }
+
+    return ports;
+}
+
 /*
  * Validate authentication token from request headers
  */
@@ -180,6 +500,7 @@ send_sse_event (McpHttpServerTransport *self,
 
     body = soup_server_message_get_response_body (self->sse_message);
     soup_message_body_append (body, SOUP_MEMORY_COPY, event_str, strlen (event_str));
+    self->sse_writing = TRUE;
 
     /* Trigger sending the chunk */
     soup_server_message_unpause (self->sse_message);
@@ -187,6 +508,81 @@ send_sse_event (McpHttpServerTransport *self,
     return TRUE;
 }
 
+typedef struct
+{
+    GTask *task;
+    gchar *data;
+} SseEntry;
+
+static void
+sse_entry_free (SseEntry *entry)
+{
+    g_object_unref (entry->task);
+    g_free (entry->data);
+    g_free (entry);
+}
+
+/*
+ * Sends the next queued event, unless the last one is still being
+ * written
+ */
+static void
+flush_sse_queue (McpHttpServerTransport *self)
+{
+    SseEntry *entry;
+
+    if (self->sse_writing || self->sse_message == NULL)
+    {
+        return;
+    }
+
+    entry = mcp_write_queue_pop (self->sse_queue);
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    send_sse_event (self, "message", entry->data);
+    g_task_return_boolean (entry->task, TRUE);
+    sse_entry_free (entry);
+}
+
+/*
+ * Fails every queued event; the stream they were meant for is gone
+ */
+static void
+fail_sse_queue (McpHttpServerTransport *self)
+{
+    SseEntry *entry;
+
+    self->sse_writing = FALSE;
+    while ((entry = mcp_write_queue_pop (self->sse_queue)) != NULL)
+    {
+        g_task_return_new_error (entry->task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "SSE stream closed before the message was sent");
+        sse_entry_free (entry);
+    }
+}
+
+static void
+on_sse_wrote_chunk (SoupServerMessage *msg,
+                    gpointer           user_data)
+{
+    McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (user_data);
+
+    if (self->sse_message == msg)
+    {
+        self->sse_writing = FALSE;
+        flush_sse_queue (self);
+    }
+}
+
+static gboolean route_to_shard (McpHttpServerTransport *self,
+                                SoupServerMessage      *msg,
+                                GHashTable             *query,
+                                const gchar            *content_type,
+                                gboolean                streaming);
+
 /*
  * Handle SSE connection (GET request to sse_path)
  */
@@ -201,6 +597,7 @@ handle_sse_request (SoupServer        *server,
     SoupMessageHeaders *response_headers;
     SoupMessageHeaders *request_headers;
     const gchar *accept_header;
+    const gchar *session_id;
 
     /* Validate authentication */
     if (!validate_auth (self, msg))
@@ -218,6 +615,11 @@ handle_sse_request (SoupServer        *server,
         return;
     }
 
+    if (route_to_shard (self, msg, query, NULL, TRUE))
+    {
+        return;
+    }
+
     /* Only allow one client at a time */
     if (self->client_connected)
     {
@@ -225,9 +627,24 @@ handle_sse_request (SoupServer        *server,
         return;
     }
 
-    /* Generate session ID */
-    g_free (self->session_id);
-    self->session_id = generate_session_id ();
+    /* A client that opened its session with a POST keeps its id; one
+     * naming some other live session is not let into it */
+    session_id = soup_message_headers_get_one (request_headers, "Mcp-Session-Id");
+    if (session_id == NULL && query != NULL)
+    {
+        session_id = (const gchar *)g_hash_table_lookup (query, "sessionId");
+    }
+    if (session_id != NULL && self->session_id != NULL &&
+        g_strcmp0 (session_id, self->session_id) != 0)
+    {
+        soup_server_message_set_status (msg, SOUP_STATUS_NOT_FOUND, "Unknown session");
+        return;
+    }
+    if (session_id == NULL || self->session_id == NULL)
+    {
+        g_free (self->session_id);
+        self->session_id = generate_session_id (self);
+    }
 
     /* Set response headers */
     response_headers = soup_server_message_get_response_headers (msg);
@@ -239,11 +656,14 @@ handle_sse_request (SoupServer        *server,
 
     /* Set status and enable chunked encoding */
     soup_server_message_set_status (msg, SOUP_STATUS_OK, NULL);
+    soup_message_headers_set_encoding (response_headers, SOUP_ENCODING_CHUNKED);
 
     /* Store the message for sending events */
     self->sse_message = msg;
     self->client_connected = TRUE;
     self->event_id_counter = 0;
+    self->sse_writing = FALSE;
+    g_signal_connect_object (msg, "wrote-chunk", G_CALLBACK (on_sse_wrote_chunk), self, 0);
 
     /* Pause the message - we'll unpause when we have data to send */
     soup_server_message_pause (msg);
@@ -273,6 +693,7 @@ on_sse_finished (SoupServerMessage *msg,
     {
         self->sse_message = NULL;
         self->client_connected = FALSE;
+        fail_sse_queue (self);
 
         g_free (self->session_id);
         self->session_id = NULL;
@@ -280,6 +701,471 @@ on_sse_finished (SoupServerMessage *msg,
     }
 }
 
+/*
+ * Headers that describe one hop rather than the request itself
+ */
+static gboolean
+is_hop_by_hop_header (const gchar *name)
+{
+    static const gchar * const hop_headers[] = {
+        "Connection", "Keep-Alive", "Proxy-Authenticate",
+        "Proxy-Authorization", "TE", "Trailer", "Transfer-Encoding",
+        "Upgrade", "Host", "Content-Length", NULL
+    };
+    guint i;
+
+    for (i = 0; hop_headers[i] != NULL; i++)
+    {
+        if (g_ascii_strcasecmp (name, hop_headers[i]) == 0)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static void
+copy_request_header (const char *name,
+                     const char *value,
+                     gpointer    user_data)
+{
+    SoupMessageHeaders *headers = user_data;
+
+    if (!is_hop_by_hop_header (name))
+    {
+        soup_message_headers_append (headers, name, value);
+    }
+}
+
+/* Bytes read at a time from a shard's relayed SSE stream */
+#define FORWARD_CHUNK_SIZE (16 * 1024)
+
+typedef struct
+{
+    McpHttpServerTransport *self;        /* NULL once stop_server() ran */
+    SoupServerMessage      *msg;
+    SoupMessage            *forward;
+    gchar                  *content_type;
+    GBytes                 *body;
+    GArray                 *ports;       /* shards to try, in order */
+    guint                   next_port;
+    gboolean                streaming;   /* relay the reply as it comes */
+    GInputStream           *stream;
+    GCancellable           *cancellable;
+    gulong                  finished_id;
+    gboolean                client_gone;
+} ForwardData;
+
+static void
+forward_data_free (ForwardData *data)
+{
+    if (data->self != NULL)
+    {
+        data->self->forwards = g_list_remove (data->self->forwards, data);
+    }
+    g_signal_handler_disconnect (data->msg, data->finished_id);
+    g_object_unref (data->msg);
+    g_clear_object (&data->forward);
+    g_free (data->content_type);
+    g_clear_pointer (&data->body, g_bytes_unref);
+    g_array_unref (data->ports);
+    g_clear_object (&data->stream);
+    g_object_unref (data->cancellable);
+    g_free (data);
+}
+
+/*
+ * Ends the client's request with @status, or with what the shard
+ * answered when @status is 0
+ */
+static void
+forward_data_finish (ForwardData *data,
+                     guint        status,
+                     const gchar *reason)
+{
+    /* Nothing to answer if the client left or the server stopped */
+    if (!data->client_gone && data->self != NULL)
+    {
+        if (status != 0)
+        {
+            soup_server_message_set_status (data->msg, status, reason);
+        }
+        if (data->streaming)
+        {
+            soup_message_body_complete (soup_server_message_get_response_body (data->msg));
+        }
+        soup_server_message_unpause (data->msg);
+    }
+    forward_data_free (data);
+}
+
+/* The client went away; stop relaying to it */
+static void
+on_forwarded_msg_finished (SoupServerMessage *msg,
+                           gpointer           user_data)
+{
+    ForwardData *data = user_data;
+
+    data->client_gone = TRUE;
+    g_cancellable_cancel (data->cancellable);
+}
+
+/*
+ * Passes the shard's status and the headers a client acts on back to
+ * the client
+ */
+static void
+copy_forward_response (ForwardData *data)
+{
+    static const gchar * const headers[] = {
+        "Content-Type", "Mcp-Session-Id", "Cache-Control",
+        "X-Accel-Buffering", "Retry-After", NULL
+    };
+    SoupMessageHeaders *from;
+    SoupMessageHeaders *to;
+    guint i;
+
+    from = soup_message_get_response_headers (data->forward);
+    to = soup_server_message_get_response_headers (data->msg);
+    for (i = 0; headers[i] != NULL; i++)
+    {
+        const gchar *value = soup_message_headers_get_one (from, headers[i]);
+
+        if (value != NULL)
+        {
+            soup_message_headers_replace (to, headers[i], value);
+        }
+    }
+
+    soup_server_message_set_status (data->msg,
+                                    soup_message_get_status (data->forward),
+                                    NULL);
+}
+
+static void forward_send (ForwardData *data);
+
+/*
+ * Whether a shard turned a new session away and another one is left to
+ * ask
+ */
+static gboolean
+forward_try_next (ForwardData *data)
+{
+    if (soup_message_get_status (data->forward) != SOUP_STATUS_SERVICE_UNAVAILABLE ||
+        data->next_port >= data->ports->len ||
+        data->self == NULL)
+    {
+        return FALSE;
+    }
+
+    g_clear_object (&data->forward);
+    g_clear_object (&data->stream);
+    forward_send (data);
+    return TRUE;
+}
+
+/*
+ * Relays the owning shard's reply back to the client
+ */
+static void
+on_forward_finished (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+    ForwardData *data = user_data;
+    g_autoptr(GBytes) body = NULL;
+    g_autoptr(GError) error = NULL;
+
+    body = soup_session_send_and_read_finish (SOUP_SESSION (source), result, &error);
+    if (body == NULL)
+    {
+        forward_data_finish (data, SOUP_STATUS_BAD_GATEWAY, error->message);
+        return;
+    }
+
+    if (forward_try_next (data))
+    {
+        return;
+    }
+
+    copy_forward_response (data);
+    if (g_bytes_get_size (body) > 0)
+    {
+        soup_message_body_append_bytes (
+            soup_server_message_get_response_body (data->msg), body);
+    }
+    forward_data_finish (data, 0, NULL);
+}
+
+static void
+on_forward_read (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+    ForwardData *data = user_data;
+    g_autoptr(GBytes) chunk = NULL;
+
+    /* The stream ended, the client left or the transport stopped */
+    chunk = g_input_stream_read_bytes_finish (G_INPUT_STREAM (source), result, NULL);
+    if (chunk == NULL || g_bytes_get_size (chunk) == 0)
+    {
+        forward_data_finish (data, 0, NULL);
+        return;
+    }
+
+    soup_message_body_append_bytes (soup_server_message_get_response_body (data->msg), chunk);
+    soup_server_message_unpause (data->msg);
+
+    g_input_stream_read_bytes_async (data->stream, FORWARD_CHUNK_SIZE, G_PRIORITY_DEFAULT,
+                                     data->cancellable, on_forward_read, data);
+}
+
+/*
+ * Relays a shard's SSE stream back to the client as it arrives
+ */
+static void
+on_forward_sent (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+    ForwardData *data = user_data;
+    g_autoptr(GError) error = NULL;
+
+    data->stream = soup_session_send_finish (SOUP_SESSION (source), result, &error);
+    if (data->stream == NULL)
+    {
+        forward_data_finish (data, SOUP_STATUS_BAD_GATEWAY, error->message);
+        return;
+    }
+
+    if (forward_try_next (data))
+    {
+        return;
+    }
+
+    copy_forward_response (data);
+    if (soup_message_get_status (data->forward) != SOUP_STATUS_OK)
+    {
+        forward_data_finish (data, 0, NULL);
+        return;
+    }
+
+    soup_message_headers_set_encoding (soup_server_message_get_response_headers (data->msg),
+                                       SOUP_ENCODING_CHUNKED);
+    soup_server_message_unpause (data->msg);
+    g_input_stream_read_bytes_async (data->stream, FORWARD_CHUNK_SIZE, G_PRIORITY_DEFAULT,
+                                     data->cancellable, on_forward_read, data);
+}
+
+/*
+ * Sends the client's request on to the next shard in @data's list
+ */
+static void
+forward_send (ForwardData *data)
+{
+    McpHttpServerTransport *self = data->self;
+    GUri *uri;
+    const gchar *query;
+    g_autofree gchar *url = NULL;
+    g_autofree gchar *shard = NULL;
+    guint port;
+
+    port = g_array_index (data->ports, guint, data->next_port++);
+    uri = soup_server_message_get_uri (data->msg);
+    query = g_uri_get_query (uri);
+    url = g_strdup_printf ("http://127.0.0.1:%u%s%s%s",
+                           port, g_uri_get_path (uri),
+                           query != NULL ? "?" : "",
+                           query != NULL ? query : "");
+
+    data->forward = soup_message_new (soup_server_message_get_method (data->msg), url);
+    if (data->forward == NULL)
+    {
+        forward_data_finish (data, SOUP_STATUS_BAD_GATEWAY, NULL);
+        return;
+    }
+
+    soup_message_headers_foreach (soup_server_message_get_request_headers (data->msg),
+                                  copy_request_header,
+                                  soup_message_get_request_headers (data->forward));
+    shard = g_strdup_printf ("%u", self->shard_port);
+    soup_message_headers_replace (soup_message_get_request_headers (data->forward),
+                                  SHARD_FORWARDED_HEADER, shard);
+    if (data->content_type != NULL)
+    {
+        soup_message_set_request_body_from_bytes (data->forward, data->content_type,
+                                                  data->body);
+    }
+
+    if (self->forward_session == NULL)
+    {
+        self->forward_session = soup_session_new ();
+    }
+
+    if (data->streaming)
+    {
+        soup_session_send_async (self->forward_session, data->forward,
+                                 G_PRIORITY_DEFAULT, data->cancellable,
+                                 on_forward_sent, data);
+    }
+    else
+    {
+        soup_session_send_and_read_async (self->forward_session, data->forward,
+                                          G_PRIORITY_DEFAULT, data->cancellable,
+                                          on_forward_finished, data);
+    }
+}
+
+/*
+ * Relays @msg to the shards listening on loopback @ports, one after
+ * another while they answer 503 Service Unavailable.  @content_type is
+ * the request body's, or %NULL for a request without one.  With
+ * @streaming the reply is passed on as it arrives, for SSE.
+ */
+static void
+forward_request (McpHttpServerTransport *self,
+                 SoupServerMessage      *msg,
+                 const gchar            *content_type,
+                 GArray                 *ports,
+                 gboolean                streaming)
+{
+    ForwardData *data;
+
+    data = g_new0 (ForwardData, 1);
+    data->self = self;
+    data->msg = g_object_ref (msg);
+    data->content_type = g_strdup (content_type);
+    if (content_type != NULL)
+    {
+        data->body = soup_message_body_flatten (soup_server_message_get_request_body (msg));
+    }
+    data->ports = g_array_ref (ports);
+    data->streaming = streaming;
+    data->cancellable = g_cancellable_new ();
+    data->finished_id = g_signal_connect (msg, "finished",
+                                          G_CALLBACK (on_forwarded_msg_finished), data);
+    self->forwards = g_list_prepend (self->forwards, data);
+
+    soup_server_message_pause (msg);
+    forward_send (data);
+}
+
+/*
+ * Forwards @msg to the shard listening on loopback @owner_port
+ */
+static void
+forward_to_owner (McpHttpServerTransport *self,
+                  SoupServerMessage      *msg,
+                  const gchar            *content_type,
+                  guint                   owner_port,
+                  gboolean                streaming)
+{
+    g_autoptr(GArray) ports = NULL;
+
+    ports = g_array_sized_new (FALSE, FALSE, sizeof (guint), 1);
+    g_array_append_val (ports, owner_port);
+    forward_request (self, msg, content_type, ports, streaming);
+}
+
+/*
+ * Forwards a request opening a new session to the other shards of the
+ * group in this process, until one that is not serving a client takes
+ * it.  Answers 503 Service Unavailable if none is free.
+ */
+static void
+forward_new_session (McpHttpServerTransport *self,
+                     SoupServerMessage      *msg,
+                     const gchar            *content_type,
+                     gboolean                streaming)
+{
+    g_autoptr(GArray) ports = NULL;
+
+    ports = shard_group_ports (self);
+    if (ports->len == 0)
+    {
+        soup_message_headers_replace (soup_server_message_get_response_headers (msg),
+                                      "Retry-After", "1");
+        soup_server_message_set_status (msg, SOUP_STATUS_SERVICE_UNAVAILABLE,
+                                        "All shards are busy");
+        return;
+    }
+
+    forward_request (self, msg, content_type, ports, streaming);
+}
+
+/*
+ * Works out where a request to a sharded transport belongs.  Returns
+ * %TRUE if it has been relayed to another shard or answered, %FALSE if
+ * this shard should handle it.
+ *
+ * A shard only handles the sessions it issued, and new sessions only
+ * while it has none; the rest go to their owner or a free shard, unless
+ * another shard already relayed the request.  Session ids no shard of
+ * the group signed are not relayed anywhere.
+ */
+static gboolean
+route_to_shard (McpHttpServerTransport *self,
+                SoupServerMessage      *msg,
+                GHashTable             *query,
+                const gchar            *content_type,
+                gboolean                streaming)
+{
+    SoupMessageHeaders *request_headers;
+    const gchar *session_id;
+    guint owner_port = 0;
+    gboolean forwarded;
+
+    if (self->shard_port == 0)
+    {
+        return FALSE;
+    }
+
+    request_headers = soup_server_message_get_request_headers (msg);
+    session_id = soup_message_headers_get_one (request_headers, "Mcp-Session-Id");
+    if (session_id == NULL && query != NULL)
+    {
+        session_id = (const gchar *)g_hash_table_lookup (query, "sessionId");
+    }
+    if (session_id != NULL)
+    {
+        owner_port = session_shard_port (self, session_id);
+        if (owner_port == 0)
+        {
+            soup_server_message_set_status (msg, SOUP_STATUS_NOT_FOUND,
+                                            "Unknown session");
+            return TRUE;
+        }
+    }
+
+    forwarded = received_on_shard_port (self, msg) &&
+                soup_message_headers_get_one (request_headers,
+                                              SHARD_FORWARDED_HEADER) != NULL;
+
+    if (session_id == NULL && self->session_id != NULL)
+    {
+        /* Busy: the shard that relayed this asks the next one */
+        if (forwarded)
+        {
+            soup_server_message_set_status (msg, SOUP_STATUS_SERVICE_UNAVAILABLE,
+                                            "Shard is busy");
+        }
+        else
+        {
+            forward_new_session (self, msg, content_type, streaming);
+        }
+        return TRUE;
+    }
+
+    if (!forwarded && owner_port != 0 && owner_port != self->shard_port)
+    {
+        forward_to_owner (self, msg, content_type, owner_port, streaming);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
 /*
  * Handle POST request (client sending message)
  */
@@ -298,9 +1184,8 @@ handle_post_request (SoupServer        *server,
     g_autoptr(GBytes) request_body = NULL;
     const gchar *body_data;
     gsize body_len;
-    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(JsonNode) root = NULL;
     g_autoptr(GError) error = NULL;
-    JsonNode *root;
 
     /* Validate authentication */
     if (!validate_auth (self, msg))
@@ -318,6 +1203,11 @@ handle_post_request (SoupServer        *server,
         return;
     }
 
+    if (route_to_shard (self, msg, query, content_type, FALSE))
+    {
+        return;
+    }
+
     /* Validate session ID if we have an active SSE client.
      * Accept from Mcp-Session-Id header or sessionId query parameter. */
     if (self->client_connected && self->session_id != NULL)
@@ -348,8 +1238,8 @@ handle_post_request (SoupServer        *server,
     }
 
     /* Parse JSON */
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, body_data, body_len, &error))
+    root = mcp_json_parse (body_data, body_len, &error);
+    if (root == NULL)
     {
         g_autoptr(GError) parse_error = NULL;
 
@@ -361,13 +1251,6 @@ handle_post_request (SoupServer        *server,
         return;
     }
 
-    root = json_parser_get_root (parser);
-    if (root == NULL)
-    {
-        soup_server_message_set_status (msg, SOUP_STATUS_BAD_REQUEST, NULL);
-        return;
-    }
-
     /* Set response headers */
     response_headers = soup_server_message_get_response_headers (msg);
     soup_message_headers_replace (response_headers, "Content-Type", "application/json");
@@ -376,7 +1259,7 @@ handle_post_request (SoupServer        *server,
      * (streamable HTTP mode where no SSE client connects first). */
     if (self->session_id == NULL)
     {
-        self->session_id = generate_session_id ();
+        self->session_id = generate_session_id (self);
         g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SESSION_ID]);
     }
     soup_message_headers_replace (response_headers, "Mcp-Session-Id", self->session_id);
@@ -385,17 +1268,282 @@ handle_post_request (SoupServer        *server,
      * directly into the HTTP body (streamable HTTP / no SSE client). */
     self->pending_post_msg = msg;
 
-    /* Emit message-received signal -- handlers run synchronously,
-     * so send_message_async may clear pending_post_msg inline. */
-    mcp_transport_emit_message_received (MCP_TRANSPORT (self), root);
+    /* Emit message-received signal -- handlers run synchronously,
+     * so send_message_async may clear pending_post_msg inline. */
+    mcp_transport_emit_message_received (MCP_TRANSPORT (self), root);
+
+    if (self->pending_post_msg != NULL)
+    {
+        /* No response was generated synchronously (notification, etc.).
+         * Return 202 Accepted -- response may come via SSE later. */
+        self->pending_post_msg = NULL;
+        soup_server_message_set_status (msg, SOUP_STATUS_ACCEPTED, NULL);
+    }
+}
+
+/*
+ * Signs a download id and expiry with the transport's key, so that
+ * URLs cannot be forged or extended
+ */
+static gchar *
+sign_download (McpHttpServerTransport *self,
+               const gchar            *id,
+               gint64                  expires)
+{
+    g_autofree gchar *payload = NULL;
+
+    payload = g_strdup_printf ("%s:%" G_GINT64_FORMAT, id, expires);
+    return g_compute_hmac_for_string (G_CHECKSUM_SHA256,
+                                      self->download_key, sizeof self->download_key,
+                                      payload, -1);
+}
+
+static void schedule_prune_downloads (McpHttpServerTransport *self,
+                                      gint64                  expires);
+
+/*
+ * Drops expired downloads, and arms the timer again for the next one
+ * to expire
+ */
+static void
+prune_downloads (McpHttpServerTransport *self)
+{
+    GHashTableIter iter;
+    Download *download;
+    gint64 now;
+    gint64 next = G_MAXINT64;
+
+    now = g_get_real_time () / G_USEC_PER_SEC;
+    g_hash_table_iter_init (&iter, self->downloads);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &download))
+    {
+        if (download->expires < now)
+        {
+            g_hash_table_iter_remove (&iter);
+        }
+        else if (download->expires < next)
+        {
+            next = download->expires;
+        }
+    }
+
+    if (next != G_MAXINT64)
+    {
+        schedule_prune_downloads (self, next);
+    }
+}
+
+static gboolean
+prune_downloads_cb (gpointer user_data)
+{
+    McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (user_data);
+
+    g_clear_pointer (&self->download_prune_source, g_source_unref);
+    prune_downloads (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Makes sure the expired downloads are dropped by the time a download
+ * that expires at @expires does, even if nothing else happens on the
+ * server by then
+ */
+static void
+schedule_prune_downloads (McpHttpServerTransport *self,
+                          gint64                  expires)
+{
+    gint64 delay;
+
+    if (self->download_prune_source != NULL)
+    {
+        if (self->download_prune_at <= expires)
+        {
+            return;
+        }
+        g_source_destroy (self->download_prune_source);
+        g_clear_pointer (&self->download_prune_source, g_source_unref);
+    }
+
+    /* A download is still valid during its expiry second */
+    delay = expires + 1 - g_get_real_time () / G_USEC_PER_SEC;
+    self->download_prune_at = expires;
+    self->download_prune_source = g_timeout_source_new_seconds ((guint) MAX (delay, 1));
+    g_source_set_callback (self->download_prune_source, prune_downloads_cb, self, NULL);
+    g_source_attach (self->download_prune_source, g_main_context_get_thread_default ());
+}
+
+/*
+ * Handle GET/HEAD of a published download.  The signed URL is the
+ * credential, so the Bearer token is not required.
+ */
+static void
+handle_download_request (McpHttpServerTransport *self,
+                         SoupServerMessage      *msg,
+                         const char             *path,
+                         GHashTable             *query)
+{
+    SoupMessageHeaders *request_headers;
+    SoupMessageHeaders *response_headers;
+    g_autofree gchar *expected = NULL;
+    g_autoptr(GBytes) body = NULL;
+    const gchar *id;
+    const gchar *expires_str;
+    const gchar *sig;
+    Download *download;
+    gint64 expires;
+    gsize total;
+    guint status = SOUP_STATUS_OK;
+
+    id = path + strlen (DOWNLOAD_PATH);
+    expires_str = query != NULL ? g_hash_table_lookup (query, "expires") : NULL;
+    sig = query != NULL ? g_hash_table_lookup (query, "sig") : NULL;
+
+    if (expires_str == NULL || sig == NULL)
+    {
+        soup_server_message_set_status (msg, SOUP_STATUS_FORBIDDEN, NULL);
+        return;
+    }
+
+    expires = g_ascii_strtoll (expires_str, NULL, 10);
+    expected = sign_download (self, id, expires);
+    if (!signature_equal (sig, expected))
+    {
+        soup_server_message_set_status (msg, SOUP_STATUS_FORBIDDEN, NULL);
+        return;
+    }
+
+    if (expires < g_get_real_time () / G_USEC_PER_SEC)
+    {
+        g_hash_table_remove (self->downloads, id);
+        soup_server_message_set_status (msg, SOUP_STATUS_GONE, NULL);
+        return;
+    }
+
+    download = g_hash_table_lookup (self->downloads, id);
+    if (download == NULL)
+    {
+        soup_server_message_set_status (msg, SOUP_STATUS_NOT_FOUND, NULL);
+        return;
+    }
+
+    request_headers = soup_server_message_get_request_headers (msg);
+    response_headers = soup_server_message_get_response_headers (msg);
+    total = g_bytes_get_size (download->data);
+    body = g_bytes_ref (download->data);
+
+    soup_message_headers_set_content_type (response_headers,
+                                           download->mime_type != NULL ?
+                                           download->mime_type : "application/octet-stream",
+                                           NULL);
+    soup_message_headers_replace (response_headers, "Accept-Ranges", "bytes");
+    soup_message_headers_replace (response_headers, "Cache-Control", "no-store");
+
+    /* One range is served as 206 here; for several, libsoup turns the
+     * whole body into a multipart/byteranges response */
+    if (soup_message_headers_get_one (request_headers, "Range") != NULL)
+    {
+        SoupRange *ranges = NULL;
+        int n_ranges = 0;
+
+        if (!soup_message_headers_get_ranges (request_headers, total, &ranges, &n_ranges))
+        {
+            g_autofree gchar *content_range = NULL;
+
+            content_range = g_strdup_printf ("bytes */%" G_GSIZE_FORMAT, total);
+            soup_message_headers_replace (response_headers, "Content-Range", content_range);
+            soup_server_message_set_status (msg, SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE, NULL);
+            return;
+        }
+
+        if (n_ranges == 1)
+        {
+            g_bytes_unref (body);
+            body = g_bytes_new_from_bytes (download->data,
+                                           (gsize) ranges[0].start,
+                                           (gsize) (ranges[0].end - ranges[0].start + 1));
+            soup_message_headers_set_content_range (response_headers,
+                                                    ranges[0].start, ranges[0].end,
+                                                    total);
+            status = SOUP_STATUS_PARTIAL_CONTENT;
+        }
+
+        soup_message_headers_free_ranges (request_headers, ranges);
+    }
+
+    /* The bytes are handed to libsoup as they are, for fd-backed
+     * contents the file mapping rather than a copy; libsoup sets
+     * Content-Length from them */
+    soup_message_body_append_bytes (soup_server_message_get_response_body (msg), body);
+    soup_server_message_set_status (msg, status, NULL);
+
+    /* The response holds the data now; once the whole of it has been
+     * asked for, nobody needs the URL again */
+    if (soup_message_headers_get_one (request_headers, "Range") == NULL &&
+        g_strcmp0 (soup_server_message_get_method (msg), "GET") == 0)
+    {
+        g_hash_table_remove (self->downloads, id);
+    }
+}
+
+/*
+ * Handle DELETE request (client ending its session)
+ */
+static void
+handle_delete_request (SoupServer        *server,
+                       SoupServerMessage *msg,
+                       const char        *path,
+                       GHashTable        *query,
+                       gpointer           user_data)
+{
+    McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (user_data);
+    const gchar *session_id;
+
+    /* Validate authentication */
+    if (!validate_auth (self, msg))
+    {
+        soup_server_message_set_status (msg, SOUP_STATUS_UNAUTHORIZED, NULL);
+        return;
+    }
+
+    session_id = soup_message_headers_get_one (soup_server_message_get_request_headers (msg),
+                                               "Mcp-Session-Id");
+    if (session_id == NULL && query != NULL)
+    {
+        session_id = (const gchar *)g_hash_table_lookup (query, "sessionId");
+    }
+    if (session_id == NULL)
+    {
+        soup_server_message_set_status (msg, SOUP_STATUS_BAD_REQUEST, NULL);
+        return;
+    }
+
+    if (route_to_shard (self, msg, query, NULL, FALSE))
+    {
+        return;
+    }
 
-    if (self->pending_post_msg != NULL)
+    if (g_strcmp0 (session_id, self->session_id) != 0)
     {
-        /* No response was generated synchronously (notification, etc.).
-         * Return 202 Accepted -- response may come via SSE later. */
-        self->pending_post_msg = NULL;
-        soup_server_message_set_status (msg, SOUP_STATUS_ACCEPTED, NULL);
+        soup_server_message_set_status (msg, SOUP_STATUS_NOT_FOUND, "Unknown session");
+        return;
+    }
+
+    /* End the SSE stream, if any, and free the shard for a new client */
+    if (self->sse_message != NULL)
+    {
+        SoupServerMessage *sse = self->sse_message;
+
+        self->sse_message = NULL;
+        self->client_connected = FALSE;
+        fail_sse_queue (self);
+        soup_message_body_complete (soup_server_message_get_response_body (sse));
+        soup_server_message_unpause (sse);
     }
+    g_clear_pointer (&self->session_id, g_free);
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SESSION_ID]);
+
+    soup_server_message_set_status (msg, SOUP_STATUS_NO_CONTENT, NULL);
 }
 
 /*
@@ -423,6 +1571,14 @@ handle_request (SoupServer        *server,
         return;
     }
 
+    /* Route published downloads */
+    if ((g_strcmp0 (method, "GET") == 0 || g_strcmp0 (method, "HEAD") == 0) &&
+        g_str_has_prefix (path, DOWNLOAD_PATH))
+    {
+        handle_download_request (self, msg, path, query);
+        return;
+    }
+
     /* Route POST requests to POST path */
     if (g_strcmp0 (method, "POST") == 0 && g_strcmp0 (path, self->post_path) == 0)
     {
@@ -430,10 +1586,124 @@ handle_request (SoupServer        *server,
         return;
     }
 
+    /* Route DELETE requests on the POST path to session teardown */
+    if (g_strcmp0 (method, "DELETE") == 0 && g_strcmp0 (path, self->post_path) == 0)
+    {
+        handle_delete_request (server, msg, path, query, user_data);
+        return;
+    }
+
     /* Unknown path/method */
     soup_server_message_set_status (msg, SOUP_STATUS_NOT_FOUND, NULL);
 }
 
+/*
+ * Binds a listening TCP socket on @address and hands it to @server.
+ * Stores the bound port in @out_port.
+ */
+static gboolean
+listen_on_address (SoupServer    *server,
+                   GInetAddress  *address,
+                   guint          port,
+                   gboolean       reuse_port,
+                   guint         *out_port,
+                   GError       **error)
+{
+    g_autoptr(GSocket) sock = NULL;
+    g_autoptr(GSocketAddress) bind_address = NULL;
+    g_autoptr(GSocketAddress) local_address = NULL;
+
+    sock = g_socket_new (g_inet_address_get_family (address),
+                         G_SOCKET_TYPE_STREAM,
+                         G_SOCKET_PROTOCOL_TCP,
+                         error);
+    if (sock == NULL)
+    {
+        return FALSE;
+    }
+
+    if (reuse_port)
+    {
+#ifdef SO_REUSEPORT
+        if (!g_socket_set_option (sock, SOL_SOCKET, SO_REUSEPORT, 1, error))
+        {
+            return FALSE;
+        }
+#else
+        g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                             "SO_REUSEPORT is not supported on this platform");
+        return FALSE;
+#endif
+    }
+
+    bind_address = g_inet_socket_address_new (address, port);
+    if (!g_socket_bind (sock, bind_address, TRUE, error) ||
+        !g_socket_listen (sock, error))
+    {
+        return FALSE;
+    }
+
+    local_address = g_socket_get_local_address (sock, error);
+    if (local_address == NULL)
+    {
+        return FALSE;
+    }
+    *out_port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (local_address));
+
+    return soup_server_listen_socket (server, sock, 0, error);
+}
+
+/*
+ * Listens as one shard of a group sharing the configured port, plus
+ * on the private loopback port other shards forward requests to
+ */
+static gboolean
+listen_shard (McpHttpServerTransport  *self,
+              GError                 **error)
+{
+    g_autoptr(GInetAddress) address = NULL;
+    g_autoptr(GInetAddress) loopback = NULL;
+
+    if (g_strcmp0 (self->host, "127.0.0.1") == 0 ||
+        g_strcmp0 (self->host, "localhost") == 0)
+    {
+        address = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+        if (!listen_on_address (self->server, address, self->port, TRUE,
+                                &self->actual_port, error))
+        {
+            return FALSE;
+        }
+    }
+    else
+    {
+        g_autoptr(GError) ipv6_error = NULL;
+
+        /* Dual-stack where available, as soup_server_listen_all() */
+        address = g_inet_address_new_any (G_SOCKET_FAMILY_IPV6);
+        if (!listen_on_address (self->server, address, self->port, TRUE,
+                                &self->actual_port, &ipv6_error))
+        {
+            g_clear_object (&address);
+            address = g_inet_address_new_any (G_SOCKET_FAMILY_IPV4);
+            if (!listen_on_address (self->server, address, self->port, TRUE,
+                                    &self->actual_port, error))
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    loopback = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+    if (!listen_on_address (self->server, loopback, 0, FALSE,
+                            &self->shard_port, error))
+    {
+        return FALSE;
+    }
+
+    shard_group_add (self);
+    return TRUE;
+}
+
 /* McpTransport interface implementation */
 
 static McpTransportState
@@ -479,7 +1749,17 @@ mcp_http_server_transport_connect_async (McpTransport        *transport,
     soup_server_add_handler (self->server, NULL, handle_request, self, NULL);
 
     /* Start listening */
-    if (self->host != NULL && self->host[0] != '\0')
+    if (self->reuse_port)
+    {
+        if (!listen_shard (self, &error))
+        {
+            stop_server (self);
+            g_task_return_error (task, g_steal_pointer (&error));
+            set_state (self, MCP_TRANSPORT_STATE_ERROR);
+            return;
+        }
+    }
+    else if (self->host != NULL && self->host[0] != '\0')
     {
         /* Listen on specific host - use listen_local for localhost */
         if (g_strcmp0 (self->host, "127.0.0.1") == 0 ||
@@ -514,17 +1794,21 @@ mcp_http_server_transport_connect_async (McpTransport        *transport,
         }
     }
 
-    /* Get the actual port (for port 0 auto-assign case) */
-    uris = soup_server_get_uris (self->server);
-    if (uris != NULL)
-    {
-        GUri *uri = uris->data;
-        self->actual_port = g_uri_get_port (uri);
-        g_slist_free_full (uris, (GDestroyNotify) g_uri_unref);
-    }
-    else
+    /* Get the actual port (for port 0 auto-assign case).  Shards
+     * already know it from the socket they bound. */
+    if (!self->reuse_port)
     {
-        self->actual_port = self->port;
+        uris = soup_server_get_uris (self->server);
+        if (uris != NULL)
+        {
+            GUri *uri = uris->data;
+            self->actual_port = g_uri_get_port (uri);
+            g_slist_free_full (uris, (GDestroyNotify) g_uri_unref);
+        }
+        else
+        {
+            self->actual_port = self->port;
+        }
     }
 
     set_state (self, MCP_TRANSPORT_STATE_CONNECTED);
@@ -569,20 +1853,21 @@ mcp_http_server_transport_disconnect_finish (McpTransport  *transport,
     return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+/*
+ * deliver_message:
+ *
+ * Delivers one serialized message, inline in a waiting POST response
+ * or as an SSE event queued behind those waiting at @priority or above,
+ * and completes @task once it has been handed to libsoup.
+ */
 static void
-mcp_http_server_transport_send_message_async (McpTransport        *transport,
-                                               JsonNode            *message,
-                                               GCancellable        *cancellable,
-                                               GAsyncReadyCallback  callback,
-                                               gpointer             user_data)
+deliver_message (McpHttpServerTransport *self,
+                 GTask                  *task,
+                 const gchar            *json_data,
+                 gsize                   json_len,
+                 McpMessagePriority      priority)
 {
-    McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (transport);
-    g_autoptr(GTask) task = NULL;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autofree gchar *json_data = NULL;
-
-    task = g_task_new (self, cancellable, callback, user_data);
-    g_task_set_source_tag (task, mcp_http_server_transport_send_message_async);
+    SseEntry *entry;
 
     if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
     {
@@ -591,11 +1876,6 @@ mcp_http_server_transport_send_message_async (McpTransport        *transport,
         return;
     }
 
-    /* Serialize JSON */
-    generator = json_generator_new ();
-    json_generator_set_root (generator, message);
-    json_data = json_generator_to_data (generator, NULL);
-
     /* Streamable HTTP: if a POST is waiting for an inline response, write
      * the JSON directly into the HTTP response body instead of SSE. */
     if (self->pending_post_msg != NULL)
@@ -607,8 +1887,7 @@ mcp_http_server_transport_send_message_async (McpTransport        *transport,
         soup_message_headers_replace (hdrs, "Content-Type", "application/json");
 
         body = soup_server_message_get_response_body (self->pending_post_msg);
-        soup_message_body_append (body, SOUP_MEMORY_COPY,
-                                  json_data, strlen (json_data));
+        soup_message_body_append (body, SOUP_MEMORY_COPY, json_data, json_len);
 
         soup_server_message_set_status (self->pending_post_msg,
                                          SOUP_STATUS_OK, NULL);
@@ -626,14 +1905,67 @@ mcp_http_server_transport_send_message_async (McpTransport        *transport,
     }
 
     /* Send as SSE event */
-    if (!send_sse_event (self, "message", json_data))
-    {
-        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
-                                  "Failed to send SSE event");
-        return;
-    }
+    entry = g_new0 (SseEntry, 1);
+    entry->task = g_object_ref (task);
+    entry->data = g_strndup (json_data, json_len);
+    mcp_write_queue_push (self->sse_queue, priority, entry);
+    flush_sse_queue (self);
+}
 
-    g_task_return_boolean (task, TRUE);
+static void
+mcp_http_server_transport_send_message_async (McpTransport        *transport,
+                                               JsonNode            *message,
+                                               GCancellable        *cancellable,
+                                               GAsyncReadyCallback  callback,
+                                               gpointer             user_data)
+{
+    McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (transport);
+    g_autoptr(GTask) task = NULL;
+    const gchar *json_data;
+    gsize json_len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_http_server_transport_send_message_async);
+
+    /* Serialize JSON */
+    mcp_json_writer_reset (self->writer);
+    mcp_json_writer_node (self->writer, message);
+    json_data = mcp_json_writer_get_data (self->writer, &json_len);
+
+    deliver_message (self, task, json_data, json_len,
+                     mcp_transport_classify_message (message));
+}
+
+static void
+mcp_http_server_transport_send_raw_with_priority_async (McpTransport        *transport,
+                                                         GBytes              *data,
+                                                         McpMessagePriority   priority,
+                                                         GCancellable        *cancellable,
+                                                         GAsyncReadyCallback  callback,
+                                                         gpointer             user_data)
+{
+    McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (transport);
+    g_autoptr(GTask) task = NULL;
+    const gchar *bytes;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_http_server_transport_send_raw_with_priority_async);
+
+    bytes = g_bytes_get_data (data, &len);
+    deliver_message (self, task, bytes, len, priority);
+}
+
+static void
+mcp_http_server_transport_send_raw_async (McpTransport        *transport,
+                                           GBytes              *data,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data)
+{
+    mcp_http_server_transport_send_raw_with_priority_async (transport, data,
+                                                             mcp_transport_classify_raw (data),
+                                                             cancellable, callback, user_data);
 }
 
 static gboolean
@@ -644,6 +1976,52 @@ mcp_http_server_transport_send_message_finish (McpTransport  *transport,
     return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+static gchar *
+mcp_http_server_transport_publish_download (McpTransport  *transport,
+                                            GBytes        *data,
+                                            const gchar   *mime_type,
+                                            GError       **error)
+{
+    McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (transport);
+    g_autofree gchar *signature = NULL;
+    Download *download;
+    gchar *id;
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                     "Transport not connected");
+        return NULL;
+    }
+
+    prune_downloads (self);
+
+    /* The caller sends the data inline instead */
+    if (g_bytes_get_size (data) > self->download_limit ||
+        self->download_bytes > self->download_limit - g_bytes_get_size (data))
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                     "Published downloads would exceed %" G_GUINT64_FORMAT " bytes",
+                     self->download_limit);
+        return NULL;
+    }
+
+    id = g_uuid_string_random ();
+    download = g_new0 (Download, 1);
+    download->owner = self;
+    download->data = g_bytes_ref (data);
+    download->mime_type = g_strdup (mime_type);
+    download->expires = g_get_real_time () / G_USEC_PER_SEC + self->download_ttl;
+    g_hash_table_insert (self->downloads, id, download);
+    self->download_bytes += g_bytes_get_size (data);
+    schedule_prune_downloads (self, download->expires);
+
+    /* Relative to the address the client already talks to */
+    signature = sign_download (self, id, download->expires);
+    return g_strdup_printf ("%s%s?expires=%" G_GINT64_FORMAT "&sig=%s",
+                            DOWNLOAD_PATH, id, download->expires, signature);
+}
+
 static void
 mcp_http_server_transport_iface_init (McpTransportInterface *iface)
 {
@@ -654,6 +2032,10 @@ mcp_http_server_transport_iface_init (McpTransportInterface *iface)
     iface->disconnect_finish = mcp_http_server_transport_disconnect_finish;
     iface->send_message_async = mcp_http_server_transport_send_message_async;
     iface->send_message_finish = mcp_http_server_transport_send_message_finish;
+    iface->send_raw_async = mcp_http_server_transport_send_raw_async;
+    iface->send_raw_finish = mcp_http_server_transport_send_message_finish;
+    iface->send_raw_with_priority_async = mcp_http_server_transport_send_raw_with_priority_async;
+    iface->publish_download = mcp_http_server_transport_publish_download;
 }
 
 static void
@@ -665,6 +2047,7 @@ stop_server (McpHttpServerTransport *self)
         self->sse_message = NULL;
         self->client_connected = FALSE;
     }
+    fail_sse_queue (self);
 
     /* Stop server */
     if (self->server != NULL)
@@ -673,9 +2056,36 @@ stop_server (McpHttpServerTransport *self)
         g_clear_object (&self->server);
     }
 
+    /* Fail any requests still being relayed to other shards; they
+     * finish on their own, without this transport */
+    while (self->forwards != NULL)
+    {
+        ForwardData *data = self->forwards->data;
+
+        data->self = NULL;
+        g_cancellable_cancel (data->cancellable);
+        self->forwards = g_list_delete_link (self->forwards, self->forwards);
+    }
+    if (self->forward_session != NULL)
+    {
+        soup_session_abort (self->forward_session);
+        g_clear_object (&self->forward_session);
+    }
+    if (self->shard_port != 0)
+    {
+        shard_group_remove (self);
+    }
+
     /* Clear session */
     g_clear_pointer (&self->session_id, g_free);
+    g_hash_table_remove_all (self->downloads);
+    if (self->download_prune_source != NULL)
+    {
+        g_source_destroy (self->download_prune_source);
+        g_clear_pointer (&self->download_prune_source, g_source_unref);
+    }
     self->actual_port = 0;
+    self->shard_port = 0;
 }
 
 /* GObject implementation */
@@ -696,11 +2106,15 @@ mcp_http_server_transport_finalize (GObject *object)
 {
     McpHttpServerTransport *self = MCP_HTTP_SERVER_TRANSPORT (object);
 
+    mcp_json_writer_free (self->writer);
+    mcp_write_queue_free (self->sse_queue, NULL);
     g_free (self->host);
     g_free (self->post_path);
     g_free (self->sse_path);
     g_free (self->auth_token);
+    g_free (self->shard_key);
     g_free (self->session_id);
+    g_hash_table_unref (self->downloads);
 
     G_OBJECT_CLASS (mcp_http_server_transport_parent_class)->finalize (object);
 }
@@ -739,6 +2153,18 @@ mcp_http_server_transport_get_property (GObject    *object,
         case PROP_TLS_CERTIFICATE:
             g_value_set_object (value, self->tls_certificate);
             break;
+        case PROP_DOWNLOAD_TTL:
+            g_value_set_uint (value, self->download_ttl);
+            break;
+        case PROP_DOWNLOAD_LIMIT:
+            g_value_set_uint64 (value, self->download_limit);
+            break;
+        case PROP_REUSE_PORT:
+            g_value_set_boolean (value, self->reuse_port);
+            break;
+        case PROP_SHARD_KEY:
+            g_value_set_string (value, self->shard_key);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -776,6 +2202,18 @@ mcp_http_server_transport_set_property (GObject      *object,
         case PROP_TLS_CERTIFICATE:
             mcp_http_server_transport_set_tls_certificate (self, g_value_get_object (value));
             break;
+        case PROP_DOWNLOAD_TTL:
+            mcp_http_server_transport_set_download_ttl (self, g_value_get_uint (value));
+            break;
+        case PROP_DOWNLOAD_LIMIT:
+            mcp_http_server_transport_set_download_limit (self, g_value_get_uint64 (value));
+            break;
+        case PROP_REUSE_PORT:
+            mcp_http_server_transport_set_reuse_port (self, g_value_get_boolean (value));
+            break;
+        case PROP_SHARD_KEY:
+            mcp_http_server_transport_set_shard_key (self, g_value_get_string (value));
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -888,12 +2326,65 @@ mcp_http_server_transport_class_init (McpHttpServerTransportClass *klass)
                              G_TYPE_TLS_CERTIFICATE,
                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+    /**
+     * McpHttpServerTransport:download-ttl:
+     *
+     * How long, in seconds, a published download URL stays valid.
+     */
+    properties[PROP_DOWNLOAD_TTL] =
+        g_param_spec_uint ("download-ttl",
+                           "Download TTL",
+                           "Seconds a published download URL stays valid",
+                           1, G_MAXUINT, MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_TTL,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * McpHttpServerTransport:download-limit:
+     *
+     * The most bytes published downloads may hold at once.  Contents
+     * that would go over it are sent inline.
+     */
+    properties[PROP_DOWNLOAD_LIMIT] =
+        g_param_spec_uint64 ("download-limit",
+                             "Download Limit",
+                             "Most bytes published downloads may hold at once",
+                             0, G_MAXUINT64, MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_LIMIT,
+                             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * McpHttpServerTransport:reuse-port:
+     *
+     * Whether to listen with SO_REUSEPORT as one shard of a group of
+     * transports sharing the same port.
+     */
+    properties[PROP_REUSE_PORT] =
+        g_param_spec_boolean ("reuse-port",
+                              "Reuse Port",
+                              "Listen with SO_REUSEPORT as one of several shards",
+                              FALSE,
+                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    /**
+     * McpHttpServerTransport:shard-key:
+     *
+     * The secret the shards of a group sign their session ids with, or
+     * %NULL to use a key private to the process.
+     */
+    properties[PROP_SHARD_KEY] =
+        g_param_spec_string ("shard-key",
+                             "Shard Key",
+                             "The secret shards sign session ids with",
+                             NULL,
+                             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties (object_class, N_PROPERTIES, properties);
 }
 
 static void
 mcp_http_server_transport_init (McpHttpServerTransport *self)
 {
+    self->writer = mcp_json_writer_new ();
+    self->sse_queue = mcp_write_queue_new ();
     self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
     self->post_path = g_strdup ("/");
     self->sse_path = g_strdup ("/sse");
@@ -901,6 +2392,21 @@ mcp_http_server_transport_init (McpHttpServerTransport *self)
     self->client_connected = FALSE;
     self->event_id_counter = 0;
     self->pending_post_msg = NULL;
+    self->downloads = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, (GDestroyNotify) download_free);
+    self->download_ttl = MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_TTL;
+    self->download_limit = MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_LIMIT;
+
+    {
+        guint i;
+
+        for (i = 0; i < DOWNLOAD_KEY_SIZE; i += sizeof (guint32))
+        {
+            guint32 r = g_random_int ();
+
+            memcpy (self->download_key + i, &r, sizeof r);
+        }
+    }
 }
 
 /* Public API */
@@ -1093,9 +2599,93 @@ mcp_http_server_transport_has_client (McpHttpServerTransport *self)
     return self->client_connected;
 }
 
+guint
+mcp_http_server_transport_get_download_ttl (McpHttpServerTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self), 0);
+    return self->download_ttl;
+}
+
+void
+mcp_http_server_transport_set_download_ttl (McpHttpServerTransport *self,
+                                             guint                   seconds)
+{
+    g_return_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self));
+    g_return_if_fail (seconds > 0);
+
+    self->download_ttl = seconds;
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_DOWNLOAD_TTL]);
+}
+
+guint64
+mcp_http_server_transport_get_download_limit (McpHttpServerTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self), 0);
+    return self->download_limit;
+}
+
+void
+mcp_http_server_transport_set_download_limit (McpHttpServerTransport *self,
+                                               guint64                 bytes)
+{
+    g_return_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self));
+
+    /* Downloads already published stay until they are fetched or expire */
+    self->download_limit = bytes;
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_DOWNLOAD_LIMIT]);
+}
+
 guint
 mcp_http_server_transport_get_actual_port (McpHttpServerTransport *self)
 {
     g_return_val_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self), 0);
     return self->actual_port;
 }
+
+gboolean
+mcp_http_server_transport_get_reuse_port (McpHttpServerTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self), FALSE);
+    return self->reuse_port;
+}
+
+void
+mcp_http_server_transport_set_reuse_port (McpHttpServerTransport *self,
+                                          gboolean                reuse_port)
+{
+    g_return_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self));
+    g_return_if_fail (self->state == MCP_TRANSPORT_STATE_DISCONNECTED);
+
+    reuse_port = !!reuse_port;
+    if (self->reuse_port != reuse_port)
+    {
+        self->reuse_port = reuse_port;
+        g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_REUSE_PORT]);
+    }
+}
+
+guint
+mcp_http_server_transport_get_shard_port (McpHttpServerTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self), 0);
+    return self->shard_port;
+}
+
+const gchar *
+mcp_http_server_transport_get_shard_key (McpHttpServerTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self), NULL);
+    return self->shard_key;
+}
+
+void
+mcp_http_server_transport_set_shard_key (McpHttpServerTransport *self,
+                                         const gchar            *key)
+{
+    g_return_if_fail (MCP_IS_HTTP_SERVER_TRANSPORT (self));
+    g_return_if_fail (self->state == MCP_TRANSPORT_STATE_DISCONNECTED);
+
+    g_free (self->shard_key);
+    self->shard_key = g_strdup (key);
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SHARD_KEY]);
+}
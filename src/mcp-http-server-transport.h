@@ -25,6 +25,20 @@
 
 G_BEGIN_DECLS
 
+/**
+ * MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_TTL:
+ *
+ * Default lifetime in seconds of a published download URL.
+ */
+#define MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_TTL (300)
+
+/**
+ * MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_LIMIT:
+ *
+ * Default for the most bytes published downloads hold at once.
+ */
+#define MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_LIMIT (G_GUINT64_CONSTANT (256) * 1024 * 1024)
+
 #define MCP_TYPE_HTTP_SERVER_TRANSPORT (mcp_http_server_transport_get_type ())
 
 G_DECLARE_FINAL_TYPE (McpHttpServerTransport, mcp_http_server_transport, MCP, HTTP_SERVER_TRANSPORT, GObject)
@@ -240,6 +254,118 @@ gboolean mcp_http_server_transport_has_client (McpHttpServerTransport *self);
  */
 guint mcp_http_server_transport_get_actual_port (McpHttpServerTransport *self);
 
+/**
+ * mcp_http_server_transport_get_download_ttl:
+ * @self: an #McpHttpServerTransport
+ *
+ * Gets how long published download URLs stay valid.
+ *
+ * Returns: the lifetime in seconds
+ */
+guint mcp_http_server_transport_get_download_ttl (McpHttpServerTransport *self);
+
+/**
+ * mcp_http_server_transport_set_download_ttl:
+ * @self: an #McpHttpServerTransport
+ * @seconds: the lifetime in seconds, greater than 0
+ *
+ * Sets how long URLs published with mcp_transport_publish_download()
+ * stay valid.  Bulk resource contents are published this way for
+ * clients that declare %MCP_TRANSPORT_DOWNLOAD; the data is held until
+ * a full GET of the URL has been served or the URL expires.
+ */
+void mcp_http_server_transport_set_download_ttl (McpHttpServerTransport *self,
+                                                 guint                   seconds);
+
+/**
+ * mcp_http_server_transport_get_download_limit:
+ * @self: an #McpHttpServerTransport
+ *
+ * Gets the most bytes published downloads may hold at once.
+ *
+ * Returns: the limit in bytes
+ */
+guint64 mcp_http_server_transport_get_download_limit (McpHttpServerTransport *self);
+
+/**
+ * mcp_http_server_transport_set_download_limit:
+ * @self: an #McpHttpServerTransport
+ * @bytes: the limit in bytes
+ *
+ * Sets the most bytes that downloads published with
+ * mcp_transport_publish_download() may hold at once.  Publishing more
+ * fails, and #McpServer then sends the contents inline.  With 0,
+ * nothing is published.
+ */
+void mcp_http_server_transport_set_download_limit (McpHttpServerTransport *self,
+                                                   guint64                 bytes);
+
+/**
+ * mcp_http_server_transport_get_reuse_port:
+ * @self: an #McpHttpServerTransport
+ *
+ * Gets whether the transport listens as one shard of a group.
+ *
+ * Returns: %TRUE if SO_REUSEPORT sharding is enabled
+ */
+gboolean mcp_http_server_transport_get_reuse_port (McpHttpServerTransport *self);
+
+/**
+ * mcp_http_server_transport_set_reuse_port:
+ * @self: an #McpHttpServerTransport
+ * @reuse_port: whether to listen with SO_REUSEPORT
+ *
+ * Makes the transport one shard of a group of transports listening on
+ * the same port, each in its own thread or process.  The kernel
+ * balances new connections across the group; requests carrying a
+ * session id issued by another shard are forwarded to it over loopback,
+ * so every session stays on the shard that holds its SSE stream.  A new
+ * session landing on a busy shard is forwarded to a free shard in the
+ * same process, or turned away with 503 if there is none.  Shards
+ * in different processes must run as the same user and share a key set
+ * with mcp_http_server_transport_set_shard_key().  Cannot be changed
+ * while connected.
+ */
+void mcp_http_server_transport_set_reuse_port (McpHttpServerTransport *self,
+                                               gboolean                reuse_port);
+
+/**
+ * mcp_http_server_transport_get_shard_port:
+ * @self: an #McpHttpServerTransport
+ *
+ * Gets the loopback port other shards forward this shard's requests to.
+ * Session ids issued by a shard end in "." followed by a signature,
+ * another "." and this port.
+ *
+ * Returns: the shard port, or 0 if not connected or not sharded
+ */
+guint mcp_http_server_transport_get_shard_port (McpHttpServerTransport *self);
+
+/**
+ * mcp_http_server_transport_get_shard_key:
+ * @self: an #McpHttpServerTransport
+ *
+ * Gets the key the shards of a group sign their session ids with.
+ *
+ * Returns: (nullable): the shard key, or %NULL for the process's own key
+ */
+const gchar *mcp_http_server_transport_get_shard_key (McpHttpServerTransport *self);
+
+/**
+ * mcp_http_server_transport_set_shard_key:
+ * @self: an #McpHttpServerTransport
+ * @key: (nullable): the shared secret, or %NULL
+ *
+ * Sets the secret the shards of a group sign their session ids with.
+ * A shard only forwards a POST to the loopback port named in its
+ * session id when the signature matches, so a client cannot have its
+ * request relayed to an arbitrary local port.  Shards in one process
+ * share a random key by default; shards in different processes must
+ * all be given the same key.  Cannot be changed while connected.
+ */
+void mcp_http_server_transport_set_shard_key (McpHttpServerTransport *self,
+                                              const gchar            *key);
+
 G_END_DECLS
 
 #endif /* MCP_HTTP_SERVER_TRANSPORT_H */
@@ -6,6 +6,8 @@
  */
 #include "mcp-http-transport.h"
 #include "mcp-error.h"
+#include "mcp-json-parse.h"
+#include "mcp-json-writer.h"
 #undef MCP_COMPILATION
 
 #include <string.h>
@@ -53,6 +55,9 @@ struct _McpHttpTransport
 
     /* Pending reconnect */
     guint reconnect_timeout_id;
+
+    /* Reused to serialize outgoing messages */
+    McpJsonWriter *writer;
 };
 
 static void mcp_http_transport_iface_init (McpTransportInterface *iface);
@@ -172,9 +177,8 @@ process_sse_event (McpHttpTransport *self,
                    const gchar      *data,
                    const gchar      *event_id)
 {
-    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(JsonNode) root = NULL;
     g_autoptr(GError) error = NULL;
-    JsonNode *root;
 
     /* Update last event ID for reconnection */
     if (event_id != NULL && event_id[0] != '\0')
@@ -190,16 +194,10 @@ process_sse_event (McpHttpTransport *self,
     }
 
     /* Parse JSON data */
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, data, -1, &error))
-    {
-        g_warning ("Failed to parse SSE data as JSON: %s", error->message);
-        return;
-    }
-
-    root = json_parser_get_root (parser);
+    root = mcp_json_parse (data, -1, &error);
     if (root == NULL)
     {
+        g_warning ("Failed to parse SSE data as JSON: %s", error->message);
         return;
     }
 
@@ -606,14 +604,14 @@ typedef struct
 {
     McpHttpTransport *transport;
     GTask *task;
-    JsonNode *message;
+    SoupMessage *soup_msg;
 } SendMessageData;
 
 static void
 send_message_data_free (SendMessageData *data)
 {
     g_object_unref (data->transport);
-    json_node_unref (data->message);
+    g_object_unref (data->soup_msg);
     g_slice_free (SendMessageData, data);
 }
 
@@ -630,7 +628,9 @@ post_send_cb (GObject      *source,
 
     response = soup_session_send_and_read_finish (SOUP_SESSION (source), result, &error);
 
-    message = g_object_get_data (source, "current-message");
+    /* Each POST carries its own message, so concurrent sends do not
+     * read each other's status. */
+    message = data->soup_msg;
 
     if (response == NULL)
     {
@@ -660,7 +660,7 @@ post_send_cb (GObject      *source,
         if (content_type != NULL && g_str_has_prefix (content_type, "application/json"))
         {
             /* Parse and emit the response */
-            g_autoptr(JsonParser) parser = NULL;
+            g_autoptr(JsonNode) root = NULL;
             const gchar *response_data;
             gsize response_len;
 
@@ -668,14 +668,10 @@ post_send_cb (GObject      *source,
 
             if (response_len > 0)
             {
-                parser = json_parser_new ();
-                if (json_parser_load_from_data (parser, response_data, response_len, NULL))
+                root = mcp_json_parse (response_data, response_len, NULL);
+                if (root != NULL)
                 {
-                    JsonNode *root = json_parser_get_root (parser);
-                    if (root != NULL)
-                    {
-                        mcp_transport_emit_message_received (MCP_TRANSPORT (data->transport), root);
-                    }
+                    mcp_transport_emit_message_received (MCP_TRANSPORT (data->transport), root);
                 }
             }
         }
@@ -687,25 +683,22 @@ post_send_cb (GObject      *source,
     send_message_data_free (data);
 }
 
+/*
+ * post_body:
+ *
+ * POSTs one serialized JSON-RPC message and completes @task (transfer
+ * full) from post_send_cb.
+ */
 static void
-mcp_http_transport_send_message_async (McpTransport        *transport,
-                                        JsonNode            *message,
-                                        GCancellable        *cancellable,
-                                        GAsyncReadyCallback  callback,
-                                        gpointer             user_data)
+post_body (McpHttpTransport *self,
+           GBytes           *body,
+           GTask            *task,
+           GCancellable     *cancellable)
 {
-    McpHttpTransport *self = MCP_HTTP_TRANSPORT (transport);
-    GTask *task;
     SendMessageData *data;
     g_autofree gchar *url = NULL;
-    g_autofree gchar *json_data = NULL;
-    g_autoptr(JsonGenerator) generator = NULL;
     SoupMessage *soup_msg;
     SoupMessageHeaders *headers;
-    GBytes *body;
-
-    task = g_task_new (self, cancellable, callback, user_data);
-    g_task_set_source_tag (task, mcp_http_transport_send_message_async);
 
     if (self->state != MCP_TRANSPORT_STATE_CONNECTED &&
         self->state != MCP_TRANSPORT_STATE_CONNECTING)
@@ -716,11 +709,6 @@ mcp_http_transport_send_message_async (McpTransport        *transport,
         return;
     }
 
-    /* Serialize JSON */
-    generator = json_generator_new ();
-    json_generator_set_root (generator, message);
-    json_data = json_generator_to_data (generator, NULL);
-
     /* Build URL */
     url = build_url (self, self->post_endpoint);
 
@@ -740,18 +728,12 @@ mcp_http_transport_send_message_async (McpTransport        *transport,
 
     add_auth_header (self, soup_msg);
 
-    body = g_bytes_new (json_data, strlen (json_data));
     soup_message_set_request_body_from_bytes (soup_msg, "application/json", body);
-    g_bytes_unref (body);
-
-    /* Store message for callback */
-    g_object_set_data_full (G_OBJECT (self->session), "current-message",
-                            soup_msg, g_object_unref);
 
     data = g_slice_new (SendMessageData);
     data->transport = g_object_ref (self);
     data->task = task;
-    data->message = json_node_copy (message);
+    data->soup_msg = soup_msg;
 
     soup_session_send_and_read_async (self->session,
                                        soup_msg,
@@ -761,6 +743,44 @@ mcp_http_transport_send_message_async (McpTransport        *transport,
                                        data);
 }
 
+static void
+mcp_http_transport_send_message_async (McpTransport        *transport,
+                                        JsonNode            *message,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data)
+{
+    McpHttpTransport *self = MCP_HTTP_TRANSPORT (transport);
+    GTask *task;
+    g_autoptr(GBytes) body = NULL;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_http_transport_send_message_async);
+
+    /* Serialize JSON */
+    mcp_json_writer_reset (self->writer);
+    mcp_json_writer_node (self->writer, message);
+    body = mcp_json_writer_to_bytes (self->writer);
+
+    post_body (self, body, task, cancellable);
+}
+
+static void
+mcp_http_transport_send_raw_async (McpTransport        *transport,
+                                    GBytes              *data,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+    McpHttpTransport *self = MCP_HTTP_TRANSPORT (transport);
+    GTask *task;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_http_transport_send_raw_async);
+
+    post_body (self, data, task, cancellable);
+}
+
 static gboolean
 mcp_http_transport_send_message_finish (McpTransport  *transport,
                                          GAsyncResult  *result,
@@ -769,6 +789,90 @@ mcp_http_transport_send_message_finish (McpTransport  *transport,
     return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+static void
+download_cb (GObject      *source,
+             GAsyncResult *result,
+             gpointer      user_data)
+{
+    g_autoptr(GTask) task = G_TASK (user_data);
+    SoupMessage *message = g_task_get_task_data (task);
+    g_autoptr(GBytes) body = NULL;
+    GError *error = NULL;
+    guint status;
+
+    body = soup_session_send_and_read_finish (SOUP_SESSION (source), result, &error);
+    if (body == NULL)
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    status = soup_message_get_status (message);
+    if (status != SOUP_STATUS_OK)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                                 "Download failed with status %u: %s",
+                                 status, soup_message_get_reason_phrase (message));
+        return;
+    }
+
+    g_task_return_pointer (task, g_steal_pointer (&body), (GDestroyNotify) g_bytes_unref);
+}
+
+static void
+mcp_http_transport_download_async (McpTransport        *transport,
+                                   const gchar         *url,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+    McpHttpTransport *self = MCP_HTTP_TRANSPORT (transport);
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *full_url = NULL;
+    SoupMessage *soup_msg;
+    GTask *task;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_http_transport_download_async);
+
+    /* Servers publish URLs relative to the address we connected to */
+    full_url = g_uri_resolve_relative (self->base_url, url, G_URI_FLAGS_NONE, &error);
+    if (full_url == NULL)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                                 "Invalid download URL %s: %s", url, error->message);
+        g_object_unref (task);
+        return;
+    }
+
+    soup_msg = soup_message_new ("GET", full_url);
+    if (soup_msg == NULL)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                                 "Invalid download URL: %s", full_url);
+        g_object_unref (task);
+        return;
+    }
+
+    add_auth_header (self, soup_msg);
+    g_task_set_task_data (task, soup_msg, g_object_unref);
+
+    soup_session_send_and_read_async (self->session,
+                                      soup_msg,
+                                      G_PRIORITY_DEFAULT,
+                                      cancellable,
+                                      download_cb,
+                                      task);
+}
+
+static GBytes *
+mcp_http_transport_download_finish (McpTransport  *transport,
+                                    GAsyncResult  *result,
+                                    GError       **error)
+{
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 static void
 mcp_http_transport_iface_init (McpTransportInterface *iface)
 {
@@ -779,6 +883,10 @@ mcp_http_transport_iface_init (McpTransportInterface *iface)
     iface->disconnect_finish = mcp_http_transport_disconnect_finish;
     iface->send_message_async = mcp_http_transport_send_message_async;
     iface->send_message_finish = mcp_http_transport_send_message_finish;
+    iface->send_raw_async = mcp_http_transport_send_raw_async;
+    iface->send_raw_finish = mcp_http_transport_send_message_finish;
+    iface->download_async = mcp_http_transport_download_async;
+    iface->download_finish = mcp_http_transport_download_finish;
 }
 
 /* GObject implementation */
@@ -807,6 +915,7 @@ mcp_http_transport_finalize (GObject *object)
 {
     McpHttpTransport *self = MCP_HTTP_TRANSPORT (object);
 
+    mcp_json_writer_free (self->writer);
     g_free (self->base_url);
     g_free (self->auth_token);
     g_free (self->sse_endpoint);
@@ -966,6 +1075,7 @@ mcp_http_transport_class_init (McpHttpTransportClass *klass)
 static void
 mcp_http_transport_init (McpHttpTransport *self)
 {
+    self->writer = mcp_json_writer_new ();
     self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
     self->timeout_seconds = 30;
     self->reconnect_enabled = TRUE;
@@ -0,0 +1,616 @@
+/*
+ * mcp-in-process-transport.c - In-process transport pair implementation
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "mcp-in-process-transport.h"
+#include "mcp-error.h"
+#include "mcp-json-parse.h"
+
+#include <gio/gio.h>
+
+/**
+ * SECTION:mcp-in-process-transport
+ * @title: McpInProcessTransport
+ * @short_description: Zero-serialization transport between two objects in one process
+ *
+ * #McpInProcessTransport endpoints come in pairs created by
+ * mcp_in_process_transport_new_pair().  Sending on one endpoint seals
+ * the message and pushes it onto the peer's inbox; a #GSource attached
+ * to the peer's #GMainContext drains the inbox in order and emits
+ * "message-received" for each message.  Sealed nodes are shared, not
+ * copied, so a message costs a queue push and a main loop dispatch.
+ */
+
+struct _McpInProcessTransport
+{
+    GObject parent_instance;
+
+    GMainContext      *context;          /* delivery context (ref'd)   */
+    GSource           *inbox_source;     /* attached to @context       */
+    GWeakRef           peer;
+
+    GMutex             lock;             /* guards the fields below    */
+    McpTransportState  state;
+    gboolean           closed;           /* disconnected or disposed   */
+    GQueue             inbox;            /* JsonNode * or CLOSE_MARKER */
+};
+
+static void mcp_in_process_transport_iface_init (McpTransportInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (McpInProcessTransport, mcp_in_process_transport, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (MCP_TYPE_TRANSPORT,
+                                                mcp_in_process_transport_iface_init))
+
+/* Queued after the last message when the peer goes away */
+static gint close_marker;
+#define CLOSE_MARKER ((gpointer) &close_marker)
+
+/* ── state helpers ─────────────────────────────────────────────────── */
+
+/* Caller MUST NOT hold self->lock. */
+static void
+set_state (McpInProcessTransport *self,
+           McpTransportState      new_state)
+{
+    McpTransportState old_state;
+
+    g_mutex_lock (&self->lock);
+    old_state = self->state;
+    if (old_state == new_state)
+    {
+        g_mutex_unlock (&self->lock);
+        return;
+    }
+    self->state = new_state;
+    g_mutex_unlock (&self->lock);
+
+    mcp_transport_emit_state_changed (MCP_TRANSPORT (self),
+                                      old_state,
+                                      new_state);
+}
+
+/* ── inbox ─────────────────────────────────────────────────────────── */
+
+static void
+inbox_item_free (gpointer item)
+{
+    if (item != CLOSE_MARKER)
+    {
+        json_node_unref (item);
+    }
+}
+
+/* Takes ownership of @item.  Safe from any thread. */
+static void
+inbox_push (McpInProcessTransport *self,
+            gpointer               item)
+{
+    GSource *source;
+
+    g_mutex_lock (&self->lock);
+    if (self->inbox_source == NULL)
+    {
+        /* Disposed */
+        g_mutex_unlock (&self->lock);
+        inbox_item_free (item);
+        return;
+    }
+    g_queue_push_tail (&self->inbox, item);
+    source = g_source_ref (self->inbox_source);
+    g_mutex_unlock (&self->lock);
+
+    /* Wakes the owning context if it is blocked in poll() */
+    g_source_set_ready_time (source, 0);
+    g_source_unref (source);
+}
+
+static gboolean
+inbox_dispatch_cb (gpointer user_data)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (user_data);
+
+    g_object_ref (self);
+    g_source_set_ready_time (self->inbox_source, -1);
+
+    /* The source may recurse, so a handler that spins a nested main
+     * loop still sees later messages; each one is popped exactly once
+     * and in order. */
+    for (;;)
+    {
+        gpointer item;
+
+        g_mutex_lock (&self->lock);
+        if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+        {
+            /* Keep the queue until connect_async() */
+            g_mutex_unlock (&self->lock);
+            break;
+        }
+        item = g_queue_pop_head (&self->inbox);
+        g_mutex_unlock (&self->lock);
+
+        if (item == NULL)
+        {
+            break;
+        }
+
+        if (item == CLOSE_MARKER)
+        {
+            g_mutex_lock (&self->lock);
+            self->closed = TRUE;
+            g_mutex_unlock (&self->lock);
+            set_state (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+            continue;
+        }
+
+        mcp_transport_emit_message_received (MCP_TRANSPORT (self), item);
+        json_node_unref (item);
+    }
+
+    g_object_unref (self);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+inbox_source_dispatch (GSource     *source,
+                       GSourceFunc  callback,
+                       gpointer     user_data)
+{
+    return callback != NULL ? callback (user_data) : G_SOURCE_REMOVE;
+}
+
+static GSourceFuncs inbox_source_funcs =
+{
+    NULL,
+    NULL,
+    inbox_source_dispatch,
+    NULL,
+};
+
+/* ── sealing ───────────────────────────────────────────────────────── */
+
+static JsonNode *deep_copy (JsonNode *node);
+
+static void
+copy_member_cb (JsonObject  *object,
+                const gchar *member_name,
+                JsonNode    *member_node,
+                gpointer     user_data)
+{
+    json_object_set_member (user_data, member_name, deep_copy (member_node));
+}
+
+static void
+copy_element_cb (JsonArray *array,
+                 guint      index_,
+                 JsonNode  *element_node,
+                 gpointer   user_data)
+{
+    json_array_add_element (user_data, deep_copy (element_node));
+}
+
+/*
+ * json_node_copy() shares objects, arrays and values with the original,
+ * and sealing a copy would seal the sender's tree as well, so unsealed
+ * messages are copied all the way down first.
+ */
+static JsonNode *
+deep_copy (JsonNode *node)
+{
+    JsonNode *copy;
+
+    switch (json_node_get_node_type (node))
+    {
+        case JSON_NODE_OBJECT:
+            {
+                JsonObject *object = json_object_new ();
+
+                json_object_foreach_member (json_node_get_object (node),
+                                            copy_member_cb, object);
+                copy = json_node_new (JSON_NODE_OBJECT);
+                json_node_take_object (copy, object);
+            }
+            break;
+
+        case JSON_NODE_ARRAY:
+            {
+                JsonArray *src = json_node_get_array (node);
+                JsonArray *array = json_array_sized_new (json_array_get_length (src));
+
+                json_array_foreach_element (src, copy_element_cb, array);
+                copy = json_node_new (JSON_NODE_ARRAY);
+                json_node_take_array (copy, array);
+            }
+            break;
+
+        case JSON_NODE_VALUE:
+            copy = json_node_new (JSON_NODE_VALUE);
+            switch (json_node_get_value_type (node))
+            {
+                case G_TYPE_INT64:
+                    json_node_set_int (copy, json_node_get_int (node));
+                    break;
+                case G_TYPE_DOUBLE:
+                    json_node_set_double (copy, json_node_get_double (node));
+                    break;
+                case G_TYPE_BOOLEAN:
+                    json_node_set_boolean (copy, json_node_get_boolean (node));
+                    break;
+                case G_TYPE_STRING:
+                default:
+                    json_node_set_string (copy, json_node_get_string (node));
+                    break;
+            }
+            break;
+
+        case JSON_NODE_NULL:
+        default:
+            copy = json_node_new (JSON_NODE_NULL);
+            break;
+    }
+
+    return copy;
+}
+
+static JsonNode *
+seal_message (JsonNode *message)
+{
+    JsonNode *sealed;
+
+    if (json_node_is_immutable (message))
+    {
+        return json_node_ref (message);
+    }
+
+    sealed = deep_copy (message);
+    json_node_seal (sealed);
+    return sealed;
+}
+
+/* Takes ownership of @message, which must be sealed. */
+static gboolean
+deliver (McpInProcessTransport  *self,
+         JsonNode               *message,
+         GError                **error)
+{
+    g_autoptr(JsonNode) owned = message;
+    g_autoptr(McpInProcessTransport) peer = NULL;
+    McpTransportState s;
+    gboolean peer_closed = FALSE;
+
+    g_mutex_lock (&self->lock);
+    s = self->state;
+    g_mutex_unlock (&self->lock);
+
+    if (s != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                     "in-process transport not connected");
+        return FALSE;
+    }
+
+    peer = g_weak_ref_get (&self->peer);
+    if (peer != NULL)
+    {
+        g_mutex_lock (&peer->lock);
+        peer_closed = peer->closed;
+        g_mutex_unlock (&peer->lock);
+    }
+
+    if (peer == NULL || peer_closed)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                     "in-process peer has gone away");
+        return FALSE;
+    }
+
+    inbox_push (peer, g_steal_pointer (&owned));
+    return TRUE;
+}
+
+/* Tells the peer, after anything already sent, that we are gone. */
+static void
+close_link (McpInProcessTransport *self)
+{
+    g_autoptr(McpInProcessTransport) peer = NULL;
+    gboolean was_closed;
+
+    g_mutex_lock (&self->lock);
+    was_closed = self->closed;
+    self->closed = TRUE;
+    g_mutex_unlock (&self->lock);
+
+    if (was_closed)
+    {
+        return;
+    }
+
+    peer = g_weak_ref_get (&self->peer);
+    if (peer != NULL)
+    {
+        inbox_push (peer, CLOSE_MARKER);
+    }
+}
+
+/* ── interface vtable ──────────────────────────────────────────────── */
+
+static McpTransportState
+in_process_get_state (McpTransport *transport)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (transport);
+    McpTransportState s;
+
+    g_mutex_lock (&self->lock);
+    s = self->state;
+    g_mutex_unlock (&self->lock);
+    return s;
+}
+
+static void
+in_process_connect_async (McpTransport        *transport,
+                          GCancellable        *cancellable,
+                          GAsyncReadyCallback  callback,
+                          gpointer             user_data)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (transport);
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, user_data);
+    gboolean closed;
+
+    g_task_set_source_tag (task, in_process_connect_async);
+
+    g_mutex_lock (&self->lock);
+    closed = self->closed;
+    g_mutex_unlock (&self->lock);
+
+    if (closed)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "in-process transport was closed");
+        return;
+    }
+
+    set_state (self, MCP_TRANSPORT_STATE_CONNECTED);
+
+    /* Deliver anything the peer sent before we were connected */
+    g_source_set_ready_time (self->inbox_source, 0);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+in_process_connect_finish (McpTransport  *transport,
+                           GAsyncResult  *result,
+                           GError       **error)
+{
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+in_process_disconnect_async (McpTransport        *transport,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (transport);
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, user_data);
+
+    g_task_set_source_tag (task, in_process_disconnect_async);
+
+    close_link (self);
+    set_state (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+in_process_disconnect_finish (McpTransport  *transport,
+                              GAsyncResult  *result,
+                              GError       **error)
+{
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+in_process_send_message_async (McpTransport        *transport,
+                               JsonNode            *message,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (transport);
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, user_data);
+    GError *error = NULL;
+
+    g_task_set_source_tag (task, in_process_send_message_async);
+
+    if (!deliver (self, seal_message (message), &error))
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+in_process_send_message_finish (McpTransport  *transport,
+                                GAsyncResult  *result,
+                                GError       **error)
+{
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+in_process_send_raw_async (McpTransport        *transport,
+                           GBytes              *data,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (transport);
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, user_data);
+    g_autoptr(GError) parse_error = NULL;
+    GError *error = NULL;
+    const gchar *bytes;
+    gsize len;
+    JsonNode *node;
+
+    g_task_set_source_tag (task, in_process_send_raw_async);
+
+    /* The tree is fresh, so it can be sealed in place without a copy */
+    bytes = g_bytes_get_data (data, &len);
+    node = mcp_json_parse (bytes, (gssize) len, &parse_error);
+    if (node == NULL)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_PARSE_ERROR,
+                                 "Invalid JSON message: %s", parse_error->message);
+        return;
+    }
+    json_node_seal (node);
+
+    if (!deliver (self, node, &error))
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+mcp_in_process_transport_iface_init (McpTransportInterface *iface)
+{
+    iface->get_state            = in_process_get_state;
+    iface->connect_async        = in_process_connect_async;
+    iface->connect_finish       = in_process_connect_finish;
+    iface->disconnect_async     = in_process_disconnect_async;
+    iface->disconnect_finish    = in_process_disconnect_finish;
+    iface->send_message_async   = in_process_send_message_async;
+    iface->send_message_finish  = in_process_send_message_finish;
+    iface->send_raw_async       = in_process_send_raw_async;
+    iface->send_raw_finish      = in_process_send_message_finish;
+}
+
+/* ── lifecycle ─────────────────────────────────────────────────────── */
+
+static void
+mcp_in_process_transport_dispose (GObject *object)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (object);
+    GSource *source;
+
+    close_link (self);
+
+    g_mutex_lock (&self->lock);
+    source = g_steal_pointer (&self->inbox_source);
+    g_mutex_unlock (&self->lock);
+
+    if (source != NULL)
+    {
+        g_source_destroy (source);
+        g_source_unref (source);
+    }
+
+    G_OBJECT_CLASS (mcp_in_process_transport_parent_class)->dispose (object);
+}
+
+static void
+mcp_in_process_transport_finalize (GObject *object)
+{
+    McpInProcessTransport *self = MCP_IN_PROCESS_TRANSPORT (object);
+
+    g_queue_clear_full (&self->inbox, inbox_item_free);
+    g_weak_ref_clear (&self->peer);
+    g_clear_pointer (&self->context, g_main_context_unref);
+    g_mutex_clear (&self->lock);
+
+    G_OBJECT_CLASS (mcp_in_process_transport_parent_class)->finalize (object);
+}
+
+static void
+mcp_in_process_transport_class_init (McpInProcessTransportClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->dispose = mcp_in_process_transport_dispose;
+    object_class->finalize = mcp_in_process_transport_finalize;
+}
+
+static void
+mcp_in_process_transport_init (McpInProcessTransport *self)
+{
+    g_mutex_init (&self->lock);
+    g_weak_ref_init (&self->peer, NULL);
+    g_queue_init (&self->inbox);
+    self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
+}
+
+/* ── public API ────────────────────────────────────────────────────── */
+
+static McpInProcessTransport *
+endpoint_new (GMainContext *context)
+{
+    McpInProcessTransport *self;
+
+    self = g_object_new (MCP_TYPE_IN_PROCESS_TRANSPORT, NULL);
+    if (context == NULL)
+    {
+        context = g_main_context_ref_thread_default ();
+    }
+    else
+    {
+        g_main_context_ref (context);
+    }
+    self->context = context;
+
+    /* The source lives exactly as long as the endpoint (it is destroyed
+     * in dispose), so it holds no reference of its own. */
+    self->inbox_source = g_source_new (&inbox_source_funcs, sizeof (GSource));
+    g_source_set_name (self->inbox_source, "McpInProcessTransport inbox");
+    g_source_set_can_recurse (self->inbox_source, TRUE);
+    g_source_set_ready_time (self->inbox_source, -1);
+    g_source_set_callback (self->inbox_source, inbox_dispatch_cb, self, NULL);
+    g_source_attach (self->inbox_source, context);
+
+    return self;
+}
+
+void
+mcp_in_process_transport_new_pair (GMainContext           *context_a,
+                                   GMainContext           *context_b,
+                                   McpInProcessTransport **out_a,
+                                   McpInProcessTransport **out_b)
+{
+    McpInProcessTransport *a;
+    McpInProcessTransport *b;
+
+    g_return_if_fail (out_a != NULL);
+    g_return_if_fail (out_b != NULL);
+
+    a = endpoint_new (context_a);
+    b = endpoint_new (context_b);
+
+    g_weak_ref_set (&a->peer, b);
+    g_weak_ref_set (&b->peer, a);
+
+    *out_a = a;
+    *out_b = b;
+}
+
+McpInProcessTransport *
+mcp_in_process_transport_get_peer (McpInProcessTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_IN_PROCESS_TRANSPORT (self), NULL);
+
+    return g_weak_ref_get (&self->peer);
+}
+
+GMainContext *
+mcp_in_process_transport_get_context (McpInProcessTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_IN_PROCESS_TRANSPORT (self), NULL);
+
+    return self->context;
+}
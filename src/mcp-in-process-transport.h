@@ -0,0 +1,78 @@
+/*
+ * mcp-in-process-transport.h - In-process transport pair for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * McpInProcessTransport connects an McpClient and an McpServer living
+ * in the same process (plugin hosts, tests) without a socket, pipe or
+ * host callback.  Messages are handed to the peer as sealed, refcounted
+ * JsonNodes through a queue drained on the peer's GMainContext, so
+ * nothing is serialized to JSON text and parsed back.
+ */
+
+#ifndef MCP_IN_PROCESS_TRANSPORT_H
+#define MCP_IN_PROCESS_TRANSPORT_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <json-glib/json-glib.h>
+#include "mcp-transport.h"
+
+G_BEGIN_DECLS
+
+#define MCP_TYPE_IN_PROCESS_TRANSPORT (mcp_in_process_transport_get_type ())
+
+G_DECLARE_FINAL_TYPE (McpInProcessTransport, mcp_in_process_transport,
+                      MCP, IN_PROCESS_TRANSPORT, GObject)
+
+/**
+ * mcp_in_process_transport_new_pair:
+ * @context_a: (nullable): the #GMainContext @out_a delivers messages on,
+ *   or %NULL for the thread-default context
+ * @context_b: (nullable): the #GMainContext @out_b delivers messages on,
+ *   or %NULL for the thread-default context
+ * @out_a: (out) (transfer full): return location for the first endpoint
+ * @out_b: (out) (transfer full): return location for the second endpoint
+ *
+ * Creates two connected endpoints.  Whatever is sent on one arrives on
+ * the other as a "message-received" emission on that endpoint's
+ * context, in the order it was sent.  The endpoints may be used from
+ * different threads as long as each context is iterated by its thread.
+ *
+ * Both endpoints start %MCP_TRANSPORT_STATE_DISCONNECTED and become
+ * connected through mcp_transport_connect_async() as usual.  Messages
+ * sent to an endpoint that is not connected yet wait in its queue.
+ *
+ * Received messages are immutable (see json_node_seal()): handlers may
+ * keep references to them but must copy before modifying.
+ */
+void mcp_in_process_transport_new_pair (GMainContext           *context_a,
+                                        GMainContext           *context_b,
+                                        McpInProcessTransport **out_a,
+                                        McpInProcessTransport **out_b);
+
+/**
+ * mcp_in_process_transport_get_peer:
+ * @self: an #McpInProcessTransport
+ *
+ * Gets the other endpoint of the pair.
+ *
+ * Returns: (transfer full) (nullable): the peer, or %NULL if it has
+ *   been finalized
+ */
+McpInProcessTransport *mcp_in_process_transport_get_peer (McpInProcessTransport *self);
+
+/**
+ * mcp_in_process_transport_get_context:
+ * @self: an #McpInProcessTransport
+ *
+ * Gets the #GMainContext this endpoint delivers received messages on.
+ *
+ * Returns: (transfer none): the context
+ */
+GMainContext *mcp_in_process_transport_get_context (McpInProcessTransport *self);
+
+G_END_DECLS
+
+#endif /* MCP_IN_PROCESS_TRANSPORT_H */
@@ -0,0 +1,429 @@
+/*
+ * mcp-json-intern.c - Shared immutable JSON values
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+#include "mcp-json-intern.h"
+
+#include <string.h>
+
+/*
+ * Every object and array in the table is sealed, and every object or
+ * array inside one is itself in the table.  Comparing two candidates
+ * therefore never recurses: nested containers are equal exactly when
+ * they are the same pointer.
+ *
+ * The value of each entry counts its uses: callers of mcp_json_intern()
+ * that have not released it yet, plus the entries that contain it.
+ * The table holds one reference on each key.
+ */
+static GMutex intern_lock;
+static GHashTable *intern_table = NULL;     /* JsonNode -> use count */
+
+static gboolean
+is_container (JsonNode *node)
+{
+    return JSON_NODE_HOLDS_OBJECT (node) || JSON_NODE_HOLDS_ARRAY (node);
+}
+
+static guint
+scalar_hash (JsonNode *node)
+{
+    if (JSON_NODE_HOLDS_NULL (node))
+    {
+        return 0;
+    }
+
+    switch (json_node_get_value_type (node))
+    {
+        case G_TYPE_INT64:
+            {
+                gint64 value = json_node_get_int (node);
+
+                return g_int64_hash (&value);
+            }
+        case G_TYPE_DOUBLE:
+            {
+                gdouble value = json_node_get_double (node);
+
+                return g_double_hash (&value) ^ 1;
+            }
+        case G_TYPE_BOOLEAN:
+            return json_node_get_boolean (node) ? 2 : 3;
+        case G_TYPE_STRING:
+            return g_str_hash (json_node_get_string (node));
+        default:
+            return 4;
+    }
+}
+
+static gboolean
+scalar_equal (JsonNode *a,
+              JsonNode *b)
+{
+    if (JSON_NODE_TYPE (a) != JSON_NODE_TYPE (b))
+    {
+        return FALSE;
+    }
+    if (JSON_NODE_HOLDS_NULL (a))
+    {
+        return TRUE;
+    }
+    if (json_node_get_value_type (a) != json_node_get_value_type (b))
+    {
+        return FALSE;
+    }
+
+    switch (json_node_get_value_type (a))
+    {
+        case G_TYPE_INT64:
+            return json_node_get_int (a) == json_node_get_int (b);
+        case G_TYPE_DOUBLE:
+            {
+                /* Bitwise, so 0.0 and -0.0 stay apart as their hashes do */
+                gdouble value_a = json_node_get_double (a);
+                gdouble value_b = json_node_get_double (b);
+
+                return memcmp (&value_a, &value_b, sizeof (gdouble)) == 0;
+            }
+        case G_TYPE_BOOLEAN:
+            return json_node_get_boolean (a) == json_node_get_boolean (b);
+        case G_TYPE_STRING:
+            return g_strcmp0 (json_node_get_string (a), json_node_get_string (b)) == 0;
+        default:
+            return FALSE;
+    }
+}
+
+/* A nested container is already interned, so its address identifies it */
+static guint
+child_hash (JsonNode *node)
+{
+    return is_container (node) ? g_direct_hash (node) : scalar_hash (node);
+}
+
+static gboolean
+child_equal (JsonNode *a,
+             JsonNode *b)
+{
+    if (is_container (a) || is_container (b))
+    {
+        return a == b;
+    }
+
+    return scalar_equal (a, b);
+}
+
+static guint
+intern_hash (gconstpointer key)
+{
+    JsonNode *node = (JsonNode *) key;
+    guint hash;
+
+    if (JSON_NODE_HOLDS_OBJECT (node))
+    {
+        JsonObject *object = json_node_get_object (node);
+        GList *members = json_object_get_members (object);
+        GList *l;
+
+        hash = 5381;
+        for (l = members; l != NULL; l = l->next)
+        {
+            hash = hash * 31 + g_str_hash (l->data);
+            hash = hash * 31 + child_hash (json_object_get_member (object, l->data));
+        }
+        g_list_free (members);
+    }
+    else
+    {
+        JsonArray *array = json_node_get_array (node);
+        guint length = json_array_get_length (array);
+        guint i;
+
+        hash = 5387;
+        for (i = 0; i < length; i++)
+        {
+            hash = hash * 31 + child_hash (json_array_get_element (array, i));
+        }
+    }
+
+    return hash;
+}
+
+static gboolean
+intern_equal (gconstpointer a,
+              gconstpointer b)
+{
+    JsonNode *node_a = (JsonNode *) a;
+    JsonNode *node_b = (JsonNode *) b;
+
+    if (node_a == node_b)
+    {
+        return TRUE;
+    }
+    if (JSON_NODE_TYPE (node_a) != JSON_NODE_TYPE (node_b))
+    {
+        return FALSE;
+    }
+
+    if (JSON_NODE_HOLDS_OBJECT (node_a))
+    {
+        JsonObject *object_a = json_node_get_object (node_a);
+        JsonObject *object_b = json_node_get_object (node_b);
+        GList *members_a;
+        GList *members_b;
+        GList *la;
+        GList *lb;
+        gboolean equal = TRUE;
+
+        if (json_object_get_size (object_a) != json_object_get_size (object_b))
+        {
+            return FALSE;
+        }
+
+        /* Member order is kept: it shows in what clients are sent */
+        members_a = json_object_get_members (object_a);
+        members_b = json_object_get_members (object_b);
+        for (la = members_a, lb = members_b;
+             equal && la != NULL && lb != NULL;
+             la = la->next, lb = lb->next)
+        {
+            equal = g_str_equal (la->data, lb->data) &&
+                    child_equal (json_object_get_member (object_a, la->data),
+                                 json_object_get_member (object_b, lb->data));
+        }
+        g_list_free (members_a);
+        g_list_free (members_b);
+
+        return equal;
+    }
+    else
+    {
+        JsonArray *array_a = json_node_get_array (node_a);
+        JsonArray *array_b = json_node_get_array (node_b);
+        guint length = json_array_get_length (array_a);
+        guint i;
+
+        if (json_array_get_length (array_b) != length)
+        {
+            return FALSE;
+        }
+
+        for (i = 0; i < length; i++)
+        {
+            if (!child_equal (json_array_get_element (array_a, i),
+                              json_array_get_element (array_b, i)))
+            {
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+}
+
+static void release_locked (JsonNode *node);
+
+/* Drops the use @node's entry has of each container inside it */
+static void
+release_children_locked (JsonNode *node)
+{
+    if (JSON_NODE_HOLDS_OBJECT (node))
+    {
+        JsonObject *object = json_node_get_object (node);
+        GList *members = json_object_get_members (object);
+        GList *l;
+
+        for (l = members; l != NULL; l = l->next)
+        {
+            release_locked (json_object_get_member (object, l->data));
+        }
+        g_list_free (members);
+    }
+    else if (JSON_NODE_HOLDS_ARRAY (node))
+    {
+        JsonArray *array = json_node_get_array (node);
+        guint length = json_array_get_length (array);
+        guint i;
+
+        for (i = 0; i < length; i++)
+        {
+            release_locked (json_array_get_element (array, i));
+        }
+    }
+}
+
+/* Drops one use of @node; references are left to the caller */
+static void
+release_locked (JsonNode *node)
+{
+    gpointer key;
+    gpointer value;
+    guint uses;
+
+    if (!is_container (node) ||
+        !g_hash_table_lookup_extended (intern_table, node, &key, &value) ||
+        key != node)
+    {
+        return;
+    }
+
+    uses = GPOINTER_TO_UINT (value);
+    if (uses > 1)
+    {
+        g_hash_table_insert (intern_table, key, GUINT_TO_POINTER (uses - 1));
+        return;
+    }
+
+    g_hash_table_steal (intern_table, node);
+    release_children_locked (node);
+    json_node_unref (node);
+}
+
+static JsonNode *intern_locked (JsonNode *node);
+
+static JsonNode *
+intern_child_locked (JsonNode *child)
+{
+    JsonNode *copy;
+
+    if (is_container (child))
+    {
+        return intern_locked (child);
+    }
+
+    copy = json_node_copy (child);
+    json_node_seal (copy);
+    return copy;
+}
+
+/*
+ * Returns a new reference to the shared instance of the object or
+ * array @node and counts a use of it.
+ */
+static JsonNode *
+intern_locked (JsonNode *node)
+{
+    JsonNode *copy;
+    gpointer key;
+    gpointer value;
+
+    /* Already the shared instance: the usual case when one tool's
+     * schema is handed to another */
+    if (json_node_is_immutable (node) &&
+        g_hash_table_lookup_extended (intern_table, node, &key, &value) &&
+        key == node)
+    {
+        g_hash_table_insert (intern_table, key,
+                             GUINT_TO_POINTER (GPOINTER_TO_UINT (value) + 1));
+        return json_node_ref (key);
+    }
+
+    if (JSON_NODE_HOLDS_OBJECT (node))
+    {
+        JsonObject *src = json_node_get_object (node);
+        JsonObject *object = json_object_new ();
+        GList *members = json_object_get_members (src);
+        GList *l;
+
+        for (l = members; l != NULL; l = l->next)
+        {
+            json_object_set_member (object, l->data,
+                                    intern_child_locked (json_object_get_member (src, l->data)));
+        }
+        g_list_free (members);
+
+        copy = json_node_new (JSON_NODE_OBJECT);
+        json_node_take_object (copy, object);
+    }
+    else
+    {
+        JsonArray *src = json_node_get_array (node);
+        guint length = json_array_get_length (src);
+        JsonArray *array = json_array_sized_new (length);
+        guint i;
+
+        for (i = 0; i < length; i++)
+        {
+            json_array_add_element (array,
+                                    intern_child_locked (json_array_get_element (src, i)));
+        }
+
+        copy = json_node_new (JSON_NODE_ARRAY);
+        json_node_take_array (copy, array);
+    }
+    json_node_seal (copy);
+
+    if (g_hash_table_lookup_extended (intern_table, copy, &key, &value))
+    {
+        /* The copy's children were counted as uses; give them back */
+        release_children_locked (copy);
+        json_node_unref (copy);
+
+        g_hash_table_insert (intern_table, key,
+                             GUINT_TO_POINTER (GPOINTER_TO_UINT (value) + 1));
+        return json_node_ref (key);
+    }
+
+    g_hash_table_insert (intern_table, copy, GUINT_TO_POINTER (1));
+    return json_node_ref (copy);
+}
+
+JsonNode *
+mcp_json_intern (JsonNode *node)
+{
+    JsonNode *result;
+
+    g_return_val_if_fail (node != NULL, NULL);
+
+    if (!is_container (node))
+    {
+        result = json_node_copy (node);
+        json_node_seal (result);
+        return result;
+    }
+
+    g_mutex_lock (&intern_lock);
+    if (intern_table == NULL)
+    {
+        intern_table = g_hash_table_new (intern_hash, intern_equal);
+    }
+    result = intern_locked (node);
+    g_mutex_unlock (&intern_lock);
+
+    return result;
+}
+
+void
+mcp_json_intern_release (JsonNode *node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    if (is_container (node))
+    {
+        g_mutex_lock (&intern_lock);
+        if (intern_table != NULL)
+        {
+            release_locked (node);
+        }
+        g_mutex_unlock (&intern_lock);
+    }
+
+    json_node_unref (node);
+}
+
+guint
+mcp_json_intern_get_count (void)
+{
+    guint count;
+
+    g_mutex_lock (&intern_lock);
+    count = intern_table != NULL ? g_hash_table_size (intern_table) : 0;
+    g_mutex_unlock (&intern_lock);
+
+    return count;
+}
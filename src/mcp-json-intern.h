@@ -0,0 +1,68 @@
+/*
+ * mcp-json-intern.h - Shared immutable JSON values
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * Tools tend to repeat the same schemas and sub-schemas (pagination
+ * arguments, path arguments), and every per-connection McpServer of an
+ * McpUnixSocketServer holds the same tools.  Interning keeps one sealed
+ * instance of each distinct object or array for the whole process, so
+ * an identical schema costs a reference rather than a tree.
+ */
+
+#ifndef MCP_JSON_INTERN_H
+#define MCP_JSON_INTERN_H
+
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * mcp_json_intern:
+ * @node: a #JsonNode
+ *
+ * Gets the shared, sealed instance of @node.  Objects and arrays are
+ * hash-consed from the leaves up: every object or array inside the
+ * result is itself shared, so two schemas with a common sub-schema
+ * hold the same instance of it.  Two values are the same when they
+ * have the same members in the same order with the same names and
+ * the same values, including the type of each number.
+ *
+ * @node itself is neither modified nor kept.  Interning a value that
+ * is already the shared instance only takes a reference.  Scalars
+ * are not shared; they come back as a sealed copy.
+ *
+ * This function is thread-safe.
+ *
+ * Returns: (transfer full): an immutable node equal to @node; give it
+ *   back with mcp_json_intern_release()
+ */
+JsonNode *mcp_json_intern (JsonNode *node);
+
+/**
+ * mcp_json_intern_release:
+ * @node: (transfer full): a node returned by mcp_json_intern()
+ *
+ * Drops a reference returned by mcp_json_intern().  Once nothing uses
+ * a value through mcp_json_intern() any more it is forgotten, so the
+ * next equal value becomes a new instance.  Other references taken
+ * with json_node_ref() stay valid but do not keep the value shared.
+ */
+void mcp_json_intern_release (JsonNode *node);
+
+/**
+ * mcp_json_intern_get_count:
+ *
+ * Gets the number of distinct objects and arrays currently shared,
+ * counting every nested one.
+ *
+ * Returns: the number of interned values
+ */
+guint mcp_json_intern_get_count (void);
+
+G_END_DECLS
+
+#endif /* MCP_JSON_INTERN_H */
@@ -0,0 +1,814 @@
+/*
+ * mcp-json-parse.c - JSON parsing backends for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+#include "mcp-json-parse.h"
+
+#include <errno.h>
+#include <string.h>
+
+typedef struct
+{
+    const gchar *name;
+    JsonNode  *(*parse) (const gchar  *data,
+                         gsize         length,
+                         GError      **error);
+} ParserBackend;
+
+static JsonNode *parse_native    (const gchar  *data,
+                                  gsize         length,
+                                  GError      **error);
+static JsonNode *parse_json_glib (const gchar  *data,
+                                  gsize         length,
+                                  GError      **error);
+
+static const ParserBackend backends[] =
+{
+    { MCP_JSON_PARSER_BACKEND_NATIVE, parse_native },
+    { MCP_JSON_PARSER_BACKEND_JSON_GLIB, parse_json_glib },
+};
+
+static gpointer current_backend = NULL;  /* const ParserBackend * */
+
+static const ParserBackend *
+lookup_backend (const gchar *name)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (backends); i++)
+    {
+        if (g_strcmp0 (backends[i].name, name) == 0)
+        {
+            return &backends[i];
+        }
+    }
+
+    return NULL;
+}
+
+static const ParserBackend *
+get_backend (void)
+{
+    const ParserBackend *backend = g_atomic_pointer_get (&current_backend);
+
+    if (G_UNLIKELY (backend == NULL))
+    {
+        const gchar *env = g_getenv ("MCP_JSON_PARSER");
+
+        backend = &backends[0];
+        if (env != NULL && *env != '\0')
+        {
+            const ParserBackend *named = lookup_backend (env);
+
+            if (named != NULL)
+            {
+                backend = named;
+            }
+            else
+            {
+                g_warning ("Unknown MCP_JSON_PARSER backend '%s', using '%s'",
+                           env, backend->name);
+            }
+        }
+
+        g_atomic_pointer_compare_and_exchange (&current_backend, NULL,
+                                               (gpointer) backend);
+        backend = g_atomic_pointer_get (&current_backend);
+    }
+
+    return backend;
+}
+
+JsonNode *
+mcp_json_parse (const gchar  *data,
+                gssize        length,
+                GError      **error)
+{
+    g_return_val_if_fail (data != NULL || length == 0, NULL);
+
+    if (length < 0)
+    {
+        length = strlen (data);
+    }
+
+    return get_backend ()->parse (data, (gsize) length, error);
+}
+
+gboolean
+mcp_json_parse_set_backend (const gchar *name)
+{
+    const ParserBackend *backend;
+
+    g_return_val_if_fail (name != NULL, FALSE);
+
+    backend = lookup_backend (name);
+    if (backend == NULL)
+    {
+        return FALSE;
+    }
+
+    g_atomic_pointer_set (&current_backend, (gpointer) backend);
+    return TRUE;
+}
+
+const gchar *
+mcp_json_parse_get_backend (void)
+{
+    return get_backend ()->name;
+}
+
+/* ========================================================================== */
+/* json-glib backend                                                          */
+/* ========================================================================== */
+
+static JsonNode *
+parse_json_glib (const gchar  *data,
+                 gsize         length,
+                 GError      **error)
+{
+    g_autoptr(JsonParser) parser = NULL;
+    JsonNode *root;
+
+    parser = json_parser_new ();
+    if (!json_parser_load_from_data (parser, data, (gssize) length, error))
+    {
+        return NULL;
+    }
+
+    root = json_parser_steal_root (parser);
+    if (root == NULL)
+    {
+        g_set_error_literal (error, JSON_PARSER_ERROR, JSON_PARSER_ERROR_PARSE,
+                             "Empty JSON document");
+    }
+
+    return root;
+}
+
+/* ========================================================================== */
+/* Native backend                                                             */
+/* ========================================================================== */
+
+/* Nesting limit; MCP messages are nowhere near this deep */
+#define MAX_DEPTH (512)
+
+/* Numbers longer than this are copied to the heap for strtod */
+#define NUMBER_BUF_SIZE (64)
+
+/* Member names shorter than this are copied to the stack */
+#define KEY_BUF_SIZE (64)
+
+#define ONES  G_GUINT64_CONSTANT (0x0101010101010101)
+#define HIGHS G_GUINT64_CONSTANT (0x8080808080808080)
+
+typedef struct
+{
+    const gchar  *start;
+    const gchar  *p;
+    const gchar  *end;
+    guint         depth;
+    GString      *scratch;
+    GError      **error;
+} NativeParser;
+
+static JsonNode *parse_value (NativeParser *np);
+
+static gboolean
+fail (NativeParser    *np,
+      JsonParserError  code,
+      const gchar     *what)
+{
+    g_set_error (np->error, JSON_PARSER_ERROR, code,
+                 "Parse error at byte %" G_GSIZE_FORMAT ": %s",
+                 (gsize) (np->p - np->start), what);
+    return FALSE;
+}
+
+static inline void
+skip_ws (NativeParser *np)
+{
+    while (np->p < np->end &&
+           (*np->p == ' ' || *np->p == '\n' || *np->p == '\r' || *np->p == '\t'))
+    {
+        np->p++;
+    }
+}
+
+/*
+ * string_stop:
+ *
+ * Non-zero if any byte of @w ends a plain run inside a string: a
+ * control character, '"' or '\\'.  Bytes >= 0x80 never match.
+ */
+static inline gboolean
+string_stop (guint64 w)
+{
+    guint64 quote = w ^ (ONES * '"');
+    guint64 bslash = w ^ (ONES * '\\');
+    guint64 ctrl = (w - ONES * 0x20) & ~w;
+
+    quote = (quote - ONES) & ~quote;
+    bslash = (bslash - ONES) & ~bslash;
+
+    return ((ctrl | quote | bslash) & HIGHS) != 0;
+}
+
+static gboolean
+is_ascii (const gchar *data,
+          gsize        length)
+{
+    gsize i = 0;
+
+    for (; i + sizeof (guint64) <= length; i += sizeof (guint64))
+    {
+        guint64 w;
+
+        memcpy (&w, data + i, sizeof (w));
+        if ((w & HIGHS) != 0)
+        {
+            return FALSE;
+        }
+    }
+
+    for (; i < length; i++)
+    {
+        if ((guchar) data[i] >= 0x80)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static gint
+hex_value (gchar c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static gboolean
+read_hex4 (NativeParser *np,
+           gunichar     *out)
+{
+    gunichar value = 0;
+    gint i;
+
+    if (np->end - np->p < 4)
+    {
+        return fail (np, JSON_PARSER_ERROR_INVALID_DATA, "truncated \\u escape");
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        gint digit = hex_value (np->p[i]);
+
+        if (digit < 0)
+        {
+            return fail (np, JSON_PARSER_ERROR_INVALID_DATA, "invalid \\u escape");
+        }
+        value = (value << 4) | (gunichar) digit;
+    }
+
+    np->p += 4;
+    *out = value;
+    return TRUE;
+}
+
+static gboolean
+read_escape (NativeParser *np)
+{
+    gunichar ch;
+
+    /* np->p is just past the backslash */
+    if (np->p >= np->end)
+    {
+        return fail (np, JSON_PARSER_ERROR_PARSE, "unterminated string");
+    }
+
+    switch (*np->p++)
+    {
+        case '"':  g_string_append_c (np->scratch, '"');  return TRUE;
+        case '\\': g_string_append_c (np->scratch, '\\'); return TRUE;
+        case '/':  g_string_append_c (np->scratch, '/');  return TRUE;
+        case 'b':  g_string_append_c (np->scratch, '\b'); return TRUE;
+        case 'f':  g_string_append_c (np->scratch, '\f'); return TRUE;
+        case 'n':  g_string_append_c (np->scratch, '\n'); return TRUE;
+        case 'r':  g_string_append_c (np->scratch, '\r'); return TRUE;
+        case 't':  g_string_append_c (np->scratch, '\t'); return TRUE;
+        case 'u':
+            break;
+        default:
+            np->p--;
+            return fail (np, JSON_PARSER_ERROR_INVALID_DATA, "invalid escape");
+    }
+
+    if (!read_hex4 (np, &ch))
+    {
+        return FALSE;
+    }
+
+    if (ch >= 0xD800 && ch <= 0xDBFF)
+    {
+        gunichar low;
+
+        if (np->end - np->p < 2 || np->p[0] != '\\' || np->p[1] != 'u')
+        {
+            return fail (np, JSON_PARSER_ERROR_INVALID_DATA, "unpaired surrogate");
+        }
+        np->p += 2;
+        if (!read_hex4 (np, &low))
+        {
+            return FALSE;
+        }
+        if (low < 0xDC00 || low > 0xDFFF)
+        {
+            return fail (np, JSON_PARSER_ERROR_INVALID_DATA, "unpaired surrogate");
+        }
+        ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+    }
+    else if (ch >= 0xDC00 && ch <= 0xDFFF)
+    {
+        return fail (np, JSON_PARSER_ERROR_INVALID_DATA, "unpaired surrogate");
+    }
+
+    g_string_append_unichar (np->scratch, ch);
+    return TRUE;
+}
+
+/*
+ * read_string:
+ *
+ * Reads the string at np->p (which must be '"') into np->scratch.
+ */
+static gboolean
+read_string (NativeParser *np)
+{
+    const gchar *run;
+
+    g_string_truncate (np->scratch, 0);
+    run = ++np->p;
+
+    for (;;)
+    {
+        guchar c;
+
+        /* Plain runs are skipped a word at a time */
+        while (np->end - np->p >= (gssize) sizeof (guint64))
+        {
+            guint64 w;
+
+            memcpy (&w, np->p, sizeof (w));
+            if (string_stop (w))
+            {
+                break;
+            }
+            np->p += sizeof (guint64);
+        }
+
+        if (np->p >= np->end)
+        {
+            return fail (np, JSON_PARSER_ERROR_PARSE, "unterminated string");
+        }
+
+        c = (guchar) *np->p;
+        if (c == '"')
+        {
+            g_string_append_len (np->scratch, run, np->p - run);
+            np->p++;
+            return TRUE;
+        }
+        if (c == '\\')
+        {
+            g_string_append_len (np->scratch, run, np->p - run);
+            np->p++;
+            if (!read_escape (np))
+            {
+                return FALSE;
+            }
+            run = np->p;
+            continue;
+        }
+        if (c < 0x20)
+        {
+            return fail (np, JSON_PARSER_ERROR_INVALID_DATA,
+                         "control character in string");
+        }
+        np->p++;
+    }
+}
+
+static JsonNode *
+parse_number (NativeParser *np)
+{
+    const gchar *start = np->p;
+    gboolean is_int = TRUE;
+    gchar buf[NUMBER_BUF_SIZE];
+    g_autofree gchar *heap = NULL;
+    gchar *text;
+    gsize len;
+    JsonNode *node;
+
+    if (*np->p == '-')
+    {
+        np->p++;
+    }
+
+    if (np->p < np->end && *np->p == '0')
+    {
+        np->p++;
+    }
+    else if (np->p < np->end && g_ascii_isdigit (*np->p))
+    {
+        while (np->p < np->end && g_ascii_isdigit (*np->p))
+        {
+            np->p++;
+        }
+    }
+    else
+    {
+        fail (np, JSON_PARSER_ERROR_INVALID_DATA, "invalid number");
+        return NULL;
+    }
+
+    if (np->p < np->end && *np->p == '.')
+    {
+        is_int = FALSE;
+        np->p++;
+        if (np->p >= np->end || !g_ascii_isdigit (*np->p))
+        {
+            fail (np, JSON_PARSER_ERROR_INVALID_DATA, "invalid number");
+            return NULL;
+        }
+        while (np->p < np->end && g_ascii_isdigit (*np->p))
+        {
+            np->p++;
+        }
+    }
+
+    if (np->p < np->end && (*np->p == 'e' || *np->p == 'E'))
+    {
+        is_int = FALSE;
+        np->p++;
+        if (np->p < np->end && (*np->p == '+' || *np->p == '-'))
+        {
+            np->p++;
+        }
+        if (np->p >= np->end || !g_ascii_isdigit (*np->p))
+        {
+            fail (np, JSON_PARSER_ERROR_INVALID_DATA, "invalid number");
+            return NULL;
+        }
+        while (np->p < np->end && g_ascii_isdigit (*np->p))
+        {
+            np->p++;
+        }
+    }
+
+    /* strtoll/strtod need a terminated copy; the input may not be */
+    len = np->p - start;
+    if (len < sizeof (buf))
+    {
+        memcpy (buf, start, len);
+        buf[len] = '\0';
+        text = buf;
+    }
+    else
+    {
+        heap = g_strndup (start, len);
+        text = heap;
+    }
+
+    node = json_node_new (JSON_NODE_VALUE);
+
+    if (is_int)
+    {
+        gint64 value;
+
+        errno = 0;
+        value = g_ascii_strtoll (text, NULL, 10);
+        if (errno != ERANGE)
+        {
+            json_node_set_int (node, value);
+            return node;
+        }
+        /* Out of gint64 range: keep it as a double, like JsonParser */
+    }
+
+    json_node_set_double (node, g_ascii_strtod (text, NULL));
+    return node;
+}
+
+static JsonNode *
+parse_literal (NativeParser *np)
+{
+    static const struct
+    {
+        const gchar *word;
+        gsize        len;
+    } literals[] = {
+        { "true", 4 },
+        { "false", 5 },
+        { "null", 4 },
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (literals); i++)
+    {
+        gsize len = literals[i].len;
+        JsonNode *node;
+
+        if ((gsize) (np->end - np->p) < len ||
+            memcmp (np->p, literals[i].word, len) != 0 ||
+            (np->p + len < np->end && g_ascii_isalnum (np->p[len])))
+        {
+            continue;
+        }
+
+        np->p += len;
+        if (i == 2)
+        {
+            return json_node_new (JSON_NODE_NULL);
+        }
+
+        node = json_node_new (JSON_NODE_VALUE);
+        json_node_set_boolean (node, i == 0);
+        return node;
+    }
+
+    fail (np, JSON_PARSER_ERROR_INVALID_BAREWORD, "invalid bareword");
+    return NULL;
+}
+
+static JsonNode *
+parse_object (NativeParser *np)
+{
+    g_autoptr(JsonObject) object = NULL;
+    JsonNode *node;
+
+    if (++np->depth > MAX_DEPTH)
+    {
+        fail (np, JSON_PARSER_ERROR_PARSE, "nesting too deep");
+        return NULL;
+    }
+
+    np->p++;
+    object = json_object_new ();
+
+    skip_ws (np);
+    if (np->p < np->end && *np->p == '}')
+    {
+        np->p++;
+        goto done;
+    }
+
+    for (;;)
+    {
+        gchar key_buf[KEY_BUF_SIZE];
+        g_autofree gchar *key_heap = NULL;
+        const gchar *key;
+        JsonNode *value;
+
+        skip_ws (np);
+        if (np->p >= np->end)
+        {
+            fail (np, JSON_PARSER_ERROR_PARSE, "unterminated object");
+            return NULL;
+        }
+        if (*np->p != '"')
+        {
+            if (*np->p == '}')
+            {
+                fail (np, JSON_PARSER_ERROR_TRAILING_COMMA, "trailing comma");
+            }
+            else if (g_ascii_isalpha (*np->p))
+            {
+                fail (np, JSON_PARSER_ERROR_INVALID_BAREWORD, "invalid bareword");
+            }
+            else
+            {
+                fail (np, JSON_PARSER_ERROR_PARSE, "expected member name");
+            }
+            return NULL;
+        }
+
+        if (!read_string (np))
+        {
+            return NULL;
+        }
+
+        /* scratch is reused for the value, so keep the name aside */
+        if (np->scratch->len < sizeof (key_buf))
+        {
+            memcpy (key_buf, np->scratch->str, np->scratch->len + 1);
+            key = key_buf;
+        }
+        else
+        {
+            key_heap = g_strndup (np->scratch->str, np->scratch->len);
+            key = key_heap;
+        }
+
+        skip_ws (np);
+        if (np->p >= np->end || *np->p != ':')
+        {
+            fail (np, JSON_PARSER_ERROR_MISSING_COLON, "missing ':'");
+            return NULL;
+        }
+        np->p++;
+
+        skip_ws (np);
+        value = parse_value (np);
+        if (value == NULL)
+        {
+            return NULL;
+        }
+        json_object_set_member (object, key, value);
+
+        skip_ws (np);
+        if (np->p < np->end && *np->p == ',')
+        {
+            np->p++;
+            continue;
+        }
+        if (np->p < np->end && *np->p == '}')
+        {
+            np->p++;
+            break;
+        }
+        fail (np, JSON_PARSER_ERROR_MISSING_COMMA, "missing ',' or '}'");
+        return NULL;
+    }
+
+done:
+    np->depth--;
+    node = json_node_new (JSON_NODE_OBJECT);
+    json_node_take_object (node, g_steal_pointer (&object));
+    return node;
+}
+
+static JsonNode *
+parse_array (NativeParser *np)
+{
+    g_autoptr(JsonArray) array = NULL;
+    JsonNode *node;
+
+    if (++np->depth > MAX_DEPTH)
+    {
+        fail (np, JSON_PARSER_ERROR_PARSE, "nesting too deep");
+        return NULL;
+    }
+
+    np->p++;
+    array = json_array_new ();
+
+    skip_ws (np);
+    if (np->p < np->end && *np->p == ']')
+    {
+        np->p++;
+        goto done;
+    }
+
+    for (;;)
+    {
+        JsonNode *element;
+
+        skip_ws (np);
+        if (np->p < np->end && *np->p == ']')
+        {
+            fail (np, JSON_PARSER_ERROR_TRAILING_COMMA, "trailing comma");
+            return NULL;
+        }
+
+        element = parse_value (np);
+        if (element == NULL)
+        {
+            return NULL;
+        }
+        json_array_add_element (array, element);
+
+        skip_ws (np);
+        if (np->p < np->end && *np->p == ',')
+        {
+            np->p++;
+            continue;
+        }
+        if (np->p < np->end && *np->p == ']')
+        {
+            np->p++;
+            break;
+        }
+        fail (np, JSON_PARSER_ERROR_MISSING_COMMA, "missing ',' or ']'");
+        return NULL;
+    }
+
+done:
+    np->depth--;
+    node = json_node_new (JSON_NODE_ARRAY);
+    json_node_take_array (node, g_steal_pointer (&array));
+    return node;
+}
+
+static JsonNode *
+parse_value (NativeParser *np)
+{
+    JsonNode *node;
+
+    if (np->p >= np->end)
+    {
+        fail (np, JSON_PARSER_ERROR_PARSE, "unexpected end of data");
+        return NULL;
+    }
+
+    switch (*np->p)
+    {
+        case '{':
+            return parse_object (np);
+
+        case '[':
+            return parse_array (np);
+
+        case '"':
+            if (!read_string (np))
+            {
+                return NULL;
+            }
+            node = json_node_new (JSON_NODE_VALUE);
+            json_node_set_string (node, np->scratch->str);
+            return node;
+
+        case '-':
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return parse_number (np);
+
+        default:
+            if (g_ascii_isalpha (*np->p))
+            {
+                return parse_literal (np);
+            }
+            fail (np, JSON_PARSER_ERROR_PARSE, "unexpected character");
+            return NULL;
+    }
+}
+
+static JsonNode *
+parse_native (const gchar  *data,
+              gsize         length,
+              GError      **error)
+{
+    NativeParser np = { 0, };
+    JsonNode *root;
+
+    /* Validate once up front so strings can be copied without checks */
+    if (!is_ascii (data, length) && !g_utf8_validate (data, (gssize) length, NULL))
+    {
+        g_set_error_literal (error, JSON_PARSER_ERROR, JSON_PARSER_ERROR_INVALID_DATA,
+                             "Invalid UTF-8 in JSON document");
+        return NULL;
+    }
+
+    np.start = data;
+    np.p = data;
+    np.end = data + length;
+    np.error = error;
+
+    skip_ws (&np);
+    if (np.p == np.end)
+    {
+        g_set_error_literal (error, JSON_PARSER_ERROR, JSON_PARSER_ERROR_PARSE,
+                             "Empty JSON document");
+        return NULL;
+    }
+
+    np.scratch = g_string_sized_new (256);
+    root = parse_value (&np);
+
+    if (root != NULL)
+    {
+        skip_ws (&np);
+        if (np.p != np.end)
+        {
+            fail (&np, JSON_PARSER_ERROR_PARSE, "trailing data after document");
+            g_clear_pointer (&root, json_node_unref);
+        }
+    }
+
+    g_string_free (np.scratch, TRUE);
+
+    return root;
+}
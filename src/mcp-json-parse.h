@@ -0,0 +1,78 @@
+/*
+ * mcp-json-parse.h - JSON parsing backends for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * Every inbound message (transports, mcp_message_parse()) goes through
+ * mcp_json_parse().  The backend that does the work is selectable, so
+ * the built-in parser can be compared against json-glib's JsonParser or
+ * swapped out when debugging interoperability problems.
+ */
+
+#ifndef MCP_JSON_PARSE_H
+#define MCP_JSON_PARSE_H
+
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * MCP_JSON_PARSER_BACKEND_NATIVE:
+ *
+ * Name of the built-in backend: a single-pass recursive-descent parser
+ * over the whole buffer that skips string contents and checks for
+ * non-ASCII data a machine word at a time.  This is the default.
+ */
+#define MCP_JSON_PARSER_BACKEND_NATIVE "native"
+
+/**
+ * MCP_JSON_PARSER_BACKEND_JSON_GLIB:
+ *
+ * Name of the backend that uses json-glib's #JsonParser.
+ */
+#define MCP_JSON_PARSER_BACKEND_JSON_GLIB "json-glib"
+
+/**
+ * mcp_json_parse:
+ * @data: JSON text
+ * @length: length of @data in bytes, or -1 if NUL-terminated
+ * @error: (nullable): return location for a #GError
+ *
+ * Parses one JSON document with the current backend.  Errors are in
+ * the %JSON_PARSER_ERROR domain whichever backend is used; an empty or
+ * whitespace-only document is an error.
+ *
+ * Returns: (transfer full) (nullable): the root node, or %NULL on error
+ */
+JsonNode *mcp_json_parse (const gchar  *data,
+                          gssize        length,
+                          GError      **error);
+
+/**
+ * mcp_json_parse_set_backend:
+ * @name: a backend name, e.g. %MCP_JSON_PARSER_BACKEND_NATIVE
+ *
+ * Selects the backend used by mcp_json_parse() for the whole process.
+ * Without a call to this function the backend named by the
+ * `MCP_JSON_PARSER` environment variable is used, falling back to
+ * %MCP_JSON_PARSER_BACKEND_NATIVE.
+ *
+ * Returns: %TRUE if @name is a known backend
+ */
+gboolean mcp_json_parse_set_backend (const gchar *name);
+
+/**
+ * mcp_json_parse_get_backend:
+ *
+ * Gets the name of the backend used by mcp_json_parse().
+ *
+ * Returns: (transfer none): the backend name
+ */
+const gchar *mcp_json_parse_get_backend (void);
+
+G_END_DECLS
+
+#endif /* MCP_JSON_PARSE_H */
@@ -0,0 +1,454 @@
+/*
+ * mcp-json-writer.c - Streaming JSON writer for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+#include "mcp-json-writer.h"
+
+#include <string.h>
+
+struct _McpJsonWriter
+{
+    GString  *buffer;
+
+    /* A value was written at the current nesting level */
+    gboolean  need_comma;
+
+    /* A member name was just written; the next value is its value */
+    gboolean  after_member;
+};
+
+/* Initial buffer size; most MCP messages fit without regrowing */
+#define WRITER_INITIAL_SIZE (4096)
+
+McpJsonWriter *
+mcp_json_writer_new (void)
+{
+    McpJsonWriter *self;
+
+    self = g_new0 (McpJsonWriter, 1);
+    self->buffer = g_string_sized_new (WRITER_INITIAL_SIZE);
+
+    return self;
+}
+
+void
+mcp_json_writer_free (McpJsonWriter *self)
+{
+    if (self == NULL)
+    {
+        return;
+    }
+
+    g_string_free (self->buffer, TRUE);
+    g_free (self);
+}
+
+void
+mcp_json_writer_reset (McpJsonWriter *self)
+{
+    g_return_if_fail (self != NULL);
+
+    g_string_truncate (self->buffer, 0);
+    self->need_comma = FALSE;
+    self->after_member = FALSE;
+}
+
+/* ========================================================================== */
+/* String escaping                                                            */
+/* ========================================================================== */
+
+#define ONES  G_GUINT64_CONSTANT (0x0101010101010101)
+#define HIGHS G_GUINT64_CONSTANT (0x8080808080808080)
+
+/*
+ * needs_escape:
+ *
+ * Tests eight bytes at once for anything JSON requires escaping: a
+ * control character (< 0x20), '"' or '\\'.  Uses the usual "has zero
+ * byte" / "has byte less than n" word tricks; bytes >= 0x80 (UTF-8
+ * sequences) never match, so multi-byte text is copied through whole.
+ */
+static inline gboolean
+needs_escape (guint64 w)
+{
+    guint64 quote = w ^ (ONES * '"');
+    guint64 bslash = w ^ (ONES * '\\');
+    guint64 ctrl = (w - ONES * 0x20) & ~w;
+
+    quote = (quote - ONES) & ~quote;
+    bslash = (bslash - ONES) & ~bslash;
+
+    return ((ctrl | quote | bslash) & HIGHS) != 0;
+}
+
+static void
+append_escape (GString *out,
+               guchar   c)
+{
+    static const gchar hex[] = "0123456789abcdef";
+
+    switch (c)
+    {
+        case '"':
+            g_string_append_len (out, "\\\"", 2);
+            break;
+        case '\\':
+            g_string_append_len (out, "\\\\", 2);
+            break;
+        case '\b':
+            g_string_append_len (out, "\\b", 2);
+            break;
+        case '\f':
+            g_string_append_len (out, "\\f", 2);
+            break;
+        case '\n':
+            g_string_append_len (out, "\\n", 2);
+            break;
+        case '\r':
+            g_string_append_len (out, "\\r", 2);
+            break;
+        case '\t':
+            g_string_append_len (out, "\\t", 2);
+            break;
+        default:
+            g_string_append_len (out, "\\u00", 4);
+            g_string_append_c (out, hex[c >> 4]);
+            g_string_append_c (out, hex[c & 0xf]);
+            break;
+    }
+}
+
+static void
+append_string (GString     *out,
+               const gchar *s,
+               gsize        len)
+{
+    gsize start = 0;
+    gsize i = 0;
+
+    g_string_append_c (out, '"');
+
+    while (i < len)
+    {
+        guchar c;
+
+        /* Skip clean runs a word at a time */
+        if (i + sizeof (guint64) <= len)
+        {
+            guint64 w;
+
+            memcpy (&w, s + i, sizeof (w));
+            if (!needs_escape (w))
+            {
+                i += sizeof (guint64);
+                continue;
+            }
+        }
+
+        c = (guchar) s[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            i++;
+            continue;
+        }
+
+        g_string_append_len (out, s + start, i - start);
+        append_escape (out, c);
+        start = ++i;
+    }
+
+    g_string_append_len (out, s + start, len - start);
+    g_string_append_c (out, '"');
+}
+
+/* ========================================================================== */
+/* Structure                                                                  */
+/* ========================================================================== */
+
+static inline void
+begin_value (McpJsonWriter *self)
+{
+    if (self->after_member)
+    {
+        self->after_member = FALSE;
+    }
+    else if (self->need_comma)
+    {
+        g_string_append_c (self->buffer, ',');
+    }
+}
+
+void
+mcp_json_writer_begin_object (McpJsonWriter *self)
+{
+    g_return_if_fail (self != NULL);
+
+    begin_value (self);
+    g_string_append_c (self->buffer, '{');
+    self->need_comma = FALSE;
+}
+
+void
+mcp_json_writer_end_object (McpJsonWriter *self)
+{
+    g_return_if_fail (self != NULL);
+
+    g_string_append_c (self->buffer, '}');
+    self->need_comma = TRUE;
+}
+
+void
+mcp_json_writer_begin_array (McpJsonWriter *self)
+{
+    g_return_if_fail (self != NULL);
+
+    begin_value (self);
+    g_string_append_c (self->buffer, '[');
+    self->need_comma = FALSE;
+}
+
+void
+mcp_json_writer_end_array (McpJsonWriter *self)
+{
+    g_return_if_fail (self != NULL);
+
+    g_string_append_c (self->buffer, ']');
+    self->need_comma = TRUE;
+}
+
+void
+mcp_json_writer_member (McpJsonWriter *self,
+                        const gchar   *name)
+{
+    g_return_if_fail (self != NULL);
+    g_return_if_fail (name != NULL);
+
+    if (self->need_comma)
+    {
+        g_string_append_c (self->buffer, ',');
+    }
+
+    append_string (self->buffer, name, strlen (name));
+    g_string_append_c (self->buffer, ':');
+
+    self->after_member = TRUE;
+    self->need_comma = FALSE;
+}
+
+/* ========================================================================== */
+/* Scalars                                                                    */
+/* ========================================================================== */
+
+void
+mcp_json_writer_string (McpJsonWriter *self,
+                        const gchar   *value)
+{
+    g_return_if_fail (self != NULL);
+
+    if (value == NULL)
+    {
+        mcp_json_writer_null (self);
+        return;
+    }
+
+    mcp_json_writer_string_len (self, value, strlen (value));
+}
+
+void
+mcp_json_writer_string_len (McpJsonWriter *self,
+                            const gchar   *value,
+                            gsize          len)
+{
+    g_return_if_fail (self != NULL);
+    g_return_if_fail (value != NULL || len == 0);
+
+    begin_value (self);
+    append_string (self->buffer, value, len);
+    self->need_comma = TRUE;
+}
+
+void
+mcp_json_writer_int (McpJsonWriter *self,
+                     gint64         value)
+{
+    g_return_if_fail (self != NULL);
+
+    begin_value (self);
+    g_string_append_printf (self->buffer, "%" G_GINT64_FORMAT, value);
+    self->need_comma = TRUE;
+}
+
+void
+mcp_json_writer_double (McpJsonWriter *self,
+                        gdouble        value)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_return_if_fail (self != NULL);
+
+    /* NaN and +/-inf: x - x is NaN for both, 0 for finite values */
+    if (value - value != 0.0)
+    {
+        mcp_json_writer_null (self);
+        return;
+    }
+
+    begin_value (self);
+    g_string_append (self->buffer, g_ascii_dtostr (buf, sizeof (buf), value));
+    /* Keep integral values a double, as json-glib writes them: 1.0, not 1 */
+    if (strpbrk (buf, ".eE") == NULL)
+    {
+        g_string_append_len (self->buffer, ".0", 2);
+    }
+    self->need_comma = TRUE;
+}
+
+void
+mcp_json_writer_boolean (McpJsonWriter *self,
+                         gboolean       value)
+{
+    g_return_if_fail (self != NULL);
+
+    begin_value (self);
+    if (value)
+    {
+        g_string_append_len (self->buffer, "true", 4);
+    }
+    else
+    {
+        g_string_append_len (self->buffer, "false", 5);
+    }
+    self->need_comma = TRUE;
+}
+
+void
+mcp_json_writer_null (McpJsonWriter *self)
+{
+    g_return_if_fail (self != NULL);
+
+    begin_value (self);
+    g_string_append_len (self->buffer, "null", 4);
+    self->need_comma = TRUE;
+}
+
+void
+mcp_json_writer_raw (McpJsonWriter *self,
+                     const gchar   *json,
+                     gssize         len)
+{
+    g_return_if_fail (self != NULL);
+    g_return_if_fail (json != NULL);
+
+    begin_value (self);
+    g_string_append_len (self->buffer, json, len);
+    self->need_comma = TRUE;
+}
+
+/* ========================================================================== */
+/* Existing trees                                                             */
+/* ========================================================================== */
+
+static void
+write_member_cb (JsonObject  *object,
+                 const gchar *member_name,
+                 JsonNode    *member_node,
+                 gpointer     user_data)
+{
+    McpJsonWriter *self = user_data;
+
+    mcp_json_writer_member (self, member_name);
+    mcp_json_writer_node (self, member_node);
+}
+
+static void
+write_element_cb (JsonArray *array,
+                  guint      index_,
+                  JsonNode  *element_node,
+                  gpointer   user_data)
+{
+    mcp_json_writer_node (user_data, element_node);
+}
+
+void
+mcp_json_writer_node (McpJsonWriter *self,
+                      JsonNode      *node)
+{
+    g_return_if_fail (self != NULL);
+
+    if (node == NULL)
+    {
+        mcp_json_writer_null (self);
+        return;
+    }
+
+    switch (json_node_get_node_type (node))
+    {
+        case JSON_NODE_OBJECT:
+            mcp_json_writer_begin_object (self);
+            json_object_foreach_member (json_node_get_object (node),
+                                        write_member_cb, self);
+            mcp_json_writer_end_object (self);
+            break;
+
+        case JSON_NODE_ARRAY:
+            mcp_json_writer_begin_array (self);
+            json_array_foreach_element (json_node_get_array (node),
+                                        write_element_cb, self);
+            mcp_json_writer_end_array (self);
+            break;
+
+        case JSON_NODE_VALUE:
+            switch (json_node_get_value_type (node))
+            {
+                case G_TYPE_INT64:
+                    mcp_json_writer_int (self, json_node_get_int (node));
+                    break;
+                case G_TYPE_DOUBLE:
+                    mcp_json_writer_double (self, json_node_get_double (node));
+                    break;
+                case G_TYPE_BOOLEAN:
+                    mcp_json_writer_boolean (self, json_node_get_boolean (node));
+                    break;
+                case G_TYPE_STRING:
+                    mcp_json_writer_string (self, json_node_get_string (node));
+                    break;
+                default:
+                    mcp_json_writer_null (self);
+                    break;
+            }
+            break;
+
+        case JSON_NODE_NULL:
+        default:
+            mcp_json_writer_null (self);
+            break;
+    }
+}
+
+/* ========================================================================== */
+/* Output                                                                     */
+/* ========================================================================== */
+
+const gchar *
+mcp_json_writer_get_data (McpJsonWriter *self,
+                          gsize         *length)
+{
+    g_return_val_if_fail (self != NULL, NULL);
+
+    if (length != NULL)
+    {
+        *length = self->buffer->len;
+    }
+
+    return self->buffer->str;
+}
+
+GBytes *
+mcp_json_writer_to_bytes (McpJsonWriter *self)
+{
+    g_return_val_if_fail (self != NULL, NULL);
+
+    return g_bytes_new (self->buffer->str, self->buffer->len);
+}
@@ -0,0 +1,217 @@
+/*
+ * mcp-json-writer.h - Streaming JSON writer for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * McpJsonWriter emits compact JSON text straight into a growable buffer
+ * that is kept across messages.  It is the output-side counterpart of
+ * JsonBuilder + JsonGenerator: the server and the transports use it to
+ * serialize outgoing messages without building an intermediate tree.
+ */
+
+#ifndef MCP_JSON_WRITER_H
+#define MCP_JSON_WRITER_H
+
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * McpJsonWriter:
+ *
+ * An opaque structure that writes JSON text into a reusable buffer.
+ *
+ * Values are appended in document order; separators are inserted
+ * automatically.  Inside an object, each value must be preceded by
+ * mcp_json_writer_member().  The writer does not check that the calls
+ * form a well-balanced document.
+ */
+typedef struct _McpJsonWriter McpJsonWriter;
+
+/**
+ * mcp_json_writer_new:
+ *
+ * Creates a new, empty writer.
+ *
+ * Returns: (transfer full): a new #McpJsonWriter
+ */
+McpJsonWriter *mcp_json_writer_new (void);
+
+/**
+ * mcp_json_writer_free:
+ * @self: (nullable): a #McpJsonWriter
+ *
+ * Frees the writer and its buffer.
+ */
+void mcp_json_writer_free (McpJsonWriter *self);
+
+/**
+ * mcp_json_writer_reset:
+ * @self: a #McpJsonWriter
+ *
+ * Empties the writer so it can be used for the next document.  The
+ * buffer's allocation is kept.
+ */
+void mcp_json_writer_reset (McpJsonWriter *self);
+
+/**
+ * mcp_json_writer_begin_object:
+ * @self: a #McpJsonWriter
+ *
+ * Starts a JSON object.
+ */
+void mcp_json_writer_begin_object (McpJsonWriter *self);
+
+/**
+ * mcp_json_writer_end_object:
+ * @self: a #McpJsonWriter
+ *
+ * Ends the current JSON object.
+ */
+void mcp_json_writer_end_object (McpJsonWriter *self);
+
+/**
+ * mcp_json_writer_begin_array:
+ * @self: a #McpJsonWriter
+ *
+ * Starts a JSON array.
+ */
+void mcp_json_writer_begin_array (McpJsonWriter *self);
+
+/**
+ * mcp_json_writer_end_array:
+ * @self: a #McpJsonWriter
+ *
+ * Ends the current JSON array.
+ */
+void mcp_json_writer_end_array (McpJsonWriter *self);
+
+/**
+ * mcp_json_writer_member:
+ * @self: a #McpJsonWriter
+ * @name: the member name
+ *
+ * Writes an object member name.  The next value written becomes the
+ * member's value.
+ */
+void mcp_json_writer_member (McpJsonWriter *self,
+                             const gchar   *name);
+
+/**
+ * mcp_json_writer_string:
+ * @self: a #McpJsonWriter
+ * @value: (nullable): a UTF-8 string
+ *
+ * Writes a string value, escaping it as needed.  %NULL writes `null`.
+ */
+void mcp_json_writer_string (McpJsonWriter *self,
+                             const gchar   *value);
+
+/**
+ * mcp_json_writer_string_len:
+ * @self: a #McpJsonWriter
+ * @value: UTF-8 data
+ * @len: length of @value in bytes
+ *
+ * Writes a string value of known length.
+ */
+void mcp_json_writer_string_len (McpJsonWriter *self,
+                                 const gchar   *value,
+                                 gsize          len);
+
+/**
+ * mcp_json_writer_int:
+ * @self: a #McpJsonWriter
+ * @value: the value
+ *
+ * Writes an integer value.
+ */
+void mcp_json_writer_int (McpJsonWriter *self,
+                          gint64         value);
+
+/**
+ * mcp_json_writer_double:
+ * @self: a #McpJsonWriter
+ * @value: the value
+ *
+ * Writes a floating point value.  NaN and infinities, which JSON
+ * cannot represent, are written as `null`.
+ */
+void mcp_json_writer_double (McpJsonWriter *self,
+                             gdouble        value);
+
+/**
+ * mcp_json_writer_boolean:
+ * @self: a #McpJsonWriter
+ * @value: the value
+ *
+ * Writes a boolean value.
+ */
+void mcp_json_writer_boolean (McpJsonWriter *self,
+                              gboolean       value);
+
+/**
+ * mcp_json_writer_null:
+ * @self: a #McpJsonWriter
+ *
+ * Writes a `null` value.
+ */
+void mcp_json_writer_null (McpJsonWriter *self);
+
+/**
+ * mcp_json_writer_node:
+ * @self: a #McpJsonWriter
+ * @node: (nullable): a #JsonNode
+ *
+ * Writes an existing JSON tree as a value.  This is how user-supplied
+ * trees (schemas, tool content, arguments) are embedded without being
+ * copied.  %NULL writes `null`.
+ */
+void mcp_json_writer_node (McpJsonWriter *self,
+                           JsonNode      *node);
+
+/**
+ * mcp_json_writer_raw:
+ * @self: a #McpJsonWriter
+ * @json: serialized JSON text
+ * @len: length of @json, or -1 if NUL-terminated
+ *
+ * Writes a value that is already serialized.  @json is copied as-is
+ * and must be a single valid JSON value.
+ */
+void mcp_json_writer_raw (McpJsonWriter *self,
+                          const gchar   *json,
+                          gssize         len);
+
+/**
+ * mcp_json_writer_get_data:
+ * @self: a #McpJsonWriter
+ * @length: (out) (optional): return location for the length in bytes
+ *
+ * Gets the text written so far.  The data is NUL-terminated and stays
+ * valid until the writer is next modified, reset or freed.
+ *
+ * Returns: (transfer none): the JSON text
+ */
+const gchar *mcp_json_writer_get_data (McpJsonWriter *self,
+                                       gsize         *length);
+
+/**
+ * mcp_json_writer_to_bytes:
+ * @self: a #McpJsonWriter
+ *
+ * Copies the text written so far, e.g. to hand it to
+ * mcp_transport_send_raw_async() before the writer is reused.
+ *
+ * Returns: (transfer full): a new #GBytes
+ */
+GBytes *mcp_json_writer_to_bytes (McpJsonWriter *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (McpJsonWriter, mcp_json_writer_free)
+
+G_END_DECLS
+
+#endif /* MCP_JSON_WRITER_H */
@@ -7,6 +7,7 @@
 #include "mcp-message.h"
 #include "mcp-enums.h"
 #include "mcp-error.h"
+#include "mcp-json-parse.h"
 #undef MCP_COMPILATION
 
 /* ========================================================================== */
@@ -193,18 +194,16 @@ McpMessage *
 mcp_message_parse (const gchar  *json_str,
                    GError      **error)
 {
-    g_autoptr(JsonParser) parser = NULL;
-    JsonNode *root;
+    g_autoptr(JsonNode) root = NULL;
 
     g_return_val_if_fail (json_str != NULL, NULL);
 
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, json_str, -1, error))
+    root = mcp_json_parse (json_str, -1, error);
+    if (root == NULL)
     {
         return NULL;
     }
 
-    root = json_parser_get_root (parser);
     return mcp_message_new_from_json (root, error);
 }
 
@@ -8,6 +8,12 @@
 #include "mcp-resource-provider.h"
 #include "mcp-prompt-provider.h"
 #include "mcp-error.h"
+
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
 #undef MCP_COMPILATION
 
 /* ========================================================================== */
@@ -170,6 +176,32 @@ mcp_tool_result_to_json (McpToolResult *result)
     return node;
 }
 
+void
+mcp_tool_result_write_json (McpToolResult *result,
+                            McpJsonWriter *writer)
+{
+    JsonNode *arr_node;
+
+    g_return_if_fail (result != NULL);
+    g_return_if_fail (writer != NULL);
+
+    mcp_json_writer_begin_object (writer);
+
+    mcp_json_writer_member (writer, "content");
+    arr_node = json_node_new (JSON_NODE_ARRAY);
+    json_node_set_array (arr_node, result->content);
+    mcp_json_writer_node (writer, arr_node);
+    json_node_unref (arr_node);
+
+    if (result->is_error)
+    {
+        mcp_json_writer_member (writer, "isError");
+        mcp_json_writer_boolean (writer, TRUE);
+    }
+
+    mcp_json_writer_end_object (writer);
+}
+
 /* ========================================================================== */
 /* McpResourceContents                                                        */
 /* ========================================================================== */
@@ -182,6 +214,8 @@ struct _McpResourceContents
     gchar   *text;
     gchar   *blob;
     gboolean is_text;
+    gint     fd;      /* -1 unless backed by a file descriptor */
+    GBytes  *bytes;   /* raw data, when not backed by fd or blob */
 };
 
 McpResourceContents *
@@ -200,6 +234,7 @@ mcp_resource_contents_new_text (const gchar *uri,
     contents->text = g_strdup (text);
     contents->mime_type = g_strdup (mime_type);
     contents->is_text = TRUE;
+    contents->fd = -1;
 
     return contents;
 }
@@ -220,6 +255,48 @@ mcp_resource_contents_new_blob (const gchar *uri,
     contents->blob = g_strdup (blob);
     contents->mime_type = g_strdup (mime_type);
     contents->is_text = FALSE;
+    contents->fd = -1;
+
+    return contents;
+}
+
+McpResourceContents *
+mcp_resource_contents_new_from_fd (const gchar *uri,
+                                   gint         fd,
+                                   const gchar *mime_type)
+{
+    McpResourceContents *contents;
+
+    g_return_val_if_fail (uri != NULL, NULL);
+    g_return_val_if_fail (fd >= 0, NULL);
+
+    contents = g_new0 (McpResourceContents, 1);
+    contents->ref_count = 1;
+    contents->uri = g_strdup (uri);
+    contents->mime_type = g_strdup (mime_type);
+    contents->is_text = FALSE;
+    contents->fd = fd;
+
+    return contents;
+}
+
+McpResourceContents *
+mcp_resource_contents_new_from_bytes (const gchar *uri,
+                                      GBytes      *bytes,
+                                      const gchar *mime_type)
+{
+    McpResourceContents *contents;
+
+    g_return_val_if_fail (uri != NULL, NULL);
+    g_return_val_if_fail (bytes != NULL, NULL);
+
+    contents = g_new0 (McpResourceContents, 1);
+    contents->ref_count = 1;
+    contents->uri = g_strdup (uri);
+    contents->mime_type = g_strdup (mime_type);
+    contents->is_text = FALSE;
+    contents->fd = -1;
+    contents->bytes = g_bytes_ref (bytes);
 
     return contents;
 }
@@ -244,6 +321,11 @@ mcp_resource_contents_unref (McpResourceContents *contents)
         g_free (contents->mime_type);
         g_free (contents->text);
         g_free (contents->blob);
+        g_clear_pointer (&contents->bytes, g_bytes_unref);
+        if (contents->fd >= 0)
+        {
+            g_close (contents->fd, NULL);
+        }
         g_free (contents);
     }
 }
@@ -269,11 +351,177 @@ mcp_resource_contents_get_text (McpResourceContents *contents)
     return contents->text;
 }
 
+/* Reads all of @fd, from the start when it can seek */
+static GBytes *
+read_fd (gint     fd,
+         GError **error)
+{
+    GByteArray *buffer;
+    gssize n;
+
+    /* Pipes and sockets are read from where they are */
+    if (lseek (fd, 0, SEEK_SET) < 0 && errno != ESPIPE)
+    {
+        gint saved_errno = errno;
+
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                     "Cannot rewind resource: %s", g_strerror (saved_errno));
+        return NULL;
+    }
+
+    buffer = g_byte_array_new ();
+    for (;;)
+    {
+        guint8 chunk[64 * 1024];
+
+        n = read (fd, chunk, sizeof chunk);
+        if (n > 0)
+        {
+            g_byte_array_append (buffer, chunk, (guint) n);
+        }
+        else if (n == 0)
+        {
+            break;
+        }
+        else if (errno != EINTR)
+        {
+            gint saved_errno = errno;
+
+            g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                         "Cannot read resource: %s", g_strerror (saved_errno));
+            g_byte_array_unref (buffer);
+            return NULL;
+        }
+    }
+
+    return g_byte_array_free_to_bytes (buffer);
+}
+
+static gchar *
+encode_bulk (McpResourceContents *contents)
+{
+    g_autoptr(GBytes) bytes = NULL;
+    g_autoptr(GError) error = NULL;
+    gconstpointer data;
+    gsize len;
+
+    if (contents->bytes != NULL)
+    {
+        bytes = g_bytes_ref (contents->bytes);
+    }
+    else
+    {
+        bytes = read_fd (contents->fd, &error);
+        if (bytes == NULL)
+        {
+            g_warning ("Resource %s: %s", contents->uri, error->message);
+            return g_strdup ("");
+        }
+    }
+
+    data = g_bytes_get_data (bytes, &len);
+    return g_base64_encode (data, len);
+}
+
+/*
+ * The base64 form of bulk contents is only built when needed.  The
+ * same contents may be written out from several threads at once, and
+ * a pipe can only be read once, so it is built exactly once.
+ */
+static const gchar *
+ensure_blob (McpResourceContents *contents)
+{
+    if ((contents->fd >= 0 || contents->bytes != NULL) &&
+        g_once_init_enter_pointer (&contents->blob))
+    {
+        g_once_init_leave_pointer (&contents->blob, encode_bulk (contents));
+    }
+
+    return contents->blob;
+}
+
 const gchar *
 mcp_resource_contents_get_blob (McpResourceContents *contents)
 {
     g_return_val_if_fail (contents != NULL, NULL);
-    return contents->blob;
+    return ensure_blob (contents);
+}
+
+gboolean
+mcp_resource_contents_is_bulk (McpResourceContents *contents)
+{
+    g_return_val_if_fail (contents != NULL, FALSE);
+    return contents->fd >= 0 || contents->bytes != NULL;
+}
+
+gint
+mcp_resource_contents_get_fd (McpResourceContents *contents)
+{
+    g_return_val_if_fail (contents != NULL, -1);
+    return contents->fd;
+}
+
+GMappedFile *
+mcp_resource_contents_get_mapped_file (McpResourceContents  *contents,
+                                       GError              **error)
+{
+    g_return_val_if_fail (contents != NULL, NULL);
+
+    if (contents->fd < 0)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_INVALID_PARAMS,
+                     "Resource %s is not backed by a file descriptor",
+                     contents->uri);
+        return NULL;
+    }
+
+    return g_mapped_file_new_from_fd (contents->fd, FALSE, error);
+}
+
+GBytes *
+mcp_resource_contents_get_bytes (McpResourceContents *contents)
+{
+    g_return_val_if_fail (contents != NULL, NULL);
+
+    if (contents->fd >= 0)
+    {
+        g_autoptr(GMappedFile) mapped = NULL;
+        g_autoptr(GError) error = NULL;
+        GBytes *bytes;
+
+        mapped = g_mapped_file_new_from_fd (contents->fd, FALSE, NULL);
+        if (mapped != NULL)
+        {
+            return g_mapped_file_get_bytes (mapped);
+        }
+
+        /* Pipes and sockets cannot be mapped */
+        bytes = read_fd (contents->fd, &error);
+        if (bytes == NULL)
+        {
+            g_warning ("Resource %s: %s", contents->uri, error->message);
+            bytes = g_bytes_new (NULL, 0);
+        }
+        return bytes;
+    }
+
+    if (contents->bytes != NULL)
+    {
+        return g_bytes_ref (contents->bytes);
+    }
+
+    if (contents->is_text)
+    {
+        return g_bytes_new (contents->text, strlen (contents->text));
+    }
+    else
+    {
+        guchar *data;
+        gsize len;
+
+        data = g_base64_decode (contents->blob, &len);
+        return g_bytes_new_take (data, len);
+    }
 }
 
 gboolean
@@ -311,7 +559,7 @@ mcp_resource_contents_to_json (McpResourceContents *contents)
     else
     {
         json_builder_set_member_name (builder, "blob");
-        json_builder_add_string_value (builder, contents->blob);
+        json_builder_add_string_value (builder, ensure_blob (contents));
     }
 
     json_builder_end_object (builder);
@@ -321,6 +569,38 @@ mcp_resource_contents_to_json (McpResourceContents *contents)
     return node;
 }
 
+void
+mcp_resource_contents_write_json (McpResourceContents *contents,
+                                  McpJsonWriter       *writer)
+{
+    g_return_if_fail (contents != NULL);
+    g_return_if_fail (writer != NULL);
+
+    mcp_json_writer_begin_object (writer);
+
+    mcp_json_writer_member (writer, "uri");
+    mcp_json_writer_string (writer, contents->uri);
+
+    if (contents->mime_type != NULL)
+    {
+        mcp_json_writer_member (writer, "mimeType");
+        mcp_json_writer_string (writer, contents->mime_type);
+    }
+
+    if (contents->is_text)
+    {
+        mcp_json_writer_member (writer, "text");
+        mcp_json_writer_string (writer, contents->text);
+    }
+    else
+    {
+        mcp_json_writer_member (writer, "blob");
+        mcp_json_writer_string (writer, ensure_blob (contents));
+    }
+
+    mcp_json_writer_end_object (writer);
+}
+
 /* ========================================================================== */
 /* McpPromptMessage                                                           */
 /* ========================================================================== */
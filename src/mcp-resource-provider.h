@@ -59,6 +59,42 @@ McpResourceContents *mcp_resource_contents_new_blob (const gchar *uri,
                                                      const gchar *blob,
                                                      const gchar *mime_type);
 
+/**
+ * mcp_resource_contents_new_from_fd:
+ * @uri: the resource URI
+ * @fd: a file descriptor holding the data, e.g. a memfd; ownership is
+ *   transferred to the contents
+ * @mime_type: (nullable): the MIME type
+ *
+ * Creates binary contents backed by a file descriptor.  When the
+ * client's transport can pass file descriptors and the client declared
+ * %MCP_TRANSPORT_FD_PASSING, #McpServer passes @fd itself instead of
+ * base64-encoding the data; otherwise the data is read from the start
+ * of @fd, or from its current position for a pipe or socket, and sent
+ * as a blob.  The data is read at most once.
+ *
+ * Returns: (transfer full): a new #McpResourceContents
+ */
+McpResourceContents *mcp_resource_contents_new_from_fd (const gchar *uri,
+                                                        gint         fd,
+                                                        const gchar *mime_type);
+
+/**
+ * mcp_resource_contents_new_from_bytes:
+ * @uri: the resource URI
+ * @bytes: the raw data, e.g. from g_mapped_file_get_bytes()
+ * @mime_type: (nullable): the MIME type
+ *
+ * Creates binary contents holding raw data.  The data is only
+ * base64-encoded if it has to be sent inline; a transport that serves
+ * downloads hands it to the client out of band instead.
+ *
+ * Returns: (transfer full): a new #McpResourceContents
+ */
+McpResourceContents *mcp_resource_contents_new_from_bytes (const gchar *uri,
+                                                           GBytes      *bytes,
+                                                           const gchar *mime_type);
+
 /**
  * mcp_resource_contents_ref:
  * @contents: a #McpResourceContents
@@ -111,12 +147,62 @@ const gchar *mcp_resource_contents_get_text (McpResourceContents *contents);
  * mcp_resource_contents_get_blob:
  * @contents: a #McpResourceContents
  *
- * Gets the blob content (base64-encoded).
+ * Gets the blob content (base64-encoded).  For bulk contents it is
+ * encoded on first use, once, even when called from several threads.
  *
  * Returns: (transfer none) (nullable): the blob, or %NULL if text
  */
 const gchar *mcp_resource_contents_get_blob (McpResourceContents *contents);
 
+/**
+ * mcp_resource_contents_is_bulk:
+ * @contents: a #McpResourceContents
+ *
+ * Checks whether @contents holds raw data, from
+ * mcp_resource_contents_new_from_fd() or
+ * mcp_resource_contents_new_from_bytes(), rather than text or a
+ * base64 blob.
+ *
+ * Returns: %TRUE for raw data
+ */
+gboolean mcp_resource_contents_is_bulk (McpResourceContents *contents);
+
+/**
+ * mcp_resource_contents_get_fd:
+ * @contents: a #McpResourceContents
+ *
+ * Gets the file descriptor backing @contents.  Contents read through a
+ * transport that passes file descriptors carry the peer's descriptor
+ * here.
+ *
+ * Returns: (transfer none): the file descriptor, or -1
+ */
+gint mcp_resource_contents_get_fd (McpResourceContents *contents);
+
+/**
+ * mcp_resource_contents_get_mapped_file:
+ * @contents: a #McpResourceContents
+ * @error: (nullable): return location for a #GError
+ *
+ * Maps the file descriptor backing @contents read-only.
+ *
+ * Returns: (transfer full) (nullable): a #GMappedFile, or %NULL if
+ *   @contents has no file descriptor or it cannot be mapped
+ */
+GMappedFile *mcp_resource_contents_get_mapped_file (McpResourceContents  *contents,
+                                                    GError              **error);
+
+/**
+ * mcp_resource_contents_get_bytes:
+ * @contents: a #McpResourceContents
+ *
+ * Gets the data of @contents: the UTF-8 text, the decoded blob, or the
+ * mapped file descriptor, which is not copied.
+ *
+ * Returns: (transfer full): the data
+ */
+GBytes *mcp_resource_contents_get_bytes (McpResourceContents *contents);
+
 /**
  * mcp_resource_contents_is_text:
  * @contents: a #McpResourceContents
@@ -137,6 +223,18 @@ gboolean mcp_resource_contents_is_text (McpResourceContents *contents);
  */
 JsonNode *mcp_resource_contents_to_json (McpResourceContents *contents);
 
+/**
+ * mcp_resource_contents_write_json:
+ * @contents: a #McpResourceContents
+ * @writer: a #McpJsonWriter
+ *
+ * Writes the contents to @writer as one JSON value, matching
+ * mcp_resource_contents_to_json().  Large text or blob payloads are
+ * escaped straight into the writer's buffer without an extra copy.
+ */
+void mcp_resource_contents_write_json (McpResourceContents *contents,
+                                       McpJsonWriter       *writer);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (McpResourceContents, mcp_resource_contents_unref)
 
 /**
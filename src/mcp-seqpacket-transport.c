@@ -0,0 +1,755 @@
+/*
+ * mcp-seqpacket-transport.c - SOCK_SEQPACKET transport implementation
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "mcp-seqpacket-transport.h"
+#include "mcp-error.h"
+#include "mcp-json-parse.h"
+#include "mcp-json-writer.h"
+
+#include <gio/gunixsocketaddress.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+/**
+ * SECTION:mcp-seqpacket-transport
+ * @title: McpSeqpacketTransport
+ * @short_description: Message-per-datagram Unix socket transport
+ *
+ * #McpSeqpacketTransport sends every MCP message as exactly one
+ * SOCK_SEQPACKET datagram.  The receiver peeks at the next datagram
+ * with MSG_PEEK | MSG_TRUNC to learn its size, reads it whole into a
+ * buffer of that size and parses it in place.  There is no newline
+ * framing, so nothing is scanned for delimiters and a message never
+ * arrives in pieces.
+ *
+ * A datagram has to fit in the sender's socket buffer.  Messages larger
+ * than that grow SO_SNDBUF once, up to the net.core.wmem_max limit;
+ * anything still too large fails with %G_IO_ERROR_MESSAGE_TOO_LARGE and
+ * the connection stays usable.  An empty datagram reads the same as the
+ * peer closing, and ends the connection.
+ */
+
+/* Messages delivered per wakeup before yielding to the main loop */
+#define MAX_MESSAGES_PER_DISPATCH (64)
+
+struct _McpSeqpacketTransport
+{
+    GObject parent_instance;
+
+    McpTransportState  state;
+    gchar             *socket_path;     /* client only */
+    GSocketConnection *connection;
+    GMainContext      *context;
+
+    GSource           *read_source;
+    GSource           *write_source;    /* only while the peer is full */
+
+    /* Messages waiting for the peer to drain, by priority */
+    McpWriteQueue     *write_queue;
+    /* Receive buffer, as large as the largest message seen */
+    gchar             *buffer;
+    gsize              buffer_size;
+    /* Reused to serialize outgoing messages */
+    McpJsonWriter     *writer;
+};
+
+static void mcp_seqpacket_transport_iface_init (McpTransportInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (McpSeqpacketTransport, mcp_seqpacket_transport, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (MCP_TYPE_TRANSPORT,
+                                                mcp_seqpacket_transport_iface_init))
+
+typedef struct
+{
+    GTask  *task;
+    GBytes *bytes;
+} WriteEntry;
+
+static void
+write_entry_free (WriteEntry *entry)
+{
+    g_clear_object (&entry->task);
+    g_bytes_unref (entry->bytes);
+    g_free (entry);
+}
+
+static void
+set_state (McpSeqpacketTransport *self,
+           McpTransportState      new_state)
+{
+    McpTransportState old_state;
+
+    old_state = self->state;
+    if (old_state != new_state)
+    {
+        self->state = new_state;
+        mcp_transport_emit_state_changed (MCP_TRANSPORT (self), old_state, new_state);
+    }
+}
+
+static void
+set_errno_error (GError      **error,
+                 gint          saved_errno,
+                 const gchar  *what)
+{
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "%s: %s", what, g_strerror (saved_errno));
+}
+
+static gint
+get_fd (McpSeqpacketTransport *self)
+{
+    return g_socket_get_fd (g_socket_connection_get_socket (self->connection));
+}
+
+/* ── teardown ──────────────────────────────────────────────────────── */
+
+static void
+release (McpSeqpacketTransport *self)
+{
+    if (self->read_source != NULL)
+    {
+        g_source_destroy (self->read_source);
+        g_clear_pointer (&self->read_source, g_source_unref);
+    }
+    if (self->write_source != NULL)
+    {
+        g_source_destroy (self->write_source);
+        g_clear_pointer (&self->write_source, g_source_unref);
+    }
+
+    if (self->connection != NULL)
+    {
+        g_io_stream_close (G_IO_STREAM (self->connection), NULL, NULL);
+        g_clear_object (&self->connection);
+    }
+
+    g_clear_pointer (&self->buffer, g_free);
+    self->buffer_size = 0;
+}
+
+static void
+teardown (McpSeqpacketTransport *self,
+          McpTransportState      new_state)
+{
+    WriteEntry *entry;
+
+    release (self);
+
+    while ((entry = mcp_write_queue_pop (self->write_queue)) != NULL)
+    {
+        g_task_return_new_error (entry->task,
+                                 MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport closed before the message was sent");
+        write_entry_free (entry);
+    }
+
+    set_state (self, new_state);
+}
+
+/* ── receiving ─────────────────────────────────────────────────────── */
+
+static void
+deliver (McpSeqpacketTransport *self,
+         const gchar           *data,
+         gsize                  len)
+{
+    g_autoptr(JsonNode) root = NULL;
+    g_autoptr(GError) error = NULL;
+
+    root = mcp_json_parse (data, len, &error);
+    if (root == NULL)
+    {
+        g_autoptr(GError) parse_error = NULL;
+
+        parse_error = g_error_new (MCP_ERROR,
+                                   MCP_ERROR_PARSE_ERROR,
+                                   "Failed to parse JSON: %s",
+                                   error->message);
+        mcp_transport_emit_error (MCP_TRANSPORT (self), parse_error);
+        return;
+    }
+
+    mcp_transport_emit_message_received (MCP_TRANSPORT (self), root);
+}
+
+/*
+ * Reads one datagram into the receive buffer.  Returns its length, 0 at
+ * end of stream, or -1 with errno set.
+ */
+static gssize
+receive_one (McpSeqpacketTransport *self)
+{
+    gint fd = get_fd (self);
+    gssize size;
+    gssize n;
+
+    /* With MSG_TRUNC the real length comes back even into no buffer */
+    do
+    {
+        size = recv (fd, NULL, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+    }
+    while (size < 0 && errno == EINTR);
+
+    if (size <= 0)
+    {
+        return size;
+    }
+
+    if ((gsize) size > self->buffer_size)
+    {
+        g_free (self->buffer);
+        self->buffer = g_malloc (size);
+        self->buffer_size = size;
+    }
+
+    do
+    {
+        n = recv (fd, self->buffer, size, MSG_DONTWAIT);
+    }
+    while (n < 0 && errno == EINTR);
+
+    return n;
+}
+
+static gboolean
+on_socket_readable (GSocket      *socket,
+                    GIOCondition  condition,
+                    gpointer      user_data)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (user_data);
+    gboolean keep = TRUE;
+    guint i;
+
+    g_object_ref (self);
+
+    for (i = 0; i < MAX_MESSAGES_PER_DISPATCH; i++)
+    {
+        gssize n = receive_one (self);
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+
+        if (n < 0)
+        {
+            g_autoptr(GError) error = NULL;
+
+            set_errno_error (&error, errno, "Failed to receive message");
+            mcp_transport_emit_error (MCP_TRANSPORT (self), error);
+            teardown (self, MCP_TRANSPORT_STATE_ERROR);
+            keep = FALSE;
+            break;
+        }
+
+        if (n == 0)
+        {
+            teardown (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+            keep = FALSE;
+            break;
+        }
+
+        deliver (self, self->buffer, n);
+
+        /* A handler may have disconnected us */
+        if (self->connection == NULL)
+        {
+            keep = FALSE;
+            break;
+        }
+    }
+
+    g_object_unref (self);
+
+    return keep ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+/* ── sending ───────────────────────────────────────────────────────── */
+
+/*
+ * Sends @data as one datagram.  A message too large for the socket
+ * buffer grows the buffer once and is retried.
+ */
+static gboolean
+send_datagram (McpSeqpacketTransport  *self,
+               const guint8           *data,
+               gsize                   len,
+               GError                **error)
+{
+    gint fd = get_fd (self);
+    gboolean grown = FALSE;
+
+    for (;;)
+    {
+        gint size;
+
+        if (send (fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT) >= 0)
+        {
+            return TRUE;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+
+        if (errno != EMSGSIZE || grown)
+        {
+            set_errno_error (error, errno, "Failed to send message");
+            return FALSE;
+        }
+
+        /* The kernel caps this at net.core.wmem_max */
+        size = (gint) MIN (len + 4096, (gsize) G_MAXINT / 2);
+        setsockopt (fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof size);
+        grown = TRUE;
+    }
+}
+
+/*
+ * Whether a send error leaves the connection usable
+ */
+static gboolean
+is_send_error_fatal (const GError *error)
+{
+    return !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK) &&
+           !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_MESSAGE_TOO_LARGE);
+}
+
+static gboolean on_socket_writable (GSocket      *socket,
+                                    GIOCondition  condition,
+                                    gpointer      user_data);
+
+static void
+watch_writable (McpSeqpacketTransport *self)
+{
+    if (self->write_source != NULL)
+    {
+        return;
+    }
+
+    self->write_source = g_socket_create_source (g_socket_connection_get_socket (self->connection),
+                                                 G_IO_OUT, NULL);
+    g_source_set_callback (self->write_source, (GSourceFunc) on_socket_writable, self, NULL);
+    g_source_attach (self->write_source, self->context);
+}
+
+/*
+ * Sends queued messages until the peer is full.  Returns %FALSE if the
+ * transport was torn down.
+ */
+static gboolean
+flush_write_queue (McpSeqpacketTransport *self)
+{
+    WriteEntry *entry;
+
+    while (self->connection != NULL &&
+           (entry = mcp_write_queue_peek (self->write_queue)) != NULL)
+    {
+        g_autoptr(GError) error = NULL;
+        const guint8 *data;
+        gsize len;
+
+        data = g_bytes_get_data (entry->bytes, &len);
+        if (!send_datagram (self, data, len, &error) &&
+            g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+        {
+            watch_writable (self);
+            return TRUE;
+        }
+
+        mcp_write_queue_pop (self->write_queue);
+        if (error == NULL)
+        {
+            g_task_return_boolean (entry->task, TRUE);
+            write_entry_free (entry);
+        }
+        else if (!is_send_error_fatal (error))
+        {
+            g_task_return_error (entry->task, g_steal_pointer (&error));
+            write_entry_free (entry);
+        }
+        else
+        {
+            g_task_return_new_error (entry->task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                     "%s", error->message);
+            write_entry_free (entry);
+            teardown (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+        }
+    }
+
+    return self->connection != NULL;
+}
+
+static gboolean
+on_socket_writable (GSocket      *socket,
+                    GIOCondition  condition,
+                    gpointer      user_data)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (user_data);
+
+    /* Dropped here; flushing re-arms it if the peer fills up again */
+    g_clear_pointer (&self->write_source, g_source_unref);
+
+    g_object_ref (self);
+    flush_write_queue (self);
+    g_object_unref (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Sends @data after everything already queued at @priority or above.
+ * @bytes, if given, backs @data and is referenced instead of copied.
+ * Takes ownership of @task.
+ */
+static void
+send_data (McpSeqpacketTransport *self,
+           GTask                 *task,
+           const guint8          *data,
+           gsize                  len,
+           GBytes                *bytes,
+           McpMessagePriority     priority)
+{
+    WriteEntry *entry;
+
+    entry = g_new0 (WriteEntry, 1);
+    entry->task = task;  /* Takes ownership */
+    entry->bytes = bytes != NULL ? g_bytes_ref (bytes) : g_bytes_new (data, len);
+    mcp_write_queue_push (self->write_queue, priority, entry);
+
+    if (self->write_source == NULL)
+    {
+        flush_write_queue (self);
+    }
+}
+
+/* ── connecting ────────────────────────────────────────────────────── */
+
+static void
+install (McpSeqpacketTransport *self,
+         GSocketConnection     *connection)
+{
+    GSocket *socket;
+
+    self->connection = connection;
+    socket = g_socket_connection_get_socket (connection);
+    g_socket_set_blocking (socket, FALSE);
+
+    /* The sources are destroyed in release(), before self goes away */
+    self->read_source = g_socket_create_source (socket, G_IO_IN | G_IO_HUP | G_IO_ERR, NULL);
+    g_source_set_callback (self->read_source, (GSourceFunc) on_socket_readable, self, NULL);
+    g_source_attach (self->read_source, self->context);
+
+    set_state (self, MCP_TRANSPORT_STATE_CONNECTED);
+}
+
+static void
+on_client_connected (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+    g_autoptr(GTask) task = G_TASK (user_data);
+    McpSeqpacketTransport *self = g_task_get_source_object (task);
+    g_autoptr(GSocketConnection) connection = NULL;
+    GError *error = NULL;
+
+    connection = g_socket_client_connect_finish (G_SOCKET_CLIENT (source), result, &error);
+    if (connection == NULL)
+    {
+        if (self->state == MCP_TRANSPORT_STATE_CONNECTING)
+        {
+            set_state (self, MCP_TRANSPORT_STATE_ERROR);
+        }
+        g_task_return_error (task, error);
+        return;
+    }
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTING)
+    {
+        /* Disconnected while connecting */
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport was closed during connect");
+        return;
+    }
+
+    install (self, g_steal_pointer (&connection));
+    g_task_return_boolean (task, TRUE);
+}
+
+/* ── interface vtable ──────────────────────────────────────────────── */
+
+static McpTransportState
+seqpacket_transport_get_state (McpTransport *transport)
+{
+    return MCP_SEQPACKET_TRANSPORT (transport)->state;
+}
+
+static void
+seqpacket_transport_connect_async (McpTransport        *transport,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (transport);
+    g_autoptr(GSocketClient) client = NULL;
+    g_autoptr(GSocketAddress) address = NULL;
+    GTask *task;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, seqpacket_transport_connect_async);
+
+    if (self->state == MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    if (self->state == MCP_TRANSPORT_STATE_CONNECTING ||
+        (self->socket_path == NULL && self->connection == NULL))
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED, "%s",
+                                 self->socket_path == NULL ? "Connection has been closed"
+                                                           : "Already connecting");
+        g_object_unref (task);
+        return;
+    }
+
+    g_clear_pointer (&self->context, g_main_context_unref);
+    self->context = g_main_context_ref_thread_default ();
+
+    if (self->socket_path == NULL)
+    {
+        /* Server side: the connection was accepted already */
+        install (self, g_steal_pointer (&self->connection));
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    set_state (self, MCP_TRANSPORT_STATE_CONNECTING);
+
+    client = g_socket_client_new ();
+    g_socket_client_set_family (client, G_SOCKET_FAMILY_UNIX);
+    g_socket_client_set_socket_type (client, G_SOCKET_TYPE_SEQPACKET);
+    address = g_unix_socket_address_new (self->socket_path);
+
+    g_socket_client_connect_async (client, G_SOCKET_CONNECTABLE (address),
+                                   cancellable, on_client_connected, task);
+}
+
+static gboolean
+seqpacket_transport_connect_finish (McpTransport  *transport,
+                                    GAsyncResult  *result,
+                                    GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, transport), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+seqpacket_transport_disconnect_async (McpTransport        *transport,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (transport);
+    g_autoptr(GTask) task = NULL;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, seqpacket_transport_disconnect_async);
+
+    teardown (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+seqpacket_transport_disconnect_finish (McpTransport  *transport,
+                                       GAsyncResult  *result,
+                                       GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, transport), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+seqpacket_transport_send_message_async (McpTransport        *transport,
+                                        JsonNode            *message,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (transport);
+    GTask *task;
+    const gchar *json_str;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, seqpacket_transport_send_message_async);
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_task_return_new_error (task,
+                                 MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport is not connected");
+        g_object_unref (task);
+        return;
+    }
+
+    mcp_json_writer_reset (self->writer);
+    mcp_json_writer_node (self->writer, message);
+    json_str = mcp_json_writer_get_data (self->writer, &len);
+
+    send_data (self, task, (const guint8 *) json_str, len, NULL,
+               mcp_transport_classify_message (message));
+}
+
+static void
+seqpacket_transport_send_raw_with_priority_async (McpTransport        *transport,
+                                                  GBytes              *data,
+                                                  McpMessagePriority   priority,
+                                                  GCancellable        *cancellable,
+                                                  GAsyncReadyCallback  callback,
+                                                  gpointer             user_data)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (transport);
+    GTask *task;
+    const guint8 *bytes;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, seqpacket_transport_send_raw_with_priority_async);
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_task_return_new_error (task,
+                                 MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport is not connected");
+        g_object_unref (task);
+        return;
+    }
+
+    bytes = g_bytes_get_data (data, &len);
+    send_data (self, task, bytes, len, data, priority);
+}
+
+static void
+seqpacket_transport_send_raw_async (McpTransport        *transport,
+                                    GBytes              *data,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+    seqpacket_transport_send_raw_with_priority_async (transport, data,
+                                                      mcp_transport_classify_raw (data),
+                                                      cancellable, callback, user_data);
+}
+
+static gboolean
+seqpacket_transport_send_message_finish (McpTransport  *transport,
+                                         GAsyncResult  *result,
+                                         GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, transport), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+mcp_seqpacket_transport_iface_init (McpTransportInterface *iface)
+{
+    iface->get_state = seqpacket_transport_get_state;
+    iface->connect_async = seqpacket_transport_connect_async;
+    iface->connect_finish = seqpacket_transport_connect_finish;
+    iface->disconnect_async = seqpacket_transport_disconnect_async;
+    iface->disconnect_finish = seqpacket_transport_disconnect_finish;
+    iface->send_message_async = seqpacket_transport_send_message_async;
+    iface->send_message_finish = seqpacket_transport_send_message_finish;
+    iface->send_raw_async = seqpacket_transport_send_raw_async;
+    iface->send_raw_finish = seqpacket_transport_send_message_finish;
+    iface->send_raw_with_priority_async = seqpacket_transport_send_raw_with_priority_async;
+}
+
+/* ── lifecycle ─────────────────────────────────────────────────────── */
+
+static void
+mcp_seqpacket_transport_dispose (GObject *object)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (object);
+
+    release (self);
+    mcp_write_queue_clear (self->write_queue, (GDestroyNotify) write_entry_free);
+
+    G_OBJECT_CLASS (mcp_seqpacket_transport_parent_class)->dispose (object);
+}
+
+static void
+mcp_seqpacket_transport_finalize (GObject *object)
+{
+    McpSeqpacketTransport *self = MCP_SEQPACKET_TRANSPORT (object);
+
+    mcp_write_queue_free (self->write_queue, NULL);
+    g_clear_pointer (&self->writer, mcp_json_writer_free);
+    g_clear_pointer (&self->context, g_main_context_unref);
+    g_free (self->socket_path);
+
+    G_OBJECT_CLASS (mcp_seqpacket_transport_parent_class)->finalize (object);
+}
+
+static void
+mcp_seqpacket_transport_class_init (McpSeqpacketTransportClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->dispose = mcp_seqpacket_transport_dispose;
+    object_class->finalize = mcp_seqpacket_transport_finalize;
+}
+
+static void
+mcp_seqpacket_transport_init (McpSeqpacketTransport *self)
+{
+    self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
+    self->write_queue = mcp_write_queue_new ();
+    self->writer = mcp_json_writer_new ();
+}
+
+/* ── public API ────────────────────────────────────────────────────── */
+
+McpSeqpacketTransport *
+mcp_seqpacket_transport_new_client (const gchar *socket_path)
+{
+    McpSeqpacketTransport *self;
+
+    g_return_val_if_fail (socket_path != NULL, NULL);
+
+    self = g_object_new (MCP_TYPE_SEQPACKET_TRANSPORT, NULL);
+    self->socket_path = g_strdup (socket_path);
+
+    return self;
+}
+
+McpSeqpacketTransport *
+mcp_seqpacket_transport_new_server (GSocketConnection *connection)
+{
+    McpSeqpacketTransport *self;
+
+    g_return_val_if_fail (G_IS_SOCKET_CONNECTION (connection), NULL);
+
+    self = g_object_new (MCP_TYPE_SEQPACKET_TRANSPORT, NULL);
+    self->connection = g_object_ref (connection);
+
+    return self;
+}
@@ -0,0 +1,52 @@
+/*
+ * mcp-seqpacket-transport.h - SOCK_SEQPACKET transport for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * McpSeqpacketTransport carries MCP messages over a Unix domain socket
+ * of type SOCK_SEQPACKET, one message per datagram.  The kernel keeps
+ * message boundaries, so there is no delimiter to scan for and no
+ * partial message to reassemble.  The server side is an
+ * McpUnixSocketServer whose socket type is G_SOCKET_TYPE_SEQPACKET.
+ */
+
+#ifndef MCP_SEQPACKET_TRANSPORT_H
+#define MCP_SEQPACKET_TRANSPORT_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include "mcp-transport.h"
+
+G_BEGIN_DECLS
+
+#define MCP_TYPE_SEQPACKET_TRANSPORT (mcp_seqpacket_transport_get_type ())
+
+G_DECLARE_FINAL_TYPE (McpSeqpacketTransport, mcp_seqpacket_transport, MCP, SEQPACKET_TRANSPORT, GObject)
+
+/**
+ * mcp_seqpacket_transport_new_client:
+ * @socket_path: path of a Unix socket served by an #McpUnixSocketServer
+ *   in %G_SOCKET_TYPE_SEQPACKET mode
+ *
+ * Creates a client-side transport.  mcp_transport_connect_async()
+ * connects a SOCK_SEQPACKET socket to @socket_path.
+ *
+ * Returns: (transfer full): a new #McpSeqpacketTransport
+ */
+McpSeqpacketTransport *mcp_seqpacket_transport_new_client (const gchar *socket_path);
+
+/**
+ * mcp_seqpacket_transport_new_server:
+ * @connection: an accepted SOCK_SEQPACKET connection
+ *
+ * Creates the server side of a connection accepted on a SOCK_SEQPACKET
+ * listener.
+ *
+ * Returns: (transfer full): a new #McpSeqpacketTransport
+ */
+McpSeqpacketTransport *mcp_seqpacket_transport_new_server (GSocketConnection *connection);
+
+G_END_DECLS
+
+#endif /* MCP_SEQPACKET_TRANSPORT_H */
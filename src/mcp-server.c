@@ -6,11 +6,16 @@
  */
 #include "mcp-server.h"
 #include "mcp-message.h"
+#include "mcp-arena.h"
+#include "mcp-json-writer.h"
+#include "mcp-json-parse.h"
 #include "mcp-error.h"
 #include "mcp-version.h"
 #include "mcp-task.h"
 #undef MCP_COMPILATION
 
+#include <string.h>
+
 /**
  * SECTION:mcp-server
  * @title: McpServer
@@ -20,7 +25,31 @@
  * handle tool calls, resource reads, and prompt gets from connected clients.
  */
 
-/* Handler registration structure */
+/*
+ * ServerRequest:
+ *
+ * An incoming request as the dispatch code sees it.  It is allocated
+ * from the server's per-message arena; @method and @params are
+ * borrowed from the received JsonNode and @id is either borrowed or
+ * formatted into the arena.  None of it may be kept past dispatch:
+ * copy what must survive (task IDs, strings stored in tables), and
+ * user handlers that want to keep the arguments take a reference on
+ * the JsonObject they are given.
+ */
+typedef struct
+{
+    const gchar *id;
+    const gchar *method;
+    JsonNode    *params;
+} ServerRequest;
+
+/*
+ * HandlerData:
+ *
+ * A registered handler.  It is reference counted because registry
+ * snapshots share it: @destroy runs once the last snapshot (or
+ * pending #McpServerUpdate) holding the handler lets go of it.
+ */
 typedef struct
 {
     gpointer        handler;
@@ -28,15 +57,447 @@ typedef struct
     GDestroyNotify  destroy;
 } HandlerData;
 
+static HandlerData *
+handler_data_new (gpointer       handler,
+                  gpointer       user_data,
+                  GDestroyNotify destroy)
+{
+    HandlerData *hd;
+
+    hd = g_atomic_rc_box_new0 (HandlerData);
+    hd->handler = handler;
+    hd->user_data = user_data;
+    hd->destroy = destroy;
+
+    return hd;
+}
+
 static void
-handler_data_free (gpointer data)
+handler_data_clear (gpointer data)
 {
     HandlerData *hd = data;
     if (hd->destroy != NULL && hd->user_data != NULL)
     {
         hd->destroy (hd->user_data);
     }
-    g_free (hd);
+}
+
+static gpointer
+handler_data_ref (gpointer data)
+{
+    return g_atomic_rc_box_acquire (data);
+}
+
+static void
+handler_data_unref (gpointer data)
+{
+    g_atomic_rc_box_release_full (data, handler_data_clear);
+}
+
+/*
+ * Registry:
+ *
+ * An immutable snapshot of everything a client can list or call.
+ * The server publishes its current snapshot through an atomic
+ * pointer.  Dispatch reads that pointer without locking and holds a
+ * reference for as long as it runs handlers, so a commit that swaps
+ * in a new snapshot never changes the tables under an in-flight call.
+ *
+ * Writers are serialized by McpServer.registry_lock.  A commit copies
+ * only the categories it touches; untouched tables are shared between
+ * the old and new snapshot by reference.  The server drops its own
+ * reference on a replaced snapshot on its main context, which is the
+ * only place dispatch reads the pointer, so a reader can never take a
+ * reference on a snapshot that is being freed.
+ */
+typedef enum
+{
+    REGISTRY_TOOLS     = 1 << 0,
+    REGISTRY_RESOURCES = 1 << 1,
+    REGISTRY_PROMPTS   = 1 << 2
+} RegistryCategory;
+
+typedef struct
+{
+    gatomicrefcount ref_count;
+
+    /* name -> McpTool, and name -> HandlerData for each kind of handler */
+    GHashTable *tools;
+    GHashTable *tool_handlers;
+    GHashTable *async_tool_handlers;
+
+    /* uri -> McpResource / HandlerData */
+    GHashTable *resources;
+    GHashTable *resource_handlers;
+    /* uri_template -> McpResourceTemplate / HandlerData */
+    GHashTable *resource_templates;
+    GHashTable *template_handlers;
+
+    /* name -> McpPrompt / HandlerData */
+    GHashTable *prompts;
+    GHashTable *prompt_handlers;
+
+    /* RegistryCategory flags whose tables no other snapshot shares;
+     * only read and written under registry_lock */
+    guint owned;
+} Registry;
+
+static GHashTable *
+object_table_new (void)
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+}
+
+static GHashTable *
+handler_table_new (void)
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, handler_data_unref);
+}
+
+/*
+ * Most sessions never subscribe or start a task, so those tables are
+ * only made on first insert.  Lookups go through lazy_table_lookup().
+ */
+static GHashTable *
+lazy_table (GHashTable     **table,
+            GDestroyNotify   value_destroy)
+{
+    if (*table == NULL)
+    {
+        *table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, value_destroy);
+    }
+
+    return *table;
+}
+
+static gpointer
+lazy_table_lookup (GHashTable  *table,
+                   const gchar *key)
+{
+    return table != NULL ? g_hash_table_lookup (table, key) : NULL;
+}
+
+/* Fills @dest with the entries of @src, taking a reference on each value */
+static GHashTable *
+table_copy (GHashTable    *src,
+            GHashTable    *dest,
+            GBoxedCopyFunc value_ref)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_hash_table_iter_init (&iter, src);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        g_hash_table_insert (dest, g_strdup (key), value_ref (value));
+    }
+
+    return dest;
+}
+
+static GHashTable *
+object_table_copy (GHashTable *src)
+{
+    return table_copy (src, object_table_new (), g_object_ref);
+}
+
+static GHashTable *
+handler_table_copy (GHashTable *src)
+{
+    return table_copy (src, handler_table_new (), handler_data_ref);
+}
+
+static Registry *
+registry_new (void)
+{
+    Registry *registry;
+
+    registry = g_new0 (Registry, 1);
+    g_atomic_ref_count_init (&registry->ref_count);
+
+    registry->tools = object_table_new ();
+    registry->tool_handlers = handler_table_new ();
+    registry->async_tool_handlers = handler_table_new ();
+    registry->resources = object_table_new ();
+    registry->resource_handlers = handler_table_new ();
+    registry->resource_templates = object_table_new ();
+    registry->template_handlers = handler_table_new ();
+    registry->prompts = object_table_new ();
+    registry->prompt_handlers = handler_table_new ();
+    registry->owned = REGISTRY_TOOLS | REGISTRY_RESOURCES | REGISTRY_PROMPTS;
+
+    return registry;
+}
+
+/*
+ * Returns the snapshot every server starts from.  It owns none of its
+ * tables, so the first change to a category forks just that category
+ * and a server that never registers anything costs no tables at all.
+ * The snapshot is never freed.
+ */
+static Registry *
+registry_empty (void)
+{
+    static Registry *empty = NULL;
+
+    if (g_once_init_enter_pointer (&empty))
+    {
+        Registry *registry = registry_new ();
+
+        registry->owned = 0;
+        g_once_init_leave_pointer (&empty, registry);
+    }
+
+    return empty;
+}
+
+static Registry *
+registry_ref (Registry *registry)
+{
+    g_atomic_ref_count_inc (&registry->ref_count);
+    return registry;
+}
+
+static void
+registry_unref (Registry *registry)
+{
+    if (!g_atomic_ref_count_dec (&registry->ref_count))
+    {
+        return;
+    }
+
+    g_hash_table_unref (registry->tools);
+    g_hash_table_unref (registry->tool_handlers);
+    g_hash_table_unref (registry->async_tool_handlers);
+    g_hash_table_unref (registry->resources);
+    g_hash_table_unref (registry->resource_handlers);
+    g_hash_table_unref (registry->resource_templates);
+    g_hash_table_unref (registry->template_handlers);
+    g_hash_table_unref (registry->prompts);
+    g_hash_table_unref (registry->prompt_handlers);
+    g_free (registry);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (Registry, registry_unref)
+
+/* An async tool's task keeps the snapshot its handler came from */
+#define TASK_REGISTRY_KEY "mcp-server-registry"
+
+/*
+ * Makes a new snapshot from @base in which the tables of @categories
+ * are private copies and every other table is shared with @base.
+ */
+static Registry *
+registry_fork (Registry *base,
+               guint     categories)
+{
+    Registry *registry;
+
+    registry = g_new0 (Registry, 1);
+    g_atomic_ref_count_init (&registry->ref_count);
+
+#define FORK_TABLE(category, field, copy) \
+    registry->field = (categories & (category)) ? copy (base->field) \
+                                                : g_hash_table_ref (base->field)
+
+    FORK_TABLE (REGISTRY_TOOLS, tools, object_table_copy);
+    FORK_TABLE (REGISTRY_TOOLS, tool_handlers, handler_table_copy);
+    FORK_TABLE (REGISTRY_TOOLS, async_tool_handlers, handler_table_copy);
+    FORK_TABLE (REGISTRY_RESOURCES, resources, object_table_copy);
+    FORK_TABLE (REGISTRY_RESOURCES, resource_handlers, handler_table_copy);
+    FORK_TABLE (REGISTRY_RESOURCES, resource_templates, object_table_copy);
+    FORK_TABLE (REGISTRY_RESOURCES, template_handlers, handler_table_copy);
+    FORK_TABLE (REGISTRY_PROMPTS, prompts, object_table_copy);
+    FORK_TABLE (REGISTRY_PROMPTS, prompt_handlers, handler_table_copy);
+
+#undef FORK_TABLE
+
+    registry->owned = categories;
+    /* Skips the store for the shared empty snapshot, which owns nothing */
+    if ((base->owned & ~categories) != 0)
+    {
+        base->owned &= categories;
+    }
+
+    return registry;
+}
+
+/*
+ * UpdateOp:
+ *
+ * One recorded change in an #McpServerUpdate.  Updates are kept as a
+ * log rather than as a finished snapshot so that a commit always
+ * applies them on top of whatever is current at that moment; two
+ * writers never lose each other's changes.
+ */
+typedef enum
+{
+    UPDATE_ADD_TOOL,
+    UPDATE_ADD_ASYNC_TOOL,
+    UPDATE_REMOVE_TOOL,
+    UPDATE_ADD_RESOURCE,
+    UPDATE_REMOVE_RESOURCE,
+    UPDATE_ADD_RESOURCE_TEMPLATE,
+    UPDATE_REMOVE_RESOURCE_TEMPLATE,
+    UPDATE_ADD_PROMPT,
+    UPDATE_REMOVE_PROMPT
+} UpdateOpKind;
+
+typedef struct
+{
+    UpdateOpKind  kind;
+    gchar        *key;
+    GObject      *object;   /* the tool, resource, template or prompt */
+    HandlerData  *hd;       /* nullable */
+} UpdateOp;
+
+struct _McpServerUpdate
+{
+    GArray *ops;            /* of UpdateOp */
+    guint   categories;     /* RegistryCategory flags touched by @ops */
+};
+
+static void
+update_op_clear (gpointer data)
+{
+    UpdateOp *op = data;
+
+    g_free (op->key);
+    g_clear_object (&op->object);
+    g_clear_pointer (&op->hd, handler_data_unref);
+}
+
+static guint
+update_op_category (UpdateOpKind kind)
+{
+    switch (kind)
+    {
+        case UPDATE_ADD_TOOL:
+        case UPDATE_ADD_ASYNC_TOOL:
+        case UPDATE_REMOVE_TOOL:
+            return REGISTRY_TOOLS;
+        case UPDATE_ADD_RESOURCE:
+        case UPDATE_REMOVE_RESOURCE:
+        case UPDATE_ADD_RESOURCE_TEMPLATE:
+        case UPDATE_REMOVE_RESOURCE_TEMPLATE:
+            return REGISTRY_RESOURCES;
+        case UPDATE_ADD_PROMPT:
+        case UPDATE_REMOVE_PROMPT:
+            return REGISTRY_PROMPTS;
+        default:
+            break;
+    }
+
+    g_assert_not_reached ();
+    return 0;
+}
+
+/*
+ * Fills in @op.  @object and @key are borrowed; @handler may be %NULL,
+ * in which case @destroy is not kept either.
+ */
+static void
+update_op_init (UpdateOp       *op,
+                UpdateOpKind    kind,
+                const gchar    *key,
+                gpointer        object,
+                gpointer        handler,
+                gpointer        user_data,
+                GDestroyNotify  destroy)
+{
+    op->kind = kind;
+    op->key = g_strdup (key);
+    op->object = object != NULL ? g_object_ref (object) : NULL;
+    op->hd = handler != NULL ? handler_data_new (handler, user_data, destroy) : NULL;
+}
+
+/* Inserts @hd (if any) into @handlers after dropping every old handler */
+static void
+replace_handler (GHashTable  *handlers,
+                 GHashTable  *other_handlers,
+                 const gchar *key,
+                 HandlerData *hd)
+{
+    g_hash_table_remove (handlers, key);
+    if (other_handlers != NULL)
+    {
+        g_hash_table_remove (other_handlers, key);
+    }
+    if (hd != NULL)
+    {
+        g_hash_table_insert (handlers, g_strdup (key), handler_data_ref (hd));
+    }
+}
+
+/*
+ * Applies @op to @registry, whose tables for the op's category must
+ * not be visible to any reader.  Returns %TRUE if an entry was added
+ * or removed.
+ */
+static gboolean
+registry_apply (Registry       *registry,
+                const UpdateOp *op)
+{
+    switch (op->kind)
+    {
+        case UPDATE_ADD_TOOL:
+        case UPDATE_ADD_ASYNC_TOOL:
+            g_hash_table_insert (registry->tools, g_strdup (op->key),
+                                 g_object_ref (op->object));
+            if (op->kind == UPDATE_ADD_TOOL)
+            {
+                replace_handler (registry->tool_handlers,
+                                 registry->async_tool_handlers, op->key, op->hd);
+            }
+            else
+            {
+                replace_handler (registry->async_tool_handlers,
+                                 registry->tool_handlers, op->key, op->hd);
+            }
+            return TRUE;
+
+        case UPDATE_REMOVE_TOOL:
+            g_hash_table_remove (registry->tool_handlers, op->key);
+            g_hash_table_remove (registry->async_tool_handlers, op->key);
+            return g_hash_table_remove (registry->tools, op->key);
+
+        case UPDATE_ADD_RESOURCE:
+            g_hash_table_insert (registry->resources, g_strdup (op->key),
+                                 g_object_ref (op->object));
+            replace_handler (registry->resource_handlers, NULL, op->key, op->hd);
+            return TRUE;
+
+        case UPDATE_REMOVE_RESOURCE:
+            g_hash_table_remove (registry->resource_handlers, op->key);
+            return g_hash_table_remove (registry->resources, op->key);
+
+        case UPDATE_ADD_RESOURCE_TEMPLATE:
+            g_hash_table_insert (registry->resource_templates, g_strdup (op->key),
+                                 g_object_ref (op->object));
+            replace_handler (registry->template_handlers, NULL, op->key, op->hd);
+            return TRUE;
+
+        case UPDATE_REMOVE_RESOURCE_TEMPLATE:
+            g_hash_table_remove (registry->template_handlers, op->key);
+            return g_hash_table_remove (registry->resource_templates, op->key);
+
+        case UPDATE_ADD_PROMPT:
+            g_hash_table_insert (registry->prompts, g_strdup (op->key),
+                                 g_object_ref (op->object));
+            replace_handler (registry->prompt_handlers, NULL, op->key, op->hd);
+            return TRUE;
+
+        case UPDATE_REMOVE_PROMPT:
+            g_hash_table_remove (registry->prompt_handlers, op->key);
+            return g_hash_table_remove (registry->prompts, op->key);
+
+        default:
+            break;
+    }
+
+    g_assert_not_reached ();
+    return FALSE;
 }
 
 struct _McpServer
@@ -56,29 +517,51 @@ struct _McpServer
     gulong        state_handler_id;
     gulong        error_handler_id;
 
-    /* Registered tools: name -> McpTool */
-    GHashTable *tools;
-    /* Tool handlers: name -> HandlerData */
-    GHashTable *tool_handlers;
+    /* Tools, resources, templates and prompts: the current snapshot,
+     * swapped atomically; writers hold registry_lock */
+    Registry     *registry;
+    GMutex        registry_lock;
+    /* Context dispatch runs on, and the thread that last dispatched;
+     * replaced snapshots are released there */
+    GMainContext *context;
+    GThread      *owner;
+
+    /* Calls from other threads waiting to be replayed on @context.
+     * The source is made by the first such call, under registry_lock,
+     * and never once the server is disposed. */
+    struct _OutboxItem *outbox;
+    GSource            *outbox_source;
+    gboolean            outbox_closed;
 
-    /* Registered resources: uri -> McpResource */
-    GHashTable *resources;
-    /* Resource handlers: uri -> HandlerData */
-    GHashTable *resource_handlers;
-    /* Resource templates: uri_template -> McpResourceTemplate */
-    GHashTable *resource_templates;
-    /* Template handlers: uri_template -> HandlerData */
-    GHashTable *template_handlers;
     /* Subscriptions: uri -> TRUE */
     GHashTable *subscriptions;
 
-    /* Registered prompts: name -> McpPrompt */
-    GHashTable *prompts;
-    /* Prompt handlers: name -> HandlerData */
-    GHashTable *prompt_handlers;
+    /* Requests in flight that asked for progress: token -> request ID,
+     * and those whose progress has been sent: request ID -> TRUE */
+    GHashTable *progress_tokens;
+    GHashTable *progress_sent;
 
-    /* Async tool handlers (Tasks API): name -> HandlerData */
-    GHashTable *async_tool_handlers;
+    /* Tool calls scheduled on the worker pool by their annotations */
+    gboolean            concurrent_tools;
+    McpToolKeyFunc      tool_key_func;
+    gpointer            tool_key_data;
+    GDestroyNotify      tool_key_destroy;
+    struct _ToolScope  *tool_scope;      /* this session's; guarded by tool_scope_lock */
+    GHashTable         *inflight_calls;  /* coalescing key -> ToolCall */
+
+    /* resources/read requests coalesced with other servers */
+    McpReadGroup *read_group;
+
+    /* Results of read-only and idempotent tools, or NULL when off */
+    struct _ToolCache *tool_cache;
+
+    /* Token buckets checked before tools/call and resources/read */
+    McpRateLimiter *rate_limiter;
+
+    /* list_changed notifications waiting for the window to close */
+    guint    list_changed_delay;
+    guint    list_changed_pending;   /* RegistryCategory flags */
+    GSource *list_changed_source;
 
     /* Active tasks: task_id -> McpTask */
     GHashTable *tasks;
@@ -98,6 +581,11 @@ struct _McpServer
     /* Main loop for synchronous run */
     GMainLoop *main_loop;
     GError    *run_error;
+
+    /* Per-message scratch memory, held only while dispatching */
+    McpArena *arena;
+    guint     dispatch_depth;
+    gboolean  use_arena;
 };
 
 G_DEFINE_TYPE (McpServer, mcp_server, MCP_TYPE_SESSION)
@@ -109,6 +597,9 @@ enum
     PROP_CLIENT_CAPABILITIES,
     PROP_TRANSPORT,
     PROP_INSTRUCTIONS,
+    PROP_LIST_CHANGED_DELAY,
+    PROP_CONCURRENT_TOOLS,
+    PROP_USE_ARENA,
     N_PROPERTIES
 };
 
@@ -139,8 +630,8 @@ static void on_transport_error  (McpTransport *transport,
                                  GError       *error,
                                  gpointer      user_data);
 
-static void handle_request      (McpServer  *self,
-                                 McpRequest *request);
+static void handle_request      (McpServer     *self,
+                                 ServerRequest *request);
 static void handle_notification (McpServer       *self,
                                  McpNotification *notification);
 static void handle_response     (McpServer   *self,
@@ -242,11 +733,11 @@ uri_matches_template (const gchar *uri,
  * Returns NULL if params are not present or not an object.
  */
 static JsonObject *
-get_request_params_object (McpRequest *request)
+get_request_params_object (ServerRequest *request)
 {
     JsonNode *params_node;
 
-    params_node = mcp_request_get_params (request);
+    params_node = request->params;
     if (params_node == NULL)
     {
         return NULL;
@@ -271,83 +762,521 @@ static void send_error_response (McpServer   *self,
 static void send_notification   (McpServer   *self,
                                  const gchar *method,
                                  JsonNode    *params);
+static void queue_list_changed  (McpServer   *self,
+                                 guint        categories);
+static void tool_cache_invalidate_key (McpServer   *self,
+                                       const gchar *key);
 
-static void
-mcp_server_dispose (GObject *object)
+/* Cross-thread calls */
+
+/*
+ * OutboxItem:
+ *
+ * A call to one of the thread-safe entry points made off the owning
+ * thread, replayed on the server's context.  Items form an intrusive
+ * lock-free stack: producers push with a compare-and-swap, and the
+ * owning context takes the whole stack at once and reverses it, so
+ * calls from any one thread are replayed in the order they were made.
+ */
+typedef enum
 {
-    McpServer *self = MCP_SERVER (object);
+    OUTBOX_COMPLETE_TASK,
+    OUTBOX_UPDATE_TASK,
+    OUTBOX_PROGRESS,
+    OUTBOX_RESOURCE_UPDATED,
+    OUTBOX_LOG,
+    OUTBOX_INVALIDATE_TOOL,
+    OUTBOX_INVALIDATE_RESULT
+} OutboxKind;
+
+typedef struct _OutboxItem OutboxItem;
+
+struct _OutboxItem
+{
+    OutboxItem    *next;
+    OutboxKind     kind;
+    gchar         *key;         /* task ID, progress token, URI, tool
+                                 * name or cache key */
+    gchar         *text;        /* status or error message, or logger */
+    McpToolResult *result;
+    JsonNode      *data;
+    gdouble        progress;
+    gint64         total;
+    gint           value;       /* McpTaskStatus or McpLogLevel */
+};
 
-    if (self->transport != NULL)
-    {
-        if (self->message_handler_id > 0)
-        {
-            g_signal_handler_disconnect (self->transport, self->message_handler_id);
-            self->message_handler_id = 0;
-        }
-        if (self->state_handler_id > 0)
-        {
-            g_signal_handler_disconnect (self->transport, self->state_handler_id);
-            self->state_handler_id = 0;
-        }
-        if (self->error_handler_id > 0)
-        {
-            g_signal_handler_disconnect (self->transport, self->error_handler_id);
-            self->error_handler_id = 0;
-        }
-        g_clear_object (&self->transport);
-    }
+static OutboxItem *
+outbox_item_new (OutboxKind   kind,
+                 const gchar *key,
+                 const gchar *text)
+{
+    OutboxItem *item;
 
-    g_clear_object (&self->capabilities);
-    g_clear_object (&self->client_capabilities);
-    g_clear_object (&self->start_task);
+    item = g_new0 (OutboxItem, 1);
+    item->kind = kind;
+    item->key = g_strdup (key);
+    item->text = g_strdup (text);
 
-    g_clear_pointer (&self->tools, g_hash_table_unref);
-    g_clear_pointer (&self->tool_handlers, g_hash_table_unref);
-    g_clear_pointer (&self->resources, g_hash_table_unref);
-    g_clear_pointer (&self->resource_handlers, g_hash_table_unref);
-    g_clear_pointer (&self->resource_templates, g_hash_table_unref);
-    g_clear_pointer (&self->template_handlers, g_hash_table_unref);
-    g_clear_pointer (&self->subscriptions, g_hash_table_unref);
-    g_clear_pointer (&self->prompts, g_hash_table_unref);
-    g_clear_pointer (&self->prompt_handlers, g_hash_table_unref);
+    return item;
+}
 
-    g_clear_pointer (&self->async_tool_handlers, g_hash_table_unref);
-    g_clear_pointer (&self->tasks, g_hash_table_unref);
-    g_clear_pointer (&self->task_results, g_hash_table_unref);
+static void
+outbox_item_free (OutboxItem *item)
+{
+    g_free (item->key);
+    g_free (item->text);
+    g_clear_pointer (&item->result, mcp_tool_result_unref);
+    g_clear_pointer (&item->data, json_node_unref);
+    g_free (item);
+}
 
-    if (self->main_loop != NULL)
+static gboolean outbox_dispatch_cb (gpointer user_data);
+static GSourceFuncs outbox_source_funcs;
+
+/*
+ * Gets the outbox source, attaching it to the server's context first
+ * if no call has needed it yet.  Most servers are only ever called
+ * from their own thread, so they never pay for one.
+ *
+ * Returns: (nullable): the source, or %NULL once the server is disposed
+ */
+static GSource *
+outbox_get_source (McpServer *self)
+{
+    GSource *source;
+
+    source = g_atomic_pointer_get (&self->outbox_source);
+    if (source != NULL)
     {
-        g_main_loop_quit (self->main_loop);
-        g_clear_pointer (&self->main_loop, g_main_loop_unref);
+        return source;
     }
 
-    g_clear_error (&self->run_error);
+    g_mutex_lock (&self->registry_lock);
+    source = self->outbox_source;
+    if (source == NULL && !self->outbox_closed)
+    {
+        source = g_source_new (&outbox_source_funcs, sizeof (GSource));
+        g_source_set_name (source, "McpServer outbox");
+        g_source_set_ready_time (source, -1);
+        g_source_set_callback (source, outbox_dispatch_cb, self, NULL);
+        g_source_attach (source, self->context);
+        g_atomic_pointer_set (&self->outbox_source, source);
+    }
+    g_mutex_unlock (&self->registry_lock);
 
-    G_OBJECT_CLASS (mcp_server_parent_class)->dispose (object);
+    return source;
 }
 
+/*
+ * Queues @item, taking ownership.  Only the push that finds the stack
+ * empty wakes the owning context, so a burst of calls costs one
+ * wakeup however many threads make them.
+ */
 static void
-mcp_server_finalize (GObject *object)
+outbox_push (McpServer  *self,
+             OutboxItem *item)
 {
-    McpServer *self = MCP_SERVER (object);
+    OutboxItem *head;
+    GSource *source;
 
-    g_free (self->instructions);
+    do
+    {
+        head = g_atomic_pointer_get (&self->outbox);
+        item->next = head;
+    }
+    while (!g_atomic_pointer_compare_and_exchange (&self->outbox, head, item));
 
-    G_OBJECT_CLASS (mcp_server_parent_class)->finalize (object);
+    if (head == NULL)
+    {
+        /* Once disposed, the item waits to be freed in finalize */
+        source = outbox_get_source (self);
+        if (source != NULL)
+        {
+            g_source_set_ready_time (source, 0);
+        }
+    }
 }
 
-static void
-mcp_server_get_property (GObject    *object,
-                         guint       prop_id,
-                         GValue     *value,
-                         GParamSpec *pspec)
+/* Takes every queued item, oldest first */
+static OutboxItem *
+outbox_take (McpServer *self)
 {
-    McpServer *self = MCP_SERVER (object);
+    OutboxItem *head;
+    OutboxItem *reversed = NULL;
+
+    do
+    {
+        head = g_atomic_pointer_get (&self->outbox);
+    }
+    while (!g_atomic_pointer_compare_and_exchange (&self->outbox, head, NULL));
+
+    while (head != NULL)
+    {
+        OutboxItem *next = head->next;
+
+        head->next = reversed;
+        reversed = head;
+        head = next;
+    }
+
+    return reversed;
+}
+
+static void
+outbox_item_run (McpServer  *self,
+                 OutboxItem *item)
+{
+    switch (item->kind)
+    {
+        case OUTBOX_COMPLETE_TASK:
+            mcp_server_complete_task (self, item->key,
+                                      g_steal_pointer (&item->result), item->text);
+            break;
+        case OUTBOX_UPDATE_TASK:
+            mcp_server_update_task_status (self, item->key,
+                                           (McpTaskStatus) item->value, item->text);
+            break;
+        case OUTBOX_PROGRESS:
+            mcp_server_send_progress (self, item->key, item->progress, item->total);
+            break;
+        case OUTBOX_RESOURCE_UPDATED:
+            mcp_server_notify_resource_updated (self, item->key);
+            break;
+        case OUTBOX_LOG:
+            mcp_server_emit_log (self, (McpLogLevel) item->value, item->text, item->data);
+            break;
+        case OUTBOX_INVALIDATE_TOOL:
+            mcp_server_invalidate_tool_results (self, item->key);
+            break;
+        case OUTBOX_INVALIDATE_RESULT:
+            tool_cache_invalidate_key (self, item->key);
+            break;
+        default:
+            g_assert_not_reached ();
+    }
+}
+
+static gboolean
+outbox_dispatch_cb (gpointer user_data)
+{
+    McpServer *self = MCP_SERVER (user_data);
+    OutboxItem *item;
+
+    g_object_ref (self);
+
+    /* Disarm before taking, so a push that lands after the take
+     * wakes the context again */
+    g_source_set_ready_time (self->outbox_source, -1);
+
+    item = outbox_take (self);
+    while (item != NULL)
+    {
+        OutboxItem *next = item->next;
+
+        outbox_item_run (self, item);
+        outbox_item_free (item);
+        item = next;
+    }
+
+    g_object_unref (self);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+outbox_source_dispatch (GSource     *source,
+                        GSourceFunc  callback,
+                        gpointer     user_data)
+{
+    return callback != NULL ? callback (user_data) : G_SOURCE_REMOVE;
+}
+
+static GSourceFuncs outbox_source_funcs =
+{
+    NULL,
+    NULL,
+    outbox_source_dispatch,
+    NULL,
+};
+
+/* Tool scheduling */
+
+/*
+ * ToolScope:
+ *
+ * What tool calls scheduled on the worker pool are ordered against:
+ * one session, or one resource key shared by every server in the
+ * process.  Read-only and non-destructive calls share the scope;
+ * destructive calls hold it alone.  Calls start strictly in arrival
+ * order, so a waiting destructive call holds back the readers behind
+ * it instead of being starved by them.
+ *
+ * Scopes are only touched with tool_scope_lock held: calls finishing
+ * on worker threads start the calls waiting behind them.
+ */
+typedef struct _ToolScope ToolScope;
+
+struct _ToolScope
+{
+    gchar    *key;          /* NULL for a session's scope */
+    guint     shared;       /* shared calls running */
+    gboolean  exclusive;    /* an exclusive call is running */
+    GQueue    waiting;      /* ToolCall */
+};
+
+/*
+ * ToolCall:
+ *
+ * One tool handler invocation scheduled on the worker pool, and every
+ * request waiting for its result.  The registry reference keeps the
+ * handler and its user data alive while the call runs.
+ */
+typedef struct
+{
+    GTask         *task;
+    Registry      *registry;
+    HandlerData   *hd;
+    gchar         *name;
+    gchar         *arguments;     /* canonical JSON, or NULL */
+    gchar         *coalesce_key;  /* set while later calls may join */
+    GPtrArray     *request_ids;
+    ToolScope     *scope;
+    gboolean       exclusive;
+    gboolean       cache_result;  /* store under coalesce_key when done */
+    guint          cache_generation;
+    McpToolResult *result;
+} ToolCall;
+
+static GMutex      tool_scope_lock;
+static GHashTable *tool_scopes;     /* key -> ToolScope, while in use */
+
+typedef struct _ToolCache ToolCache;
+
+static void tool_cache_clear (ToolCache *cache);
+static void tool_cache_free  (ToolCache *cache);
+
+static void rate_limiter_forget (McpRateLimiter *limiter,
+                                 McpServer      *session);
+
+static void
+tool_scope_free (ToolScope *scope)
+{
+    g_warn_if_fail (g_queue_is_empty (&scope->waiting));
+    g_free (scope->key);
+    g_free (scope);
+}
+
+/* Called with tool_scope_lock held */
+static ToolScope *
+tool_scope_lookup (McpServer   *self,
+                   const gchar *key)
+{
+    ToolScope *scope;
+
+    if (key == NULL)
+    {
+        if (self->tool_scope == NULL)
+        {
+            self->tool_scope = g_new0 (ToolScope, 1);
+        }
+        return self->tool_scope;
+    }
+
+    if (tool_scopes == NULL)
+    {
+        tool_scopes = g_hash_table_new (g_str_hash, g_str_equal);
+    }
+
+    scope = g_hash_table_lookup (tool_scopes, key);
+    if (scope == NULL)
+    {
+        scope = g_new0 (ToolScope, 1);
+        scope->key = g_strdup (key);
+        g_hash_table_insert (tool_scopes, scope->key, scope);
+    }
+
+    return scope;
+}
+
+/*
+ * Called with tool_scope_lock held.  Moves the calls at the head of
+ * the queue that may run now to @runnable.
+ */
+static void
+tool_scope_take_runnable (ToolScope *scope,
+                          GQueue    *runnable)
+{
+    ToolCall *call;
+
+    while ((call = g_queue_peek_head (&scope->waiting)) != NULL)
+    {
+        if (call->exclusive)
+        {
+            if (scope->shared > 0 || scope->exclusive)
+            {
+                break;
+            }
+            scope->exclusive = TRUE;
+        }
+        else
+        {
+            if (scope->exclusive)
+            {
+                break;
+            }
+            scope->shared++;
+        }
+
+        g_queue_push_tail (runnable, g_queue_pop_head (&scope->waiting));
+    }
+}
+
+/* Called with tool_scope_lock held, when @call has finished */
+static void
+tool_scope_release (ToolCall *call,
+                    GQueue   *runnable)
+{
+    ToolScope *scope = call->scope;
+
+    if (call->exclusive)
+    {
+        scope->exclusive = FALSE;
+    }
+    else
+    {
+        scope->shared--;
+    }
+
+    tool_scope_take_runnable (scope, runnable);
+
+    /* A resource key's scope lives only while calls use it */
+    if (scope->key != NULL && scope->shared == 0 && !scope->exclusive &&
+        g_queue_is_empty (&scope->waiting))
+    {
+        g_hash_table_remove (tool_scopes, scope->key);
+        tool_scope_free (scope);
+    }
+}
+
+static void
+mcp_server_dispose (GObject *object)
+{
+    McpServer *self = MCP_SERVER (object);
+
+    if (self->transport != NULL)
+    {
+        if (self->message_handler_id > 0)
+        {
+            g_signal_handler_disconnect (self->transport, self->message_handler_id);
+            self->message_handler_id = 0;
+        }
+        if (self->state_handler_id > 0)
+        {
+            g_signal_handler_disconnect (self->transport, self->state_handler_id);
+            self->state_handler_id = 0;
+        }
+        if (self->error_handler_id > 0)
+        {
+            g_signal_handler_disconnect (self->transport, self->error_handler_id);
+            self->error_handler_id = 0;
+        }
+        g_clear_object (&self->transport);
+    }
+
+    g_clear_object (&self->capabilities);
+    g_clear_object (&self->client_capabilities);
+    g_clear_object (&self->start_task);
+
+    g_mutex_lock (&self->registry_lock);
+    g_clear_pointer (&self->registry, registry_unref);
+    g_mutex_unlock (&self->registry_lock);
+    g_clear_pointer (&self->subscriptions, g_hash_table_unref);
+    g_clear_pointer (&self->progress_tokens, g_hash_table_unref);
+    g_clear_pointer (&self->progress_sent, g_hash_table_unref);
+    g_clear_pointer (&self->read_group, mcp_read_group_unref);
+    if (self->rate_limiter != NULL)
+    {
+        rate_limiter_forget (self->rate_limiter, self);
+        g_clear_pointer (&self->rate_limiter, mcp_rate_limiter_unref);
+    }
+
+    if (self->list_changed_source != NULL)
+    {
+        g_source_destroy (self->list_changed_source);
+        g_clear_pointer (&self->list_changed_source, g_source_unref);
+    }
+
+    /* Later pushes still set the ready time, which is then a no-op,
+     * or find the outbox closed and make no source */
+    g_mutex_lock (&self->registry_lock);
+    self->outbox_closed = TRUE;
+    if (self->outbox_source != NULL)
+    {
+        g_source_destroy (self->outbox_source);
+    }
+    g_mutex_unlock (&self->registry_lock);
+
+    g_clear_pointer (&self->tasks, g_hash_table_unref);
+    g_clear_pointer (&self->task_results, g_hash_table_unref);
+
+    if (self->main_loop != NULL)
+    {
+        g_main_loop_quit (self->main_loop);
+        g_clear_pointer (&self->main_loop, g_main_loop_unref);
+    }
+
+    g_clear_error (&self->run_error);
+
+    G_OBJECT_CLASS (mcp_server_parent_class)->dispose (object);
+}
+
+static void
+mcp_server_finalize (GObject *object)
+{
+    McpServer *self = MCP_SERVER (object);
+
+    g_free (self->instructions);
+    g_mutex_clear (&self->registry_lock);
+
+    /* Every scheduled call holds a reference, so none is left */
+    g_clear_pointer (&self->tool_scope, tool_scope_free);
+    g_clear_pointer (&self->inflight_calls, g_hash_table_unref);
+    g_clear_pointer (&self->tool_cache, tool_cache_free);
+    if (self->tool_key_destroy != NULL)
+    {
+        self->tool_key_destroy (self->tool_key_data);
+    }
+
+    /* Calls queued too late to be replayed */
+    {
+        OutboxItem *item = outbox_take (self);
+
+        while (item != NULL)
+        {
+            OutboxItem *next = item->next;
+
+            outbox_item_free (item);
+            item = next;
+        }
+    }
+    g_clear_pointer (&self->outbox_source, g_source_unref);
+
+    g_main_context_unref (self->context);
+
+    G_OBJECT_CLASS (mcp_server_parent_class)->finalize (object);
+}
+
+static void
+mcp_server_get_property (GObject    *object,
+                         guint       prop_id,
+                         GValue     *value,
+                         GParamSpec *pspec)
+{
+    McpServer *self = MCP_SERVER (object);
 
     switch (prop_id)
     {
         case PROP_CAPABILITIES:
-            g_value_set_object (value, self->capabilities);
+            g_value_set_object (value, mcp_server_get_capabilities (self));
             break;
         case PROP_CLIENT_CAPABILITIES:
             g_value_set_object (value, self->client_capabilities);
@@ -358,6 +1287,15 @@ mcp_server_get_property (GObject    *object,
         case PROP_INSTRUCTIONS:
             g_value_set_string (value, self->instructions);
             break;
+        case PROP_LIST_CHANGED_DELAY:
+            g_value_set_uint (value, self->list_changed_delay);
+            break;
+        case PROP_CONCURRENT_TOOLS:
+            g_value_set_boolean (value, self->concurrent_tools);
+            break;
+        case PROP_USE_ARENA:
+            g_value_set_boolean (value, self->use_arena);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -378,6 +1316,15 @@ mcp_server_set_property (GObject      *object,
             g_free (self->instructions);
             self->instructions = g_value_dup_string (value);
             break;
+        case PROP_LIST_CHANGED_DELAY:
+            mcp_server_set_list_changed_delay (self, g_value_get_uint (value));
+            break;
+        case PROP_CONCURRENT_TOOLS:
+            mcp_server_set_concurrent_tools (self, g_value_get_boolean (value));
+            break;
+        case PROP_USE_ARENA:
+            mcp_server_set_use_arena (self, g_value_get_boolean (value));
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -422,6 +1369,51 @@ mcp_server_class_init (McpServerClass *klass)
                              NULL,
                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+    /**
+     * McpServer:list-changed-delay:
+     *
+     * How long, in milliseconds, list_changed notifications are held
+     * so that a burst of changes reaches the client as one
+     * notification per list.  With 0, changes made during the same
+     * main loop iteration are coalesced.
+     */
+    properties[PROP_LIST_CHANGED_DELAY] =
+        g_param_spec_uint ("list-changed-delay",
+                           "List Changed Delay",
+                           "Window in milliseconds for coalescing list_changed notifications",
+                           0, G_MAXUINT, 0,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                           G_PARAM_EXPLICIT_NOTIFY);
+
+    /**
+     * McpServer:concurrent-tools:
+     *
+     * Whether synchronous tool handlers run on a worker pool, with
+     * read-only tools in parallel and destructive tools serialized.
+     * See mcp_server_set_concurrent_tools().
+     */
+    properties[PROP_CONCURRENT_TOOLS] =
+        g_param_spec_boolean ("concurrent-tools",
+                              "Concurrent Tools",
+                              "Whether tool calls are scheduled by their annotations",
+                              FALSE,
+                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                              G_PARAM_EXPLICIT_NOTIFY);
+
+    /**
+     * McpServer:use-arena:
+     *
+     * Whether well-formed requests are read into the per-message
+     * arena.  See mcp_server_set_use_arena().
+     */
+    properties[PROP_USE_ARENA] =
+        g_param_spec_boolean ("use-arena",
+                              "Use Arena",
+                              "Whether requests are dispatched from a per-message arena",
+                              TRUE,
+                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                              G_PARAM_EXPLICIT_NOTIFY);
+
     g_object_class_install_properties (object_class, N_PROPERTIES, properties);
 
     /**
@@ -514,37 +1506,14 @@ mcp_server_class_init (McpServerClass *klass)
 static void
 mcp_server_init (McpServer *self)
 {
-    self->capabilities = mcp_server_capabilities_new ();
-
-    self->tools = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                         g_free, g_object_unref);
-    self->tool_handlers = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                  g_free, handler_data_free);
-
-    self->resources = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                             g_free, g_object_unref);
-    self->resource_handlers = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                      g_free, handler_data_free);
-    self->resource_templates = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                       g_free, g_object_unref);
-    self->template_handlers = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                      g_free, handler_data_free);
-    self->subscriptions = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                  g_free, NULL);
-
-    self->prompts = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                           g_free, g_object_unref);
-    self->prompt_handlers = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                    g_free, handler_data_free);
-
-    /* Tasks API */
-    self->async_tool_handlers = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                        g_free, handler_data_free);
-    self->tasks = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                          g_free, g_object_unref);
-    self->task_results = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                 g_free,
-                                                 (GDestroyNotify) mcp_tool_result_unref);
+    self->registry = registry_ref (registry_empty ());
+    g_mutex_init (&self->registry_lock);
+    self->context = g_main_context_ref_thread_default ();
+    self->owner = g_thread_self ();
+    self->use_arena = TRUE;
+
+    /* The outbox source, subscriptions, tasks and task_results are made
+     * when first needed */
     self->task_counter = 0;
 }
 
@@ -582,6 +1551,13 @@ McpServerCapabilities *
 mcp_server_get_capabilities (McpServer *self)
 {
     g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+
+    /* Made on first use; until then every capability is off */
+    if (self->capabilities == NULL)
+    {
+        self->capabilities = mcp_server_capabilities_new ();
+    }
+
     return self->capabilities;
 }
 
@@ -610,52 +1586,192 @@ mcp_server_get_instructions (McpServer *self)
     return self->instructions;
 }
 
-/* Transport management */
-
 void
-mcp_server_set_transport (McpServer    *self,
-                          McpTransport *transport)
+mcp_server_set_list_changed_delay (McpServer *self,
+                                   guint      delay_ms)
 {
     g_return_if_fail (MCP_IS_SERVER (self));
-    g_return_if_fail (MCP_IS_TRANSPORT (transport));
 
-    if (self->transport != NULL)
+    if (self->list_changed_delay == delay_ms)
     {
-        if (self->message_handler_id > 0)
-        {
-            g_signal_handler_disconnect (self->transport, self->message_handler_id);
-            self->message_handler_id = 0;
-        }
-        if (self->state_handler_id > 0)
-        {
-            g_signal_handler_disconnect (self->transport, self->state_handler_id);
-            self->state_handler_id = 0;
-        }
-        if (self->error_handler_id > 0)
-        {
-            g_signal_handler_disconnect (self->transport, self->error_handler_id);
-            self->error_handler_id = 0;
-        }
-        g_clear_object (&self->transport);
+        return;
     }
 
-    self->transport = g_object_ref (transport);
-
-    self->message_handler_id = g_signal_connect (transport, "message-received",
-                                                  G_CALLBACK (on_message_received),
-                                                  self);
-    self->state_handler_id = g_signal_connect (transport, "state-changed",
-                                                G_CALLBACK (on_state_changed),
-                                                self);
-    self->error_handler_id = g_signal_connect (transport, "error",
-                                                G_CALLBACK (on_transport_error),
-                                                self);
-
-    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TRANSPORT]);
+    /* A window already open keeps the length it was opened with */
+    self->list_changed_delay = delay_ms;
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_LIST_CHANGED_DELAY]);
 }
 
-McpTransport *
-mcp_server_get_transport (McpServer *self)
+guint
+mcp_server_get_list_changed_delay (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), 0);
+    return self->list_changed_delay;
+}
+
+void
+mcp_server_set_concurrent_tools (McpServer *self,
+                                 gboolean   concurrent)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    concurrent = !!concurrent;
+    if (self->concurrent_tools == concurrent)
+    {
+        return;
+    }
+
+    /* Calls already scheduled finish on the worker pool */
+    self->concurrent_tools = concurrent;
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_CONCURRENT_TOOLS]);
+}
+
+gboolean
+mcp_server_get_concurrent_tools (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
+    return self->concurrent_tools;
+}
+
+void
+mcp_server_set_use_arena (McpServer *self,
+                          gboolean   use_arena)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    use_arena = !!use_arena;
+    if (self->use_arena == use_arena)
+    {
+        return;
+    }
+
+    /* A message being dispatched keeps the arena it started with */
+    self->use_arena = use_arena;
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_USE_ARENA]);
+}
+
+gboolean
+mcp_server_get_use_arena (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), TRUE);
+    return self->use_arena;
+}
+
+void
+mcp_server_set_tool_key_func (McpServer      *self,
+                              McpToolKeyFunc  func,
+                              gpointer        user_data,
+                              GDestroyNotify  destroy)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    if (self->tool_key_destroy != NULL)
+    {
+        self->tool_key_destroy (self->tool_key_data);
+    }
+
+    self->tool_key_func = func;
+    self->tool_key_data = user_data;
+    self->tool_key_destroy = destroy;
+}
+
+void
+mcp_server_set_read_group (McpServer    *self,
+                           McpReadGroup *group)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    if (group != NULL)
+    {
+        mcp_read_group_ref (group);
+    }
+    g_clear_pointer (&self->read_group, mcp_read_group_unref);
+    self->read_group = group;
+}
+
+McpReadGroup *
+mcp_server_get_read_group (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+    return self->read_group;
+}
+
+void
+mcp_server_set_rate_limiter (McpServer      *self,
+                             McpRateLimiter *limiter)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    if (limiter == self->rate_limiter)
+    {
+        return;
+    }
+
+    if (limiter != NULL)
+    {
+        mcp_rate_limiter_ref (limiter);
+    }
+    if (self->rate_limiter != NULL)
+    {
+        rate_limiter_forget (self->rate_limiter, self);
+        mcp_rate_limiter_unref (self->rate_limiter);
+    }
+    self->rate_limiter = limiter;
+}
+
+McpRateLimiter *
+mcp_server_get_rate_limiter (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+    return self->rate_limiter;
+}
+
+/* Transport management */
+
+void
+mcp_server_set_transport (McpServer    *self,
+                          McpTransport *transport)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (MCP_IS_TRANSPORT (transport));
+
+    if (self->transport != NULL)
+    {
+        if (self->message_handler_id > 0)
+        {
+            g_signal_handler_disconnect (self->transport, self->message_handler_id);
+            self->message_handler_id = 0;
+        }
+        if (self->state_handler_id > 0)
+        {
+            g_signal_handler_disconnect (self->transport, self->state_handler_id);
+            self->state_handler_id = 0;
+        }
+        if (self->error_handler_id > 0)
+        {
+            g_signal_handler_disconnect (self->transport, self->error_handler_id);
+            self->error_handler_id = 0;
+        }
+        g_clear_object (&self->transport);
+    }
+
+    self->transport = g_object_ref (transport);
+
+    self->message_handler_id = g_signal_connect (transport, "message-received",
+                                                  G_CALLBACK (on_message_received),
+                                                  self);
+    self->state_handler_id = g_signal_connect (transport, "state-changed",
+                                                G_CALLBACK (on_state_changed),
+                                                self);
+    self->error_handler_id = g_signal_connect (transport, "error",
+                                                G_CALLBACK (on_transport_error),
+                                                self);
+
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TRANSPORT]);
+}
+
+McpTransport *
+mcp_server_get_transport (McpServer *self)
 {
     g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
     return self->transport;
@@ -783,308 +1899,499 @@ mcp_server_stop (McpServer *self)
     mcp_session_set_state (MCP_SESSION (self), MCP_SESSION_STATE_DISCONNECTED);
 }
 
-/* Tool management */
+/* Registry snapshots */
 
-void
-mcp_server_add_tool (McpServer      *self,
-                     McpTool        *tool,
-                     McpToolHandler  handler,
-                     gpointer        user_data,
-                     GDestroyNotify  destroy)
+/*
+ * Whether the caller is the thread that dispatches the server's
+ * messages: either it is iterating the server's context right now, or
+ * it created the server or last dispatched for it.
+ */
+static gboolean
+on_owner_thread (McpServer *self)
 {
-    const gchar *name;
-    HandlerData *hd;
+    return g_main_context_is_owner (self->context) ||
+           g_atomic_pointer_get (&self->owner) == g_thread_self ();
+}
 
-    g_return_if_fail (MCP_IS_SERVER (self));
-    g_return_if_fail (MCP_IS_TOOL (tool));
+/*
+ * Returns the current snapshot for reading.  The pointer stays valid
+ * until control returns to the main loop; take a reference with
+ * registry_acquire() before running any handler, since a handler may
+ * itself replace the snapshot.  Only valid on the owning context.
+ */
+static Registry *
+registry_peek (McpServer *self)
+{
+    return g_atomic_pointer_get (&self->registry);
+}
 
-    name = mcp_tool_get_name (tool);
+static Registry *
+registry_acquire (McpServer *self)
+{
+    return registry_ref (registry_peek (self));
+}
 
-    g_hash_table_insert (self->tools, g_strdup (name), g_object_ref (tool));
+/*
+ * Finishes a swap on the owning context: turns on the capabilities
+ * for lists that now have entries and, if @notify, queues a
+ * list_changed notification for every list in @changed.
+ */
+static void
+registry_published (McpServer *self,
+                    guint      changed,
+                    gboolean   notify)
+{
+    Registry *registry = registry_peek (self);
+    McpServerCapabilities *capabilities;
 
-    if (handler != NULL)
+    capabilities = (changed != 0) ? mcp_server_get_capabilities (self) : NULL;
+    if ((changed & REGISTRY_TOOLS) &&
+        g_hash_table_size (registry->tools) > 0 &&
+        !mcp_server_capabilities_get_tools (capabilities))
     {
-        hd = g_new0 (HandlerData, 1);
-        hd->handler = handler;
-        hd->user_data = user_data;
-        hd->destroy = destroy;
-        g_hash_table_insert (self->tool_handlers, g_strdup (name), hd);
+        mcp_server_capabilities_set_tools (capabilities, TRUE, TRUE);
+    }
+    if ((changed & REGISTRY_RESOURCES) &&
+        (g_hash_table_size (registry->resources) > 0 ||
+         g_hash_table_size (registry->resource_templates) > 0) &&
+        !mcp_server_capabilities_get_resources (capabilities))
+    {
+        mcp_server_capabilities_set_resources (capabilities, TRUE, TRUE, TRUE);
+    }
+    if ((changed & REGISTRY_PROMPTS) &&
+        g_hash_table_size (registry->prompts) > 0 &&
+        !mcp_server_capabilities_get_prompts (capabilities))
+    {
+        mcp_server_capabilities_set_prompts (capabilities, TRUE, TRUE);
     }
 
-    /* Enable tools capability if not already */
-    if (!mcp_server_capabilities_get_tools (self->capabilities))
+    /* Cached results may come from a handler that is gone now */
+    if ((changed & REGISTRY_TOOLS) && self->tool_cache != NULL)
     {
-        mcp_server_capabilities_set_tools (self->capabilities, TRUE, TRUE);
+        tool_cache_clear (self->tool_cache);
+    }
+
+    if (notify && changed != 0)
+    {
+        queue_list_changed (self, changed);
     }
 }
 
-gboolean
-mcp_server_remove_tool (McpServer   *self,
-                        const gchar *name)
+typedef struct
 {
-    g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
-    g_return_val_if_fail (name != NULL, FALSE);
+    GWeakRef  server;
+    Registry *retired;
+    guint     changed;
+    gboolean  notify;
+} PublishData;
+
+static void
+publish_data_free (gpointer user_data)
+{
+    PublishData *data = user_data;
 
-    g_hash_table_remove (self->tool_handlers, name);
-    return g_hash_table_remove (self->tools, name);
+    g_weak_ref_clear (&data->server);
+    registry_unref (data->retired);
+    g_free (data);
 }
 
-GList *
-mcp_server_list_tools (McpServer *self)
+static gboolean
+publish_idle_cb (gpointer user_data)
 {
-    GList *list = NULL;
-    GHashTableIter iter;
-    gpointer value;
-
-    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+    PublishData *data = user_data;
+    g_autoptr(McpServer) self = g_weak_ref_get (&data->server);
 
-    g_hash_table_iter_init (&iter, self->tools);
-    while (g_hash_table_iter_next (&iter, NULL, &value))
+    if (self != NULL && self->registry != NULL)
     {
-        list = g_list_prepend (list, g_object_ref (value));
+        registry_published (self, data->changed, data->notify);
     }
 
-    return g_list_reverse (list);
+    return G_SOURCE_REMOVE;
 }
 
 /*
- * Synchronous in-process tool invocation.  Mirrors the handler
- * lookup in handle_tools_call() but skips the transport round-trip.
- * Sync handlers only — async (Tasks API) handlers aren't reachable
- * here because they expect an McpTask scaffolded by handle_tools_call.
+ * Makes @registry current.  Must be called with registry_lock held;
+ * the lock is released before the client is told about the change.
+ * The server's reference on the old snapshot is dropped on the owning
+ * context, so callers on other threads defer that to an idle source.
  */
-McpToolResult *
-mcp_server_invoke_tool (McpServer    *self,
-                        const gchar  *name,
-                        JsonObject   *arguments,
-                        GError      **error)
+static void
+registry_swap_and_unlock (McpServer *self,
+                          Registry  *registry,
+                          guint      changed,
+                          gboolean   notify)
 {
-    HandlerData    *hd;
-    McpToolHandler  handler;
+    Registry *retired;
+    PublishData *data;
+    g_autoptr(GSource) source = NULL;
 
-    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
-    g_return_val_if_fail (name != NULL, NULL);
+    retired = self->registry;
+    g_atomic_pointer_set (&self->registry, registry);
+    g_mutex_unlock (&self->registry_lock);
 
-    if (!g_hash_table_contains (self->tools, name))
+    if (on_owner_thread (self))
     {
-        g_set_error (error, MCP_ERROR, MCP_ERROR_TOOL_NOT_FOUND,
-                     "mcp_server_invoke_tool: unknown tool '%s'", name);
-        return NULL;
+        registry_unref (retired);
+        registry_published (self, changed, notify);
+        return;
     }
 
-    hd = g_hash_table_lookup (self->tool_handlers, name);
-    if (hd == NULL || hd->handler == NULL)
-    {
-        g_set_error (error, MCP_ERROR, MCP_ERROR_METHOD_NOT_FOUND,
-                     "mcp_server_invoke_tool: tool '%s' has no sync "
-                     "handler (async tools are not supported here)",
-                     name);
-        return NULL;
-    }
+    data = g_new0 (PublishData, 1);
+    g_weak_ref_init (&data->server, self);
+    data->retired = retired;
+    data->changed = changed;
+    data->notify = notify;
 
-    handler = (McpToolHandler) hd->handler;
-    return handler (self, name, arguments, hd->user_data);
+    source = g_idle_source_new ();
+    g_source_set_priority (source, G_PRIORITY_DEFAULT);
+    g_source_set_callback (source, publish_idle_cb, data, publish_data_free);
+    g_source_set_name (source, "McpServer registry publish");
+    g_source_attach (source, self->context);
 }
 
-/* Resource management */
-
-void
-mcp_server_add_resource (McpServer          *self,
-                         McpResource        *resource,
-                         McpResourceHandler  handler,
-                         gpointer            user_data,
-                         GDestroyNotify      destroy)
+/*
+ * Applies one change on behalf of mcp_server_add_tool() and friends.
+ * While nothing else holds the current snapshot, which is the normal
+ * case when a server is being set up, the change is made in place
+ * rather than by copying the tables.  Single changes do not notify
+ * the client; callers send those with mcp_server_notify_tools_changed()
+ * and friends.
+ */
+static gboolean
+registry_update_one (McpServer      *self,
+                     const UpdateOp *op)
 {
-    const gchar *uri;
-    HandlerData *hd;
-
-    g_return_if_fail (MCP_IS_SERVER (self));
-    g_return_if_fail (MCP_IS_RESOURCE (resource));
-
-    uri = mcp_resource_get_uri (resource);
+    Registry *current;
+    Registry *registry;
+    guint category;
+    gboolean changed;
 
-    g_hash_table_insert (self->resources, g_strdup (uri), g_object_ref (resource));
+    category = update_op_category (op->kind);
 
-    if (handler != NULL)
+    g_mutex_lock (&self->registry_lock);
+    current = self->registry;
+    if (current == NULL)
     {
-        hd = g_new0 (HandlerData, 1);
-        hd->handler = handler;
-        hd->user_data = user_data;
-        hd->destroy = destroy;
-        g_hash_table_insert (self->resource_handlers, g_strdup (uri), hd);
+        /* Disposed */
+        g_mutex_unlock (&self->registry_lock);
+        return FALSE;
     }
 
-    /* Enable resources capability if not already */
-    if (!mcp_server_capabilities_get_resources (self->capabilities))
+    if ((current->owned & category) &&
+        g_atomic_ref_count_compare (&current->ref_count, 1) &&
+        on_owner_thread (self))
     {
-        mcp_server_capabilities_set_resources (self->capabilities, TRUE, TRUE, TRUE);
+        changed = registry_apply (current, op);
+        g_mutex_unlock (&self->registry_lock);
+        registry_published (self, changed ? category : 0, FALSE);
+        return changed;
     }
+
+    registry = registry_fork (current, category);
+    changed = registry_apply (registry, op);
+    registry_swap_and_unlock (self, registry, changed ? category : 0, FALSE);
+
+    return changed;
 }
 
-void
-mcp_server_add_resource_template (McpServer            *self,
-                                  McpResourceTemplate  *templ,
-                                  McpResourceHandler    handler,
-                                  gpointer              user_data,
-                                  GDestroyNotify        destroy)
+McpServerUpdate *
+mcp_server_update_new (void)
 {
-    const gchar *uri_template;
-    HandlerData *hd;
-
-    g_return_if_fail (MCP_IS_SERVER (self));
-    g_return_if_fail (MCP_IS_RESOURCE_TEMPLATE (templ));
+    McpServerUpdate *update;
 
-    uri_template = mcp_resource_template_get_uri_template (templ);
+    update = g_new0 (McpServerUpdate, 1);
+    update->ops = g_array_new (FALSE, TRUE, sizeof (UpdateOp));
+    g_array_set_clear_func (update->ops, update_op_clear);
 
-    g_hash_table_insert (self->resource_templates, g_strdup (uri_template),
-                         g_object_ref (templ));
+    return update;
+}
 
-    if (handler != NULL)
+void
+mcp_server_update_free (McpServerUpdate *update)
+{
+    if (update == NULL)
     {
-        hd = g_new0 (HandlerData, 1);
-        hd->handler = handler;
-        hd->user_data = user_data;
-        hd->destroy = destroy;
-        g_hash_table_insert (self->template_handlers, g_strdup (uri_template), hd);
+        return;
     }
 
-    /* Enable resources capability if not already */
-    if (!mcp_server_capabilities_get_resources (self->capabilities))
-    {
-        mcp_server_capabilities_set_resources (self->capabilities, TRUE, TRUE, TRUE);
-    }
+    g_array_unref (update->ops);
+    g_free (update);
 }
 
-gboolean
-mcp_server_remove_resource (McpServer   *self,
-                            const gchar *uri)
+static void
+update_append (McpServerUpdate *update,
+               UpdateOpKind     kind,
+               const gchar     *key,
+               gpointer         object,
+               gpointer         handler,
+               gpointer         user_data,
+               GDestroyNotify   destroy)
 {
-    g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
-    g_return_val_if_fail (uri != NULL, FALSE);
+    UpdateOp op = { 0, };
 
-    g_hash_table_remove (self->resource_handlers, uri);
-    g_hash_table_remove (self->subscriptions, uri);
-    return g_hash_table_remove (self->resources, uri);
+    update_op_init (&op, kind, key, object, handler, user_data, destroy);
+    g_array_append_val (update->ops, op);
+    update->categories |= update_op_category (kind);
 }
 
-GList *
-mcp_server_list_resources (McpServer *self)
+void
+mcp_server_update_add_tool (McpServerUpdate *update,
+                            McpTool         *tool,
+                            McpToolHandler   handler,
+                            gpointer         user_data,
+                            GDestroyNotify   destroy)
 {
-    GList *list = NULL;
-    GHashTableIter iter;
-    gpointer value;
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (MCP_IS_TOOL (tool));
 
-    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+    update_append (update, UPDATE_ADD_TOOL, mcp_tool_get_name (tool), tool,
+                   handler, user_data, destroy);
+}
 
-    g_hash_table_iter_init (&iter, self->resources);
-    while (g_hash_table_iter_next (&iter, NULL, &value))
-    {
-        list = g_list_prepend (list, g_object_ref (value));
-    }
+void
+mcp_server_update_add_async_tool (McpServerUpdate     *update,
+                                  McpTool             *tool,
+                                  McpAsyncToolHandler  handler,
+                                  gpointer             user_data,
+                                  GDestroyNotify       destroy)
+{
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (MCP_IS_TOOL (tool));
 
-    return g_list_reverse (list);
+    update_append (update, UPDATE_ADD_ASYNC_TOOL, mcp_tool_get_name (tool), tool,
+                   handler, user_data, destroy);
 }
 
-GList *
-mcp_server_list_resource_templates (McpServer *self)
+void
+mcp_server_update_remove_tool (McpServerUpdate *update,
+                               const gchar     *name)
 {
-    GList *list = NULL;
-    GHashTableIter iter;
-    gpointer value;
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (name != NULL);
 
-    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+    update_append (update, UPDATE_REMOVE_TOOL, name, NULL, NULL, NULL, NULL);
+}
 
-    g_hash_table_iter_init (&iter, self->resource_templates);
-    while (g_hash_table_iter_next (&iter, NULL, &value))
-    {
-        list = g_list_prepend (list, g_object_ref (value));
-    }
+void
+mcp_server_update_add_resource (McpServerUpdate    *update,
+                                McpResource        *resource,
+                                McpResourceHandler  handler,
+                                gpointer            user_data,
+                                GDestroyNotify      destroy)
+{
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (MCP_IS_RESOURCE (resource));
 
-    return g_list_reverse (list);
+    update_append (update, UPDATE_ADD_RESOURCE, mcp_resource_get_uri (resource),
+                   resource, handler, user_data, destroy);
 }
 
 void
-mcp_server_notify_resource_updated (McpServer   *self,
-                                    const gchar *uri)
+mcp_server_update_remove_resource (McpServerUpdate *update,
+                                   const gchar     *uri)
 {
-    g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonNode) params = NULL;
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (uri != NULL);
+
+    update_append (update, UPDATE_REMOVE_RESOURCE, uri, NULL, NULL, NULL, NULL);
+}
+
+void
+mcp_server_update_add_resource_template (McpServerUpdate     *update,
+                                         McpResourceTemplate *templ,
+                                         McpResourceHandler   handler,
+                                         gpointer             user_data,
+                                         GDestroyNotify       destroy)
+{
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (MCP_IS_RESOURCE_TEMPLATE (templ));
+
+    update_append (update, UPDATE_ADD_RESOURCE_TEMPLATE,
+                   mcp_resource_template_get_uri_template (templ),
+                   templ, handler, user_data, destroy);
+}
+
+void
+mcp_server_update_remove_resource_template (McpServerUpdate *update,
+                                            const gchar     *uri_template)
+{
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (uri_template != NULL);
+
+    update_append (update, UPDATE_REMOVE_RESOURCE_TEMPLATE, uri_template,
+                   NULL, NULL, NULL, NULL);
+}
+
+void
+mcp_server_update_add_prompt (McpServerUpdate  *update,
+                              McpPrompt        *prompt,
+                              McpPromptHandler  handler,
+                              gpointer          user_data,
+                              GDestroyNotify    destroy)
+{
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (MCP_IS_PROMPT (prompt));
+
+    update_append (update, UPDATE_ADD_PROMPT, mcp_prompt_get_name (prompt),
+                   prompt, handler, user_data, destroy);
+}
+
+void
+mcp_server_update_remove_prompt (McpServerUpdate *update,
+                                 const gchar     *name)
+{
+    g_return_if_fail (update != NULL);
+    g_return_if_fail (name != NULL);
+
+    update_append (update, UPDATE_REMOVE_PROMPT, name, NULL, NULL, NULL, NULL);
+}
+
+void
+mcp_server_commit_update (McpServer       *self,
+                          McpServerUpdate *update)
+{
+    Registry *registry;
+    guint changed = 0;
+    guint i;
 
     g_return_if_fail (MCP_IS_SERVER (self));
-    g_return_if_fail (uri != NULL);
+    g_return_if_fail (update != NULL);
 
-    /* Only send if subscribed */
-    if (!g_hash_table_contains (self->subscriptions, uri))
+    if (update->ops->len == 0)
     {
         return;
     }
 
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "uri");
-    json_builder_add_string_value (builder, uri);
-    json_builder_end_object (builder);
-    params = json_builder_get_root (builder);
+    g_mutex_lock (&self->registry_lock);
+    if (self->registry == NULL)
+    {
+        /* Disposed */
+        g_mutex_unlock (&self->registry_lock);
+        return;
+    }
 
-    send_notification (self, "notifications/resources/updated", params);
+    /* Built privately, then published with one pointer store */
+    registry = registry_fork (self->registry, update->categories);
+    for (i = 0; i < update->ops->len; i++)
+    {
+        const UpdateOp *op = &g_array_index (update->ops, UpdateOp, i);
+
+        if (registry_apply (registry, op))
+        {
+            changed |= update_op_category (op->kind);
+        }
+    }
+
+    registry_swap_and_unlock (self, registry, changed, TRUE);
 }
 
-/* Prompt management */
+/* Tool management */
 
 void
-mcp_server_add_prompt (McpServer        *self,
-                       McpPrompt        *prompt,
-                       McpPromptHandler  handler,
-                       gpointer          user_data,
-                       GDestroyNotify    destroy)
+mcp_server_add_tool (McpServer      *self,
+                     McpTool        *tool,
+                     McpToolHandler  handler,
+                     gpointer        user_data,
+                     GDestroyNotify  destroy)
 {
-    const gchar *name;
-    HandlerData *hd;
+    UpdateOp op = { 0, };
 
     g_return_if_fail (MCP_IS_SERVER (self));
-    g_return_if_fail (MCP_IS_PROMPT (prompt));
+    g_return_if_fail (MCP_IS_TOOL (tool));
 
-    name = mcp_prompt_get_name (prompt);
+    update_op_init (&op, UPDATE_ADD_TOOL, mcp_tool_get_name (tool), tool,
+                    handler, user_data, destroy);
+    registry_update_one (self, &op);
+    update_op_clear (&op);
+}
 
-    g_hash_table_insert (self->prompts, g_strdup (name), g_object_ref (prompt));
+/*
+ * Records adding every object in @objects under the name @get_key
+ * returns, all sharing one handler, and commits the lot.
+ */
+static void
+commit_bulk_add (McpServer      *self,
+                 UpdateOpKind    kind,
+                 GPtrArray      *objects,
+                 const gchar  *(*get_key) (gpointer object),
+                 gpointer        handler,
+                 gpointer        user_data,
+                 GDestroyNotify  destroy)
+{
+    g_autoptr(McpServerUpdate) update = NULL;
+    HandlerData *hd = NULL;
+    guint i;
 
     if (handler != NULL)
     {
-        hd = g_new0 (HandlerData, 1);
-        hd->handler = handler;
-        hd->user_data = user_data;
-        hd->destroy = destroy;
-        g_hash_table_insert (self->prompt_handlers, g_strdup (name), hd);
+        hd = handler_data_new (handler, user_data, destroy);
+    }
+
+    update = mcp_server_update_new ();
+    for (i = 0; i < objects->len; i++)
+    {
+        UpdateOp op = { 0, };
+
+        op.kind = kind;
+        op.key = g_strdup (get_key (g_ptr_array_index (objects, i)));
+        op.object = g_object_ref (g_ptr_array_index (objects, i));
+        op.hd = hd != NULL ? handler_data_ref (hd) : NULL;
+        g_array_append_val (update->ops, op);
     }
+    update->categories |= update_op_category (kind);
+
+    g_clear_pointer (&hd, handler_data_unref);
+    mcp_server_commit_update (self, update);
+}
+
+void
+mcp_server_add_tools (McpServer      *self,
+                      GPtrArray      *tools,
+                      McpToolHandler  handler,
+                      gpointer        user_data,
+                      GDestroyNotify  destroy)
+{
+    guint i;
+
+    g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (tools != NULL);
 
-    /* Enable prompts capability if not already */
-    if (!mcp_server_capabilities_get_prompts (self->capabilities))
+    for (i = 0; i < tools->len; i++)
     {
-        mcp_server_capabilities_set_prompts (self->capabilities, TRUE, TRUE);
+        g_return_if_fail (MCP_IS_TOOL (g_ptr_array_index (tools, i)));
     }
+
+    commit_bulk_add (self, UPDATE_ADD_TOOL, tools,
+                     (const gchar *(*) (gpointer)) mcp_tool_get_name,
+                     handler, user_data, destroy);
 }
 
 gboolean
-mcp_server_remove_prompt (McpServer   *self,
-                          const gchar *name)
+mcp_server_remove_tool (McpServer   *self,
+                        const gchar *name)
 {
+    UpdateOp op = { 0, };
+    gboolean removed;
+
     g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
     g_return_val_if_fail (name != NULL, FALSE);
 
-    g_hash_table_remove (self->prompt_handlers, name);
-    return g_hash_table_remove (self->prompts, name);
+    update_op_init (&op, UPDATE_REMOVE_TOOL, name, NULL, NULL, NULL, NULL);
+    removed = registry_update_one (self, &op);
+    update_op_clear (&op);
+
+    return removed;
 }
 
-GList *
-mcp_server_list_prompts (McpServer *self)
+/* Lists the objects in @table, in the table's order */
+static GList *
+list_table_values (GHashTable *table)
 {
     GList *list = NULL;
     GHashTableIter iter;
     gpointer value;
 
-    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
-
-    g_hash_table_iter_init (&iter, self->prompts);
+    g_hash_table_iter_init (&iter, table);
     while (g_hash_table_iter_next (&iter, NULL, &value))
     {
         list = g_list_prepend (list, g_object_ref (value));
@@ -1093,83 +2400,389 @@ mcp_server_list_prompts (McpServer *self)
     return g_list_reverse (list);
 }
 
-/* Notifications */
+GList *
+mcp_server_list_tools (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+
+    return list_table_values (registry_peek (self)->tools);
+}
+
+/*
+ * Synchronous in-process tool invocation.  Mirrors the handler
+ * lookup in handle_tools_call() but skips the transport round-trip.
+ * Sync handlers only — async (Tasks API) handlers aren't reachable
+ * here because they expect an McpTask scaffolded by handle_tools_call.
+ */
+McpToolResult *
+mcp_server_invoke_tool (McpServer    *self,
+                        const gchar  *name,
+                        JsonObject   *arguments,
+                        GError      **error)
+{
+    g_autoptr(Registry) registry = NULL;
+    HandlerData    *hd;
+    McpToolHandler  handler;
+
+    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+    g_return_val_if_fail (name != NULL, NULL);
+
+    registry = registry_acquire (self);
+
+    if (!g_hash_table_contains (registry->tools, name))
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_TOOL_NOT_FOUND,
+                     "mcp_server_invoke_tool: unknown tool '%s'", name);
+        return NULL;
+    }
+
+    hd = g_hash_table_lookup (registry->tool_handlers, name);
+    if (hd == NULL || hd->handler == NULL)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_METHOD_NOT_FOUND,
+                     "mcp_server_invoke_tool: tool '%s' has no sync "
+                     "handler (async tools are not supported here)",
+                     name);
+        return NULL;
+    }
+
+    handler = (McpToolHandler) hd->handler;
+    return handler (self, name, arguments, hd->user_data);
+}
+
+/* Resource management */
 
 void
-mcp_server_notify_tools_changed (McpServer *self)
+mcp_server_add_resource (McpServer          *self,
+                         McpResource        *resource,
+                         McpResourceHandler  handler,
+                         gpointer            user_data,
+                         GDestroyNotify      destroy)
 {
+    UpdateOp op = { 0, };
+
     g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (MCP_IS_RESOURCE (resource));
 
-    send_notification (self, "notifications/tools/list_changed", NULL);
+    update_op_init (&op, UPDATE_ADD_RESOURCE, mcp_resource_get_uri (resource),
+                    resource, handler, user_data, destroy);
+    registry_update_one (self, &op);
+    update_op_clear (&op);
 }
 
 void
-mcp_server_notify_resources_changed (McpServer *self)
+mcp_server_add_resources (McpServer          *self,
+                          GPtrArray          *resources,
+                          McpResourceHandler  handler,
+                          gpointer            user_data,
+                          GDestroyNotify      destroy)
 {
+    guint i;
+
     g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (resources != NULL);
+
+    for (i = 0; i < resources->len; i++)
+    {
+        g_return_if_fail (MCP_IS_RESOURCE (g_ptr_array_index (resources, i)));
+    }
 
-    send_notification (self, "notifications/resources/list_changed", NULL);
+    commit_bulk_add (self, UPDATE_ADD_RESOURCE, resources,
+                     (const gchar *(*) (gpointer)) mcp_resource_get_uri,
+                     handler, user_data, destroy);
 }
 
 void
-mcp_server_notify_prompts_changed (McpServer *self)
+mcp_server_add_resource_template (McpServer            *self,
+                                  McpResourceTemplate  *templ,
+                                  McpResourceHandler    handler,
+                                  gpointer              user_data,
+                                  GDestroyNotify        destroy)
 {
+    UpdateOp op = { 0, };
+
     g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (MCP_IS_RESOURCE_TEMPLATE (templ));
+
+    update_op_init (&op, UPDATE_ADD_RESOURCE_TEMPLATE,
+                    mcp_resource_template_get_uri_template (templ),
+                    templ, handler, user_data, destroy);
+    registry_update_one (self, &op);
+    update_op_clear (&op);
+}
+
+gboolean
+mcp_server_remove_resource (McpServer   *self,
+                            const gchar *uri)
+{
+    UpdateOp op = { 0, };
+    gboolean removed;
 
-    send_notification (self, "notifications/prompts/list_changed", NULL);
+    g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
+    g_return_val_if_fail (uri != NULL, FALSE);
+
+    update_op_init (&op, UPDATE_REMOVE_RESOURCE, uri, NULL, NULL, NULL, NULL);
+    removed = registry_update_one (self, &op);
+    update_op_clear (&op);
+
+    if (self->subscriptions != NULL)
+    {
+        g_hash_table_remove (self->subscriptions, uri);
+    }
+    return removed;
+}
+
+GList *
+mcp_server_list_resources (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+
+    return list_table_values (registry_peek (self)->resources);
+}
+
+GList *
+mcp_server_list_resource_templates (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+
+    return list_table_values (registry_peek (self)->resource_templates);
 }
 
 void
-mcp_server_emit_log (McpServer   *self,
-                     McpLogLevel  level,
-                     const gchar *logger,
-                     JsonNode    *data)
+mcp_server_notify_resource_updated (McpServer   *self,
+                                    const gchar *uri)
 {
     g_autoptr(JsonBuilder) builder = NULL;
     g_autoptr(JsonNode) params = NULL;
-    const gchar *level_str;
 
     g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (uri != NULL);
 
-    if (!mcp_server_capabilities_get_logging (self->capabilities))
+    if (!on_owner_thread (self))
     {
+        outbox_push (self, outbox_item_new (OUTBOX_RESOURCE_UPDATED, uri, NULL));
         return;
     }
 
-    level_str = mcp_log_level_to_string (level);
+    /* Only send if subscribed */
+    if (lazy_table_lookup (self->subscriptions, uri) == NULL)
+    {
+        return;
+    }
 
     builder = json_builder_new ();
     json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "level");
-    json_builder_add_string_value (builder, level_str);
-    if (logger != NULL)
-    {
-        json_builder_set_member_name (builder, "logger");
-        json_builder_add_string_value (builder, logger);
-    }
-    json_builder_set_member_name (builder, "data");
-    json_builder_add_value (builder, json_node_copy (data));
+    json_builder_set_member_name (builder, "uri");
+    json_builder_add_string_value (builder, uri);
     json_builder_end_object (builder);
     params = json_builder_get_root (builder);
 
-    send_notification (self, "notifications/message", params);
+    send_notification (self, "notifications/resources/updated", params);
 }
 
+/* Prompt management */
+
 void
-mcp_server_send_progress (McpServer   *self,
-                          const gchar *token,
-                          gdouble      progress,
-                          gint64       total)
+mcp_server_add_prompt (McpServer        *self,
+                       McpPrompt        *prompt,
+                       McpPromptHandler  handler,
+                       gpointer          user_data,
+                       GDestroyNotify    destroy)
 {
-    g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonNode) params = NULL;
+    UpdateOp op = { 0, };
 
     g_return_if_fail (MCP_IS_SERVER (self));
-    g_return_if_fail (token != NULL);
+    g_return_if_fail (MCP_IS_PROMPT (prompt));
 
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "progressToken");
+    update_op_init (&op, UPDATE_ADD_PROMPT, mcp_prompt_get_name (prompt),
+                    prompt, handler, user_data, destroy);
+    registry_update_one (self, &op);
+    update_op_clear (&op);
+}
+
+gboolean
+mcp_server_remove_prompt (McpServer   *self,
+                          const gchar *name)
+{
+    UpdateOp op = { 0, };
+    gboolean removed;
+
+    g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
+    g_return_val_if_fail (name != NULL, FALSE);
+
+    update_op_init (&op, UPDATE_REMOVE_PROMPT, name, NULL, NULL, NULL, NULL);
+    removed = registry_update_one (self, &op);
+    update_op_clear (&op);
+
+    return removed;
+}
+
+GList *
+mcp_server_list_prompts (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
+
+    return list_table_values (registry_peek (self)->prompts);
+}
+
+/* Notifications */
+
+static gboolean
+flush_list_changed_cb (gpointer user_data)
+{
+    McpServer *self = MCP_SERVER (user_data);
+    guint pending;
+
+    pending = self->list_changed_pending;
+    self->list_changed_pending = 0;
+    g_clear_pointer (&self->list_changed_source, g_source_unref);
+
+    if (pending & REGISTRY_TOOLS)
+    {
+        send_notification (self, "notifications/tools/list_changed", NULL);
+    }
+    if (pending & REGISTRY_RESOURCES)
+    {
+        send_notification (self, "notifications/resources/list_changed", NULL);
+    }
+    if (pending & REGISTRY_PROMPTS)
+    {
+        send_notification (self, "notifications/prompts/list_changed", NULL);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Marks a list as changed.  The first change opens a window of
+ * list-changed-delay milliseconds; everything marked before it closes
+ * goes out as one notification per list.  The window is not extended
+ * by later changes, so a steady stream of them still gets through.
+ */
+static void
+queue_list_changed (McpServer *self,
+                    guint      categories)
+{
+    GSource *source;
+
+    self->list_changed_pending |= categories;
+    if (self->list_changed_source != NULL)
+    {
+        return;
+    }
+
+    if (self->list_changed_delay > 0)
+    {
+        source = g_timeout_source_new (self->list_changed_delay);
+    }
+    else
+    {
+        source = g_idle_source_new ();
+        g_source_set_priority (source, G_PRIORITY_DEFAULT);
+    }
+    g_source_set_callback (source, flush_list_changed_cb, self, NULL);
+    g_source_set_name (source, "McpServer list_changed");
+    g_source_attach (source, self->context);
+    self->list_changed_source = source;
+}
+
+void
+mcp_server_notify_tools_changed (McpServer *self)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    queue_list_changed (self, REGISTRY_TOOLS);
+}
+
+void
+mcp_server_notify_resources_changed (McpServer *self)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    queue_list_changed (self, REGISTRY_RESOURCES);
+}
+
+void
+mcp_server_notify_prompts_changed (McpServer *self)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    queue_list_changed (self, REGISTRY_PROMPTS);
+}
+
+void
+mcp_server_emit_log (McpServer   *self,
+                     McpLogLevel  level,
+                     const gchar *logger,
+                     JsonNode    *data)
+{
+    g_autoptr(JsonBuilder) builder = NULL;
+    g_autoptr(JsonNode) params = NULL;
+    const gchar *level_str;
+
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    if (!on_owner_thread (self))
+    {
+        OutboxItem *item = outbox_item_new (OUTBOX_LOG, NULL, logger);
+
+        item->value = level;
+        item->data = data != NULL ? json_node_copy (data) : NULL;
+        outbox_push (self, item);
+        return;
+    }
+
+    if (self->capabilities == NULL ||
+        !mcp_server_capabilities_get_logging (self->capabilities))
+    {
+        return;
+    }
+
+    level_str = mcp_log_level_to_string (level);
+
+    builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "level");
+    json_builder_add_string_value (builder, level_str);
+    if (logger != NULL)
+    {
+        json_builder_set_member_name (builder, "logger");
+        json_builder_add_string_value (builder, logger);
+    }
+    json_builder_set_member_name (builder, "data");
+    json_builder_add_value (builder, json_node_copy (data));
+    json_builder_end_object (builder);
+    params = json_builder_get_root (builder);
+
+    send_notification (self, "notifications/message", params);
+}
+
+void
+mcp_server_send_progress (McpServer   *self,
+                          const gchar *token,
+                          gdouble      progress,
+                          gint64       total)
+{
+    g_autoptr(JsonBuilder) builder = NULL;
+    g_autoptr(JsonNode) params = NULL;
+    const gchar *request_id;
+
+    g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (token != NULL);
+
+    if (!on_owner_thread (self))
+    {
+        OutboxItem *item = outbox_item_new (OUTBOX_PROGRESS, token, NULL);
+
+        item->progress = progress;
+        item->total = total;
+        outbox_push (self, item);
+        return;
+    }
+
+    builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "progressToken");
     json_builder_add_string_value (builder, token);
     json_builder_set_member_name (builder, "progress");
     json_builder_add_double_value (builder, progress);
@@ -1182,18 +2795,154 @@ mcp_server_send_progress (McpServer   *self,
     params = json_builder_get_root (builder);
 
     send_notification (self, "notifications/progress", params);
+
+    /* The request's response now has to follow this notification */
+    request_id = lazy_table_lookup (self->progress_tokens, token);
+    if (request_id != NULL)
+    {
+        g_hash_table_insert (lazy_table (&self->progress_sent, NULL),
+                             g_strdup (request_id), GINT_TO_POINTER (TRUE));
+    }
+}
+
+/* Scratch memory */
+
+/*
+ * Servers on one thread share a writer and a spare arena rather than
+ * keeping their own, so an idle session holds neither.  Nothing that
+ * runs between resetting the writer and copying its data out can
+ * write with it again, so one writer per thread is enough.
+ */
+static GPrivate scratch_writer_key = G_PRIVATE_INIT ((GDestroyNotify) mcp_json_writer_free);
+static GPrivate scratch_arena_key = G_PRIVATE_INIT ((GDestroyNotify) mcp_arena_free);
+
+static McpJsonWriter *
+scratch_writer (void)
+{
+    McpJsonWriter *writer = g_private_get (&scratch_writer_key);
+
+    if (writer == NULL)
+    {
+        writer = mcp_json_writer_new ();
+        g_private_set (&scratch_writer_key, writer);
+    }
+
+    return writer;
+}
+
+/*
+ * Takes the thread's spare arena, or a new one while another server
+ * further up the stack is still dispatching from it.
+ */
+static McpArena *
+scratch_arena_acquire (void)
+{
+    McpArena *arena = g_private_get (&scratch_arena_key);
+
+    if (arena == NULL)
+    {
+        return mcp_arena_new (0);
+    }
+
+    g_private_set (&scratch_arena_key, NULL);
+    return arena;
+}
+
+static void
+scratch_arena_release (McpArena *arena)
+{
+    if (g_private_get (&scratch_arena_key) != NULL)
+    {
+        mcp_arena_free (arena);
+        return;
+    }
+
+    mcp_arena_reset (arena);
+    g_private_set (&scratch_arena_key, arena);
 }
 
 /* Transport callbacks */
 
+/*
+ * read_request:
+ *
+ * Fast path for the common case of a well-formed request: reads the
+ * envelope straight from @message into an arena-allocated
+ * #ServerRequest, without building an #McpRequest or copying params.
+ * Returns %NULL for anything else, which then goes through
+ * mcp_message_new_from_json() and its validation and error reporting.
+ */
+static ServerRequest *
+read_request (McpServer *self,
+              JsonNode  *message)
+{
+    JsonObject *obj;
+    JsonNode *node;
+    ServerRequest *request;
+
+    if (!JSON_NODE_HOLDS_OBJECT (message))
+    {
+        return NULL;
+    }
+    obj = json_node_get_object (message);
+
+    node = json_object_get_member (obj, "jsonrpc");
+    if (node == NULL || json_node_get_value_type (node) != G_TYPE_STRING ||
+        g_strcmp0 (json_node_get_string (node), MCP_JSONRPC_VERSION) != 0)
+    {
+        return NULL;
+    }
+
+    node = json_object_get_member (obj, "method");
+    if (node == NULL || json_node_get_value_type (node) != G_TYPE_STRING ||
+        !json_object_has_member (obj, "id"))
+    {
+        return NULL;
+    }
+
+    request = mcp_arena_new0 (self->arena, ServerRequest);
+    request->method = json_node_get_string (node);
+    request->params = json_object_get_member (obj, "params");
+
+    /* Same conversion as McpMessage: responses always carry a string id */
+    node = json_object_get_member (obj, "id");
+    if (JSON_NODE_HOLDS_VALUE (node))
+    {
+        switch (json_node_get_value_type (node))
+        {
+            case G_TYPE_STRING:
+                request->id = json_node_get_string (node);
+                break;
+            case G_TYPE_INT64:
+                request->id = mcp_arena_strdup_printf (self->arena, "%" G_GINT64_FORMAT,
+                                                       json_node_get_int (node));
+                break;
+            case G_TYPE_DOUBLE:
+                request->id = mcp_arena_strdup_printf (self->arena, "%g",
+                                                       json_node_get_double (node));
+                break;
+            default:
+                break;
+        }
+    }
+
+    return request;
+}
+
 static void
-on_message_received (McpTransport *transport,
-                     JsonNode     *message,
-                     gpointer      user_data)
+dispatch_message (McpServer *self,
+                  JsonNode  *message)
 {
-    McpServer *self = MCP_SERVER (user_data);
     g_autoptr(McpMessage) msg = NULL;
     g_autoptr(GError) error = NULL;
+    ServerRequest *request;
+
+    request = self->arena != NULL ? read_request (self, message) : NULL;
+    if (request != NULL)
+    {
+        handle_request (self, request);
+        return;
+    }
 
     msg = mcp_message_new_from_json (message, &error);
     if (msg == NULL)
@@ -1207,7 +2956,14 @@ on_message_received (McpTransport *transport,
     switch (mcp_message_get_message_type (msg))
     {
         case MCP_MESSAGE_TYPE_REQUEST:
-            handle_request (self, MCP_REQUEST (msg));
+            {
+                ServerRequest slow = { 0, };
+
+                slow.id = mcp_request_get_id (MCP_REQUEST (msg));
+                slow.method = mcp_request_get_method (MCP_REQUEST (msg));
+                slow.params = mcp_request_get_params (MCP_REQUEST (msg));
+                handle_request (self, &slow);
+            }
             break;
         case MCP_MESSAGE_TYPE_NOTIFICATION:
             handle_notification (self, MCP_NOTIFICATION (msg));
@@ -1225,6 +2981,31 @@ on_message_received (McpTransport *transport,
     }
 }
 
+static void
+on_message_received (McpTransport *transport,
+                     JsonNode     *message,
+                     gpointer      user_data)
+{
+    McpServer *self = MCP_SERVER (user_data);
+
+    /* A handler may spin a nested main loop and dispatch again, so the
+     * arena is only given back once the outermost message is done */
+    g_object_ref (self);
+    if (self->dispatch_depth++ == 0 && self->use_arena)
+    {
+        self->arena = scratch_arena_acquire ();
+    }
+    g_atomic_pointer_set (&self->owner, g_thread_self ());
+
+    dispatch_message (self, message);
+
+    if (--self->dispatch_depth == 0 && self->arena != NULL)
+    {
+        scratch_arena_release (g_steal_pointer (&self->arena));
+    }
+    g_object_unref (self);
+}
+
 static void
 on_state_changed (McpTransport      *transport,
                   McpTransportState  old_state,
@@ -1297,60 +3078,168 @@ send_message_cb (GObject      *source,
 }
 
 static void
-send_response (McpServer   *self,
-               const gchar *id,
-               JsonNode    *result)
+send_raw_cb (GObject      *source,
+             GAsyncResult *result,
+             gpointer      user_data)
 {
-    g_autoptr(McpResponse) response = NULL;
-    g_autoptr(JsonNode) node = NULL;
-    g_autoptr(JsonNode) result_owned = result;  /* Take ownership of result */
+    GError *error = NULL;
 
-    if (self->transport == NULL)
+    if (!mcp_transport_send_raw_finish (MCP_TRANSPORT (source), result, &error))
     {
-        return;
+        g_warning ("Failed to send message: %s", error->message);
+        g_error_free (error);
     }
-
-    /* mcp_response_new takes ownership of the node */
-    response = mcp_response_new (id, g_steal_pointer (&result_owned));
-    node = mcp_message_to_json (MCP_MESSAGE (response));
-
-    mcp_transport_send_message_async (self->transport, node, NULL,
-                                      send_message_cb, NULL);
 }
 
-static void
-send_error_response (McpServer   *self,
-                     const gchar *id,
-                     gint         code,
-                     const gchar *message,
-                     JsonNode    *data)
+/*
+ * begin_response:
+ *
+ * Starts a response envelope in the scratch writer and returns it
+ * positioned at the "result" value.  The caller writes exactly one
+ * value and then calls finish_response().  Returns %NULL if there is
+ * no transport to send on.
+ */
+static McpJsonWriter *
+begin_response (McpServer   *self,
+                const gchar *id)
 {
-    g_autoptr(McpErrorResponse) error_resp = NULL;
-    g_autoptr(JsonNode) node = NULL;
+    McpJsonWriter *writer = scratch_writer ();
 
     if (self->transport == NULL)
     {
-        return;
+        return NULL;
     }
 
-    error_resp = mcp_error_response_new (id, code, message);
-    if (data != NULL)
-    {
-        mcp_error_response_set_data (error_resp, data);
-    }
-    node = mcp_message_to_json (MCP_MESSAGE (error_resp));
+    mcp_json_writer_reset (writer);
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "jsonrpc");
+    mcp_json_writer_string (writer, MCP_JSONRPC_VERSION);
+    mcp_json_writer_member (writer, "id");
+    mcp_json_writer_string (writer, id);
+    mcp_json_writer_member (writer, "result");
 
-    mcp_transport_send_message_async (self->transport, node, NULL,
-                                      send_message_cb, NULL);
+    return writer;
 }
 
-static void
-send_notification (McpServer   *self,
-                   const gchar *method,
-                   JsonNode    *params)
+static gboolean
+progress_token_is_for (gpointer key,
+                       gpointer value,
+                       gpointer user_data)
 {
-    g_autoptr(McpNotification) notif = NULL;
-    g_autoptr(JsonNode) node = NULL;
+    return g_str_equal (value, user_data);
+}
+
+/*
+ * response_priority:
+ *
+ * Responses overtake queued notifications, except the progress
+ * notifications of their own request, which the client must see
+ * first.  A request that has had progress sent is answered in the
+ * progress lane, behind them.  The request's progress token is
+ * forgotten either way.
+ */
+static McpMessagePriority
+response_priority (McpServer   *self,
+                   const gchar *id)
+{
+    McpMessagePriority priority = MCP_MESSAGE_PRIORITY_HIGH;
+
+    if (id == NULL || self->progress_tokens == NULL)
+    {
+        return priority;
+    }
+
+    if (self->progress_sent != NULL && g_hash_table_remove (self->progress_sent, id))
+    {
+        priority = MCP_MESSAGE_PRIORITY_LOW;
+    }
+    g_hash_table_foreach_remove (self->progress_tokens, progress_token_is_for, (gpointer) id);
+
+    return priority;
+}
+
+static void
+finish_response (McpServer     *self,
+                 McpJsonWriter *writer,
+                 const gchar   *id)
+{
+    g_autoptr(GBytes) bytes = NULL;
+
+    mcp_json_writer_end_object (writer);
+    bytes = mcp_json_writer_to_bytes (writer);
+
+    mcp_transport_send_raw_with_priority_async (self->transport, bytes,
+                                                response_priority (self, id), NULL,
+                                                send_raw_cb, NULL);
+}
+
+static void
+send_response (McpServer   *self,
+               const gchar *id,
+               JsonNode    *result)
+{
+    g_autoptr(JsonNode) result_owned = result;  /* Take ownership of result */
+    McpJsonWriter *writer;
+
+    writer = begin_response (self, id);
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    mcp_json_writer_node (writer, result_owned);
+    finish_response (self, writer, id);
+}
+
+static void
+send_error_response (McpServer   *self,
+                     const gchar *id,
+                     gint         code,
+                     const gchar *message,
+                     JsonNode    *data)
+{
+    McpJsonWriter *writer = scratch_writer ();
+    g_autoptr(GBytes) bytes = NULL;
+
+    if (self->transport == NULL)
+    {
+        return;
+    }
+
+    /* Same shape as mcp_message_to_json() on an McpErrorResponse */
+    mcp_json_writer_reset (writer);
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "jsonrpc");
+    mcp_json_writer_string (writer, MCP_JSONRPC_VERSION);
+    mcp_json_writer_member (writer, "id");
+    mcp_json_writer_string (writer, id);
+    mcp_json_writer_member (writer, "error");
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "code");
+    mcp_json_writer_int (writer, code);
+    mcp_json_writer_member (writer, "message");
+    mcp_json_writer_string (writer, message);
+    if (data != NULL)
+    {
+        mcp_json_writer_member (writer, "data");
+        mcp_json_writer_node (writer, data);
+    }
+    mcp_json_writer_end_object (writer);
+    mcp_json_writer_end_object (writer);
+
+    bytes = mcp_json_writer_to_bytes (writer);
+    mcp_transport_send_raw_with_priority_async (self->transport, bytes,
+                                                response_priority (self, id), NULL,
+                                                send_raw_cb, NULL);
+}
+
+static void
+send_notification (McpServer   *self,
+                   const gchar *method,
+                   JsonNode    *params)
+{
+    g_autoptr(McpNotification) notif = NULL;
+    g_autoptr(JsonNode) node = NULL;
 
     if (self->transport == NULL ||
         mcp_session_get_state (MCP_SESSION (self)) != MCP_SESSION_STATE_READY)
@@ -1373,8 +3262,8 @@ send_notification (McpServer   *self,
 /* Request handlers */
 
 static void
-handle_initialize (McpServer  *self,
-                   McpRequest *request)
+handle_initialize (McpServer     *self,
+                   ServerRequest *request)
 {
     JsonObject *params;
     JsonNode *cap_node;
@@ -1386,7 +3275,7 @@ handle_initialize (McpServer  *self,
     params = get_request_params_object (request);
     if (params == NULL)
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing params", NULL);
         return;
@@ -1439,7 +3328,7 @@ handle_initialize (McpServer  *self,
 
     json_builder_set_member_name (builder, "capabilities");
     {
-        g_autoptr(JsonNode) caps = mcp_server_capabilities_to_json (self->capabilities);
+        g_autoptr(JsonNode) caps = mcp_server_capabilities_to_json (mcp_server_get_capabilities (self));
         json_builder_add_value (builder, g_steal_pointer (&caps));
     }
 
@@ -1458,259 +3347,1928 @@ handle_initialize (McpServer  *self,
     json_builder_end_object (builder);
     result = json_builder_get_root (builder);
 
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    send_response (self, request->id, g_steal_pointer (&result));
 }
 
 static void
-handle_tools_list (McpServer  *self,
-                   McpRequest *request)
+handle_tools_list (McpServer     *self,
+                   ServerRequest *request)
 {
-    g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonNode) result = NULL;
+    McpJsonWriter *writer;
     GHashTableIter iter;
     gpointer value;
 
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "tools");
-    json_builder_begin_array (builder);
+    writer = begin_response (self, request->id);
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "tools");
+    mcp_json_writer_begin_array (writer);
 
-    g_hash_table_iter_init (&iter, self->tools);
+    g_hash_table_iter_init (&iter, registry_peek (self)->tools);
     while (g_hash_table_iter_next (&iter, NULL, &value))
     {
-        McpTool *tool = MCP_TOOL (value);
-        g_autoptr(JsonNode) tool_node = mcp_tool_to_json (tool);
-        json_builder_add_value (builder, g_steal_pointer (&tool_node));
+        mcp_tool_write_json (MCP_TOOL (value), writer);
     }
 
-    json_builder_end_array (builder);
-    json_builder_end_object (builder);
-    result = json_builder_get_root (builder);
+    mcp_json_writer_end_array (writer);
+    mcp_json_writer_end_object (writer);
+
+    finish_response (self, writer, request->id);
+}
+
+/* Rate limiting */
+
+/* A limit of @rate tokens per second, holding at most @burst */
+typedef struct
+{
+    gdouble rate;       /* 0 when unset */
+    gdouble burst;
+} RateRule;
+
+/*
+ * RateBucket:
+ *
+ * The tokens left for one key: a session (@name is NULL), a tool or
+ * resource across sessions (@session is NULL), or both.  Tools and
+ * resources are kept apart by @resource, so a URI never shares a
+ * bucket with a tool of the same name.  Tokens are only brought up to
+ * date when the bucket is used.  A bucket that has refilled completely
+ * is the same as none, so full buckets are swept away when the table
+ * has doubled since the last sweep.
+ */
+typedef struct
+{
+    gpointer  session;
+    gchar    *name;
+    gboolean  resource;
+    gdouble   tokens;
+    gint64    updated;  /* monotonic time of @tokens */
+    gint64    full_at;  /* when the bucket will be full again */
+} RateBucket;
+
+struct _McpRateLimiter
+{
+    gatomicrefcount  ref_count;
+    GMutex           lock;
+    RateRule         session;
+    RateRule         tool;              /* for names without a rule of their own */
+    RateRule         session_tool;
+    GHashTable      *tool_rules;        /* name -> RateRule */
+    GHashTable      *session_tool_rules;
+    RateRule         resource;          /* for URIs without a rule of their own */
+    RateRule         session_resource;
+    GHashTable      *resource_rules;    /* URI -> RateRule */
+    GHashTable      *session_resource_rules;
+    GHashTable      *buckets;           /* set of RateBucket */
+    guint            sweep_at;
+    guint64          rejected;
+};
+
+#define RATE_LIMITER_MIN_SWEEP 64
+
+static guint
+rate_bucket_hash (gconstpointer key)
+{
+    const RateBucket *bucket = key;
 
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    return g_direct_hash (bucket->session) ^
+           (bucket->name != NULL ? g_str_hash (bucket->name) : 0) ^
+           (guint) bucket->resource;
+}
+
+static gboolean
+rate_bucket_equal (gconstpointer a,
+                   gconstpointer b)
+{
+    const RateBucket *bucket_a = a;
+    const RateBucket *bucket_b = b;
+
+    return bucket_a->session == bucket_b->session &&
+           bucket_a->resource == bucket_b->resource &&
+           g_strcmp0 (bucket_a->name, bucket_b->name) == 0;
 }
 
 static void
-handle_tools_call (McpServer  *self,
-                   McpRequest *request)
+rate_bucket_free (RateBucket *bucket)
 {
-    JsonObject *params;
-    const gchar *name;
-    JsonObject *arguments = NULL;
-    HandlerData *hd;
-    HandlerData *async_hd;
-    g_autoptr(McpToolResult) tool_result = NULL;
-    g_autoptr(JsonNode) result = NULL;
+    g_free (bucket->name);
+    g_free (bucket);
+}
 
-    params = get_request_params_object (request);
-    if (params == NULL || !json_object_has_member (params, "name"))
+McpRateLimiter *
+mcp_rate_limiter_new (void)
+{
+    McpRateLimiter *limiter;
+
+    limiter = g_new0 (McpRateLimiter, 1);
+    g_atomic_ref_count_init (&limiter->ref_count);
+    g_mutex_init (&limiter->lock);
+    limiter->tool_rules = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    limiter->session_tool_rules = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                         g_free, g_free);
+    limiter->resource_rules = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    limiter->session_resource_rules = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                             g_free, g_free);
+    limiter->buckets = g_hash_table_new_full (rate_bucket_hash, rate_bucket_equal,
+                                              (GDestroyNotify) rate_bucket_free, NULL);
+    limiter->sweep_at = RATE_LIMITER_MIN_SWEEP;
+
+    return limiter;
+}
+
+McpRateLimiter *
+mcp_rate_limiter_ref (McpRateLimiter *limiter)
+{
+    g_return_val_if_fail (limiter != NULL, NULL);
+
+    g_atomic_ref_count_inc (&limiter->ref_count);
+    return limiter;
+}
+
+void
+mcp_rate_limiter_unref (McpRateLimiter *limiter)
+{
+    g_return_if_fail (limiter != NULL);
+
+    if (g_atomic_ref_count_dec (&limiter->ref_count))
     {
-        send_error_response (self, mcp_request_get_id (request),
-                             MCP_ERROR_INVALID_PARAMS,
-                             "Missing tool name", NULL);
-        return;
+        g_hash_table_unref (limiter->tool_rules);
+        g_hash_table_unref (limiter->session_tool_rules);
+        g_hash_table_unref (limiter->resource_rules);
+        g_hash_table_unref (limiter->session_resource_rules);
+        g_hash_table_unref (limiter->buckets);
+        g_mutex_clear (&limiter->lock);
+        g_free (limiter);
     }
+}
 
-    name = json_object_get_string_member (params, "name");
+static void
+rate_rule_set (RateRule *rule,
+               gdouble   rate,
+               guint     burst)
+{
+    rule->rate = MAX (rate, 0.0);
+    rule->burst = MAX (burst, 1);
+}
+
+static void
+rate_rules_set (GHashTable  *rules,
+                RateRule    *fallback,
+                const gchar *name,
+                gdouble      rate,
+                guint        burst)
+{
+    RateRule *rule;
 
-    if (!g_hash_table_contains (self->tools, name))
+    if (name == NULL)
     {
-        send_error_response (self, mcp_request_get_id (request),
-                             MCP_ERROR_METHOD_NOT_FOUND,
-                             "Unknown tool", NULL);
+        rate_rule_set (fallback, rate, burst);
         return;
     }
 
-    if (json_object_has_member (params, "arguments"))
+    if (rate <= 0.0)
     {
-        arguments = json_object_get_object_member (params, "arguments");
+        g_hash_table_remove (rules, name);
+        return;
     }
 
-    g_signal_emit (self, signals[SIGNAL_TOOL_CALLED], 0, name, arguments);
+    rule = g_new0 (RateRule, 1);
+    rate_rule_set (rule, rate, burst);
+    g_hash_table_replace (rules, g_strdup (name), rule);
+}
 
-    /* First check for async tool handler (Tasks API) */
-    async_hd = g_hash_table_lookup (self->async_tool_handlers, name);
-    if (async_hd != NULL && async_hd->handler != NULL)
+void
+mcp_rate_limiter_set_session_limit (McpRateLimiter *limiter,
+                                    gdouble         rate,
+                                    guint           burst)
+{
+    g_return_if_fail (limiter != NULL);
+
+    g_mutex_lock (&limiter->lock);
+    rate_rule_set (&limiter->session, rate, burst);
+    g_mutex_unlock (&limiter->lock);
+}
+
+void
+mcp_rate_limiter_set_tool_limit (McpRateLimiter *limiter,
+                                 const gchar    *name,
+                                 gdouble         rate,
+                                 guint           burst)
+{
+    g_return_if_fail (limiter != NULL);
+
+    g_mutex_lock (&limiter->lock);
+    rate_rules_set (limiter->tool_rules, &limiter->tool, name, rate, burst);
+    g_mutex_unlock (&limiter->lock);
+}
+
+void
+mcp_rate_limiter_set_session_tool_limit (McpRateLimiter *limiter,
+                                         const gchar    *name,
+                                         gdouble         rate,
+                                         guint           burst)
+{
+    g_return_if_fail (limiter != NULL);
+
+    g_mutex_lock (&limiter->lock);
+    rate_rules_set (limiter->session_tool_rules, &limiter->session_tool, name, rate, burst);
+    g_mutex_unlock (&limiter->lock);
+}
+
+void
+mcp_rate_limiter_set_resource_limit (McpRateLimiter *limiter,
+                                     const gchar    *uri,
+                                     gdouble         rate,
+                                     guint           burst)
+{
+    g_return_if_fail (limiter != NULL);
+
+    g_mutex_lock (&limiter->lock);
+    rate_rules_set (limiter->resource_rules, &limiter->resource, uri, rate, burst);
+    g_mutex_unlock (&limiter->lock);
+}
+
+void
+mcp_rate_limiter_set_session_resource_limit (McpRateLimiter *limiter,
+                                             const gchar    *uri,
+                                             gdouble         rate,
+                                             guint           burst)
+{
+    g_return_if_fail (limiter != NULL);
+
+    g_mutex_lock (&limiter->lock);
+    rate_rules_set (limiter->session_resource_rules, &limiter->session_resource,
+                    uri, rate, burst);
+    g_mutex_unlock (&limiter->lock);
+}
+
+guint64
+mcp_rate_limiter_get_rejected (McpRateLimiter *limiter)
+{
+    guint64 rejected;
+
+    g_return_val_if_fail (limiter != NULL, 0);
+
+    g_mutex_lock (&limiter->lock);
+    rejected = limiter->rejected;
+    g_mutex_unlock (&limiter->lock);
+
+    return rejected;
+}
+
+static gboolean
+rate_bucket_is_full (gpointer key,
+                     gpointer value,
+                     gpointer user_data)
+{
+    RateBucket *bucket = key;
+    gint64 *now = user_data;
+
+    return bucket->full_at <= *now;
+}
+
+static gboolean
+rate_bucket_is_session (gpointer key,
+                        gpointer value,
+                        gpointer user_data)
+{
+    RateBucket *bucket = key;
+
+    return bucket->session == user_data;
+}
+
+/* Drops @session's buckets, so a later server at the same address starts afresh */
+static void
+rate_limiter_forget (McpRateLimiter *limiter,
+                     McpServer      *session)
+{
+    g_mutex_lock (&limiter->lock);
+    g_hash_table_foreach_remove (limiter->buckets, rate_bucket_is_session, session);
+    g_mutex_unlock (&limiter->lock);
+}
+
+/*
+ * Returns the bucket for @session and the tool or resource @name,
+ * refilled by @rule up to @now.  A new bucket starts full.  Called
+ * with the lock held.
+ */
+static RateBucket *
+rate_limiter_bucket (McpRateLimiter *limiter,
+                     gpointer        session,
+                     const gchar    *name,
+                     gboolean        resource,
+                     const RateRule *rule,
+                     gint64          now)
+{
+    RateBucket lookup = { session, (gchar *) name, resource, 0, 0, 0 };
+    RateBucket *bucket;
+
+    bucket = g_hash_table_lookup (limiter->buckets, &lookup);
+    if (bucket != NULL)
     {
-        McpAsyncToolHandler async_handler;
-        g_autofree gchar *task_id = NULL;
-        g_autoptr(McpTask) task = NULL;
-        g_autoptr(JsonBuilder) builder = NULL;
+        bucket->tokens = MIN (rule->burst,
+                              bucket->tokens +
+                              rule->rate * (now - bucket->updated) / G_USEC_PER_SEC);
+        bucket->updated = now;
+        return bucket;
+    }
 
-        /* Generate unique task ID */
-        task_id = g_strdup_printf ("task-%lu", ++self->task_counter);
+    bucket = g_new0 (RateBucket, 1);
+    bucket->session = session;
+    bucket->name = g_strdup (name);
+    bucket->resource = resource;
+    bucket->tokens = rule->burst;
+    bucket->updated = now;
+    g_hash_table_add (limiter->buckets, bucket);
 
-        /* Create new task */
-        task = mcp_task_new (task_id, MCP_TASK_STATUS_WORKING);
-        mcp_task_set_status_message (task, "Processing");
+    return bucket;
+}
+
+/*
+ * Takes a token from every bucket limiting a request of @session for
+ * the tool or, with @resource, the resource @name, or from none.  When
+ * refused, @retry_after is set to the microseconds until every bucket
+ * has a token again and @scope to the limit that is furthest from it.
+ */
+static gboolean
+rate_limiter_take (McpRateLimiter  *limiter,
+                   McpServer       *session,
+                   const gchar     *name,
+                   gboolean         resource,
+                   gint64          *retry_after,
+                   const gchar    **scope)
+{
+    static const gchar *tool_scopes[] = { "session", "tool", "session-tool" };
+    static const gchar *resource_scopes[] = { "session", "resource", "session-resource" };
+    const gchar **scopes = resource ? resource_scopes : tool_scopes;
+    const RateRule *rules[3];
+    RateBucket *buckets[3] = { NULL, NULL, NULL };
+    gint64 now;
+    gint64 wait = 0;
+    guint i;
+
+    g_mutex_lock (&limiter->lock);
+
+    rules[0] = &limiter->session;
+    rules[1] = g_hash_table_lookup (resource ? limiter->resource_rules
+                                             : limiter->tool_rules, name);
+    if (rules[1] == NULL)
+    {
+        rules[1] = resource ? &limiter->resource : &limiter->tool;
+    }
+    rules[2] = g_hash_table_lookup (resource ? limiter->session_resource_rules
+                                             : limiter->session_tool_rules, name);
+    if (rules[2] == NULL)
+    {
+        rules[2] = resource ? &limiter->session_resource : &limiter->session_tool;
+    }
+
+    now = g_get_monotonic_time ();
+    if (g_hash_table_size (limiter->buckets) >= limiter->sweep_at)
+    {
+        g_hash_table_foreach_remove (limiter->buckets, rate_bucket_is_full, &now);
+        limiter->sweep_at = MAX (RATE_LIMITER_MIN_SWEEP,
+                                 2 * g_hash_table_size (limiter->buckets));
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (rules); i++)
+    {
+        if (rules[i]->rate <= 0.0)
+        {
+            continue;
+        }
+
+        buckets[i] = rate_limiter_bucket (limiter,
+                                          i != 1 ? session : NULL,
+                                          i != 0 ? name : NULL,
+                                          i != 0 && resource,
+                                          rules[i], now);
+        if (buckets[i]->tokens < 1.0)
+        {
+            gint64 needed = (gint64) ((1.0 - buckets[i]->tokens) / rules[i]->rate *
+                                      G_USEC_PER_SEC) + 1;
+
+            if (needed > wait)
+            {
+                wait = needed;
+                *scope = scopes[i];
+            }
+        }
+    }
+
+    if (wait > 0)
+    {
+        limiter->rejected++;
+        g_mutex_unlock (&limiter->lock);
+
+        *retry_after = wait;
+        return FALSE;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (buckets); i++)
+    {
+        if (buckets[i] != NULL)
+        {
+            buckets[i]->tokens -= 1.0;
+            buckets[i]->full_at = now + (gint64) ((rules[i]->burst - buckets[i]->tokens) /
+                                                  rules[i]->rate * G_USEC_PER_SEC);
+        }
+    }
+
+    g_mutex_unlock (&limiter->lock);
+    return TRUE;
+}
+
+/*
+ * Checks a request for the tool or, with @resource, the resource @name
+ * against the server's limiter, replying with a retryable error if it
+ * is refused.  Returns %TRUE if the request may go ahead.
+ */
+static gboolean
+check_rate_limit (McpServer   *self,
+                  const gchar *request_id,
+                  const gchar *name,
+                  gboolean     resource)
+{
+    g_autoptr(JsonObject) object = NULL;
+    g_autoptr(JsonNode) data = NULL;
+    const gchar *scope = NULL;
+    gint64 retry_after = 0;
+
+    if (self->rate_limiter == NULL ||
+        rate_limiter_take (self->rate_limiter, self, name, resource, &retry_after, &scope))
+    {
+        return TRUE;
+    }
+
+    object = json_object_new ();
+    json_object_set_int_member (object, "retryAfterMs", (retry_after + 999) / 1000);
+    json_object_set_string_member (object, "scope", scope);
+    data = json_node_new (JSON_NODE_OBJECT);
+    json_node_set_object (data, object);
+
+    send_error_response (self, request_id, MCP_ERROR_RATE_LIMITED,
+                         "Rate limit exceeded", data);
+    return FALSE;
+}
+
+/*
+ * Writes @node with object members sorted by name and integral
+ * numbers written as integers, so that arguments that differ only in
+ * member order or number spelling give the same text.
+ */
+static void
+write_canonical_json (McpJsonWriter *writer,
+                      JsonNode      *node)
+{
+    switch (json_node_get_node_type (node))
+    {
+        case JSON_NODE_OBJECT:
+            {
+                JsonObject *object = json_node_get_object (node);
+                GList *members;
+                GList *l;
+
+                members = g_list_sort (json_object_get_members (object),
+                                       (GCompareFunc) g_strcmp0);
+
+                mcp_json_writer_begin_object (writer);
+                for (l = members; l != NULL; l = l->next)
+                {
+                    mcp_json_writer_member (writer, l->data);
+                    write_canonical_json (writer, json_object_get_member (object, l->data));
+                }
+                mcp_json_writer_end_object (writer);
+
+                g_list_free (members);
+            }
+            break;
+
+        case JSON_NODE_ARRAY:
+            {
+                JsonArray *array = json_node_get_array (node);
+                guint length = json_array_get_length (array);
+                guint i;
+
+                mcp_json_writer_begin_array (writer);
+                for (i = 0; i < length; i++)
+                {
+                    write_canonical_json (writer, json_array_get_element (array, i));
+                }
+                mcp_json_writer_end_array (writer);
+            }
+            break;
+
+        case JSON_NODE_VALUE:
+            if (json_node_get_value_type (node) == G_TYPE_DOUBLE)
+            {
+                gdouble value = json_node_get_double (node);
+
+                /* 1, 1.0 and 1e0 are the same argument */
+                if (value >= -9007199254740992.0 && value <= 9007199254740992.0 &&
+                    (gdouble) (gint64) value == value)
+                {
+                    mcp_json_writer_int (writer, (gint64) value);
+                    break;
+                }
+            }
+            mcp_json_writer_node (writer, node);
+            break;
+
+        default:
+            mcp_json_writer_node (writer, node);
+            break;
+    }
+}
+
+static gchar *
+canonical_arguments (McpServer  *self,
+                     JsonObject *arguments)
+{
+    McpJsonWriter *writer = scratch_writer ();
+    g_autoptr(JsonNode) node = NULL;
+
+    node = json_node_new (JSON_NODE_OBJECT);
+    json_node_set_object (node, arguments);
+
+    /* No response is being written while a request is dispatched */
+    mcp_json_writer_reset (writer);
+    write_canonical_json (writer, node);
+
+    return g_strdup (mcp_json_writer_get_data (writer, NULL));
+}
+
+/* Tool result cache */
+
+/*
+ * ToolCache:
+ *
+ * Serialized results of read-only and idempotent tools, keyed by the
+ * tool name and canonical arguments.  Entries expire after the TTL and
+ * the least recently used are evicted to keep the total size, counted
+ * as key plus serialized result plus bookkeeping, under the limit.
+ * Only used on the server's context.
+ */
+typedef struct
+{
+    GList   link;       /* in the LRU list; data points back here */
+    gchar  *key;        /* tool name, newline, canonical arguments */
+    GBytes *result;
+    gint64  expires;    /* monotonic time, or G_MAXINT64 */
+    gsize   size;
+} CacheEntry;
+
+typedef struct
+{
+    guint64 hits;
+    guint64 misses;
+} CacheStats;
+
+struct _ToolCache
+{
+    GHashTable *entries;    /* key -> CacheEntry */
+    GQueue      lru;        /* most recently used first */
+    GHashTable *stats;      /* tool name -> CacheStats */
+    gsize       size;
+    gsize       max_size;
+    gint64      ttl;        /* microseconds, 0 for no expiry */
+    guint       generation; /* bumped by every invalidation */
+};
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+    g_free (entry->key);
+    g_bytes_unref (entry->result);
+    g_free (entry);
+}
+
+static ToolCache *
+tool_cache_new (void)
+{
+    ToolCache *cache;
+
+    cache = g_new0 (ToolCache, 1);
+    cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                            (GDestroyNotify) cache_entry_free);
+    g_queue_init (&cache->lru);
+    cache->stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    return cache;
+}
+
+static void
+tool_cache_remove (ToolCache  *cache,
+                   CacheEntry *entry)
+{
+    g_queue_unlink (&cache->lru, &entry->link);
+    cache->size -= entry->size;
+    g_hash_table_remove (cache->entries, entry->key);
+}
+
+static void
+tool_cache_clear (ToolCache *cache)
+{
+    g_hash_table_remove_all (cache->entries);
+    g_queue_init (&cache->lru);
+    cache->size = 0;
+    cache->generation++;
+}
+
+static void
+tool_cache_free (ToolCache *cache)
+{
+    g_hash_table_unref (cache->entries);
+    g_hash_table_unref (cache->stats);
+    g_free (cache);
+}
+
+static void
+tool_cache_evict (ToolCache *cache)
+{
+    while (cache->size > cache->max_size)
+    {
+        tool_cache_remove (cache, g_queue_peek_tail (&cache->lru));
+    }
+}
+
+static gboolean
+tool_is_cacheable (McpTool *tool)
+{
+    return tool != NULL &&
+           (mcp_tool_get_read_only_hint (tool) || mcp_tool_get_idempotent_hint (tool));
+}
+
+/* The same key schedule_tool_call() coalesces on */
+static gchar *
+tool_cache_key (McpJsonWriter *writer,
+                const gchar   *name,
+                JsonObject    *arguments)
+{
+    mcp_json_writer_reset (writer);
+
+    if (arguments != NULL)
+    {
+        g_autoptr(JsonNode) node = json_node_new (JSON_NODE_OBJECT);
+
+        json_node_set_object (node, arguments);
+        write_canonical_json (writer, node);
+    }
+
+    return g_strconcat (name, "\n", mcp_json_writer_get_data (writer, NULL), NULL);
+}
+
+/* Returns the cached result for @key, counting the hit or miss */
+static GBytes *
+tool_cache_lookup (ToolCache   *cache,
+                   const gchar *key,
+                   const gchar *name)
+{
+    CacheEntry *entry;
+    CacheStats *stats;
+
+    stats = g_hash_table_lookup (cache->stats, name);
+    if (stats == NULL)
+    {
+        stats = g_new0 (CacheStats, 1);
+        g_hash_table_insert (cache->stats, g_strdup (name), stats);
+    }
+
+    entry = g_hash_table_lookup (cache->entries, key);
+    if (entry != NULL && entry->expires <= g_get_monotonic_time ())
+    {
+        tool_cache_remove (cache, entry);
+        entry = NULL;
+    }
+
+    if (entry == NULL)
+    {
+        stats->misses++;
+        return NULL;
+    }
+
+    stats->hits++;
+    g_queue_unlink (&cache->lru, &entry->link);
+    g_queue_push_head_link (&cache->lru, &entry->link);
+
+    return entry->result;
+}
+
+/*
+ * Serializes @result and, unless it is an error or the cache was
+ * invalidated since @generation was read, stores it under @key.
+ * Returns the serialized result either way.
+ */
+static GBytes *
+tool_cache_store (McpServer     *self,
+                  const gchar   *key,
+                  guint          generation,
+                  McpToolResult *result)
+{
+    ToolCache *cache = self->tool_cache;
+    g_autoptr(McpJsonWriter) writer = NULL;
+    CacheEntry *entry;
+    GBytes *bytes;
+
+    writer = mcp_json_writer_new ();
+    mcp_tool_result_write_json (result, writer);
+    bytes = mcp_json_writer_to_bytes (writer);
+
+    if (cache == NULL || cache->generation != generation ||
+        mcp_tool_result_get_is_error (result))
+    {
+        return bytes;
+    }
+
+    entry = g_hash_table_lookup (cache->entries, key);
+    if (entry != NULL)
+    {
+        tool_cache_remove (cache, entry);
+    }
+
+    entry = g_new0 (CacheEntry, 1);
+    entry->link.data = entry;
+    entry->key = g_strdup (key);
+    entry->result = g_bytes_ref (bytes);
+    entry->expires = cache->ttl > 0 ? g_get_monotonic_time () + cache->ttl : G_MAXINT64;
+    entry->size = sizeof (CacheEntry) + strlen (key) + 1 + g_bytes_get_size (bytes);
+
+    if (entry->size > cache->max_size)
+    {
+        cache_entry_free (entry);
+        return bytes;
+    }
+
+    g_hash_table_insert (cache->entries, entry->key, entry);
+    g_queue_push_head_link (&cache->lru, &entry->link);
+    cache->size += entry->size;
+    tool_cache_evict (cache);
+
+    return bytes;
+}
+
+void
+mcp_server_set_tool_cache (McpServer *self,
+                           guint      ttl_ms,
+                           gsize      max_bytes)
+{
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    if (max_bytes == 0)
+    {
+        g_clear_pointer (&self->tool_cache, tool_cache_free);
+        return;
+    }
+
+    if (self->tool_cache == NULL)
+    {
+        self->tool_cache = tool_cache_new ();
+    }
+
+    /* Entries already cached keep the expiry they were stored with */
+    self->tool_cache->ttl = (gint64) ttl_ms * 1000;
+    self->tool_cache->max_size = max_bytes;
+    tool_cache_evict (self->tool_cache);
+}
+
+gsize
+mcp_server_get_tool_cache_size (McpServer *self)
+{
+    g_return_val_if_fail (MCP_IS_SERVER (self), 0);
+    return self->tool_cache != NULL ? self->tool_cache->size : 0;
+}
+
+void
+mcp_server_invalidate_tool_results (McpServer   *self,
+                                    const gchar *name)
+{
+    ToolCache *cache;
+    GList *l;
+    gsize name_len;
+
+    g_return_if_fail (MCP_IS_SERVER (self));
+
+    if (!on_owner_thread (self))
+    {
+        outbox_push (self, outbox_item_new (OUTBOX_INVALIDATE_TOOL, name, NULL));
+        return;
+    }
+
+    cache = self->tool_cache;
+    if (cache == NULL)
+    {
+        return;
+    }
+
+    if (name == NULL)
+    {
+        tool_cache_clear (cache);
+        return;
+    }
+
+    name_len = strlen (name);
+    l = cache->lru.head;
+    while (l != NULL)
+    {
+        CacheEntry *entry = l->data;
+
+        l = l->next;
+        if (strncmp (entry->key, name, name_len) == 0 && entry->key[name_len] == '\n')
+        {
+            tool_cache_remove (cache, entry);
+        }
+    }
+    cache->generation++;
+}
+
+static void
+tool_cache_invalidate_key (McpServer   *self,
+                           const gchar *key)
+{
+    CacheEntry *entry;
+
+    if (self->tool_cache == NULL)
+    {
+        return;
+    }
+
+    entry = g_hash_table_lookup (self->tool_cache->entries, key);
+    if (entry != NULL)
+    {
+        tool_cache_remove (self->tool_cache, entry);
+    }
+    self->tool_cache->generation++;
+}
+
+void
+mcp_server_invalidate_tool_result (McpServer   *self,
+                                   const gchar *name,
+                                   JsonObject  *arguments)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+    g_autofree gchar *key = NULL;
+
+    g_return_if_fail (MCP_IS_SERVER (self));
+    g_return_if_fail (name != NULL);
+
+    /* A writer of its own, as this may run on a worker thread or
+     * inside a handler while the server's writer is in use */
+    writer = mcp_json_writer_new ();
+    key = tool_cache_key (writer, name, arguments);
+
+    if (!on_owner_thread (self))
+    {
+        outbox_push (self, outbox_item_new (OUTBOX_INVALIDATE_RESULT, key, NULL));
+        return;
+    }
+
+    tool_cache_invalidate_key (self, key);
+}
+
+gboolean
+mcp_server_get_tool_cache_stats (McpServer   *self,
+                                 const gchar *name,
+                                 guint64     *hits,
+                                 guint64     *misses)
+{
+    CacheStats *stats = NULL;
+
+    g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
+    g_return_val_if_fail (name != NULL, FALSE);
+
+    if (self->tool_cache != NULL)
+    {
+        stats = g_hash_table_lookup (self->tool_cache->stats, name);
+    }
+
+    if (hits != NULL)
+    {
+        *hits = stats != NULL ? stats->hits : 0;
+    }
+    if (misses != NULL)
+    {
+        *misses = stats != NULL ? stats->misses : 0;
+    }
+
+    return stats != NULL;
+}
+
+/* Writes a result serialized earlier as the reply to @request_id */
+static void
+send_serialized_result (McpServer   *self,
+                        const gchar *request_id,
+                        GBytes      *result)
+{
+    McpJsonWriter *writer;
+
+    writer = begin_response (self, request_id);
+    if (writer != NULL)
+    {
+        mcp_json_writer_raw (writer, g_bytes_get_data (result, NULL),
+                             g_bytes_get_size (result));
+        finish_response (self, writer, request_id);
+    }
+}
+
+static void
+tool_call_free (ToolCall *call)
+{
+    g_clear_object (&call->task);
+    g_clear_pointer (&call->registry, registry_unref);
+    g_free (call->name);
+    g_free (call->arguments);
+    g_free (call->coalesce_key);
+    g_ptr_array_unref (call->request_ids);
+    g_clear_pointer (&call->result, mcp_tool_result_unref);
+    g_free (call);
+}
+
+static void tool_call_thread (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable);
+
+static void
+tool_calls_start (GQueue *runnable)
+{
+    ToolCall *call;
+
+    while ((call = g_queue_pop_head (runnable)) != NULL)
+    {
+        g_task_run_in_thread (call->task, tool_call_thread);
+    }
+}
+
+static void
+tool_call_thread (GTask        *task,
+                  gpointer      source_object,
+                  gpointer      task_data,
+                  GCancellable *cancellable)
+{
+    McpServer *self = MCP_SERVER (source_object);
+    ToolCall *call = task_data;
+    g_autoptr(JsonNode) arguments = NULL;
+    GQueue runnable = G_QUEUE_INIT;
+    McpToolHandler handler;
+
+    /* The handler gets a tree of its own, not the dispatching thread's */
+    if (call->arguments != NULL)
+    {
+        arguments = mcp_json_parse (call->arguments, -1, NULL);
+    }
+
+    handler = (McpToolHandler) call->hd->handler;
+    call->result = handler (self, call->name,
+                            arguments != NULL ? json_node_get_object (arguments) : NULL,
+                            call->hd->user_data);
+
+    /* Start whatever was waiting on this call before replying */
+    g_mutex_lock (&tool_scope_lock);
+    tool_scope_release (call, &runnable);
+    g_mutex_unlock (&tool_scope_lock);
+    tool_calls_start (&runnable);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+tool_call_done_cb (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+    McpServer *self = MCP_SERVER (source);
+    ToolCall *call = user_data;
+    guint i;
+
+    if (call->coalesce_key != NULL)
+    {
+        g_hash_table_remove (self->inflight_calls, call->coalesce_key);
+    }
+
+    if (call->result == NULL)
+    {
+        call->result = mcp_tool_result_new (FALSE);
+        mcp_tool_result_add_text (call->result, "");
+    }
+
+    if (call->cache_result)
+    {
+        g_autoptr(GBytes) bytes = NULL;
+
+        bytes = tool_cache_store (self, call->coalesce_key, call->cache_generation,
+                                  call->result);
+        for (i = 0; i < call->request_ids->len; i++)
+        {
+            send_serialized_result (self, g_ptr_array_index (call->request_ids, i), bytes);
+        }
+
+        tool_call_free (call);
+        return;
+    }
+
+    for (i = 0; i < call->request_ids->len; i++)
+    {
+        McpJsonWriter *writer;
+
+        writer = begin_response (self, g_ptr_array_index (call->request_ids, i));
+        if (writer != NULL)
+        {
+            mcp_tool_result_write_json (call->result, writer);
+            finish_response (self, writer, g_ptr_array_index (call->request_ids, i));
+        }
+    }
+
+    tool_call_free (call);
+}
+
+/*
+ * Runs @hd on the worker pool once @tool's annotations allow it, and
+ * replies to @request_id from the server's context.  A call to a
+ * read-only or idempotent tool joins an identical call in flight
+ * instead of running again.  With @cache_result set, the result is
+ * stored in the tool cache unless it was invalidated after
+ * @cache_generation.
+ */
+static void
+schedule_tool_call (McpServer   *self,
+                    Registry    *registry,
+                    McpTool     *tool,
+                    HandlerData *hd,
+                    const gchar *name,
+                    JsonObject  *arguments,
+                    const gchar *request_id,
+                    gboolean     cache_result,
+                    guint        cache_generation)
+{
+    g_autofree gchar *canonical = NULL;
+    g_autofree gchar *coalesce_key = NULL;
+    g_autofree gchar *resource_key = NULL;
+    GQueue runnable = G_QUEUE_INIT;
+    ToolCall *call;
+
+    if (arguments != NULL)
+    {
+        canonical = canonical_arguments (self, arguments);
+    }
+
+    if (mcp_tool_get_read_only_hint (tool) || mcp_tool_get_idempotent_hint (tool))
+    {
+        coalesce_key = g_strconcat (name, "\n", canonical, NULL);
+
+        if (self->inflight_calls == NULL)
+        {
+            self->inflight_calls = g_hash_table_new (g_str_hash, g_str_equal);
+        }
+
+        call = g_hash_table_lookup (self->inflight_calls, coalesce_key);
+        if (call != NULL)
+        {
+            g_ptr_array_add (call->request_ids, g_strdup (request_id));
+            return;
+        }
+    }
+
+    if (self->tool_key_func != NULL)
+    {
+        resource_key = self->tool_key_func (self, name, arguments, self->tool_key_data);
+    }
+
+    call = g_new0 (ToolCall, 1);
+    call->task = g_task_new (self, NULL, tool_call_done_cb, call);
+    g_task_set_source_tag (call->task, schedule_tool_call);
+    g_task_set_task_data (call->task, call, NULL);
+    call->registry = registry_ref (registry);
+    call->hd = hd;
+    call->name = g_strdup (name);
+    call->arguments = g_steal_pointer (&canonical);
+    call->request_ids = g_ptr_array_new_with_free_func (g_free);
+    g_ptr_array_add (call->request_ids, g_strdup (request_id));
+    call->exclusive = !mcp_tool_get_read_only_hint (tool) &&
+                      mcp_tool_get_destructive_hint (tool);
+
+    if (coalesce_key != NULL)
+    {
+        call->coalesce_key = g_steal_pointer (&coalesce_key);
+        g_hash_table_insert (self->inflight_calls, call->coalesce_key, call);
+        call->cache_result = cache_result;
+        call->cache_generation = cache_generation;
+    }
+
+    g_mutex_lock (&tool_scope_lock);
+    call->scope = tool_scope_lookup (self, resource_key);
+    g_queue_push_tail (&call->scope->waiting, call);
+    tool_scope_take_runnable (call->scope, &runnable);
+    g_mutex_unlock (&tool_scope_lock);
+
+    tool_calls_start (&runnable);
+}
+
+static void
+handle_tools_call (McpServer     *self,
+                   ServerRequest *request)
+{
+    JsonObject *params;
+    const gchar *name;
+    JsonObject *arguments = NULL;
+    HandlerData *hd;
+    HandlerData *async_hd;
+    McpTool *tool;
+    g_autoptr(Registry) registry = NULL;
+    g_autoptr(McpToolResult) tool_result = NULL;
+    g_autoptr(JsonNode) result = NULL;
+    g_autofree gchar *cache_key = NULL;
+    guint cache_generation = 0;
+    McpJsonWriter *writer;
+
+    params = get_request_params_object (request);
+    if (params == NULL || !json_object_has_member (params, "name"))
+    {
+        send_error_response (self, request->id,
+                             MCP_ERROR_INVALID_PARAMS,
+                             "Missing tool name", NULL);
+        return;
+    }
+
+    name = json_object_get_string_member (params, "name");
+
+    /* The call runs against this snapshot even if it is replaced meanwhile */
+    registry = registry_acquire (self);
+
+    if (!g_hash_table_contains (registry->tools, name))
+    {
+        send_error_response (self, request->id,
+                             MCP_ERROR_METHOD_NOT_FOUND,
+                             "Unknown tool", NULL);
+        return;
+    }
+
+    if (!check_rate_limit (self, request->id, name, FALSE))
+    {
+        return;
+    }
+
+    if (json_object_has_member (params, "arguments"))
+    {
+        arguments = json_object_get_object_member (params, "arguments");
+    }
+
+    g_signal_emit (self, signals[SIGNAL_TOOL_CALLED], 0, name, arguments);
+
+    /* First check for async tool handler (Tasks API) */
+    async_hd = g_hash_table_lookup (registry->async_tool_handlers, name);
+    if (async_hd != NULL && async_hd->handler != NULL)
+    {
+        McpAsyncToolHandler async_handler;
+        g_autofree gchar *task_id = NULL;
+        g_autoptr(McpTask) task = NULL;
+        g_autoptr(JsonBuilder) builder = NULL;
+
+        /* Generate unique task ID */
+        task_id = g_strdup_printf ("task-%lu", ++self->task_counter);
+
+        /* Create new task */
+        task = mcp_task_new (task_id, MCP_TASK_STATUS_WORKING);
+        mcp_task_set_status_message (task, "Processing");
+
+        /* Store task */
+        g_hash_table_insert (lazy_table (&self->tasks, g_object_unref),
+                             g_strdup (task_id), g_object_ref (task));
+        g_object_set_data_full (G_OBJECT (task), TASK_REGISTRY_KEY,
+                                registry_ref (registry),
+                                (GDestroyNotify) registry_unref);
+
+        /* Call async handler */
+        async_handler = (McpAsyncToolHandler) async_hd->handler;
+        tool_result = async_handler (self, task, name, arguments, async_hd->user_data);
+
+        if (tool_result != NULL)
+        {
+            /* Handler completed synchronously */
+            g_object_set_data (G_OBJECT (task), TASK_REGISTRY_KEY, NULL);
+            mcp_task_set_status (task, MCP_TASK_STATUS_COMPLETED);
+            mcp_task_set_status_message (task, "Completed synchronously");
+            mcp_task_update_timestamp (task);
+
+            /* Store result */
+            g_hash_table_insert (lazy_table (&self->task_results,
+                                             (GDestroyNotify) mcp_tool_result_unref),
+                                 g_strdup (task_id), mcp_tool_result_ref (tool_result));
+
+            /* Return result with task info */
+            builder = json_builder_new ();
+            json_builder_begin_object (builder);
+
+            /* Add content from tool result */
+            {
+                g_autoptr(JsonNode) tool_node = mcp_tool_result_to_json (tool_result);
+                JsonObject *tool_obj = json_node_get_object (tool_node);
+
+                if (json_object_has_member (tool_obj, "content"))
+                {
+                    JsonArray *content = json_object_get_array_member (tool_obj, "content");
+                    JsonNode *arr_node = json_node_new (JSON_NODE_ARRAY);
+                    json_builder_set_member_name (builder, "content");
+                    /* json_node_set_array refs the array, so don't add extra ref */
+                    json_node_set_array (arr_node, content);
+                    json_builder_add_value (builder, arr_node);
+                }
+
+                if (json_object_has_member (tool_obj, "isError"))
+                {
+                    json_builder_set_member_name (builder, "isError");
+                    json_builder_add_boolean_value (builder, json_object_get_boolean_member (tool_obj, "isError"));
+                }
+            }
+
+            /* Add task info */
+            json_builder_set_member_name (builder, "task");
+            {
+                g_autoptr(JsonNode) task_node = mcp_task_to_json (task);
+                json_builder_add_value (builder, g_steal_pointer (&task_node));
+            }
+
+            json_builder_end_object (builder);
+            result = json_builder_get_root (builder);
+        }
+        else
+        {
+            /* Handler is processing asynchronously */
+            /* Return task reference */
+            builder = json_builder_new ();
+            json_builder_begin_object (builder);
+            json_builder_set_member_name (builder, "task");
+            {
+                g_autoptr(JsonNode) task_node = mcp_task_to_json (task);
+                json_builder_add_value (builder, g_steal_pointer (&task_node));
+            }
+            json_builder_end_object (builder);
+            result = json_builder_get_root (builder);
+        }
+
+        send_response (self, request->id, g_steal_pointer (&result));
+        return;
+    }
+
+    /* Regular synchronous tool handler */
+    hd = g_hash_table_lookup (registry->tool_handlers, name);
+    tool = g_hash_table_lookup (registry->tools, name);
+
+    if (hd != NULL && hd->handler != NULL &&
+        self->tool_cache != NULL && tool_is_cacheable (tool))
+    {
+        GBytes *cached;
+
+        cache_key = tool_cache_key (scratch_writer (), name, arguments);
+        cached = tool_cache_lookup (self->tool_cache, cache_key, name);
+        if (cached != NULL)
+        {
+            send_serialized_result (self, request->id, cached);
+            return;
+        }
+
+        /* An invalidation while the handler runs keeps its result out */
+        cache_generation = self->tool_cache->generation;
+    }
+
+    if (hd != NULL && hd->handler != NULL && self->concurrent_tools)
+    {
+        /* Replies from the server's context once the worker is done */
+        schedule_tool_call (self, registry, tool, hd, name, arguments, request->id,
+                            cache_key != NULL, cache_generation);
+        return;
+    }
+
+    if (hd != NULL && hd->handler != NULL)
+    {
+        McpToolHandler handler;
+        handler = (McpToolHandler) hd->handler;
+        tool_result = handler (self, name, arguments, hd->user_data);
+    }
+    else
+    {
+        /* No handler - return empty result */
+        tool_result = mcp_tool_result_new (FALSE);
+        mcp_tool_result_add_text (tool_result, "");
+    }
+
+    if (cache_key != NULL)
+    {
+        g_autoptr(GBytes) bytes = NULL;
+
+        if (tool_result == NULL)
+        {
+            tool_result = mcp_tool_result_new (FALSE);
+            mcp_tool_result_add_text (tool_result, "");
+        }
+
+        bytes = tool_cache_store (self, cache_key, cache_generation, tool_result);
+        send_serialized_result (self, request->id, bytes);
+        return;
+    }
+
+    writer = begin_response (self, request->id);
+    if (writer != NULL)
+    {
+        mcp_tool_result_write_json (tool_result, writer);
+        finish_response (self, writer, request->id);
+    }
+}
+
+static void
+handle_resources_list (McpServer     *self,
+                       ServerRequest *request)
+{
+    g_autoptr(JsonBuilder) builder = NULL;
+    g_autoptr(JsonNode) result = NULL;
+    GHashTableIter iter;
+    gpointer value;
+
+    builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "resources");
+    json_builder_begin_array (builder);
+
+    g_hash_table_iter_init (&iter, registry_peek (self)->resources);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        McpResource *resource = MCP_RESOURCE (value);
+        g_autoptr(JsonNode) res_node = mcp_resource_to_json (resource);
+        json_builder_add_value (builder, g_steal_pointer (&res_node));
+    }
+
+    json_builder_end_array (builder);
+    json_builder_end_object (builder);
+    result = json_builder_get_root (builder);
+
+    send_response (self, request->id, g_steal_pointer (&result));
+}
+
+static void
+handle_resources_templates_list (McpServer     *self,
+                                 ServerRequest *request)
+{
+    g_autoptr(JsonBuilder) builder = NULL;
+    g_autoptr(JsonNode) result = NULL;
+    GHashTableIter iter;
+    gpointer value;
+
+    builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "resourceTemplates");
+    json_builder_begin_array (builder);
+
+    g_hash_table_iter_init (&iter, registry_peek (self)->resource_templates);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        McpResourceTemplate *templ = MCP_RESOURCE_TEMPLATE (value);
+        g_autoptr(JsonNode) templ_node = mcp_resource_template_to_json (templ);
+        json_builder_add_value (builder, g_steal_pointer (&templ_node));
+    }
+
+    json_builder_end_array (builder);
+    json_builder_end_object (builder);
+    result = json_builder_get_root (builder);
+
+    send_response (self, request->id, g_steal_pointer (&result));
+}
+
+/*
+ * Whether the client declared an experimental capability, such as
+ * taking bulk resource contents out of band.
+ */
+static gboolean
+client_accepts (McpServer   *self,
+                const gchar *capability)
+{
+    return self->transport != NULL &&
+           self->client_capabilities != NULL &&
+           mcp_client_capabilities_get_experimental (self->client_capabilities,
+                                                     capability) != NULL;
+}
+
+/*
+ * Passes the descriptor behind @contents to the client and writes an
+ * entry that refers to it.  Returns %FALSE, having written nothing, if
+ * the descriptor could not be passed.
+ */
+static gboolean
+write_contents_fd (McpServer           *self,
+                   McpResourceContents *contents,
+                   McpJsonWriter       *writer)
+{
+    g_autoptr(GError) error = NULL;
+    const gchar *mime_type;
+    gint handle;
+
+    handle = mcp_transport_send_fd (self->transport,
+                                    mcp_resource_contents_get_fd (contents),
+                                    &error);
+    if (handle < 0)
+    {
+        g_debug ("Sending %s inline: %s",
+                 mcp_resource_contents_get_uri (contents), error->message);
+        return FALSE;
+    }
+
+    mcp_json_writer_begin_object (writer);
+
+    mcp_json_writer_member (writer, "uri");
+    mcp_json_writer_string (writer, mcp_resource_contents_get_uri (contents));
+
+    mime_type = mcp_resource_contents_get_mime_type (contents);
+    if (mime_type != NULL)
+    {
+        mcp_json_writer_member (writer, "mimeType");
+        mcp_json_writer_string (writer, mime_type);
+    }
+
+    /* An empty blob keeps the entry valid for readers that ignore _meta */
+    mcp_json_writer_member (writer, "blob");
+    mcp_json_writer_string (writer, "");
+
+    mcp_json_writer_member (writer, "_meta");
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, MCP_TRANSPORT_FD_PASSING);
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "handle");
+    mcp_json_writer_int (writer, handle);
+    mcp_json_writer_end_object (writer);
+    mcp_json_writer_end_object (writer);
+
+    mcp_json_writer_end_object (writer);
+
+    return TRUE;
+}
+
+/*
+ * Publishes the data of @contents at a download URL served by the
+ * transport and writes an entry that refers to it.  Returns %FALSE,
+ * having written nothing, if the transport cannot serve it.
+ */
+static gboolean
+write_contents_download (McpServer           *self,
+                         McpResourceContents *contents,
+                         McpJsonWriter       *writer)
+{
+    g_autoptr(GBytes) data = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *url = NULL;
+    const gchar *mime_type;
+
+    mime_type = mcp_resource_contents_get_mime_type (contents);
+    data = mcp_resource_contents_get_bytes (contents);
+    url = mcp_transport_publish_download (self->transport, data, mime_type, &error);
+    if (url == NULL)
+    {
+        g_debug ("Sending %s inline: %s",
+                 mcp_resource_contents_get_uri (contents), error->message);
+        return FALSE;
+    }
+
+    mcp_json_writer_begin_object (writer);
+
+    mcp_json_writer_member (writer, "uri");
+    mcp_json_writer_string (writer, mcp_resource_contents_get_uri (contents));
+
+    if (mime_type != NULL)
+    {
+        mcp_json_writer_member (writer, "mimeType");
+        mcp_json_writer_string (writer, mime_type);
+    }
+
+    mcp_json_writer_member (writer, "blob");
+    mcp_json_writer_string (writer, "");
+
+    mcp_json_writer_member (writer, "_meta");
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, MCP_TRANSPORT_DOWNLOAD);
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "url");
+    mcp_json_writer_string (writer, url);
+    mcp_json_writer_member (writer, "size");
+    mcp_json_writer_int (writer, (gint64) g_bytes_get_size (data));
+    mcp_json_writer_end_object (writer);
+    mcp_json_writer_end_object (writer);
+
+    mcp_json_writer_end_object (writer);
+
+    return TRUE;
+}
+
+/* Read coalescing */
+
+struct _McpReadGroup
+{
+    gatomicrefcount  ref_count;
+    GHashTable      *flights;       /* key -> ReadFlight */
+    guint64          coalesced;
+};
+
+/*
+ * ReadFlight:
+ *
+ * A resources/read whose handler has not run yet, and the requests
+ * from every server in the group waiting for it.  It runs from an
+ * idle on the first server's context, so reads dispatched during the
+ * rest of that main loop iteration can still join.
+ */
+typedef struct
+{
+    McpReadGroup *group;
+    gchar        *key;
+    McpServer    *server;       /* runs the handler */
+    Registry     *registry;
+    gchar        *uri;
+    GPtrArray    *servers;      /* McpServer, one per waiting request */
+    GPtrArray    *request_ids;
+} ReadFlight;
+
+McpReadGroup *
+mcp_read_group_new (void)
+{
+    McpReadGroup *group;
+
+    group = g_new0 (McpReadGroup, 1);
+    g_atomic_ref_count_init (&group->ref_count);
+    group->flights = g_hash_table_new (g_str_hash, g_str_equal);
+
+    return group;
+}
+
+McpReadGroup *
+mcp_read_group_ref (McpReadGroup *group)
+{
+    g_return_val_if_fail (group != NULL, NULL);
+
+    g_atomic_ref_count_inc (&group->ref_count);
+    return group;
+}
+
+void
+mcp_read_group_unref (McpReadGroup *group)
+{
+    g_return_if_fail (group != NULL);
+
+    if (g_atomic_ref_count_dec (&group->ref_count))
+    {
+        g_hash_table_unref (group->flights);
+        g_free (group);
+    }
+}
+
+guint64
+mcp_read_group_get_coalesced_reads (McpReadGroup *group)
+{
+    g_return_val_if_fail (group != NULL, 0);
+    return group->coalesced;
+}
+
+/*
+ * The handler a read of @uri starts with: the resource's own handler,
+ * or else the first matching template's.
+ */
+static HandlerData *
+lookup_read_handler (Registry    *registry,
+                     const gchar *uri)
+{
+    GHashTableIter iter;
+    const gchar *template_uri;
+    HandlerData *hd;
+
+    hd = g_hash_table_lookup (registry->resource_handlers, uri);
+    if (hd != NULL && hd->handler != NULL)
+    {
+        return hd;
+    }
+
+    g_hash_table_iter_init (&iter, registry->resource_templates);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&template_uri, NULL))
+    {
+        if (uri_matches_template (uri, template_uri))
+        {
+            hd = g_hash_table_lookup (registry->template_handlers, template_uri);
+            if (hd != NULL && hd->handler != NULL)
+            {
+                return hd;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static GList *
+read_resource (McpServer   *self,
+               Registry    *registry,
+               const gchar *uri)
+{
+    HandlerData *hd;
+    McpResourceHandler handler;
+    GList *contents = NULL;
+
+    /* First try direct resource handlers */
+    hd = g_hash_table_lookup (registry->resource_handlers, uri);
+    if (hd != NULL && hd->handler != NULL)
+    {
+        handler = (McpResourceHandler) hd->handler;
+        contents = handler (self, uri, hd->user_data);
+    }
+
+    /* If no direct handler, try template matching */
+    if (contents == NULL)
+    {
+        GHashTableIter iter;
+        const gchar *template_uri;
+        McpResourceTemplate *templ;
+
+        g_hash_table_iter_init (&iter, registry->resource_templates);
+        while (g_hash_table_iter_next (&iter, (gpointer *)&template_uri, (gpointer *)&templ))
+        {
+            if (uri_matches_template (uri, template_uri))
+            {
+                hd = g_hash_table_lookup (registry->template_handlers, template_uri);
+                if (hd != NULL && hd->handler != NULL)
+                {
+                    handler = (McpResourceHandler) hd->handler;
+                    contents = handler (self, uri, hd->user_data);
+                    break;
+                }
+            }
+        }
+    }
+
+    return contents;
+}
+
+/* Whether read_resource() has a handler to try for @uri */
+static gboolean
+resource_is_known (Registry    *registry,
+                   const gchar *uri)
+{
+    GHashTableIter iter;
+    const gchar *template_uri;
+    HandlerData *hd;
+
+    hd = g_hash_table_lookup (registry->resource_handlers, uri);
+    if (hd != NULL && hd->handler != NULL)
+    {
+        return TRUE;
+    }
+
+    g_hash_table_iter_init (&iter, registry->resource_templates);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&template_uri, NULL))
+    {
+        if (uri_matches_template (uri, template_uri))
+        {
+            hd = g_hash_table_lookup (registry->template_handlers, template_uri);
+            if (hd != NULL && hd->handler != NULL)
+            {
+                return TRUE;
+            }
+        }
+    }
+
+    return FALSE;
+}
 
-        /* Store task */
-        g_hash_table_insert (self->tasks, g_strdup (task_id), g_object_ref (task));
+/*
+ * Whether @contents are written the same way for every client: bulk
+ * data that this client takes out of band is not.
+ */
+static gboolean
+contents_are_portable (McpServer *self,
+                       GList     *contents)
+{
+    gboolean pass_fds;
+    gboolean use_downloads;
+    GList *l;
 
-        /* Call async handler */
-        async_handler = (McpAsyncToolHandler) async_hd->handler;
-        tool_result = async_handler (self, task, name, arguments, async_hd->user_data);
+    pass_fds = client_accepts (self, MCP_TRANSPORT_FD_PASSING) &&
+               mcp_transport_supports_fd_passing (self->transport);
+    use_downloads = client_accepts (self, MCP_TRANSPORT_DOWNLOAD);
+    if (!pass_fds && !use_downloads)
+    {
+        return TRUE;
+    }
 
-        if (tool_result != NULL)
+    for (l = contents; l != NULL; l = l->next)
+    {
+        if (mcp_resource_contents_is_bulk (l->data))
         {
-            /* Handler completed synchronously */
-            mcp_task_set_status (task, MCP_TASK_STATUS_COMPLETED);
-            mcp_task_set_status_message (task, "Completed synchronously");
-            mcp_task_update_timestamp (task);
-
-            /* Store result */
-            g_hash_table_insert (self->task_results, g_strdup (task_id),
-                                 mcp_tool_result_ref (tool_result));
+            return FALSE;
+        }
+    }
 
-            /* Return result with task info */
-            builder = json_builder_new ();
-            json_builder_begin_object (builder);
+    return TRUE;
+}
 
-            /* Add content from tool result */
-            {
-                g_autoptr(JsonNode) tool_node = mcp_tool_result_to_json (tool_result);
-                JsonObject *tool_obj = json_node_get_object (tool_node);
+static void
+write_read_result (McpServer     *self,
+                   GList         *contents,
+                   McpJsonWriter *writer)
+{
+    gboolean pass_fds;
+    gboolean use_downloads;
+    GList *l;
 
-                if (json_object_has_member (tool_obj, "content"))
-                {
-                    JsonArray *content = json_object_get_array_member (tool_obj, "content");
-                    JsonNode *arr_node = json_node_new (JSON_NODE_ARRAY);
-                    json_builder_set_member_name (builder, "content");
-                    /* json_node_set_array refs the array, so don't add extra ref */
-                    json_node_set_array (arr_node, content);
-                    json_builder_add_value (builder, arr_node);
-                }
+    /* Contents are escaped straight into the response buffer.  Raw data
+     * the client can take out of band, as a descriptor or a download,
+     * is not encoded at all. */
+    pass_fds = self != NULL &&
+               client_accepts (self, MCP_TRANSPORT_FD_PASSING) &&
+               mcp_transport_supports_fd_passing (self->transport);
+    use_downloads = self != NULL && client_accepts (self, MCP_TRANSPORT_DOWNLOAD);
 
-                if (json_object_has_member (tool_obj, "isError"))
-                {
-                    json_builder_set_member_name (builder, "isError");
-                    json_builder_add_boolean_value (builder, json_object_get_boolean_member (tool_obj, "isError"));
-                }
-            }
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "contents");
+    mcp_json_writer_begin_array (writer);
 
-            /* Add task info */
-            json_builder_set_member_name (builder, "task");
+    for (l = contents; l != NULL; l = l->next)
+    {
+        if (mcp_resource_contents_is_bulk (l->data))
+        {
+            if (pass_fds &&
+                mcp_resource_contents_get_fd (l->data) >= 0 &&
+                write_contents_fd (self, l->data, writer))
             {
-                g_autoptr(JsonNode) task_node = mcp_task_to_json (task);
-                json_builder_add_value (builder, g_steal_pointer (&task_node));
+                continue;
             }
-
-            json_builder_end_object (builder);
-            result = json_builder_get_root (builder);
-        }
-        else
-        {
-            /* Handler is processing asynchronously */
-            /* Return task reference */
-            builder = json_builder_new ();
-            json_builder_begin_object (builder);
-            json_builder_set_member_name (builder, "task");
+            if (use_downloads && write_contents_download (self, l->data, writer))
             {
-                g_autoptr(JsonNode) task_node = mcp_task_to_json (task);
-                json_builder_add_value (builder, g_steal_pointer (&task_node));
+                continue;
             }
-            json_builder_end_object (builder);
-            result = json_builder_get_root (builder);
         }
+        mcp_resource_contents_write_json (l->data, writer);
+    }
+
+    mcp_json_writer_end_array (writer);
+    mcp_json_writer_end_object (writer);
+}
 
-        send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+static void
+send_read_response (McpServer   *self,
+                    const gchar *id,
+                    GList       *contents)
+{
+    McpJsonWriter *writer;
+
+    if (contents == NULL)
+    {
+        send_error_response (self, id,
+                             MCP_ERROR_INVALID_PARAMS,
+                             "Resource not found", NULL);
         return;
     }
 
-    /* Regular synchronous tool handler */
-    hd = g_hash_table_lookup (self->tool_handlers, name);
-    if (hd != NULL && hd->handler != NULL)
+    writer = begin_response (self, id);
+    if (writer != NULL)
     {
-        McpToolHandler handler;
-        handler = (McpToolHandler) hd->handler;
-        tool_result = handler (self, name, arguments, hd->user_data);
+        write_read_result (self, contents, writer);
+        finish_response (self, writer, id);
     }
-    else
+}
+
+static void
+read_flight_free (ReadFlight *flight)
+{
+    /* Still listed if the source was destroyed without running */
+    if (g_hash_table_lookup (flight->group->flights, flight->key) == flight)
     {
-        /* No handler - return empty result */
-        tool_result = mcp_tool_result_new (FALSE);
-        mcp_tool_result_add_text (tool_result, "");
+        g_hash_table_remove (flight->group->flights, flight->key);
     }
 
-    result = mcp_tool_result_to_json (tool_result);
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    mcp_read_group_unref (flight->group);
+    g_free (flight->key);
+    g_object_unref (flight->server);
+    registry_unref (flight->registry);
+    g_free (flight->uri);
+    g_ptr_array_unref (flight->servers);
+    g_ptr_array_unref (flight->request_ids);
+    g_free (flight);
 }
 
-static void
-handle_resources_list (McpServer  *self,
-                       McpRequest *request)
+static gboolean
+read_flight_run_cb (gpointer user_data)
 {
-    g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonNode) result = NULL;
-    GHashTableIter iter;
-    gpointer value;
+    ReadFlight *flight = user_data;
+    g_autoptr(McpJsonWriter) shared = NULL;
+    GList *contents;
+    guint i;
 
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "resources");
-    json_builder_begin_array (builder);
+    /* Late reads start a new flight */
+    g_hash_table_remove (flight->group->flights, flight->key);
 
-    g_hash_table_iter_init (&iter, self->resources);
-    while (g_hash_table_iter_next (&iter, NULL, &value))
+    contents = read_resource (flight->server, flight->registry, flight->uri);
+
+    for (i = 0; i < flight->servers->len; i++)
     {
-        McpResource *resource = MCP_RESOURCE (value);
-        g_autoptr(JsonNode) res_node = mcp_resource_to_json (resource);
-        json_builder_add_value (builder, g_steal_pointer (&res_node));
+        McpServer *server = g_ptr_array_index (flight->servers, i);
+        const gchar *id = g_ptr_array_index (flight->request_ids, i);
+        McpJsonWriter *writer;
+        const gchar *data;
+        gsize length;
+
+        if (contents == NULL || !contents_are_portable (server, contents))
+        {
+            send_read_response (server, id, contents);
+            continue;
+        }
+
+        /* Serialized once, then copied into each reply */
+        if (shared == NULL)
+        {
+            shared = mcp_json_writer_new ();
+            write_read_result (NULL, contents, shared);
+        }
+
+        writer = begin_response (server, id);
+        if (writer != NULL)
+        {
+            data = mcp_json_writer_get_data (shared, &length);
+            mcp_json_writer_raw (writer, data, length);
+            finish_response (server, writer, id);
+        }
     }
 
-    json_builder_end_array (builder);
-    json_builder_end_object (builder);
-    result = json_builder_get_root (builder);
+    g_list_free_full (contents, (GDestroyNotify) mcp_resource_contents_unref);
 
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    return G_SOURCE_REMOVE;
 }
 
-static void
-handle_resources_templates_list (McpServer  *self,
-                                 McpRequest *request)
+/*
+ * Joins the pending read of @uri by the same handler in the server's
+ * group, or starts one.  Returns %FALSE if no handler matches.
+ */
+static gboolean
+read_resource_coalesced (McpServer   *self,
+                         Registry    *registry,
+                         const gchar *uri,
+                         const gchar *request_id)
 {
-    g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonNode) result = NULL;
-    GHashTableIter iter;
-    gpointer value;
-
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "resourceTemplates");
-    json_builder_begin_array (builder);
+    McpReadGroup *group = self->read_group;
+    g_autoptr(GSource) source = NULL;
+    g_autofree gchar *key = NULL;
+    ReadFlight *flight;
+    HandlerData *hd;
 
-    g_hash_table_iter_init (&iter, self->resource_templates);
-    while (g_hash_table_iter_next (&iter, NULL, &value))
+    hd = lookup_read_handler (registry, uri);
+    if (hd == NULL)
     {
-        McpResourceTemplate *templ = MCP_RESOURCE_TEMPLATE (value);
-        g_autoptr(JsonNode) templ_node = mcp_resource_template_to_json (templ);
-        json_builder_add_value (builder, g_steal_pointer (&templ_node));
+        return FALSE;
     }
 
-    json_builder_end_array (builder);
-    json_builder_end_object (builder);
-    result = json_builder_get_root (builder);
+    key = g_strdup_printf ("%p:%p:%s", hd->handler, hd->user_data, uri);
+    flight = g_hash_table_lookup (group->flights, key);
+    if (flight != NULL)
+    {
+        g_ptr_array_add (flight->servers, g_object_ref (self));
+        g_ptr_array_add (flight->request_ids, g_strdup (request_id));
+        group->coalesced++;
+        return TRUE;
+    }
+
+    flight = g_new0 (ReadFlight, 1);
+    flight->group = mcp_read_group_ref (group);
+    flight->key = g_steal_pointer (&key);
+    flight->server = g_object_ref (self);
+    flight->registry = registry_ref (registry);
+    flight->uri = g_strdup (uri);
+    flight->servers = g_ptr_array_new_with_free_func (g_object_unref);
+    flight->request_ids = g_ptr_array_new_with_free_func (g_free);
+    g_ptr_array_add (flight->servers, g_object_ref (self));
+    g_ptr_array_add (flight->request_ids, g_strdup (request_id));
+    g_hash_table_insert (group->flights, flight->key, flight);
+
+    /* Default priority: other sockets already readable are dispatched
+     * in this iteration and join, but a busy server still gets to it
+     * in the next one */
+    source = g_idle_source_new ();
+    g_source_set_priority (source, G_PRIORITY_DEFAULT);
+    g_source_set_name (source, "McpServer coalesced read");
+    g_source_set_callback (source, read_flight_run_cb, flight,
+                           (GDestroyNotify) read_flight_free);
+    g_source_attach (source, self->context);
 
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    return TRUE;
 }
 
 static void
-handle_resources_read (McpServer  *self,
-                       McpRequest *request)
+handle_resources_read (McpServer     *self,
+                       ServerRequest *request)
 {
     JsonObject *params;
     const gchar *uri;
-    HandlerData *hd;
-    McpResourceHandler handler;
-    GList *contents = NULL;
-    g_autoptr(JsonBuilder) builder = NULL;
-    g_autoptr(JsonNode) result = NULL;
-    GList *l;
+    g_autoptr(Registry) registry = NULL;
+    GList *contents;
 
     params = get_request_params_object (request);
     if (params == NULL || !json_object_has_member (params, "uri"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing resource URI", NULL);
         return;
@@ -1718,71 +5276,35 @@ handle_resources_read (McpServer  *self,
 
     uri = json_object_get_string_member (params, "uri");
 
-    g_signal_emit (self, signals[SIGNAL_RESOURCE_READ], 0, uri);
-
-    /* First try direct resource handlers */
-    hd = g_hash_table_lookup (self->resource_handlers, uri);
-    if (hd != NULL && hd->handler != NULL)
-    {
-        handler = (McpResourceHandler) hd->handler;
-        contents = handler (self, uri, hd->user_data);
-    }
-
-    /* If no direct handler, try template matching */
-    if (contents == NULL)
+    /* Unknown URIs are refused before they can take tokens or make buckets */
+    registry = registry_acquire (self);
+    if (!resource_is_known (registry, uri))
     {
-        GHashTableIter iter;
-        const gchar *template_uri;
-        McpResourceTemplate *templ;
-
-        g_hash_table_iter_init (&iter, self->resource_templates);
-        while (g_hash_table_iter_next (&iter, (gpointer *)&template_uri, (gpointer *)&templ))
-        {
-            if (uri_matches_template (uri, template_uri))
-            {
-                hd = g_hash_table_lookup (self->template_handlers, template_uri);
-                if (hd != NULL && hd->handler != NULL)
-                {
-                    handler = (McpResourceHandler) hd->handler;
-                    contents = handler (self, uri, hd->user_data);
-                    break;
-                }
-            }
-        }
+        send_read_response (self, request->id, NULL);
+        return;
     }
 
-    if (contents == NULL)
+    if (!check_rate_limit (self, request->id, uri, TRUE))
     {
-        send_error_response (self, mcp_request_get_id (request),
-                             MCP_ERROR_INVALID_PARAMS,
-                             "Resource not found", NULL);
         return;
     }
 
-    builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "contents");
-    json_builder_begin_array (builder);
+    g_signal_emit (self, signals[SIGNAL_RESOURCE_READ], 0, uri);
 
-    for (l = contents; l != NULL; l = l->next)
+    if (self->read_group != NULL &&
+        read_resource_coalesced (self, registry, uri, request->id))
     {
-        McpResourceContents *c = l->data;
-        g_autoptr(JsonNode) c_node = mcp_resource_contents_to_json (c);
-        json_builder_add_value (builder, g_steal_pointer (&c_node));
+        return;
     }
 
-    json_builder_end_array (builder);
-    json_builder_end_object (builder);
-    result = json_builder_get_root (builder);
-
+    contents = read_resource (self, registry, uri);
+    send_read_response (self, request->id, contents);
     g_list_free_full (contents, (GDestroyNotify) mcp_resource_contents_unref);
-
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
 }
 
 static void
-handle_resources_subscribe (McpServer  *self,
-                            McpRequest *request)
+handle_resources_subscribe (McpServer     *self,
+                            ServerRequest *request)
 {
     JsonObject *params;
     const gchar *uri;
@@ -1790,7 +5312,7 @@ handle_resources_subscribe (McpServer  *self,
     params = get_request_params_object (request);
     if (params == NULL || !json_object_has_member (params, "uri"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing resource URI", NULL);
         return;
@@ -1798,14 +5320,15 @@ handle_resources_subscribe (McpServer  *self,
 
     uri = json_object_get_string_member (params, "uri");
 
-    g_hash_table_insert (self->subscriptions, g_strdup (uri), GINT_TO_POINTER (TRUE));
+    g_hash_table_insert (lazy_table (&self->subscriptions, NULL),
+                         g_strdup (uri), GINT_TO_POINTER (TRUE));
 
-    send_response (self, mcp_request_get_id (request), json_node_new (JSON_NODE_OBJECT));
+    send_response (self, request->id, json_node_new (JSON_NODE_OBJECT));
 }
 
 static void
-handle_resources_unsubscribe (McpServer  *self,
-                              McpRequest *request)
+handle_resources_unsubscribe (McpServer     *self,
+                              ServerRequest *request)
 {
     JsonObject *params;
     const gchar *uri;
@@ -1813,7 +5336,7 @@ handle_resources_unsubscribe (McpServer  *self,
     params = get_request_params_object (request);
     if (params == NULL || !json_object_has_member (params, "uri"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing resource URI", NULL);
         return;
@@ -1821,14 +5344,17 @@ handle_resources_unsubscribe (McpServer  *self,
 
     uri = json_object_get_string_member (params, "uri");
 
-    g_hash_table_remove (self->subscriptions, uri);
+    if (self->subscriptions != NULL)
+    {
+        g_hash_table_remove (self->subscriptions, uri);
+    }
 
-    send_response (self, mcp_request_get_id (request), json_node_new (JSON_NODE_OBJECT));
+    send_response (self, request->id, json_node_new (JSON_NODE_OBJECT));
 }
 
 static void
-handle_prompts_list (McpServer  *self,
-                     McpRequest *request)
+handle_prompts_list (McpServer     *self,
+                     ServerRequest *request)
 {
     g_autoptr(JsonBuilder) builder = NULL;
     g_autoptr(JsonNode) result = NULL;
@@ -1840,7 +5366,7 @@ handle_prompts_list (McpServer  *self,
     json_builder_set_member_name (builder, "prompts");
     json_builder_begin_array (builder);
 
-    g_hash_table_iter_init (&iter, self->prompts);
+    g_hash_table_iter_init (&iter, registry_peek (self)->prompts);
     while (g_hash_table_iter_next (&iter, NULL, &value))
     {
         McpPrompt *prompt = MCP_PROMPT (value);
@@ -1852,12 +5378,12 @@ handle_prompts_list (McpServer  *self,
     json_builder_end_object (builder);
     result = json_builder_get_root (builder);
 
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    send_response (self, request->id, g_steal_pointer (&result));
 }
 
 static void
-handle_prompts_get (McpServer  *self,
-                    McpRequest *request)
+handle_prompts_get (McpServer     *self,
+                    ServerRequest *request)
 {
     JsonObject *params;
     const gchar *name;
@@ -1865,13 +5391,14 @@ handle_prompts_get (McpServer  *self,
     GHashTable *arguments = NULL;
     HandlerData *hd;
     McpPromptHandler handler;
+    g_autoptr(Registry) registry = NULL;
     g_autoptr(McpPromptResult) prompt_result = NULL;
     g_autoptr(JsonNode) result = NULL;
 
     params = get_request_params_object (request);
     if (params == NULL || !json_object_has_member (params, "name"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing prompt name", NULL);
         return;
@@ -1879,9 +5406,11 @@ handle_prompts_get (McpServer  *self,
 
     name = json_object_get_string_member (params, "name");
 
-    if (!g_hash_table_contains (self->prompts, name))
+    registry = registry_acquire (self);
+
+    if (!g_hash_table_contains (registry->prompts, name))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_METHOD_NOT_FOUND,
                              "Unknown prompt", NULL);
         return;
@@ -1908,7 +5437,7 @@ handle_prompts_get (McpServer  *self,
 
     g_signal_emit (self, signals[SIGNAL_PROMPT_REQUESTED], 0, name, arguments);
 
-    hd = g_hash_table_lookup (self->prompt_handlers, name);
+    hd = g_hash_table_lookup (registry->prompt_handlers, name);
     if (hd != NULL && hd->handler != NULL)
     {
         handler = (McpPromptHandler) hd->handler;
@@ -1926,19 +5455,19 @@ handle_prompts_get (McpServer  *self,
     }
 
     result = mcp_prompt_result_to_json (prompt_result);
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    send_response (self, request->id, g_steal_pointer (&result));
 }
 
 static void
-handle_ping (McpServer  *self,
-             McpRequest *request)
+handle_ping (McpServer     *self,
+             ServerRequest *request)
 {
-    send_response (self, mcp_request_get_id (request), json_node_new (JSON_NODE_OBJECT));
+    send_response (self, request->id, json_node_new (JSON_NODE_OBJECT));
 }
 
 static void
-handle_completion_complete (McpServer  *self,
-                            McpRequest *request)
+handle_completion_complete (McpServer     *self,
+                            ServerRequest *request)
 {
     JsonObject *params;
     JsonObject *ref;
@@ -1954,7 +5483,7 @@ handle_completion_complete (McpServer  *self,
     params = get_request_params_object (request);
     if (params == NULL)
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing params", NULL);
         return;
@@ -1963,7 +5492,7 @@ handle_completion_complete (McpServer  *self,
     /* Parse ref object */
     if (!json_object_has_member (params, "ref"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing ref", NULL);
         return;
@@ -1972,7 +5501,7 @@ handle_completion_complete (McpServer  *self,
     ref = json_object_get_object_member (params, "ref");
     if (ref == NULL || !json_object_has_member (ref, "type"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Invalid ref", NULL);
         return;
@@ -1985,7 +5514,7 @@ handle_completion_complete (McpServer  *self,
     {
         if (!json_object_has_member (ref, "name"))
         {
-            send_error_response (self, mcp_request_get_id (request),
+            send_error_response (self, request->id,
                                  MCP_ERROR_INVALID_PARAMS,
                                  "Missing prompt name", NULL);
             return;
@@ -1996,7 +5525,7 @@ handle_completion_complete (McpServer  *self,
     {
         if (!json_object_has_member (ref, "uri"))
         {
-            send_error_response (self, mcp_request_get_id (request),
+            send_error_response (self, request->id,
                                  MCP_ERROR_INVALID_PARAMS,
                                  "Missing resource uri", NULL);
             return;
@@ -2005,7 +5534,7 @@ handle_completion_complete (McpServer  *self,
     }
     else
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Unknown ref type", NULL);
         return;
@@ -2014,7 +5543,7 @@ handle_completion_complete (McpServer  *self,
     /* Parse argument object */
     if (!json_object_has_member (params, "argument"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing argument", NULL);
         return;
@@ -2023,7 +5552,7 @@ handle_completion_complete (McpServer  *self,
     argument = json_object_get_object_member (params, "argument");
     if (argument == NULL || !json_object_has_member (argument, "value"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Invalid argument", NULL);
         return;
@@ -2050,22 +5579,70 @@ handle_completion_complete (McpServer  *self,
     }
 
     result = mcp_completion_result_to_json (completion_result);
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    send_response (self, request->id, g_steal_pointer (&result));
 }
 
 /* Forward declarations for Tasks API handlers */
-static void handle_tasks_get    (McpServer *self, McpRequest *request);
-static void handle_tasks_result (McpServer *self, McpRequest *request);
-static void handle_tasks_cancel (McpServer *self, McpRequest *request);
-static void handle_tasks_list   (McpServer *self, McpRequest *request);
+static void handle_tasks_get    (McpServer *self, ServerRequest *request);
+static void handle_tasks_result (McpServer *self, ServerRequest *request);
+static void handle_tasks_cancel (McpServer *self, ServerRequest *request);
+static void handle_tasks_list   (McpServer *self, ServerRequest *request);
+
+/*
+ * Remembers the progress token a request carries in its _meta, so that
+ * its response can be kept behind its progress notifications.
+ */
+static void
+track_progress_token (McpServer     *self,
+                      ServerRequest *request)
+{
+    JsonObject *params;
+    JsonNode *meta;
+    JsonNode *token;
+    gchar *text;
+
+    params = get_request_params_object (request);
+    if (request->id == NULL || params == NULL)
+    {
+        return;
+    }
+
+    meta = json_object_get_member (params, "_meta");
+    if (meta == NULL || !JSON_NODE_HOLDS_OBJECT (meta))
+    {
+        return;
+    }
+
+    token = json_object_get_member (json_node_get_object (meta), "progressToken");
+    if (token == NULL || !JSON_NODE_HOLDS_VALUE (token))
+    {
+        return;
+    }
+
+    switch (json_node_get_value_type (token))
+    {
+        case G_TYPE_STRING:
+            text = g_strdup (json_node_get_string (token));
+            break;
+        case G_TYPE_INT64:
+            text = g_strdup_printf ("%" G_GINT64_FORMAT, json_node_get_int (token));
+            break;
+        default:
+            return;
+    }
+
+    g_hash_table_insert (lazy_table (&self->progress_tokens, g_free),
+                         text, g_strdup (request->id));
+}
 
 static void
-handle_request (McpServer  *self,
-                McpRequest *request)
+handle_request (McpServer     *self,
+                ServerRequest *request)
 {
     const gchar *method;
 
-    method = mcp_request_get_method (request);
+    method = request->method;
+    track_progress_token (self, request);
 
     if (g_strcmp0 (method, "initialize") == 0)
     {
@@ -2135,7 +5712,7 @@ handle_request (McpServer  *self,
     }
     else
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_METHOD_NOT_FOUND,
                              "Unknown method", NULL);
     }
@@ -2310,32 +5887,16 @@ mcp_server_add_async_tool (McpServer          *self,
                            gpointer            user_data,
                            GDestroyNotify      destroy)
 {
-    const gchar *name;
-    HandlerData *hd;
+    UpdateOp op = { 0, };
 
     g_return_if_fail (MCP_IS_SERVER (self));
     g_return_if_fail (MCP_IS_TOOL (tool));
 
-    name = mcp_tool_get_name (tool);
-
-    /* Add tool to the regular tools list */
-    g_hash_table_insert (self->tools, g_strdup (name), g_object_ref (tool));
-
-    /* Add async handler */
-    if (handler != NULL)
-    {
-        hd = g_new0 (HandlerData, 1);
-        hd->handler = handler;
-        hd->user_data = user_data;
-        hd->destroy = destroy;
-        g_hash_table_insert (self->async_tool_handlers, g_strdup (name), hd);
-    }
-
-    /* Enable tools capability if not already */
-    if (!mcp_server_capabilities_get_tools (self->capabilities))
-    {
-        mcp_server_capabilities_set_tools (self->capabilities, TRUE, TRUE);
-    }
+    /* Listed with the regular tools, dispatched through a task */
+    update_op_init (&op, UPDATE_ADD_ASYNC_TOOL, mcp_tool_get_name (tool), tool,
+                    handler, user_data, destroy);
+    registry_update_one (self, &op);
+    update_op_clear (&op);
 }
 
 /**
@@ -2354,7 +5915,7 @@ mcp_server_get_task (McpServer   *self,
     g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
     g_return_val_if_fail (task_id != NULL, NULL);
 
-    return g_hash_table_lookup (self->tasks, task_id);
+    return lazy_table_lookup (self->tasks, task_id);
 }
 
 /**
@@ -2374,6 +5935,11 @@ mcp_server_list_tasks (McpServer *self)
 
     g_return_val_if_fail (MCP_IS_SERVER (self), NULL);
 
+    if (self->tasks == NULL)
+    {
+        return NULL;
+    }
+
     g_hash_table_iter_init (&iter, self->tasks);
     while (g_hash_table_iter_next (&iter, NULL, &value))
     {
@@ -2435,7 +6001,16 @@ mcp_server_complete_task (McpServer     *self,
     g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
     g_return_val_if_fail (task_id != NULL, FALSE);
 
-    task = g_hash_table_lookup (self->tasks, task_id);
+    if (!on_owner_thread (self))
+    {
+        OutboxItem *item = outbox_item_new (OUTBOX_COMPLETE_TASK, task_id, error_message);
+
+        item->result = result;
+        outbox_push (self, item);
+        return TRUE;
+    }
+
+    task = lazy_table_lookup (self->tasks, task_id);
     if (task == NULL)
     {
         if (result != NULL)
@@ -2448,7 +6023,9 @@ mcp_server_complete_task (McpServer     *self,
     /* Store the result */
     if (result != NULL)
     {
-        g_hash_table_insert (self->task_results, g_strdup (task_id), result);
+        g_hash_table_insert (lazy_table (&self->task_results,
+                                         (GDestroyNotify) mcp_tool_result_unref),
+                             g_strdup (task_id), result);
     }
 
     /* Update task status */
@@ -2464,6 +6041,7 @@ mcp_server_complete_task (McpServer     *self,
     }
 
     mcp_task_update_timestamp (task);
+    g_object_set_data (G_OBJECT (task), TASK_REGISTRY_KEY, NULL);
 
     /* Notify client */
     mcp_server_notify_task_status (self, task);
@@ -2511,7 +6089,16 @@ mcp_server_update_task_status (McpServer     *self,
     g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
     g_return_val_if_fail (task_id != NULL, FALSE);
 
-    task = g_hash_table_lookup (self->tasks, task_id);
+    if (!on_owner_thread (self))
+    {
+        OutboxItem *item = outbox_item_new (OUTBOX_UPDATE_TASK, task_id, message);
+
+        item->value = status;
+        outbox_push (self, item);
+        return TRUE;
+    }
+
+    task = lazy_table_lookup (self->tasks, task_id);
     if (task == NULL)
     {
         return FALSE;
@@ -2548,7 +6135,7 @@ mcp_server_cancel_task (McpServer   *self,
     g_return_val_if_fail (MCP_IS_SERVER (self), FALSE);
     g_return_val_if_fail (task_id != NULL, FALSE);
 
-    task = g_hash_table_lookup (self->tasks, task_id);
+    task = lazy_table_lookup (self->tasks, task_id);
     if (task == NULL)
     {
         return FALSE;
@@ -2557,6 +6144,7 @@ mcp_server_cancel_task (McpServer   *self,
     mcp_task_set_status (task, MCP_TASK_STATUS_CANCELLED);
     mcp_task_set_status_message (task, "Task cancelled by request");
     mcp_task_update_timestamp (task);
+    g_object_set_data (G_OBJECT (task), TASK_REGISTRY_KEY, NULL);
 
     /* Notify client */
     mcp_server_notify_task_status (self, task);
@@ -2567,41 +6155,45 @@ mcp_server_cancel_task (McpServer   *self,
 /* Task request handlers */
 
 static void
-handle_tasks_get (McpServer  *self,
-                  McpRequest *request)
+handle_tasks_get (McpServer     *self,
+                  ServerRequest *request)
 {
     JsonObject *params;
     const gchar *task_id;
     McpTask *task;
-    g_autoptr(JsonNode) result = NULL;
+    McpJsonWriter *writer;
 
     params = get_request_params_object (request);
     if (params == NULL || !json_object_has_member (params, "taskId"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing taskId", NULL);
         return;
     }
 
     task_id = json_object_get_string_member (params, "taskId");
-    task = g_hash_table_lookup (self->tasks, task_id);
+    task = lazy_table_lookup (self->tasks, task_id);
 
     if (task == NULL)
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Task not found", NULL);
         return;
     }
 
-    result = mcp_task_to_json (task);
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    writer = begin_response (self, request->id);
+    if (writer != NULL)
+    {
+        mcp_task_write_json (task, writer);
+        finish_response (self, writer, request->id);
+    }
 }
 
 static void
-handle_tasks_result (McpServer  *self,
-                     McpRequest *request)
+handle_tasks_result (McpServer     *self,
+                     ServerRequest *request)
 {
     JsonObject *params;
     const gchar *task_id;
@@ -2612,18 +6204,18 @@ handle_tasks_result (McpServer  *self,
     params = get_request_params_object (request);
     if (params == NULL || !json_object_has_member (params, "taskId"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing taskId", NULL);
         return;
     }
 
     task_id = json_object_get_string_member (params, "taskId");
-    task = g_hash_table_lookup (self->tasks, task_id);
+    task = lazy_table_lookup (self->tasks, task_id);
 
     if (task == NULL)
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Task not found", NULL);
         return;
@@ -2633,13 +6225,13 @@ handle_tasks_result (McpServer  *self,
     if (mcp_task_get_status (task) != MCP_TASK_STATUS_COMPLETED &&
         mcp_task_get_status (task) != MCP_TASK_STATUS_FAILED)
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Task not yet completed", NULL);
         return;
     }
 
-    result = g_hash_table_lookup (self->task_results, task_id);
+    result = lazy_table_lookup (self->task_results, task_id);
     if (result != NULL)
     {
         result_node = mcp_tool_result_to_json (result);
@@ -2651,12 +6243,12 @@ handle_tasks_result (McpServer  *self,
         result_node = mcp_tool_result_to_json (empty);
     }
 
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result_node));
+    send_response (self, request->id, g_steal_pointer (&result_node));
 }
 
 static void
-handle_tasks_cancel (McpServer  *self,
-                     McpRequest *request)
+handle_tasks_cancel (McpServer     *self,
+                     ServerRequest *request)
 {
     JsonObject *params;
     const gchar *task_id;
@@ -2664,7 +6256,7 @@ handle_tasks_cancel (McpServer  *self,
     params = get_request_params_object (request);
     if (params == NULL || !json_object_has_member (params, "taskId"))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Missing taskId", NULL);
         return;
@@ -2674,18 +6266,18 @@ handle_tasks_cancel (McpServer  *self,
 
     if (!mcp_server_cancel_task (self, task_id))
     {
-        send_error_response (self, mcp_request_get_id (request),
+        send_error_response (self, request->id,
                              MCP_ERROR_INVALID_PARAMS,
                              "Task not found", NULL);
         return;
     }
 
-    send_response (self, mcp_request_get_id (request), json_node_new (JSON_NODE_OBJECT));
+    send_response (self, request->id, json_node_new (JSON_NODE_OBJECT));
 }
 
 static void
-handle_tasks_list (McpServer  *self,
-                   McpRequest *request)
+handle_tasks_list (McpServer     *self,
+                   ServerRequest *request)
 {
     g_autoptr(JsonBuilder) builder = NULL;
     g_autoptr(JsonNode) result = NULL;
@@ -2697,19 +6289,22 @@ handle_tasks_list (McpServer  *self,
     json_builder_set_member_name (builder, "tasks");
     json_builder_begin_array (builder);
 
-    g_hash_table_iter_init (&iter, self->tasks);
-    while (g_hash_table_iter_next (&iter, NULL, &value))
+    if (self->tasks != NULL)
     {
-        McpTask *task = MCP_TASK (value);
-        g_autoptr(JsonNode) task_node = mcp_task_to_json (task);
-        json_builder_add_value (builder, g_steal_pointer (&task_node));
+        g_hash_table_iter_init (&iter, self->tasks);
+        while (g_hash_table_iter_next (&iter, NULL, &value))
+        {
+            McpTask *task = MCP_TASK (value);
+            g_autoptr(JsonNode) task_node = mcp_task_to_json (task);
+            json_builder_add_value (builder, g_steal_pointer (&task_node));
+        }
     }
 
     json_builder_end_array (builder);
     json_builder_end_object (builder);
     result = json_builder_get_root (builder);
 
-    send_response (self, mcp_request_get_id (request), g_steal_pointer (&result));
+    send_response (self, request->id, g_steal_pointer (&result));
 }
 
 /* ========================================================================== */
@@ -108,6 +108,25 @@ typedef McpToolResult *(*McpAsyncToolHandler) (McpServer   *server,
                                                JsonObject  *arguments,
                                                gpointer     user_data);
 
+/**
+ * McpToolKeyFunc:
+ * @server: the #McpServer
+ * @name: the tool name
+ * @arguments: (nullable): the arguments
+ * @user_data: user data
+ *
+ * Callback function naming the resource a tool call works on, for
+ * scheduling with #McpServer:concurrent-tools.  Calls that return the
+ * same key are ordered against each other across every server in the
+ * process; calls that return %NULL are ordered within their session.
+ *
+ * Returns: (transfer full) (nullable): the resource key, or %NULL
+ */
+typedef gchar *(*McpToolKeyFunc) (McpServer   *server,
+                                  const gchar *name,
+                                  JsonObject  *arguments,
+                                  gpointer     user_data);
+
 /**
  * McpCompletionHandler:
  * @server: the #McpServer
@@ -182,6 +201,193 @@ void mcp_server_set_instructions (McpServer   *self,
  */
 const gchar *mcp_server_get_instructions (McpServer *self);
 
+/**
+ * mcp_server_set_list_changed_delay:
+ * @self: an #McpServer
+ * @delay_ms: the coalescing window, in milliseconds
+ *
+ * Sets how long list_changed notifications are held after the first
+ * change so that a burst of changes costs the client one re-list per
+ * list.  With 0 (the default), changes made during the same main loop
+ * iteration are coalesced.
+ */
+void mcp_server_set_list_changed_delay (McpServer *self,
+                                        guint      delay_ms);
+
+/**
+ * mcp_server_get_list_changed_delay:
+ * @self: an #McpServer
+ *
+ * Gets the list_changed coalescing window.
+ *
+ * Returns: the window in milliseconds
+ */
+guint mcp_server_get_list_changed_delay (McpServer *self);
+
+/**
+ * mcp_server_set_concurrent_tools:
+ * @self: an #McpServer
+ * @concurrent: whether to schedule tool calls by their annotations
+ *
+ * Sets whether tools/call requests for tools with a synchronous
+ * handler run on a worker pool, scheduled by the tool's annotations,
+ * instead of on the server's main context.
+ *
+ * Read-only and non-destructive tools run concurrently with each
+ * other.  Destructive tools (the default for a tool that is not
+ * read-only) run alone: they wait for the calls before them to finish
+ * and hold back the calls after them.  This ordering is per session,
+ * or per resource key when a #McpToolKeyFunc is set with
+ * mcp_server_set_tool_key_func().  Calls start in arrival order, so a
+ * destructive call is never starved by a stream of readers.
+ *
+ * Calls to a read-only or idempotent tool with the same arguments as a
+ * call still in flight on the same session are not run again; they get
+ * the result of the call in flight.
+ *
+ * Handlers then run on worker threads: they may call the functions
+ * documented as callable from any thread, such as
+ * mcp_server_send_progress(), and must not touch other server state.
+ * Async tool handlers and mcp_server_invoke_tool() are not affected.
+ */
+void mcp_server_set_concurrent_tools (McpServer *self,
+                                      gboolean   concurrent);
+
+/**
+ * mcp_server_get_concurrent_tools:
+ * @self: an #McpServer
+ *
+ * Gets whether tool calls are scheduled by their annotations.
+ *
+ * Returns: %TRUE if tool handlers run on a worker pool
+ */
+gboolean mcp_server_get_concurrent_tools (McpServer *self);
+
+/**
+ * mcp_server_set_use_arena:
+ * @self: an #McpServer
+ * @use_arena: whether to dispatch requests from a per-message arena
+ *
+ * Sets whether well-formed requests are read straight into a scratch
+ * arena borrowed from the thread (the default), or go through
+ * #McpRequest like every other message.  Both behave the same; turning
+ * the arena off is meant for measuring what it saves.
+ */
+void mcp_server_set_use_arena (McpServer *self,
+                               gboolean   use_arena);
+
+/**
+ * mcp_server_get_use_arena:
+ * @self: an #McpServer
+ *
+ * Gets whether requests are dispatched from a per-message arena.
+ *
+ * Returns: %TRUE if the arena is used
+ */
+gboolean mcp_server_get_use_arena (McpServer *self);
+
+/**
+ * mcp_server_set_tool_key_func:
+ * @self: an #McpServer
+ * @func: (scope notified) (nullable): the key function
+ * @user_data: (closure): user data for @func
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Sets the function naming the resource each tool call works on when
+ * #McpServer:concurrent-tools is enabled.  It is called on the
+ * server's main context as each call arrives.  Servers that return the
+ * same key for, say, the same file path share the ordering for that
+ * file, so two sessions cannot run destructive calls on it at once.
+ */
+void mcp_server_set_tool_key_func (McpServer      *self,
+                                   McpToolKeyFunc  func,
+                                   gpointer        user_data,
+                                   GDestroyNotify  destroy);
+
+/**
+ * mcp_server_set_tool_cache:
+ * @self: an #McpServer
+ * @ttl_ms: how long a result stays cached, in milliseconds, or 0 to
+ *   keep results until they are evicted or invalidated
+ * @max_bytes: the most memory cached results may use, or 0 to disable
+ *   the cache
+ *
+ * Caches the results of tools whose annotations mark them read-only or
+ * idempotent.  A tools/call request with the same tool name and
+ * arguments as a cached result is answered without running the
+ * handler.  Arguments are compared after sorting object members and
+ * writing integral numbers as integers, so `{"a": 1, "b": 2}` and
+ * `{"b": 2.0, "a": 1}` share a result.  Error results are not cached.
+ *
+ * When @max_bytes would be exceeded, the least recently used results
+ * are evicted.  Adding or removing tools drops every cached result.
+ * Disabling the cache frees it and its statistics.
+ * mcp_server_invoke_tool() and async tool handlers never use the cache.
+ */
+void mcp_server_set_tool_cache (McpServer *self,
+                                guint      ttl_ms,
+                                gsize      max_bytes);
+
+/**
+ * mcp_server_get_tool_cache_size:
+ * @self: an #McpServer
+ *
+ * Gets the memory used by cached tool results, including keys and
+ * bookkeeping.
+ *
+ * Returns: the size in bytes, or 0 if the cache is disabled
+ */
+gsize mcp_server_get_tool_cache_size (McpServer *self);
+
+/**
+ * mcp_server_invalidate_tool_results:
+ * @self: an #McpServer
+ * @name: (nullable): a tool name, or %NULL for every tool
+ *
+ * Drops the cached results of @name, e.g. after a destructive tool
+ * changed the data it reads.  A call of @name already running when
+ * this is called does not cache its result either.
+ *
+ * This function may be called from any thread; from other threads the
+ * results are dropped on the server's main context shortly after.
+ */
+void mcp_server_invalidate_tool_results (McpServer   *self,
+                                         const gchar *name);
+
+/**
+ * mcp_server_invalidate_tool_result:
+ * @self: an #McpServer
+ * @name: a tool name
+ * @arguments: (nullable): the call's arguments
+ *
+ * Drops the cached result of calling @name with @arguments, compared
+ * as described for mcp_server_set_tool_cache().
+ *
+ * This function may be called from any thread.
+ */
+void mcp_server_invalidate_tool_result (McpServer   *self,
+                                        const gchar *name,
+                                        JsonObject  *arguments);
+
+/**
+ * mcp_server_get_tool_cache_stats:
+ * @self: an #McpServer
+ * @name: a tool name
+ * @hits: (out) (optional): return location for the number of calls
+ *   answered from the cache
+ * @misses: (out) (optional): return location for the number of calls
+ *   that ran the handler
+ *
+ * Gets how often calls to @name were answered from the cache since it
+ * was enabled.
+ *
+ * Returns: %TRUE if @name was looked up in the cache at least once
+ */
+gboolean mcp_server_get_tool_cache_stats (McpServer   *self,
+                                          const gchar *name,
+                                          guint64     *hits,
+                                          guint64     *misses);
+
 /* Transport management */
 
 /**
@@ -271,6 +477,25 @@ void mcp_server_add_tool (McpServer      *self,
                           gpointer        user_data,
                           GDestroyNotify  destroy);
 
+/**
+ * mcp_server_add_tools:
+ * @self: an #McpServer
+ * @tools: (element-type McpTool): the tools to add
+ * @handler: (scope notified) (nullable): the handler for all of @tools
+ * @user_data: (closure): user data for @handler
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Adds several tools that share one handler in a single atomic
+ * update, as mcp_server_commit_update() does, and notifies the client
+ * once.  @destroy is called when none of the tools uses the handler
+ * any more.
+ */
+void mcp_server_add_tools (McpServer      *self,
+                           GPtrArray      *tools,
+                           McpToolHandler  handler,
+                           gpointer        user_data,
+                           GDestroyNotify  destroy);
+
 /**
  * mcp_server_remove_tool:
  * @self: an #McpServer
@@ -342,6 +567,24 @@ void mcp_server_add_resource (McpServer          *self,
                               gpointer            user_data,
                               GDestroyNotify      destroy);
 
+/**
+ * mcp_server_add_resources:
+ * @self: an #McpServer
+ * @resources: (element-type McpResource): the resources to add
+ * @handler: (scope notified) (nullable): the handler for all of @resources
+ * @user_data: (closure): user data for @handler
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Adds several resources that share one handler in a single atomic
+ * update and notifies the client once.  The handler is told which
+ * URI is being read, so one handler can serve them all.
+ */
+void mcp_server_add_resources (McpServer          *self,
+                               GPtrArray          *resources,
+                               McpResourceHandler  handler,
+                               gpointer            user_data,
+                               GDestroyNotify      destroy);
+
 /**
  * mcp_server_add_resource_template:
  * @self: an #McpServer
@@ -396,6 +639,8 @@ GList *mcp_server_list_resource_templates (McpServer *self);
  * @uri: the resource URI
  *
  * Notifies the client that a resource has been updated.
+ *
+ * May be called from any thread; see mcp_server_complete_task().
  */
 void mcp_server_notify_resource_updated (McpServer   *self,
                                          const gchar *uri);
@@ -440,13 +685,442 @@ gboolean mcp_server_remove_prompt (McpServer   *self,
  */
 GList *mcp_server_list_prompts (McpServer *self);
 
+/* Registry updates */
+
+/**
+ * McpServerUpdate:
+ *
+ * A batch of tool, resource and prompt changes that
+ * mcp_server_commit_update() applies to a server in one step.
+ *
+ * Clients never see part of an update: the server builds a new
+ * snapshot of its registry off to the side and swaps it in with a
+ * single atomic store, so requests being dispatched keep reading the
+ * previous snapshot and calls already running finish against it.
+ * Entries added with the same name or URI as an existing one replace
+ * it, handler and all.
+ *
+ * An update only records the changes, so it can be committed to any
+ * number of servers (for example every session of an
+ * #McpUnixSocketServer) and the handlers' @user_data is shared
+ * between them.  Each handler's @destroy runs once neither the update
+ * nor any server snapshot refers to it any more, possibly on another
+ * thread.
+ */
+typedef struct _McpServerUpdate McpServerUpdate;
+
+/**
+ * mcp_server_update_new:
+ *
+ * Creates an empty update.
+ *
+ * Returns: (transfer full): a new #McpServerUpdate
+ */
+McpServerUpdate *mcp_server_update_new (void);
+
+/**
+ * mcp_server_update_free:
+ * @update: (nullable): an #McpServerUpdate
+ *
+ * Frees @update.  Servers it was committed to are not affected.
+ */
+void mcp_server_update_free (McpServerUpdate *update);
+
+/**
+ * mcp_server_update_add_tool:
+ * @update: an #McpServerUpdate
+ * @tool: (transfer none): the #McpTool to add
+ * @handler: (scope notified) (nullable): the handler function
+ * @user_data: (closure): user data for @handler
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Records adding or replacing a tool, as mcp_server_add_tool() would.
+ */
+void mcp_server_update_add_tool (McpServerUpdate *update,
+                                 McpTool         *tool,
+                                 McpToolHandler   handler,
+                                 gpointer         user_data,
+                                 GDestroyNotify   destroy);
+
+/**
+ * mcp_server_update_add_async_tool:
+ * @update: an #McpServerUpdate
+ * @tool: (transfer none): the #McpTool to add
+ * @handler: (scope notified) (nullable): the async handler function
+ * @user_data: (closure): user data for @handler
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Records adding or replacing a Tasks API tool, as
+ * mcp_server_add_async_tool() would.
+ */
+void mcp_server_update_add_async_tool (McpServerUpdate     *update,
+                                       McpTool             *tool,
+                                       McpAsyncToolHandler  handler,
+                                       gpointer             user_data,
+                                       GDestroyNotify       destroy);
+
+/**
+ * mcp_server_update_remove_tool:
+ * @update: an #McpServerUpdate
+ * @name: the tool name
+ *
+ * Records removing a tool.  Removing a tool the server does not have
+ * is not an error.
+ */
+void mcp_server_update_remove_tool (McpServerUpdate *update,
+                                    const gchar     *name);
+
+/**
+ * mcp_server_update_add_resource:
+ * @update: an #McpServerUpdate
+ * @resource: (transfer none): the #McpResource to add
+ * @handler: (scope notified) (nullable): the handler function
+ * @user_data: (closure): user data for @handler
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Records adding or replacing a resource.
+ */
+void mcp_server_update_add_resource (McpServerUpdate    *update,
+                                     McpResource        *resource,
+                                     McpResourceHandler  handler,
+                                     gpointer            user_data,
+                                     GDestroyNotify      destroy);
+
+/**
+ * mcp_server_update_remove_resource:
+ * @update: an #McpServerUpdate
+ * @uri: the resource URI
+ *
+ * Records removing a resource.
+ */
+void mcp_server_update_remove_resource (McpServerUpdate *update,
+                                        const gchar     *uri);
+
+/**
+ * mcp_server_update_add_resource_template:
+ * @update: an #McpServerUpdate
+ * @templ: (transfer none): the #McpResourceTemplate to add
+ * @handler: (scope notified) (nullable): the handler function
+ * @user_data: (closure): user data for @handler
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Records adding or replacing a resource template.
+ */
+void mcp_server_update_add_resource_template (McpServerUpdate     *update,
+                                              McpResourceTemplate *templ,
+                                              McpResourceHandler   handler,
+                                              gpointer             user_data,
+                                              GDestroyNotify       destroy);
+
+/**
+ * mcp_server_update_remove_resource_template:
+ * @update: an #McpServerUpdate
+ * @uri_template: the URI template
+ *
+ * Records removing a resource template.
+ */
+void mcp_server_update_remove_resource_template (McpServerUpdate *update,
+                                                 const gchar     *uri_template);
+
+/**
+ * mcp_server_update_add_prompt:
+ * @update: an #McpServerUpdate
+ * @prompt: (transfer none): the #McpPrompt to add
+ * @handler: (scope notified) (nullable): the handler function
+ * @user_data: (closure): user data for @handler
+ * @destroy: (destroy user_data): destroy notify for @user_data
+ *
+ * Records adding or replacing a prompt.
+ */
+void mcp_server_update_add_prompt (McpServerUpdate  *update,
+                                   McpPrompt        *prompt,
+                                   McpPromptHandler  handler,
+                                   gpointer          user_data,
+                                   GDestroyNotify    destroy);
+
+/**
+ * mcp_server_update_remove_prompt:
+ * @update: an #McpServerUpdate
+ * @name: the prompt name
+ *
+ * Records removing a prompt.
+ */
+void mcp_server_update_remove_prompt (McpServerUpdate *update,
+                                      const gchar     *name);
+
+/**
+ * mcp_server_commit_update:
+ * @self: an #McpServer
+ * @update: (transfer none): the changes to apply
+ *
+ * Applies every change in @update on top of the server's current
+ * registry and publishes the result atomically.  The client then gets
+ * one list_changed notification for each of the tool, resource and
+ * prompt lists the update actually changed, coalesced with other
+ * changes in the #McpServer:list-changed-delay window.
+ *
+ * Unlike mcp_server_add_tool() and friends, this may be called from
+ * any thread.  Dispatch is never blocked; concurrent commits are
+ * applied one after the other.  When called from another thread, the
+ * notifications are sent from the server's main context.
+ */
+void mcp_server_commit_update (McpServer       *self,
+                               McpServerUpdate *update);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (McpServerUpdate, mcp_server_update_free)
+
+/* Read coalescing */
+
+/**
+ * McpReadGroup:
+ *
+ * An opaque, reference counted group of servers whose resources/read
+ * requests are coalesced.  While a read of a URI is pending, further
+ * reads of the same URI from any server in the group that resolve to
+ * the same handler and user data wait for it: the handler runs once,
+ * its contents are serialized once, and every waiter gets the same
+ * reply.  A group is used from a single #GMainContext.
+ */
+typedef struct _McpReadGroup McpReadGroup;
+
+/**
+ * mcp_read_group_new:
+ *
+ * Creates an empty read group.
+ *
+ * Returns: (transfer full): a new #McpReadGroup
+ */
+McpReadGroup *mcp_read_group_new (void);
+
+/**
+ * mcp_read_group_ref:
+ * @group: an #McpReadGroup
+ *
+ * Increases the reference count of @group.
+ *
+ * Returns: (transfer full): @group
+ */
+McpReadGroup *mcp_read_group_ref (McpReadGroup *group);
+
+/**
+ * mcp_read_group_unref:
+ * @group: (transfer full): an #McpReadGroup
+ *
+ * Decreases the reference count of @group, freeing it when it drops
+ * to zero.  Reads still pending keep the group alive.
+ */
+void mcp_read_group_unref (McpReadGroup *group);
+
+/**
+ * mcp_read_group_get_coalesced_reads:
+ * @group: an #McpReadGroup
+ *
+ * Gets how many reads were answered by joining another read of the
+ * same URI instead of running the handler.
+ *
+ * Returns: the number of coalesced reads
+ */
+guint64 mcp_read_group_get_coalesced_reads (McpReadGroup *group);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (McpReadGroup, mcp_read_group_unref)
+
+/**
+ * mcp_server_set_read_group:
+ * @self: an #McpServer
+ * @group: (nullable): an #McpReadGroup, or %NULL
+ *
+ * Makes @self coalesce resources/read requests with the other servers
+ * in @group.  A read then waits until the end of the current main loop
+ * iteration, so that reads of the same URI arriving meanwhile share
+ * its handler invocation.  Only use this when a resource handler's
+ * contents do not depend on which server it is called for.  With
+ * %NULL (the default), every read runs its handler immediately.
+ */
+void mcp_server_set_read_group (McpServer    *self,
+                                McpReadGroup *group);
+
+/**
+ * mcp_server_get_read_group:
+ * @self: an #McpServer
+ *
+ * Gets the read group set with mcp_server_set_read_group().
+ *
+ * Returns: (transfer none) (nullable): the #McpReadGroup, or %NULL
+ */
+McpReadGroup *mcp_server_get_read_group (McpServer *self);
+
+/* Rate limiting */
+
+/**
+ * McpRateLimiter:
+ *
+ * An opaque, reference counted set of token-bucket limits on
+ * tools/call and resources/read requests, shared by any number of
+ * servers.  Each bucket holds up to a burst of tokens and refills at a
+ * steady rate; a request takes one token from every bucket that
+ * applies to it, or is refused with %MCP_ERROR_RATE_LIMITED without
+ * taking any.  Buckets are refilled lazily when they are next used and
+ * dropped once full, so memory only grows with the keys in active use.
+ * A limiter may be shared by servers running on different threads.
+ */
+typedef struct _McpRateLimiter McpRateLimiter;
+
+/**
+ * mcp_rate_limiter_new:
+ *
+ * Creates a rate limiter without any limits.
+ *
+ * Returns: (transfer full): a new #McpRateLimiter
+ */
+McpRateLimiter *mcp_rate_limiter_new (void);
+
+/**
+ * mcp_rate_limiter_ref:
+ * @limiter: an #McpRateLimiter
+ *
+ * Increases the reference count of @limiter.
+ *
+ * Returns: (transfer full): @limiter
+ */
+McpRateLimiter *mcp_rate_limiter_ref (McpRateLimiter *limiter);
+
+/**
+ * mcp_rate_limiter_unref:
+ * @limiter: (transfer full): an #McpRateLimiter
+ *
+ * Decreases the reference count of @limiter, freeing it when it drops
+ * to zero.
+ */
+void mcp_rate_limiter_unref (McpRateLimiter *limiter);
+
+/**
+ * mcp_rate_limiter_set_session_limit:
+ * @limiter: an #McpRateLimiter
+ * @rate: tokens added per second, or 0 to remove the limit
+ * @burst: the most tokens a bucket holds
+ *
+ * Limits the requests of each session (each #McpServer using
+ * @limiter), whatever tool or resource they are for.
+ */
+void mcp_rate_limiter_set_session_limit (McpRateLimiter *limiter,
+                                         gdouble         rate,
+                                         guint           burst);
+
+/**
+ * mcp_rate_limiter_set_tool_limit:
+ * @limiter: an #McpRateLimiter
+ * @name: (nullable): a tool name, or %NULL for every tool without a
+ *   limit of its own
+ * @rate: tokens added per second, or 0 to remove the limit
+ * @burst: the most tokens a bucket holds
+ *
+ * Limits calls of the tool @name across every session using @limiter.
+ * With %NULL, each tool gets its own bucket with this rate and burst.
+ * Tool limits never apply to resources/read.
+ */
+void mcp_rate_limiter_set_tool_limit (McpRateLimiter *limiter,
+                                      const gchar    *name,
+                                      gdouble         rate,
+                                      guint           burst);
+
+/**
+ * mcp_rate_limiter_set_session_tool_limit:
+ * @limiter: an #McpRateLimiter
+ * @name: (nullable): a tool name, or %NULL for every tool without a
+ *   limit of its own
+ * @rate: tokens added per second, or 0 to remove the limit
+ * @burst: the most tokens a bucket holds
+ *
+ * Like mcp_rate_limiter_set_tool_limit(), but with a bucket per
+ * session, so one client using up its share does not hold back the
+ * others.
+ */
+void mcp_rate_limiter_set_session_tool_limit (McpRateLimiter *limiter,
+                                              const gchar    *name,
+                                              gdouble         rate,
+                                              guint           burst);
+
+/**
+ * mcp_rate_limiter_set_resource_limit:
+ * @limiter: an #McpRateLimiter
+ * @uri: (nullable): a resource URI, or %NULL for every resource without
+ *   a limit of its own
+ * @rate: tokens added per second, or 0 to remove the limit
+ * @burst: the most tokens a bucket holds
+ *
+ * Limits reads of the resource @uri across every session using
+ * @limiter.  Resources have their own limits and buckets, apart from
+ * tools, so a URI that is also a tool's name shares nothing with it.
+ * Only URIs the server can read take tokens.
+ */
+void mcp_rate_limiter_set_resource_limit (McpRateLimiter *limiter,
+                                          const gchar    *uri,
+                                          gdouble         rate,
+                                          guint           burst);
+
+/**
+ * mcp_rate_limiter_set_session_resource_limit:
+ * @limiter: an #McpRateLimiter
+ * @uri: (nullable): a resource URI, or %NULL for every resource without
+ *   a limit of its own
+ * @rate: tokens added per second, or 0 to remove the limit
+ * @burst: the most tokens a bucket holds
+ *
+ * Like mcp_rate_limiter_set_resource_limit(), but with a bucket per
+ * session.
+ */
+void mcp_rate_limiter_set_session_resource_limit (McpRateLimiter *limiter,
+                                                  const gchar    *uri,
+                                                  gdouble         rate,
+                                                  guint           burst);
+
+/**
+ * mcp_rate_limiter_get_rejected:
+ * @limiter: an #McpRateLimiter
+ *
+ * Gets how many requests were refused for want of tokens.
+ *
+ * Returns: the number of refused requests
+ */
+guint64 mcp_rate_limiter_get_rejected (McpRateLimiter *limiter);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (McpRateLimiter, mcp_rate_limiter_unref)
+
+/**
+ * mcp_server_set_rate_limiter:
+ * @self: an #McpServer
+ * @limiter: (nullable): an #McpRateLimiter, or %NULL
+ *
+ * Checks tools/call and resources/read requests against @limiter
+ * before running their handlers.  A refused request gets an
+ * %MCP_ERROR_RATE_LIMITED error whose data holds `retryAfterMs`, the
+ * time until a retry can succeed, and `scope`, the limit that was hit
+ * (`"session"`, `"tool"`, `"session-tool"`, `"resource"` or
+ * `"session-resource"`).  With %NULL (the
+ * default), requests are not limited.
+ */
+void mcp_server_set_rate_limiter (McpServer      *self,
+                                  McpRateLimiter *limiter);
+
+/**
+ * mcp_server_get_rate_limiter:
+ * @self: an #McpServer
+ *
+ * Gets the rate limiter set with mcp_server_set_rate_limiter().
+ *
+ * Returns: (transfer none) (nullable): the #McpRateLimiter, or %NULL
+ */
+McpRateLimiter *mcp_server_get_rate_limiter (McpServer *self);
+
 /* Notifications */
 
 /**
  * mcp_server_notify_tools_changed:
  * @self: an #McpServer
  *
- * Notifies the client that the tool list has changed.
+ * Notifies the client that the tool list has changed.  Calls made
+ * within the #McpServer:list-changed-delay window are coalesced into
+ * one notification.
  */
 void mcp_server_notify_tools_changed (McpServer *self);
 
@@ -454,7 +1128,8 @@ void mcp_server_notify_tools_changed (McpServer *self);
  * mcp_server_notify_resources_changed:
  * @self: an #McpServer
  *
- * Notifies the client that the resource list has changed.
+ * Notifies the client that the resource list has changed.  Calls
+ * are coalesced like mcp_server_notify_tools_changed().
  */
 void mcp_server_notify_resources_changed (McpServer *self);
 
@@ -462,7 +1137,8 @@ void mcp_server_notify_resources_changed (McpServer *self);
  * mcp_server_notify_prompts_changed:
  * @self: an #McpServer
  *
- * Notifies the client that the prompt list has changed.
+ * Notifies the client that the prompt list has changed.  Calls are
+ * coalesced like mcp_server_notify_tools_changed().
  */
 void mcp_server_notify_prompts_changed (McpServer *self);
 
@@ -474,6 +1150,8 @@ void mcp_server_notify_prompts_changed (McpServer *self);
  * @data: the log data (can be any JSON value)
  *
  * Emits a log notification to the client.
+ *
+ * May be called from any thread; see mcp_server_complete_task().
  */
 void mcp_server_emit_log (McpServer   *self,
                           McpLogLevel  level,
@@ -488,6 +1166,8 @@ void mcp_server_emit_log (McpServer   *self,
  * @total: (nullable): the total amount, or -1 if unknown
  *
  * Sends a progress notification for a long-running operation.
+ *
+ * May be called from any thread; see mcp_server_complete_task().
  */
 void mcp_server_send_progress (McpServer   *self,
                                const gchar *token,
@@ -545,7 +1225,20 @@ GList *mcp_server_list_tasks (McpServer *self);
  * Marks a task as completed with the given result.
  * This sends a task status notification to the client.
  *
- * Returns: %TRUE if the task was found and completed
+ * This function may be called from any thread, for example from the
+ * worker that ran an async tool.  Calls made off the thread that owns
+ * the server's #GMainContext are queued and replayed on that context,
+ * which is woken once per batch rather than once per call.  Calls
+ * queued by one thread are replayed in the order they were made; there
+ * is no ordering between threads.  A queued call returns %TRUE before
+ * the task is looked up, and @result is owned by the queue from then on.
+ * mcp_server_fail_task(), mcp_server_update_task_status(),
+ * mcp_server_send_progress(), mcp_server_emit_log() and
+ * mcp_server_notify_resource_updated() share the same queue, so their
+ * relative order is kept as well.
+ *
+ * Returns: %TRUE if the task was found and completed, or if the call
+ *   was queued from another thread
  */
 gboolean mcp_server_complete_task (McpServer     *self,
                                    const gchar   *task_id,
@@ -561,7 +1254,10 @@ gboolean mcp_server_complete_task (McpServer     *self,
  * Marks a task as failed with the given error message.
  * This sends a task status notification to the client.
  *
- * Returns: %TRUE if the task was found and failed
+ * May be called from any thread; see mcp_server_complete_task().
+ *
+ * Returns: %TRUE if the task was found and failed, or if the call was
+ *   queued from another thread
  */
 gboolean mcp_server_fail_task (McpServer   *self,
                                const gchar *task_id,
@@ -576,7 +1272,10 @@ gboolean mcp_server_fail_task (McpServer   *self,
  *
  * Updates the status of a task and sends a notification.
  *
- * Returns: %TRUE if the task was found and updated
+ * May be called from any thread; see mcp_server_complete_task().
+ *
+ * Returns: %TRUE if the task was found and updated, or if the call was
+ *   queued from another thread
  */
 gboolean mcp_server_update_task_status (McpServer     *self,
                                         const gchar   *task_id,
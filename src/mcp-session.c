@@ -205,8 +205,7 @@ mcp_session_init (McpSession *self)
 
     priv->state = MCP_SESSION_STATE_DISCONNECTED;
     priv->next_request_id = 1;
-    priv->pending_requests = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                     g_free, g_object_unref);
+    /* pending_requests is made on the first outgoing request */
 }
 
 /**
@@ -408,7 +407,8 @@ mcp_session_has_pending_request (McpSession  *self,
     g_return_val_if_fail (request_id != NULL, FALSE);
 
     priv = mcp_session_get_instance_private (self);
-    return g_hash_table_contains (priv->pending_requests, request_id);
+    return priv->pending_requests != NULL &&
+           g_hash_table_contains (priv->pending_requests, request_id);
 }
 
 /**
@@ -427,7 +427,7 @@ mcp_session_get_pending_request_count (McpSession *self)
     g_return_val_if_fail (MCP_IS_SESSION (self), 0);
 
     priv = mcp_session_get_instance_private (self);
-    return g_hash_table_size (priv->pending_requests);
+    return priv->pending_requests != NULL ? g_hash_table_size (priv->pending_requests) : 0;
 }
 
 /*
@@ -445,6 +445,11 @@ mcp_session_add_pending_request (McpSession  *self,
     g_return_if_fail (G_IS_TASK (task));
 
     priv = mcp_session_get_instance_private (self);
+    if (priv->pending_requests == NULL)
+    {
+        priv->pending_requests = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                         g_free, g_object_unref);
+    }
     g_hash_table_insert (priv->pending_requests,
                          g_strdup (request_id),
                          g_object_ref (task));
@@ -465,6 +470,10 @@ mcp_session_take_pending_request (McpSession  *self,
     g_return_val_if_fail (request_id != NULL, NULL);
 
     priv = mcp_session_get_instance_private (self);
+    if (priv->pending_requests == NULL)
+    {
+        return NULL;
+    }
 
     task = g_hash_table_lookup (priv->pending_requests, request_id);
     if (task != NULL)
@@ -491,6 +500,10 @@ mcp_session_cancel_all_pending_requests (McpSession *self,
     g_return_if_fail (MCP_IS_SESSION (self));
 
     priv = mcp_session_get_instance_private (self);
+    if (priv->pending_requests == NULL)
+    {
+        return;
+    }
 
     if (error == NULL)
     {
@@ -0,0 +1,1516 @@
+/*
+ * mcp-shm-transport.c - Shared-memory transport implementation
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+/* memfd_create() and the file sealing fcntls */
+#define _GNU_SOURCE
+
+#include "mcp-shm-transport.h"
+#include "mcp-error.h"
+#include "mcp-json-parse.h"
+#include "mcp-json-writer.h"
+
+#include <gio/gunixfdlist.h>
+#include <gio/gunixfdmessage.h>
+#include <gio/gunixsocketaddress.h>
+#include <glib-unix.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * SECTION:mcp-shm-transport
+ * @title: McpShmTransport
+ * @short_description: Shared-memory transport for co-located processes
+ *
+ * #McpShmTransport moves messages through a memfd shared by the two
+ * processes.  Each direction is a single-producer/single-consumer ring:
+ * the sender copies the serialized message into the ring and publishes
+ * it by advancing the head, the receiver parses it straight out of the
+ * ring and advances the tail.  Nothing is copied through the kernel.
+ *
+ * Each side owns an eventfd "doorbell" that the other side rings only
+ * when it has announced that it is about to sleep, so a busy connection
+ * exchanges messages without system calls.  After draining its ring a
+ * receiver spins briefly before sleeping; the spin budget follows how
+ * quickly the peer answered recently and decays to nothing on an idle
+ * connection.
+ *
+ * The region and doorbells are created by the server and passed over
+ * the Unix socket the client connected on.  After that the socket only
+ * carries file descriptors handed over with mcp_transport_send_fd(),
+ * and lets either side notice the other exiting.
+ */
+
+/* ── shared layout ─────────────────────────────────────────────────── */
+
+#define SHM_MAGIC            (0x4d435053u)  /* "MCPS" */
+#define SHM_VERSION          (1)
+#define SHM_CACHELINE        (64)
+#define SHM_MIN_RING_SIZE    (4096)
+#define SHM_MAX_RING_SIZE    (1u << 30)
+
+/* Frame header: payload length, top bit set when more fragments follow */
+#define FRAME_HEADER         ((guint32) sizeof (guint32))
+#define FRAME_MORE           (0x80000000u)
+
+/* A message is not split into fragments smaller than this */
+#define FRAME_MIN_CHUNK      (256)
+
+/* Upper bound of the spin before sleeping on the doorbell */
+#define SPIN_MAX_US          (50)
+
+#define HANDSHAKE_TIMEOUT_S  (10)
+
+/* Each passed descriptor travels alone, attached to this one byte */
+#define FD_MARKER            ('F')
+
+/* Passed descriptors nobody has taken; beyond this the oldest close */
+#define MAX_UNCLAIMED_FDS    (64)
+
+typedef struct
+{
+    /* Head and tail live on separate cache lines so the producer and
+     * consumer do not false-share.  Both are free-running counters. */
+    gint  head;                          /* written by the producer */
+    gchar pad0[SHM_CACHELINE - sizeof (gint)];
+    gint  tail;                          /* written by the consumer */
+    gchar pad1[SHM_CACHELINE - sizeof (gint)];
+    gint  reader_sleeping;               /* consumer wants a doorbell */
+    gint  writer_waiting;                /* producer waits for space */
+    gchar pad2[SHM_CACHELINE - 2 * sizeof (gint)];
+} ShmRing;
+
+typedef struct
+{
+    guint32 magic;
+    guint32 version;
+    guint32 ring_size;
+    guint32 reserved;
+    gchar   pad[SHM_CACHELINE - 4 * sizeof (guint32)];
+    ShmRing rings[2];                    /* [0] server to client, [1] back */
+} ShmHeader;
+
+/* Ring data follows the header; ring 0 first */
+#define SHM_DATA_OFFSET      (sizeof (ShmHeader))
+
+typedef struct
+{
+    GTask  *task;
+    GBytes *bytes;
+    gsize   offset;
+} WriteEntry;
+
+struct _McpShmTransport
+{
+    GObject parent_instance;
+
+    McpTransportState  state;
+    gboolean           is_server;
+    gchar             *socket_path;      /* client only */
+    gsize              requested_ring_size; /* server only */
+    GSocketConnection *connection;
+    GMainContext      *context;
+
+    /* Mapped region */
+    ShmHeader         *header;
+    gsize              map_size;
+    guint32            ring_size;
+    ShmRing           *tx;
+    ShmRing           *rx;
+    guint8            *tx_data;
+    guint8            *rx_data;
+    guint32            tx_head;          /* we are the only producer */
+
+    gint               doorbell_fd;      /* ours; the peer rings it */
+    gint               peer_doorbell_fd;
+    GSource           *doorbell_source;
+    GSource           *socket_source;
+
+    /* Messages waiting for ring space, by priority */
+    McpWriteQueue     *write_queue;
+    /* Taken from the queue; its first frames may be in the ring already */
+    WriteEntry        *sending;
+    /* Fragments of the message being received */
+    GByteArray        *partial;
+    /* Reused to serialize outgoing messages */
+    McpJsonWriter     *writer;
+
+    gint64             slept_at;
+    gint64             spin_us;
+
+    /* Descriptors passed over the socket, numbered in order */
+    gint               fds_sent;
+    gint               fds_received;
+    GQueue            *received_fds;     /* ReceivedFd, oldest first */
+};
+
+static void mcp_shm_transport_iface_init (McpTransportInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (McpShmTransport, mcp_shm_transport, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (MCP_TYPE_TRANSPORT,
+                                                mcp_shm_transport_iface_init))
+
+static void
+write_entry_free (WriteEntry *entry)
+{
+    g_clear_object (&entry->task);
+    g_bytes_unref (entry->bytes);
+    g_free (entry);
+}
+
+static void
+set_state (McpShmTransport   *self,
+           McpTransportState  new_state)
+{
+    McpTransportState old_state;
+
+    old_state = self->state;
+    if (old_state != new_state)
+    {
+        self->state = new_state;
+        mcp_transport_emit_state_changed (MCP_TRANSPORT (self), old_state, new_state);
+    }
+}
+
+static void
+close_fd (gint *fd)
+{
+    if (*fd >= 0)
+    {
+        close (*fd);
+        *fd = -1;
+    }
+}
+
+typedef struct
+{
+    gint handle;
+    gint fd;
+} ReceivedFd;
+
+static void
+received_fd_free (ReceivedFd *received)
+{
+    close_fd (&received->fd);
+    g_free (received);
+}
+
+static void
+set_errno_error (GError      **error,
+                 const gchar  *what)
+{
+    gint saved_errno = errno;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "%s: %s", what, g_strerror (saved_errno));
+}
+
+/* ── ring access ───────────────────────────────────────────────────── */
+
+static void
+ring_read (const guint8 *data,
+           guint32       size,
+           guint32       pos,
+           gpointer      dest,
+           gsize         len)
+{
+    gsize offset = pos & (size - 1);
+    gsize first = MIN (len, size - offset);
+
+    memcpy (dest, data + offset, first);
+    memcpy ((guint8 *) dest + first, data, len - first);
+}
+
+static void
+ring_write (guint8        *data,
+            guint32        size,
+            guint32        pos,
+            gconstpointer  src,
+            gsize          len)
+{
+    gsize offset = pos & (size - 1);
+    gsize first = MIN (len, size - offset);
+
+    memcpy (data + offset, src, first);
+    memcpy (data, (const guint8 *) src + first, len - first);
+}
+
+static void
+doorbell_ring (gint fd)
+{
+    guint64 one = 1;
+
+    /* EAGAIN means the counter is saturated, i.e. already ringing */
+    if (write (fd, &one, sizeof one) < 0 && errno != EAGAIN)
+    {
+        g_debug ("mcp-shm-transport: doorbell: %s", g_strerror (errno));
+    }
+}
+
+static gboolean
+rx_pending (McpShmTransport *self)
+{
+    return g_atomic_int_get (&self->rx->head) != g_atomic_int_get (&self->rx->tail);
+}
+
+/* ── teardown ──────────────────────────────────────────────────────── */
+
+static void
+release (McpShmTransport *self)
+{
+    if (self->doorbell_source != NULL)
+    {
+        g_source_destroy (self->doorbell_source);
+        g_clear_pointer (&self->doorbell_source, g_source_unref);
+    }
+    if (self->socket_source != NULL)
+    {
+        g_source_destroy (self->socket_source);
+        g_clear_pointer (&self->socket_source, g_source_unref);
+    }
+
+    /* Closing the socket is what tells the peer we are gone */
+    if (self->connection != NULL)
+    {
+        g_io_stream_close (G_IO_STREAM (self->connection), NULL, NULL);
+        g_clear_object (&self->connection);
+    }
+
+    if (self->header != NULL)
+    {
+        munmap (self->header, self->map_size);
+        self->header = NULL;
+        self->tx = NULL;
+        self->rx = NULL;
+        self->tx_data = NULL;
+        self->rx_data = NULL;
+    }
+
+    close_fd (&self->doorbell_fd);
+    close_fd (&self->peer_doorbell_fd);
+    g_byte_array_set_size (self->partial, 0);
+    g_queue_clear_full (self->received_fds, (GDestroyNotify) received_fd_free);
+}
+
+static void
+teardown (McpShmTransport   *self,
+          McpTransportState  new_state)
+{
+    WriteEntry *entry;
+
+    release (self);
+
+    while ((entry = g_steal_pointer (&self->sending)) != NULL ||
+           (entry = mcp_write_queue_pop (self->write_queue)) != NULL)
+    {
+        g_task_return_new_error (entry->task,
+                                 MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport closed before the message was sent");
+        write_entry_free (entry);
+    }
+
+    set_state (self, new_state);
+}
+
+static void
+fail (McpShmTransport *self,
+      const gchar     *message)
+{
+    g_autoptr(GError) error = NULL;
+
+    error = g_error_new (MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                         "Shared-memory ring corrupted: %s", message);
+    mcp_transport_emit_error (MCP_TRANSPORT (self), error);
+    teardown (self, MCP_TRANSPORT_STATE_ERROR);
+}
+
+/* ── receiving ─────────────────────────────────────────────────────── */
+
+/*
+ * Delivers every complete message in the inbound ring.  Returns %FALSE
+ * if the transport was torn down meanwhile.
+ */
+static gboolean
+drain_inbound (McpShmTransport *self)
+{
+    while (self->header != NULL)
+    {
+        g_autoptr(JsonNode) root = NULL;
+        g_autoptr(GError) error = NULL;
+        guint32 head;
+        guint32 tail;
+        guint32 avail;
+        guint32 frame;
+        guint32 len;
+        guint32 pos;
+        gboolean complete;
+
+        head = (guint32) g_atomic_int_get (&self->rx->head);
+        tail = (guint32) g_atomic_int_get (&self->rx->tail);
+        avail = head - tail;
+
+        if (avail == 0)
+        {
+            return TRUE;
+        }
+        if (avail < FRAME_HEADER || avail > self->ring_size)
+        {
+            fail (self, "bad head");
+            return FALSE;
+        }
+
+        ring_read (self->rx_data, self->ring_size, tail, &frame, FRAME_HEADER);
+        len = frame & ~FRAME_MORE;
+        complete = (frame & FRAME_MORE) == 0;
+        if (len > avail - FRAME_HEADER)
+        {
+            fail (self, "bad frame length");
+            return FALSE;
+        }
+
+        pos = (tail + FRAME_HEADER) & (self->ring_size - 1);
+        if (complete && self->partial->len == 0 && pos + len <= self->ring_size)
+        {
+            /* The common case: parse straight out of the ring */
+            if (len > 0)
+            {
+                root = mcp_json_parse ((const gchar *) self->rx_data + pos, len, &error);
+            }
+        }
+        else
+        {
+            guint old_len = self->partial->len;
+
+            g_byte_array_set_size (self->partial, old_len + len);
+            ring_read (self->rx_data, self->ring_size, tail + FRAME_HEADER,
+                       self->partial->data + old_len, len);
+
+            if (complete)
+            {
+                root = mcp_json_parse ((const gchar *) self->partial->data,
+                                       self->partial->len, &error);
+                g_byte_array_set_size (self->partial, 0);
+            }
+        }
+
+        /* The parsed tree does not point into the ring, so the space can
+         * be handed back before the message is delivered */
+        g_atomic_int_set (&self->rx->tail, (gint) (tail + FRAME_HEADER + len));
+        if (g_atomic_int_get (&self->rx->writer_waiting))
+        {
+            doorbell_ring (self->peer_doorbell_fd);
+        }
+
+        if (!complete || (root == NULL && error == NULL))
+        {
+            continue;
+        }
+
+        if (root == NULL)
+        {
+            g_autoptr(GError) parse_error = NULL;
+
+            parse_error = g_error_new (MCP_ERROR,
+                                       MCP_ERROR_PARSE_ERROR,
+                                       "Failed to parse JSON: %s",
+                                       error->message);
+            mcp_transport_emit_error (MCP_TRANSPORT (self), parse_error);
+            continue;
+        }
+
+        mcp_transport_emit_message_received (MCP_TRANSPORT (self), root);
+    }
+
+    return FALSE;
+}
+
+/* ── sending ───────────────────────────────────────────────────────── */
+
+/*
+ * Copies as much of @data from *@offset on into the outbound ring as
+ * fits, splitting it into frames.  Returns %TRUE once all of it is in
+ * the ring; %FALSE means the ring is full and the peer has been asked
+ * to ring our doorbell when it frees space.
+ */
+static gboolean
+ring_write_message (McpShmTransport *self,
+                    const guint8    *data,
+                    gsize            len,
+                    gsize           *offset)
+{
+    do
+    {
+        gsize remaining = len - *offset;
+        gsize need = FRAME_HEADER + MIN (remaining, FRAME_MIN_CHUNK);
+        gsize space;
+        gsize chunk;
+        guint32 used;
+        guint32 frame;
+
+        used = self->tx_head - (guint32) g_atomic_int_get (&self->tx->tail);
+        space = used <= self->ring_size ? self->ring_size - used : 0;
+
+        if (space < need)
+        {
+            /* Announce the wait, then look again: the consumer may have
+             * freed space before it could see the flag */
+            g_atomic_int_set (&self->tx->writer_waiting, 1);
+            used = self->tx_head - (guint32) g_atomic_int_get (&self->tx->tail);
+            space = used <= self->ring_size ? self->ring_size - used : 0;
+            if (space < need)
+            {
+                return FALSE;
+            }
+            g_atomic_int_set (&self->tx->writer_waiting, 0);
+        }
+
+        chunk = MIN (remaining, space - FRAME_HEADER);
+        frame = (guint32) chunk | (chunk < remaining ? FRAME_MORE : 0);
+
+        ring_write (self->tx_data, self->ring_size, self->tx_head, &frame, FRAME_HEADER);
+        ring_write (self->tx_data, self->ring_size, self->tx_head + FRAME_HEADER,
+                    data + *offset, chunk);
+        self->tx_head += FRAME_HEADER + (guint32) chunk;
+        *offset += chunk;
+
+        /* Publish, then ring only if the consumer said it would sleep */
+        g_atomic_int_set (&self->tx->head, (gint) self->tx_head);
+        if (g_atomic_int_get (&self->tx->reader_sleeping))
+        {
+            doorbell_ring (self->peer_doorbell_fd);
+        }
+    }
+    while (*offset < len);
+
+    return TRUE;
+}
+
+/*
+ * Writes queued messages while there is room, finishing the one whose
+ * first frames are in the ring before taking the next by priority.
+ * Returns %FALSE if the transport was torn down by a completion
+ * callback.
+ */
+static gboolean
+flush_write_queue (McpShmTransport *self)
+{
+    while (self->header != NULL)
+    {
+        WriteEntry *entry;
+        const guint8 *data;
+        gsize len;
+
+        if (self->sending == NULL)
+        {
+            self->sending = mcp_write_queue_pop (self->write_queue);
+            if (self->sending == NULL)
+            {
+                break;
+            }
+        }
+
+        entry = self->sending;
+        data = g_bytes_get_data (entry->bytes, &len);
+        if (!ring_write_message (self, data, len, &entry->offset))
+        {
+            return TRUE;
+        }
+
+        self->sending = NULL;
+        g_task_return_boolean (entry->task, TRUE);
+        write_entry_free (entry);
+    }
+
+    return self->header != NULL;
+}
+
+/*
+ * Sends @data, or whatever part of it does not fit right now, after
+ * everything already queued at @priority or above.  @bytes, if given,
+ * backs @data and is referenced instead of copied.  Takes ownership of
+ * @task.
+ */
+static void
+send_data (McpShmTransport    *self,
+           GTask              *task,
+           const guint8       *data,
+           gsize               len,
+           GBytes             *bytes,
+           McpMessagePriority  priority)
+{
+    WriteEntry *entry;
+    gsize offset = 0;
+
+    if (self->sending == NULL && mcp_write_queue_is_empty (self->write_queue) &&
+        ring_write_message (self, data, len, &offset))
+    {
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    entry = g_new0 (WriteEntry, 1);
+    entry->task = task;  /* Takes ownership */
+    entry->bytes = bytes != NULL ? g_bytes_new_from_bytes (bytes, offset, len - offset)
+                                 : g_bytes_new (data + offset, len - offset);
+
+    /* The rest of a message the ring took part of has to follow it */
+    if (offset > 0)
+    {
+        self->sending = entry;
+    }
+    else
+    {
+        mcp_write_queue_push (self->write_queue, priority, entry);
+    }
+}
+
+/* ── event sources ─────────────────────────────────────────────────── */
+
+static void
+service (McpShmTransport *self)
+{
+    gint64 now = g_get_monotonic_time ();
+
+    /* A peer that answered within the spin limit will likely do so
+     * again: spin about that long next time instead of sleeping */
+    if (self->slept_at > 0)
+    {
+        gint64 slept = now - self->slept_at;
+
+        self->spin_us = slept < SPIN_MAX_US ? MIN (MAX (slept * 2, 1), SPIN_MAX_US)
+                                            : self->spin_us / 2;
+        self->slept_at = 0;
+    }
+
+    g_atomic_int_set (&self->rx->reader_sleeping, 0);
+
+    for (;;)
+    {
+        if (!drain_inbound (self) || !flush_write_queue (self))
+        {
+            return;
+        }
+
+        if (self->spin_us > 0)
+        {
+            gint64 deadline = g_get_monotonic_time () + self->spin_us;
+
+            while (!rx_pending (self) && g_get_monotonic_time () < deadline)
+            {
+                /* spin */
+            }
+            if (rx_pending (self))
+            {
+                continue;
+            }
+            self->spin_us /= 2;
+        }
+
+        /* Announce the sleep, then look once more: a message published
+         * before the producer saw the flag would otherwise be missed */
+        g_atomic_int_set (&self->rx->reader_sleeping, 1);
+        if (!rx_pending (self))
+        {
+            break;
+        }
+        g_atomic_int_set (&self->rx->reader_sleeping, 0);
+    }
+
+    self->slept_at = g_get_monotonic_time ();
+}
+
+static gboolean
+on_doorbell (gint         fd,
+             GIOCondition condition,
+             gpointer     user_data)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (user_data);
+    guint64 count;
+
+    /* Resetting the counter is all; both rings are looked at anyway */
+    if (read (fd, &count, sizeof count) < 0 && errno != EAGAIN)
+    {
+        g_debug ("mcp-shm-transport: doorbell: %s", g_strerror (errno));
+    }
+
+    g_object_ref (self);
+    service (self);
+    g_object_unref (self);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/*
+ * Reads one byte from the socket and keeps the descriptor that came
+ * with it.  Descriptors are sent one per byte, so reading a byte at a
+ * time numbers them in the order the peer sent them.
+ */
+static gssize
+socket_receive_one (McpShmTransport  *self,
+                    GError          **error)
+{
+    GSocket *socket;
+    GSocketControlMessage **messages = NULL;
+    GInputVector vector;
+    gint n_messages = 0;
+    gint flags = 0;
+    gchar byte;
+    gssize received;
+    gint i;
+
+    socket = g_socket_connection_get_socket (self->connection);
+    vector.buffer = &byte;
+    vector.size = 1;
+    received = g_socket_receive_message (socket, NULL, &vector, 1,
+                                        &messages, &n_messages, &flags,
+                                        NULL, error);
+
+    for (i = 0; i < n_messages; i++)
+    {
+        if (G_IS_UNIX_FD_MESSAGE (messages[i]))
+        {
+            g_autofree gint *fds = NULL;
+            gint n_fds;
+            gint j;
+
+            fds = g_unix_fd_message_steal_fds (G_UNIX_FD_MESSAGE (messages[i]), &n_fds);
+            for (j = 0; j < n_fds; j++)
+            {
+                ReceivedFd *received_fd;
+
+                received_fd = g_new (ReceivedFd, 1);
+                received_fd->handle = self->fds_received++;
+                received_fd->fd = fds[j];
+                g_queue_push_tail (self->received_fds, received_fd);
+            }
+        }
+        g_object_unref (messages[i]);
+    }
+    g_free (messages);
+
+    while (g_queue_get_length (self->received_fds) > MAX_UNCLAIMED_FDS)
+    {
+        received_fd_free (g_queue_pop_head (self->received_fds));
+    }
+
+    return received;
+}
+
+static gboolean
+on_socket_ready (GSocket      *socket,
+                 GIOCondition  condition,
+                 gpointer      user_data)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (user_data);
+    g_autoptr(GError) error = NULL;
+    gssize n;
+
+    /* Descriptors passed ahead of a message wait in received_fds */
+    do
+    {
+        n = socket_receive_one (self, &error);
+    }
+    while (n > 0);
+
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+    {
+        return G_SOURCE_CONTINUE;
+    }
+
+    /* The peer is gone.  Deliver whatever it wrote before it went. */
+    g_object_ref (self);
+    if (drain_inbound (self))
+    {
+        teardown (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+    }
+    g_object_unref (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* ── handshake ─────────────────────────────────────────────────────── */
+
+/*
+ * Handshake:
+ *
+ * Inputs and results of the blocking handshake, run in a worker
+ * thread.  The main thread takes the results out of it; whatever is
+ * left is released with the task.
+ */
+typedef struct
+{
+    gchar             *socket_path;
+    gsize              ring_size;
+    GSocketConnection *connection;
+    ShmHeader         *header;
+    gsize              map_size;
+    gint               doorbell_fd;
+    gint               peer_doorbell_fd;
+} Handshake;
+
+static Handshake *
+handshake_new (void)
+{
+    Handshake *hs;
+
+    hs = g_new0 (Handshake, 1);
+    hs->doorbell_fd = -1;
+    hs->peer_doorbell_fd = -1;
+
+    return hs;
+}
+
+static void
+handshake_free (gpointer data)
+{
+    Handshake *hs = data;
+
+    g_free (hs->socket_path);
+    g_clear_object (&hs->connection);
+    if (hs->header != NULL)
+    {
+        munmap (hs->header, hs->map_size);
+    }
+    close_fd (&hs->doorbell_fd);
+    close_fd (&hs->peer_doorbell_fd);
+    g_free (hs);
+}
+
+static void
+server_handshake_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+    Handshake *hs = task_data;
+    GUnixFDList *fd_list = NULL;
+    GSocketControlMessage *message = NULL;
+    GOutputVector vector;
+    GError *error = NULL;
+    guint8 ack = 1;
+    gint memfd;
+    gint client_doorbell_fd;
+    gboolean ok = FALSE;
+
+    hs->map_size = SHM_DATA_OFFSET + 2 * hs->ring_size;
+
+    memfd = memfd_create ("mcp-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0)
+    {
+        set_errno_error (&error, "memfd_create");
+        g_task_return_error (task, error);
+        return;
+    }
+
+    /* Sealed so the client can trust the size: a region that shrinks
+     * under a mapping turns accesses into SIGBUS */
+    if (ftruncate (memfd, (off_t) hs->map_size) < 0 ||
+        fcntl (memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)
+    {
+        set_errno_error (&error, "Cannot size shared memory");
+        goto out;
+    }
+
+    hs->header = mmap (NULL, hs->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (hs->header == MAP_FAILED)
+    {
+        hs->header = NULL;
+        set_errno_error (&error, "mmap");
+        goto out;
+    }
+
+    /* The memfd starts zeroed: both rings are empty */
+    hs->header->magic = SHM_MAGIC;
+    hs->header->version = SHM_VERSION;
+    hs->header->ring_size = (guint32) hs->ring_size;
+    hs->header->rings[0].reader_sleeping = 1;
+    hs->header->rings[1].reader_sleeping = 1;
+
+    hs->doorbell_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    client_doorbell_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    hs->peer_doorbell_fd = client_doorbell_fd;
+    if (hs->doorbell_fd < 0 || client_doorbell_fd < 0)
+    {
+        set_errno_error (&error, "eventfd");
+        goto out;
+    }
+
+    /* Order: region, the client's doorbell, ours */
+    fd_list = g_unix_fd_list_new ();
+    if (g_unix_fd_list_append (fd_list, memfd, &error) < 0 ||
+        g_unix_fd_list_append (fd_list, client_doorbell_fd, &error) < 0 ||
+        g_unix_fd_list_append (fd_list, hs->doorbell_fd, &error) < 0)
+    {
+        goto out;
+    }
+
+    message = g_unix_fd_message_new_with_fd_list (fd_list);
+    vector.buffer = &ack;
+    vector.size = 1;
+
+    if (g_socket_send_message (g_socket_connection_get_socket (hs->connection),
+                               NULL, &vector, 1, &message, 1,
+                               G_SOCKET_MSG_NONE, cancellable, &error) < 0)
+    {
+        goto out;
+    }
+
+    ok = TRUE;
+
+out:
+    close (memfd);
+    g_clear_object (&message);
+    g_clear_object (&fd_list);
+
+    if (ok)
+    {
+        g_task_return_boolean (task, TRUE);
+    }
+    else
+    {
+        g_task_return_error (task, error);
+    }
+}
+
+static gboolean
+client_map_region (Handshake  *hs,
+                   gint        memfd,
+                   GError    **error)
+{
+    struct stat st;
+    gint seals;
+    guint32 ring_size;
+
+    seals = fcntl (memfd, F_GET_SEALS);
+    if (seals < 0 || (seals & F_SEAL_SHRINK) == 0 || fstat (memfd, &st) < 0 ||
+        st.st_size < (off_t) SHM_DATA_OFFSET)
+    {
+        g_set_error_literal (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                             "Server sent an unusable shared-memory region");
+        return FALSE;
+    }
+
+    hs->map_size = (gsize) st.st_size;
+    hs->header = mmap (NULL, hs->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (hs->header == MAP_FAILED)
+    {
+        hs->header = NULL;
+        set_errno_error (error, "mmap");
+        return FALSE;
+    }
+
+    ring_size = hs->header->ring_size;
+    if (hs->header->magic != SHM_MAGIC ||
+        hs->header->version != SHM_VERSION ||
+        ring_size < SHM_MIN_RING_SIZE || ring_size > SHM_MAX_RING_SIZE ||
+        (ring_size & (ring_size - 1)) != 0 ||
+        hs->map_size != SHM_DATA_OFFSET + 2 * (gsize) ring_size)
+    {
+        g_set_error_literal (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                             "Unsupported shared-memory region layout");
+        return FALSE;
+    }
+
+    hs->ring_size = ring_size;
+    return TRUE;
+}
+
+static void
+client_handshake_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+    Handshake *hs = task_data;
+    g_autoptr(GSocketClient) client = NULL;
+    g_autoptr(GSocketAddress) address = NULL;
+    GSocketControlMessage **messages = NULL;
+    GUnixFDList *fd_list = NULL;
+    GInputVector vector;
+    GOutputStream *output;
+    GSocket *socket;
+    GError *error = NULL;
+    guint8 ack = 0;
+    gint n_messages = 0;
+    gint flags = 0;
+    gint *fds = NULL;
+    gint n_fds = 0;
+    gssize received;
+    gint i;
+
+    client = g_socket_client_new ();
+    address = g_unix_socket_address_new (hs->socket_path);
+    hs->connection = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (address),
+                                              cancellable, &error);
+    if (hs->connection == NULL)
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    /* A server without the upgrade reads the hello as a bad JSON line
+     * and never answers, so don't wait forever */
+    socket = g_socket_connection_get_socket (hs->connection);
+    g_socket_set_timeout (socket, HANDSHAKE_TIMEOUT_S);
+
+    output = g_io_stream_get_output_stream (G_IO_STREAM (hs->connection));
+    if (!g_output_stream_write_all (output, MCP_SHM_TRANSPORT_HELLO,
+                                    strlen (MCP_SHM_TRANSPORT_HELLO),
+                                    NULL, cancellable, &error))
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    vector.buffer = &ack;
+    vector.size = 1;
+    received = g_socket_receive_message (socket, NULL, &vector, 1,
+                                        &messages, &n_messages, &flags,
+                                        cancellable, &error);
+    g_socket_set_timeout (socket, 0);
+
+    for (i = 0; i < n_messages; i++)
+    {
+        if (fd_list == NULL && G_IS_UNIX_FD_MESSAGE (messages[i]))
+        {
+            fd_list = g_object_ref (g_unix_fd_message_get_fd_list (
+                                        G_UNIX_FD_MESSAGE (messages[i])));
+        }
+        g_object_unref (messages[i]);
+    }
+    g_free (messages);
+
+    if (fd_list != NULL)
+    {
+        fds = g_unix_fd_list_steal_fds (fd_list, &n_fds);
+        g_object_unref (fd_list);
+    }
+
+    if (received < 0)
+    {
+        g_task_return_error (task, error);
+        goto out;
+    }
+    if (received == 0 || n_fds != 3)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "Server at %s did not offer shared memory",
+                                 hs->socket_path);
+        goto out;
+    }
+
+    hs->doorbell_fd = fds[1];
+    hs->peer_doorbell_fd = fds[2];
+    fds[1] = fds[2] = -1;
+
+    if (!client_map_region (hs, fds[0], &error))
+    {
+        g_task_return_error (task, error);
+        goto out;
+    }
+
+    g_task_return_boolean (task, TRUE);
+
+out:
+    for (i = 0; i < n_fds; i++)
+    {
+        close_fd (&fds[i]);
+    }
+    g_free (fds);
+}
+
+static void
+install (McpShmTransport *self,
+         Handshake       *hs)
+{
+    guint8 *data;
+    GSocket *socket;
+
+    self->connection = g_steal_pointer (&hs->connection);
+    self->header = g_steal_pointer (&hs->header);
+    self->map_size = hs->map_size;
+    self->ring_size = (guint32) hs->ring_size;
+    self->doorbell_fd = hs->doorbell_fd;
+    self->peer_doorbell_fd = hs->peer_doorbell_fd;
+    hs->doorbell_fd = -1;
+    hs->peer_doorbell_fd = -1;
+
+    data = (guint8 *) self->header + SHM_DATA_OFFSET;
+    if (self->is_server)
+    {
+        self->tx = &self->header->rings[0];
+        self->rx = &self->header->rings[1];
+        self->tx_data = data;
+        self->rx_data = data + self->ring_size;
+    }
+    else
+    {
+        self->tx = &self->header->rings[1];
+        self->rx = &self->header->rings[0];
+        self->tx_data = data + self->ring_size;
+        self->rx_data = data;
+    }
+    self->tx_head = (guint32) g_atomic_int_get (&self->tx->head);
+    self->fds_sent = 0;
+    self->fds_received = 0;
+
+    /* The sources are destroyed in release(), before self goes away */
+    self->doorbell_source = g_unix_fd_source_new (self->doorbell_fd, G_IO_IN);
+    g_source_set_callback (self->doorbell_source, (GSourceFunc) on_doorbell, self, NULL);
+    g_source_attach (self->doorbell_source, self->context);
+
+    socket = g_socket_connection_get_socket (self->connection);
+    g_socket_set_blocking (socket, FALSE);
+    self->socket_source = g_socket_create_source (socket, G_IO_IN | G_IO_HUP | G_IO_ERR, NULL);
+    g_source_set_callback (self->socket_source, (GSourceFunc) on_socket_ready, self, NULL);
+    g_source_attach (self->socket_source, self->context);
+
+    /* Pick up anything the peer sent before we were ready */
+    doorbell_ring (self->doorbell_fd);
+}
+
+static void
+handshake_done_cb (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (source);
+    g_autoptr(GTask) task = G_TASK (user_data);
+    GError *error = NULL;
+
+    if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+        if (self->state == MCP_TRANSPORT_STATE_CONNECTING)
+        {
+            set_state (self, MCP_TRANSPORT_STATE_ERROR);
+        }
+        g_task_return_error (task, error);
+        return;
+    }
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTING)
+    {
+        /* Disconnected while the handshake ran */
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport was closed during connect");
+        return;
+    }
+
+    install (self, g_task_get_task_data (G_TASK (result)));
+    set_state (self, MCP_TRANSPORT_STATE_CONNECTED);
+    g_task_return_boolean (task, TRUE);
+}
+
+/* ── interface vtable ──────────────────────────────────────────────── */
+
+static McpTransportState
+shm_transport_get_state (McpTransport *transport)
+{
+    return MCP_SHM_TRANSPORT (transport)->state;
+}
+
+static void
+shm_transport_connect_async (McpTransport        *transport,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (transport);
+    GTask *task;
+    GTask *handshake;
+    Handshake *hs;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, shm_transport_connect_async);
+
+    if (self->state == MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
+    if (self->state == MCP_TRANSPORT_STATE_CONNECTING ||
+        (self->is_server && self->connection == NULL))
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED, "%s",
+                                 self->is_server ? "Connection has been closed"
+                                                 : "Already connecting");
+        g_object_unref (task);
+        return;
+    }
+
+    hs = handshake_new ();
+    if (self->is_server)
+    {
+        /* The transport owns the connection again once connected */
+        hs->connection = g_steal_pointer (&self->connection);
+        hs->ring_size = self->requested_ring_size;
+    }
+    else
+    {
+        hs->socket_path = g_strdup (self->socket_path);
+    }
+
+    g_clear_pointer (&self->context, g_main_context_unref);
+    self->context = g_main_context_ref_thread_default ();
+    set_state (self, MCP_TRANSPORT_STATE_CONNECTING);
+
+    handshake = g_task_new (self, cancellable, handshake_done_cb, task);
+    g_task_set_task_data (handshake, hs, handshake_free);
+    g_task_run_in_thread (handshake, self->is_server ? server_handshake_thread
+                                                     : client_handshake_thread);
+    g_object_unref (handshake);
+}
+
+static gboolean
+shm_transport_connect_finish (McpTransport  *transport,
+                              GAsyncResult  *result,
+                              GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, transport), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+shm_transport_disconnect_async (McpTransport        *transport,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (transport);
+    g_autoptr(GTask) task = NULL;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, shm_transport_disconnect_async);
+
+    teardown (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+    g_task_return_boolean (task, TRUE);
+}
+
+static gboolean
+shm_transport_disconnect_finish (McpTransport  *transport,
+                                 GAsyncResult  *result,
+                                 GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, transport), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+shm_transport_send_message_async (McpTransport        *transport,
+                                  JsonNode            *message,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (transport);
+    GTask *task;
+    const gchar *json_str;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, shm_transport_send_message_async);
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_task_return_new_error (task,
+                                 MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport is not connected");
+        g_object_unref (task);
+        return;
+    }
+
+    /* Serialized straight into the ring when it has room */
+    mcp_json_writer_reset (self->writer);
+    mcp_json_writer_node (self->writer, message);
+    json_str = mcp_json_writer_get_data (self->writer, &len);
+
+    send_data (self, task, (const guint8 *) json_str, len, NULL,
+               mcp_transport_classify_message (message));
+}
+
+static void
+shm_transport_send_raw_with_priority_async (McpTransport        *transport,
+                                            GBytes              *data,
+                                            McpMessagePriority   priority,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (transport);
+    GTask *task;
+    const guint8 *bytes;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, shm_transport_send_raw_with_priority_async);
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_task_return_new_error (task,
+                                 MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport is not connected");
+        g_object_unref (task);
+        return;
+    }
+
+    bytes = g_bytes_get_data (data, &len);
+    send_data (self, task, bytes, len, data, priority);
+}
+
+static void
+shm_transport_send_raw_async (McpTransport        *transport,
+                              GBytes              *data,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+    shm_transport_send_raw_with_priority_async (transport, data,
+                                                mcp_transport_classify_raw (data),
+                                                cancellable, callback, user_data);
+}
+
+static gboolean
+shm_transport_send_message_finish (McpTransport  *transport,
+                                   GAsyncResult  *result,
+                                   GError       **error)
+{
+    g_return_val_if_fail (g_task_is_valid (result, transport), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static gint
+shm_transport_send_fd (McpTransport  *transport,
+                       gint           fd,
+                       GError       **error)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (transport);
+    g_autoptr(GUnixFDList) fd_list = NULL;
+    g_autoptr(GSocketControlMessage) message = NULL;
+    GError *local_error = NULL;
+    GOutputVector vector;
+    GSocket *socket;
+    gchar marker = FD_MARKER;
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                     "Transport is not connected");
+        return -1;
+    }
+
+    fd_list = g_unix_fd_list_new ();
+    if (g_unix_fd_list_append (fd_list, fd, error) < 0)
+    {
+        return -1;
+    }
+    message = g_unix_fd_message_new_with_fd_list (fd_list);
+
+    vector.buffer = &marker;
+    vector.size = 1;
+    socket = g_socket_connection_get_socket (self->connection);
+
+    /* Sent before the message that names the handle, so the peer always
+     * finds the descriptor queued on the socket by the time it looks */
+    while (g_socket_send_message (socket, NULL, &vector, 1, &message, 1,
+                                  G_SOCKET_MSG_NONE, NULL, &local_error) < 0)
+    {
+        if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+        {
+            g_propagate_error (error, local_error);
+            return -1;
+        }
+        g_clear_error (&local_error);
+
+        /* The peer drains the socket whenever it is readable */
+        if (!g_socket_condition_wait (socket, G_IO_OUT, NULL, error))
+        {
+            return -1;
+        }
+    }
+
+    return self->fds_sent++;
+}
+
+static gint
+shm_transport_receive_fd (McpTransport  *transport,
+                          gint           handle,
+                          GError       **error)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (transport);
+    GList *l;
+
+    if (self->connection == NULL)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                     "Transport is not connected");
+        return -1;
+    }
+
+    /* Not read off the socket yet, but already queued on it */
+    while (handle >= self->fds_received)
+    {
+        g_autoptr(GError) local_error = NULL;
+
+        if (socket_receive_one (self, &local_error) <= 0)
+        {
+            break;
+        }
+    }
+
+    for (l = self->received_fds->head; l != NULL; l = l->next)
+    {
+        ReceivedFd *received = l->data;
+
+        if (received->handle == handle)
+        {
+            gint fd = received->fd;
+
+            received->fd = -1;
+            received_fd_free (received);
+            g_queue_delete_link (self->received_fds, l);
+            return fd;
+        }
+    }
+
+    g_set_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                 "No file descriptor was passed as handle %d", handle);
+    return -1;
+}
+
+static void
+mcp_shm_transport_iface_init (McpTransportInterface *iface)
+{
+    iface->get_state = shm_transport_get_state;
+    iface->connect_async = shm_transport_connect_async;
+    iface->connect_finish = shm_transport_connect_finish;
+    iface->disconnect_async = shm_transport_disconnect_async;
+    iface->disconnect_finish = shm_transport_disconnect_finish;
+    iface->send_message_async = shm_transport_send_message_async;
+    iface->send_message_finish = shm_transport_send_message_finish;
+    iface->send_raw_async = shm_transport_send_raw_async;
+    iface->send_raw_finish = shm_transport_send_message_finish;
+    iface->send_raw_with_priority_async = shm_transport_send_raw_with_priority_async;
+    iface->send_fd = shm_transport_send_fd;
+    iface->receive_fd = shm_transport_receive_fd;
+}
+
+/* ── lifecycle ─────────────────────────────────────────────────────── */
+
+static void
+mcp_shm_transport_dispose (GObject *object)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (object);
+
+    release (self);
+    g_clear_pointer (&self->sending, write_entry_free);
+    mcp_write_queue_clear (self->write_queue, (GDestroyNotify) write_entry_free);
+
+    G_OBJECT_CLASS (mcp_shm_transport_parent_class)->dispose (object);
+}
+
+static void
+mcp_shm_transport_finalize (GObject *object)
+{
+    McpShmTransport *self = MCP_SHM_TRANSPORT (object);
+
+    mcp_write_queue_free (self->write_queue, NULL);
+    g_queue_free (self->received_fds);
+    g_byte_array_unref (self->partial);
+    g_clear_pointer (&self->writer, mcp_json_writer_free);
+    g_clear_pointer (&self->context, g_main_context_unref);
+    g_free (self->socket_path);
+
+    G_OBJECT_CLASS (mcp_shm_transport_parent_class)->finalize (object);
+}
+
+static void
+mcp_shm_transport_class_init (McpShmTransportClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->dispose = mcp_shm_transport_dispose;
+    object_class->finalize = mcp_shm_transport_finalize;
+}
+
+static void
+mcp_shm_transport_init (McpShmTransport *self)
+{
+    self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
+    self->doorbell_fd = -1;
+    self->peer_doorbell_fd = -1;
+    self->write_queue = mcp_write_queue_new ();
+    self->partial = g_byte_array_new ();
+    self->writer = mcp_json_writer_new ();
+    self->received_fds = g_queue_new ();
+}
+
+/* ── public API ────────────────────────────────────────────────────── */
+
+McpShmTransport *
+mcp_shm_transport_new_client (const gchar *socket_path)
+{
+    McpShmTransport *self;
+
+    g_return_val_if_fail (socket_path != NULL, NULL);
+
+    self = g_object_new (MCP_TYPE_SHM_TRANSPORT, NULL);
+    self->socket_path = g_strdup (socket_path);
+
+    return self;
+}
+
+McpShmTransport *
+mcp_shm_transport_new_server (GSocketConnection *connection,
+                              gsize              ring_size)
+{
+    McpShmTransport *self;
+    gsize size;
+
+    g_return_val_if_fail (G_IS_SOCKET_CONNECTION (connection), NULL);
+
+    if (ring_size == 0)
+    {
+        ring_size = MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE;
+    }
+    ring_size = MIN (ring_size, SHM_MAX_RING_SIZE);
+
+    /* Positions are masked, so the size must be a power of two */
+    size = SHM_MIN_RING_SIZE;
+    while (size < ring_size)
+    {
+        size <<= 1;
+    }
+
+    self = g_object_new (MCP_TYPE_SHM_TRANSPORT, NULL);
+    self->is_server = TRUE;
+    self->connection = g_object_ref (connection);
+    self->requested_ring_size = size;
+
+    return self;
+}
+
+gsize
+mcp_shm_transport_get_ring_size (McpShmTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_SHM_TRANSPORT (self), 0);
+
+    return self->ring_size;
+}
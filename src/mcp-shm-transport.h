@@ -0,0 +1,85 @@
+/*
+ * mcp-shm-transport.h - Shared-memory transport for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * McpShmTransport carries MCP messages between two processes on the
+ * same host through a pair of single-producer/single-consumer ring
+ * buffers in a memfd.  A Unix socket is used once to pass the memfd
+ * and two eventfd doorbells (SCM_RIGHTS), then only for file
+ * descriptors passed with mcp_transport_send_fd() and to notice the
+ * peer going away; messages never cross it.
+ */
+
+#ifndef MCP_SHM_TRANSPORT_H
+#define MCP_SHM_TRANSPORT_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include "mcp-transport.h"
+
+G_BEGIN_DECLS
+
+/**
+ * MCP_SHM_TRANSPORT_HELLO:
+ *
+ * The line a client writes to a Unix socket to ask for the
+ * shared-memory upgrade instead of newline-delimited JSON.
+ */
+#define MCP_SHM_TRANSPORT_HELLO "MCP-SHM/1\n"
+
+/**
+ * MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE:
+ *
+ * Default size in bytes of each direction's ring buffer.
+ */
+#define MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE (1024 * 1024)
+
+#define MCP_TYPE_SHM_TRANSPORT (mcp_shm_transport_get_type ())
+
+G_DECLARE_FINAL_TYPE (McpShmTransport, mcp_shm_transport, MCP, SHM_TRANSPORT, GObject)
+
+/**
+ * mcp_shm_transport_new_client:
+ * @socket_path: path of a Unix socket served by an #McpUnixSocketServer
+ *   with the shared-memory upgrade enabled
+ *
+ * Creates a client-side transport.  mcp_transport_connect_async()
+ * connects to @socket_path, sends %MCP_SHM_TRANSPORT_HELLO and maps the
+ * region the server hands back.
+ *
+ * Returns: (transfer full): a new #McpShmTransport
+ */
+McpShmTransport *mcp_shm_transport_new_client (const gchar *socket_path);
+
+/**
+ * mcp_shm_transport_new_server:
+ * @connection: an accepted Unix socket connection whose peer sent
+ *   %MCP_SHM_TRANSPORT_HELLO
+ * @ring_size: size of each ring buffer in bytes, rounded up to a power
+ *   of two, or 0 for %MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE
+ *
+ * Creates the server side of a shared-memory connection.
+ * mcp_transport_connect_async() creates the region and passes it to
+ * the peer over @connection.
+ *
+ * Returns: (transfer full): a new #McpShmTransport
+ */
+McpShmTransport *mcp_shm_transport_new_server (GSocketConnection *connection,
+                                               gsize              ring_size);
+
+/**
+ * mcp_shm_transport_get_ring_size:
+ * @self: an #McpShmTransport
+ *
+ * Gets the size of each ring buffer.  For a client this is only known
+ * once connected.
+ *
+ * Returns: the ring size in bytes, or 0 if not connected yet
+ */
+gsize mcp_shm_transport_get_ring_size (McpShmTransport *self);
+
+G_END_DECLS
+
+#endif /* MCP_SHM_TRANSPORT_H */
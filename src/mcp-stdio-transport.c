@@ -6,6 +6,10 @@
  */
 #include "mcp-stdio-transport.h"
 #include "mcp-error.h"
+#include "mcp-json-parse.h"
+#include "mcp-json-writer.h"
+#include "mcp-uring.h"
+#include <string.h>
 #undef MCP_COMPILATION
 
 /*
@@ -19,6 +23,7 @@
 #else
 #include <gio/gunixinputstream.h>
 #include <gio/gunixoutputstream.h>
+#include <gio/gfiledescriptorbased.h>
 #include <unistd.h>
 #include <signal.h>
 #endif
@@ -30,6 +35,11 @@
  *
  * #McpStdioTransport is a transport implementation that uses stdio streams
  * for communication. Messages are framed using newline-delimited JSON (NDJSON).
+ *
+ * When both streams are backed by sockets or pipes and the io_uring
+ * backend is available (see mcp_uring_is_available()), reads and writes
+ * bypass the streams and go through the io_uring shared by every
+ * transport on the same #GMainContext.
  */
 
 struct _McpStdioTransport
@@ -52,9 +62,16 @@ struct _McpStdioTransport
     /* Whether we own the streams (subprocess case) */
     gboolean owns_streams;
 
-    /* Write queue to handle sequential async writes */
-    GQueue *write_queue;
-    gboolean write_in_progress;
+    /* Lines waiting to be written, by priority, and the one being written */
+    McpWriteQueue *write_queue;
+    struct _WriteQueueEntry *current_write;
+
+    /* Reused to serialize outgoing messages */
+    McpJsonWriter *writer;
+
+    /* io_uring backend, used instead of the streams when set */
+    McpUringChannel *uring_channel;
+    GByteArray      *read_buffer;
 };
 
 static void mcp_stdio_transport_iface_init (McpTransportInterface *iface);
@@ -69,6 +86,7 @@ enum
     PROP_INPUT_STREAM,
     PROP_OUTPUT_STREAM,
     PROP_SUBPROCESS,
+    PROP_USES_IO_URING,
     N_PROPERTIES
 };
 
@@ -82,6 +100,7 @@ static void read_line_cb    (GObject      *source,
                              GAsyncResult *result,
                              gpointer      user_data);
 static gboolean start_read_loop_idle (gpointer user_data);
+static McpUringChannel *open_uring_channel (McpStdioTransport *self);
 
 /*
  * Set state and emit signal.
@@ -103,7 +122,7 @@ set_state (McpStdioTransport *self,
 /*
  * WriteQueueEntry - entry in the write queue
  */
-typedef struct
+typedef struct _WriteQueueEntry
 {
     GTask *task;
     gchar *line;
@@ -135,11 +154,18 @@ mcp_stdio_transport_dispose (GObject *object)
         g_clear_object (&self->read_cancellable);
     }
 
+    if (self->uring_channel != NULL)
+    {
+        mcp_uring_channel_close (g_steal_pointer (&self->uring_channel));
+    }
+    g_clear_pointer (&self->read_buffer, g_byte_array_unref);
+
     /* Clear write queue */
     if (self->write_queue != NULL)
     {
         WriteQueueEntry *entry;
-        while ((entry = g_queue_pop_head (self->write_queue)) != NULL)
+        while ((entry = g_steal_pointer (&self->current_write)) != NULL ||
+               (entry = mcp_write_queue_pop (self->write_queue)) != NULL)
         {
             if (entry->task != NULL)
             {
@@ -150,13 +176,14 @@ mcp_stdio_transport_dispose (GObject *object)
             }
             write_queue_entry_free (entry);
         }
-        g_queue_free (self->write_queue);
+        mcp_write_queue_free (self->write_queue, NULL);
         self->write_queue = NULL;
     }
 
     g_clear_object (&self->data_input);
     g_clear_object (&self->input);
     g_clear_object (&self->output);
+    g_clear_pointer (&self->writer, mcp_json_writer_free);
 
     if (self->subprocess != NULL)
     {
@@ -195,6 +222,9 @@ mcp_stdio_transport_get_property (GObject    *object,
         case PROP_SUBPROCESS:
             g_value_set_object (value, self->subprocess);
             break;
+        case PROP_USES_IO_URING:
+            g_value_set_boolean (value, self->uring_channel != NULL);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -248,15 +278,29 @@ mcp_stdio_transport_class_init (McpStdioTransportClass *klass)
                              G_PARAM_READABLE |
                              G_PARAM_STATIC_STRINGS);
 
+    /**
+     * McpStdioTransport:uses-io-uring:
+     *
+     * Whether the connected transport moves its data through the
+     * io_uring backend rather than its streams.
+     */
+    properties[PROP_USES_IO_URING] =
+        g_param_spec_boolean ("uses-io-uring",
+                              "Uses io_uring",
+                              "Whether I/O goes through io_uring",
+                              FALSE,
+                              G_PARAM_READABLE |
+                              G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties (object_class, N_PROPERTIES, properties);
 }
 
 static void
 mcp_stdio_transport_init (McpStdioTransport *self)
 {
+    self->writer = mcp_json_writer_new ();
     self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
-    self->write_queue = g_queue_new ();
-    self->write_in_progress = FALSE;
+    self->write_queue = mcp_write_queue_new ();
 }
 
 /*
@@ -302,10 +346,20 @@ stdio_transport_connect_async (McpTransport        *transport,
 
     set_state (self, MCP_TRANSPORT_STATE_CONNECTING);
 
-    /* Create data input stream wrapper for line reading */
-    self->data_input = g_data_input_stream_new (self->input);
-    g_data_input_stream_set_newline_type (self->data_input,
-                                          G_DATA_STREAM_NEWLINE_TYPE_LF);
+    /* Sockets and pipes can bypass the streams entirely; everything
+     * else reads lines through a data input stream wrapper. */
+    self->uring_channel = open_uring_channel (self);
+    if (self->uring_channel != NULL)
+    {
+        g_clear_pointer (&self->read_buffer, g_byte_array_unref);
+        self->read_buffer = g_byte_array_new ();
+    }
+    else
+    {
+        self->data_input = g_data_input_stream_new (self->input);
+        g_data_input_stream_set_newline_type (self->data_input,
+                                              G_DATA_STREAM_NEWLINE_TYPE_LF);
+    }
 
     /* Create cancellable for read loop */
     self->read_cancellable = g_cancellable_new ();
@@ -370,6 +424,12 @@ stdio_transport_disconnect_async (McpTransport        *transport,
         g_clear_object (&self->read_cancellable);
     }
 
+    /* Must happen before the streams close the descriptors */
+    if (self->uring_channel != NULL)
+    {
+        mcp_uring_channel_close (g_steal_pointer (&self->uring_channel));
+    }
+
     /* Close streams */
     if (self->output != NULL)
     {
@@ -421,8 +481,8 @@ write_message_cb (GObject      *source,
     GError *error = NULL;
     gsize bytes_written;
 
-    /* Pop the entry we just wrote */
-    entry = g_queue_pop_head (self->write_queue);
+    /* Take the entry we just wrote */
+    entry = g_steal_pointer (&self->current_write);
     g_return_if_fail (entry != NULL);
 
     if (!g_output_stream_write_all_finish (G_OUTPUT_STREAM (source), result,
@@ -447,8 +507,34 @@ write_message_cb (GObject      *source,
 
     write_queue_entry_free (entry);
 
-    /* Mark write as complete and process next in queue */
-    self->write_in_progress = FALSE;
+    /* Write the next line, if any */
+    process_write_queue (self);
+}
+
+/*
+ * queue_write:
+ *
+ * Takes ownership of @entry and queues its line for writing after the
+ * lines already waiting at @priority or above, on the io_uring channel
+ * when there is one.
+ */
+static void
+queue_write (McpStdioTransport  *self,
+             WriteQueueEntry    *entry,
+             McpMessagePriority  priority)
+{
+    if (self->uring_channel != NULL)
+    {
+        g_autoptr(GBytes) bytes = NULL;
+
+        bytes = g_bytes_new_take (g_steal_pointer (&entry->line), entry->len);
+        mcp_uring_channel_write (self->uring_channel, bytes, priority,
+                                 g_steal_pointer (&entry->task));
+        write_queue_entry_free (entry);
+        return;
+    }
+
+    mcp_write_queue_push (self->write_queue, priority, entry);
     process_write_queue (self);
 }
 
@@ -462,7 +548,7 @@ process_write_queue (McpStdioTransport *self)
 {
     WriteQueueEntry *entry;
 
-    if (self->write_in_progress)
+    if (self->current_write != NULL)
     {
         return;
     }
@@ -472,13 +558,13 @@ process_write_queue (McpStdioTransport *self)
         return;
     }
 
-    entry = g_queue_peek_head (self->write_queue);
+    entry = mcp_write_queue_pop (self->write_queue);
     if (entry == NULL)
     {
         return;
     }
 
-    self->write_in_progress = TRUE;
+    self->current_write = entry;
     g_output_stream_write_all_async (self->output,
                                      entry->line,
                                      entry->len,
@@ -497,9 +583,9 @@ stdio_transport_send_message_async (McpTransport        *transport,
 {
     McpStdioTransport *self = MCP_STDIO_TRANSPORT (transport);
     GTask *task;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autofree gchar *json_str = NULL;
     WriteQueueEntry *entry;
+    const gchar *json_str;
+    gsize len;
 
     task = g_task_new (self, cancellable, callback, user_data);
     g_task_set_source_tag (task, stdio_transport_send_message_async);
@@ -515,19 +601,72 @@ stdio_transport_send_message_async (McpTransport        *transport,
     }
 
     /* Serialize message to JSON */
-    generator = json_generator_new ();
-    json_generator_set_root (generator, message);
-    json_str = json_generator_to_data (generator, NULL);
+    mcp_json_writer_reset (self->writer);
+    mcp_json_writer_node (self->writer, message);
+    json_str = mcp_json_writer_get_data (self->writer, &len);
 
     /* Create queue entry */
     entry = g_new0 (WriteQueueEntry, 1);
     entry->task = task;  /* Takes ownership */
-    entry->line = g_strdup_printf ("%s\n", json_str);
-    entry->len = strlen (entry->line);
+    entry->line = g_malloc (len + 1);
+    memcpy (entry->line, json_str, len);
+    entry->line[len] = '\n';
+    entry->len = len + 1;
 
     /* Add to queue and process */
-    g_queue_push_tail (self->write_queue, entry);
-    process_write_queue (self);
+    queue_write (self, entry, mcp_transport_classify_message (message));
+}
+
+static void
+stdio_transport_send_raw_with_priority_async (McpTransport        *transport,
+                                              GBytes              *data,
+                                              McpMessagePriority   priority,
+                                              GCancellable        *cancellable,
+                                              GAsyncReadyCallback  callback,
+                                              gpointer             user_data)
+{
+    McpStdioTransport *self = MCP_STDIO_TRANSPORT (transport);
+    GTask *task;
+    WriteQueueEntry *entry;
+    const gchar *bytes;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, stdio_transport_send_raw_with_priority_async);
+
+    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    {
+        g_task_return_new_error (task,
+                                 MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport is not connected");
+        g_object_unref (task);
+        return;
+    }
+
+    /* Already serialized: just append the line terminator */
+    bytes = g_bytes_get_data (data, &len);
+
+    entry = g_new0 (WriteQueueEntry, 1);
+    entry->task = task;  /* Takes ownership */
+    entry->line = g_malloc (len + 1);
+    memcpy (entry->line, bytes, len);
+    entry->line[len] = '\n';
+    entry->len = len + 1;
+
+    queue_write (self, entry, priority);
+}
+
+static void
+stdio_transport_send_raw_async (McpTransport        *transport,
+                                GBytes              *data,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+    stdio_transport_send_raw_with_priority_async (transport, data,
+                                                  mcp_transport_classify_raw (data),
+                                                  cancellable, callback, user_data);
 }
 
 static gboolean
@@ -550,61 +689,38 @@ mcp_stdio_transport_iface_init (McpTransportInterface *iface)
     iface->disconnect_finish = stdio_transport_disconnect_finish;
     iface->send_message_async = stdio_transport_send_message_async;
     iface->send_message_finish = stdio_transport_send_message_finish;
+    iface->send_raw_async = stdio_transport_send_raw_async;
+    iface->send_raw_finish = stdio_transport_send_message_finish;
+    iface->send_raw_with_priority_async = stdio_transport_send_raw_with_priority_async;
 }
 
 /*
  * Read loop for receiving messages.
  */
 
+/*
+ * handle_line:
+ *
+ * Parses one line (without its terminator) and emits it.  Empty lines
+ * are skipped; parse errors are reported and do not stop reading.
+ */
 static void
-read_line_cb (GObject      *source,
-              GAsyncResult *result,
-              gpointer      user_data)
+handle_line (McpStdioTransport *self,
+             const gchar       *line,
+             gsize              length)
 {
-    GDataInputStream *data_input = G_DATA_INPUT_STREAM (source);
-    McpStdioTransport *self = MCP_STDIO_TRANSPORT (user_data);
-    g_autofree gchar *line = NULL;
     g_autoptr(GError) error = NULL;
-    g_autoptr(JsonParser) parser = NULL;
-    JsonNode *root;
-    gsize length;
-
-    line = g_data_input_stream_read_line_finish (data_input, result, &length, &error);
-
-    /* Check for cancellation or EOF */
-    if (line == NULL)
-    {
-        if (error != NULL)
-        {
-            if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-            {
-                mcp_transport_emit_error (MCP_TRANSPORT (self), error);
-                set_state (self, MCP_TRANSPORT_STATE_ERROR);
-            }
-        }
-        else
-        {
-            /* EOF - remote end closed connection */
-            g_autoptr(GError) eof_error = NULL;
-            eof_error = g_error_new (MCP_ERROR,
-                                     MCP_ERROR_CONNECTION_CLOSED,
-                                     "Remote end closed connection");
-            mcp_transport_emit_error (MCP_TRANSPORT (self), eof_error);
-            set_state (self, MCP_TRANSPORT_STATE_DISCONNECTED);
-        }
-        return;
-    }
+    g_autoptr(JsonNode) root = NULL;
 
     /* Skip empty lines */
     if (length == 0)
     {
-        start_read_loop (self);
         return;
     }
 
     /* Parse JSON */
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, line, length, &error))
+    root = mcp_json_parse (line, length, &error);
+    if (root == NULL)
     {
         g_autoptr(GError) parse_error = NULL;
         parse_error = g_error_new (MCP_ERROR,
@@ -612,30 +728,126 @@ read_line_cb (GObject      *source,
                                    "Failed to parse JSON: %s",
                                    error->message);
         mcp_transport_emit_error (MCP_TRANSPORT (self), parse_error);
-        /* Continue reading despite parse error */
-        start_read_loop (self);
         return;
     }
 
-    root = json_parser_get_root (parser);
-    if (root == NULL)
+    /* Emit message-received signal */
+    mcp_transport_emit_message_received (MCP_TRANSPORT (self), root);
+}
+
+/*
+ * handle_read_end:
+ *
+ * Reports end of stream (@error %NULL) or a read error.
+ */
+static void
+handle_read_end (McpStdioTransport *self,
+                 const GError      *error)
+{
+    if (error != NULL)
     {
-        g_autoptr(GError) parse_error = NULL;
-        parse_error = g_error_new (MCP_ERROR,
-                                   MCP_ERROR_PARSE_ERROR,
-                                   "Empty JSON root");
-        mcp_transport_emit_error (MCP_TRANSPORT (self), parse_error);
-        start_read_loop (self);
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            mcp_transport_emit_error (MCP_TRANSPORT (self), error);
+            set_state (self, MCP_TRANSPORT_STATE_ERROR);
+        }
+    }
+    else
+    {
+        /* EOF - remote end closed connection */
+        g_autoptr(GError) eof_error = NULL;
+        eof_error = g_error_new (MCP_ERROR,
+                                 MCP_ERROR_CONNECTION_CLOSED,
+                                 "Remote end closed connection");
+        mcp_transport_emit_error (MCP_TRANSPORT (self), eof_error);
+        set_state (self, MCP_TRANSPORT_STATE_DISCONNECTED);
+    }
+}
+
+static void
+read_line_cb (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    GDataInputStream *data_input = G_DATA_INPUT_STREAM (source);
+    McpStdioTransport *self = MCP_STDIO_TRANSPORT (user_data);
+    g_autofree gchar *line = NULL;
+    g_autoptr(GError) error = NULL;
+    gsize length;
+
+    line = g_data_input_stream_read_line_finish (data_input, result, &length, &error);
+
+    /* Check for cancellation or EOF */
+    if (line == NULL)
+    {
+        handle_read_end (self, error);
         return;
     }
 
-    /* Emit message-received signal */
-    mcp_transport_emit_message_received (MCP_TRANSPORT (self), root);
+    handle_line (self, line, length);
 
     /* Continue read loop */
     start_read_loop (self);
 }
 
+/*
+ * on_uring_read:
+ *
+ * Receives raw chunks from the io_uring channel and splits them into
+ * lines.  A partial line waits in read_buffer for the next chunk.
+ */
+static void
+on_uring_read (const gchar  *data,
+               gsize         length,
+               const GError *error,
+               gpointer      user_data)
+{
+    McpStdioTransport *self = MCP_STDIO_TRANSPORT (user_data);
+    g_autoptr(McpStdioTransport) keep_alive = g_object_ref (self);
+    g_autoptr(GByteArray) buffer = g_byte_array_ref (self->read_buffer);
+    const guint8 *newline;
+    gsize start;
+    gsize scan;
+
+    if (data == NULL)
+    {
+        /* Like g_data_input_stream_read_line(), hand out a final
+         * unterminated line before reporting the end */
+        if (error == NULL && buffer->len > 0)
+        {
+            handle_line (self, (const gchar *) buffer->data, buffer->len);
+            g_byte_array_set_size (buffer, 0);
+        }
+        if (self->state == MCP_TRANSPORT_STATE_CONNECTED)
+        {
+            handle_read_end (self, error);
+        }
+        return;
+    }
+
+    g_byte_array_append (buffer, (const guint8 *) data, length);
+
+    start = 0;
+    scan = buffer->len - length;
+    while ((newline = memchr (buffer->data + scan, '\n',
+                              buffer->len - scan)) != NULL)
+    {
+        gsize end = newline - buffer->data;
+
+        handle_line (self, (const gchar *) buffer->data + start, end - start);
+        start = scan = end + 1;
+
+        /* A handler may have disconnected us */
+        if (self->state != MCP_TRANSPORT_STATE_CONNECTED ||
+            self->read_buffer != buffer)
+        {
+            return;
+        }
+    }
+
+    g_byte_array_remove_range (buffer, 0, start);
+}
+
 static void
 start_read_loop (McpStdioTransport *self)
 {
@@ -644,6 +856,12 @@ start_read_loop (McpStdioTransport *self)
         return;
     }
 
+    if (self->uring_channel != NULL)
+    {
+        mcp_uring_channel_start (self->uring_channel);
+        return;
+    }
+
     if (self->read_cancellable == NULL ||
         g_cancellable_is_cancelled (self->read_cancellable))
     {
@@ -672,6 +890,32 @@ start_read_loop_idle (gpointer user_data)
     return G_SOURCE_REMOVE;
 }
 
+/*
+ * open_uring_channel:
+ *
+ * Returns an io_uring channel over the streams' file descriptors, or
+ * %NULL when either stream is not descriptor-based (memory streams,
+ * buffered wrappers) or the backend is unavailable.
+ */
+static McpUringChannel *
+open_uring_channel (McpStdioTransport *self)
+{
+#ifdef _WIN32
+    return NULL;
+#else
+    if (!G_IS_FILE_DESCRIPTOR_BASED (self->input) ||
+        !G_IS_FILE_DESCRIPTOR_BASED (self->output))
+    {
+        return NULL;
+    }
+
+    return mcp_uring_channel_new (
+        g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (self->input)),
+        g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (self->output)),
+        on_uring_read, self);
+#endif
+}
+
 /*
  * Public constructors.
  */
@@ -742,6 +986,25 @@ mcp_stdio_transport_new_with_streams (GInputStream  *input,
 McpStdioTransport *
 mcp_stdio_transport_new_subprocess (const gchar * const *command,
                                     GError             **error)
+{
+    return mcp_stdio_transport_new_subprocess_full (command, NULL, error);
+}
+
+/**
+ * mcp_stdio_transport_new_subprocess_full:
+ * @command: (array zero-terminated=1): the command to execute
+ * @working_directory: (nullable): directory to run it in
+ * @error: (nullable): return location for a #GError
+ *
+ * Creates a new stdio transport that spawns a subprocess in
+ * @working_directory.
+ *
+ * Returns: (transfer full) (nullable): a new #McpStdioTransport, or %NULL on error
+ */
+McpStdioTransport *
+mcp_stdio_transport_new_subprocess_full (const gchar * const *command,
+                                         const gchar         *working_directory,
+                                         GError             **error)
 {
     McpStdioTransport *self;
     g_autoptr(GSubprocessLauncher) launcher = NULL;
@@ -761,6 +1024,11 @@ mcp_stdio_transport_new_subprocess (const gchar * const *command,
      */
     g_subprocess_launcher_unsetenv (launcher, "G_MESSAGES_DEBUG");
 
+    if (working_directory != NULL)
+    {
+        g_subprocess_launcher_set_cwd (launcher, working_directory);
+    }
+
     subprocess = g_subprocess_launcher_spawnv (launcher, command, error);
     if (subprocess == NULL)
     {
@@ -851,3 +1119,20 @@ mcp_stdio_transport_get_output_stream (McpStdioTransport *self)
 
     return self->output;
 }
+
+/**
+ * mcp_stdio_transport_get_uses_io_uring:
+ * @self: an #McpStdioTransport
+ *
+ * Gets whether the transport moves its data through the io_uring
+ * backend rather than its streams.
+ *
+ * Returns: %TRUE while connected through io_uring
+ */
+gboolean
+mcp_stdio_transport_get_uses_io_uring (McpStdioTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_STDIO_TRANSPORT (self), FALSE);
+
+    return self->uring_channel != NULL;
+}
@@ -64,6 +64,23 @@ McpStdioTransport *mcp_stdio_transport_new_with_streams (GInputStream  *input,
 McpStdioTransport *mcp_stdio_transport_new_subprocess (const gchar * const *command,
                                                         GError             **error);
 
+/**
+ * mcp_stdio_transport_new_subprocess_full:
+ * @command: (array zero-terminated=1): the command to execute
+ * @working_directory: (nullable): directory to run the command in, or
+ *   %NULL for the current one
+ * @error: (nullable): return location for a #GError
+ *
+ * Like mcp_stdio_transport_new_subprocess(), but runs the command in
+ * @working_directory without changing the caller's.  A relative
+ * @command is resolved there too.
+ *
+ * Returns: (transfer full) (nullable): a new #McpStdioTransport, or %NULL on error
+ */
+McpStdioTransport *mcp_stdio_transport_new_subprocess_full (const gchar * const *command,
+                                                             const gchar         *working_directory,
+                                                             GError             **error);
+
 /**
  * mcp_stdio_transport_new_subprocess_simple:
  * @command_line: the command line to execute (parsed by shell rules)
@@ -108,6 +125,19 @@ GInputStream *mcp_stdio_transport_get_input_stream (McpStdioTransport *self);
  */
 GOutputStream *mcp_stdio_transport_get_output_stream (McpStdioTransport *self);
 
+/**
+ * mcp_stdio_transport_get_uses_io_uring:
+ * @self: an #McpStdioTransport
+ *
+ * Gets whether the transport moves its data through the io_uring
+ * backend rather than its streams.  This is decided on connect: both
+ * streams must wrap sockets or blocking pipes (#GFileDescriptorBased)
+ * and mcp_uring_is_available() must return %TRUE.
+ *
+ * Returns: %TRUE while connected through io_uring
+ */
+gboolean mcp_stdio_transport_get_uses_io_uring (McpStdioTransport *self);
+
 G_END_DECLS
 
 #endif /* MCP_STDIO_TRANSPORT_H */
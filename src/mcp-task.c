@@ -593,6 +593,69 @@ mcp_task_to_json (McpTask *self)
     return result;
 }
 
+/**
+ * mcp_task_write_json:
+ * @self: an #McpTask
+ * @writer: a #McpJsonWriter
+ *
+ * Writes the task to @writer, matching mcp_task_to_json().
+ */
+void
+mcp_task_write_json (McpTask       *self,
+                     McpJsonWriter *writer)
+{
+    McpTaskPrivate *priv;
+    gchar *iso_str;
+
+    g_return_if_fail (MCP_IS_TASK (self));
+    g_return_if_fail (writer != NULL);
+
+    priv = mcp_task_get_instance_private (self);
+
+    mcp_json_writer_begin_object (writer);
+
+    mcp_json_writer_member (writer, "taskId");
+    mcp_json_writer_string (writer, priv->task_id ? priv->task_id : "");
+
+    mcp_json_writer_member (writer, "status");
+    mcp_json_writer_string (writer, mcp_task_status_to_string (priv->status));
+
+    if (priv->status_message != NULL)
+    {
+        mcp_json_writer_member (writer, "statusMessage");
+        mcp_json_writer_string (writer, priv->status_message);
+    }
+
+    mcp_json_writer_member (writer, "createdAt");
+    iso_str = g_date_time_format_iso8601 (priv->created_at);
+    mcp_json_writer_string (writer, iso_str);
+    g_free (iso_str);
+
+    mcp_json_writer_member (writer, "lastUpdatedAt");
+    iso_str = g_date_time_format_iso8601 (priv->last_updated_at);
+    mcp_json_writer_string (writer, iso_str);
+    g_free (iso_str);
+
+    /* null for unlimited */
+    mcp_json_writer_member (writer, "ttl");
+    if (priv->ttl >= 0)
+    {
+        mcp_json_writer_int (writer, priv->ttl);
+    }
+    else
+    {
+        mcp_json_writer_null (writer);
+    }
+
+    if (priv->poll_interval >= 0)
+    {
+        mcp_json_writer_member (writer, "pollInterval");
+        mcp_json_writer_int (writer, priv->poll_interval);
+    }
+
+    mcp_json_writer_end_object (writer);
+}
+
 /**
  * mcp_task_new_from_json:
  * @node: a #JsonNode containing a task definition
@@ -13,6 +13,7 @@
 
 #include <glib-object.h>
 #include <json-glib/json-glib.h>
+#include "mcp-json-writer.h"
 
 G_BEGIN_DECLS
 
@@ -206,6 +207,17 @@ void mcp_task_update_timestamp (McpTask *self);
  */
 JsonNode *mcp_task_to_json (McpTask *self);
 
+/**
+ * mcp_task_write_json:
+ * @self: an #McpTask
+ * @writer: a #McpJsonWriter
+ *
+ * Writes the task to @writer as one JSON value, matching
+ * mcp_task_to_json().
+ */
+void mcp_task_write_json (McpTask       *self,
+                          McpJsonWriter *writer);
+
 /**
  * mcp_task_new_from_json:
  * @node: a #JsonNode containing a task definition
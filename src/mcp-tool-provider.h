@@ -127,6 +127,17 @@ JsonArray *mcp_tool_result_get_content (McpToolResult *result);
  */
 JsonNode *mcp_tool_result_to_json (McpToolResult *result);
 
+/**
+ * mcp_tool_result_write_json:
+ * @result: a #McpToolResult
+ * @writer: a #McpJsonWriter
+ *
+ * Writes the result to @writer as one JSON value, matching
+ * mcp_tool_result_to_json().
+ */
+void mcp_tool_result_write_json (McpToolResult *result,
+                                 McpJsonWriter *writer);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (McpToolResult, mcp_tool_result_unref)
 
 /**
@@ -49,8 +49,8 @@ mcp_tool_finalize (GObject *object)
     g_clear_pointer (&priv->name, g_free);
     g_clear_pointer (&priv->title, g_free);
     g_clear_pointer (&priv->description, g_free);
-    g_clear_pointer (&priv->input_schema, json_node_unref);
-    g_clear_pointer (&priv->output_schema, json_node_unref);
+    g_clear_pointer (&priv->input_schema, mcp_json_intern_release);
+    g_clear_pointer (&priv->output_schema, mcp_json_intern_release);
 
     G_OBJECT_CLASS (mcp_tool_parent_class)->finalize (object);
 }
@@ -98,6 +98,17 @@ mcp_tool_get_property (GObject    *object,
     }
 }
 
+/*
+ * Schemas are kept as shared, sealed instances: identical schemas and
+ * sub-schemas across tools and sessions are stored once, and handing
+ * one out is a reference rather than a copy.
+ */
+static JsonNode *
+intern_schema (JsonNode *schema)
+{
+    return schema != NULL ? mcp_json_intern (schema) : NULL;
+}
+
 static void
 mcp_tool_set_property (GObject      *object,
                        guint         prop_id,
@@ -122,12 +133,12 @@ mcp_tool_set_property (GObject      *object,
         priv->description = g_value_dup_string (value);
         break;
     case PROP_INPUT_SCHEMA:
-        g_clear_pointer (&priv->input_schema, json_node_unref);
-        priv->input_schema = g_value_dup_boxed (value);
+        g_clear_pointer (&priv->input_schema, mcp_json_intern_release);
+        priv->input_schema = intern_schema (g_value_get_boxed (value));
         break;
     case PROP_OUTPUT_SCHEMA:
-        g_clear_pointer (&priv->output_schema, json_node_unref);
-        priv->output_schema = g_value_dup_boxed (value);
+        g_clear_pointer (&priv->output_schema, mcp_json_intern_release);
+        priv->output_schema = intern_schema (g_value_get_boxed (value));
         break;
     case PROP_READ_ONLY_HINT:
         priv->read_only_hint = g_value_get_boolean (value);
@@ -654,7 +665,7 @@ mcp_tool_to_json (McpTool *self)
     json_builder_set_member_name (builder, "inputSchema");
     if (priv->input_schema != NULL)
     {
-        json_builder_add_value (builder, json_node_copy (priv->input_schema));
+        json_builder_add_value (builder, json_node_ref (priv->input_schema));
     }
     else
     {
@@ -668,7 +679,7 @@ mcp_tool_to_json (McpTool *self)
     if (priv->output_schema != NULL)
     {
         json_builder_set_member_name (builder, "outputSchema");
-        json_builder_add_value (builder, json_node_copy (priv->output_schema));
+        json_builder_add_value (builder, json_node_ref (priv->output_schema));
     }
 
     /* Optional: annotations (only include if non-default) */
@@ -719,6 +730,104 @@ mcp_tool_to_json (McpTool *self)
     return result;
 }
 
+/**
+ * mcp_tool_write_json:
+ * @self: an #McpTool
+ * @writer: a #McpJsonWriter
+ *
+ * Writes the tool definition to @writer.  The schemas are written
+ * from the stored trees without copying them.
+ */
+void
+mcp_tool_write_json (McpTool       *self,
+                     McpJsonWriter *writer)
+{
+    McpToolPrivate *priv;
+
+    g_return_if_fail (MCP_IS_TOOL (self));
+    g_return_if_fail (writer != NULL);
+
+    priv = mcp_tool_get_instance_private (self);
+
+    mcp_json_writer_begin_object (writer);
+
+    mcp_json_writer_member (writer, "name");
+    mcp_json_writer_string (writer, priv->name ? priv->name : "");
+
+    if (priv->title != NULL)
+    {
+        mcp_json_writer_member (writer, "title");
+        mcp_json_writer_string (writer, priv->title);
+    }
+
+    if (priv->description != NULL)
+    {
+        mcp_json_writer_member (writer, "description");
+        mcp_json_writer_string (writer, priv->description);
+    }
+
+    mcp_json_writer_member (writer, "inputSchema");
+    if (priv->input_schema != NULL)
+    {
+        mcp_json_writer_node (writer, priv->input_schema);
+    }
+    else
+    {
+        mcp_json_writer_begin_object (writer);
+        mcp_json_writer_member (writer, "type");
+        mcp_json_writer_string (writer, "object");
+        mcp_json_writer_end_object (writer);
+    }
+
+    if (priv->output_schema != NULL)
+    {
+        mcp_json_writer_member (writer, "outputSchema");
+        mcp_json_writer_node (writer, priv->output_schema);
+    }
+
+    /* Same rule as mcp_tool_to_json(): only non-default annotations */
+    if (priv->read_only_hint || !priv->destructive_hint ||
+        priv->idempotent_hint || !priv->open_world_hint || priv->title != NULL)
+    {
+        mcp_json_writer_member (writer, "annotations");
+        mcp_json_writer_begin_object (writer);
+
+        if (priv->title != NULL)
+        {
+            mcp_json_writer_member (writer, "title");
+            mcp_json_writer_string (writer, priv->title);
+        }
+
+        if (priv->read_only_hint)
+        {
+            mcp_json_writer_member (writer, "readOnlyHint");
+            mcp_json_writer_boolean (writer, TRUE);
+        }
+
+        if (!priv->destructive_hint)
+        {
+            mcp_json_writer_member (writer, "destructiveHint");
+            mcp_json_writer_boolean (writer, FALSE);
+        }
+
+        if (priv->idempotent_hint)
+        {
+            mcp_json_writer_member (writer, "idempotentHint");
+            mcp_json_writer_boolean (writer, TRUE);
+        }
+
+        if (!priv->open_world_hint)
+        {
+            mcp_json_writer_member (writer, "openWorldHint");
+            mcp_json_writer_boolean (writer, FALSE);
+        }
+
+        mcp_json_writer_end_object (writer);
+    }
+
+    mcp_json_writer_end_object (writer);
+}
+
 /**
  * mcp_tool_new_from_json:
  * @node: a #JsonNode containing a tool definition
@@ -11,6 +11,7 @@
 
 #include <glib-object.h>
 #include <json-glib/json-glib.h>
+#include "mcp-json-writer.h"
 
 G_BEGIN_DECLS
 
@@ -108,7 +109,8 @@ void mcp_tool_set_description (McpTool     *self,
  * mcp_tool_get_input_schema:
  * @self: an #McpTool
  *
- * Gets the JSON Schema defining expected input parameters.
+ * Gets the JSON Schema defining expected input parameters.  The
+ * schema is immutable and may be shared with other tools.
  *
  * Returns: (transfer none) (nullable): the input schema as a #JsonNode
  */
@@ -119,7 +121,9 @@ JsonNode *mcp_tool_get_input_schema (McpTool *self);
  * @self: an #McpTool
  * @schema: (nullable): a #JsonNode containing the JSON Schema
  *
- * Sets the JSON Schema defining expected input parameters.
+ * Sets the JSON Schema defining expected input parameters.  The tool
+ * keeps an interned copy (see mcp_json_intern()), so @schema may be
+ * changed or freed afterwards.
  */
 void mcp_tool_set_input_schema (McpTool  *self,
                                 JsonNode *schema);
@@ -128,7 +132,8 @@ void mcp_tool_set_input_schema (McpTool  *self,
  * mcp_tool_get_output_schema:
  * @self: an #McpTool
  *
- * Gets the JSON Schema defining the tool's structured output.
+ * Gets the JSON Schema defining the tool's structured output.  The
+ * schema is immutable and may be shared with other tools.
  *
  * Returns: (transfer none) (nullable): the output schema as a #JsonNode
  */
@@ -139,7 +144,8 @@ JsonNode *mcp_tool_get_output_schema (McpTool *self);
  * @self: an #McpTool
  * @schema: (nullable): a #JsonNode containing the JSON Schema
  *
- * Sets the JSON Schema defining the tool's structured output.
+ * Sets the JSON Schema defining the tool's structured output.  The
+ * tool keeps an interned copy, like mcp_tool_set_input_schema().
  */
 void mcp_tool_set_output_schema (McpTool  *self,
                                  JsonNode *schema);
@@ -236,6 +242,17 @@ void mcp_tool_set_open_world_hint (McpTool  *self,
  */
 JsonNode *mcp_tool_to_json (McpTool *self);
 
+/**
+ * mcp_tool_write_json:
+ * @self: an #McpTool
+ * @writer: a #McpJsonWriter
+ *
+ * Writes the tool definition to @writer as one JSON value.  The
+ * output matches mcp_tool_to_json() without building a tree.
+ */
+void mcp_tool_write_json (McpTool       *self,
+                          McpJsonWriter *writer);
+
 /**
  * mcp_tool_new_from_json:
  * @node: a #JsonNode containing a tool definition
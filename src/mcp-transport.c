@@ -6,8 +6,11 @@
  */
 #include "mcp-transport.h"
 #include "mcp-error.h"
+#include "mcp-json-parse.h"
 #undef MCP_COMPILATION
 
+#include <string.h>
+
 /**
  * SECTION:mcp-transport
  * @title: McpTransport
@@ -272,6 +275,377 @@ mcp_transport_send_message_finish (McpTransport  *self,
     return iface->send_message_finish (self, result, error);
 }
 
+static void
+send_raw_fallback_cb (GObject      *source,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+    g_autoptr(GTask) task = user_data;
+    GError *error = NULL;
+
+    if (!mcp_transport_send_message_finish (MCP_TRANSPORT (source), result, &error))
+    {
+        g_task_return_error (task, error);
+        return;
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * mcp_transport_send_raw_async:
+ * @self: an #McpTransport
+ * @data: one serialized JSON-RPC message, without a trailing newline
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call when complete
+ * @user_data: (closure): user data for @callback
+ *
+ * Sends a message that is already serialized.  Transports without a
+ * raw send path parse @data and send the resulting #JsonNode.
+ */
+void
+mcp_transport_send_raw_async (McpTransport        *self,
+                              GBytes              *data,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+    McpTransportInterface *iface;
+    g_autoptr(JsonNode) root = NULL;
+    g_autoptr(GError) error = NULL;
+    const gchar *bytes;
+    gsize len;
+    GTask *task;
+
+    g_return_if_fail (MCP_IS_TRANSPORT (self));
+    g_return_if_fail (data != NULL);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+
+    if (iface->send_raw_async != NULL)
+    {
+        iface->send_raw_async (self, data, cancellable, callback, user_data);
+        return;
+    }
+
+    g_return_if_fail (iface->send_message_async != NULL);
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_transport_send_raw_async);
+
+    bytes = g_bytes_get_data (data, &len);
+    root = mcp_json_parse (bytes, (gssize)len, &error);
+    if (root == NULL)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_PARSE_ERROR,
+                                 "Invalid JSON message: %s", error->message);
+        g_object_unref (task);
+        return;
+    }
+
+    iface->send_message_async (self, root, cancellable,
+                               send_raw_fallback_cb, task);
+}
+
+/**
+ * mcp_transport_send_raw_finish:
+ * @self: an #McpTransport
+ * @result: the #GAsyncResult
+ * @error: (nullable): return location for a #GError
+ *
+ * Completes an asynchronous raw send.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean
+mcp_transport_send_raw_finish (McpTransport  *self,
+                               GAsyncResult  *result,
+                               GError       **error)
+{
+    McpTransportInterface *iface;
+
+    g_return_val_if_fail (MCP_IS_TRANSPORT (self), FALSE);
+    g_return_val_if_fail (G_IS_ASYNC_RESULT (result), FALSE);
+
+    if (g_async_result_is_tagged (result, mcp_transport_send_raw_async))
+    {
+        return g_task_propagate_boolean (G_TASK (result), error);
+    }
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    g_return_val_if_fail (iface->send_raw_finish != NULL, FALSE);
+
+    return iface->send_raw_finish (self, result, error);
+}
+
+/**
+ * mcp_transport_send_raw_with_priority_async:
+ * @self: an #McpTransport
+ * @data: one serialized JSON-RPC message, without a trailing newline
+ * @priority: the #McpMessagePriority of @data
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call when complete
+ * @user_data: (closure): user data for @callback
+ *
+ * Sends @data in the lane given by @priority.  Transports that do not
+ * queue by priority send it like mcp_transport_send_raw_async().
+ */
+void
+mcp_transport_send_raw_with_priority_async (McpTransport        *self,
+                                            GBytes              *data,
+                                            McpMessagePriority   priority,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data)
+{
+    McpTransportInterface *iface;
+
+    g_return_if_fail (MCP_IS_TRANSPORT (self));
+    g_return_if_fail (data != NULL);
+    g_return_if_fail (priority <= MCP_MESSAGE_PRIORITY_LOW);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+
+    if (iface->send_raw_with_priority_async != NULL)
+    {
+        iface->send_raw_with_priority_async (self, data, priority, cancellable,
+                                             callback, user_data);
+        return;
+    }
+
+    mcp_transport_send_raw_async (self, data, cancellable, callback, user_data);
+}
+
+static McpMessagePriority
+priority_for_method (const gchar *method,
+                     gsize        len)
+{
+    static const gchar prefix[] = "notifications/";
+    const gsize prefix_len = sizeof prefix - 1;
+
+    if (len < prefix_len || memcmp (method, prefix, prefix_len) != 0)
+    {
+        return MCP_MESSAGE_PRIORITY_HIGH;
+    }
+
+    method += prefix_len;
+    len -= prefix_len;
+    if ((len == 8 && memcmp (method, "progress", 8) == 0) ||
+        (len == 7 && memcmp (method, "message", 7) == 0))
+    {
+        return MCP_MESSAGE_PRIORITY_LOW;
+    }
+
+    /* Requests sent after these must not overtake them: a cancelled
+     * request must not be answered as if it were still wanted, and
+     * nothing but pings may come before initialized */
+    if ((len == 9 && memcmp (method, "cancelled", 9) == 0) ||
+        (len == 11 && memcmp (method, "initialized", 11) == 0))
+    {
+        return MCP_MESSAGE_PRIORITY_HIGH;
+    }
+
+    return MCP_MESSAGE_PRIORITY_NORMAL;
+}
+
+/**
+ * mcp_transport_classify_message:
+ * @message: a JSON-RPC message
+ *
+ * Works out the lane @message is queued in.
+ *
+ * Returns: the #McpMessagePriority of @message
+ */
+McpMessagePriority
+mcp_transport_classify_message (JsonNode *message)
+{
+    JsonNode *member;
+    const gchar *method;
+
+    g_return_val_if_fail (message != NULL, MCP_MESSAGE_PRIORITY_HIGH);
+
+    if (!JSON_NODE_HOLDS_OBJECT (message))
+    {
+        return MCP_MESSAGE_PRIORITY_HIGH;
+    }
+
+    member = json_object_get_member (json_node_get_object (message), "method");
+    if (member == NULL || json_node_get_value_type (member) != G_TYPE_STRING)
+    {
+        return MCP_MESSAGE_PRIORITY_HIGH;
+    }
+    method = json_node_get_string (member);
+
+    return priority_for_method (method, strlen (method));
+}
+
+static gsize
+skip_space (const gchar *json,
+            gsize        len,
+            gsize        i)
+{
+    while (i < len && g_ascii_isspace (json[i]))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/* Returns the index just past the string that opens at @i */
+static gsize
+skip_string (const gchar *json,
+             gsize        len,
+             gsize        i)
+{
+    for (i++; i < len; i++)
+    {
+        if (json[i] == '\\')
+        {
+            i++;
+        }
+        else if (json[i] == '"')
+        {
+            return i + 1;
+        }
+    }
+
+    return len;
+}
+
+/* Returns the index just past the member value that starts at @i */
+static gsize
+skip_value (const gchar *json,
+            gsize        len,
+            gsize        i)
+{
+    guint depth = 0;
+
+    while (i < len)
+    {
+        switch (json[i])
+        {
+        case '"':
+            i = skip_string (json, len, i);
+            if (depth == 0)
+            {
+                return i;
+            }
+            continue;
+
+        case '{':
+        case '[':
+            depth++;
+            break;
+
+        case '}':
+        case ']':
+            if (depth == 0)
+            {
+                return i;
+            }
+            if (--depth == 0)
+            {
+                return i + 1;
+            }
+            break;
+
+        case ',':
+            if (depth == 0)
+            {
+                return i;
+            }
+            break;
+
+        default:
+            break;
+        }
+        i++;
+    }
+
+    return len;
+}
+
+/**
+ * mcp_transport_classify_raw:
+ * @data: one serialized JSON-RPC message
+ *
+ * Works out the lane @data is queued in, without parsing it.
+ *
+ * Returns: the #McpMessagePriority of @data
+ */
+McpMessagePriority
+mcp_transport_classify_raw (GBytes *data)
+{
+    const gchar *json;
+    gsize len;
+    gsize i;
+
+    g_return_val_if_fail (data != NULL, MCP_MESSAGE_PRIORITY_HIGH);
+
+    json = g_bytes_get_data (data, &len);
+    i = skip_space (json, len, 0);
+    if (i >= len || json[i] != '{')
+    {
+        return MCP_MESSAGE_PRIORITY_HIGH;
+    }
+    i++;
+
+    for (;;)
+    {
+        const gchar *key;
+        gsize key_len;
+
+        i = skip_space (json, len, i);
+        if (i >= len || json[i] != '"')
+        {
+            return MCP_MESSAGE_PRIORITY_HIGH;
+        }
+        key = json + i + 1;
+        i = skip_string (json, len, i);
+        if (i >= len)
+        {
+            return MCP_MESSAGE_PRIORITY_HIGH;
+        }
+        key_len = (json + i - 1) - key;
+
+        i = skip_space (json, len, i);
+        if (i >= len || json[i] != ':')
+        {
+            return MCP_MESSAGE_PRIORITY_HIGH;
+        }
+        i = skip_space (json, len, i + 1);
+
+        if (key_len == 6 && memcmp (key, "method", 6) == 0)
+        {
+            const gchar *method;
+
+            if (i >= len || json[i] != '"')
+            {
+                return MCP_MESSAGE_PRIORITY_HIGH;
+            }
+            method = json + i + 1;
+            i = skip_string (json, len, i);
+
+            return priority_for_method (method, (json + i - 1) - method);
+        }
+
+        /* Only responses have these, and they can be large */
+        if ((key_len == 6 && memcmp (key, "result", 6) == 0) ||
+            (key_len == 5 && memcmp (key, "error", 5) == 0))
+        {
+            return MCP_MESSAGE_PRIORITY_HIGH;
+        }
+
+        i = skip_space (json, len, skip_value (json, len, i));
+        if (i >= len || json[i] != ',')
+        {
+            return MCP_MESSAGE_PRIORITY_HIGH;
+        }
+        i++;
+    }
+}
+
 /**
  * mcp_transport_is_connected:
  * @self: an #McpTransport
@@ -288,6 +662,454 @@ mcp_transport_is_connected (McpTransport *self)
     return mcp_transport_get_state (self) == MCP_TRANSPORT_STATE_CONNECTED;
 }
 
+/**
+ * mcp_transport_supports_fd_passing:
+ * @self: an #McpTransport
+ *
+ * Checks whether @self can pass file descriptors to its peer.
+ *
+ * Returns: %TRUE if file descriptors can be passed
+ */
+gboolean
+mcp_transport_supports_fd_passing (McpTransport *self)
+{
+    McpTransportInterface *iface;
+
+    g_return_val_if_fail (MCP_IS_TRANSPORT (self), FALSE);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    return iface->send_fd != NULL && iface->receive_fd != NULL;
+}
+
+/**
+ * mcp_transport_send_fd:
+ * @self: an #McpTransport
+ * @fd: the file descriptor to pass
+ * @error: (nullable): return location for a #GError
+ *
+ * Passes a duplicate of @fd to the peer.
+ *
+ * Returns: a handle for the peer, or -1 on error
+ */
+gint
+mcp_transport_send_fd (McpTransport  *self,
+                       gint           fd,
+                       GError       **error)
+{
+    McpTransportInterface *iface;
+
+    g_return_val_if_fail (MCP_IS_TRANSPORT (self), -1);
+    g_return_val_if_fail (fd >= 0, -1);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    if (iface->send_fd == NULL)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                     "%s cannot pass file descriptors",
+                     G_OBJECT_TYPE_NAME (self));
+        return -1;
+    }
+
+    return iface->send_fd (self, fd, error);
+}
+
+/**
+ * mcp_transport_receive_fd:
+ * @self: an #McpTransport
+ * @handle: a handle from the peer
+ * @error: (nullable): return location for a #GError
+ *
+ * Takes a file descriptor the peer passed.
+ *
+ * Returns: the file descriptor, or -1 on error
+ */
+gint
+mcp_transport_receive_fd (McpTransport  *self,
+                          gint           handle,
+                          GError       **error)
+{
+    McpTransportInterface *iface;
+
+    g_return_val_if_fail (MCP_IS_TRANSPORT (self), -1);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    if (iface->receive_fd == NULL)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                     "%s cannot pass file descriptors",
+                     G_OBJECT_TYPE_NAME (self));
+        return -1;
+    }
+
+    return iface->receive_fd (self, handle, error);
+}
+
+/**
+ * mcp_transport_publish_download:
+ * @self: an #McpTransport
+ * @data: the bytes to serve
+ * @mime_type: (nullable): the content type
+ * @error: (nullable): return location for a #GError
+ *
+ * Serves @data to the peer at a short-lived URL.
+ *
+ * Returns: (transfer full) (nullable): the URL, or %NULL on error
+ */
+gchar *
+mcp_transport_publish_download (McpTransport  *self,
+                                GBytes        *data,
+                                const gchar   *mime_type,
+                                GError       **error)
+{
+    McpTransportInterface *iface;
+
+    g_return_val_if_fail (MCP_IS_TRANSPORT (self), NULL);
+    g_return_val_if_fail (data != NULL, NULL);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    if (iface->publish_download == NULL)
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                     "%s cannot serve downloads",
+                     G_OBJECT_TYPE_NAME (self));
+        return NULL;
+    }
+
+    return iface->publish_download (self, data, mime_type, error);
+}
+
+/**
+ * mcp_transport_supports_downloads:
+ * @self: an #McpTransport
+ *
+ * Checks whether @self can fetch the peer's download URLs.
+ *
+ * Returns: %TRUE if downloads can be fetched
+ */
+gboolean
+mcp_transport_supports_downloads (McpTransport *self)
+{
+    McpTransportInterface *iface;
+
+    g_return_val_if_fail (MCP_IS_TRANSPORT (self), FALSE);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    return iface->download_async != NULL && iface->download_finish != NULL;
+}
+
+/**
+ * mcp_transport_download_async:
+ * @self: an #McpTransport
+ * @url: a URL the peer published
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call when complete
+ * @user_data: (closure): user data for @callback
+ *
+ * Fetches data the peer published.
+ */
+void
+mcp_transport_download_async (McpTransport        *self,
+                              const gchar         *url,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+    McpTransportInterface *iface;
+
+    g_return_if_fail (MCP_IS_TRANSPORT (self));
+    g_return_if_fail (url != NULL);
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    if (iface->download_async == NULL)
+    {
+        g_task_report_new_error (self, callback, user_data,
+                                 mcp_transport_download_async,
+                                 MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                                 "%s cannot fetch downloads",
+                                 G_OBJECT_TYPE_NAME (self));
+        return;
+    }
+
+    iface->download_async (self, url, cancellable, callback, user_data);
+}
+
+/**
+ * mcp_transport_download_finish:
+ * @self: an #McpTransport
+ * @result: the #GAsyncResult
+ * @error: (nullable): return location for a #GError
+ *
+ * Completes a download.
+ *
+ * Returns: (transfer full) (nullable): the data, or %NULL on error
+ */
+GBytes *
+mcp_transport_download_finish (McpTransport  *self,
+                               GAsyncResult  *result,
+                               GError       **error)
+{
+    McpTransportInterface *iface;
+
+    g_return_val_if_fail (MCP_IS_TRANSPORT (self), NULL);
+    g_return_val_if_fail (G_IS_ASYNC_RESULT (result), NULL);
+
+    if (g_async_result_is_tagged (result, mcp_transport_download_async))
+    {
+        return g_task_propagate_pointer (G_TASK (result), error);
+    }
+
+    iface = MCP_TRANSPORT_GET_IFACE (self);
+    g_return_val_if_fail (iface->download_finish != NULL, NULL);
+
+    return iface->download_finish (self, result, error);
+}
+
+/*
+ * Write queues
+ */
+
+#define N_LANES (MCP_MESSAGE_PRIORITY_LOW + 1)
+
+struct _McpWriteQueue
+{
+    GQueue lanes[N_LANES];
+    guint  passed[N_LANES];  /* takes from other lanes while this one waited */
+};
+
+/**
+ * mcp_write_queue_new:
+ *
+ * Creates an empty write queue.
+ *
+ * Returns: (transfer full): a new #McpWriteQueue
+ */
+McpWriteQueue *
+mcp_write_queue_new (void)
+{
+    McpWriteQueue *queue;
+    guint lane;
+
+    queue = g_new0 (McpWriteQueue, 1);
+    for (lane = 0; lane < N_LANES; lane++)
+    {
+        g_queue_init (&queue->lanes[lane]);
+    }
+
+    return queue;
+}
+
+/**
+ * mcp_write_queue_free:
+ * @queue: an #McpWriteQueue
+ * @free_func: (nullable): called on every item still queued
+ *
+ * Frees @queue.
+ */
+void
+mcp_write_queue_free (McpWriteQueue  *queue,
+                      GDestroyNotify  free_func)
+{
+    g_return_if_fail (queue != NULL);
+
+    mcp_write_queue_clear (queue, free_func);
+    g_free (queue);
+}
+
+/**
+ * mcp_write_queue_clear:
+ * @queue: an #McpWriteQueue
+ * @free_func: (nullable): called on every item
+ *
+ * Removes every item from @queue.
+ */
+void
+mcp_write_queue_clear (McpWriteQueue  *queue,
+                       GDestroyNotify  free_func)
+{
+    guint lane;
+
+    g_return_if_fail (queue != NULL);
+
+    for (lane = 0; lane < N_LANES; lane++)
+    {
+        if (free_func != NULL)
+        {
+            g_queue_clear_full (&queue->lanes[lane], free_func);
+        }
+        else
+        {
+            g_queue_clear (&queue->lanes[lane]);
+        }
+        queue->passed[lane] = 0;
+    }
+}
+
+/**
+ * mcp_write_queue_push:
+ * @queue: an #McpWriteQueue
+ * @priority: the lane to add @item to
+ * @item: (not nullable): the item
+ *
+ * Adds @item after every item already in its lane.
+ */
+void
+mcp_write_queue_push (McpWriteQueue      *queue,
+                      McpMessagePriority  priority,
+                      gpointer            item)
+{
+    g_return_if_fail (queue != NULL);
+    g_return_if_fail (item != NULL);
+
+    if (priority > MCP_MESSAGE_PRIORITY_LOW)
+    {
+        priority = MCP_MESSAGE_PRIORITY_LOW;
+    }
+
+    g_queue_push_tail (&queue->lanes[priority], item);
+}
+
+/*
+ * The highest non-empty lane, unless a lower one has been passed over
+ * too often.  Returns N_LANES if @queue is empty.
+ */
+static guint
+write_queue_next_lane (McpWriteQueue *queue)
+{
+    guint next = N_LANES;
+    guint lane;
+
+    for (lane = 0; lane < N_LANES; lane++)
+    {
+        if (g_queue_is_empty (&queue->lanes[lane]))
+        {
+            continue;
+        }
+        if (queue->passed[lane] >= MCP_WRITE_QUEUE_MAX_PASSED)
+        {
+            return lane;
+        }
+        if (next == N_LANES)
+        {
+            next = lane;
+        }
+    }
+
+    return next;
+}
+
+/**
+ * mcp_write_queue_peek:
+ * @queue: an #McpWriteQueue
+ *
+ * Gets the item mcp_write_queue_pop() would take next.
+ *
+ * Returns: (transfer none) (nullable): the next item, or %NULL if
+ *   @queue is empty
+ */
+gpointer
+mcp_write_queue_peek (McpWriteQueue *queue)
+{
+    guint lane;
+
+    g_return_val_if_fail (queue != NULL, NULL);
+
+    lane = write_queue_next_lane (queue);
+    if (lane == N_LANES)
+    {
+        return NULL;
+    }
+
+    return g_queue_peek_head (&queue->lanes[lane]);
+}
+
+/**
+ * mcp_write_queue_pop:
+ * @queue: an #McpWriteQueue
+ *
+ * Takes the next item to send.
+ *
+ * Returns: (transfer full) (nullable): the next item, or %NULL if
+ *   @queue is empty
+ */
+gpointer
+mcp_write_queue_pop (McpWriteQueue *queue)
+{
+    guint next;
+    guint lane;
+
+    g_return_val_if_fail (queue != NULL, NULL);
+
+    next = write_queue_next_lane (queue);
+    if (next == N_LANES)
+    {
+        return NULL;
+    }
+
+    for (lane = 0; lane < N_LANES; lane++)
+    {
+        if (lane == next || g_queue_is_empty (&queue->lanes[lane]))
+        {
+            queue->passed[lane] = 0;
+        }
+        else
+        {
+            queue->passed[lane]++;
+        }
+    }
+
+    return g_queue_pop_head (&queue->lanes[next]);
+}
+
+/**
+ * mcp_write_queue_get_length:
+ * @queue: an #McpWriteQueue
+ *
+ * Gets the number of items in @queue.
+ *
+ * Returns: the number of items in every lane
+ */
+guint
+mcp_write_queue_get_length (McpWriteQueue *queue)
+{
+    guint length = 0;
+    guint lane;
+
+    g_return_val_if_fail (queue != NULL, 0);
+
+    for (lane = 0; lane < N_LANES; lane++)
+    {
+        length += g_queue_get_length (&queue->lanes[lane]);
+    }
+
+    return length;
+}
+
+/**
+ * mcp_write_queue_is_empty:
+ * @queue: an #McpWriteQueue
+ *
+ * Checks whether @queue holds no items.
+ *
+ * Returns: %TRUE if @queue is empty
+ */
+gboolean
+mcp_write_queue_is_empty (McpWriteQueue *queue)
+{
+    guint lane;
+
+    g_return_val_if_fail (queue != NULL, TRUE);
+
+    for (lane = 0; lane < N_LANES; lane++)
+    {
+        if (!g_queue_is_empty (&queue->lanes[lane]))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 /*
  * Helper functions for implementations to emit signals.
  */
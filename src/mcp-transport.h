@@ -143,6 +143,137 @@ struct _McpTransportInterface
                                      GAsyncResult  *result,
                                      GError       **error);
 
+    /**
+     * McpTransportInterface::send_raw_async:
+     * @self: an #McpTransport
+     * @data: one serialized JSON-RPC message, without a trailing newline
+     * @cancellable: (nullable): a #GCancellable
+     * @callback: (scope async): callback to call when complete
+     * @user_data: (closure): user data for @callback
+     *
+     * Sends an already-serialized message without building a #JsonNode.
+     * Optional; transports that leave this unset get a fallback that
+     * parses @data and calls send_message_async.
+     */
+    void (*send_raw_async) (McpTransport        *self,
+                            GBytes              *data,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data);
+
+    /**
+     * McpTransportInterface::send_raw_finish:
+     * @self: an #McpTransport
+     * @result: the #GAsyncResult
+     * @error: (nullable): return location for a #GError
+     *
+     * Completes an asynchronous raw send.
+     *
+     * Returns: %TRUE on success, %FALSE on error
+     */
+    gboolean (*send_raw_finish) (McpTransport  *self,
+                                 GAsyncResult  *result,
+                                 GError       **error);
+
+    /**
+     * McpTransportInterface::send_fd:
+     * @self: an #McpTransport
+     * @fd: the file descriptor to pass
+     * @error: (nullable): return location for a #GError
+     *
+     * Passes a duplicate of @fd to the peer so that it is available
+     * before any message sent afterwards.  Optional; only transports
+     * that can carry file descriptors set it.
+     *
+     * Returns: a handle for the peer's receive_fd, or -1 on error
+     */
+    gint (*send_fd) (McpTransport  *self,
+                     gint           fd,
+                     GError       **error);
+
+    /**
+     * McpTransportInterface::receive_fd:
+     * @self: an #McpTransport
+     * @handle: a handle the peer got from send_fd
+     * @error: (nullable): return location for a #GError
+     *
+     * Takes a file descriptor passed by the peer.
+     *
+     * Returns: the file descriptor, or -1 on error
+     */
+    gint (*receive_fd) (McpTransport  *self,
+                        gint           handle,
+                        GError       **error);
+
+    /**
+     * McpTransportInterface::publish_download:
+     * @self: an #McpTransport
+     * @data: the bytes to serve
+     * @mime_type: (nullable): the content type to serve them with
+     * @error: (nullable): return location for a #GError
+     *
+     * Makes @data available to the peer at a short-lived URL outside
+     * the message stream.  Optional; set by server transports that can
+     * serve bulk data themselves.
+     *
+     * Returns: (transfer full) (nullable): the URL, or %NULL on error
+     */
+    gchar * (*publish_download) (McpTransport  *self,
+                                 GBytes        *data,
+                                 const gchar   *mime_type,
+                                 GError       **error);
+
+    /**
+     * McpTransportInterface::download_async:
+     * @self: an #McpTransport
+     * @url: a URL from the peer's publish_download
+     * @cancellable: (nullable): a #GCancellable
+     * @callback: (scope async): callback to call when complete
+     * @user_data: (closure): user data for @callback
+     *
+     * Fetches data the peer published.  Optional; set by client
+     * transports that can reach the peer's download URLs.
+     */
+    void (*download_async) (McpTransport        *self,
+                            const gchar         *url,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data);
+
+    /**
+     * McpTransportInterface::download_finish:
+     * @self: an #McpTransport
+     * @result: the #GAsyncResult
+     * @error: (nullable): return location for a #GError
+     *
+     * Completes a download.
+     *
+     * Returns: (transfer full) (nullable): the data, or %NULL on error
+     */
+    GBytes * (*download_finish) (McpTransport  *self,
+                                 GAsyncResult  *result,
+                                 GError       **error);
+
+    /**
+     * McpTransportInterface::send_raw_with_priority_async:
+     * @self: an #McpTransport
+     * @data: one serialized JSON-RPC message, without a trailing newline
+     * @priority: the lane @data waits in if it has to be queued
+     * @cancellable: (nullable): a #GCancellable
+     * @callback: (scope async): callback to call when complete
+     * @user_data: (closure): user data for @callback
+     *
+     * Like send_raw_async, for transports that queue outgoing messages
+     * by priority; completed with send_raw_finish.  Optional;
+     * transports that leave this unset send in call order.
+     */
+    void (*send_raw_with_priority_async) (McpTransport        *self,
+                                          GBytes              *data,
+                                          McpMessagePriority   priority,
+                                          GCancellable        *cancellable,
+                                          GAsyncReadyCallback  callback,
+                                          gpointer             user_data);
+
     /*< private >*/
     gpointer padding[8];
 };
@@ -243,6 +374,88 @@ gboolean mcp_transport_send_message_finish (McpTransport  *self,
                                             GAsyncResult  *result,
                                             GError       **error);
 
+/**
+ * mcp_transport_send_raw_async:
+ * @self: an #McpTransport
+ * @data: one serialized JSON-RPC message, without a trailing newline
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call when complete
+ * @user_data: (closure): user data for @callback
+ *
+ * Sends a message that is already serialized, e.g. when proxying
+ * between transports.  The caller is responsible for @data being a
+ * valid JSON-RPC message; transports that support raw sends write it
+ * unchanged.
+ */
+void mcp_transport_send_raw_async (McpTransport        *self,
+                                   GBytes              *data,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data);
+
+/**
+ * mcp_transport_send_raw_finish:
+ * @self: an #McpTransport
+ * @result: the #GAsyncResult
+ * @error: (nullable): return location for a #GError
+ *
+ * Completes an asynchronous raw send.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean mcp_transport_send_raw_finish (McpTransport  *self,
+                                        GAsyncResult  *result,
+                                        GError       **error);
+
+/**
+ * mcp_transport_send_raw_with_priority_async:
+ * @self: an #McpTransport
+ * @data: one serialized JSON-RPC message, without a trailing newline
+ * @priority: the #McpMessagePriority of @data
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call when complete
+ * @user_data: (closure): user data for @callback
+ *
+ * Like mcp_transport_send_raw_async(), but lets the caller say which
+ * lane @data belongs in rather than having the transport look inside
+ * it.  A transport with messages waiting for the peer sends
+ * higher-priority ones first.  Complete with
+ * mcp_transport_send_raw_finish().
+ */
+void mcp_transport_send_raw_with_priority_async (McpTransport        *self,
+                                                 GBytes              *data,
+                                                 McpMessagePriority   priority,
+                                                 GCancellable        *cancellable,
+                                                 GAsyncReadyCallback  callback,
+                                                 gpointer             user_data);
+
+/**
+ * mcp_transport_classify_message:
+ * @message: a JSON-RPC message
+ *
+ * Works out the lane @message is queued in: responses, requests and
+ * the cancelled and initialized notifications are
+ * %MCP_MESSAGE_PRIORITY_HIGH, progress and log notifications
+ * %MCP_MESSAGE_PRIORITY_LOW and other notifications
+ * %MCP_MESSAGE_PRIORITY_NORMAL.
+ *
+ * Returns: the #McpMessagePriority of @message
+ */
+McpMessagePriority mcp_transport_classify_message (JsonNode *message);
+
+/**
+ * mcp_transport_classify_raw:
+ * @data: one serialized JSON-RPC message
+ *
+ * Like mcp_transport_classify_message() for a message that is already
+ * serialized.  Only the top-level members are scanned, and scanning
+ * stops at the first "method", "result" or "error" member.  Data that
+ * is not a JSON object is %MCP_MESSAGE_PRIORITY_HIGH.
+ *
+ * Returns: the #McpMessagePriority of @data
+ */
+McpMessagePriority mcp_transport_classify_raw (GBytes *data);
+
 /**
  * mcp_transport_is_connected:
  * @self: an #McpTransport
@@ -253,6 +466,237 @@ gboolean mcp_transport_send_message_finish (McpTransport  *self,
  */
 gboolean mcp_transport_is_connected (McpTransport *self);
 
+/**
+ * MCP_TRANSPORT_FD_PASSING:
+ *
+ * Name of the experimental capability a client declares when its
+ * transport can receive file descriptors, and of the `_meta` member
+ * that refers to one.
+ */
+#define MCP_TRANSPORT_FD_PASSING "mcp-glib/fd"
+
+/**
+ * mcp_transport_supports_fd_passing:
+ * @self: an #McpTransport
+ *
+ * Checks whether @self can pass file descriptors to its peer, as a
+ * shared-memory connection over a Unix socket can.
+ *
+ * Returns: %TRUE if mcp_transport_send_fd() and
+ *   mcp_transport_receive_fd() are available
+ */
+gboolean mcp_transport_supports_fd_passing (McpTransport *self);
+
+/**
+ * mcp_transport_send_fd:
+ * @self: an #McpTransport
+ * @fd: the file descriptor to pass; the caller keeps ownership
+ * @error: (nullable): return location for a #GError
+ *
+ * Passes a duplicate of @fd to the peer.  The descriptor reaches the
+ * peer no later than any message sent after this call, so a message
+ * may refer to it by the returned handle.
+ *
+ * Returns: a non-negative handle, or -1 with @error set if the
+ *   transport cannot pass file descriptors
+ */
+gint mcp_transport_send_fd (McpTransport  *self,
+                            gint           fd,
+                            GError       **error);
+
+/**
+ * mcp_transport_receive_fd:
+ * @self: an #McpTransport
+ * @handle: a handle from the peer's mcp_transport_send_fd()
+ * @error: (nullable): return location for a #GError
+ *
+ * Takes a file descriptor the peer passed.  Each handle can be taken
+ * once; descriptors that are never taken are closed with the
+ * transport.
+ *
+ * Returns: the file descriptor, owned by the caller, or -1 on error
+ */
+gint mcp_transport_receive_fd (McpTransport  *self,
+                               gint           handle,
+                               GError       **error);
+
+/**
+ * MCP_TRANSPORT_DOWNLOAD:
+ *
+ * Name of the experimental capability a client declares when its
+ * transport can fetch download URLs, and of the `_meta` member that
+ * carries one.
+ */
+#define MCP_TRANSPORT_DOWNLOAD "mcp-glib/download"
+
+/**
+ * mcp_transport_publish_download:
+ * @self: an #McpTransport
+ * @data: the bytes to serve; they are referenced, not copied
+ * @mime_type: (nullable): the content type, or %NULL for
+ *   application/octet-stream
+ * @error: (nullable): return location for a #GError
+ *
+ * Serves @data to the peer at a short-lived URL, so that bulk data can
+ * travel outside the message stream.  The URL may be relative to the
+ * address the peer connected to.
+ *
+ * Returns: (transfer full) (nullable): the URL, or %NULL with @error
+ *   set if the transport cannot serve downloads
+ */
+gchar *mcp_transport_publish_download (McpTransport  *self,
+                                       GBytes        *data,
+                                       const gchar   *mime_type,
+                                       GError       **error);
+
+/**
+ * mcp_transport_supports_downloads:
+ * @self: an #McpTransport
+ *
+ * Checks whether @self can fetch URLs from the peer's
+ * mcp_transport_publish_download().
+ *
+ * Returns: %TRUE if mcp_transport_download_async() is available
+ */
+gboolean mcp_transport_supports_downloads (McpTransport *self);
+
+/**
+ * mcp_transport_download_async:
+ * @self: an #McpTransport
+ * @url: a URL the peer published
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call when complete
+ * @user_data: (closure): user data for @callback
+ *
+ * Fetches data the peer published with mcp_transport_publish_download().
+ */
+void mcp_transport_download_async (McpTransport        *self,
+                                   const gchar         *url,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data);
+
+/**
+ * mcp_transport_download_finish:
+ * @self: an #McpTransport
+ * @result: the #GAsyncResult
+ * @error: (nullable): return location for a #GError
+ *
+ * Completes a download.
+ *
+ * Returns: (transfer full) (nullable): the data, or %NULL on error
+ */
+GBytes *mcp_transport_download_finish (McpTransport  *self,
+                                       GAsyncResult  *result,
+                                       GError       **error);
+
+/**
+ * McpWriteQueue:
+ *
+ * Outgoing messages waiting for the peer, one FIFO lane per
+ * #McpMessagePriority.  Transport implementations keep whatever they
+ * need to send a message in the queue and take the next one with
+ * mcp_write_queue_pop().  The highest non-empty lane goes first, but a
+ * message that has been passed over %MCP_WRITE_QUEUE_MAX_PASSED times
+ * goes next, so a steady stream of responses cannot hold back
+ * notifications forever.
+ *
+ * A queue is not thread-safe.
+ */
+typedef struct _McpWriteQueue McpWriteQueue;
+
+/**
+ * MCP_WRITE_QUEUE_MAX_PASSED:
+ *
+ * How many messages from higher lanes may be taken while a lower lane
+ * is waiting before that lane is served.
+ */
+#define MCP_WRITE_QUEUE_MAX_PASSED 16
+
+/**
+ * mcp_write_queue_new:
+ *
+ * Creates an empty write queue.
+ *
+ * Returns: (transfer full): a new #McpWriteQueue
+ */
+McpWriteQueue *mcp_write_queue_new (void);
+
+/**
+ * mcp_write_queue_free:
+ * @queue: an #McpWriteQueue
+ * @free_func: (nullable): called on every item still queued
+ *
+ * Frees @queue.
+ */
+void mcp_write_queue_free (McpWriteQueue  *queue,
+                           GDestroyNotify  free_func);
+
+/**
+ * mcp_write_queue_clear:
+ * @queue: an #McpWriteQueue
+ * @free_func: (nullable): called on every item
+ *
+ * Removes every item from @queue.
+ */
+void mcp_write_queue_clear (McpWriteQueue  *queue,
+                            GDestroyNotify  free_func);
+
+/**
+ * mcp_write_queue_push:
+ * @queue: an #McpWriteQueue
+ * @priority: the lane to add @item to
+ * @item: (not nullable): the item
+ *
+ * Adds @item after every item already in its lane.
+ */
+void mcp_write_queue_push (McpWriteQueue      *queue,
+                           McpMessagePriority  priority,
+                           gpointer            item);
+
+/**
+ * mcp_write_queue_peek:
+ * @queue: an #McpWriteQueue
+ *
+ * Gets the item mcp_write_queue_pop() would take next, if nothing is
+ * pushed in between.
+ *
+ * Returns: (transfer none) (nullable): the next item, or %NULL if
+ *   @queue is empty
+ */
+gpointer mcp_write_queue_peek (McpWriteQueue *queue);
+
+/**
+ * mcp_write_queue_pop:
+ * @queue: an #McpWriteQueue
+ *
+ * Takes the next item to send.
+ *
+ * Returns: (transfer full) (nullable): the next item, or %NULL if
+ *   @queue is empty
+ */
+gpointer mcp_write_queue_pop (McpWriteQueue *queue);
+
+/**
+ * mcp_write_queue_get_length:
+ * @queue: an #McpWriteQueue
+ *
+ * Gets the number of items in @queue.
+ *
+ * Returns: the number of items in every lane
+ */
+guint mcp_write_queue_get_length (McpWriteQueue *queue);
+
+/**
+ * mcp_write_queue_is_empty:
+ * @queue: an #McpWriteQueue
+ *
+ * Checks whether @queue holds no items.
+ *
+ * Returns: %TRUE if @queue is empty
+ */
+gboolean mcp_write_queue_is_empty (McpWriteQueue *queue);
+
 /*
  * Helper functions for transport implementations to emit signals.
  * These should only be called by McpTransport implementations.
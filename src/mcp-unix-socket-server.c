@@ -8,17 +8,29 @@
  * client connection gets its own McpServer + McpStdioTransport pair.
  * The consumer registers tools/resources/prompts by connecting to
  * the "session-created" signal before calling start().
+ *
+ * When the shared-memory upgrade is enabled, a client that opens with
+ * MCP_SHM_TRANSPORT_HELLO gets an McpShmTransport instead.
+ *
+ * In SOCK_SEQPACKET mode every connection is served by an
+ * McpSeqpacketTransport, one message per datagram.
+ *
+ * With coalesce-reads set, every session joins one McpReadGroup, so
+ * concurrent reads of the same resource share one handler call.
  */
 
 #include "mcp-unix-socket-server.h"
 #include "mcp-server.h"
 #include "mcp-stdio-transport.h"
+#include "mcp-shm-transport.h"
+#include "mcp-seqpacket-transport.h"
 #include "mcp-transport.h"
 #include "mcp-error.h"
 
 #include <glib.h>
 #include <gio/gio.h>
 #include <gio/gunixsocketaddress.h>
+#include <string.h>
 #include <unistd.h>
 
 /* ===== Internal session structure ===== */
@@ -27,7 +39,9 @@
  * McpUnixSocketSession:
  *
  * Tracks a single connected client. Each session owns one McpServer
- * and one McpStdioTransport wrapping the socket connection's streams.
+ * and one transport over the socket connection: an McpStdioTransport
+ * wrapping its streams, an McpShmTransport after an upgrade, or an
+ * McpSeqpacketTransport in SOCK_SEQPACKET mode.
  * The owner back-reference is unowned (no ref cycle).
  */
 typedef struct _McpUnixSocketSession McpUnixSocketSession;
@@ -35,7 +49,7 @@ typedef struct _McpUnixSocketSession McpUnixSocketSession;
 struct _McpUnixSocketSession
 {
 	McpServer             *server;
-	McpStdioTransport     *transport;
+	McpTransport          *transport;
 	GSocketConnection     *connection;
 	McpUnixSocketServer   *owner;             /* unowned back-ref */
 	gulong                 state_handler_id;
@@ -54,11 +68,24 @@ struct _McpUnixSocketServer
 	gchar *server_version;
 	gchar *socket_path;
 	gchar *instructions;
+	GSocketType socket_type;
 
 	/* Socket listener */
 	GSocketService *socket_service;
 	gboolean        running;
 
+	/* Shared-memory upgrade: ring size, 0 when disabled */
+	guint           shm_ring_size;
+	/* Cancels upgrade probes still waiting for a client's first bytes */
+	GCancellable   *probe_cancellable;
+
+	/* Shared by every session while coalesce_reads is set */
+	McpReadGroup   *read_group;
+	gboolean        coalesce_reads;
+
+	/* Applied to every new session, or NULL */
+	McpRateLimiter *rate_limiter;
+
 	/* Active sessions */
 	GList *sessions;   /* GList of McpUnixSocketSession* */
 };
@@ -87,6 +114,10 @@ enum
 	PROP_INSTRUCTIONS,
 	PROP_SESSION_COUNT,
 	PROP_RUNNING,
+	PROP_SHM_RING_SIZE,
+	PROP_SOCKET_TYPE,
+	PROP_COALESCE_READS,
+	PROP_COALESCED_READS,
 	N_PROPERTIES
 };
 
@@ -281,50 +312,42 @@ on_session_server_started (
 /* ===== Socket incoming handler ===== */
 
 /*
- * on_incoming:
+ * session_start:
  *
- * Called when a new client connects to the Unix domain socket.
- * Creates a new McpServer + McpStdioTransport pair, emits
- * "session-created" so the consumer can register tools, then
- * starts the server async.
+ * Creates the per-connection McpServer over @transport (taking
+ * ownership of it), emits "session-created" so the consumer can
+ * register tools, then starts the server async.
  */
-static gboolean
-on_incoming (
-	GSocketService    *service,
-	GSocketConnection *connection,
-	GObject           *source_object,
-	gpointer           user_data
+static void
+session_start (
+	McpUnixSocketServer *self,
+	GSocketConnection   *connection,
+	McpTransport        *transport
 ){
-	McpUnixSocketServer  *self;
 	McpUnixSocketSession *session;
-	GInputStream         *input;
-	GOutputStream        *output;
-
-	(void)service;
-	(void)source_object;
-
-	self = MCP_UNIX_SOCKET_SERVER (user_data);
 
 	session = g_new0 (McpUnixSocketSession, 1);
 	session->refcount   = 1;        /* held by the session list */
 	session->owner      = self;     /* unowned back-ref */
 	session->connection = g_object_ref (connection);
-
-	/* Wrap socket streams in McpStdioTransport (NDJSON framing) */
-	input  = g_io_stream_get_input_stream (G_IO_STREAM (connection));
-	output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
-
-	session->transport = mcp_stdio_transport_new_with_streams (input, output);
+	session->transport  = transport;
 
 	/* Create per-connection server */
 	session->server = mcp_server_new (self->server_name, self->server_version);
-	mcp_server_set_transport (session->server,
-	                          MCP_TRANSPORT (session->transport));
+	mcp_server_set_transport (session->server, session->transport);
 
 	/* Apply instructions if set */
 	if (self->instructions != NULL)
 		mcp_server_set_instructions (session->server, self->instructions);
 
+	/* Share resource reads with the other sessions */
+	if (self->coalesce_reads)
+		mcp_server_set_read_group (session->server, self->read_group);
+
+	/* Limit requests across sessions */
+	if (self->rate_limiter != NULL)
+		mcp_server_set_rate_limiter (session->server, self->rate_limiter);
+
 	/* Let consumer register tools/resources/prompts */
 	g_signal_emit (self, signals[SIGNAL_SESSION_CREATED], 0, session->server);
 
@@ -335,7 +358,7 @@ on_incoming (
 
 	/* Watch for disconnect */
 	session->state_handler_id = g_signal_connect (
-		MCP_TRANSPORT (session->transport), "state-changed",
+		session->transport, "state-changed",
 		G_CALLBACK (on_session_transport_state_changed), session);
 
 	/* Start the MCP handshake.  Hold an extra ref for the duration of the
@@ -344,6 +367,156 @@ on_incoming (
 	mcp_server_start_async (session->server, NULL,
 	                        on_session_server_started,
 	                        session_ref (session));
+}
+
+/*
+ * UpgradeProbe:
+ *
+ * A connection whose first bytes decide between NDJSON and the
+ * shared-memory upgrade. The bytes are peeked through a buffered
+ * stream that is then handed to McpStdioTransport, so an ordinary
+ * client loses nothing. The owner back-ref is only used while
+ * @cancellable is not cancelled (stop() cancels it).
+ */
+typedef struct
+{
+	McpUnixSocketServer  *owner;         /* unowned back-ref */
+	GSocketConnection    *connection;
+	GBufferedInputStream *input;
+	GCancellable         *cancellable;
+} UpgradeProbe;
+
+static void
+upgrade_probe_free (UpgradeProbe *probe)
+{
+	g_clear_object (&probe->connection);
+	g_clear_object (&probe->input);
+	g_clear_object (&probe->cancellable);
+	g_free (probe);
+}
+
+static void upgrade_probe_fill (UpgradeProbe *probe);
+
+static void
+on_upgrade_probe_filled (
+	GObject      *source,
+	GAsyncResult *result,
+	gpointer      user_data
+){
+	UpgradeProbe  *probe;
+	McpTransport  *transport;
+	const gchar   *peeked;
+	gsize          available;
+	gsize          hello_len;
+	gssize         n;
+
+	probe = (UpgradeProbe *)user_data;
+	hello_len = strlen (MCP_SHM_TRANSPORT_HELLO);
+
+	n = g_buffered_input_stream_fill_finish (probe->input, result, NULL);
+	if (n <= 0 || g_cancellable_is_cancelled (probe->cancellable))
+	{
+		/* Closed before saying anything, or the server stopped */
+		upgrade_probe_free (probe);
+		return;
+	}
+
+	peeked = g_buffered_input_stream_peek_buffer (probe->input, &available);
+
+	if (memcmp (peeked, MCP_SHM_TRANSPORT_HELLO,
+	            MIN (available, hello_len)) != 0)
+	{
+		/* An ordinary NDJSON client; its bytes stay in the buffer */
+		transport = MCP_TRANSPORT (mcp_stdio_transport_new_with_streams (
+			G_INPUT_STREAM (probe->input),
+			g_io_stream_get_output_stream (G_IO_STREAM (probe->connection))));
+	}
+	else if (available < hello_len)
+	{
+		upgrade_probe_fill (probe);
+		return;
+	}
+	else
+	{
+		g_input_stream_skip (G_INPUT_STREAM (probe->input), hello_len,
+		                     NULL, NULL);
+		transport = MCP_TRANSPORT (mcp_shm_transport_new_server (
+			probe->connection, probe->owner->shm_ring_size));
+		g_debug ("mcp-unix-socket-server: upgrading to shared memory");
+	}
+
+	session_start (probe->owner, probe->connection, transport);
+	upgrade_probe_free (probe);
+}
+
+static void
+upgrade_probe_fill (UpgradeProbe *probe)
+{
+	g_buffered_input_stream_fill_async (probe->input, -1,
+	                                    G_PRIORITY_DEFAULT,
+	                                    probe->cancellable,
+	                                    on_upgrade_probe_filled,
+	                                    probe);
+}
+
+/*
+ * on_incoming:
+ *
+ * Called when a new client connects to the Unix domain socket.
+ * Wraps the connection in an McpStdioTransport (or, in SOCK_SEQPACKET
+ * mode, an McpSeqpacketTransport) and starts a session, or, with the
+ * shared-memory upgrade enabled, first waits for the client's opening
+ * bytes to pick the transport.
+ */
+static gboolean
+on_incoming (
+	GSocketService    *service,
+	GSocketConnection *connection,
+	GObject           *source_object,
+	gpointer           user_data
+){
+	McpUnixSocketServer  *self;
+	McpStdioTransport    *transport;
+	GInputStream         *input;
+	GOutputStream        *output;
+
+	(void)service;
+	(void)source_object;
+
+	self = MCP_UNIX_SOCKET_SERVER (user_data);
+
+	if (self->socket_type == G_SOCKET_TYPE_SEQPACKET)
+	{
+		/* One message per datagram; no framing, no upgrade */
+		session_start (self, connection, MCP_TRANSPORT (
+			mcp_seqpacket_transport_new_server (connection)));
+
+		g_debug ("mcp-unix-socket-server: accepted connection");
+		return TRUE;
+	}
+
+	input  = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+	output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+
+	if (self->shm_ring_size > 0)
+	{
+		UpgradeProbe *probe;
+
+		probe = g_new0 (UpgradeProbe, 1);
+		probe->owner       = self;
+		probe->connection  = g_object_ref (connection);
+		probe->input       = G_BUFFERED_INPUT_STREAM (
+			g_buffered_input_stream_new (input));
+		probe->cancellable = g_object_ref (self->probe_cancellable);
+		upgrade_probe_fill (probe);
+
+		g_debug ("mcp-unix-socket-server: accepted connection");
+		return TRUE;
+	}
+
+	/* Wrap socket streams in McpStdioTransport (NDJSON framing) */
+	transport = mcp_stdio_transport_new_with_streams (input, output);
+	session_start (self, connection, MCP_TRANSPORT (transport));
 
 	g_debug ("mcp-unix-socket-server: accepted connection");
 	return TRUE;
@@ -423,7 +596,7 @@ mcp_unix_socket_server_start (
 		g_autoptr(GSocket) listen_socket = NULL;
 
 		listen_socket = g_socket_new (G_SOCKET_FAMILY_UNIX,
-		                              G_SOCKET_TYPE_STREAM,
+		                              self->socket_type,
 		                              G_SOCKET_PROTOCOL_DEFAULT,
 		                              error);
 		if (listen_socket == NULL)
@@ -458,6 +631,8 @@ mcp_unix_socket_server_start (
 	g_signal_connect (self->socket_service, "incoming",
 	                  G_CALLBACK (on_incoming), self);
 
+	self->probe_cancellable = g_cancellable_new ();
+
 	g_socket_service_start (self->socket_service);
 	self->running = TRUE;
 
@@ -488,6 +663,13 @@ mcp_unix_socket_server_stop (McpUnixSocketServer *self)
 		g_clear_object (&self->socket_service);
 	}
 
+	/* Drop connections still deciding on a transport */
+	if (self->probe_cancellable != NULL)
+	{
+		g_cancellable_cancel (self->probe_cancellable);
+		g_clear_object (&self->probe_cancellable);
+	}
+
 	/* Tear down all sessions */
 	while (self->sessions != NULL)
 	{
@@ -577,6 +759,104 @@ mcp_unix_socket_server_get_instructions (McpUnixSocketServer *self)
 	return self->instructions;
 }
 
+void
+mcp_unix_socket_server_set_shm_ring_size (
+	McpUnixSocketServer *self,
+	guint                ring_size
+){
+	g_return_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self));
+
+	if (self->shm_ring_size == ring_size)
+		return;
+
+	self->shm_ring_size = ring_size;
+	g_object_notify_by_pspec (G_OBJECT (self),
+	                          properties[PROP_SHM_RING_SIZE]);
+}
+
+guint
+mcp_unix_socket_server_get_shm_ring_size (McpUnixSocketServer *self)
+{
+	g_return_val_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self), 0);
+	return self->shm_ring_size;
+}
+
+void
+mcp_unix_socket_server_set_socket_type (
+	McpUnixSocketServer *self,
+	GSocketType          socket_type
+){
+	g_return_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self));
+	g_return_if_fail (socket_type == G_SOCKET_TYPE_STREAM ||
+	                  socket_type == G_SOCKET_TYPE_SEQPACKET);
+	g_return_if_fail (!self->running);
+
+	if (self->socket_type == socket_type)
+		return;
+
+	self->socket_type = socket_type;
+	g_object_notify_by_pspec (G_OBJECT (self),
+	                          properties[PROP_SOCKET_TYPE]);
+}
+
+GSocketType
+mcp_unix_socket_server_get_socket_type (McpUnixSocketServer *self)
+{
+	g_return_val_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self),
+	                      G_SOCKET_TYPE_STREAM);
+	return self->socket_type;
+}
+
+void
+mcp_unix_socket_server_set_coalesce_reads (
+	McpUnixSocketServer *self,
+	gboolean             coalesce
+){
+	g_return_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self));
+
+	coalesce = !!coalesce;
+	if (self->coalesce_reads == coalesce)
+		return;
+
+	self->coalesce_reads = coalesce;
+	g_object_notify_by_pspec (G_OBJECT (self),
+	                          properties[PROP_COALESCE_READS]);
+}
+
+gboolean
+mcp_unix_socket_server_get_coalesce_reads (McpUnixSocketServer *self)
+{
+	g_return_val_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self), FALSE);
+	return self->coalesce_reads;
+}
+
+guint64
+mcp_unix_socket_server_get_coalesced_reads (McpUnixSocketServer *self)
+{
+	g_return_val_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self), 0);
+	return mcp_read_group_get_coalesced_reads (self->read_group);
+}
+
+void
+mcp_unix_socket_server_set_rate_limiter (
+	McpUnixSocketServer *self,
+	McpRateLimiter      *limiter
+){
+	g_return_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self));
+
+	if (limiter != NULL)
+		mcp_rate_limiter_ref (limiter);
+	g_clear_pointer (&self->rate_limiter, mcp_rate_limiter_unref);
+	self->rate_limiter = limiter;
+}
+
+McpRateLimiter *
+mcp_unix_socket_server_get_rate_limiter (McpUnixSocketServer *self)
+{
+	g_return_val_if_fail (MCP_IS_UNIX_SOCKET_SERVER (self), NULL);
+	return self->rate_limiter;
+}
+
 /* ===== GObject vfuncs ===== */
 
 static void
@@ -608,6 +888,18 @@ mcp_unix_socket_server_set_property (
 		mcp_unix_socket_server_set_instructions (self,
 			g_value_get_string (value));
 		break;
+	case PROP_SHM_RING_SIZE:
+		mcp_unix_socket_server_set_shm_ring_size (self,
+			g_value_get_uint (value));
+		break;
+	case PROP_SOCKET_TYPE:
+		mcp_unix_socket_server_set_socket_type (self,
+			g_value_get_enum (value));
+		break;
+	case PROP_COALESCE_READS:
+		mcp_unix_socket_server_set_coalesce_reads (self,
+			g_value_get_boolean (value));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -646,6 +938,19 @@ mcp_unix_socket_server_get_property (
 	case PROP_RUNNING:
 		g_value_set_boolean (value, self->running);
 		break;
+	case PROP_SHM_RING_SIZE:
+		g_value_set_uint (value, self->shm_ring_size);
+		break;
+	case PROP_SOCKET_TYPE:
+		g_value_set_enum (value, self->socket_type);
+		break;
+	case PROP_COALESCE_READS:
+		g_value_set_boolean (value, self->coalesce_reads);
+		break;
+	case PROP_COALESCED_READS:
+		g_value_set_uint64 (value,
+			mcp_read_group_get_coalesced_reads (self->read_group));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -676,6 +981,8 @@ mcp_unix_socket_server_finalize (GObject *object)
 	g_free (self->server_version);
 	g_free (self->socket_path);
 	g_free (self->instructions);
+	mcp_read_group_unref (self->read_group);
+	g_clear_pointer (&self->rate_limiter, mcp_rate_limiter_unref);
 
 	G_OBJECT_CLASS (mcp_unix_socket_server_parent_class)->finalize (object);
 }
@@ -775,6 +1082,69 @@ mcp_unix_socket_server_class_init (McpUnixSocketServerClass *klass)
 		                      G_PARAM_READABLE |
 		                      G_PARAM_STATIC_STRINGS);
 
+	/**
+	 * McpUnixSocketServer:shm-ring-size:
+	 *
+	 * Ring buffer size offered to clients that ask for the
+	 * shared-memory upgrade, or 0 to serve every client with
+	 * newline-delimited JSON. Takes effect on the next connection.
+	 */
+	properties[PROP_SHM_RING_SIZE] =
+		g_param_spec_uint ("shm-ring-size",
+		                   "Shared-Memory Ring Size",
+		                   "Ring size for the shared-memory upgrade (0 disables it)",
+		                   0, G_MAXUINT, 0,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_EXPLICIT_NOTIFY |
+		                   G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * McpUnixSocketServer:socket-type:
+	 *
+	 * The type of socket to listen on: %G_SOCKET_TYPE_STREAM for
+	 * newline-delimited JSON, or %G_SOCKET_TYPE_SEQPACKET for one
+	 * message per datagram. Can only be changed while stopped.
+	 */
+	properties[PROP_SOCKET_TYPE] =
+		g_param_spec_enum ("socket-type",
+		                   "Socket Type",
+		                   "Stream or seqpacket listener",
+		                   G_TYPE_SOCKET_TYPE,
+		                   G_SOCKET_TYPE_STREAM,
+		                   G_PARAM_READWRITE |
+		                   G_PARAM_EXPLICIT_NOTIFY |
+		                   G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * McpUnixSocketServer:coalesce-reads:
+	 *
+	 * Whether sessions share resources/read requests: reads of the
+	 * same URI that arrive together from any sessions run the
+	 * resource handler once. Takes effect on the next connection.
+	 */
+	properties[PROP_COALESCE_READS] =
+		g_param_spec_boolean ("coalesce-reads",
+		                      "Coalesce Reads",
+		                      "Whether sessions share concurrent resource reads",
+		                      FALSE,
+		                      G_PARAM_READWRITE |
+		                      G_PARAM_EXPLICIT_NOTIFY |
+		                      G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * McpUnixSocketServer:coalesced-reads:
+	 *
+	 * The number of resources/read requests answered by joining
+	 * another session's read of the same URI. Not notified.
+	 */
+	properties[PROP_COALESCED_READS] =
+		g_param_spec_uint64 ("coalesced-reads",
+		                     "Coalesced Reads",
+		                     "Reads answered by joining a read in flight",
+		                     0, G_MAXUINT64, 0,
+		                     G_PARAM_READABLE |
+		                     G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties (object_class, N_PROPERTIES,
 	                                   properties);
 
@@ -829,4 +1199,9 @@ mcp_unix_socket_server_init (McpUnixSocketServer *self)
 	self->socket_service = NULL;
 	self->running        = FALSE;
 	self->sessions       = NULL;
+	self->shm_ring_size  = 0;
+	self->probe_cancellable = NULL;
+	self->socket_type    = G_SOCKET_TYPE_STREAM;
+	self->read_group     = mcp_read_group_new ();
+	self->coalesce_reads = FALSE;
 }
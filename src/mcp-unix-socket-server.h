@@ -6,8 +6,10 @@
  *
  * This file defines a multi-client MCP server that listens on a Unix
  * domain socket. Each incoming connection gets its own McpServer and
- * McpStdioTransport pair. The consumer registers tools/resources/prompts
- * by connecting to the "session-created" signal.
+ * McpStdioTransport pair (or McpShmTransport, for clients that ask for
+ * the shared-memory upgrade, or McpSeqpacketTransport when listening on
+ * a SOCK_SEQPACKET socket). The consumer registers tools/resources/
+ * prompts by connecting to the "session-created" signal.
  *
  * Unlike the transport classes (McpStdioTransport, McpHttpServerTransport),
  * this class does NOT implement McpTransport. It is a higher-level
@@ -143,6 +145,121 @@ void mcp_unix_socket_server_set_instructions (McpUnixSocketServer *self,
  */
 const gchar *mcp_unix_socket_server_get_instructions (McpUnixSocketServer *self);
 
+/**
+ * mcp_unix_socket_server_set_shm_ring_size:
+ * @self: an #McpUnixSocketServer
+ * @ring_size: ring buffer size in bytes, or 0 to disable the upgrade
+ *
+ * Offers the shared-memory upgrade: a client that opens with
+ * %MCP_SHM_TRANSPORT_HELLO (see mcp_shm_transport_new_client()) is
+ * served by an #McpShmTransport with rings of @ring_size bytes.
+ * Other clients keep getting newline-delimited JSON.
+ *
+ * While enabled, a session is created once the client has sent its
+ * first bytes rather than on accept. Takes effect on the next
+ * connection.
+ */
+void mcp_unix_socket_server_set_shm_ring_size (McpUnixSocketServer *self,
+                                                guint                ring_size);
+
+/**
+ * mcp_unix_socket_server_get_shm_ring_size:
+ * @self: an #McpUnixSocketServer
+ *
+ * Gets the ring size offered for the shared-memory upgrade.
+ *
+ * Returns: the ring size in bytes, or 0 if the upgrade is disabled
+ */
+guint mcp_unix_socket_server_get_shm_ring_size (McpUnixSocketServer *self);
+
+/**
+ * mcp_unix_socket_server_set_socket_type:
+ * @self: an #McpUnixSocketServer
+ * @socket_type: %G_SOCKET_TYPE_STREAM or %G_SOCKET_TYPE_SEQPACKET
+ *
+ * Chooses the type of socket to listen on. With
+ * %G_SOCKET_TYPE_SEQPACKET every session is served by an
+ * #McpSeqpacketTransport, which sends each message as one datagram;
+ * clients connect with mcp_seqpacket_transport_new_client(). The
+ * shared-memory upgrade is only offered on stream sockets.
+ *
+ * Must be called before mcp_unix_socket_server_start().
+ */
+void mcp_unix_socket_server_set_socket_type (McpUnixSocketServer *self,
+                                              GSocketType          socket_type);
+
+/**
+ * mcp_unix_socket_server_get_socket_type:
+ * @self: an #McpUnixSocketServer
+ *
+ * Gets the type of socket the server listens on.
+ *
+ * Returns: %G_SOCKET_TYPE_STREAM (the default) or %G_SOCKET_TYPE_SEQPACKET
+ */
+GSocketType mcp_unix_socket_server_get_socket_type (McpUnixSocketServer *self);
+
+/**
+ * mcp_unix_socket_server_set_coalesce_reads:
+ * @self: an #McpUnixSocketServer
+ * @coalesce: whether sessions share resource reads
+ *
+ * Puts every new session in one #McpReadGroup (see
+ * mcp_server_set_read_group()). When many clients read the same URI
+ * at once, for example after a resources/updated broadcast, the
+ * resource handler then runs once and its serialized contents are
+ * sent to all of them. Only enable this when the contents a handler
+ * returns do not depend on the session it is called for.
+ *
+ * Takes effect on the next connection.
+ */
+void mcp_unix_socket_server_set_coalesce_reads (McpUnixSocketServer *self,
+                                                 gboolean             coalesce);
+
+/**
+ * mcp_unix_socket_server_get_coalesce_reads:
+ * @self: an #McpUnixSocketServer
+ *
+ * Gets whether sessions share resource reads.
+ *
+ * Returns: %TRUE if new sessions join the server's read group
+ */
+gboolean mcp_unix_socket_server_get_coalesce_reads (McpUnixSocketServer *self);
+
+/**
+ * mcp_unix_socket_server_get_coalesced_reads:
+ * @self: an #McpUnixSocketServer
+ *
+ * Gets how many resources/read requests were answered by joining a
+ * read of the same URI already pending, across all sessions.
+ *
+ * Returns: the number of coalesced reads
+ */
+guint64 mcp_unix_socket_server_get_coalesced_reads (McpUnixSocketServer *self);
+
+/**
+ * mcp_unix_socket_server_set_rate_limiter:
+ * @self: an #McpUnixSocketServer
+ * @limiter: (nullable): an #McpRateLimiter, or %NULL
+ *
+ * Sets the rate limiter given to every new session with
+ * mcp_server_set_rate_limiter(). Session limits then apply per
+ * connection, while tool limits are shared by all connections.
+ *
+ * Takes effect on the next connection.
+ */
+void mcp_unix_socket_server_set_rate_limiter (McpUnixSocketServer *self,
+                                               McpRateLimiter      *limiter);
+
+/**
+ * mcp_unix_socket_server_get_rate_limiter:
+ * @self: an #McpUnixSocketServer
+ *
+ * Gets the rate limiter set with mcp_unix_socket_server_set_rate_limiter().
+ *
+ * Returns: (transfer none) (nullable): the #McpRateLimiter, or %NULL
+ */
+McpRateLimiter *mcp_unix_socket_server_get_rate_limiter (McpUnixSocketServer *self);
+
 G_END_DECLS
 
 #endif /* MCP_UNIX_SOCKET_SERVER_H */
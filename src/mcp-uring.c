@@ -0,0 +1,1014 @@
+/*
+ * mcp-uring.c - io_uring I/O backend for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "mcp-uring.h"
+#include "mcp-error.h"
+#include "mcp-transport.h"
+
+/* Summed over every ring in the process; see mcp_uring_get_stats() */
+static gsize stat_syscalls;
+static gsize stat_sends;
+static gsize stat_receives;
+
+void
+mcp_uring_get_stats (guint64 *n_syscalls,
+                     guint64 *n_sends,
+                     guint64 *n_receives)
+{
+    if (n_syscalls != NULL)
+    {
+        *n_syscalls = (gsize) g_atomic_pointer_get ((gpointer *) &stat_syscalls);
+    }
+    if (n_sends != NULL)
+    {
+        *n_sends = (gsize) g_atomic_pointer_get ((gpointer *) &stat_sends);
+    }
+    if (n_receives != NULL)
+    {
+        *n_receives = (gsize) g_atomic_pointer_get ((gpointer *) &stat_receives);
+    }
+}
+
+#ifdef MCP_HAVE_IO_URING
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <liburing.h>
+
+/* ── Layout ─────────────────────────────────────────────────────────── */
+
+#define URING_ENTRIES    256
+#define URING_BUF_GROUP  0
+#define URING_BUF_COUNT  256     /* must be a power of two */
+#define URING_BUF_SIZE   16384
+#define URING_MAX_IOV    64
+
+/*
+ * A channel has at most one read and one write in the kernel at a
+ * time, so the user_data of an operation is the channel pointer with
+ * the operation in its low bits.  Cancellation requests use 0.
+ */
+#define OP_READ   1
+#define OP_WRITE  2
+#define OP_MASK   3
+
+typedef struct _McpUring McpUring;
+
+struct _McpUring
+{
+    gint          ref_count;     /* guarded by uring_lock */
+    GMainContext *context;
+
+    struct io_uring           ring;
+    struct io_uring_buf_ring *buf_ring;
+    guchar                   *buffers;
+    gint                      event_fd;
+    GSource                  *source;
+
+    /* Channels with writes waiting for the next prepare() */
+    GQueue   pending;
+
+    /* Set when the kernel rejects multishot receives (before 6.0) */
+    gboolean no_multishot;
+};
+
+typedef struct
+{
+    GSource   source;
+    McpUring *uring;
+} UringSource;
+
+typedef struct
+{
+    GBytes *data;
+    GTask  *task;
+} WriteEntry;
+
+struct _McpUringChannel
+{
+    gint      ref_count;
+    McpUring *uring;
+
+    gint     read_fd;
+    gint     write_fd;
+    gboolean read_is_socket;
+    gboolean write_is_socket;
+
+    McpUringReadFunc read_func;   /* NULL once closed */
+    gpointer         user_data;
+
+    gboolean reading;       /* a read is in the kernel */
+    gboolean multishot;     /* ... and it is a multishot receive */
+    gboolean read_done;     /* end of stream or error reported */
+    gboolean writing;       /* a write is in the kernel */
+    gboolean flush_queued;  /* on uring->pending */
+    gboolean closed;
+
+    /* WriteEntry handed to the kernel, in flight while writing is set;
+     * the first may be partly written */
+    GQueue         writes;
+    /* WriteEntry not handed over yet, by priority */
+    McpWriteQueue *queued;
+    gsize          head_offset;
+    struct iovec   iov[URING_MAX_IOV];
+    struct msghdr  msg;
+};
+
+static GMutex      uring_lock;
+static GHashTable *urings;  /* GMainContext * → McpUring * */
+
+static void channel_ref   (McpUringChannel *channel);
+static void channel_unref (McpUringChannel *channel);
+static void channel_flush (McpUringChannel *channel);
+static gboolean channel_has_writes (McpUringChannel *channel);
+static void handle_completion (McpUring *uring,
+                               guint64   data,
+                               gint      res,
+                               guint     flags);
+
+/* ── Availability ───────────────────────────────────────────────────── */
+
+static gboolean
+probe_uring (void)
+{
+    const gchar *env;
+    struct io_uring ring;
+    struct io_uring_probe *probe;
+    struct io_uring_buf_ring *buf_ring;
+    gboolean ok;
+    gint ret;
+
+    env = g_getenv ("MCP_IO_URING");
+    if (env != NULL && g_strcmp0 (env, "0") == 0)
+    {
+        return FALSE;
+    }
+
+    /* Fails with ENOSYS on old kernels and EPERM under most seccomp
+     * profiles and with kernel.io_uring_disabled set. */
+    if (io_uring_queue_init (2, &ring, 0) < 0)
+    {
+        return FALSE;
+    }
+
+    probe = io_uring_get_probe_ring (&ring);
+    ok = probe != NULL &&
+         io_uring_opcode_supported (probe, IORING_OP_RECV) &&
+         io_uring_opcode_supported (probe, IORING_OP_READ) &&
+         io_uring_opcode_supported (probe, IORING_OP_SENDMSG) &&
+         io_uring_opcode_supported (probe, IORING_OP_WRITEV) &&
+         io_uring_opcode_supported (probe, IORING_OP_ASYNC_CANCEL);
+    if (probe != NULL)
+    {
+        io_uring_free_probe (probe);
+    }
+
+    /* Provided buffer rings need 5.19 */
+    if (ok)
+    {
+        buf_ring = io_uring_setup_buf_ring (&ring, 2, URING_BUF_GROUP, 0, &ret);
+        ok = buf_ring != NULL;
+        if (ok)
+        {
+            io_uring_free_buf_ring (&ring, buf_ring, 2, URING_BUF_GROUP);
+        }
+    }
+
+    io_uring_queue_exit (&ring);
+
+    return ok;
+}
+
+gboolean
+mcp_uring_is_available (void)
+{
+    static gsize available = 0;  /* 1 = no, 2 = yes */
+
+    if (g_once_init_enter (&available))
+    {
+        g_once_init_leave (&available, probe_uring () ? 2 : 1);
+    }
+
+    return available == 2;
+}
+
+/* ── Ring per GMainContext ──────────────────────────────────────────── */
+
+static void
+uring_free (McpUring *uring)
+{
+    if (uring->source != NULL)
+    {
+        g_source_destroy (uring->source);
+        g_source_unref (uring->source);
+    }
+
+    if (uring->buf_ring != NULL)
+    {
+        io_uring_free_buf_ring (&uring->ring, uring->buf_ring,
+                                URING_BUF_COUNT, URING_BUF_GROUP);
+    }
+    io_uring_queue_exit (&uring->ring);
+
+    if (uring->event_fd >= 0)
+    {
+        close (uring->event_fd);
+    }
+
+    g_free (uring->buffers);
+    if (uring->context != NULL)
+    {
+        g_main_context_unref (uring->context);
+    }
+    g_free (uring);
+}
+
+static void
+uring_ref (McpUring *uring)
+{
+    g_mutex_lock (&uring_lock);
+    uring->ref_count++;
+    g_mutex_unlock (&uring_lock);
+}
+
+static void
+uring_unref (McpUring *uring)
+{
+    gboolean last;
+
+    g_mutex_lock (&uring_lock);
+    last = --uring->ref_count == 0;
+    if (last)
+    {
+        g_hash_table_remove (urings, uring->context);
+    }
+    g_mutex_unlock (&uring_lock);
+
+    if (last)
+    {
+        guint64 n_syscalls;
+        guint64 n_sends;
+        guint64 n_receives;
+
+        mcp_uring_get_stats (&n_syscalls, &n_sends, &n_receives);
+        g_debug ("io_uring: %" G_GUINT64_FORMAT " syscalls for %"
+                 G_GUINT64_FORMAT " sends and %" G_GUINT64_FORMAT
+                 " receives so far",
+                 n_syscalls, n_sends, n_receives);
+        uring_free (uring);
+    }
+}
+
+static void
+uring_submit (McpUring *uring)
+{
+    if (io_uring_sq_ready (&uring->ring) == 0)
+    {
+        return;
+    }
+
+    /* On -EBUSY the entries stay queued for the next attempt */
+    io_uring_submit (&uring->ring);
+    g_atomic_pointer_add (&stat_syscalls, 1);
+}
+
+static struct io_uring_sqe *
+uring_get_sqe (McpUring *uring)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = io_uring_get_sqe (&uring->ring);
+    if (sqe == NULL)
+    {
+        uring_submit (uring);
+        sqe = io_uring_get_sqe (&uring->ring);
+    }
+
+    return sqe;
+}
+
+static void
+uring_recycle_buffer (McpUring *uring,
+                      guint     bid)
+{
+    io_uring_buf_ring_add (uring->buf_ring,
+                           uring->buffers + (gsize) bid * URING_BUF_SIZE,
+                           URING_BUF_SIZE, bid,
+                           io_uring_buf_ring_mask (URING_BUF_COUNT), 0);
+    io_uring_buf_ring_advance (uring->buf_ring, 1);
+}
+
+/*
+ * Everything queued since the last iteration goes to the kernel here,
+ * in one io_uring_enter() for all channels on the context.
+ */
+static gboolean
+uring_source_prepare (GSource *source,
+                      gint    *timeout)
+{
+    McpUring *uring = ((UringSource *) source)->uring;
+    McpUringChannel *channel;
+    gboolean ready;
+
+    *timeout = -1;
+
+    uring_ref (uring);
+
+    while ((channel = g_queue_pop_head (&uring->pending)) != NULL)
+    {
+        channel->flush_queued = FALSE;
+        if (!channel->closed && !channel->writing && channel_has_writes (channel))
+        {
+            channel_flush (channel);
+        }
+        channel_unref (channel);
+    }
+
+    uring_submit (uring);
+    ready = io_uring_cq_ready (&uring->ring) > 0;
+
+    uring_unref (uring);
+
+    return ready;
+}
+
+static gboolean
+uring_source_dispatch (GSource     *source,
+                       GSourceFunc  callback,
+                       gpointer     user_data)
+{
+    McpUring *uring = ((UringSource *) source)->uring;
+    struct io_uring_cqe *cqe;
+    guint64 value;
+
+    uring_ref (uring);
+
+    if (read (uring->event_fd, &value, sizeof value) > 0)
+    {
+        g_atomic_pointer_add (&stat_syscalls, 1);
+    }
+
+    while (io_uring_peek_cqe (&uring->ring, &cqe) == 0)
+    {
+        guint64 data = io_uring_cqe_get_data64 (cqe);
+        gint res = cqe->res;
+        guint flags = cqe->flags;
+
+        io_uring_cqe_seen (&uring->ring, cqe);
+        handle_completion (uring, data, res, flags);
+    }
+
+    uring_unref (uring);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs uring_source_funcs =
+{
+    uring_source_prepare,
+    NULL,
+    uring_source_dispatch,
+    NULL,
+    NULL,
+    NULL
+};
+
+static McpUring *
+uring_new (GMainContext *context)
+{
+    McpUring *uring;
+    gint ret;
+    guint i;
+
+    uring = g_new0 (McpUring, 1);
+    uring->ref_count = 1;
+    uring->event_fd = -1;
+    g_queue_init (&uring->pending);
+
+    ret = io_uring_queue_init (URING_ENTRIES, &uring->ring, 0);
+    if (ret < 0)
+    {
+        g_debug ("io_uring_queue_init: %s", g_strerror (-ret));
+        g_free (uring);
+        return NULL;
+    }
+
+    uring->buf_ring = io_uring_setup_buf_ring (&uring->ring, URING_BUF_COUNT,
+                                               URING_BUF_GROUP, 0, &ret);
+    if (uring->buf_ring != NULL)
+    {
+        uring->event_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+    }
+
+    if (uring->buf_ring == NULL || uring->event_fd < 0 ||
+        io_uring_register_eventfd (&uring->ring, uring->event_fd) < 0)
+    {
+        g_debug ("io_uring: cannot set up buffer ring or eventfd");
+        uring_free (uring);
+        return NULL;
+    }
+
+    uring->buffers = g_malloc ((gsize) URING_BUF_COUNT * URING_BUF_SIZE);
+    for (i = 0; i < URING_BUF_COUNT; i++)
+    {
+        io_uring_buf_ring_add (uring->buf_ring,
+                               uring->buffers + (gsize) i * URING_BUF_SIZE,
+                               URING_BUF_SIZE, i,
+                               io_uring_buf_ring_mask (URING_BUF_COUNT), i);
+    }
+    io_uring_buf_ring_advance (uring->buf_ring, URING_BUF_COUNT);
+
+    uring->context = g_main_context_ref (context);
+    uring->source = g_source_new (&uring_source_funcs, sizeof (UringSource));
+    ((UringSource *) uring->source)->uring = uring;
+    g_source_set_name (uring->source, "McpUring");
+    g_source_add_unix_fd (uring->source, uring->event_fd, G_IO_IN);
+    g_source_attach (uring->source, context);
+
+    return uring;
+}
+
+static McpUring *
+uring_get (void)
+{
+    GMainContext *context;
+    McpUring *uring;
+
+    context = g_main_context_ref_thread_default ();
+
+    g_mutex_lock (&uring_lock);
+    if (urings == NULL)
+    {
+        urings = g_hash_table_new (NULL, NULL);
+    }
+
+    uring = g_hash_table_lookup (urings, context);
+    if (uring != NULL)
+    {
+        uring->ref_count++;
+    }
+    else
+    {
+        uring = uring_new (context);
+        if (uring != NULL)
+        {
+            g_hash_table_insert (urings, context, uring);
+        }
+    }
+    g_mutex_unlock (&uring_lock);
+
+    g_main_context_unref (context);
+
+    return uring;
+}
+
+/* ── Channels ───────────────────────────────────────────────────────── */
+
+static void
+write_entry_free (WriteEntry *entry)
+{
+    g_bytes_unref (entry->data);
+    g_clear_object (&entry->task);
+    g_free (entry);
+}
+
+static void
+channel_ref (McpUringChannel *channel)
+{
+    channel->ref_count++;
+}
+
+static gboolean
+channel_has_writes (McpUringChannel *channel)
+{
+    return !g_queue_is_empty (&channel->writes) ||
+           !mcp_write_queue_is_empty (channel->queued);
+}
+
+/*
+ * Fails every queued write.  Only called while nothing is in flight,
+ * since in-flight entries are still referenced by the kernel.
+ */
+static void
+channel_fail_writes (McpUringChannel *channel,
+                     const GError    *error)
+{
+    GQueue writes;
+    McpWriteQueue *queued;
+    WriteEntry *entry;
+
+    /* Completion callbacks may queue more writes; those are not ours */
+    writes = channel->writes;
+    g_queue_init (&channel->writes);
+    queued = g_steal_pointer (&channel->queued);
+    channel->queued = mcp_write_queue_new ();
+    channel->head_offset = 0;
+
+    while ((entry = g_queue_pop_head (&writes)) != NULL ||
+           (entry = mcp_write_queue_pop (queued)) != NULL)
+    {
+        g_task_return_error (entry->task, g_error_copy (error));
+        write_entry_free (entry);
+    }
+
+    mcp_write_queue_free (queued, NULL);
+}
+
+static void
+channel_fail_writes_closed (McpUringChannel *channel)
+{
+    g_autoptr(GError) error = NULL;
+
+    if (!channel_has_writes (channel))
+    {
+        return;
+    }
+
+    error = g_error_new_literal (MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport disconnected");
+    channel_fail_writes (channel, error);
+}
+
+static void
+channel_unref (McpUringChannel *channel)
+{
+    if (--channel->ref_count > 0)
+    {
+        return;
+    }
+
+    channel_fail_writes_closed (channel);
+    mcp_write_queue_free (channel->queued, NULL);
+    uring_unref (channel->uring);
+    g_free (channel);
+}
+
+static void
+channel_queue_flush (McpUringChannel *channel)
+{
+    if (channel->flush_queued)
+    {
+        return;
+    }
+
+    channel->flush_queued = TRUE;
+    channel_ref (channel);
+    g_queue_push_tail (&channel->uring->pending, channel);
+}
+
+/*
+ * Writes as much of the queue as fits in one iovec: a sendmsg() on
+ * sockets (MSG_NOSIGNAL, like GSocket) or a writev() on pipes.  What
+ * is left of the last batch goes first, then queued entries in
+ * priority order.
+ */
+static void
+channel_flush (McpUringChannel *channel)
+{
+    struct io_uring_sqe *sqe;
+    WriteEntry *entry;
+    GList *l;
+    gsize offset;
+    guint n;
+
+    sqe = uring_get_sqe (channel->uring);
+    if (sqe == NULL)
+    {
+        g_autoptr(GError) error = NULL;
+
+        error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_BUSY,
+                                     "io_uring submission queue is full");
+        channel_fail_writes (channel, error);
+        return;
+    }
+
+    while (g_queue_get_length (&channel->writes) < URING_MAX_IOV &&
+           (entry = mcp_write_queue_pop (channel->queued)) != NULL)
+    {
+        g_queue_push_tail (&channel->writes, entry);
+    }
+
+    offset = channel->head_offset;
+    n = 0;
+    for (l = channel->writes.head; l != NULL && n < URING_MAX_IOV; l = l->next)
+    {
+        WriteEntry *entry = l->data;
+        const guint8 *bytes;
+        gsize len;
+
+        bytes = g_bytes_get_data (entry->data, &len);
+        channel->iov[n].iov_base = (gpointer) (bytes + offset);
+        channel->iov[n].iov_len = len - offset;
+        offset = 0;
+        n++;
+    }
+
+    if (channel->write_is_socket)
+    {
+        memset (&channel->msg, 0, sizeof channel->msg);
+        channel->msg.msg_iov = channel->iov;
+        channel->msg.msg_iovlen = n;
+        io_uring_prep_sendmsg (sqe, channel->write_fd, &channel->msg,
+                               MSG_NOSIGNAL);
+    }
+    else
+    {
+        io_uring_prep_writev (sqe, channel->write_fd, channel->iov, n,
+                              (guint64) -1);
+    }
+    io_uring_sqe_set_data64 (sqe, (guintptr) channel | OP_WRITE);
+
+    channel->writing = TRUE;
+    channel_ref (channel);
+}
+
+static void
+channel_write_complete (McpUringChannel *channel,
+                        gint             res)
+{
+    channel->writing = FALSE;
+
+    if (res == -ECANCELED)
+    {
+        channel_fail_writes_closed (channel);
+    }
+    else if (res < 0 && res != -EINTR && res != -EAGAIN)
+    {
+        g_autoptr(GError) error = NULL;
+
+        error = g_error_new_literal (G_IO_ERROR, g_io_error_from_errno (-res),
+                                     g_strerror (-res));
+        channel_fail_writes (channel, error);
+    }
+    else if (res > 0)
+    {
+        gsize written = res;
+
+        while (written > 0 && !g_queue_is_empty (&channel->writes))
+        {
+            WriteEntry *entry = g_queue_peek_head (&channel->writes);
+            gsize remaining;
+
+            remaining = g_bytes_get_size (entry->data) - channel->head_offset;
+            if (written < remaining)
+            {
+                channel->head_offset += written;
+                break;
+            }
+
+            written -= remaining;
+            channel->head_offset = 0;
+            g_queue_pop_head (&channel->writes);
+            g_task_return_boolean (entry->task, TRUE);
+            write_entry_free (entry);
+        }
+    }
+
+    if (channel->closed)
+    {
+        channel_fail_writes_closed (channel);
+    }
+    else if (channel_has_writes (channel))
+    {
+        channel_queue_flush (channel);
+    }
+
+    channel_unref (channel);
+}
+
+static void
+channel_read_finish (McpUringChannel *channel,
+                     const GError    *error)
+{
+    if (channel->read_done)
+    {
+        return;
+    }
+
+    channel->read_done = TRUE;
+    if (channel->read_func != NULL)
+    {
+        channel->read_func (NULL, 0, error, channel->user_data);
+    }
+}
+
+static void
+channel_arm_read (McpUringChannel *channel)
+{
+    McpUring *uring = channel->uring;
+    struct io_uring_sqe *sqe;
+
+    sqe = uring_get_sqe (uring);
+    if (sqe == NULL)
+    {
+        g_autoptr(GError) error = NULL;
+
+        error = g_error_new_literal (G_IO_ERROR, G_IO_ERROR_BUSY,
+                                     "io_uring submission queue is full");
+        channel_read_finish (channel, error);
+        return;
+    }
+
+    channel->multishot = channel->read_is_socket && !uring->no_multishot;
+    if (channel->multishot)
+    {
+        io_uring_prep_recv_multishot (sqe, channel->read_fd, NULL, 0, 0);
+    }
+    else if (channel->read_is_socket)
+    {
+        io_uring_prep_recv (sqe, channel->read_fd, NULL, URING_BUF_SIZE, 0);
+    }
+    else
+    {
+        io_uring_prep_read (sqe, channel->read_fd, NULL, URING_BUF_SIZE,
+                            (guint64) -1);
+    }
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    io_uring_sqe_set_data64 (sqe, (guintptr) channel | OP_READ);
+
+    channel->reading = TRUE;
+    channel_ref (channel);
+}
+
+static void
+channel_read_complete (McpUringChannel *channel,
+                       gint             res,
+                       guint            flags)
+{
+    McpUring *uring = channel->uring;
+    gboolean more = (flags & IORING_CQE_F_MORE) != 0;
+
+    if (!more)
+    {
+        channel->reading = FALSE;
+    }
+
+    if (flags & IORING_CQE_F_BUFFER)
+    {
+        guint bid = flags >> IORING_CQE_BUFFER_SHIFT;
+
+        if (res > 0 && channel->read_func != NULL && !channel->read_done)
+        {
+            g_atomic_pointer_add (&stat_receives, 1);
+            channel->read_func ((const gchar *) uring->buffers +
+                                (gsize) bid * URING_BUF_SIZE,
+                                res, NULL, channel->user_data);
+        }
+        uring_recycle_buffer (uring, bid);
+    }
+
+    if (res == 0)
+    {
+        channel_read_finish (channel, NULL);
+    }
+    else if (res == -EINVAL && channel->multishot && !uring->no_multishot)
+    {
+        /* Multishot receive needs 6.0: re-arm one receive at a time */
+        uring->no_multishot = TRUE;
+    }
+    else if (res < 0 && res != -ENOBUFS && res != -ECANCELED &&
+             res != -EINTR && res != -EAGAIN)
+    {
+        g_autoptr(GError) error = NULL;
+
+        error = g_error_new_literal (G_IO_ERROR, g_io_error_from_errno (-res),
+                                     g_strerror (-res));
+        channel_read_finish (channel, error);
+    }
+
+    if (!more)
+    {
+        /* Single-shot reads, and multishot receives the kernel ended
+         * (for instance with -ENOBUFS while every buffer was busy) */
+        if (!channel->closed && !channel->read_done)
+        {
+            channel_arm_read (channel);
+        }
+        channel_unref (channel);
+    }
+}
+
+static void
+handle_completion (McpUring *uring,
+                   guint64   data,
+                   gint      res,
+                   guint     flags)
+{
+    McpUringChannel *channel;
+
+    channel = (McpUringChannel *) (guintptr) (data & ~(guint64) OP_MASK);
+    if (channel == NULL)
+    {
+        return;
+    }
+
+    if ((data & OP_MASK) == OP_READ)
+    {
+        channel_read_complete (channel, res, flags);
+    }
+    else
+    {
+        channel_write_complete (channel, res);
+    }
+}
+
+/* ── Public API ─────────────────────────────────────────────────────── */
+
+static gboolean
+fd_is_stream (gint      fd,
+              gboolean *is_socket)
+{
+    struct stat st;
+
+    if (fd < 0 || fstat (fd, &st) < 0)
+    {
+        return FALSE;
+    }
+
+    *is_socket = S_ISSOCK (st.st_mode);
+    if (*is_socket)
+    {
+        return TRUE;
+    }
+
+    /* io_uring hands -EAGAIN back for O_NONBLOCK pipes instead of
+     * waiting, so only blocking ones are taken over. */
+    return S_ISFIFO (st.st_mode) && (fcntl (fd, F_GETFL) & O_NONBLOCK) == 0;
+}
+
+McpUringChannel *
+mcp_uring_channel_new (gint             read_fd,
+                       gint             write_fd,
+                       McpUringReadFunc read_func,
+                       gpointer         user_data)
+{
+    McpUringChannel *channel;
+    McpUring *uring;
+    gboolean read_is_socket;
+    gboolean write_is_socket;
+
+    g_return_val_if_fail (read_func != NULL, NULL);
+
+    if (!mcp_uring_is_available ())
+    {
+        return NULL;
+    }
+
+    /* Regular files and terminals stay on GIO */
+    if (!fd_is_stream (read_fd, &read_is_socket) ||
+        !fd_is_stream (write_fd, &write_is_socket))
+    {
+        return NULL;
+    }
+
+    uring = uring_get ();
+    if (uring == NULL)
+    {
+        return NULL;
+    }
+
+    channel = g_new0 (McpUringChannel, 1);
+    channel->ref_count = 1;
+    channel->uring = uring;
+    channel->read_fd = read_fd;
+    channel->write_fd = write_fd;
+    channel->read_is_socket = read_is_socket;
+    channel->write_is_socket = write_is_socket;
+    channel->read_func = read_func;
+    channel->user_data = user_data;
+    g_queue_init (&channel->writes);
+    channel->queued = mcp_write_queue_new ();
+
+    return channel;
+}
+
+void
+mcp_uring_channel_start (McpUringChannel *channel)
+{
+    g_return_if_fail (channel != NULL);
+
+    if (channel->reading || channel->read_done || channel->closed)
+    {
+        return;
+    }
+
+    channel_arm_read (channel);
+}
+
+void
+mcp_uring_channel_write (McpUringChannel    *channel,
+                         GBytes             *data,
+                         McpMessagePriority  priority,
+                         GTask              *task)
+{
+    WriteEntry *entry;
+
+    g_return_if_fail (channel != NULL);
+    g_return_if_fail (data != NULL);
+    g_return_if_fail (G_IS_TASK (task));
+
+    if (channel->closed)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "Transport disconnected");
+        g_object_unref (task);
+        return;
+    }
+
+    entry = g_new0 (WriteEntry, 1);
+    entry->data = g_bytes_ref (data);
+    entry->task = task;
+    mcp_write_queue_push (channel->queued, priority, entry);
+    g_atomic_pointer_add (&stat_sends, 1);
+
+    if (!channel->writing)
+    {
+        channel_queue_flush (channel);
+    }
+}
+
+void
+mcp_uring_channel_close (McpUringChannel *channel)
+{
+    McpUring *uring;
+    struct io_uring_sqe *sqe;
+
+    g_return_if_fail (channel != NULL);
+    g_return_if_fail (!channel->closed);
+
+    uring = channel->uring;
+    channel->closed = TRUE;
+    channel->read_func = NULL;
+
+    if (channel->reading && (sqe = uring_get_sqe (uring)) != NULL)
+    {
+        io_uring_prep_cancel64 (sqe, (guintptr) channel | OP_READ, 0);
+        io_uring_sqe_set_data64 (sqe, 0);
+    }
+
+    if (channel->writing && (sqe = uring_get_sqe (uring)) != NULL)
+    {
+        io_uring_prep_cancel64 (sqe, (guintptr) channel | OP_WRITE, 0);
+        io_uring_sqe_set_data64 (sqe, 0);
+    }
+    else if (!channel->writing)
+    {
+        channel_fail_writes_closed (channel);
+    }
+
+    /* The caller is about to close the descriptors */
+    uring_submit (uring);
+
+    channel_unref (channel);
+}
+
+#else /* !MCP_HAVE_IO_URING */
+
+gboolean
+mcp_uring_is_available (void)
+{
+    return FALSE;
+}
+
+McpUringChannel *
+mcp_uring_channel_new (gint             read_fd,
+                       gint             write_fd,
+                       McpUringReadFunc read_func,
+                       gpointer         user_data)
+{
+    return NULL;
+}
+
+void
+mcp_uring_channel_start (McpUringChannel *channel)
+{
+    g_return_if_reached ();
+}
+
+void
+mcp_uring_channel_write (McpUringChannel    *channel,
+                         GBytes             *data,
+                         McpMessagePriority  priority,
+                         GTask              *task)
+{
+    g_return_if_reached ();
+}
+
+void
+mcp_uring_channel_close (McpUringChannel *channel)
+{
+    g_return_if_reached ();
+}
+
+#endif /* MCP_HAVE_IO_URING */
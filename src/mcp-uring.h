@@ -0,0 +1,145 @@
+/*
+ * mcp-uring.h - io_uring I/O backend for mcp-glib
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * McpStdioTransport (and so every McpUnixSocketServer session) can move
+ * its bytes through a per-GMainContext io_uring instead of GIO's
+ * stream emulation.  All channels on a context share one ring, one pool
+ * of provided receive buffers and one eventfd source; sends queued by
+ * any number of sessions during a main loop iteration go to the kernel
+ * in a single io_uring_enter() call.
+ *
+ * The backend is only compiled in when liburing is found at build time
+ * (MCP_HAVE_IO_URING) and is only used when the running kernel accepts
+ * the ring setup.  Otherwise mcp_uring_channel_new() returns %NULL and
+ * callers keep using their GIO streams.
+ */
+
+#ifndef MCP_URING_H
+#define MCP_URING_H
+
+
+#include <glib.h>
+#include <gio/gio.h>
+#include "mcp-enums.h"
+
+G_BEGIN_DECLS
+
+/**
+ * McpUringChannel:
+ *
+ * An opaque pair of file descriptors (one to read, one to write)
+ * driven by the io_uring of the thread-default #GMainContext it was
+ * created on.  A channel does not own its file descriptors.
+ */
+typedef struct _McpUringChannel McpUringChannel;
+
+/**
+ * McpUringReadFunc:
+ * @data: (nullable): the bytes received, or %NULL at end of stream or
+ *   on error
+ * @length: number of bytes in @data
+ * @error: (nullable): the read error, or %NULL
+ * @user_data: data passed to mcp_uring_channel_new()
+ *
+ * Called from the channel's #GMainContext for every chunk read.  @data
+ * is only valid for the duration of the call.  After end of stream or
+ * an error the function is not called again.
+ */
+typedef void (*McpUringReadFunc) (const gchar  *data,
+                                  gsize         length,
+                                  const GError *error,
+                                  gpointer      user_data);
+
+/**
+ * mcp_uring_is_available:
+ *
+ * Checks whether the io_uring backend was compiled in, is supported by
+ * the running kernel and has not been disabled by setting the
+ * `MCP_IO_URING` environment variable to `0`.  The answer is computed
+ * once per process.
+ *
+ * Returns: %TRUE if mcp_uring_channel_new() can succeed
+ */
+gboolean mcp_uring_is_available (void);
+
+/**
+ * mcp_uring_channel_new:
+ * @read_fd: a socket or pipe to read from
+ * @write_fd: a socket or pipe to write to (may equal @read_fd)
+ * @read_func: function called with incoming data
+ * @user_data: data for @read_func
+ *
+ * Creates a channel on the io_uring of the thread-default
+ * #GMainContext, creating that ring if needed.  Reading starts with
+ * mcp_uring_channel_start().
+ *
+ * Returns: (transfer full) (nullable): a new channel, or %NULL if the
+ *   backend is unavailable or the descriptors are not sockets or pipes
+ */
+McpUringChannel *mcp_uring_channel_new (gint             read_fd,
+                                        gint             write_fd,
+                                        McpUringReadFunc read_func,
+                                        gpointer         user_data);
+
+/**
+ * mcp_uring_channel_start:
+ * @channel: an #McpUringChannel
+ *
+ * Starts reading.  On sockets this arms one multishot receive that
+ * stays in the kernel for the life of the channel.
+ */
+void mcp_uring_channel_start (McpUringChannel *channel);
+
+/**
+ * mcp_uring_channel_write:
+ * @channel: an #McpUringChannel
+ * @data: the bytes to write
+ * @priority: the lane @data waits in
+ * @task: (transfer full): task completed with %TRUE once all of @data
+ *   has been written, or with an error
+ *
+ * Queues @data after everything previously queued at @priority or
+ * above.  Queued buffers are written with one vectored send per
+ * channel and submitted together with every other channel's at the
+ * start of the next main loop iteration; buffers already handed to the
+ * kernel are not reordered.
+ */
+void mcp_uring_channel_write (McpUringChannel    *channel,
+                              GBytes             *data,
+                              McpMessagePriority  priority,
+                              GTask              *task);
+
+/**
+ * mcp_uring_channel_close:
+ * @channel: (transfer full): an #McpUringChannel
+ *
+ * Cancels the channel's reads and writes and drops the caller's
+ * reference.  @read_func is not called again and queued writes fail
+ * with %MCP_ERROR_CONNECTION_CLOSED.  Cancellation is submitted before
+ * this returns, so the file descriptors may be closed right after.
+ */
+void mcp_uring_channel_close (McpUringChannel *channel);
+
+/**
+ * mcp_uring_get_stats:
+ * @n_syscalls: (out) (optional): return location for the number of
+ *   io_uring_enter() and eventfd read() calls made
+ * @n_sends: (out) (optional): return location for the number of
+ *   buffers queued with mcp_uring_channel_write()
+ * @n_receives: (out) (optional): return location for the number of
+ *   chunks passed to read functions
+ *
+ * Gets counters summed over every ring the process has used, for
+ * benchmarks.  The poll() of the #GMainContext itself is not counted.
+ * Without the backend every counter is 0.
+ */
+void mcp_uring_get_stats (guint64 *n_syscalls,
+                          guint64 *n_sends,
+                          guint64 *n_receives);
+
+G_END_DECLS
+
+#endif /* MCP_URING_H */
@@ -6,9 +6,12 @@
  */
 #include "mcp-websocket-server-transport.h"
 #include "mcp-error.h"
+#include "mcp-json-parse.h"
+#include "mcp-json-writer.h"
 #undef MCP_COMPILATION
 
 #include <string.h>
+#include <sys/socket.h>
 
 /**
  * SECTION:mcp-websocket-server-transport
@@ -20,6 +23,15 @@
  * bidirectional communication via text frames.
  *
  * This is the server-side counterpart to #McpWebSocketTransport.
+ *
+ * Each transport serves one connection.  Several transports, one per
+ * thread or process, can share a port by setting
+ * #McpWebSocketServerTransport:reuse-port; a WebSocket session lives on
+ * a single connection, so it never needs to move between them.
+ *
+ * Outgoing messages are handed to the connection only while its socket
+ * has room; until then they wait in an #McpWriteQueue, so responses go
+ * ahead of notifications queued behind a slow client.
  */
 
 struct _McpWebSocketServerTransport
@@ -36,6 +48,7 @@ struct _McpWebSocketServerTransport
     gchar *auth_token;
     guint  keepalive_interval;
     GTlsCertificate *tls_certificate;
+    gboolean reuse_port;
 
     /* Server */
     SoupServer *server;
@@ -51,8 +64,15 @@ struct _McpWebSocketServerTransport
     /* Keepalive */
     guint keepalive_timeout_id;
 
+    /* Frames waiting for the socket to drain, by priority */
+    McpWriteQueue *write_queue;
+    GSource       *write_source;    /* only while the socket is full */
+
     /* Transport state */
     McpTransportState state;
+
+    /* Reused to serialize outgoing messages */
+    McpJsonWriter *writer;
 };
 
 static void mcp_websocket_server_transport_iface_init (McpTransportInterface *iface);
@@ -73,11 +93,26 @@ enum
     PROP_AUTH_TOKEN,
     PROP_KEEPALIVE_INTERVAL,
     PROP_TLS_CERTIFICATE,
+    PROP_REUSE_PORT,
     N_PROPERTIES
 };
 
 static GParamSpec *properties[N_PROPERTIES];
 
+typedef struct
+{
+    GTask *task;
+    gchar *text;
+} WriteEntry;
+
+static void
+write_entry_free (WriteEntry *entry)
+{
+    g_object_unref (entry->task);
+    g_free (entry->text);
+    g_free (entry);
+}
+
 /* Forward declarations */
 static void stop_server (McpWebSocketServerTransport *self);
 static void start_keepalive (McpWebSocketServerTransport *self);
@@ -166,6 +201,28 @@ validate_origin (McpWebSocketServerTransport *self,
     return g_strcmp0 (origin_header, self->origin) == 0;
 }
 
+/*
+ * Fails every queued frame; the connection they were meant for is gone
+ */
+static void
+fail_write_queue (McpWebSocketServerTransport *self)
+{
+    WriteEntry *entry;
+
+    if (self->write_source != NULL)
+    {
+        g_source_destroy (self->write_source);
+        g_clear_pointer (&self->write_source, g_source_unref);
+    }
+
+    while ((entry = mcp_write_queue_pop (self->write_queue)) != NULL)
+    {
+        g_task_return_new_error (entry->task, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                                 "Connection closed before the message was sent");
+        write_entry_free (entry);
+    }
+}
+
 /*
  * Handle incoming WebSocket message
  */
@@ -176,11 +233,10 @@ on_websocket_message (SoupWebsocketConnection *connection,
                       gpointer                 user_data)
 {
     McpWebSocketServerTransport *self = MCP_WEBSOCKET_SERVER_TRANSPORT (user_data);
-    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(JsonNode) root = NULL;
     g_autoptr(GError) error = NULL;
     const gchar *data;
     gsize len;
-    JsonNode *root;
 
     /* Only handle text messages */
     if (type != SOUP_WEBSOCKET_DATA_TEXT)
@@ -195,8 +251,8 @@ on_websocket_message (SoupWebsocketConnection *connection,
     }
 
     /* Parse JSON */
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, data, len, &error))
+    root = mcp_json_parse (data, len, &error);
+    if (root == NULL)
     {
         g_autoptr(GError) parse_error = NULL;
 
@@ -206,12 +262,6 @@ on_websocket_message (SoupWebsocketConnection *connection,
         return;
     }
 
-    root = json_parser_get_root (parser);
-    if (root == NULL)
-    {
-        return;
-    }
-
     /* Emit message-received signal */
     mcp_transport_emit_message_received (MCP_TRANSPORT (self), root);
 }
@@ -246,6 +296,7 @@ on_websocket_closed (SoupWebsocketConnection *connection,
 
     g_clear_object (&self->connection);
     self->client_connected = FALSE;
+    fail_write_queue (self);
 }
 
 /*
@@ -378,6 +429,73 @@ stop_keepalive (McpWebSocketServerTransport *self)
     }
 }
 
+/*
+ * Listens with SO_REUSEPORT as one shard of a group sharing the
+ * configured port
+ */
+static gboolean
+listen_shard (McpWebSocketServerTransport  *self,
+              GError                      **error)
+{
+    g_autoptr(GInetAddress) address = NULL;
+    g_autoptr(GSocket) sock = NULL;
+    g_autoptr(GSocketAddress) bind_address = NULL;
+    g_autoptr(GSocketAddress) local_address = NULL;
+
+    if (g_strcmp0 (self->host, "127.0.0.1") == 0 ||
+        g_strcmp0 (self->host, "localhost") == 0)
+    {
+        address = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+        sock = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_STREAM,
+                             G_SOCKET_PROTOCOL_TCP, error);
+    }
+    else
+    {
+        /* Dual-stack where available, as soup_server_listen_all() */
+        address = g_inet_address_new_any (G_SOCKET_FAMILY_IPV6);
+        sock = g_socket_new (G_SOCKET_FAMILY_IPV6, G_SOCKET_TYPE_STREAM,
+                             G_SOCKET_PROTOCOL_TCP, NULL);
+        if (sock == NULL)
+        {
+            g_clear_object (&address);
+            address = g_inet_address_new_any (G_SOCKET_FAMILY_IPV4);
+            sock = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_STREAM,
+                                 G_SOCKET_PROTOCOL_TCP, error);
+        }
+    }
+    if (sock == NULL)
+    {
+        return FALSE;
+    }
+
+#ifdef SO_REUSEPORT
+    if (!g_socket_set_option (sock, SOL_SOCKET, SO_REUSEPORT, 1, error))
+    {
+        return FALSE;
+    }
+#else
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                         "SO_REUSEPORT is not supported on this platform");
+    return FALSE;
+#endif
+
+    bind_address = g_inet_socket_address_new (address, self->port);
+    if (!g_socket_bind (sock, bind_address, TRUE, error) ||
+        !g_socket_listen (sock, error))
+    {
+        return FALSE;
+    }
+
+    local_address = g_socket_get_local_address (sock, error);
+    if (local_address == NULL)
+    {
+        return FALSE;
+    }
+    self->actual_port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (local_address));
+
+    return soup_server_listen_socket (self->server, sock, 0, error);
+}
+
 /* McpTransport interface implementation */
 
 static McpTransportState
@@ -439,7 +557,17 @@ mcp_websocket_server_transport_connect_async (McpTransport        *transport,
     }
 
     /* Start listening */
-    if (self->host != NULL && self->host[0] != '\0')
+    if (self->reuse_port)
+    {
+        if (!listen_shard (self, &error))
+        {
+            stop_server (self);
+            g_task_return_error (task, g_steal_pointer (&error));
+            set_state (self, MCP_TRANSPORT_STATE_ERROR);
+            return;
+        }
+    }
+    else if (self->host != NULL && self->host[0] != '\0')
     {
         if (g_strcmp0 (self->host, "127.0.0.1") == 0 ||
             g_strcmp0 (self->host, "localhost") == 0)
@@ -471,17 +599,20 @@ mcp_websocket_server_transport_connect_async (McpTransport        *transport,
         }
     }
 
-    /* Get the actual port */
-    uris = soup_server_get_uris (self->server);
-    if (uris != NULL)
-    {
-        GUri *uri = uris->data;
-        self->actual_port = g_uri_get_port (uri);
-        g_slist_free_full (uris, (GDestroyNotify) g_uri_unref);
-    }
-    else
+    /* Get the actual port.  Shards already know it from their socket. */
+    if (!self->reuse_port)
     {
-        self->actual_port = self->port;
+        uris = soup_server_get_uris (self->server);
+        if (uris != NULL)
+        {
+            GUri *uri = uris->data;
+            self->actual_port = g_uri_get_port (uri);
+            g_slist_free_full (uris, (GDestroyNotify) g_uri_unref);
+        }
+        else
+        {
+            self->actual_port = self->port;
+        }
     }
 
     set_state (self, MCP_TRANSPORT_STATE_CONNECTED);
@@ -526,32 +657,83 @@ mcp_websocket_server_transport_disconnect_finish (McpTransport  *transport,
     return g_task_propagate_boolean (G_TASK (result), error);
 }
 
-static void
-mcp_websocket_server_transport_send_message_async (McpTransport        *transport,
-                                                    JsonNode            *message,
-                                                    GCancellable        *cancellable,
-                                                    GAsyncReadyCallback  callback,
-                                                    gpointer             user_data)
+static gboolean flush_write_queue (McpWebSocketServerTransport *self);
+
+static gboolean
+on_socket_writable (GObject  *stream,
+                    gpointer  user_data)
 {
-    McpWebSocketServerTransport *self = MCP_WEBSOCKET_SERVER_TRANSPORT (transport);
-    g_autoptr(GTask) task = NULL;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autofree gchar *json_data = NULL;
+    McpWebSocketServerTransport *self = MCP_WEBSOCKET_SERVER_TRANSPORT (user_data);
 
-    task = g_task_new (self, cancellable, callback, user_data);
-    g_task_set_source_tag (task, mcp_websocket_server_transport_send_message_async);
+    /* Dropped here; flushing re-arms it if the socket fills up again */
+    g_clear_pointer (&self->write_source, g_source_unref);
+    flush_write_queue (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Hands queued frames to the connection, highest lane first, while its
+ * socket has room.  libsoup queues whatever it cannot write at once in
+ * call order, so a frame handed over when the socket is full would hold
+ * back everything sent after it.  Returns %FALSE once the socket is
+ * full.
+ */
+static gboolean
+flush_write_queue (McpWebSocketServerTransport *self)
+{
+    GPollableOutputStream *output;
+    WriteEntry *entry;
 
-    if (self->state != MCP_TRANSPORT_STATE_CONNECTED)
+    if (self->connection == NULL || self->write_source != NULL)
     {
-        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
-                                  "Transport not connected");
-        return;
+        return FALSE;
+    }
+
+    /* libsoup itself requires the stream to be pollable */
+    output = G_POLLABLE_OUTPUT_STREAM (g_io_stream_get_output_stream (
+        soup_websocket_connection_get_io_stream (self->connection)));
+
+    while ((entry = mcp_write_queue_peek (self->write_queue)) != NULL)
+    {
+        if (!g_pollable_output_stream_is_writable (output))
+        {
+            self->write_source = g_pollable_output_stream_create_source (output, NULL);
+            g_source_set_callback (self->write_source, (GSourceFunc) on_socket_writable,
+                                   self, NULL);
+            g_source_attach (self->write_source, g_main_context_get_thread_default ());
+            return FALSE;
+        }
+
+        mcp_write_queue_pop (self->write_queue);
+        soup_websocket_connection_send_text (self->connection, entry->text);
+        g_task_return_boolean (entry->task, TRUE);
+        write_entry_free (entry);
     }
 
+    return TRUE;
+}
+
+/*
+ * send_frame:
+ *
+ * Queues one serialized message as a text frame behind those already
+ * waiting at @priority or above, and completes @task once it has been
+ * handed to the connection.  Takes ownership of @text.
+ */
+static void
+send_frame (McpWebSocketServerTransport *self,
+            GTask                       *task,
+            gchar                       *text,
+            McpMessagePriority           priority)
+{
+    WriteEntry *entry;
+
     if (!self->client_connected || self->connection == NULL)
     {
         g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
                                   "No client connected");
+        g_free (text);
         return;
     }
 
@@ -559,18 +741,70 @@ mcp_websocket_server_transport_send_message_async (McpTransport        *transpor
     {
         g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
                                   "WebSocket connection not open");
+        g_free (text);
         return;
     }
 
-    /* Serialize JSON */
-    generator = json_generator_new ();
-    json_generator_set_root (generator, message);
-    json_data = json_generator_to_data (generator, NULL);
+    entry = g_new0 (WriteEntry, 1);
+    entry->task = g_object_ref (task);
+    entry->text = text;
+    mcp_write_queue_push (self->write_queue, priority, entry);
+    flush_write_queue (self);
+}
 
-    /* Send as text frame */
-    soup_websocket_connection_send_text (self->connection, json_data);
+static void
+mcp_websocket_server_transport_send_message_async (McpTransport        *transport,
+                                                    JsonNode            *message,
+                                                    GCancellable        *cancellable,
+                                                    GAsyncReadyCallback  callback,
+                                                    gpointer             user_data)
+{
+    McpWebSocketServerTransport *self = MCP_WEBSOCKET_SERVER_TRANSPORT (transport);
+    g_autoptr(GTask) task = NULL;
 
-    g_task_return_boolean (task, TRUE);
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_websocket_server_transport_send_message_async);
+
+    /* Serialize JSON; the frame may have to wait, so it is copied */
+    mcp_json_writer_reset (self->writer);
+    mcp_json_writer_node (self->writer, message);
+
+    send_frame (self, task, g_strdup (mcp_json_writer_get_data (self->writer, NULL)),
+                mcp_transport_classify_message (message));
+}
+
+static void
+mcp_websocket_server_transport_send_raw_with_priority_async (McpTransport        *transport,
+                                                              GBytes              *data,
+                                                              McpMessagePriority   priority,
+                                                              GCancellable        *cancellable,
+                                                              GAsyncReadyCallback  callback,
+                                                              gpointer             user_data)
+{
+    McpWebSocketServerTransport *self = MCP_WEBSOCKET_SERVER_TRANSPORT (transport);
+    g_autoptr(GTask) task = NULL;
+    const gchar *bytes;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_websocket_server_transport_send_raw_with_priority_async);
+
+    /* soup_websocket_connection_send_text() wants a NUL-terminated string */
+    bytes = g_bytes_get_data (data, &len);
+    send_frame (self, task, g_strndup (bytes, len), priority);
+}
+
+static void
+mcp_websocket_server_transport_send_raw_async (McpTransport        *transport,
+                                                GBytes              *data,
+                                                GCancellable        *cancellable,
+                                                GAsyncReadyCallback  callback,
+                                                gpointer             user_data)
+{
+    mcp_websocket_server_transport_send_raw_with_priority_async (transport, data,
+                                                                  mcp_transport_classify_raw (data),
+                                                                  cancellable, callback,
+                                                                  user_data);
 }
 
 static gboolean
@@ -591,6 +825,9 @@ mcp_websocket_server_transport_iface_init (McpTransportInterface *iface)
     iface->disconnect_finish = mcp_websocket_server_transport_disconnect_finish;
     iface->send_message_async = mcp_websocket_server_transport_send_message_async;
     iface->send_message_finish = mcp_websocket_server_transport_send_message_finish;
+    iface->send_raw_async = mcp_websocket_server_transport_send_raw_async;
+    iface->send_raw_finish = mcp_websocket_server_transport_send_message_finish;
+    iface->send_raw_with_priority_async = mcp_websocket_server_transport_send_raw_with_priority_async;
 }
 
 static void
@@ -626,6 +863,7 @@ stop_server (McpWebSocketServerTransport *self)
         g_clear_object (&self->connection);
         self->client_connected = FALSE;
     }
+    fail_write_queue (self);
 
     /* Stop server */
     if (self->server != NULL)
@@ -655,6 +893,8 @@ mcp_websocket_server_transport_finalize (GObject *object)
 {
     McpWebSocketServerTransport *self = MCP_WEBSOCKET_SERVER_TRANSPORT (object);
 
+    mcp_json_writer_free (self->writer);
+    mcp_write_queue_free (self->write_queue, NULL);
     g_free (self->host);
     g_free (self->path);
     g_strfreev (self->protocols);
@@ -701,6 +941,9 @@ mcp_websocket_server_transport_get_property (GObject    *object,
         case PROP_TLS_CERTIFICATE:
             g_value_set_object (value, self->tls_certificate);
             break;
+        case PROP_REUSE_PORT:
+            g_value_set_boolean (value, self->reuse_port);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -744,6 +987,9 @@ mcp_websocket_server_transport_set_property (GObject      *object,
         case PROP_TLS_CERTIFICATE:
             mcp_websocket_server_transport_set_tls_certificate (self, g_value_get_object (value));
             break;
+        case PROP_REUSE_PORT:
+            mcp_websocket_server_transport_set_reuse_port (self, g_value_get_boolean (value));
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -868,12 +1114,27 @@ mcp_websocket_server_transport_class_init (McpWebSocketServerTransportClass *kla
                              G_TYPE_TLS_CERTIFICATE,
                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+    /**
+     * McpWebSocketServerTransport:reuse-port:
+     *
+     * Whether to listen with SO_REUSEPORT as one shard of a group of
+     * transports sharing the same port.
+     */
+    properties[PROP_REUSE_PORT] =
+        g_param_spec_boolean ("reuse-port",
+                              "Reuse Port",
+                              "Listen with SO_REUSEPORT as one of several shards",
+                              FALSE,
+                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties (object_class, N_PROPERTIES, properties);
 }
 
 static void
 mcp_websocket_server_transport_init (McpWebSocketServerTransport *self)
 {
+    self->writer = mcp_json_writer_new ();
+    self->write_queue = mcp_write_queue_new ();
     self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
     self->path = g_strdup ("/");
     self->require_auth = FALSE;
@@ -1130,3 +1391,25 @@ mcp_websocket_server_transport_get_actual_port (McpWebSocketServerTransport *sel
     g_return_val_if_fail (MCP_IS_WEBSOCKET_SERVER_TRANSPORT (self), 0);
     return self->actual_port;
 }
+
+gboolean
+mcp_websocket_server_transport_get_reuse_port (McpWebSocketServerTransport *self)
+{
+    g_return_val_if_fail (MCP_IS_WEBSOCKET_SERVER_TRANSPORT (self), FALSE);
+    return self->reuse_port;
+}
+
+void
+mcp_websocket_server_transport_set_reuse_port (McpWebSocketServerTransport *self,
+                                               gboolean                     reuse_port)
+{
+    g_return_if_fail (MCP_IS_WEBSOCKET_SERVER_TRANSPORT (self));
+    g_return_if_fail (self->state == MCP_TRANSPORT_STATE_DISCONNECTED);
+
+    reuse_port = !!reuse_port;
+    if (self->reuse_port != reuse_port)
+    {
+        self->reuse_port = reuse_port;
+        g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_REUSE_PORT]);
+    }
+}
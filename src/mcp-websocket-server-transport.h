@@ -275,6 +275,30 @@ gboolean mcp_websocket_server_transport_has_client (McpWebSocketServerTransport
  */
 guint mcp_websocket_server_transport_get_actual_port (McpWebSocketServerTransport *self);
 
+/**
+ * mcp_websocket_server_transport_get_reuse_port:
+ * @self: an #McpWebSocketServerTransport
+ *
+ * Gets whether the transport listens as one shard of a group.
+ *
+ * Returns: %TRUE if SO_REUSEPORT sharding is enabled
+ */
+gboolean mcp_websocket_server_transport_get_reuse_port (McpWebSocketServerTransport *self);
+
+/**
+ * mcp_websocket_server_transport_set_reuse_port:
+ * @self: an #McpWebSocketServerTransport
+ * @reuse_port: whether to listen with SO_REUSEPORT
+ *
+ * Makes the transport one shard of a group of transports listening on
+ * the same port, each in its own thread or process; the kernel
+ * balances new connections across the group.  Shards in different
+ * processes must run as the same user.  Cannot be changed while
+ * connected.
+ */
+void mcp_websocket_server_transport_set_reuse_port (McpWebSocketServerTransport *self,
+                                                    gboolean                     reuse_port);
+
 G_END_DECLS
 
 #endif /* MCP_WEBSOCKET_SERVER_TRANSPORT_H */
@@ -6,6 +6,8 @@
  */
 #include "mcp-websocket-transport.h"
 #include "mcp-error.h"
+#include "mcp-json-parse.h"
+#include "mcp-json-writer.h"
 #undef MCP_COMPILATION
 
 #include <string.h>
@@ -56,6 +58,9 @@ struct _McpWebSocketTransport
 
     /* Pending connect task */
     GTask *connect_task;
+
+    /* Reused to serialize outgoing messages */
+    McpJsonWriter *writer;
 };
 
 static void mcp_websocket_transport_iface_init (McpTransportInterface *iface);
@@ -156,11 +161,10 @@ on_websocket_message (SoupWebsocketConnection *connection,
                       gpointer                 user_data)
 {
     McpWebSocketTransport *self = MCP_WEBSOCKET_TRANSPORT (user_data);
-    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(JsonNode) root = NULL;
     g_autoptr(GError) error = NULL;
     const gchar *data;
     gsize length;
-    JsonNode *root;
 
     if (type != SOUP_WEBSOCKET_DATA_TEXT)
     {
@@ -175,16 +179,10 @@ on_websocket_message (SoupWebsocketConnection *connection,
     }
 
     /* Parse JSON */
-    parser = json_parser_new ();
-    if (!json_parser_load_from_data (parser, data, length, &error))
-    {
-        g_warning ("Failed to parse WebSocket message as JSON: %s", error->message);
-        return;
-    }
-
-    root = json_parser_get_root (parser);
+    root = mcp_json_parse (data, length, &error);
     if (root == NULL)
     {
+        g_warning ("Failed to parse WebSocket message as JSON: %s", error->message);
         return;
     }
 
@@ -541,8 +539,6 @@ mcp_websocket_transport_send_message_async (McpTransport        *transport,
 {
     McpWebSocketTransport *self = MCP_WEBSOCKET_TRANSPORT (transport);
     GTask *task;
-    g_autoptr(JsonGenerator) generator = NULL;
-    g_autofree gchar *json_data = NULL;
 
     task = g_task_new (self, cancellable, callback, user_data);
     g_task_set_source_tag (task, mcp_websocket_transport_send_message_async);
@@ -556,13 +552,47 @@ mcp_websocket_transport_send_message_async (McpTransport        *transport,
         return;
     }
 
-    /* Serialize JSON */
-    generator = json_generator_new ();
-    json_generator_set_root (generator, message);
-    json_data = json_generator_to_data (generator, NULL);
+    /* Serialize JSON; libsoup copies the frame, so the buffer is reused */
+    mcp_json_writer_reset (self->writer);
+    mcp_json_writer_node (self->writer, message);
 
     /* Send text message */
-    soup_websocket_connection_send_text (self->connection, json_data);
+    soup_websocket_connection_send_text (self->connection,
+                                         mcp_json_writer_get_data (self->writer, NULL));
+
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+static void
+mcp_websocket_transport_send_raw_async (McpTransport        *transport,
+                                         GBytes              *data,
+                                         GCancellable        *cancellable,
+                                         GAsyncReadyCallback  callback,
+                                         gpointer             user_data)
+{
+    McpWebSocketTransport *self = MCP_WEBSOCKET_TRANSPORT (transport);
+    GTask *task;
+    g_autofree gchar *text = NULL;
+    const gchar *bytes;
+    gsize len;
+
+    task = g_task_new (self, cancellable, callback, user_data);
+    g_task_set_source_tag (task, mcp_websocket_transport_send_raw_async);
+
+    if (self->connection == NULL ||
+        soup_websocket_connection_get_state (self->connection) != SOUP_WEBSOCKET_STATE_OPEN)
+    {
+        g_task_return_new_error (task, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR,
+                                  "WebSocket not connected");
+        g_object_unref (task);
+        return;
+    }
+
+    /* soup_websocket_connection_send_text() wants a NUL-terminated string */
+    bytes = g_bytes_get_data (data, &len);
+    text = g_strndup (bytes, len);
+    soup_websocket_connection_send_text (self->connection, text);
 
     g_task_return_boolean (task, TRUE);
     g_object_unref (task);
@@ -586,6 +616,8 @@ mcp_websocket_transport_iface_init (McpTransportInterface *iface)
     iface->disconnect_finish = mcp_websocket_transport_disconnect_finish;
     iface->send_message_async = mcp_websocket_transport_send_message_async;
     iface->send_message_finish = mcp_websocket_transport_send_message_finish;
+    iface->send_raw_async = mcp_websocket_transport_send_raw_async;
+    iface->send_raw_finish = mcp_websocket_transport_send_message_finish;
 }
 
 /* GObject implementation */
@@ -616,6 +648,7 @@ mcp_websocket_transport_finalize (GObject *object)
 {
     McpWebSocketTransport *self = MCP_WEBSOCKET_TRANSPORT (object);
 
+    mcp_json_writer_free (self->writer);
     g_free (self->uri);
     g_free (self->auth_token);
     g_strfreev (self->protocols);
@@ -776,6 +809,7 @@ mcp_websocket_transport_class_init (McpWebSocketTransportClass *klass)
 static void
 mcp_websocket_transport_init (McpWebSocketTransport *self)
 {
+    self->writer = mcp_json_writer_new ();
     self->state = MCP_TRANSPORT_STATE_DISCONNECTED;
     self->reconnect_enabled = TRUE;
     self->reconnect_delay_ms = 1000;
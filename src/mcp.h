@@ -42,6 +42,12 @@ G_BEGIN_DECLS
 /* Error handling */
 #include "mcp-error.h"
 
+/* JSON input and output, shared values, scratch memory */
+#include "mcp-json-parse.h"
+#include "mcp-arena.h"
+#include "mcp-json-writer.h"
+#include "mcp-json-intern.h"
+
 /* Entity types */
 #include "mcp-tool.h"
 #include "mcp-resource.h"
@@ -70,6 +76,9 @@ G_BEGIN_DECLS
 /* Multiplexed transport (no I/O of its own — host supplies framing). */
 #include "mcp-mux-transport.h"
 
+/* In-process transport pair (client and server in one process). */
+#include "mcp-in-process-transport.h"
+
 /*
  * Stdio transport requires platform-specific stream APIs.
  * On Windows cross-compilation via mingw, gwin32inputstream.h is unavailable.
@@ -77,8 +86,14 @@ G_BEGIN_DECLS
  */
 #ifndef MCP_NO_STDIO_TRANSPORT
 #include "mcp-stdio-transport.h"
+/* Optional io_uring backend behind McpStdioTransport */
+#include "mcp-uring.h"
 /* Unix socket server requires gio-unix-2.0 and McpStdioTransport */
 #include "mcp-unix-socket-server.h"
+/* Shared-memory upgrade offered by the Unix socket server */
+#include "mcp-shm-transport.h"
+/* Message-per-datagram transport for SOCK_SEQPACKET sockets */
+#include "mcp-seqpacket-transport.h"
 #endif
 
 /*
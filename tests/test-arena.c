@@ -0,0 +1,111 @@
+/*
+ * test-arena.c - Unit tests for McpArena
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <glib.h>
+#include <string.h>
+#include "mcp.h"
+
+static void
+test_arena_alloc (void)
+{
+    g_autoptr(McpArena) arena = NULL;
+    gchar *a;
+    gchar *b;
+    gint64 *n;
+
+    arena = mcp_arena_new (256);
+    g_assert_cmpuint (mcp_arena_get_allocated (arena), ==, 0);
+
+    a = mcp_arena_alloc (arena, 3);
+    b = mcp_arena_alloc (arena, 5);
+    g_assert_nonnull (a);
+    g_assert_nonnull (b);
+    g_assert_true (a != b);
+    g_assert_cmpuint (mcp_arena_get_allocated (arena), ==, 256);
+
+    /* Allocations are aligned for any basic type */
+    n = mcp_arena_alloc0 (arena, sizeof (gint64));
+    g_assert_cmpuint (GPOINTER_TO_SIZE (n) % sizeof (gint64), ==, 0);
+    g_assert_cmpint (*n, ==, 0);
+    *n = G_MAXINT64;
+
+    /* Filling the chunk starts a new one */
+    mcp_arena_alloc (arena, 60);
+    mcp_arena_alloc (arena, 60);
+    mcp_arena_alloc (arena, 60);
+    mcp_arena_alloc (arena, 60);
+    g_assert_cmpuint (mcp_arena_get_allocated (arena), ==, 512);
+}
+
+static void
+test_arena_large (void)
+{
+    g_autoptr(McpArena) arena = NULL;
+    gchar *small;
+    gchar *big;
+
+    arena = mcp_arena_new (256);
+    small = mcp_arena_alloc (arena, 16);
+    big = mcp_arena_alloc (arena, 4096);
+    memset (big, 'x', 4096);
+
+    /* The current chunk keeps serving small allocations */
+    g_assert_true (mcp_arena_alloc (arena, 16) == small + 16);
+    g_assert_cmpuint (mcp_arena_get_allocated (arena), ==, 256 + 4096);
+}
+
+static void
+test_arena_reset (void)
+{
+    g_autoptr(McpArena) arena = NULL;
+    guint i;
+
+    arena = mcp_arena_new (256);
+    mcp_arena_alloc (arena, 8);
+
+    for (i = 0; i < 100; i++)
+    {
+        mcp_arena_alloc (arena, 64);
+    }
+    mcp_arena_alloc (arena, 10000);
+    g_assert_cmpuint (mcp_arena_get_allocated (arena), >, 256);
+
+    /* One regular chunk survives and is reused from the start */
+    mcp_arena_reset (arena);
+    g_assert_cmpuint (mcp_arena_get_allocated (arena), ==, 256);
+    g_assert_nonnull (mcp_arena_alloc (arena, 8));
+    g_assert_cmpuint (mcp_arena_get_allocated (arena), ==, 256);
+}
+
+static void
+test_arena_strings (void)
+{
+    g_autoptr(McpArena) arena = NULL;
+
+    arena = mcp_arena_new (0);
+
+    g_assert_null (mcp_arena_strdup (arena, NULL));
+    g_assert_cmpstr (mcp_arena_strdup (arena, "tools/call"), ==, "tools/call");
+    g_assert_cmpstr (mcp_arena_strndup (arena, "resources/read", 9), ==, "resources");
+    g_assert_cmpstr (mcp_arena_strndup (arena, "ab", 10), ==, "ab");
+    g_assert_cmpstr (mcp_arena_strdup_printf (arena, "%" G_GINT64_FORMAT, (gint64) -42),
+                     ==, "-42");
+    g_assert_cmpstr (mcp_arena_strdup_printf (arena, "%s-%u", "task", 7), ==, "task-7");
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/arena/alloc", test_arena_alloc);
+    g_test_add_func ("/mcp/arena/large", test_arena_large);
+    g_test_add_func ("/mcp/arena/reset", test_arena_reset);
+    g_test_add_func ("/mcp/arena/strings", test_arena_strings);
+
+    return g_test_run ();
+}
@@ -58,6 +58,7 @@ test_reset_options_restores_defaults (void)
     mcp_cli_opt_json = TRUE;
     mcp_cli_opt_quiet = TRUE;
     mcp_cli_opt_license = TRUE;
+    mcp_cli_opt_broker = TRUE;
 
     /* Reset */
     mcp_cli_reset_options ();
@@ -67,6 +68,7 @@ test_reset_options_restores_defaults (void)
     g_assert_false (mcp_cli_opt_json);
     g_assert_false (mcp_cli_opt_quiet);
     g_assert_false (mcp_cli_opt_license);
+    g_assert_false (mcp_cli_opt_broker);
 }
 
 /*
@@ -422,6 +424,257 @@ test_parse_prompt_args_zero_args_empty_table (void)
     g_hash_table_unref (table);
 }
 
+/* ========================================================================== */
+/* Sample Argument Tests                                                       */
+/* ========================================================================== */
+
+static JsonNode *
+parse_json (const gchar *json)
+{
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    g_autoptr(GError) error = NULL;
+
+    json_parser_load_from_data (parser, json, -1, &error);
+    g_assert_no_error (error);
+
+    return json_node_copy (json_parser_get_root (parser));
+}
+
+/*
+ * test_sample_arguments_required_only:
+ *
+ * Verify that only required properties get sample values, by type.
+ */
+static void
+test_sample_arguments_required_only (void)
+{
+    g_autoptr(JsonNode) schema = NULL;
+    g_autoptr(JsonObject) args = NULL;
+
+    schema = parse_json ("{\"type\": \"object\", \"properties\": {"
+                         "\"s\": {\"type\": \"string\"},"
+                         "\"i\": {\"type\": \"integer\"},"
+                         "\"b\": {\"type\": \"boolean\"},"
+                         "\"o\": {\"type\": \"string\"}},"
+                         "\"required\": [\"s\", \"i\", \"b\"]}");
+    args = mcp_cli_sample_arguments (schema);
+
+    g_assert_cmpuint (json_object_get_size (args), ==, 3);
+    g_assert_cmpstr (json_object_get_string_member (args, "s"), ==, "sample");
+    g_assert_cmpint (json_object_get_int_member (args, "i"), ==, 1);
+    g_assert_false (json_object_get_boolean_member (args, "b"));
+    g_assert_false (json_object_has_member (args, "o"));
+}
+
+/*
+ * test_sample_arguments_default_and_enum:
+ *
+ * Verify that "default" and "enum" values are preferred.
+ */
+static void
+test_sample_arguments_default_and_enum (void)
+{
+    g_autoptr(JsonNode) schema = NULL;
+    g_autoptr(JsonObject) args = NULL;
+
+    schema = parse_json ("{\"type\": \"object\", \"properties\": {"
+                         "\"unit\": {\"type\": \"string\", \"enum\": [\"c\", \"f\"]},"
+                         "\"count\": {\"type\": \"integer\", \"default\": 5}},"
+                         "\"required\": [\"unit\", \"count\"]}");
+    args = mcp_cli_sample_arguments (schema);
+
+    g_assert_cmpstr (json_object_get_string_member (args, "unit"), ==, "c");
+    g_assert_cmpint (json_object_get_int_member (args, "count"), ==, 5);
+}
+
+/*
+ * test_sample_arguments_null_schema:
+ *
+ * Verify that a missing schema yields an empty object.
+ */
+static void
+test_sample_arguments_null_schema (void)
+{
+    g_autoptr(JsonObject) args = NULL;
+
+    args = mcp_cli_sample_arguments (NULL);
+
+    g_assert_nonnull (args);
+    g_assert_cmpuint (json_object_get_size (args), ==, 0);
+}
+
+/* ========================================================================== */
+/* Resource Output Tests                                                       */
+/* ========================================================================== */
+
+/*
+ * write_contents_to_memory:
+ *
+ * Runs mcp_cli_write_resource_contents() into a memory stream and
+ * returns the bytes written.
+ */
+static GBytes *
+write_contents_to_memory (GList *contents)
+{
+    g_autoptr(GOutputStream) stream = NULL;
+    g_autoptr(GError) error = NULL;
+    gsize written = 0;
+    gboolean ok;
+
+    stream = g_memory_output_stream_new_resizable ();
+    ok = mcp_cli_write_resource_contents (contents, stream, &written, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_true (ok);
+    g_assert_true (g_output_stream_close (stream, NULL, NULL));
+
+    g_assert_cmpuint (written, ==,
+                      g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream)));
+
+    return g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (stream));
+}
+
+/*
+ * test_write_resource_contents_mixed:
+ *
+ * Verify that text is written verbatim and blobs are decoded, in order.
+ */
+static void
+test_write_resource_contents_mixed (void)
+{
+    g_autoptr(GBytes) bytes = NULL;
+    GList *contents = NULL;
+
+    contents = g_list_append (contents,
+        mcp_resource_contents_new_text ("test://a", "hello ", "text/plain"));
+    contents = g_list_append (contents,
+        mcp_resource_contents_new_blob ("test://b", "d29ybGQ=", "application/octet-stream"));
+
+    bytes = write_contents_to_memory (contents);
+
+    g_assert_cmpmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes),
+                     "hello world", 11);
+
+    g_list_free_full (contents, (GDestroyNotify)mcp_resource_contents_unref);
+}
+
+/*
+ * test_write_resource_contents_large_blob:
+ *
+ * Verify that a blob spanning several decode chunks round-trips intact.
+ */
+static void
+test_write_resource_contents_large_blob (void)
+{
+    g_autoptr(GBytes) bytes = NULL;
+    g_autofree guchar *payload = NULL;
+    g_autofree gchar *encoded = NULL;
+    GList *contents = NULL;
+    gsize size = 200 * 1024 + 7;
+    gsize i;
+
+    payload = g_malloc (size);
+    for (i = 0; i < size; i++)
+    {
+        payload[i] = (guchar)(i * 31 + 7);
+    }
+    encoded = g_base64_encode (payload, size);
+
+    contents = g_list_append (contents,
+        mcp_resource_contents_new_blob ("test://big", encoded, NULL));
+
+    bytes = write_contents_to_memory (contents);
+
+    g_assert_cmpmem (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes),
+                     payload, size);
+
+    g_list_free_full (contents, (GDestroyNotify)mcp_resource_contents_unref);
+}
+
+/* ========================================================================== */
+/* Broker Tests                                                                */
+/* ========================================================================== */
+
+/*
+ * test_broker_socket_path_env:
+ *
+ * Verify that MCP_BROKER_SOCKET overrides the default socket path.
+ */
+static void
+test_broker_socket_path_env (void)
+{
+    g_autofree gchar *path = NULL;
+
+    g_setenv ("MCP_BROKER_SOCKET", "/tmp/test-broker.sock", TRUE);
+    path = mcp_cli_broker_socket_path ();
+    g_unsetenv ("MCP_BROKER_SOCKET");
+
+    g_assert_cmpstr (path, ==, "/tmp/test-broker.sock");
+}
+
+/*
+ * test_broker_socket_path_default:
+ *
+ * Verify that the default socket lives in the user runtime directory.
+ */
+static void
+test_broker_socket_path_default (void)
+{
+    g_autofree gchar *path = NULL;
+
+    g_unsetenv ("MCP_BROKER_SOCKET");
+    path = mcp_cli_broker_socket_path ();
+
+    g_assert_true (g_str_has_prefix (path, g_get_user_runtime_dir ()));
+    g_assert_true (g_str_has_suffix (path, "mcp-glib/broker.sock"));
+}
+
+/* ========================================================================== */
+/* Latency Statistics Tests                                                    */
+/* ========================================================================== */
+
+/*
+ * test_latency_percentile_empty:
+ *
+ * Verify that an empty sample array yields 0.0.
+ */
+static void
+test_latency_percentile_empty (void)
+{
+    GArray *samples;
+
+    samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+    g_assert_cmpfloat (mcp_cli_latency_percentile (samples, 50.0), ==, 0.0);
+
+    g_array_unref (samples);
+}
+
+/*
+ * test_latency_percentile_nearest_rank:
+ *
+ * Verify nearest-rank percentiles over unsorted input.
+ */
+static void
+test_latency_percentile_nearest_rank (void)
+{
+    gdouble values[] = { 9.0, 3.0, 7.0, 1.0, 5.0, 10.0, 2.0, 8.0, 4.0, 6.0 };
+    GArray *samples;
+
+    samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    g_array_append_vals (samples, values, G_N_ELEMENTS (values));
+
+    mcp_cli_sort_samples (samples);
+
+    g_assert_cmpfloat (g_array_index (samples, gdouble, 0), ==, 1.0);
+    g_assert_cmpfloat (mcp_cli_latency_percentile (samples, 0.0), ==, 1.0);
+    g_assert_cmpfloat (mcp_cli_latency_percentile (samples, 50.0), ==, 5.0);
+    g_assert_cmpfloat (mcp_cli_latency_percentile (samples, 90.0), ==, 9.0);
+    g_assert_cmpfloat (mcp_cli_latency_percentile (samples, 99.0), ==, 10.0);
+    g_assert_cmpfloat (mcp_cli_latency_percentile (samples, 100.0), ==, 10.0);
+
+    g_array_unref (samples);
+}
+
 /* ========================================================================== */
 /* Main Entry Point                                                            */
 /* ========================================================================== */
@@ -476,5 +729,31 @@ main (int    argc,
     g_test_add_func ("/cli/prompt-args/zero-args-empty-table",
                      test_parse_prompt_args_zero_args_empty_table);
 
+    /* Sample argument tests */
+    g_test_add_func ("/cli/sample-args/required-only",
+                     test_sample_arguments_required_only);
+    g_test_add_func ("/cli/sample-args/default-and-enum",
+                     test_sample_arguments_default_and_enum);
+    g_test_add_func ("/cli/sample-args/null-schema",
+                     test_sample_arguments_null_schema);
+
+    /* Resource output tests */
+    g_test_add_func ("/cli/resource-output/mixed",
+                     test_write_resource_contents_mixed);
+    g_test_add_func ("/cli/resource-output/large-blob",
+                     test_write_resource_contents_large_blob);
+
+    /* Broker tests */
+    g_test_add_func ("/cli/broker/socket-path-env",
+                     test_broker_socket_path_env);
+    g_test_add_func ("/cli/broker/socket-path-default",
+                     test_broker_socket_path_default);
+
+    /* Latency statistics tests */
+    g_test_add_func ("/cli/latency/percentile-empty",
+                     test_latency_percentile_empty);
+    g_test_add_func ("/cli/latency/percentile-nearest-rank",
+                     test_latency_percentile_nearest_rank);
+
     return g_test_run ();
 }
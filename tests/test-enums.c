@@ -218,6 +218,37 @@ test_message_type (void)
     g_type_class_unref (enum_class);
 }
 
+/*
+ * Test McpMessagePriority enum
+ */
+static void
+test_message_priority (void)
+{
+    GType type;
+    GEnumClass *enum_class;
+    GEnumValue *value;
+
+    type = MCP_TYPE_MESSAGE_PRIORITY;
+    g_assert_true (G_TYPE_IS_ENUM (type));
+
+    enum_class = g_type_class_ref (type);
+    g_assert_nonnull (enum_class);
+
+    value = g_enum_get_value (enum_class, MCP_MESSAGE_PRIORITY_HIGH);
+    g_assert_nonnull (value);
+    g_assert_cmpstr (value->value_nick, ==, "high");
+
+    value = g_enum_get_value (enum_class, MCP_MESSAGE_PRIORITY_NORMAL);
+    g_assert_nonnull (value);
+    g_assert_cmpstr (value->value_nick, ==, "normal");
+
+    value = g_enum_get_value (enum_class, MCP_MESSAGE_PRIORITY_LOW);
+    g_assert_nonnull (value);
+    g_assert_cmpstr (value->value_nick, ==, "low");
+
+    g_type_class_unref (enum_class);
+}
+
 /*
  * Test MCP error domain
  */
@@ -245,6 +276,7 @@ test_error_code_is_json_rpc (void)
     g_assert_true (mcp_error_code_is_json_rpc (MCP_ERROR_CONNECTION_CLOSED));
     g_assert_true (mcp_error_code_is_json_rpc (MCP_ERROR_TRANSPORT_ERROR));
     g_assert_true (mcp_error_code_is_json_rpc (MCP_ERROR_TIMEOUT));
+    g_assert_true (mcp_error_code_is_json_rpc (MCP_ERROR_RATE_LIMITED));
     g_assert_true (mcp_error_code_is_json_rpc (MCP_ERROR_URL_ELICITATION_REQUIRED));
 
     /* Library-specific codes should return FALSE */
@@ -273,6 +305,7 @@ test_error_code_conversions (void)
     g_assert_cmpint (mcp_error_code_from_json_rpc_code (-32602), ==, MCP_ERROR_INVALID_PARAMS);
     g_assert_cmpint (mcp_error_code_from_json_rpc_code (-32603), ==, MCP_ERROR_INTERNAL_ERROR);
     g_assert_cmpint (mcp_error_code_from_json_rpc_code (-32000), ==, MCP_ERROR_CONNECTION_CLOSED);
+    g_assert_cmpint (mcp_error_code_from_json_rpc_code (-32003), ==, MCP_ERROR_RATE_LIMITED);
     g_assert_cmpint (mcp_error_code_from_json_rpc_code (-32042), ==, MCP_ERROR_URL_ELICITATION_REQUIRED);
 }
 
@@ -303,6 +336,7 @@ main (int   argc,
 
     /* Message type tests */
     g_test_add_func ("/mcp/enums/message-type/type", test_message_type);
+    g_test_add_func ("/mcp/enums/message-priority/type", test_message_priority);
 
     /* Error domain tests */
     g_test_add_func ("/mcp/error/quark", test_error_quark);
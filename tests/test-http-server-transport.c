@@ -6,6 +6,7 @@
  */
 
 #include <glib.h>
+#include <string.h>
 #include "mcp.h"
 
 /* ============================================================================
@@ -243,6 +244,7 @@ test_http_server_transport_interface (void)
     g_assert_nonnull (iface->disconnect_finish);
     g_assert_nonnull (iface->send_message_async);
     g_assert_nonnull (iface->send_message_finish);
+    g_assert_nonnull (iface->send_raw_with_priority_async);
 }
 
 /* ============================================================================
@@ -523,6 +525,699 @@ test_http_server_transport_state_changed_signal (void)
     g_clear_error (&data.error);
 }
 
+/* ============================================================================
+ * Download Tests
+ * ========================================================================== */
+
+#define DOWNLOAD_DATA "0123456789abcdefghijklmnopqrstuvwxyz"
+
+/* Connects a server transport and publishes DOWNLOAD_DATA */
+static McpHttpServerTransport *
+start_download_server (gchar **base_url,
+                       gchar **url)
+{
+    McpHttpServerTransport *transport;
+    g_autoptr(GMainLoop) loop = NULL;
+    g_autoptr(GBytes) data = NULL;
+    g_autoptr(GError) error = NULL;
+    AsyncTestData async = { 0 };
+
+    transport = mcp_http_server_transport_new_full ("127.0.0.1", 0);
+    loop = g_main_loop_new (NULL, FALSE);
+    async.loop = loop;
+    mcp_transport_connect_async (MCP_TRANSPORT (transport), NULL, on_connect_finished, &async);
+    g_main_loop_run (loop);
+    g_assert_true (async.success);
+
+    data = g_bytes_new_static (DOWNLOAD_DATA, strlen (DOWNLOAD_DATA));
+    *url = mcp_transport_publish_download (MCP_TRANSPORT (transport), data, "text/plain", &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (*url);
+
+    *base_url = g_strdup_printf ("http://127.0.0.1:%u/",
+                                 mcp_http_server_transport_get_actual_port (transport));
+    return transport;
+}
+
+typedef struct
+{
+    GMainLoop *loop;
+    GBytes    *body;
+    GError    *error;
+} DownloadTestData;
+
+static void
+on_fetch_finished (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+    DownloadTestData *data = user_data;
+
+    data->body = soup_session_send_and_read_finish (SOUP_SESSION (source), result, &data->error);
+    g_main_loop_quit (data->loop);
+}
+
+/* GETs @path on @base_url, optionally with a Range header.  The server
+ * runs in this thread, so the request has to be asynchronous. */
+static GBytes *
+fetch (const gchar *base_url,
+       const gchar *path,
+       const gchar *range,
+       guint       *status)
+{
+    g_autoptr(SoupSession) session = NULL;
+    g_autoptr(SoupMessage) msg = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    g_autofree gchar *full_url = NULL;
+    g_autoptr(GError) error = NULL;
+    DownloadTestData data = { 0 };
+
+    full_url = g_uri_resolve_relative (base_url, path, G_URI_FLAGS_NONE, &error);
+    g_assert_no_error (error);
+
+    session = soup_session_new ();
+    msg = soup_message_new ("GET", full_url);
+    if (range != NULL)
+    {
+        soup_message_headers_replace (soup_message_get_request_headers (msg), "Range", range);
+    }
+
+    loop = g_main_loop_new (NULL, FALSE);
+    data.loop = loop;
+    soup_session_send_and_read_async (session, msg, G_PRIORITY_DEFAULT, NULL,
+                                      on_fetch_finished, &data);
+    g_main_loop_run (loop);
+
+    g_assert_no_error (data.error);
+    *status = soup_message_get_status (msg);
+    return data.body;
+}
+
+static void
+test_http_server_transport_download (void)
+{
+    g_autoptr(McpHttpServerTransport) transport = NULL;
+    g_autofree gchar *base_url = NULL;
+    g_autofree gchar *url = NULL;
+    g_autoptr(GBytes) body = NULL;
+    g_autoptr(GBytes) again = NULL;
+    guint status;
+
+    transport = start_download_server (&base_url, &url);
+    g_assert_true (g_str_has_prefix (url, "/"));
+
+    body = fetch (base_url, url, NULL, &status);
+    g_assert_cmpuint (status, ==, SOUP_STATUS_OK);
+    g_assert_cmpmem (g_bytes_get_data (body, NULL), g_bytes_get_size (body),
+                     DOWNLOAD_DATA, strlen (DOWNLOAD_DATA));
+
+    /* The data is let go of once it has been served in full */
+    again = fetch (base_url, url, NULL, &status);
+    g_assert_cmpuint (status, ==, SOUP_STATUS_NOT_FOUND);
+}
+
+static void
+test_http_server_transport_download_range (void)
+{
+    g_autoptr(McpHttpServerTransport) transport = NULL;
+    g_autofree gchar *base_url = NULL;
+    g_autofree gchar *url = NULL;
+    g_autoptr(GBytes) body = NULL;
+    g_autoptr(GBytes) unsatisfiable = NULL;
+    guint status;
+
+    transport = start_download_server (&base_url, &url);
+
+    body = fetch (base_url, url, "bytes=10-15", &status);
+    g_assert_cmpuint (status, ==, SOUP_STATUS_PARTIAL_CONTENT);
+    g_assert_cmpmem (g_bytes_get_data (body, NULL), g_bytes_get_size (body),
+                     "abcdef", 6);
+
+    unsatisfiable = fetch (base_url, url, "bytes=1000-", &status);
+    g_assert_cmpuint (status, ==, SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE);
+}
+
+static void
+test_http_server_transport_download_forged (void)
+{
+    g_autoptr(McpHttpServerTransport) transport = NULL;
+    g_autofree gchar *base_url = NULL;
+    g_autofree gchar *url = NULL;
+    g_autofree gchar *forged = NULL;
+    g_autoptr(GBytes) body = NULL;
+    gchar *expires;
+    guint status;
+
+    transport = start_download_server (&base_url, &url);
+
+    /* Pushing the expiry out invalidates the signature */
+    forged = g_strdup (url);
+    expires = strstr (forged, "expires=") + strlen ("expires=");
+    *expires = *expires == '9' ? '8' : '9';
+
+    body = fetch (base_url, forged, NULL, &status);
+    g_assert_cmpuint (status, ==, SOUP_STATUS_FORBIDDEN);
+}
+
+static void
+test_http_server_transport_download_limit (void)
+{
+    g_autoptr(McpHttpServerTransport) transport = NULL;
+    g_autofree gchar *base_url = NULL;
+    g_autofree gchar *url = NULL;
+    g_autofree gchar *second = NULL;
+    g_autoptr(GBytes) data = NULL;
+    g_autoptr(GBytes) body = NULL;
+    g_autoptr(GError) error = NULL;
+    guint status;
+
+    transport = start_download_server (&base_url, &url);
+    g_assert_cmpuint (mcp_http_server_transport_get_download_limit (transport), ==,
+                      MCP_HTTP_SERVER_TRANSPORT_DEFAULT_DOWNLOAD_LIMIT);
+    mcp_http_server_transport_set_download_limit (transport, strlen (DOWNLOAD_DATA) + 10);
+
+    /* DOWNLOAD_DATA is still held, so another copy does not fit */
+    data = g_bytes_new_static (DOWNLOAD_DATA, strlen (DOWNLOAD_DATA));
+    second = mcp_transport_publish_download (MCP_TRANSPORT (transport), data, "text/plain", &error);
+    g_assert_error (error, MCP_ERROR, MCP_ERROR_TRANSPORT_ERROR);
+    g_assert_null (second);
+    g_clear_error (&error);
+
+    /* Serving the first in full makes room again */
+    body = fetch (base_url, url, NULL, &status);
+    g_assert_cmpuint (status, ==, SOUP_STATUS_OK);
+    second = mcp_transport_publish_download (MCP_TRANSPORT (transport), data, "text/plain", &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (second);
+}
+
+static void
+on_download_finished (GObject      *source,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+    DownloadTestData *data = user_data;
+
+    data->body = mcp_transport_download_finish (MCP_TRANSPORT (source), result, &data->error);
+    g_main_loop_quit (data->loop);
+}
+
+static void
+test_http_server_transport_download_client (void)
+{
+    g_autoptr(McpHttpServerTransport) transport = NULL;
+    g_autoptr(McpHttpTransport) client = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    g_autofree gchar *base_url = NULL;
+    g_autofree gchar *url = NULL;
+    DownloadTestData data = { 0 };
+
+    transport = start_download_server (&base_url, &url);
+
+    /* The client resolves the relative URL against its base URL */
+    client = mcp_http_transport_new (base_url);
+    g_assert_true (mcp_transport_supports_downloads (MCP_TRANSPORT (client)));
+    g_assert_false (mcp_transport_supports_downloads (MCP_TRANSPORT (transport)));
+
+    loop = g_main_loop_new (NULL, FALSE);
+    data.loop = loop;
+    mcp_transport_download_async (MCP_TRANSPORT (client), url, NULL,
+                                  on_download_finished, &data);
+    g_main_loop_run (loop);
+
+    g_assert_no_error (data.error);
+    g_assert_cmpmem (g_bytes_get_data (data.body, NULL), g_bytes_get_size (data.body),
+                     DOWNLOAD_DATA, strlen (DOWNLOAD_DATA));
+    g_bytes_unref (data.body);
+}
+
+/* ============================================================================
+ * SSE Priority Tests
+ * ========================================================================== */
+
+#define SSE_PROGRESS_1 "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\",\"params\":{\"progressToken\":1}}"
+#define SSE_PROGRESS_2 "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\",\"params\":{\"progressToken\":2}}"
+#define SSE_RESPONSE   "{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":{}}"
+
+typedef struct
+{
+    GMainLoop    *loop;
+    GInputStream *stream;
+    GString      *received;
+    GError       *error;
+} SseTestData;
+
+static void
+on_sse_opened (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+    SseTestData *data = user_data;
+
+    data->stream = soup_session_send_finish (SOUP_SESSION (source), result, &data->error);
+    g_main_loop_quit (data->loop);
+}
+
+static void
+on_sse_read (GObject      *source,
+             GAsyncResult *result,
+             gpointer      user_data)
+{
+    SseTestData *data = user_data;
+    g_autoptr(GBytes) chunk = NULL;
+
+    chunk = g_input_stream_read_bytes_finish (G_INPUT_STREAM (source), result, &data->error);
+    if (chunk != NULL && g_bytes_get_size (chunk) > 0)
+    {
+        g_string_append_len (data->received, g_bytes_get_data (chunk, NULL),
+                             g_bytes_get_size (chunk));
+    }
+    g_main_loop_quit (data->loop);
+}
+
+/* A response queued behind progress on the SSE stream goes first */
+static void
+test_http_server_transport_sse_priority (void)
+{
+    g_autoptr(McpHttpServerTransport) transport = NULL;
+    g_autoptr(SoupSession) session = NULL;
+    g_autoptr(SoupMessage) msg = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    g_autoptr(GBytes) progress_1 = NULL;
+    g_autoptr(GBytes) progress_2 = NULL;
+    g_autoptr(GBytes) response = NULL;
+    g_autofree gchar *url = NULL;
+    AsyncTestData async = { 0 };
+    SseTestData data = { 0 };
+    const gchar *response_at;
+    const gchar *progress_2_at;
+    gint64 deadline;
+
+    transport = mcp_http_server_transport_new_full ("127.0.0.1", 0);
+    loop = g_main_loop_new (NULL, FALSE);
+    async.loop = loop;
+    mcp_transport_connect_async (MCP_TRANSPORT (transport), NULL, on_connect_finished, &async);
+    g_main_loop_run (loop);
+    g_assert_true (async.success);
+
+    url = g_strdup_printf ("http://127.0.0.1:%u/sse",
+                           mcp_http_server_transport_get_actual_port (transport));
+    session = soup_session_new ();
+    msg = soup_message_new ("GET", url);
+    soup_message_headers_replace (soup_message_get_request_headers (msg),
+                                  "Accept", "text/event-stream");
+
+    data.loop = loop;
+    data.received = g_string_new (NULL);
+    soup_session_send_async (session, msg, G_PRIORITY_DEFAULT, NULL, on_sse_opened, &data);
+    g_main_loop_run (loop);
+    g_assert_no_error (data.error);
+    g_assert_true (mcp_http_server_transport_has_client (transport));
+
+    /* Queued back to back: at most the first goes out before the
+     * response is queued */
+    progress_1 = g_bytes_new_static (SSE_PROGRESS_1, strlen (SSE_PROGRESS_1));
+    progress_2 = g_bytes_new_static (SSE_PROGRESS_2, strlen (SSE_PROGRESS_2));
+    response = g_bytes_new_static (SSE_RESPONSE, strlen (SSE_RESPONSE));
+    mcp_transport_send_raw_async (MCP_TRANSPORT (transport), progress_1, NULL, NULL, NULL);
+    mcp_transport_send_raw_async (MCP_TRANSPORT (transport), progress_2, NULL, NULL, NULL);
+    mcp_transport_send_raw_async (MCP_TRANSPORT (transport), response, NULL, NULL, NULL);
+
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    while (strstr (data.received->str, SSE_PROGRESS_2) == NULL ||
+           strstr (data.received->str, SSE_RESPONSE) == NULL)
+    {
+        g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+        g_input_stream_read_bytes_async (data.stream, 4096, G_PRIORITY_DEFAULT, NULL,
+                                         on_sse_read, &data);
+        g_main_loop_run (loop);
+        g_assert_no_error (data.error);
+    }
+
+    response_at = strstr (data.received->str, SSE_RESPONSE);
+    progress_2_at = strstr (data.received->str, SSE_PROGRESS_2);
+    g_assert_true (response_at < progress_2_at);
+
+    g_object_unref (data.stream);
+    g_string_free (data.received, TRUE);
+    soup_session_abort (session);
+}
+
+/* ============================================================================
+ * Sharding Tests
+ * ========================================================================== */
+
+#define SHARD_MESSAGE "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}"
+
+/* Connects a reuse-port transport on 127.0.0.1:@port */
+static McpHttpServerTransport *
+start_shard (guint port)
+{
+    McpHttpServerTransport *transport;
+    g_autoptr(GMainLoop) loop = NULL;
+    AsyncTestData async = { 0 };
+
+    transport = mcp_http_server_transport_new_full ("127.0.0.1", port);
+    mcp_http_server_transport_set_reuse_port (transport, TRUE);
+
+    loop = g_main_loop_new (NULL, FALSE);
+    async.loop = loop;
+    mcp_transport_connect_async (MCP_TRANSPORT (transport), NULL, on_connect_finished, &async);
+    g_main_loop_run (loop);
+    g_assert_no_error (async.error);
+    g_assert_true (async.success);
+
+    return transport;
+}
+
+static void
+on_shard_message (McpTransport *transport,
+                  JsonNode     *message,
+                  gpointer      user_data)
+{
+    guint *count = user_data;
+    (*count)++;
+}
+
+/* Sends @method to 127.0.0.1:@port and returns the status; a POST
+ * carries SHARD_MESSAGE.  @session_id, if given, is sent as
+ * Mcp-Session-Id; the response's Mcp-Session-Id is stored in
+ * @out_session_id. */
+static guint
+send_to_shard (const gchar  *method,
+               guint         port,
+               const gchar  *session_id,
+               gboolean      forwarded,
+               gchar       **out_session_id)
+{
+    g_autoptr(SoupSession) session = NULL;
+    g_autoptr(SoupMessage) msg = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    g_autoptr(GBytes) request = NULL;
+    g_autofree gchar *url = NULL;
+    DownloadTestData data = { 0 };
+
+    url = g_strdup_printf ("http://127.0.0.1:%u/", port);
+    session = soup_session_new ();
+    msg = soup_message_new (method, url);
+    if (g_strcmp0 (method, "POST") == 0)
+    {
+        request = g_bytes_new_static (SHARD_MESSAGE, strlen (SHARD_MESSAGE));
+        soup_message_set_request_body_from_bytes (msg, "application/json", request);
+    }
+    if (session_id != NULL)
+    {
+        soup_message_headers_replace (soup_message_get_request_headers (msg),
+                                      "Mcp-Session-Id", session_id);
+    }
+    if (forwarded)
+    {
+        soup_message_headers_replace (soup_message_get_request_headers (msg),
+                                      "Mcp-Shard-Forwarded", "1");
+    }
+
+    loop = g_main_loop_new (NULL, FALSE);
+    data.loop = loop;
+    soup_session_send_and_read_async (session, msg, G_PRIORITY_DEFAULT, NULL,
+                                      on_fetch_finished, &data);
+    g_main_loop_run (loop);
+    g_assert_no_error (data.error);
+    g_clear_pointer (&data.body, g_bytes_unref);
+
+    if (out_session_id != NULL)
+    {
+        *out_session_id = g_strdup (soup_message_headers_get_one (
+            soup_message_get_response_headers (msg), "Mcp-Session-Id"));
+    }
+
+    return soup_message_get_status (msg);
+}
+
+static guint
+post_to_shard (guint         port,
+               const gchar  *session_id,
+               gboolean      forwarded,
+               gchar       **out_session_id)
+{
+    return send_to_shard ("POST", port, session_id, forwarded, out_session_id);
+}
+
+/* Two shards share one port, each with its own loopback shard port */
+static void
+test_http_server_transport_shard_listen (void)
+{
+    g_autoptr(McpHttpServerTransport) a = NULL;
+    g_autoptr(McpHttpServerTransport) b = NULL;
+    guint port;
+
+    a = start_shard (0);
+    port = mcp_http_server_transport_get_actual_port (a);
+    g_assert_cmpuint (port, >, 0);
+
+    b = start_shard (port);
+    g_assert_cmpuint (mcp_http_server_transport_get_actual_port (b), ==, port);
+
+    g_assert_true (mcp_http_server_transport_get_reuse_port (a));
+    g_assert_cmpuint (mcp_http_server_transport_get_shard_port (a), >, 0);
+    g_assert_cmpuint (mcp_http_server_transport_get_shard_port (b), >, 0);
+    g_assert_cmpuint (mcp_http_server_transport_get_shard_port (a), !=,
+                      mcp_http_server_transport_get_shard_port (b));
+}
+
+/* A POST reaching the wrong shard is forwarded to the session's owner */
+static void
+test_http_server_transport_shard_affinity (void)
+{
+    g_autoptr(McpHttpServerTransport) a = NULL;
+    g_autoptr(McpHttpServerTransport) b = NULL;
+    g_autofree gchar *session_id = NULL;
+    g_autofree gchar *relayed_id = NULL;
+    g_autofree gchar *suffix = NULL;
+    guint a_port;
+    guint b_port;
+    guint a_count = 0;
+    guint b_count = 0;
+
+    a = start_shard (0);
+    b = start_shard (mcp_http_server_transport_get_actual_port (a));
+    a_port = mcp_http_server_transport_get_shard_port (a);
+    b_port = mcp_http_server_transport_get_shard_port (b);
+    g_signal_connect (a, "message-received", G_CALLBACK (on_shard_message), &a_count);
+    g_signal_connect (b, "message-received", G_CALLBACK (on_shard_message), &b_count);
+
+    /* The session id names the shard that issued it */
+    g_assert_cmpuint (post_to_shard (a_port, NULL, FALSE, &session_id), ==,
+                      SOUP_STATUS_ACCEPTED);
+    suffix = g_strdup_printf (".%u", a_port);
+    g_assert_nonnull (session_id);
+    g_assert_true (g_str_has_suffix (session_id, suffix));
+    g_assert_cmpuint (a_count, ==, 1);
+
+    /* Sent to B, handled by A */
+    g_assert_cmpuint (post_to_shard (b_port, session_id, FALSE, &relayed_id), ==,
+                      SOUP_STATUS_ACCEPTED);
+    g_assert_cmpstr (relayed_id, ==, session_id);
+    g_assert_cmpuint (a_count, ==, 2);
+    g_assert_cmpuint (b_count, ==, 0);
+
+    /* Already forwarded once: B handles it rather than loop */
+    g_assert_cmpuint (post_to_shard (b_port, session_id, TRUE, NULL), ==,
+                      SOUP_STATUS_ACCEPTED);
+    g_assert_cmpuint (a_count, ==, 2);
+    g_assert_cmpuint (b_count, ==, 1);
+}
+
+/* Session ids that no shard signed are not relayed anywhere, and the
+ * forwarded header means nothing on the shared port */
+static void
+test_http_server_transport_shard_forged (void)
+{
+    g_autoptr(McpHttpServerTransport) a = NULL;
+    g_autoptr(McpHttpServerTransport) b = NULL;
+    g_autofree gchar *session_id = NULL;
+    g_autofree gchar *forged = NULL;
+    g_autofree gchar *unsigned_id = NULL;
+    const gchar *port_dot;
+    guint a_port;
+    guint b_port;
+    guint public_port;
+    guint a_count = 0;
+    guint b_count = 0;
+
+    a = start_shard (0);
+    public_port = mcp_http_server_transport_get_actual_port (a);
+    b = start_shard (public_port);
+    a_port = mcp_http_server_transport_get_shard_port (a);
+    b_port = mcp_http_server_transport_get_shard_port (b);
+    g_signal_connect (a, "message-received", G_CALLBACK (on_shard_message), &a_count);
+    g_signal_connect (b, "message-received", G_CALLBACK (on_shard_message), &b_count);
+
+    g_assert_cmpuint (post_to_shard (a_port, NULL, FALSE, &session_id), ==,
+                      SOUP_STATUS_ACCEPTED);
+    g_assert_nonnull (session_id);
+    g_assert_cmpuint (a_count, ==, 1);
+
+    /* A's signature with B's port swapped in */
+    port_dot = strrchr (session_id, '.');
+    g_assert_nonnull (port_dot);
+    forged = g_strdup_printf ("%.*s.%u", (gint) (port_dot - session_id), session_id, b_port);
+    g_assert_cmpuint (post_to_shard (b_port, forged, FALSE, NULL), ==,
+                      SOUP_STATUS_NOT_FOUND);
+
+    /* An unsigned id naming a port outside the group */
+    unsigned_id = g_strdup_printf ("%s.%u", "00000000-0000-4000-8000-000000000000", 1);
+    g_assert_cmpuint (post_to_shard (public_port, unsigned_id, FALSE, NULL), ==,
+                      SOUP_STATUS_NOT_FOUND);
+    g_assert_cmpuint (post_to_shard (b_port, unsigned_id, TRUE, NULL), ==,
+                      SOUP_STATUS_NOT_FOUND);
+    g_assert_cmpuint (a_count, ==, 1);
+    g_assert_cmpuint (b_count, ==, 0);
+
+    /* Claiming to be forwarded on the shared port does not stop
+     * whichever shard accepts it from relaying to the owner */
+    g_assert_cmpuint (post_to_shard (public_port, session_id, TRUE, NULL), ==,
+                      SOUP_STATUS_ACCEPTED);
+    g_assert_cmpuint (a_count, ==, 2);
+    g_assert_cmpuint (b_count, ==, 0);
+}
+
+/* A new client landing on a busy shard is handed to a free one, and
+ * turned away once every shard is busy */
+static void
+test_http_server_transport_shard_new_session (void)
+{
+    g_autoptr(McpHttpServerTransport) a = NULL;
+    g_autoptr(McpHttpServerTransport) b = NULL;
+    g_autofree gchar *first = NULL;
+    g_autofree gchar *second = NULL;
+    g_autofree gchar *a_suffix = NULL;
+    g_autofree gchar *b_suffix = NULL;
+    guint a_port;
+    guint b_port;
+    guint a_count = 0;
+    guint b_count = 0;
+
+    a = start_shard (0);
+    b = start_shard (mcp_http_server_transport_get_actual_port (a));
+    a_port = mcp_http_server_transport_get_shard_port (a);
+    b_port = mcp_http_server_transport_get_shard_port (b);
+    g_signal_connect (a, "message-received", G_CALLBACK (on_shard_message), &a_count);
+    g_signal_connect (b, "message-received", G_CALLBACK (on_shard_message), &b_count);
+
+    g_assert_cmpuint (post_to_shard (a_port, NULL, FALSE, &first), ==,
+                      SOUP_STATUS_ACCEPTED);
+    a_suffix = g_strdup_printf (".%u", a_port);
+    g_assert_true (g_str_has_suffix (first, a_suffix));
+
+    /* A is busy, so B opens the second session */
+    g_assert_cmpuint (post_to_shard (a_port, NULL, FALSE, &second), ==,
+                      SOUP_STATUS_ACCEPTED);
+    b_suffix = g_strdup_printf (".%u", b_port);
+    g_assert_nonnull (second);
+    g_assert_true (g_str_has_suffix (second, b_suffix));
+    g_assert_cmpstr (mcp_http_server_transport_get_session_id (a), ==, first);
+    g_assert_cmpuint (a_count, ==, 1);
+    g_assert_cmpuint (b_count, ==, 1);
+
+    /* Both busy */
+    g_assert_cmpuint (post_to_shard (a_port, NULL, FALSE, NULL), ==,
+                      SOUP_STATUS_SERVICE_UNAVAILABLE);
+    g_assert_cmpuint (post_to_shard (b_port, NULL, TRUE, NULL), ==,
+                      SOUP_STATUS_SERVICE_UNAVAILABLE);
+    g_assert_cmpuint (a_count, ==, 1);
+    g_assert_cmpuint (b_count, ==, 1);
+}
+
+/* A DELETE reaching the wrong shard ends the session on its owner */
+static void
+test_http_server_transport_shard_delete (void)
+{
+    g_autoptr(McpHttpServerTransport) a = NULL;
+    g_autoptr(McpHttpServerTransport) b = NULL;
+    g_autofree gchar *session_id = NULL;
+    guint a_port;
+    guint b_port;
+
+    a = start_shard (0);
+    b = start_shard (mcp_http_server_transport_get_actual_port (a));
+    a_port = mcp_http_server_transport_get_shard_port (a);
+    b_port = mcp_http_server_transport_get_shard_port (b);
+
+    g_assert_cmpuint (post_to_shard (a_port, NULL, FALSE, &session_id), ==,
+                      SOUP_STATUS_ACCEPTED);
+    g_assert_nonnull (mcp_http_server_transport_get_session_id (a));
+
+    g_assert_cmpuint (send_to_shard ("DELETE", b_port, session_id, FALSE, NULL), ==,
+                      SOUP_STATUS_NO_CONTENT);
+    g_assert_null (mcp_http_server_transport_get_session_id (a));
+    g_assert_cmpuint (send_to_shard ("DELETE", b_port, session_id, FALSE, NULL), ==,
+                      SOUP_STATUS_NOT_FOUND);
+    g_assert_cmpuint (send_to_shard ("DELETE", b_port, NULL, FALSE, NULL), ==,
+                      SOUP_STATUS_BAD_REQUEST);
+}
+
+static void
+on_stream_sent (GObject      *source,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+    DownloadTestData *data = user_data;
+    g_autoptr(GInputStream) stream = NULL;
+
+    stream = soup_session_send_finish (SOUP_SESSION (source), result, &data->error);
+    g_main_loop_quit (data->loop);
+}
+
+/* An SSE stream opened on the wrong shard is relayed from its owner */
+static void
+test_http_server_transport_shard_sse (void)
+{
+    g_autoptr(McpHttpServerTransport) a = NULL;
+    g_autoptr(McpHttpServerTransport) b = NULL;
+    g_autoptr(SoupSession) session = NULL;
+    g_autoptr(SoupMessage) msg = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    g_autofree gchar *session_id = NULL;
+    g_autofree gchar *url = NULL;
+    DownloadTestData data = { 0 };
+    guint a_port;
+    guint b_port;
+
+    a = start_shard (0);
+    b = start_shard (mcp_http_server_transport_get_actual_port (a));
+    a_port = mcp_http_server_transport_get_shard_port (a);
+    b_port = mcp_http_server_transport_get_shard_port (b);
+
+    g_assert_cmpuint (post_to_shard (a_port, NULL, FALSE, &session_id), ==,
+                      SOUP_STATUS_ACCEPTED);
+
+    url = g_strdup_printf ("http://127.0.0.1:%u/sse", b_port);
+    session = soup_session_new ();
+    msg = soup_message_new ("GET", url);
+    soup_message_headers_replace (soup_message_get_request_headers (msg),
+                                  "Accept", "text/event-stream");
+    soup_message_headers_replace (soup_message_get_request_headers (msg),
+                                  "Mcp-Session-Id", session_id);
+
+    loop = g_main_loop_new (NULL, FALSE);
+    data.loop = loop;
+    soup_session_send_async (session, msg, G_PRIORITY_DEFAULT, NULL,
+                             on_stream_sent, &data);
+    g_main_loop_run (loop);
+
+    g_assert_no_error (data.error);
+    g_assert_cmpuint (soup_message_get_status (msg), ==, SOUP_STATUS_OK);
+    g_assert_cmpstr (soup_message_headers_get_one (soup_message_get_response_headers (msg),
+                                                   "Mcp-Session-Id"), ==, session_id);
+
+    /* A holds the stream and kept the session's id */
+    g_assert_true (mcp_http_server_transport_has_client (a));
+    g_assert_false (mcp_http_server_transport_has_client (b));
+    g_assert_cmpstr (mcp_http_server_transport_get_session_id (a), ==, session_id);
+
+    soup_session_abort (session);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -589,5 +1284,33 @@ main (int   argc,
     g_test_add_func ("/mcp/http-server-transport/signals/state-changed",
                      test_http_server_transport_state_changed_signal);
 
+    /* Download tests */
+    g_test_add_func ("/mcp/http-server-transport/download/basic",
+                     test_http_server_transport_download);
+    g_test_add_func ("/mcp/http-server-transport/download/range",
+                     test_http_server_transport_download_range);
+    g_test_add_func ("/mcp/http-server-transport/download/forged",
+                     test_http_server_transport_download_forged);
+    g_test_add_func ("/mcp/http-server-transport/download/limit",
+                     test_http_server_transport_download_limit);
+    g_test_add_func ("/mcp/http-server-transport/download/client",
+                     test_http_server_transport_download_client);
+
+    /* Sharding tests */
+    g_test_add_func ("/mcp/http-server-transport/sse/priority",
+                     test_http_server_transport_sse_priority);
+    g_test_add_func ("/mcp/http-server-transport/shard/listen",
+                     test_http_server_transport_shard_listen);
+    g_test_add_func ("/mcp/http-server-transport/shard/affinity",
+                     test_http_server_transport_shard_affinity);
+    g_test_add_func ("/mcp/http-server-transport/shard/forged",
+                     test_http_server_transport_shard_forged);
+    g_test_add_func ("/mcp/http-server-transport/shard/new-session",
+                     test_http_server_transport_shard_new_session);
+    g_test_add_func ("/mcp/http-server-transport/shard/delete",
+                     test_http_server_transport_shard_delete);
+    g_test_add_func ("/mcp/http-server-transport/shard/sse",
+                     test_http_server_transport_shard_sse);
+
     return g_test_run ();
 }
@@ -0,0 +1,426 @@
+/*
+ * test-in-process-transport.c - Unit tests for McpInProcessTransport
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <glib.h>
+#include "mcp.h"
+
+/* ── shared test plumbing ──────────────────────────────────────────── */
+
+typedef struct
+{
+    GQueue *received;   /* JsonNode* (owned) */
+    GQueue *states;     /* new state          */
+} Capture;
+
+static void
+on_message_received (McpTransport *transport,
+                     JsonNode     *message,
+                     gpointer      user_data)
+{
+    Capture *cap = user_data;
+
+    g_queue_push_tail (cap->received, json_node_ref (message));
+}
+
+static void
+on_state_changed (McpTransport      *transport,
+                  McpTransportState  old_state,
+                  McpTransportState  new_state,
+                  gpointer           user_data)
+{
+    Capture *cap = user_data;
+
+    g_queue_push_tail (cap->states, GINT_TO_POINTER (new_state));
+}
+
+static void
+capture_init (Capture               *cap,
+              McpInProcessTransport *t)
+{
+    cap->received = g_queue_new ();
+    cap->states = g_queue_new ();
+    g_signal_connect (t, "message-received", G_CALLBACK (on_message_received), cap);
+    g_signal_connect (t, "state-changed", G_CALLBACK (on_state_changed), cap);
+}
+
+static void
+capture_clear (Capture *cap)
+{
+    g_queue_free_full (cap->received, (GDestroyNotify) json_node_unref);
+    g_queue_free (cap->states);
+}
+
+static JsonNode *
+make_message (gint seq)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "seq");
+    json_builder_add_int_value (builder, seq);
+    json_builder_end_object (builder);
+
+    return json_builder_get_root (builder);
+}
+
+static gint
+message_seq (JsonNode *node)
+{
+    return (gint) json_object_get_int_member (json_node_get_object (node), "seq");
+}
+
+static void
+pump_until_count (GMainContext *context,
+                  GQueue       *queue,
+                  guint         count)
+{
+    gint64 deadline = g_get_monotonic_time () + 3 * G_USEC_PER_SEC;
+
+    while (g_queue_get_length (queue) < count &&
+           g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (context, FALSE);
+    }
+}
+
+static void
+connect_now (McpInProcessTransport *t)
+{
+    mcp_transport_connect_async (MCP_TRANSPORT (t), NULL, NULL, NULL);
+    g_assert_cmpint (mcp_transport_get_state (MCP_TRANSPORT (t)), ==,
+                     MCP_TRANSPORT_STATE_CONNECTED);
+}
+
+/* ── tests ─────────────────────────────────────────────────────────── */
+
+static void
+test_in_process_pair (void)
+{
+    g_autoptr(McpInProcessTransport) a = NULL;
+    g_autoptr(McpInProcessTransport) b = NULL;
+    g_autoptr(McpInProcessTransport) peer = NULL;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &a, &b);
+
+    g_assert_true (MCP_IS_TRANSPORT (a));
+    g_assert_cmpint (mcp_transport_get_state (MCP_TRANSPORT (a)), ==,
+                     MCP_TRANSPORT_STATE_DISCONNECTED);
+    g_assert_true (mcp_in_process_transport_get_context (a) ==
+                   g_main_context_default ());
+
+    peer = mcp_in_process_transport_get_peer (a);
+    g_assert_true (peer == b);
+}
+
+static void
+test_in_process_ordered_and_sealed (void)
+{
+    g_autoptr(McpInProcessTransport) a = NULL;
+    g_autoptr(McpInProcessTransport) b = NULL;
+    g_autoptr(JsonNode) first = NULL;
+    Capture cap;
+    gint i;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &a, &b);
+    capture_init (&cap, b);
+    connect_now (a);
+    connect_now (b);
+
+    for (i = 0; i < 5; i++)
+    {
+        g_autoptr(JsonNode) msg = make_message (i);
+
+        mcp_transport_send_message_async (MCP_TRANSPORT (a), msg, NULL, NULL, NULL);
+        if (i == 0)
+        {
+            first = json_node_ref (msg);
+        }
+    }
+
+    pump_until_count (NULL, cap.received, 5);
+    g_assert_cmpuint (g_queue_get_length (cap.received), ==, 5);
+
+    for (i = 0; i < 5; i++)
+    {
+        JsonNode *node = g_queue_peek_nth (cap.received, i);
+
+        g_assert_cmpint (message_seq (node), ==, i);
+        g_assert_true (json_node_is_immutable (node));
+    }
+
+    /* The sender's tree was copied, not sealed in place */
+    g_assert_false (json_node_is_immutable (first));
+    json_object_set_int_member (json_node_get_object (first), "seq", 42);
+    g_assert_cmpint (message_seq (g_queue_peek_head (cap.received)), ==, 0);
+
+    capture_clear (&cap);
+}
+
+static void
+test_in_process_send_raw (void)
+{
+    g_autoptr(McpInProcessTransport) a = NULL;
+    g_autoptr(McpInProcessTransport) b = NULL;
+    g_autoptr(GBytes) bytes = NULL;
+    Capture cap;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &a, &b);
+    capture_init (&cap, b);
+    connect_now (a);
+    connect_now (b);
+
+    bytes = g_bytes_new_static ("{\"seq\":7}", 9);
+    mcp_transport_send_raw_async (MCP_TRANSPORT (a), bytes, NULL, NULL, NULL);
+
+    pump_until_count (NULL, cap.received, 1);
+    g_assert_cmpuint (g_queue_get_length (cap.received), ==, 1);
+    g_assert_cmpint (message_seq (g_queue_peek_head (cap.received)), ==, 7);
+
+    capture_clear (&cap);
+}
+
+static void
+test_in_process_queued_until_connected (void)
+{
+    g_autoptr(McpInProcessTransport) a = NULL;
+    g_autoptr(McpInProcessTransport) b = NULL;
+    g_autoptr(JsonNode) msg = make_message (1);
+    Capture cap;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &a, &b);
+    capture_init (&cap, b);
+    connect_now (a);
+
+    mcp_transport_send_message_async (MCP_TRANSPORT (a), msg, NULL, NULL, NULL);
+    while (g_main_context_iteration (NULL, FALSE))
+        ;
+    g_assert_cmpuint (g_queue_get_length (cap.received), ==, 0);
+
+    connect_now (b);
+    pump_until_count (NULL, cap.received, 1);
+    g_assert_cmpuint (g_queue_get_length (cap.received), ==, 1);
+
+    capture_clear (&cap);
+}
+
+static void
+send_done_cb (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    GError **error = user_data;
+
+    mcp_transport_send_message_finish (MCP_TRANSPORT (source), result, error);
+}
+
+static void
+test_in_process_disconnect (void)
+{
+    g_autoptr(McpInProcessTransport) a = NULL;
+    g_autoptr(McpInProcessTransport) b = NULL;
+    g_autoptr(JsonNode) msg = make_message (1);
+    Capture cap;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &a, &b);
+    connect_now (a);
+    connect_now (b);
+    capture_init (&cap, b);
+
+    /* Sent before the disconnect, so delivered before the close */
+    mcp_transport_send_message_async (MCP_TRANSPORT (a), msg, NULL, NULL, NULL);
+    mcp_transport_disconnect_async (MCP_TRANSPORT (a), NULL, NULL, NULL);
+
+    pump_until_count (NULL, cap.states, 1);
+    g_assert_cmpuint (g_queue_get_length (cap.received), ==, 1);
+    g_assert_cmpint (GPOINTER_TO_INT (g_queue_peek_head (cap.states)), ==,
+                     MCP_TRANSPORT_STATE_DISCONNECTED);
+
+    /* The close arrived after the message */
+    g_assert_cmpint (mcp_transport_get_state (MCP_TRANSPORT (b)), ==,
+                     MCP_TRANSPORT_STATE_DISCONNECTED);
+
+    capture_clear (&cap);
+}
+
+static void
+test_in_process_peer_gone (void)
+{
+    g_autoptr(McpInProcessTransport) a = NULL;
+    g_autoptr(McpInProcessTransport) b = NULL;
+    g_autoptr(JsonNode) msg = make_message (1);
+    g_autoptr(GError) error = NULL;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &a, &b);
+    connect_now (a);
+    connect_now (b);
+
+    g_clear_object (&a);
+
+    mcp_transport_send_message_async (MCP_TRANSPORT (b), msg, NULL,
+                                      send_done_cb, &error);
+    while (error == NULL && g_main_context_iteration (NULL, TRUE))
+        ;
+    g_assert_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED);
+}
+
+typedef struct
+{
+    McpInProcessTransport *transport;
+    gint                   count;
+} SenderArgs;
+
+static gpointer
+sender_thread (gpointer data)
+{
+    SenderArgs *args = data;
+    gint i;
+
+    for (i = 0; i < args->count; i++)
+    {
+        g_autoptr(JsonNode) msg = make_message (i);
+
+        mcp_transport_send_message_async (MCP_TRANSPORT (args->transport), msg,
+                                          NULL, NULL, NULL);
+    }
+
+    return NULL;
+}
+
+static void
+test_in_process_cross_thread (void)
+{
+    g_autoptr(GMainContext) context = g_main_context_new ();
+    g_autoptr(McpInProcessTransport) a = NULL;
+    g_autoptr(McpInProcessTransport) b = NULL;
+    SenderArgs args;
+    GThread *thread;
+    Capture cap;
+    gint i;
+
+    mcp_in_process_transport_new_pair (NULL, context, &a, &b);
+    capture_init (&cap, b);
+    connect_now (a);
+    connect_now (b);
+
+    args.transport = a;
+    args.count = 200;
+    thread = g_thread_new ("sender", sender_thread, &args);
+
+    pump_until_count (context, cap.received, 200);
+    g_thread_join (thread);
+
+    g_assert_cmpuint (g_queue_get_length (cap.received), ==, 200);
+    for (i = 0; i < 200; i++)
+    {
+        g_assert_cmpint (message_seq (g_queue_peek_nth (cap.received, i)), ==, i);
+    }
+
+    capture_clear (&cap);
+}
+
+/* ── McpClient/McpServer over a pair ───────────────────────────────── */
+
+static McpToolResult *
+echo_tool_handler (McpServer   *server,
+                   const gchar *name,
+                   JsonObject  *arguments,
+                   gpointer     user_data)
+{
+    McpToolResult *result;
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, json_object_get_string_member (arguments, "text"));
+    return result;
+}
+
+typedef struct
+{
+    GMainLoop     *loop;
+    McpToolResult *result;
+    GError        *error;
+} CallCtx;
+
+static void
+on_call_done (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    CallCtx *cc = user_data;
+
+    cc->result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &cc->error);
+    g_main_loop_quit (cc->loop);
+}
+
+static void
+test_in_process_client_server (void)
+{
+    g_autoptr(McpInProcessTransport) client_t = NULL;
+    g_autoptr(McpInProcessTransport) server_t = NULL;
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autoptr(McpTool) echo = NULL;
+    g_autoptr(JsonObject) args = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    CallCtx cc = { NULL, NULL, NULL };
+    gint64 deadline;
+    JsonNode *content;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &client_t, &server_t);
+
+    server = mcp_server_new ("test-server", "1.0");
+    echo = mcp_tool_new ("echo", "Echo the text argument");
+    mcp_server_add_tool (server, echo, echo_tool_handler, NULL, NULL);
+    mcp_server_set_transport (server, MCP_TRANSPORT (server_t));
+    mcp_server_start_async (server, NULL, NULL, NULL);
+
+    client = mcp_client_new ("test-client", "1.0");
+    mcp_client_set_transport (client, MCP_TRANSPORT (client_t));
+    mcp_client_connect_async (client, NULL, NULL, NULL);
+
+    deadline = g_get_monotonic_time () + 3 * G_USEC_PER_SEC;
+    while (mcp_session_get_state (MCP_SESSION (client)) != MCP_SESSION_STATE_READY &&
+           g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (mcp_session_get_state (MCP_SESSION (client)), ==,
+                     MCP_SESSION_STATE_READY);
+
+    args = json_object_new ();
+    json_object_set_string_member (args, "text", "in-process");
+
+    loop = g_main_loop_new (NULL, FALSE);
+    cc.loop = loop;
+    mcp_client_call_tool_async (client, "echo", args, NULL, on_call_done, &cc);
+    g_main_loop_run (loop);
+
+    g_assert_no_error (cc.error);
+    g_assert_nonnull (cc.result);
+    content = json_array_get_element (mcp_tool_result_get_content (cc.result), 0);
+    g_assert_cmpstr (json_object_get_string_member (json_node_get_object (content), "text"),
+                     ==, "in-process");
+    mcp_tool_result_unref (cc.result);
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/in-process/pair", test_in_process_pair);
+    g_test_add_func ("/mcp/in-process/ordered-and-sealed",
+                     test_in_process_ordered_and_sealed);
+    g_test_add_func ("/mcp/in-process/send-raw", test_in_process_send_raw);
+    g_test_add_func ("/mcp/in-process/queued-until-connected",
+                     test_in_process_queued_until_connected);
+    g_test_add_func ("/mcp/in-process/disconnect", test_in_process_disconnect);
+    g_test_add_func ("/mcp/in-process/peer-gone", test_in_process_peer_gone);
+    g_test_add_func ("/mcp/in-process/cross-thread", test_in_process_cross_thread);
+    g_test_add_func ("/mcp/in-process/client-server", test_in_process_client_server);
+
+    return g_test_run ();
+}
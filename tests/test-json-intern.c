@@ -0,0 +1,210 @@
+/*
+ * test-json-intern.c - Unit tests for mcp_json_intern()
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <glib.h>
+#include "mcp.h"
+
+static JsonNode *
+parse (const gchar *json)
+{
+    g_autoptr(GError) error = NULL;
+    JsonNode *node;
+
+    node = mcp_json_parse (json, -1, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (node);
+
+    return node;
+}
+
+static void
+test_json_intern_shared (void)
+{
+    g_autoptr(JsonNode) a = parse ("{\"type\":\"object\",\"properties\":"
+                                   "{\"path\":{\"type\":\"string\"}}}");
+    g_autoptr(JsonNode) b = parse ("{\"type\":\"object\",\"properties\":"
+                                   "{\"path\":{\"type\":\"string\"}}}");
+    JsonNode *first;
+    JsonNode *second;
+    JsonNode *again;
+    guint count;
+
+    count = mcp_json_intern_get_count ();
+
+    first = mcp_json_intern (a);
+    g_assert_true (first != a);
+    g_assert_true (json_node_is_immutable (first));
+    g_assert_false (json_node_is_immutable (a));
+    g_assert_true (json_node_equal (first, a));
+    /* The schema, "properties" and "path" */
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count + 3);
+
+    second = mcp_json_intern (b);
+    g_assert_true (second == first);
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count + 3);
+
+    /* Interning the shared instance again only takes a reference */
+    again = mcp_json_intern (first);
+    g_assert_true (again == first);
+
+    mcp_json_intern_release (again);
+    mcp_json_intern_release (second);
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count + 3);
+    mcp_json_intern_release (first);
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count);
+}
+
+static void
+test_json_intern_sub_schemas (void)
+{
+    g_autoptr(JsonNode) a = parse ("{\"type\":\"object\",\"properties\":"
+                                   "{\"cursor\":{\"type\":\"string\"},"
+                                   "\"query\":{\"type\":\"string\"}}}");
+    g_autoptr(JsonNode) b = parse ("{\"type\":\"object\",\"properties\":"
+                                   "{\"cursor\":{\"type\":\"string\"},"
+                                   "\"limit\":{\"type\":\"integer\"}}}");
+    JsonNode *first;
+    JsonNode *second;
+    JsonObject *props_a;
+    JsonObject *props_b;
+    guint count;
+
+    count = mcp_json_intern_get_count ();
+
+    first = mcp_json_intern (a);
+    second = mcp_json_intern (b);
+    g_assert_true (first != second);
+
+    /* "cursor" and "query" are the same {"type":"string"}, which the
+     * second schema shares; it adds its own object, "properties" and
+     * "limit" */
+    props_a = json_object_get_object_member (json_node_get_object (first), "properties");
+    props_b = json_object_get_object_member (json_node_get_object (second), "properties");
+    g_assert_true (json_object_get_member (props_a, "cursor") ==
+                   json_object_get_member (props_b, "cursor"));
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count + 6);
+
+    /* The shared sub-schema outlives the first schema */
+    mcp_json_intern_release (first);
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count + 4);
+    mcp_json_intern_release (second);
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count);
+}
+
+static void
+test_json_intern_distinct (void)
+{
+    static const gchar *values[] = {
+        "{\"a\":1,\"b\":2}",
+        "{\"b\":2,\"a\":1}",
+        "{\"a\":1.0,\"b\":2}",
+        "{\"a\":\"1\",\"b\":2}",
+        "{\"a\":true,\"b\":2}",
+        "{\"a\":null,\"b\":2}",
+        "{\"a\":[1],\"b\":2}",
+        "[1,2]",
+        "[2,1]",
+        "[[1,2]]",
+    };
+    JsonNode *interned[G_N_ELEMENTS (values)];
+    guint count;
+    guint i;
+    guint j;
+
+    count = mcp_json_intern_get_count ();
+
+    for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+        g_autoptr(JsonNode) node = parse (values[i]);
+
+        interned[i] = mcp_json_intern (node);
+    }
+
+    /* Member order and number types are kept apart */
+    for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+        for (j = i + 1; j < G_N_ELEMENTS (values); j++)
+        {
+            g_assert_true (interned[i] != interned[j]);
+        }
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+        mcp_json_intern_release (interned[i]);
+    }
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count);
+}
+
+static void
+test_json_intern_scalar (void)
+{
+    g_autoptr(JsonNode) node = parse ("\"text\"");
+    JsonNode *interned;
+    guint count;
+
+    count = mcp_json_intern_get_count ();
+
+    interned = mcp_json_intern (node);
+    g_assert_true (json_node_is_immutable (interned));
+    g_assert_cmpstr (json_node_get_string (interned), ==, "text");
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count);
+
+    mcp_json_intern_release (interned);
+}
+
+static void
+test_json_intern_tool (void)
+{
+    g_autoptr(JsonNode) schema = parse ("{\"type\":\"object\",\"properties\":"
+                                        "{\"path\":{\"type\":\"string\"}}}");
+    g_autoptr(McpTool) read_tool = NULL;
+    g_autoptr(McpTool) stat_tool = NULL;
+    g_autoptr(JsonNode) json = NULL;
+    JsonObject *interned;
+    guint count;
+
+    count = mcp_json_intern_get_count ();
+
+    read_tool = mcp_tool_new ("read", NULL);
+    stat_tool = mcp_tool_new ("stat", NULL);
+    mcp_tool_set_input_schema (read_tool, schema);
+    mcp_tool_set_input_schema (stat_tool, schema);
+    g_assert_true (mcp_tool_get_input_schema (read_tool) == mcp_tool_get_input_schema (stat_tool));
+    g_assert_true (json_node_is_immutable (mcp_tool_get_input_schema (read_tool)));
+
+    /* The caller's node is left alone */
+    g_assert_false (json_node_is_immutable (schema));
+    json_object_set_string_member (json_node_get_object (schema), "title", "changed");
+    interned = json_node_get_object (mcp_tool_get_input_schema (read_tool));
+    g_assert_false (json_object_has_member (interned, "title"));
+
+    /* Serializing hands out the shared schema */
+    json = mcp_tool_to_json (read_tool);
+    g_assert_true (json_object_get_member (json_node_get_object (json), "inputSchema") ==
+                   mcp_tool_get_input_schema (read_tool));
+    g_clear_pointer (&json, json_node_unref);
+
+    g_clear_object (&read_tool);
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count + 3);
+    mcp_tool_set_input_schema (stat_tool, NULL);
+    g_assert_cmpuint (mcp_json_intern_get_count (), ==, count);
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/json-intern/shared", test_json_intern_shared);
+    g_test_add_func ("/mcp/json-intern/sub-schemas", test_json_intern_sub_schemas);
+    g_test_add_func ("/mcp/json-intern/distinct", test_json_intern_distinct);
+    g_test_add_func ("/mcp/json-intern/scalar", test_json_intern_scalar);
+    g_test_add_func ("/mcp/json-intern/tool", test_json_intern_tool);
+
+    return g_test_run ();
+}
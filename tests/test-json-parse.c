@@ -0,0 +1,182 @@
+/*
+ * test-json-parse.c - Unit tests for mcp_json_parse()
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <glib.h>
+#include "mcp.h"
+
+/*
+ * Parses @doc with both backends and checks they agree.
+ */
+static void
+assert_backends_agree (const gchar *doc)
+{
+    g_autoptr(JsonNode) native = NULL;
+    g_autoptr(JsonNode) reference = NULL;
+    g_autoptr(GError) error = NULL;
+
+    g_assert_true (mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_JSON_GLIB));
+    reference = mcp_json_parse (doc, -1, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (reference);
+
+    g_assert_true (mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_NATIVE));
+    native = mcp_json_parse (doc, -1, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (native);
+
+    g_assert_true (json_node_equal (native, reference));
+}
+
+static void
+test_json_parse_backend_select (void)
+{
+    g_assert_true (mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_JSON_GLIB));
+    g_assert_cmpstr (mcp_json_parse_get_backend (), ==, "json-glib");
+
+    g_assert_false (mcp_json_parse_set_backend ("no-such-backend"));
+    g_assert_cmpstr (mcp_json_parse_get_backend (), ==, "json-glib");
+
+    g_assert_true (mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_NATIVE));
+    g_assert_cmpstr (mcp_json_parse_get_backend (), ==, "native");
+}
+
+static void
+test_json_parse_messages (void)
+{
+    assert_backends_agree ("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/list\"}");
+    assert_backends_agree (
+        "{\"jsonrpc\": \"2.0\", \"id\": \"abc\", \"result\": {"
+        "  \"tools\": [ { \"name\": \"echo\", \"inputSchema\": {"
+        "    \"type\": \"object\", \"properties\": {} } } ],"
+        "  \"nextCursor\": null, \"ok\": true, \"partial\": false } }");
+    assert_backends_agree ("[1, -2, 0, 3.25, -0.5e3, 1E2, 9223372036854775807]");
+    assert_backends_agree ("\"top-level string\"");
+    assert_backends_agree ("  42  ");
+    assert_backends_agree ("{\"a\":{\"b\":{\"c\":[[[]]]}},\"a\":1}");
+}
+
+static void
+test_json_parse_strings (void)
+{
+    g_autoptr(JsonNode) node = NULL;
+    g_autoptr(GError) error = NULL;
+
+    mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_NATIVE);
+
+    /* Escapes inside and around the word-at-a-time fast path */
+    node = mcp_json_parse ("\"plain run longer than one word\\n\\t\\\"\\\\\\/end\"",
+                           -1, &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (json_node_get_string (node), ==,
+                     "plain run longer than one word\n\t\"\\/end");
+    g_clear_pointer (&node, json_node_unref);
+
+    /* \u escapes, including a surrogate pair, and raw UTF-8 */
+    node = mcp_json_parse ("\"caf\\u00e9 \\ud83d\\ude00 \xe2\x9c\x93\"", -1, &error);
+    g_assert_no_error (error);
+    g_assert_cmpstr (json_node_get_string (node), ==,
+                     "caf\xc3\xa9 \xf0\x9f\x98\x80 \xe2\x9c\x93");
+    g_clear_pointer (&node, json_node_unref);
+
+    /* Long member names go through the heap copy */
+    assert_backends_agree ("{\"a-member-name-that-is-much-longer-than-the-sixty-four-byte-"
+                           "stack-buffer\":\"v\",\"\":\"empty name\"}");
+}
+
+static void
+test_json_parse_length (void)
+{
+    g_autoptr(JsonNode) node = NULL;
+    g_autoptr(GError) error = NULL;
+    const gchar *doc = "{\"id\":7}garbage";
+
+    mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_NATIVE);
+
+    /* Only the first @length bytes are looked at */
+    node = mcp_json_parse (doc, 8, &error);
+    g_assert_no_error (error);
+    g_assert_cmpint (json_object_get_int_member (json_node_get_object (node), "id"),
+                     ==, 7);
+}
+
+static void
+test_json_parse_errors (void)
+{
+    static const struct
+    {
+        const gchar *doc;
+        gint         code;
+    } cases[] = {
+        { "{ not valid json }", JSON_PARSER_ERROR_INVALID_BAREWORD },
+        { "[tru]", JSON_PARSER_ERROR_INVALID_BAREWORD },
+        { "[1,]", JSON_PARSER_ERROR_TRAILING_COMMA },
+        { "{\"a\":1,}", JSON_PARSER_ERROR_TRAILING_COMMA },
+        { "{\"a\" 1}", JSON_PARSER_ERROR_MISSING_COLON },
+        { "[1 2]", JSON_PARSER_ERROR_MISSING_COMMA },
+        { "\"unterminated", JSON_PARSER_ERROR_PARSE },
+        { "\"ctrl\x01\"", JSON_PARSER_ERROR_INVALID_DATA },
+        { "\"\\ud800\"", JSON_PARSER_ERROR_INVALID_DATA },
+        { "\"\\x\"", JSON_PARSER_ERROR_INVALID_DATA },
+        { "\"\xff\"", JSON_PARSER_ERROR_INVALID_DATA },
+        { "01", JSON_PARSER_ERROR_PARSE },
+        { "-", JSON_PARSER_ERROR_INVALID_DATA },
+        { "1.", JSON_PARSER_ERROR_INVALID_DATA },
+        { "{} {}", JSON_PARSER_ERROR_PARSE },
+        { "", JSON_PARSER_ERROR_PARSE },
+        { " \n ", JSON_PARSER_ERROR_PARSE },
+    };
+    guint i;
+
+    mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_NATIVE);
+
+    for (i = 0; i < G_N_ELEMENTS (cases); i++)
+    {
+        g_autoptr(JsonNode) node = NULL;
+        g_autoptr(GError) error = NULL;
+
+        node = mcp_json_parse (cases[i].doc, -1, &error);
+        g_assert_null (node);
+        g_assert_error (error, JSON_PARSER_ERROR, cases[i].code);
+    }
+}
+
+static void
+test_json_parse_depth (void)
+{
+    g_autoptr(GString) doc = NULL;
+    g_autoptr(JsonNode) node = NULL;
+    g_autoptr(GError) error = NULL;
+    guint i;
+
+    mcp_json_parse_set_backend (MCP_JSON_PARSER_BACKEND_NATIVE);
+
+    doc = g_string_new (NULL);
+    for (i = 0; i < 100000; i++)
+    {
+        g_string_append_c (doc, '[');
+    }
+
+    /* Rejected before the stack runs out */
+    node = mcp_json_parse (doc->str, doc->len, &error);
+    g_assert_null (node);
+    g_assert_error (error, JSON_PARSER_ERROR, JSON_PARSER_ERROR_PARSE);
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/json-parse/backend-select", test_json_parse_backend_select);
+    g_test_add_func ("/mcp/json-parse/messages", test_json_parse_messages);
+    g_test_add_func ("/mcp/json-parse/strings", test_json_parse_strings);
+    g_test_add_func ("/mcp/json-parse/length", test_json_parse_length);
+    g_test_add_func ("/mcp/json-parse/errors", test_json_parse_errors);
+    g_test_add_func ("/mcp/json-parse/depth", test_json_parse_depth);
+
+    return g_test_run ();
+}
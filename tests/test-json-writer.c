@@ -0,0 +1,228 @@
+/*
+ * test-json-writer.c - Unit tests for McpJsonWriter
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <glib.h>
+#include <math.h>
+#include "mcp.h"
+
+/*
+ * Parses the writer's output and checks it is the same document as
+ * @expected, so tests don't depend on json-glib's formatting.
+ */
+static void
+assert_same_json (McpJsonWriter *writer,
+                  JsonNode      *expected)
+{
+    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(GError) error = NULL;
+    const gchar *data;
+    gsize len;
+
+    data = mcp_json_writer_get_data (writer, &len);
+    parser = json_parser_new ();
+    g_assert_true (json_parser_load_from_data (parser, data, (gssize) len, &error));
+    g_assert_no_error (error);
+    g_assert_true (json_node_equal (json_parser_get_root (parser), expected));
+}
+
+static void
+test_json_writer_structure (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+
+    writer = mcp_json_writer_new ();
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_member (writer, "a");
+    mcp_json_writer_int (writer, 1);
+    mcp_json_writer_member (writer, "b");
+    mcp_json_writer_begin_array (writer);
+    mcp_json_writer_boolean (writer, TRUE);
+    mcp_json_writer_null (writer);
+    mcp_json_writer_begin_object (writer);
+    mcp_json_writer_end_object (writer);
+    mcp_json_writer_begin_array (writer);
+    mcp_json_writer_end_array (writer);
+    mcp_json_writer_string (writer, "x");
+    mcp_json_writer_end_array (writer);
+    mcp_json_writer_member (writer, "c");
+    mcp_json_writer_raw (writer, "{\"d\":false}", -1);
+    mcp_json_writer_end_object (writer);
+
+    g_assert_cmpstr (mcp_json_writer_get_data (writer, NULL), ==,
+                     "{\"a\":1,\"b\":[true,null,{},[],\"x\"],\"c\":{\"d\":false}}");
+
+    /* Reset starts a fresh document */
+    mcp_json_writer_reset (writer);
+    mcp_json_writer_int (writer, -42);
+    g_assert_cmpstr (mcp_json_writer_get_data (writer, NULL), ==, "-42");
+}
+
+static void
+test_json_writer_escaping (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+
+    writer = mcp_json_writer_new ();
+
+    /* Escapes inside and around the word-at-a-time fast path */
+    mcp_json_writer_string (writer, "plain ascii text, longer than a word");
+    g_assert_cmpstr (mcp_json_writer_get_data (writer, NULL), ==,
+                     "\"plain ascii text, longer than a word\"");
+
+    mcp_json_writer_reset (writer);
+    mcp_json_writer_string (writer, "quote\" back\\slash\nnl\ttab\x01" "end");
+    g_assert_cmpstr (mcp_json_writer_get_data (writer, NULL), ==,
+                     "\"quote\\\" back\\\\slash\\nnl\\ttab\\u0001end\"");
+
+    /* UTF-8 passes through unescaped */
+    mcp_json_writer_reset (writer);
+    mcp_json_writer_string (writer, "caf\xc3\xa9 \xe2\x9c\x93");
+    g_assert_cmpstr (mcp_json_writer_get_data (writer, NULL), ==,
+                     "\"caf\xc3\xa9 \xe2\x9c\x93\"");
+
+    /* Explicit length may contain NUL */
+    mcp_json_writer_reset (writer);
+    mcp_json_writer_string_len (writer, "a\0b", 3);
+    g_assert_cmpstr (mcp_json_writer_get_data (writer, NULL), ==, "\"a\\u0000b\"");
+}
+
+static void
+test_json_writer_double (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+
+    writer = mcp_json_writer_new ();
+    mcp_json_writer_begin_array (writer);
+    mcp_json_writer_double (writer, 1.5);
+    mcp_json_writer_double (writer, 1.0);
+    mcp_json_writer_double (writer, -0.0);
+    mcp_json_writer_double (writer, 1e20);
+    mcp_json_writer_double (writer, NAN);
+    mcp_json_writer_double (writer, -INFINITY);
+    mcp_json_writer_end_array (writer);
+
+    /* Integral doubles keep their fraction, so they read back as doubles */
+    g_assert_cmpstr (mcp_json_writer_get_data (writer, NULL), ==,
+                     "[1.5,1.0,-0.0,1e+20,null,null]");
+}
+
+static void
+test_json_writer_node (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+    g_autoptr(JsonParser) parser = NULL;
+    g_autoptr(GError) error = NULL;
+    const gchar *doc =
+        "{\"s\":\"v\\\"q\",\"i\":7,\"d\":1.5,\"b\":false,\"n\":null,"
+        "\"a\":[1,[2,{\"x\":\"y\"}]],\"o\":{}}";
+
+    parser = json_parser_new ();
+    g_assert_true (json_parser_load_from_data (parser, doc, -1, &error));
+    g_assert_no_error (error);
+
+    writer = mcp_json_writer_new ();
+    mcp_json_writer_node (writer, json_parser_get_root (parser));
+
+    assert_same_json (writer, json_parser_get_root (parser));
+}
+
+static void
+test_json_writer_tool_matches (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+    g_autoptr(McpTool) tool = NULL;
+    g_autoptr(JsonNode) expected = NULL;
+    g_autoptr(JsonParser) parser = NULL;
+
+    parser = json_parser_new ();
+    g_assert_true (json_parser_load_from_data (parser,
+        "{\"type\":\"object\",\"properties\":{\"q\":{\"type\":\"string\"}}}",
+        -1, NULL));
+
+    tool = mcp_tool_new ("search", "Search \"things\"");
+    mcp_tool_set_title (tool, "Search");
+    mcp_tool_set_input_schema (tool, json_parser_get_root (parser));
+    mcp_tool_set_read_only_hint (tool, TRUE);
+
+    writer = mcp_json_writer_new ();
+    mcp_tool_write_json (tool, writer);
+
+    expected = mcp_tool_to_json (tool);
+    assert_same_json (writer, expected);
+}
+
+static void
+test_json_writer_tool_result_matches (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+    g_autoptr(McpToolResult) result = NULL;
+    g_autoptr(JsonNode) expected = NULL;
+
+    result = mcp_tool_result_new (TRUE);
+    mcp_tool_result_add_text (result, "line one\nline two");
+    mcp_tool_result_add_image (result, "aGVsbG8=", "image/png");
+
+    writer = mcp_json_writer_new ();
+    mcp_tool_result_write_json (result, writer);
+
+    expected = mcp_tool_result_to_json (result);
+    assert_same_json (writer, expected);
+}
+
+static void
+test_json_writer_resource_contents_matches (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+    g_autoptr(JsonNode) expected = NULL;
+    McpResourceContents *contents;
+
+    contents = mcp_resource_contents_new_text ("file:///a.txt", "hi\t\"there\"",
+                                               "text/plain");
+
+    writer = mcp_json_writer_new ();
+    mcp_resource_contents_write_json (contents, writer);
+
+    expected = mcp_resource_contents_to_json (contents);
+    assert_same_json (writer, expected);
+
+    mcp_resource_contents_unref (contents);
+}
+
+static void
+test_json_writer_task_matches (void)
+{
+    g_autoptr(McpJsonWriter) writer = NULL;
+    g_autoptr(McpTask) task = NULL;
+    g_autoptr(JsonNode) expected = NULL;
+
+    task = mcp_task_new ("task-1", MCP_TASK_STATUS_WORKING);
+    mcp_task_set_status_message (task, "Processing");
+
+    writer = mcp_json_writer_new ();
+    mcp_task_write_json (task, writer);
+
+    expected = mcp_task_to_json (task);
+    assert_same_json (writer, expected);
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/json-writer/structure", test_json_writer_structure);
+    g_test_add_func ("/mcp/json-writer/escaping", test_json_writer_escaping);
+    g_test_add_func ("/mcp/json-writer/double", test_json_writer_double);
+    g_test_add_func ("/mcp/json-writer/node", test_json_writer_node);
+    g_test_add_func ("/mcp/json-writer/tool", test_json_writer_tool_matches);
+    g_test_add_func ("/mcp/json-writer/tool-result", test_json_writer_tool_result_matches);
+    g_test_add_func ("/mcp/json-writer/resource-contents",
+                     test_json_writer_resource_contents_matches);
+    g_test_add_func ("/mcp/json-writer/task", test_json_writer_task_matches);
+
+    return g_test_run ();
+}
@@ -6,6 +6,10 @@
  */
 
 #include <glib.h>
+#ifdef G_OS_UNIX
+#include <glib-unix.h>
+#include <unistd.h>
+#endif
 #include "mcp.h"
 
 /* ========================================================================== */
@@ -443,6 +447,74 @@ test_resource_template_json_roundtrip (void)
                      mcp_resource_template_get_mime_type (restored));
 }
 
+#ifdef G_OS_UNIX
+/*
+ * Test bulk contents backed by a pipe, which cannot be rewound
+ */
+static void
+test_resource_contents_pipe (void)
+{
+    g_autoptr(McpResourceContents) contents = NULL;
+    g_autoptr(GError) error = NULL;
+    const gchar *blob;
+    gint fds[2];
+
+    g_assert_true (g_unix_open_pipe (fds, FD_CLOEXEC, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (write (fds[1], "pipe data", 9), ==, 9);
+    close (fds[1]);
+
+    contents = mcp_resource_contents_new_from_fd ("test://pipe", fds[0],
+                                                  "application/octet-stream");
+    g_assert_true (mcp_resource_contents_is_bulk (contents));
+
+    blob = mcp_resource_contents_get_blob (contents);
+    g_assert_cmpstr (blob, ==, "cGlwZSBkYXRh");
+
+    /* The pipe is drained; the encoded form is kept */
+    g_assert_true (mcp_resource_contents_get_blob (contents) == blob);
+}
+
+static gpointer
+get_blob_thread (gpointer data)
+{
+    return (gpointer) mcp_resource_contents_get_blob (data);
+}
+
+/*
+ * Test that the blob of shared contents is built once across threads
+ */
+static void
+test_resource_contents_blob_threads (void)
+{
+    g_autoptr(McpResourceContents) contents = NULL;
+    g_autoptr(GError) error = NULL;
+    GThread *threads[8];
+    const gchar *blob;
+    gint fds[2];
+    guint i;
+
+    g_assert_true (g_unix_open_pipe (fds, FD_CLOEXEC, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (write (fds[1], "pipe data", 9), ==, 9);
+    close (fds[1]);
+
+    contents = mcp_resource_contents_new_from_fd ("test://pipe", fds[0], NULL);
+
+    for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+        threads[i] = g_thread_new ("get-blob", get_blob_thread, contents);
+    }
+
+    blob = mcp_resource_contents_get_blob (contents);
+    g_assert_cmpstr (blob, ==, "cGlwZSBkYXRh");
+    for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+        g_assert_true (g_thread_join (threads[i]) == blob);
+    }
+}
+#endif
+
 int
 main (int   argc,
       char *argv[])
@@ -468,5 +540,11 @@ main (int   argc,
                      test_resource_template_from_json_missing_uri_template);
     g_test_add_func ("/mcp/resource-template/json-roundtrip", test_resource_template_json_roundtrip);
 
+#ifdef G_OS_UNIX
+    /* McpResourceContents tests */
+    g_test_add_func ("/mcp/resource-contents/pipe", test_resource_contents_pipe);
+    g_test_add_func ("/mcp/resource-contents/blob-threads", test_resource_contents_blob_threads);
+#endif
+
     return g_test_run ();
 }
@@ -0,0 +1,339 @@
+/*
+ * test-seqpacket-transport.c - Tests for McpSeqpacketTransport
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <string.h>
+#include <unistd.h>
+#include "mcp.h"
+
+/* ── helpers ───────────────────────────────────────────────────────── */
+
+static gchar *
+make_test_socket_path (const gchar *test_name)
+{
+    return g_strdup_printf ("%s/mcp-test-seqpacket-%s-%d.sock",
+                            g_get_user_runtime_dir (),
+                            test_name,
+                            (gint) getpid ());
+}
+
+static McpToolResult *
+echo_tool_handler (McpServer   *server,
+                   const gchar *name,
+                   JsonObject  *arguments,
+                   gpointer     user_data)
+{
+    McpToolResult *result;
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, json_object_get_string_member (arguments, "text"));
+    return result;
+}
+
+typedef struct
+{
+    McpServer *last_server;
+    gint       created;
+    gint       closed;
+} SessionCtx;
+
+static void
+on_session_created (McpUnixSocketServer *socket_server,
+                    McpServer           *server,
+                    gpointer             user_data)
+{
+    SessionCtx *ctx = user_data;
+    g_autoptr(McpTool) echo = NULL;
+
+    echo = mcp_tool_new ("echo", "Echo the text argument");
+    mcp_server_add_tool (server, echo, echo_tool_handler, NULL, NULL);
+
+    ctx->last_server = server;
+    ctx->created++;
+}
+
+static void
+on_session_closed (McpUnixSocketServer *socket_server,
+                   McpServer           *server,
+                   gpointer             user_data)
+{
+    SessionCtx *ctx = user_data;
+
+    ctx->closed++;
+}
+
+static McpUnixSocketServer *
+start_server (const gchar *path,
+              SessionCtx  *ctx)
+{
+    McpUnixSocketServer *server;
+    g_autoptr(GError) error = NULL;
+
+    server = mcp_unix_socket_server_new ("test-server", "1.0", path);
+    mcp_unix_socket_server_set_socket_type (server, G_SOCKET_TYPE_SEQPACKET);
+    g_signal_connect (server, "session-created", G_CALLBACK (on_session_created), ctx);
+    g_signal_connect (server, "session-closed", G_CALLBACK (on_session_closed), ctx);
+
+    g_assert_true (mcp_unix_socket_server_start (server, &error));
+    g_assert_no_error (error);
+
+    return server;
+}
+
+static McpClient *
+connect_client (McpTransport *transport)
+{
+    McpClient *client;
+    gint64 deadline;
+
+    client = mcp_client_new ("test-client", "1.0");
+    mcp_client_set_transport (client, transport);
+    mcp_client_connect_async (client, NULL, NULL, NULL);
+
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    while (mcp_session_get_state (MCP_SESSION (client)) != MCP_SESSION_STATE_READY &&
+           g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (mcp_session_get_state (MCP_SESSION (client)), ==,
+                     MCP_SESSION_STATE_READY);
+
+    return client;
+}
+
+typedef struct
+{
+    GMainLoop     *loop;
+    McpToolResult *result;
+    GError        *error;
+    gint           pending;
+} CallCtx;
+
+static void
+on_call_done (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    CallCtx *cc = user_data;
+
+    cc->result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &cc->error);
+    g_main_loop_quit (cc->loop);
+}
+
+static const gchar *
+result_text (McpToolResult *result)
+{
+    JsonNode *content;
+
+    content = json_array_get_element (mcp_tool_result_get_content (result), 0);
+    return json_object_get_string_member (json_node_get_object (content), "text");
+}
+
+/* Calls the echo tool and checks the text comes back unchanged */
+static void
+assert_echo (McpClient   *client,
+             const gchar *text)
+{
+    g_autoptr(JsonObject) args = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    CallCtx cc = { NULL, NULL, NULL, 0 };
+
+    args = json_object_new ();
+    json_object_set_string_member (args, "text", text);
+
+    loop = g_main_loop_new (NULL, FALSE);
+    cc.loop = loop;
+    mcp_client_call_tool_async (client, "echo", args, NULL, on_call_done, &cc);
+    g_main_loop_run (loop);
+
+    g_assert_no_error (cc.error);
+    g_assert_nonnull (cc.result);
+    g_assert_cmpstr (result_text (cc.result), ==, text);
+    mcp_tool_result_unref (cc.result);
+}
+
+/* ── tests ─────────────────────────────────────────────────────────── */
+
+static void
+test_seqpacket_echo (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("echo");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpSeqpacketTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+    gint i;
+
+    server = start_server (path, &ctx);
+    g_assert_cmpint (mcp_unix_socket_server_get_socket_type (server), ==,
+                     G_SOCKET_TYPE_SEQPACKET);
+
+    transport = mcp_seqpacket_transport_new_client (path);
+    client = connect_client (MCP_TRANSPORT (transport));
+    g_assert_cmpint (ctx.created, ==, 1);
+    g_assert_true (MCP_IS_SEQPACKET_TRANSPORT (mcp_server_get_transport (ctx.last_server)));
+
+    for (i = 0; i < 50; i++)
+    {
+        g_autofree gchar *text = g_strdup_printf ("message %d", i);
+
+        assert_echo (client, text);
+    }
+
+    /* Newlines are just bytes inside a datagram */
+    assert_echo (client, "line one\nline two\n");
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_seqpacket_large_message (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("large");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpSeqpacketTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autofree gchar *text = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+
+    server = start_server (path, &ctx);
+    transport = mcp_seqpacket_transport_new_client (path);
+    client = connect_client (MCP_TRANSPORT (transport));
+
+    /* Larger than the default socket buffer, so the sender grows it */
+    text = g_strnfill (300 * 1024, 'x');
+    assert_echo (client, text);
+    assert_echo (client, "small after large");
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+on_burst_call_done (GObject      *source,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+    CallCtx *cc = user_data;
+    McpToolResult *tool_result;
+
+    tool_result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &cc->error);
+    g_assert_no_error (cc->error);
+    mcp_tool_result_unref (tool_result);
+
+    if (--cc->pending == 0)
+    {
+        g_main_loop_quit (cc->loop);
+    }
+}
+
+static void
+test_seqpacket_burst (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("burst");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpSeqpacketTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+    CallCtx cc = { NULL, NULL, NULL, 0 };
+    gint i;
+
+    server = start_server (path, &ctx);
+    transport = mcp_seqpacket_transport_new_client (path);
+    client = connect_client (MCP_TRANSPORT (transport));
+
+    /* Far more datagrams than the peer queues at once: the rest wait
+     * in the write queue until the socket is writable again */
+    loop = g_main_loop_new (NULL, FALSE);
+    cc.loop = loop;
+    for (i = 0; i < 200; i++)
+    {
+        g_autoptr(JsonObject) args = json_object_new ();
+        g_autofree gchar *text = g_strdup_printf ("burst %d", i);
+
+        json_object_set_string_member (args, "text", text);
+        cc.pending++;
+        mcp_client_call_tool_async (client, "echo", args, NULL, on_burst_call_done, &cc);
+    }
+    g_main_loop_run (loop);
+    g_assert_cmpint (cc.pending, ==, 0);
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_seqpacket_peer_close (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("close");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpSeqpacketTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+    gint64 deadline;
+
+    server = start_server (path, &ctx);
+    transport = mcp_seqpacket_transport_new_client (path);
+    client = connect_client (MCP_TRANSPORT (transport));
+
+    mcp_transport_disconnect_async (MCP_TRANSPORT (transport), NULL, NULL, NULL);
+    g_assert_cmpint (mcp_transport_get_state (MCP_TRANSPORT (transport)), ==,
+                     MCP_TRANSPORT_STATE_DISCONNECTED);
+
+    /* The server reads end of stream and reaps the session */
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    while (ctx.closed == 0 && g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (ctx.closed, ==, 1);
+    g_assert_cmpuint (mcp_unix_socket_server_get_session_count (server), ==, 0);
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_seqpacket_stream_client_refused (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("refused");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(GSocketClient) socket_client = NULL;
+    g_autoptr(GSocketAddress) address = NULL;
+    g_autoptr(GSocketConnection) connection = NULL;
+    g_autoptr(GError) error = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+
+    server = start_server (path, &ctx);
+
+    /* A stream socket cannot connect to a seqpacket listener */
+    socket_client = g_socket_client_new ();
+    address = g_unix_socket_address_new (path);
+    connection = g_socket_client_connect (socket_client, G_SOCKET_CONNECTABLE (address),
+                                          NULL, &error);
+    g_assert_null (connection);
+    g_assert_nonnull (error);
+    g_assert_cmpint (ctx.created, ==, 0);
+
+    mcp_unix_socket_server_stop (server);
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/seqpacket/echo", test_seqpacket_echo);
+    g_test_add_func ("/mcp/seqpacket/large-message", test_seqpacket_large_message);
+    g_test_add_func ("/mcp/seqpacket/burst", test_seqpacket_burst);
+    g_test_add_func ("/mcp/seqpacket/peer-close", test_seqpacket_peer_close);
+    g_test_add_func ("/mcp/seqpacket/stream-client-refused",
+                     test_seqpacket_stream_client_refused);
+
+    return g_test_run ();
+}
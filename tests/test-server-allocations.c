@@ -0,0 +1,182 @@
+/*
+ * test-server-allocations.c - Heap allocations per request with and
+ * without McpServer's per-message arena
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * Run with --verbose to see the figures.
+ */
+
+#include <glib.h>
+#include "mcp.h"
+
+/*
+ * Definitions in the executable take precedence over the C library's
+ * for every shared object, so GLib's and mcp-glib's calls are counted
+ * too.  Sanitizers bring their own allocator, which this would bypass.
+ */
+#if defined (__GLIBC__) && !defined (__SANITIZE_ADDRESS__) && !defined (__SANITIZE_THREAD__)
+#define HAVE_ALLOC_COUNT 1
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static gint alloc_count = 0;
+
+void *
+malloc (size_t size)
+{
+    g_atomic_int_inc (&alloc_count);
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members,
+        size_t size)
+{
+    g_atomic_int_inc (&alloc_count);
+    return __libc_calloc (n_members, size);
+}
+
+void *
+realloc (void   *ptr,
+         size_t  size)
+{
+    g_atomic_int_inc (&alloc_count);
+    return __libc_realloc (ptr, size);
+}
+#endif
+
+#define N_CALLS 200
+
+#ifdef HAVE_ALLOC_COUNT
+
+static McpToolResult *
+echo_tool_handler (McpServer   *server,
+                   const gchar *name,
+                   JsonObject  *arguments,
+                   gpointer     user_data)
+{
+    McpToolResult *result;
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, json_object_get_string_member (arguments, "text"));
+    return result;
+}
+
+typedef struct
+{
+    GMainLoop     *loop;
+    McpToolResult *result;
+    GError        *error;
+} CallCtx;
+
+static void
+on_call_done (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    CallCtx *cc = user_data;
+
+    cc->result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &cc->error);
+    g_main_loop_quit (cc->loop);
+}
+
+/*
+ * Calls an echo tool over an in-process pair N_CALLS times after one
+ * warm-up call, and returns the allocations per call made by the
+ * client, the server and the transports together.
+ */
+static gdouble
+allocations_per_call (gboolean use_arena)
+{
+    g_autoptr(McpInProcessTransport) client_t = NULL;
+    g_autoptr(McpInProcessTransport) server_t = NULL;
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autoptr(McpTool) echo = NULL;
+    g_autoptr(JsonObject) args = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    gint64 deadline;
+    gint count = 0;
+    guint i;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &client_t, &server_t);
+
+    server = mcp_server_new ("test-server", "1.0");
+    mcp_server_set_use_arena (server, use_arena);
+    g_assert_true (mcp_server_get_use_arena (server) == use_arena);
+    echo = mcp_tool_new ("echo", "Echo the text argument");
+    mcp_server_add_tool (server, echo, echo_tool_handler, NULL, NULL);
+    mcp_server_set_transport (server, MCP_TRANSPORT (server_t));
+    mcp_server_start_async (server, NULL, NULL, NULL);
+
+    client = mcp_client_new ("test-client", "1.0");
+    mcp_client_set_transport (client, MCP_TRANSPORT (client_t));
+    mcp_client_connect_async (client, NULL, NULL, NULL);
+
+    deadline = g_get_monotonic_time () + 3 * G_USEC_PER_SEC;
+    while (mcp_session_get_state (MCP_SESSION (client)) != MCP_SESSION_STATE_READY &&
+           g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (mcp_session_get_state (MCP_SESSION (client)), ==,
+                     MCP_SESSION_STATE_READY);
+
+    args = json_object_new ();
+    json_object_set_string_member (args, "text", "hello");
+    loop = g_main_loop_new (NULL, FALSE);
+
+    for (i = 0; i <= N_CALLS; i++)
+    {
+        CallCtx cc = { loop, NULL, NULL };
+        gint before = g_atomic_int_get (&alloc_count);
+
+        mcp_client_call_tool_async (client, "echo", args, NULL, on_call_done, &cc);
+        g_main_loop_run (loop);
+        g_assert_no_error (cc.error);
+        g_assert_nonnull (cc.result);
+        mcp_tool_result_unref (cc.result);
+
+        /* The first call fills caches and scratch buffers */
+        if (i > 0)
+        {
+            count += g_atomic_int_get (&alloc_count) - before;
+        }
+    }
+
+    return (gdouble) count / N_CALLS;
+}
+
+#endif /* HAVE_ALLOC_COUNT */
+
+static void
+test_server_allocations_arena (void)
+{
+#ifdef HAVE_ALLOC_COUNT
+    gdouble with_arena;
+    gdouble without_arena;
+
+    without_arena = allocations_per_call (FALSE);
+    with_arena = allocations_per_call (TRUE);
+
+    g_test_message ("allocations per call: %.1f with the arena, %.1f without",
+                    with_arena, without_arena);
+    g_assert_cmpfloat (with_arena, <, without_arena);
+#else
+    g_test_skip ("Allocations are only counted with glibc and no sanitizer");
+#endif
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/server-allocations/arena", test_server_allocations_arena);
+
+    return g_test_run ();
+}
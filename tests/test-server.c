@@ -9,6 +9,9 @@
 #include "mcp.h"
 #undef MCP_COMPILATION
 
+#include <stdlib.h>
+#include <string.h>
+
 /* ========================================================================== */
 /* McpToolResult tests                                                        */
 /* ========================================================================== */
@@ -437,6 +440,52 @@ test_server_multiple_entities (void)
     g_list_free_full (prompts, g_object_unref);
 }
 
+static void
+test_server_idle (void)
+{
+    g_autoptr(McpServer) first = NULL;
+    g_autoptr(McpServer) second = NULL;
+    g_autoptr(McpTool) tool = NULL;
+    g_autoptr(McpPrompt) prompt = NULL;
+    GList *list;
+
+    /* Nothing is allocated yet, but every getter still works */
+    first = mcp_server_new ("first", "1.0.0");
+    second = mcp_server_new ("second", "1.0.0");
+    g_assert_null (mcp_server_list_tools (first));
+    g_assert_null (mcp_server_list_resources (first));
+    g_assert_null (mcp_server_list_tasks (first));
+    g_assert_null (mcp_server_get_task (first, "task-1"));
+    g_assert_false (mcp_server_complete_task (first, "task-1", NULL, NULL));
+    g_assert_cmpuint (mcp_session_get_pending_request_count (MCP_SESSION (first)), ==, 0);
+    mcp_server_notify_resource_updated (first, "file:///unsubscribed");
+
+    /* Both start from the same empty registry; a change to one must
+     * not show up in the other */
+    tool = mcp_tool_new ("echo", "Echoes the input");
+    mcp_server_add_tool (first, tool, NULL, NULL, NULL);
+    prompt = mcp_prompt_new ("helper", "Helper prompt");
+    mcp_server_add_prompt (second, prompt, NULL, NULL, NULL);
+
+    list = mcp_server_list_tools (first);
+    g_assert_cmpuint (g_list_length (list), ==, 1);
+    g_list_free_full (list, g_object_unref);
+    g_assert_null (mcp_server_list_prompts (first));
+    g_assert_null (mcp_server_list_tools (second));
+    list = mcp_server_list_prompts (second);
+    g_assert_cmpuint (g_list_length (list), ==, 1);
+    g_list_free_full (list, g_object_unref);
+
+    g_assert_true (mcp_server_capabilities_get_tools (mcp_server_get_capabilities (first)));
+    g_assert_false (mcp_server_capabilities_get_tools (mcp_server_get_capabilities (second)));
+
+    /* A third server still starts empty */
+    g_clear_object (&first);
+    first = mcp_server_new ("third", "1.0.0");
+    g_assert_null (mcp_server_list_tools (first));
+    g_assert_null (mcp_server_list_prompts (first));
+}
+
 static void
 test_server_session_state (void)
 {
@@ -450,6 +499,1423 @@ test_server_session_state (void)
     g_assert_cmpint (state, ==, MCP_SESSION_STATE_DISCONNECTED);
 }
 
+/* ========================================================================== */
+/* Registry update tests                                                      */
+/* ========================================================================== */
+
+static guint
+count_list (GList *list)
+{
+    guint n = g_list_length (list);
+
+    g_list_free_full (list, g_object_unref);
+    return n;
+}
+
+static void
+test_server_update_commit (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(McpServerUpdate) update = NULL;
+    g_autoptr(McpTool) old_tool = NULL;
+    g_autoptr(McpTool) new_tool = NULL;
+    g_autoptr(McpPrompt) prompt = NULL;
+    g_autoptr(McpResourceTemplate) templ = NULL;
+    McpServerCapabilities *caps;
+    GList *tools;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    old_tool = mcp_tool_new ("old", "Old tool");
+    new_tool = mcp_tool_new ("new", "New tool");
+    prompt = mcp_prompt_new ("greeting", "Greeting");
+    templ = mcp_resource_template_new ("file:///{path}", "File");
+
+    mcp_server_add_tool (server, old_tool, NULL, NULL, NULL);
+
+    update = mcp_server_update_new ();
+    mcp_server_update_remove_tool (update, "old");
+    mcp_server_update_add_tool (update, new_tool, NULL, NULL, NULL);
+    mcp_server_update_add_prompt (update, prompt, NULL, NULL, NULL);
+    mcp_server_update_add_resource_template (update, templ, NULL, NULL, NULL);
+
+    /* Nothing is visible before the commit */
+    g_assert_cmpuint (count_list (mcp_server_list_prompts (server)), ==, 0);
+    caps = mcp_server_get_capabilities (server);
+    g_assert_false (mcp_server_capabilities_get_prompts (caps));
+
+    mcp_server_commit_update (server, update);
+
+    tools = mcp_server_list_tools (server);
+    g_assert_cmpuint (g_list_length (tools), ==, 1);
+    g_assert_cmpstr (mcp_tool_get_name (tools->data), ==, "new");
+    g_list_free_full (tools, g_object_unref);
+    g_assert_cmpuint (count_list (mcp_server_list_prompts (server)), ==, 1);
+    g_assert_cmpuint (count_list (mcp_server_list_resource_templates (server)), ==, 1);
+    g_assert_true (mcp_server_capabilities_get_prompts (caps));
+    g_assert_true (mcp_server_capabilities_get_resources (caps));
+
+    /* The same update can be committed again, to this or another server */
+    mcp_server_commit_update (server, update);
+    g_assert_cmpuint (count_list (mcp_server_list_tools (server)), ==, 1);
+}
+
+typedef struct
+{
+    McpServer *server;
+    gint       destroyed;
+} InFlightCtx;
+
+static void
+in_flight_destroy (gpointer user_data)
+{
+    InFlightCtx *ctx = user_data;
+
+    ctx->destroyed++;
+}
+
+static McpToolResult *
+reload_tool_handler (McpServer   *server,
+                     const gchar *name,
+                     JsonObject  *arguments,
+                     gpointer     user_data)
+{
+    InFlightCtx *ctx = user_data;
+    g_autoptr(McpServerUpdate) update = NULL;
+    McpToolResult *result;
+
+    /* Unregister ourselves while still running */
+    update = mcp_server_update_new ();
+    mcp_server_update_remove_tool (update, name);
+    mcp_server_commit_update (server, update);
+
+    g_assert_cmpuint (count_list (mcp_server_list_tools (server)), ==, 0);
+    g_assert_cmpint (ctx->destroyed, ==, 0);
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, "done");
+    return result;
+}
+
+static void
+test_server_update_in_flight (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(McpTool) tool = NULL;
+    g_autoptr(McpToolResult) result = NULL;
+    g_autoptr(GError) error = NULL;
+    InFlightCtx ctx = { NULL, 0 };
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    tool = mcp_tool_new ("reload", "Removes itself");
+    ctx.server = server;
+    mcp_server_add_tool (server, tool, reload_tool_handler, &ctx, in_flight_destroy);
+
+    /* The call finishes against the snapshot it started with; the
+     * handler's data goes once that snapshot is released */
+    result = mcp_server_invoke_tool (server, "reload", NULL, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (result);
+    g_assert_cmpint (ctx.destroyed, ==, 1);
+}
+
+#define UPDATE_THREADS 4
+#define UPDATES_PER_THREAD 50
+
+typedef struct
+{
+    McpServer *server;
+    gint       index;
+} UpdaterArgs;
+
+static gpointer
+updater_thread (gpointer user_data)
+{
+    UpdaterArgs *args = user_data;
+    gint i;
+
+    for (i = 0; i < UPDATES_PER_THREAD; i++)
+    {
+        g_autoptr(McpServerUpdate) update = mcp_server_update_new ();
+        g_autofree gchar *name = g_strdup_printf ("tool-%d-%d", args->index, i);
+        g_autoptr(McpTool) tool = mcp_tool_new (name, "Added from a thread");
+
+        mcp_server_update_add_tool (update, tool, NULL, NULL, NULL);
+        mcp_server_commit_update (args->server, update);
+    }
+
+    return NULL;
+}
+
+static void
+test_server_update_from_threads (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    UpdaterArgs args[UPDATE_THREADS];
+    GThread *threads[UPDATE_THREADS];
+    gint i;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+
+    for (i = 0; i < UPDATE_THREADS; i++)
+    {
+        args[i].server = server;
+        args[i].index = i;
+        threads[i] = g_thread_new ("updater", updater_thread, &args[i]);
+    }
+
+    /* Readers on the server's context keep working meanwhile */
+    for (i = 0; i < 100; i++)
+    {
+        count_list (mcp_server_list_tools (server));
+        g_main_context_iteration (NULL, FALSE);
+    }
+
+    for (i = 0; i < UPDATE_THREADS; i++)
+    {
+        g_thread_join (threads[i]);
+    }
+
+    /* No commit lost another's changes */
+    g_assert_cmpuint (count_list (mcp_server_list_tools (server)), ==,
+                      UPDATE_THREADS * UPDATES_PER_THREAD);
+
+    /* Capabilities are turned on from the server's context */
+    while (g_main_context_iteration (NULL, FALSE))
+        ;
+    g_assert_true (mcp_server_capabilities_get_tools (mcp_server_get_capabilities (server)));
+}
+
+typedef struct
+{
+    McpInProcessTransport *client_t;
+    McpInProcessTransport *server_t;
+    McpClient             *client;
+    gint                   tools_changed;
+    gint                   resources_changed;
+    gint                   prompts_changed;
+} ListChangedCtx;
+
+static void
+on_list_changed (McpClient *client,
+                 gpointer   user_data)
+{
+    gint *count = user_data;
+
+    (*count)++;
+}
+
+/* Connects a client to @server over an in-process pair */
+static void
+list_changed_ctx_connect (ListChangedCtx *ctx,
+                          McpServer      *server)
+{
+    gint64 deadline;
+
+    mcp_in_process_transport_new_pair (NULL, NULL, &ctx->client_t, &ctx->server_t);
+
+    mcp_server_set_transport (server, MCP_TRANSPORT (ctx->server_t));
+    mcp_server_start_async (server, NULL, NULL, NULL);
+
+    ctx->client = mcp_client_new ("test-client", "1.0");
+    mcp_client_set_transport (ctx->client, MCP_TRANSPORT (ctx->client_t));
+    g_signal_connect (ctx->client, "tools-changed", G_CALLBACK (on_list_changed),
+                      &ctx->tools_changed);
+    g_signal_connect (ctx->client, "resources-changed", G_CALLBACK (on_list_changed),
+                      &ctx->resources_changed);
+    g_signal_connect (ctx->client, "prompts-changed", G_CALLBACK (on_list_changed),
+                      &ctx->prompts_changed);
+    mcp_client_connect_async (ctx->client, NULL, NULL, NULL);
+
+    deadline = g_get_monotonic_time () + 3 * G_USEC_PER_SEC;
+    while (mcp_session_get_state (MCP_SESSION (ctx->client)) != MCP_SESSION_STATE_READY &&
+           g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (mcp_session_get_state (MCP_SESSION (ctx->client)), ==,
+                     MCP_SESSION_STATE_READY);
+}
+
+/* Runs the main loop for @msec milliseconds */
+static void
+pump_for (guint msec)
+{
+    gint64 deadline = g_get_monotonic_time () + msec * 1000;
+
+    while (g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+        g_usleep (1000);
+    }
+}
+
+static void
+list_changed_ctx_clear (ListChangedCtx *ctx)
+{
+    g_clear_object (&ctx->client);
+    g_clear_object (&ctx->client_t);
+    g_clear_object (&ctx->server_t);
+}
+
+/*
+ * Creates a server with a read-only tool @reader and a tool @writer
+ * that leaves its annotations unset, so it counts as destructive.
+ */
+static McpServer *
+two_tool_server_new (const gchar    *reader,
+                     McpToolHandler  reader_handler,
+                     gpointer        reader_data,
+                     const gchar    *writer,
+                     McpToolHandler  writer_handler,
+                     gpointer        writer_data)
+{
+    McpServer *server;
+    g_autoptr(McpTool) read_tool = NULL;
+    g_autoptr(McpTool) write_tool = NULL;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+
+    read_tool = mcp_tool_new (reader, "Reads");
+    mcp_tool_set_read_only_hint (read_tool, TRUE);
+    mcp_server_add_tool (server, read_tool, reader_handler, reader_data, NULL);
+
+    write_tool = mcp_tool_new (writer, "Writes");
+    mcp_server_add_tool (server, write_tool, writer_handler, writer_data, NULL);
+
+    return server;
+}
+
+static void
+test_server_update_list_changed (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(McpServerUpdate) update = NULL;
+    g_autoptr(McpPrompt) prompt = NULL;
+    ListChangedCtx ctx = { 0, };
+    gint i;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    list_changed_ctx_connect (&ctx, server);
+
+    update = mcp_server_update_new ();
+    for (i = 0; i < 10; i++)
+    {
+        g_autofree gchar *name = g_strdup_printf ("plugin-tool-%d", i);
+        g_autoptr(McpTool) tool = mcp_tool_new (name, "Plugin tool");
+
+        mcp_server_update_add_tool (update, tool, NULL, NULL, NULL);
+    }
+    prompt = mcp_prompt_new ("plugin-prompt", "Plugin prompt");
+    mcp_server_update_add_prompt (update, prompt, NULL, NULL, NULL);
+    /* Removing something that is not there changes nothing */
+    mcp_server_update_remove_resource (update, "file:///missing");
+    mcp_server_commit_update (server, update);
+
+    pump_for (100);
+
+    /* One notification per list, however many entries changed */
+    g_assert_cmpint (ctx.tools_changed, ==, 1);
+    g_assert_cmpint (ctx.prompts_changed, ==, 1);
+    g_assert_cmpint (ctx.resources_changed, ==, 0);
+
+    list_changed_ctx_clear (&ctx);
+}
+
+/* ========================================================================== */
+/* Bulk registration and list_changed coalescing tests                        */
+/* ========================================================================== */
+
+static McpToolResult *
+shared_tool_handler (McpServer   *server,
+                     const gchar *name,
+                     JsonObject  *arguments,
+                     gpointer     user_data)
+{
+    McpToolResult *result;
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, name);
+    return result;
+}
+
+static void
+count_destroy (gpointer user_data)
+{
+    gint *count = user_data;
+
+    (*count)++;
+}
+
+static void
+test_server_add_tools (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(GPtrArray) tools = NULL;
+    g_autoptr(McpToolResult) result = NULL;
+    g_autoptr(GError) error = NULL;
+    gint destroyed = 0;
+    gint i;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+
+    tools = g_ptr_array_new_with_free_func (g_object_unref);
+    for (i = 0; i < 50; i++)
+    {
+        g_autofree gchar *name = g_strdup_printf ("tool-%d", i);
+
+        g_ptr_array_add (tools, mcp_tool_new (name, "Bulk tool"));
+    }
+
+    mcp_server_add_tools (server, tools, shared_tool_handler, &destroyed, count_destroy);
+    g_assert_cmpuint (count_list (mcp_server_list_tools (server)), ==, 50);
+    g_assert_true (mcp_server_capabilities_get_tools (mcp_server_get_capabilities (server)));
+
+    result = mcp_server_invoke_tool (server, "tool-17", NULL, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (result);
+
+    /* The shared user data goes with the last tool using it */
+    for (i = 0; i < 49; i++)
+    {
+        g_autofree gchar *name = g_strdup_printf ("tool-%d", i);
+
+        g_assert_true (mcp_server_remove_tool (server, name));
+    }
+    g_assert_cmpint (destroyed, ==, 0);
+    g_assert_true (mcp_server_remove_tool (server, "tool-49"));
+    g_assert_cmpint (destroyed, ==, 1);
+}
+
+static GList *
+shared_resource_handler (McpServer   *server,
+                         const gchar *uri,
+                         gpointer     user_data)
+{
+    return g_list_append (NULL, mcp_resource_contents_new_text (uri, uri, "text/plain"));
+}
+
+static void
+test_server_list_changed_coalesced (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(GPtrArray) resources = NULL;
+    ListChangedCtx ctx = { 0, };
+    gint i;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    list_changed_ctx_connect (&ctx, server);
+
+    resources = g_ptr_array_new_with_free_func (g_object_unref);
+    for (i = 0; i < 200; i++)
+    {
+        g_autofree gchar *uri = g_strdup_printf ("mem:///item/%d", i);
+        g_autofree gchar *name = g_strdup_printf ("item %d", i);
+
+        g_ptr_array_add (resources, mcp_resource_new (uri, name));
+    }
+
+    /* A plugin registering 200 resources and notifying after each one
+     * still costs the client a single re-list */
+    mcp_server_add_resources (server, resources, shared_resource_handler, NULL, NULL);
+    for (i = 0; i < 200; i++)
+    {
+        mcp_server_notify_resources_changed (server);
+    }
+    mcp_server_notify_tools_changed (server);
+
+    pump_for (100);
+    g_assert_cmpuint (count_list (mcp_server_list_resources (server)), ==, 200);
+    g_assert_cmpint (ctx.resources_changed, ==, 1);
+    g_assert_cmpint (ctx.tools_changed, ==, 1);
+    g_assert_cmpint (ctx.prompts_changed, ==, 0);
+
+    list_changed_ctx_clear (&ctx);
+}
+
+static void
+test_server_list_changed_window (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    ListChangedCtx ctx = { 0, };
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    mcp_server_set_list_changed_delay (server, 200);
+    g_assert_cmpuint (mcp_server_get_list_changed_delay (server), ==, 200);
+    list_changed_ctx_connect (&ctx, server);
+
+    /* Changes spread over several main loop iterations share the window */
+    mcp_server_notify_tools_changed (server);
+    pump_for (20);
+    mcp_server_notify_tools_changed (server);
+    pump_for (20);
+    mcp_server_notify_tools_changed (server);
+    g_assert_cmpint (ctx.tools_changed, ==, 0);
+
+    pump_for (400);
+    g_assert_cmpint (ctx.tools_changed, ==, 1);
+
+    /* The next change opens a new window */
+    mcp_server_notify_tools_changed (server);
+    pump_for (400);
+    g_assert_cmpint (ctx.tools_changed, ==, 2);
+
+    list_changed_ctx_clear (&ctx);
+}
+
+/* ========================================================================== */
+/* Cross-thread call tests                                                    */
+/* ========================================================================== */
+
+#define PRODUCER_THREADS 8
+#define LOGS_PER_PRODUCER 250
+
+typedef struct
+{
+    McpServer *server;
+    gint       index;
+} ProducerArgs;
+
+typedef struct
+{
+    gint received;
+    gint next_seq[PRODUCER_THREADS];
+    gint out_of_order;
+} LogCtx;
+
+static gpointer
+producer_thread (gpointer user_data)
+{
+    ProducerArgs *args = user_data;
+    g_autofree gchar *logger = g_strdup_printf ("producer-%d", args->index);
+    gint i;
+
+    for (i = 0; i < LOGS_PER_PRODUCER; i++)
+    {
+        g_autoptr(JsonNode) data = json_node_new (JSON_NODE_VALUE);
+
+        json_node_set_int (data, i);
+        mcp_server_emit_log (args->server, MCP_LOG_LEVEL_INFO, logger, data);
+        mcp_server_send_progress (args->server, logger, (gdouble) i / LOGS_PER_PRODUCER, -1);
+    }
+
+    /* Unknown task: queued, then dropped quietly on the server's context */
+    g_assert_true (mcp_server_complete_task (args->server, "no-such-task",
+                                             mcp_tool_result_new (FALSE), NULL));
+
+    return NULL;
+}
+
+static void
+on_log_message (McpClient   *client,
+                const gchar *level,
+                const gchar *logger,
+                JsonNode    *data,
+                gpointer     user_data)
+{
+    LogCtx *log = user_data;
+    gint index;
+
+    g_assert_true (g_str_has_prefix (logger, "producer-"));
+    index = atoi (logger + strlen ("producer-"));
+    g_assert_cmpint (index, >=, 0);
+    g_assert_cmpint (index, <, PRODUCER_THREADS);
+
+    /* Each thread's calls arrive in the order it made them */
+    if (json_node_get_int (data) != log->next_seq[index])
+    {
+        log->out_of_order++;
+    }
+    log->next_seq[index] = json_node_get_int (data) + 1;
+    log->received++;
+}
+
+static void
+test_server_cross_thread_stress (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    ListChangedCtx ctx = { 0, };
+    LogCtx log = { 0, };
+    ProducerArgs args[PRODUCER_THREADS];
+    GThread *threads[PRODUCER_THREADS];
+    gint64 deadline;
+    gint i;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    mcp_server_capabilities_set_logging (mcp_server_get_capabilities (server), TRUE);
+    list_changed_ctx_connect (&ctx, server);
+    g_signal_connect (ctx.client, "log-message", G_CALLBACK (on_log_message), &log);
+
+    for (i = 0; i < PRODUCER_THREADS; i++)
+    {
+        args[i].server = server;
+        args[i].index = i;
+        threads[i] = g_thread_new ("producer", producer_thread, &args[i]);
+    }
+
+    /* The server's context keeps dispatching while the producers run */
+    deadline = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+    while (log.received < PRODUCER_THREADS * LOGS_PER_PRODUCER &&
+           g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+
+    for (i = 0; i < PRODUCER_THREADS; i++)
+    {
+        g_thread_join (threads[i]);
+    }
+    pump_for (50);
+
+    g_assert_cmpint (log.received, ==, PRODUCER_THREADS * LOGS_PER_PRODUCER);
+    g_assert_cmpint (log.out_of_order, ==, 0);
+    for (i = 0; i < PRODUCER_THREADS; i++)
+    {
+        g_assert_cmpint (log.next_seq[i], ==, LOGS_PER_PRODUCER);
+    }
+
+    list_changed_ctx_clear (&ctx);
+}
+
+/* ========================================================================== */
+/* Annotation-aware tool scheduling tests                                     */
+/* ========================================================================== */
+
+typedef struct
+{
+    gint running;       /* handlers running now */
+    gint max_running;
+    gint calls;         /* handler invocations */
+    gint overlapped;    /* destructive calls that saw another call running */
+} SchedulingCtx;
+
+static void
+scheduling_enter (SchedulingCtx *sched)
+{
+    gint running = g_atomic_int_add (&sched->running, 1) + 1;
+    gint max;
+
+    g_atomic_int_inc (&sched->calls);
+    do
+    {
+        max = g_atomic_int_get (&sched->max_running);
+    }
+    while (running > max &&
+           !g_atomic_int_compare_and_exchange (&sched->max_running, max, running));
+}
+
+static McpToolResult *
+slow_read_handler (McpServer   *server,
+                   const gchar *name,
+                   JsonObject  *arguments,
+                   gpointer     user_data)
+{
+    SchedulingCtx *sched = user_data;
+    McpToolResult *result;
+
+    scheduling_enter (sched);
+    g_usleep (50 * 1000);
+    g_atomic_int_add (&sched->running, -1);
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, json_object_get_string_member (arguments, "path"));
+    return result;
+}
+
+static McpToolResult *
+slow_write_handler (McpServer   *server,
+                    const gchar *name,
+                    JsonObject  *arguments,
+                    gpointer     user_data)
+{
+    SchedulingCtx *sched = user_data;
+
+    scheduling_enter (sched);
+    if (g_atomic_int_get (&sched->running) != 1)
+    {
+        g_atomic_int_inc (&sched->overlapped);
+    }
+    g_usleep (30 * 1000);
+    if (g_atomic_int_get (&sched->running) != 1)
+    {
+        g_atomic_int_inc (&sched->overlapped);
+    }
+    g_atomic_int_add (&sched->running, -1);
+
+    return mcp_tool_result_new (FALSE);
+}
+
+typedef struct
+{
+    gint     pending;
+    GString *texts;
+} CallsCtx;
+
+static void
+on_scheduled_call_done (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+    CallsCtx *calls = user_data;
+    g_autoptr(McpToolResult) tool_result = NULL;
+    g_autoptr(GError) error = NULL;
+    JsonArray *content;
+
+    tool_result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (tool_result);
+
+    content = mcp_tool_result_get_content (tool_result);
+    if (json_array_get_length (content) > 0)
+    {
+        JsonObject *item = json_array_get_object_element (content, 0);
+
+        g_string_append_printf (calls->texts, "%s;",
+                                json_object_get_string_member (item, "text"));
+    }
+    calls->pending--;
+}
+
+static void
+call_with_path (McpClient   *client,
+                const gchar *tool,
+                const gchar *path,
+                CallsCtx    *calls)
+{
+    g_autoptr(JsonObject) args = json_object_new ();
+
+    json_object_set_string_member (args, "path", path);
+    calls->pending++;
+    mcp_client_call_tool_async (client, tool, args, NULL, on_scheduled_call_done, calls);
+}
+
+static void
+wait_for_calls (CallsCtx *calls)
+{
+    gint64 deadline = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+
+    while (calls->pending > 0 && g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (calls->pending, ==, 0);
+}
+
+static void
+test_server_concurrent_tools_read_only (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    ListChangedCtx ctx = { 0, };
+    SchedulingCtx readers = { 0, };
+    SchedulingCtx writers = { 0, };
+    CallsCtx calls = { 0, g_string_new (NULL) };
+    gint i;
+
+    server = two_tool_server_new ("read", slow_read_handler, &readers,
+                                  "write", slow_write_handler, &writers);
+    mcp_server_set_concurrent_tools (server, TRUE);
+    g_assert_true (mcp_server_get_concurrent_tools (server));
+    list_changed_ctx_connect (&ctx, server);
+
+    for (i = 0; i < 4; i++)
+    {
+        g_autofree gchar *path = g_strdup_printf ("/file/%d", i);
+
+        call_with_path (ctx.client, "read", path, &calls);
+    }
+    wait_for_calls (&calls);
+
+    /* Read-only handlers overlapped on the worker pool */
+    g_assert_cmpint (readers.calls, ==, 4);
+    g_assert_cmpint (readers.max_running, >, 1);
+
+    g_string_free (calls.texts, TRUE);
+    list_changed_ctx_clear (&ctx);
+}
+
+/* Counts both kinds of call in one place, to check they exclude each other */
+static McpToolResult *
+mixed_handler (McpServer   *server,
+               const gchar *name,
+               JsonObject  *arguments,
+               gpointer     user_data)
+{
+    if (g_str_equal (name, "write"))
+    {
+        return slow_write_handler (server, name, arguments, user_data);
+    }
+    return slow_read_handler (server, name, arguments, user_data);
+}
+
+static void
+test_server_concurrent_tools_destructive (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(McpTool) read = NULL;
+    g_autoptr(McpTool) write = NULL;
+    ListChangedCtx ctx = { 0, };
+    SchedulingCtx sched = { 0, };
+    CallsCtx calls = { 0, g_string_new (NULL) };
+    gint i;
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    mcp_server_set_concurrent_tools (server, TRUE);
+    read = mcp_tool_new ("read", "Read a path");
+    mcp_tool_set_read_only_hint (read, TRUE);
+    mcp_server_add_tool (server, read, mixed_handler, &sched, NULL);
+    write = mcp_tool_new ("write", "Write a path");
+    mcp_server_add_tool (server, write, mixed_handler, &sched, NULL);
+    list_changed_ctx_connect (&ctx, server);
+
+    /* Writers interleaved with readers: a writer never overlaps anything */
+    for (i = 0; i < 12; i++)
+    {
+        g_autofree gchar *path = g_strdup_printf ("/file/%d", i);
+
+        call_with_path (ctx.client, i % 3 == 0 ? "write" : "read", path, &calls);
+    }
+    wait_for_calls (&calls);
+
+    g_assert_cmpint (sched.calls, ==, 12);
+    g_assert_cmpint (sched.overlapped, ==, 0);
+
+    g_string_free (calls.texts, TRUE);
+    list_changed_ctx_clear (&ctx);
+}
+
+static gchar *
+path_key_func (McpServer   *server,
+               const gchar *name,
+               JsonObject  *arguments,
+               gpointer     user_data)
+{
+    return g_strdup (json_object_get_string_member (arguments, "path"));
+}
+
+static void
+test_server_concurrent_tools_key (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    ListChangedCtx ctx = { 0, };
+    SchedulingCtx readers = { 0, };
+    SchedulingCtx writers = { 0, };
+    CallsCtx calls = { 0, g_string_new (NULL) };
+
+    server = two_tool_server_new ("read", slow_read_handler, &readers,
+                                  "write", slow_write_handler, &writers);
+    mcp_server_set_concurrent_tools (server, TRUE);
+    mcp_server_set_tool_key_func (server, path_key_func, NULL, NULL);
+    list_changed_ctx_connect (&ctx, server);
+
+    /* Writes to different paths run side by side */
+    call_with_path (ctx.client, "write", "/a", &calls);
+    call_with_path (ctx.client, "write", "/b", &calls);
+    wait_for_calls (&calls);
+    g_assert_cmpint (writers.calls, ==, 2);
+    g_assert_cmpint (writers.max_running, ==, 2);
+
+    /* Writes to the same path do not */
+    writers.max_running = 0;
+    call_with_path (ctx.client, "write", "/a", &calls);
+    call_with_path (ctx.client, "write", "/a", &calls);
+    call_with_path (ctx.client, "write", "/a", &calls);
+    wait_for_calls (&calls);
+    g_assert_cmpint (writers.calls, ==, 5);
+    g_assert_cmpint (writers.max_running, ==, 1);
+
+    g_string_free (calls.texts, TRUE);
+    list_changed_ctx_clear (&ctx);
+}
+
+static guint
+count_text (GStrv        texts,
+            const gchar *text)
+{
+    guint count = 0;
+    guint i;
+
+    for (i = 0; texts[i] != NULL; i++)
+    {
+        if (g_str_equal (texts[i], text))
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void
+test_server_concurrent_tools_coalesced (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    ListChangedCtx ctx = { 0, };
+    SchedulingCtx readers = { 0, };
+    SchedulingCtx writers = { 0, };
+    CallsCtx calls = { 0, g_string_new (NULL) };
+    gint i;
+
+    server = two_tool_server_new ("read", slow_read_handler, &readers,
+                                  "write", slow_write_handler, &writers);
+    mcp_server_set_concurrent_tools (server, TRUE);
+    list_changed_ctx_connect (&ctx, server);
+
+    /* Identical calls in flight together share one invocation */
+    for (i = 0; i < 5; i++)
+    {
+        call_with_path (ctx.client, "read", "/hot", &calls);
+    }
+    call_with_path (ctx.client, "read", "/cold", &calls);
+    wait_for_calls (&calls);
+
+    g_assert_cmpint (readers.calls, ==, 2);
+    {
+        g_auto(GStrv) texts = g_strsplit (calls.texts->str, ";", -1);
+
+        /* Every caller got the result, whichever call finished first */
+        g_assert_cmpuint (g_strv_length (texts), ==, 7);
+        g_assert_cmpuint (count_text (texts, "/hot"), ==, 5);
+        g_assert_cmpuint (count_text (texts, "/cold"), ==, 1);
+    }
+
+    /* Once it has replied, the same call runs again */
+    call_with_path (ctx.client, "read", "/hot", &calls);
+    wait_for_calls (&calls);
+    g_assert_cmpint (readers.calls, ==, 3);
+
+    g_string_free (calls.texts, TRUE);
+    list_changed_ctx_clear (&ctx);
+}
+
+/* ========================================================================== */
+/* Read coalescing tests                                                      */
+/* ========================================================================== */
+
+#define READ_SESSIONS 3
+
+static GList *
+counting_resource_handler (McpServer   *server,
+                           const gchar *uri,
+                           gpointer     user_data)
+{
+    gint *calls = user_data;
+
+    (*calls)++;
+    return g_list_append (NULL, mcp_resource_contents_new_text (uri, "shared config",
+                                                                "text/plain"));
+}
+
+typedef struct
+{
+    gint pending;
+    gint matched;
+} ReadsCtx;
+
+static void
+on_coalesced_read_done (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+    ReadsCtx *reads = user_data;
+    g_autoptr(GError) error = NULL;
+    GList *contents;
+
+    contents = mcp_client_read_resource_finish (MCP_CLIENT (source), result, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (contents);
+
+    if (g_strcmp0 (mcp_resource_contents_get_text (contents->data), "shared config") == 0)
+    {
+        reads->matched++;
+    }
+    reads->pending--;
+
+    g_list_free_full (contents, (GDestroyNotify) mcp_resource_contents_unref);
+}
+
+static void
+wait_for_reads (ReadsCtx *reads)
+{
+    gint64 deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+
+    while (reads->pending > 0 && g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (reads->pending, ==, 0);
+}
+
+static void
+test_server_read_group (void)
+{
+    g_autoptr(McpReadGroup) group = NULL;
+    McpServer *servers[READ_SESSIONS];
+    ListChangedCtx ctx[READ_SESSIONS];
+    ReadsCtx reads = { 0, };
+    gint handler_calls = 0;
+    gint i;
+
+    group = mcp_read_group_new ();
+    g_assert_cmpuint (mcp_read_group_get_coalesced_reads (group), ==, 0);
+
+    /* Sessions set up alike, so the handler and its data match */
+    for (i = 0; i < READ_SESSIONS; i++)
+    {
+        g_autoptr(McpResource) resource = NULL;
+
+        servers[i] = mcp_server_new ("test-server", "1.0.0");
+        mcp_server_set_read_group (servers[i], group);
+        g_assert_true (mcp_server_get_read_group (servers[i]) == group);
+
+        resource = mcp_resource_new ("config://shared", "Shared config");
+        mcp_server_add_resource (servers[i], resource, counting_resource_handler,
+                                 &handler_calls, NULL);
+
+        memset (&ctx[i], 0, sizeof (ctx[i]));
+        list_changed_ctx_connect (&ctx[i], servers[i]);
+    }
+
+    /* Every session reads the hot URI twice before the server runs */
+    for (i = 0; i < READ_SESSIONS * 2; i++)
+    {
+        reads.pending++;
+        mcp_client_read_resource_async (ctx[i % READ_SESSIONS].client, "config://shared",
+                                        NULL, on_coalesced_read_done, &reads);
+    }
+    wait_for_reads (&reads);
+
+    g_assert_cmpint (handler_calls, ==, 1);
+    g_assert_cmpint (reads.matched, ==, READ_SESSIONS * 2);
+    g_assert_cmpuint (mcp_read_group_get_coalesced_reads (group), ==, READ_SESSIONS * 2 - 1);
+
+    /* A read after the flight has landed runs the handler again */
+    reads.pending++;
+    mcp_client_read_resource_async (ctx[0].client, "config://shared",
+                                    NULL, on_coalesced_read_done, &reads);
+    wait_for_reads (&reads);
+    g_assert_cmpint (handler_calls, ==, 2);
+
+    for (i = 0; i < READ_SESSIONS; i++)
+    {
+        list_changed_ctx_clear (&ctx[i]);
+        g_object_unref (servers[i]);
+    }
+}
+
+/* ========================================================================== */
+/* Tool result cache tests                                                    */
+/* ========================================================================== */
+
+static McpToolResult *
+counting_tool_handler (McpServer   *server,
+                       const gchar *name,
+                       JsonObject  *arguments,
+                       gpointer     user_data)
+{
+    gint *calls = user_data;
+    g_autofree gchar *text = NULL;
+    McpToolResult *result;
+
+    (*calls)++;
+    text = g_strdup_printf ("call %d", *calls);
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, text);
+    return result;
+}
+
+static void
+call_with_args (McpClient   *client,
+                const gchar *tool,
+                JsonObject  *args,
+                CallsCtx    *calls)
+{
+    calls->pending++;
+    mcp_client_call_tool_async (client, tool, args, NULL, on_scheduled_call_done, calls);
+    wait_for_calls (calls);
+}
+
+static void
+test_server_tool_cache (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(JsonObject) args = NULL;
+    g_autoptr(JsonObject) reordered = NULL;
+    ListChangedCtx ctx = { 0, };
+    CallsCtx calls = { 0, g_string_new (NULL) };
+    gint lookups = 0;
+    gint writes = 0;
+    guint64 hits;
+    guint64 misses;
+
+    server = two_tool_server_new ("lookup", counting_tool_handler, &lookups,
+                                  "write", counting_tool_handler, &writes);
+    mcp_server_set_tool_cache (server, 0, 64 * 1024);
+    list_changed_ctx_connect (&ctx, server);
+
+    args = json_object_new ();
+    json_object_set_string_member (args, "path", "/a");
+    json_object_set_int_member (args, "depth", 1);
+    call_with_args (ctx.client, "lookup", args, &calls);
+    call_with_args (ctx.client, "lookup", args, &calls);
+    g_assert_cmpint (lookups, ==, 1);
+
+    /* Member order and number spelling do not matter */
+    reordered = json_object_new ();
+    json_object_set_double_member (reordered, "depth", 1.0);
+    json_object_set_string_member (reordered, "path", "/a");
+    call_with_args (ctx.client, "lookup", reordered, &calls);
+    g_assert_cmpint (lookups, ==, 1);
+    g_assert_cmpstr (calls.texts->str, ==, "call 1;call 1;call 1;");
+
+    g_assert_true (mcp_server_get_tool_cache_stats (server, "lookup", &hits, &misses));
+    g_assert_cmpuint (hits, ==, 2);
+    g_assert_cmpuint (misses, ==, 1);
+    g_assert_cmpuint (mcp_server_get_tool_cache_size (server), >, 0);
+
+    /* A destructive tool runs every time */
+    call_with_args (ctx.client, "write", args, &calls);
+    call_with_args (ctx.client, "write", args, &calls);
+    g_assert_cmpint (writes, ==, 2);
+    g_assert_false (mcp_server_get_tool_cache_stats (server, "write", NULL, NULL));
+
+    /* Invalidating runs the handler again */
+    mcp_server_invalidate_tool_result (server, "lookup", reordered);
+    call_with_args (ctx.client, "lookup", args, &calls);
+    g_assert_cmpint (lookups, ==, 2);
+
+    mcp_server_invalidate_tool_results (server, "lookup");
+    g_assert_cmpuint (mcp_server_get_tool_cache_size (server), ==, 0);
+    call_with_args (ctx.client, "lookup", args, &calls);
+    call_with_args (ctx.client, "lookup", args, &calls);
+    g_assert_cmpint (lookups, ==, 3);
+
+    /* Disabling the cache drops results and statistics */
+    mcp_server_set_tool_cache (server, 0, 0);
+    g_assert_false (mcp_server_get_tool_cache_stats (server, "lookup", NULL, NULL));
+    call_with_args (ctx.client, "lookup", args, &calls);
+    g_assert_cmpint (lookups, ==, 4);
+
+    g_string_free (calls.texts, TRUE);
+    list_changed_ctx_clear (&ctx);
+}
+
+static void
+test_server_tool_cache_bounds (void)
+{
+    g_autoptr(McpServer) server = NULL;
+    ListChangedCtx ctx = { 0, };
+    CallsCtx calls = { 0, g_string_new (NULL) };
+    gint lookups = 0;
+    gint writes = 0;
+    gint i;
+
+    server = two_tool_server_new ("lookup", counting_tool_handler, &lookups,
+                                  "write", counting_tool_handler, &writes);
+    mcp_server_set_tool_cache (server, 0, 1024);
+    list_changed_ctx_connect (&ctx, server);
+
+    /* Far more distinct calls than fit: the oldest are evicted */
+    for (i = 0; i < 50; i++)
+    {
+        g_autoptr(JsonObject) args = json_object_new ();
+
+        json_object_set_int_member (args, "n", i);
+        call_with_args (ctx.client, "lookup", args, &calls);
+        g_assert_cmpuint (mcp_server_get_tool_cache_size (server), <=, 1024);
+    }
+    g_assert_cmpint (lookups, ==, 50);
+    g_assert_cmpuint (mcp_server_get_tool_cache_size (server), >, 0);
+
+    {
+        g_autoptr(JsonObject) first = json_object_new ();
+        g_autoptr(JsonObject) last = json_object_new ();
+
+        json_object_set_int_member (first, "n", 0);
+        json_object_set_int_member (last, "n", 49);
+        call_with_args (ctx.client, "lookup", last, &calls);
+        g_assert_cmpint (lookups, ==, 50);
+        call_with_args (ctx.client, "lookup", first, &calls);
+        g_assert_cmpint (lookups, ==, 51);
+    }
+
+    /* Results expire after the TTL */
+    mcp_server_set_tool_cache (server, 100, 1024);
+    {
+        g_autoptr(JsonObject) args = json_object_new ();
+
+        json_object_set_string_member (args, "path", "/ttl");
+        call_with_args (ctx.client, "lookup", args, &calls);
+        call_with_args (ctx.client, "lookup", args, &calls);
+        g_assert_cmpint (lookups, ==, 52);
+
+        g_usleep (150 * 1000);
+        call_with_args (ctx.client, "lookup", args, &calls);
+        g_assert_cmpint (lookups, ==, 53);
+    }
+
+    g_string_free (calls.texts, TRUE);
+    list_changed_ctx_clear (&ctx);
+}
+
+/* ========================================================================== */
+/* Rate limiting tests                                                        */
+/* ========================================================================== */
+
+typedef struct
+{
+    gint pending;
+    gint accepted;
+    gint limited;
+    gint unknown;
+} RateCtx;
+
+static void
+on_rate_limited_call_done (GObject      *source,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+    RateCtx *rate = user_data;
+    g_autoptr(McpToolResult) tool_result = NULL;
+    g_autoptr(GError) error = NULL;
+
+    tool_result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &error);
+    if (tool_result != NULL)
+    {
+        rate->accepted++;
+    }
+    else
+    {
+        g_assert_error (error, MCP_ERROR, MCP_ERROR_RATE_LIMITED);
+        rate->limited++;
+    }
+    rate->pending--;
+}
+
+/* Calls @tool @count times and waits for every reply */
+static void
+call_rate_limited (McpClient   *client,
+                   const gchar *tool,
+                   gint         count,
+                   RateCtx     *rate)
+{
+    gint64 deadline;
+    gint i;
+
+    for (i = 0; i < count; i++)
+    {
+        rate->pending++;
+        mcp_client_call_tool_async (client, tool, NULL, NULL,
+                                    on_rate_limited_call_done, rate);
+    }
+
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    while (rate->pending > 0 && g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (rate->pending, ==, 0);
+}
+
+static void
+on_rate_limited_read_done (GObject      *source,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+    RateCtx *rate = user_data;
+    g_autoptr(GError) error = NULL;
+    GList *contents;
+
+    contents = mcp_client_read_resource_finish (MCP_CLIENT (source), result, &error);
+    if (contents != NULL)
+    {
+        rate->accepted++;
+        g_list_free_full (contents, (GDestroyNotify) mcp_resource_contents_unref);
+    }
+    else if (g_error_matches (error, MCP_ERROR, MCP_ERROR_RATE_LIMITED))
+    {
+        rate->limited++;
+    }
+    else
+    {
+        g_assert_error (error, MCP_ERROR, MCP_ERROR_INVALID_PARAMS);
+        rate->unknown++;
+    }
+    rate->pending--;
+}
+
+/* Reads @uri @count times and waits for every reply */
+static void
+read_rate_limited (McpClient   *client,
+                   const gchar *uri,
+                   gint         count,
+                   RateCtx     *rate)
+{
+    gint64 deadline;
+    gint i;
+
+    for (i = 0; i < count; i++)
+    {
+        rate->pending++;
+        mcp_client_read_resource_async (client, uri, NULL,
+                                        on_rate_limited_read_done, rate);
+    }
+
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    while (rate->pending > 0 && g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (rate->pending, ==, 0);
+}
+
+/* The tools "search" and "echo", plus a resource also named "search" */
+static McpServer *
+rate_server_new (McpRateLimiter *limiter,
+                 gint           *calls,
+                 gint           *reads)
+{
+    McpServer *server;
+    g_autoptr(McpResource) resource = NULL;
+
+    server = two_tool_server_new ("search", counting_tool_handler, calls,
+                                  "echo", counting_tool_handler, calls);
+    mcp_server_set_rate_limiter (server, limiter);
+    g_assert_true (mcp_server_get_rate_limiter (server) == limiter);
+
+    resource = mcp_resource_new ("search", "search");
+    mcp_server_add_resource (server, resource, counting_resource_handler, reads, NULL);
+
+    return server;
+}
+
+static void
+test_server_rate_limit_session (void)
+{
+    g_autoptr(McpRateLimiter) limiter = NULL;
+    g_autoptr(McpServer) server = NULL;
+    ListChangedCtx ctx = { 0, };
+    RateCtx rate = { 0, };
+    gint calls = 0;
+    gint reads = 0;
+
+    /* Three calls at once, then one every 100 ms */
+    limiter = mcp_rate_limiter_new ();
+    mcp_rate_limiter_set_session_limit (limiter, 10.0, 3);
+    server = rate_server_new (limiter, &calls, &reads);
+    list_changed_ctx_connect (&ctx, server);
+
+    /* The session limit covers every tool */
+    call_rate_limited (ctx.client, "search", 2, &rate);
+    call_rate_limited (ctx.client, "echo", 3, &rate);
+    g_assert_cmpint (rate.accepted, ==, 3);
+    g_assert_cmpint (rate.limited, ==, 2);
+    g_assert_cmpint (calls, ==, 3);
+    g_assert_cmpuint (mcp_rate_limiter_get_rejected (limiter), ==, 2);
+
+    /* Refused calls took no tokens, so the bucket refills on time */
+    g_usleep (250 * 1000);
+    call_rate_limited (ctx.client, "echo", 2, &rate);
+    g_assert_cmpint (rate.accepted, ==, 5);
+
+    /* Removing the limit lets everything through */
+    mcp_rate_limiter_set_session_limit (limiter, 0, 0);
+    call_rate_limited (ctx.client, "echo", 10, &rate);
+    g_assert_cmpint (rate.accepted, ==, 15);
+
+    list_changed_ctx_clear (&ctx);
+}
+
+static void
+test_server_rate_limit_tool (void)
+{
+    g_autoptr(McpRateLimiter) limiter = NULL;
+    g_autoptr(McpServer) server_a = NULL;
+    g_autoptr(McpServer) server_b = NULL;
+    ListChangedCtx ctx_a = { 0, };
+    ListChangedCtx ctx_b = { 0, };
+    RateCtx rate_a = { 0, };
+    RateCtx rate_b = { 0, };
+    gint calls = 0;
+    gint reads = 0;
+
+    /* Slow enough not to refill while the test runs */
+    limiter = mcp_rate_limiter_new ();
+    mcp_rate_limiter_set_tool_limit (limiter, "search", 0.01, 2);
+    mcp_rate_limiter_set_session_tool_limit (limiter, NULL, 0.01, 4);
+    server_a = rate_server_new (limiter, &calls, &reads);
+    server_b = rate_server_new (limiter, &calls, &reads);
+    list_changed_ctx_connect (&ctx_a, server_a);
+    list_changed_ctx_connect (&ctx_b, server_b);
+
+    /* The tool limit is shared by both sessions */
+    call_rate_limited (ctx_a.client, "search", 1, &rate_a);
+    call_rate_limited (ctx_b.client, "search", 2, &rate_b);
+    g_assert_cmpint (rate_a.accepted, ==, 1);
+    g_assert_cmpint (rate_b.accepted, ==, 1);
+    g_assert_cmpint (rate_b.limited, ==, 1);
+
+    /* Other tools only have the per-session limit */
+    call_rate_limited (ctx_a.client, "echo", 5, &rate_a);
+    call_rate_limited (ctx_b.client, "echo", 5, &rate_b);
+    g_assert_cmpint (rate_a.accepted, ==, 5);
+    g_assert_cmpint (rate_a.limited, ==, 1);
+    g_assert_cmpint (rate_b.accepted, ==, 5);
+    g_assert_cmpint (rate_b.limited, ==, 2);
+    g_assert_cmpint (calls, ==, 10);
+
+    /* Tool limits leave the resource of the same name alone */
+    read_rate_limited (ctx_a.client, "search", 3, &rate_a);
+    g_assert_cmpint (rate_a.accepted, ==, 8);
+    g_assert_cmpint (reads, ==, 3);
+
+    list_changed_ctx_clear (&ctx_a);
+    list_changed_ctx_clear (&ctx_b);
+}
+
+static void
+test_server_rate_limit_resource (void)
+{
+    g_autoptr(McpRateLimiter) limiter = NULL;
+    g_autoptr(McpServer) server_a = NULL;
+    g_autoptr(McpServer) server_b = NULL;
+    ListChangedCtx ctx_a = { 0, };
+    ListChangedCtx ctx_b = { 0, };
+    RateCtx rate_a = { 0, };
+    RateCtx rate_b = { 0, };
+    gint calls = 0;
+    gint reads = 0;
+
+    limiter = mcp_rate_limiter_new ();
+    mcp_rate_limiter_set_resource_limit (limiter, "search", 0.01, 3);
+    mcp_rate_limiter_set_session_resource_limit (limiter, NULL, 0.01, 2);
+    server_a = rate_server_new (limiter, &calls, &reads);
+    server_b = rate_server_new (limiter, &calls, &reads);
+    list_changed_ctx_connect (&ctx_a, server_a);
+    list_changed_ctx_connect (&ctx_b, server_b);
+
+    /* Reads of unknown URIs are refused before they take a token */
+    read_rate_limited (ctx_a.client, "file:///missing", 5, &rate_a);
+    g_assert_cmpint (rate_a.unknown, ==, 5);
+    g_assert_cmpint (rate_a.limited, ==, 0);
+    g_assert_cmpuint (mcp_rate_limiter_get_rejected (limiter), ==, 0);
+
+    /* Each session gets two reads; the resource three in total */
+    read_rate_limited (ctx_a.client, "search", 3, &rate_a);
+    g_assert_cmpint (rate_a.accepted, ==, 2);
+    g_assert_cmpint (rate_a.limited, ==, 1);
+    read_rate_limited (ctx_b.client, "search", 2, &rate_b);
+    g_assert_cmpint (rate_b.accepted, ==, 1);
+    g_assert_cmpint (rate_b.limited, ==, 1);
+    g_assert_cmpint (reads, ==, 3);
+
+    /* Resource limits leave the tool of the same name alone */
+    call_rate_limited (ctx_a.client, "search", 4, &rate_a);
+    g_assert_cmpint (rate_a.accepted, ==, 6);
+    g_assert_cmpint (calls, ==, 4);
+
+    list_changed_ctx_clear (&ctx_a);
+    list_changed_ctx_clear (&ctx_b);
+}
+
 /* ========================================================================== */
 /* main                                                                       */
 /* ========================================================================== */
@@ -490,7 +1956,43 @@ main (int   argc,
     g_test_add_func ("/mcp/server/add-resource-template", test_server_add_resource_template);
     g_test_add_func ("/mcp/server/add-prompt", test_server_add_prompt);
     g_test_add_func ("/mcp/server/multiple-entities", test_server_multiple_entities);
+    g_test_add_func ("/mcp/server/idle", test_server_idle);
     g_test_add_func ("/mcp/server/session-state", test_server_session_state);
 
+    /* Registry update tests */
+    g_test_add_func ("/mcp/server/update/commit", test_server_update_commit);
+    g_test_add_func ("/mcp/server/update/in-flight", test_server_update_in_flight);
+    g_test_add_func ("/mcp/server/update/from-threads", test_server_update_from_threads);
+    g_test_add_func ("/mcp/server/update/list-changed", test_server_update_list_changed);
+
+    /* Bulk registration and list_changed coalescing tests */
+    g_test_add_func ("/mcp/server/add-tools", test_server_add_tools);
+    g_test_add_func ("/mcp/server/list-changed/coalesced", test_server_list_changed_coalesced);
+    g_test_add_func ("/mcp/server/list-changed/window", test_server_list_changed_window);
+
+    /* Cross-thread call tests */
+    g_test_add_func ("/mcp/server/cross-thread/stress", test_server_cross_thread_stress);
+
+    /* Annotation-aware tool scheduling tests */
+    g_test_add_func ("/mcp/server/concurrent-tools/read-only",
+                     test_server_concurrent_tools_read_only);
+    g_test_add_func ("/mcp/server/concurrent-tools/destructive",
+                     test_server_concurrent_tools_destructive);
+    g_test_add_func ("/mcp/server/concurrent-tools/key", test_server_concurrent_tools_key);
+    g_test_add_func ("/mcp/server/concurrent-tools/coalesced",
+                     test_server_concurrent_tools_coalesced);
+
+    /* Read coalescing tests */
+    g_test_add_func ("/mcp/server/read-group", test_server_read_group);
+
+    /* Tool result cache tests */
+    g_test_add_func ("/mcp/server/tool-cache", test_server_tool_cache);
+    g_test_add_func ("/mcp/server/tool-cache/bounds", test_server_tool_cache_bounds);
+
+    /* Rate limiting tests */
+    g_test_add_func ("/mcp/server/rate-limit/session", test_server_rate_limit_session);
+    g_test_add_func ("/mcp/server/rate-limit/tool", test_server_rate_limit_tool);
+    g_test_add_func ("/mcp/server/rate-limit/resource", test_server_rate_limit_resource);
+
     return g_test_run ();
 }
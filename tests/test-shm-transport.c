@@ -0,0 +1,461 @@
+/*
+ * test-shm-transport.c - Tests for McpShmTransport
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "mcp.h"
+
+/* ── helpers ───────────────────────────────────────────────────────── */
+
+static gchar *
+make_test_socket_path (const gchar *test_name)
+{
+    return g_strdup_printf ("%s/mcp-test-shm-%s-%d.sock",
+                            g_get_user_runtime_dir (),
+                            test_name,
+                            (gint) getpid ());
+}
+
+static McpToolResult *
+echo_tool_handler (McpServer   *server,
+                   const gchar *name,
+                   JsonObject  *arguments,
+                   gpointer     user_data)
+{
+    McpToolResult *result;
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, json_object_get_string_member (arguments, "text"));
+    return result;
+}
+
+#define BLOB_URI  "test://blob"
+#define BLOB_SIZE (256 * 1024)
+
+/* Fills a memfd with a pattern the reader can check */
+static GList *
+blob_resource_handler (McpServer   *server,
+                       const gchar *uri,
+                       gpointer     user_data)
+{
+    g_autofree guint8 *data = NULL;
+    gint fd;
+    gsize i;
+
+    data = g_malloc (BLOB_SIZE);
+    for (i = 0; i < BLOB_SIZE; i++)
+    {
+        data[i] = (guint8) (i * 7);
+    }
+
+    fd = memfd_create ("test-blob", MFD_CLOEXEC);
+    g_assert_cmpint (fd, >=, 0);
+    g_assert_cmpint (write (fd, data, BLOB_SIZE), ==, BLOB_SIZE);
+
+    return g_list_append (NULL, mcp_resource_contents_new_from_fd (uri, fd,
+                                                                   "application/octet-stream"));
+}
+
+static void
+assert_blob_bytes (GBytes *bytes)
+{
+    const guint8 *data;
+    gsize len;
+    gsize i;
+
+    data = g_bytes_get_data (bytes, &len);
+    g_assert_cmpuint (len, ==, BLOB_SIZE);
+    for (i = 0; i < len; i++)
+    {
+        g_assert_cmpuint (data[i], ==, (guint8) (i * 7));
+    }
+}
+
+typedef struct
+{
+    McpServer *last_server;
+    gint       created;
+    gint       closed;
+} SessionCtx;
+
+static void
+on_session_created (McpUnixSocketServer *socket_server,
+                    McpServer           *server,
+                    gpointer             user_data)
+{
+    SessionCtx *ctx = user_data;
+    g_autoptr(McpTool) echo = NULL;
+
+    g_autoptr(McpResource) blob = NULL;
+
+    echo = mcp_tool_new ("echo", "Echo the text argument");
+    mcp_server_add_tool (server, echo, echo_tool_handler, NULL, NULL);
+
+    blob = mcp_resource_new (BLOB_URI, "blob");
+    mcp_server_add_resource (server, blob, blob_resource_handler, NULL, NULL);
+
+    ctx->last_server = server;
+    ctx->created++;
+}
+
+static void
+on_session_closed (McpUnixSocketServer *socket_server,
+                   McpServer           *server,
+                   gpointer             user_data)
+{
+    SessionCtx *ctx = user_data;
+
+    ctx->closed++;
+}
+
+static McpUnixSocketServer *
+start_server (const gchar *path,
+              guint        ring_size,
+              SessionCtx  *ctx)
+{
+    McpUnixSocketServer *server;
+    g_autoptr(GError) error = NULL;
+
+    server = mcp_unix_socket_server_new ("test-server", "1.0", path);
+    mcp_unix_socket_server_set_shm_ring_size (server, ring_size);
+    g_signal_connect (server, "session-created", G_CALLBACK (on_session_created), ctx);
+    g_signal_connect (server, "session-closed", G_CALLBACK (on_session_closed), ctx);
+
+    g_assert_true (mcp_unix_socket_server_start (server, &error));
+    g_assert_no_error (error);
+
+    return server;
+}
+
+static McpClient *
+connect_client (McpTransport *transport)
+{
+    McpClient *client;
+    gint64 deadline;
+
+    client = mcp_client_new ("test-client", "1.0");
+    mcp_client_set_transport (client, transport);
+    mcp_client_connect_async (client, NULL, NULL, NULL);
+
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    while (mcp_session_get_state (MCP_SESSION (client)) != MCP_SESSION_STATE_READY &&
+           g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (mcp_session_get_state (MCP_SESSION (client)), ==,
+                     MCP_SESSION_STATE_READY);
+
+    return client;
+}
+
+typedef struct
+{
+    GMainLoop     *loop;
+    McpToolResult *result;
+    GError        *error;
+} CallCtx;
+
+static void
+on_call_done (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    CallCtx *cc = user_data;
+
+    cc->result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &cc->error);
+    g_main_loop_quit (cc->loop);
+}
+
+/* Calls the echo tool and checks the text comes back unchanged */
+static void
+assert_echo (McpClient   *client,
+             const gchar *text)
+{
+    g_autoptr(JsonObject) args = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    CallCtx cc = { NULL, NULL, NULL };
+    JsonNode *content;
+
+    args = json_object_new ();
+    json_object_set_string_member (args, "text", text);
+
+    loop = g_main_loop_new (NULL, FALSE);
+    cc.loop = loop;
+    mcp_client_call_tool_async (client, "echo", args, NULL, on_call_done, &cc);
+    g_main_loop_run (loop);
+
+    g_assert_no_error (cc.error);
+    g_assert_nonnull (cc.result);
+    content = json_array_get_element (mcp_tool_result_get_content (cc.result), 0);
+    g_assert_cmpstr (json_object_get_string_member (json_node_get_object (content), "text"),
+                     ==, text);
+    mcp_tool_result_unref (cc.result);
+}
+
+typedef struct
+{
+    GMainLoop *loop;
+    GList     *contents;
+    GError    *error;
+} ReadCtx;
+
+static void
+on_read_done (GObject      *source,
+              GAsyncResult *result,
+              gpointer      user_data)
+{
+    ReadCtx *rc = user_data;
+
+    rc->contents = mcp_client_read_resource_finish (MCP_CLIENT (source), result, &rc->error);
+    g_main_loop_quit (rc->loop);
+}
+
+/* Reads BLOB_URI; the caller frees the returned contents */
+static McpResourceContents *
+read_blob (McpClient *client)
+{
+    g_autoptr(GMainLoop) loop = NULL;
+    ReadCtx rc = { NULL, NULL, NULL };
+    McpResourceContents *contents;
+
+    loop = g_main_loop_new (NULL, FALSE);
+    rc.loop = loop;
+    mcp_client_read_resource_async (client, BLOB_URI, NULL, on_read_done, &rc);
+    g_main_loop_run (loop);
+
+    g_assert_no_error (rc.error);
+    g_assert_cmpuint (g_list_length (rc.contents), ==, 1);
+    contents = rc.contents->data;
+    g_list_free (rc.contents);
+
+    g_assert_cmpstr (mcp_resource_contents_get_mime_type (contents), ==,
+                     "application/octet-stream");
+    return contents;
+}
+
+/* ── tests ─────────────────────────────────────────────────────────── */
+
+static void
+test_shm_echo (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("echo");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpShmTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+    gint i;
+
+    server = start_server (path, MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE, &ctx);
+
+    transport = mcp_shm_transport_new_client (path);
+    g_assert_cmpuint (mcp_shm_transport_get_ring_size (transport), ==, 0);
+
+    client = connect_client (MCP_TRANSPORT (transport));
+    g_assert_cmpint (ctx.created, ==, 1);
+    g_assert_true (MCP_IS_SHM_TRANSPORT (mcp_server_get_transport (ctx.last_server)));
+    g_assert_cmpuint (mcp_shm_transport_get_ring_size (transport), ==,
+                      MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE);
+
+    for (i = 0; i < 50; i++)
+    {
+        g_autofree gchar *text = g_strdup_printf ("message %d", i);
+
+        assert_echo (client, text);
+    }
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_shm_large_message (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("large");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpShmTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autofree gchar *text = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+
+    /* Far bigger than the ring: the message is sent in fragments while
+     * the receiver frees space */
+    server = start_server (path, 4096, &ctx);
+    transport = mcp_shm_transport_new_client (path);
+    client = connect_client (MCP_TRANSPORT (transport));
+    g_assert_cmpuint (mcp_shm_transport_get_ring_size (transport), ==, 4096);
+
+    text = g_strnfill (200 * 1024, 'x');
+    assert_echo (client, text);
+    assert_echo (client, "small after large");
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_shm_stdio_client_still_served (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("stdio");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(GSocketClient) socket_client = NULL;
+    g_autoptr(GSocketAddress) address = NULL;
+    g_autoptr(GSocketConnection) connection = NULL;
+    g_autoptr(McpStdioTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autoptr(GError) error = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+
+    server = start_server (path, MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE, &ctx);
+
+    socket_client = g_socket_client_new ();
+    address = g_unix_socket_address_new (path);
+    connection = g_socket_client_connect (socket_client, G_SOCKET_CONNECTABLE (address),
+                                          NULL, &error);
+    g_assert_no_error (error);
+
+    transport = mcp_stdio_transport_new_with_streams (
+        g_io_stream_get_input_stream (G_IO_STREAM (connection)),
+        g_io_stream_get_output_stream (G_IO_STREAM (connection)));
+    client = connect_client (MCP_TRANSPORT (transport));
+
+    g_assert_true (MCP_IS_STDIO_TRANSPORT (mcp_server_get_transport (ctx.last_server)));
+    assert_echo (client, "plain");
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_shm_peer_close (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("close");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpShmTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+    gint64 deadline;
+
+    server = start_server (path, MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE, &ctx);
+    transport = mcp_shm_transport_new_client (path);
+    client = connect_client (MCP_TRANSPORT (transport));
+
+    mcp_transport_disconnect_async (MCP_TRANSPORT (transport), NULL, NULL, NULL);
+    g_assert_cmpint (mcp_transport_get_state (MCP_TRANSPORT (transport)), ==,
+                     MCP_TRANSPORT_STATE_DISCONNECTED);
+
+    /* The server notices through the socket and reaps the session */
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    while (ctx.closed == 0 && g_get_monotonic_time () < deadline)
+    {
+        g_main_context_iteration (NULL, FALSE);
+    }
+    g_assert_cmpint (ctx.closed, ==, 1);
+    g_assert_cmpuint (mcp_unix_socket_server_get_session_count (server), ==, 0);
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_shm_resource_fd (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("fd");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(McpShmTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autoptr(GMappedFile) mapped = NULL;
+    g_autoptr(GError) error = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+    gint i;
+
+    server = start_server (path, MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE, &ctx);
+    transport = mcp_shm_transport_new_client (path);
+    g_assert_true (mcp_transport_supports_fd_passing (MCP_TRANSPORT (transport)));
+    client = connect_client (MCP_TRANSPORT (transport));
+
+    /* Several reads in a row keep handles in step on both sides */
+    for (i = 0; i < 3; i++)
+    {
+        g_autoptr(McpResourceContents) contents = read_blob (client);
+        g_autoptr(GBytes) bytes = NULL;
+
+        g_assert_cmpint (mcp_resource_contents_get_fd (contents), >=, 0);
+        bytes = mcp_resource_contents_get_bytes (contents);
+        assert_blob_bytes (bytes);
+
+        if (i == 0)
+        {
+            mapped = mcp_resource_contents_get_mapped_file (contents, &error);
+            g_assert_no_error (error);
+        }
+    }
+
+    /* The mapping outlives the contents it came from */
+    g_assert_cmpuint (g_mapped_file_get_length (mapped), ==, BLOB_SIZE);
+    assert_echo (client, "still talking");
+
+    mcp_unix_socket_server_stop (server);
+}
+
+static void
+test_shm_resource_fd_fallback (void)
+{
+    g_autofree gchar *path = make_test_socket_path ("fd-fallback");
+    g_autoptr(McpUnixSocketServer) server = NULL;
+    g_autoptr(GSocketClient) socket_client = NULL;
+    g_autoptr(GSocketAddress) address = NULL;
+    g_autoptr(GSocketConnection) connection = NULL;
+    g_autoptr(McpStdioTransport) transport = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autoptr(McpResourceContents) contents = NULL;
+    g_autoptr(GBytes) bytes = NULL;
+    g_autoptr(GError) error = NULL;
+    SessionCtx ctx = { NULL, 0, 0 };
+
+    server = start_server (path, MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE, &ctx);
+
+    socket_client = g_socket_client_new ();
+    address = g_unix_socket_address_new (path);
+    connection = g_socket_client_connect (socket_client, G_SOCKET_CONNECTABLE (address),
+                                          NULL, &error);
+    g_assert_no_error (error);
+
+    transport = mcp_stdio_transport_new_with_streams (
+        g_io_stream_get_input_stream (G_IO_STREAM (connection)),
+        g_io_stream_get_output_stream (G_IO_STREAM (connection)));
+    g_assert_false (mcp_transport_supports_fd_passing (MCP_TRANSPORT (transport)));
+    client = connect_client (MCP_TRANSPORT (transport));
+
+    /* Without fd passing the same handler's data arrives as base64 */
+    contents = read_blob (client);
+    g_assert_cmpint (mcp_resource_contents_get_fd (contents), ==, -1);
+    g_assert_null (mcp_resource_contents_get_mapped_file (contents, &error));
+    g_assert_error (error, MCP_ERROR, MCP_ERROR_INVALID_PARAMS);
+    bytes = mcp_resource_contents_get_bytes (contents);
+    assert_blob_bytes (bytes);
+
+    mcp_unix_socket_server_stop (server);
+}
+
+int
+main (int argc, char *argv[])
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/mcp/shm/echo", test_shm_echo);
+    g_test_add_func ("/mcp/shm/large-message", test_shm_large_message);
+    g_test_add_func ("/mcp/shm/stdio-client-still-served",
+                     test_shm_stdio_client_still_served);
+    g_test_add_func ("/mcp/shm/peer-close", test_shm_peer_close);
+    g_test_add_func ("/mcp/shm/resource-fd", test_shm_resource_fd);
+    g_test_add_func ("/mcp/shm/resource-fd-fallback", test_shm_resource_fd_fallback);
+
+    return g_test_run ();
+}
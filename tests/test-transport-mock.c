@@ -8,9 +8,15 @@
 #define MCP_COMPILATION
 #include "mcp-transport.h"
 #include "mcp-stdio-transport.h"
+#include "mcp-server.h"
 #include "mcp-error.h"
 #undef MCP_COMPILATION
 
+#include <glib-unix.h>
+#include <gio/gunixinputstream.h>
+#include <string.h>
+#include <unistd.h>
+
 /* ========================================================================== */
 /* Mock Transport Implementation                                              */
 /* ========================================================================== */
@@ -450,6 +456,66 @@ test_transport_send_not_connected (TransportFixture *fixture,
     g_assert_error (fixture->error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED);
 }
 
+static void
+send_raw_cb (GObject      *source,
+             GAsyncResult *result,
+             gpointer      user_data)
+{
+    TransportFixture *fixture = user_data;
+
+    fixture->callback_called = TRUE;
+    fixture->success = mcp_transport_send_raw_finish (MCP_TRANSPORT (source),
+                                                      result,
+                                                      &fixture->error);
+    g_main_loop_quit (fixture->loop);
+}
+
+static void
+test_transport_send_raw_fallback (TransportFixture *fixture,
+                                  gconstpointer     user_data)
+{
+    static const gchar raw[] = "{\"jsonrpc\":\"2.0\",\"method\":\"ping\",\"id\":7}";
+    g_autoptr(GBytes) bytes = NULL;
+    g_autoptr(JsonNode) sent = NULL;
+    JsonObject *obj;
+
+    mcp_transport_connect_async (MCP_TRANSPORT (fixture->transport),
+                                 NULL, connect_cb, fixture);
+    g_main_loop_run (fixture->loop);
+    g_assert_true (fixture->success);
+
+    fixture->callback_called = FALSE;
+    fixture->success = FALSE;
+
+    /* The mock has no send_raw, so the bytes are parsed and sent as a node */
+    bytes = g_bytes_new_static (raw, sizeof (raw) - 1);
+    mcp_transport_send_raw_async (MCP_TRANSPORT (fixture->transport),
+                                  bytes, NULL, send_raw_cb, fixture);
+    g_main_loop_run (fixture->loop);
+
+    g_assert_true (fixture->callback_called);
+    g_assert_true (fixture->success);
+    g_assert_no_error (fixture->error);
+
+    sent = test_mock_transport_pop_sent (fixture->transport);
+    g_assert_nonnull (sent);
+    obj = json_node_get_object (sent);
+    g_assert_cmpstr (json_object_get_string_member (obj, "method"), ==, "ping");
+    g_assert_cmpint (json_object_get_int_member (obj, "id"), ==, 7);
+
+    /* Bytes that are not JSON fail without reaching the transport */
+    fixture->callback_called = FALSE;
+    g_clear_pointer (&bytes, g_bytes_unref);
+    bytes = g_bytes_new_static ("{not json", 9);
+    mcp_transport_send_raw_async (MCP_TRANSPORT (fixture->transport),
+                                  bytes, NULL, send_raw_cb, fixture);
+    g_main_loop_run (fixture->loop);
+
+    g_assert_false (fixture->success);
+    g_assert_error (fixture->error, MCP_ERROR, MCP_ERROR_PARSE_ERROR);
+    g_assert_cmpuint (test_mock_transport_get_sent_count (fixture->transport), ==, 0);
+}
+
 /* State change signal test */
 
 static void
@@ -760,6 +826,246 @@ test_stdio_transport_send (StdioFixture  *fixture,
     }
 }
 
+/* ========================================================================== */
+/* Write Queue Tests                                                          */
+/* ========================================================================== */
+
+static void
+test_write_queue_lanes (void)
+{
+    McpWriteQueue *queue;
+
+    queue = mcp_write_queue_new ();
+    g_assert_true (mcp_write_queue_is_empty (queue));
+    g_assert_null (mcp_write_queue_pop (queue));
+
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_LOW, "log 1");
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_NORMAL, "status 1");
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_LOW, "log 2");
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_HIGH, "response 1");
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_HIGH, "response 2");
+    g_assert_cmpuint (mcp_write_queue_get_length (queue), ==, 5);
+
+    /* Highest lane first, each lane in the order it was filled */
+    g_assert_cmpstr (mcp_write_queue_peek (queue), ==, "response 1");
+    g_assert_cmpstr (mcp_write_queue_pop (queue), ==, "response 1");
+    g_assert_cmpstr (mcp_write_queue_pop (queue), ==, "response 2");
+    g_assert_cmpstr (mcp_write_queue_pop (queue), ==, "status 1");
+    g_assert_cmpstr (mcp_write_queue_pop (queue), ==, "log 1");
+    g_assert_cmpstr (mcp_write_queue_pop (queue), ==, "log 2");
+    g_assert_true (mcp_write_queue_is_empty (queue));
+
+    mcp_write_queue_free (queue, NULL);
+}
+
+static void
+test_write_queue_starvation (void)
+{
+    McpWriteQueue *queue;
+    gint log_position = -1;
+    gint i;
+
+    queue = mcp_write_queue_new ();
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_LOW, "log");
+    for (i = 0; i < 4 * MCP_WRITE_QUEUE_MAX_PASSED; i++)
+    {
+        mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_HIGH, "response");
+    }
+
+    /* Responses keep coming, but the log line is not held back forever */
+    for (i = 0; !mcp_write_queue_is_empty (queue); i++)
+    {
+        const gchar *item = mcp_write_queue_pop (queue);
+
+        if (g_str_equal (item, "log"))
+        {
+            log_position = i;
+        }
+    }
+    g_assert_cmpint (log_position, ==, MCP_WRITE_QUEUE_MAX_PASSED);
+
+    mcp_write_queue_free (queue, NULL);
+}
+
+static void
+test_write_queue_free_items (void)
+{
+    McpWriteQueue *queue;
+
+    queue = mcp_write_queue_new ();
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_HIGH, g_strdup ("a"));
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_LOW, g_strdup ("b"));
+    mcp_write_queue_clear (queue, g_free);
+    g_assert_true (mcp_write_queue_is_empty (queue));
+
+    mcp_write_queue_push (queue, MCP_MESSAGE_PRIORITY_NORMAL, g_strdup ("c"));
+    mcp_write_queue_free (queue, g_free);
+}
+
+static McpToolResult *
+progress_tool_handler (McpServer   *server,
+                       const gchar *name,
+                       JsonObject  *arguments,
+                       gpointer     user_data)
+{
+    McpToolResult *result;
+    gint i;
+
+    for (i = 1; i <= 3; i++)
+    {
+        mcp_server_send_progress (server, "tok", i, 3);
+    }
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, "done");
+    return result;
+}
+
+/* Finds the response to @id among @lines */
+static gint
+find_response (gchar       **lines,
+               const gchar  *id)
+{
+    g_autofree gchar *needle = g_strdup_printf ("\"id\":\"%s\",\"result\"", id);
+    gint i;
+
+    for (i = 0; lines[i] != NULL; i++)
+    {
+        if (strstr (lines[i], needle) != NULL)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void
+test_write_queue_response_after_progress (void)
+{
+    static const gchar requests[] =
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":"
+        "{\"capabilities\":{},\"clientInfo\":{\"name\":\"test\",\"version\":\"1.0\"}}}\n"
+        "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}\n"
+        "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/call\",\"params\":"
+        "{\"name\":\"slow\",\"_meta\":{\"progressToken\":\"tok\"}}}\n"
+        "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"ping\"}\n";
+    g_autoptr(McpServer) server = NULL;
+    g_autoptr(McpTool) tool = NULL;
+    g_autoptr(McpStdioTransport) transport = NULL;
+    g_autoptr(GInputStream) input = NULL;
+    g_autoptr(GOutputStream) output = NULL;
+    g_autoptr(GError) error = NULL;
+    g_auto(GStrv) lines = NULL;
+    g_autofree gchar *text = NULL;
+    gint last_progress = -1;
+    gint n_progress = 0;
+    gint response;
+    gint64 deadline;
+    gint fds[2];
+    gint i;
+
+    /* The pipe stays open, so the server does not see end of input */
+    g_assert_true (g_unix_open_pipe (fds, FD_CLOEXEC, &error));
+    g_assert_no_error (error);
+    g_assert_cmpint (write (fds[1], requests, sizeof requests - 1), ==, sizeof requests - 1);
+
+    input = g_unix_input_stream_new (fds[0], TRUE);
+    output = g_memory_output_stream_new_resizable ();
+    transport = mcp_stdio_transport_new_with_streams (input, output);
+
+    server = mcp_server_new ("test-server", "1.0.0");
+    tool = mcp_tool_new ("slow", "Reports progress");
+    mcp_server_add_tool (server, tool, progress_tool_handler, NULL, NULL);
+    mcp_server_set_transport (server, MCP_TRANSPORT (transport));
+    mcp_server_start_async (server, NULL, NULL, NULL);
+
+    deadline = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+    do
+    {
+        g_main_context_iteration (NULL, FALSE);
+        g_clear_pointer (&lines, g_strfreev);
+        g_free (text);
+        text = g_strndup (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (output)),
+                          g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (output)));
+        lines = g_strsplit (text, "\n", -1);
+    }
+    while ((find_response (lines, "2") < 0 || find_response (lines, "3") < 0) &&
+           g_get_monotonic_time () < deadline);
+
+    /* The handler queued its progress while the first write was in
+     * flight; its response still comes after every notification */
+    response = find_response (lines, "2");
+    g_assert_cmpint (response, >=, 0);
+    for (i = 0; lines[i] != NULL; i++)
+    {
+        if (strstr (lines[i], "\"notifications/progress\"") != NULL)
+        {
+            last_progress = i;
+            n_progress++;
+        }
+    }
+    g_assert_cmpint (n_progress, ==, 3);
+    g_assert_cmpint (last_progress, <, response);
+    g_assert_cmpint (find_response (lines, "3"), >=, 0);
+
+    close (fds[1]);
+}
+
+static McpMessagePriority
+classify_raw (const gchar *json)
+{
+    g_autoptr(GBytes) bytes = g_bytes_new_static (json, strlen (json));
+
+    return mcp_transport_classify_raw (bytes);
+}
+
+static void
+test_transport_classify (void)
+{
+    g_autoptr(JsonNode) node = NULL;
+    g_autoptr(GError) error = NULL;
+
+    /* Responses, errors and requests */
+    g_assert_cmpint (classify_raw ("{\"jsonrpc\":\"2.0\",\"id\":\"1\",\"result\":{}}"),
+                     ==, MCP_MESSAGE_PRIORITY_HIGH);
+    g_assert_cmpint (classify_raw ("{\"jsonrpc\":\"2.0\",\"id\":1,"
+                                   "\"error\":{\"code\":-32601,\"message\":\"x\"}}"),
+                     ==, MCP_MESSAGE_PRIORITY_HIGH);
+    g_assert_cmpint (classify_raw ("{\"id\":7,\"method\":\"ping\"}"),
+                     ==, MCP_MESSAGE_PRIORITY_HIGH);
+
+    /* Notifications, with nested values and strings to skip first */
+    g_assert_cmpint (classify_raw ("{\"params\":{\"progressToken\":\"a,}\\\"\",\"n\":[1,{}]},"
+                                   " \"method\" : \"notifications/progress\"}"),
+                     ==, MCP_MESSAGE_PRIORITY_LOW);
+    g_assert_cmpint (classify_raw ("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/message\"}"),
+                     ==, MCP_MESSAGE_PRIORITY_LOW);
+    g_assert_cmpint (classify_raw ("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/tasks/status\"}"),
+                     ==, MCP_MESSAGE_PRIORITY_NORMAL);
+
+    /* Later requests must not overtake these */
+    g_assert_cmpint (classify_raw ("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/cancelled\","
+                                   "\"params\":{\"requestId\":\"4\"}}"),
+                     ==, MCP_MESSAGE_PRIORITY_HIGH);
+    g_assert_cmpint (classify_raw ("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}"),
+                     ==, MCP_MESSAGE_PRIORITY_HIGH);
+
+    /* Anything unexpected is not held back */
+    g_assert_cmpint (classify_raw ("[1,2]"), ==, MCP_MESSAGE_PRIORITY_HIGH);
+    g_assert_cmpint (classify_raw ("{\"method\":"), ==, MCP_MESSAGE_PRIORITY_HIGH);
+
+    node = json_from_string ("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\"}",
+                             &error);
+    g_assert_no_error (error);
+    g_assert_cmpint (mcp_transport_classify_message (node), ==, MCP_MESSAGE_PRIORITY_LOW);
+    g_clear_pointer (&node, json_node_unref);
+
+    node = json_from_string ("{\"jsonrpc\":\"2.0\",\"id\":\"3\",\"result\":{}}", &error);
+    g_assert_no_error (error);
+    g_assert_cmpint (mcp_transport_classify_message (node), ==, MCP_MESSAGE_PRIORITY_HIGH);
+}
+
 /* ========================================================================== */
 /* Main                                                                       */
 /* ========================================================================== */
@@ -807,6 +1113,12 @@ main (int   argc,
                 test_transport_send_not_connected,
                 transport_fixture_teardown);
 
+    g_test_add ("/transport/mock/send-raw-fallback",
+                TransportFixture, NULL,
+                transport_fixture_setup,
+                test_transport_send_raw_fallback,
+                transport_fixture_teardown);
+
     g_test_add ("/transport/mock/state-signal",
                 TransportFixture, NULL,
                 transport_fixture_setup,
@@ -825,6 +1137,14 @@ main (int   argc,
                 test_transport_error_signal,
                 transport_fixture_teardown);
 
+    /* Write queue tests */
+    g_test_add_func ("/transport/write-queue/lanes", test_write_queue_lanes);
+    g_test_add_func ("/transport/write-queue/starvation", test_write_queue_starvation);
+    g_test_add_func ("/transport/write-queue/free-items", test_write_queue_free_items);
+    g_test_add_func ("/transport/write-queue/response-after-progress",
+                     test_write_queue_response_after_progress);
+    g_test_add_func ("/transport/classify", test_transport_classify);
+
     /* Stdio transport tests */
     g_test_add_func ("/transport/stdio/new", test_stdio_transport_new);
     g_test_add_func ("/transport/stdio/with-streams", test_stdio_transport_with_streams);
@@ -6,8 +6,12 @@
  */
 
 #include <glib.h>
+#include <glib-unix.h>
 #include <gio/gio.h>
 #include <gio/gunixsocketaddress.h>
+#include <gio/gunixinputstream.h>
+#include <gio/gunixoutputstream.h>
+#include <sys/socket.h>
 #include <string.h>
 #include <unistd.h>
 #include "mcp.h"
@@ -483,6 +487,72 @@ test_unix_socket_server_multiple_sessions (void)
 	mcp_unix_socket_server_stop (server);
 }
 
+/*
+ * on_session_created_group:
+ *
+ * Records the read group of each new session.
+ */
+static void
+on_session_created_group (
+	McpUnixSocketServer *unix_server,
+	McpServer           *mcp_server,
+	gpointer             user_data
+){
+	GPtrArray *groups;
+
+	(void)unix_server;
+
+	groups = (GPtrArray *)user_data;
+	g_ptr_array_add (groups, mcp_server_get_read_group (mcp_server));
+}
+
+static void
+test_unix_socket_server_coalesce_reads (void)
+{
+	g_autofree gchar *path = NULL;
+	g_autoptr(McpUnixSocketServer) server = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GSocketConnection) conn1 = NULL;
+	g_autoptr(GSocketConnection) conn2 = NULL;
+	g_autoptr(GPtrArray) groups = NULL;
+	guint64 coalesced = 99;
+
+	path = make_test_socket_path ("coalesce");
+	server = mcp_unix_socket_server_new ("test", "1.0.0", path);
+	groups = g_ptr_array_new ();
+
+	g_assert_false (mcp_unix_socket_server_get_coalesce_reads (server));
+	mcp_unix_socket_server_set_coalesce_reads (server, TRUE);
+	g_assert_true (mcp_unix_socket_server_get_coalesce_reads (server));
+
+	g_signal_connect (server, "session-created",
+	                  G_CALLBACK (on_session_created_group), groups);
+
+	g_assert_true (mcp_unix_socket_server_start (server, &error));
+	g_assert_no_error (error);
+
+	conn1 = connect_client (path, &error);
+	g_assert_no_error (error);
+	spin_mainloop ();
+
+	conn2 = connect_client (path, &error);
+	g_assert_no_error (error);
+	spin_mainloop ();
+
+	/* Both sessions were put in the same group before the signal */
+	g_assert_cmpuint (groups->len, ==, 2);
+	g_assert_nonnull (g_ptr_array_index (groups, 0));
+	g_assert_true (g_ptr_array_index (groups, 0) ==
+	               g_ptr_array_index (groups, 1));
+
+	g_object_get (G_OBJECT (server), "coalesced-reads", &coalesced, NULL);
+	g_assert_cmpuint (coalesced, ==, 0);
+	g_assert_cmpuint (mcp_unix_socket_server_get_coalesced_reads (server),
+	                  ==, 0);
+
+	mcp_unix_socket_server_stop (server);
+}
+
 static void
 test_unix_socket_server_instructions_applied (void)
 {
@@ -691,6 +761,257 @@ test_unix_socket_server_connect_disconnect_race (void)
 	mcp_unix_socket_server_stop (server);
 }
 
+/* ============================================================================
+ * Stream Backend Tests
+ *
+ * Sessions run McpStdioTransport over the accepted socket, which goes
+ * through io_uring when mcp_uring_is_available() and through GIO
+ * otherwise.  These check NDJSON framing end to end on whichever
+ * backend is active: many small messages, one much larger than a
+ * receive buffer, and both directions.
+ * ========================================================================== */
+
+#define FRAMING_COUNT     200
+#define FRAMING_BIG_SIZE  (256 * 1024)
+
+typedef struct
+{
+	gint       received;
+	gint       next_id;
+	gboolean   saw_big;
+	gint       sent;
+} FramingCtx;
+
+static void
+on_framing_message (
+	McpTransport *transport,
+	JsonNode     *message,
+	gpointer      user_data
+){
+	FramingCtx  *ctx;
+	JsonObject  *obj;
+
+	(void)transport;
+
+	ctx = (FramingCtx *)user_data;
+	obj = json_node_get_object (message);
+
+	if (json_object_has_member (obj, "big"))
+	{
+		g_assert_cmpuint (strlen (json_object_get_string_member (obj, "big")),
+		                  ==, FRAMING_BIG_SIZE);
+		ctx->saw_big = TRUE;
+	}
+	else
+	{
+		/* Order is preserved across batched writes */
+		g_assert_cmpint (json_object_get_int_member (obj, "id"), ==,
+		                 ctx->next_id);
+		ctx->next_id++;
+	}
+
+	ctx->received++;
+}
+
+static void
+on_framing_connected (
+	GObject      *source,
+	GAsyncResult *result,
+	gpointer      user_data
+){
+	g_autoptr(GError) error = NULL;
+
+	mcp_transport_connect_finish (MCP_TRANSPORT (source), result, &error);
+	g_assert_no_error (error);
+	(*(gint *)user_data)++;
+}
+
+static void
+on_framing_sent (
+	GObject      *source,
+	GAsyncResult *result,
+	gpointer      user_data
+){
+	g_autoptr(GError) error = NULL;
+
+	mcp_transport_send_message_finish (MCP_TRANSPORT (source), result,
+	                                   &error);
+	g_assert_no_error (error);
+	((FramingCtx *)user_data)->sent++;
+}
+
+static gboolean
+on_framing_timeout (gpointer user_data)
+{
+	g_assert_not_reached ();
+	return G_SOURCE_REMOVE;
+}
+
+static void
+send_framing_messages (
+	McpTransport *transport,
+	FramingCtx   *ctx
+){
+	g_autofree gchar *big = NULL;
+	gint i;
+
+	for (i = 0; i < FRAMING_COUNT; i++)
+	{
+		g_autoptr(JsonBuilder) builder = json_builder_new ();
+		g_autoptr(JsonNode) node = NULL;
+
+		json_builder_begin_object (builder);
+		json_builder_set_member_name (builder, "id");
+		json_builder_add_int_value (builder, i);
+		json_builder_end_object (builder);
+		node = json_builder_get_root (builder);
+
+		mcp_transport_send_message_async (transport, node, NULL,
+		                                  on_framing_sent, ctx);
+
+		if (i == FRAMING_COUNT / 2)
+		{
+			g_autoptr(JsonBuilder) big_builder = json_builder_new ();
+			g_autoptr(JsonNode) big_node = NULL;
+
+			big = g_malloc (FRAMING_BIG_SIZE + 1);
+			memset (big, 'x', FRAMING_BIG_SIZE);
+			big[FRAMING_BIG_SIZE] = '\0';
+
+			json_builder_begin_object (big_builder);
+			json_builder_set_member_name (big_builder, "big");
+			json_builder_add_string_value (big_builder, big);
+			json_builder_end_object (big_builder);
+			big_node = json_builder_get_root (big_builder);
+
+			mcp_transport_send_message_async (transport, big_node, NULL,
+			                                  on_framing_sent, ctx);
+		}
+	}
+}
+
+/*
+ * run_framing_test:
+ *
+ * Connects a transport on each end and sends the test messages from
+ * @a to @b and from @b to @a at the same time.
+ */
+static void
+run_framing_test (
+	McpStdioTransport *a,
+	McpStdioTransport *b
+){
+	FramingCtx to_b = { 0, 0, FALSE, 0 };
+	FramingCtx to_a = { 0, 0, FALSE, 0 };
+	gint connected = 0;
+	guint timeout_id;
+
+	g_signal_connect (b, "message-received",
+	                  G_CALLBACK (on_framing_message), &to_b);
+	g_signal_connect (a, "message-received",
+	                  G_CALLBACK (on_framing_message), &to_a);
+
+	mcp_transport_connect_async (MCP_TRANSPORT (a), NULL,
+	                             on_framing_connected, &connected);
+	mcp_transport_connect_async (MCP_TRANSPORT (b), NULL,
+	                             on_framing_connected, &connected);
+	while (connected < 2)
+		g_main_context_iteration (NULL, TRUE);
+
+	g_assert_cmpint (mcp_stdio_transport_get_uses_io_uring (a), ==,
+	                 mcp_uring_is_available ());
+	g_assert_cmpint (mcp_stdio_transport_get_uses_io_uring (b), ==,
+	                 mcp_uring_is_available ());
+
+	send_framing_messages (MCP_TRANSPORT (a), &to_b);
+	send_framing_messages (MCP_TRANSPORT (b), &to_a);
+
+	timeout_id = g_timeout_add_seconds (10, on_framing_timeout, NULL);
+	while (to_b.received < FRAMING_COUNT + 1 ||
+	       to_a.received < FRAMING_COUNT + 1 ||
+	       to_b.sent < FRAMING_COUNT + 1 ||
+	       to_a.sent < FRAMING_COUNT + 1)
+		g_main_context_iteration (NULL, TRUE);
+	g_source_remove (timeout_id);
+
+	g_assert_true (to_b.saw_big);
+	g_assert_true (to_a.saw_big);
+
+	g_signal_handlers_disconnect_by_data (a, &to_a);
+	g_signal_handlers_disconnect_by_data (b, &to_b);
+}
+
+static void
+test_unix_socket_server_framing_socket (void)
+{
+	g_autoptr(GSocket) sock_a = NULL;
+	g_autoptr(GSocket) sock_b = NULL;
+	g_autoptr(GSocketConnection) conn_a = NULL;
+	g_autoptr(GSocketConnection) conn_b = NULL;
+	g_autoptr(McpStdioTransport) a = NULL;
+	g_autoptr(McpStdioTransport) b = NULL;
+	g_autoptr(GError) error = NULL;
+	gint fds[2];
+
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0,
+	                             fds), ==, 0);
+	sock_a = g_socket_new_from_fd (fds[0], &error);
+	g_assert_no_error (error);
+	sock_b = g_socket_new_from_fd (fds[1], &error);
+	g_assert_no_error (error);
+
+	conn_a = g_socket_connection_factory_create_connection (sock_a);
+	conn_b = g_socket_connection_factory_create_connection (sock_b);
+
+	a = mcp_stdio_transport_new_with_streams (
+		g_io_stream_get_input_stream (G_IO_STREAM (conn_a)),
+		g_io_stream_get_output_stream (G_IO_STREAM (conn_a)));
+	b = mcp_stdio_transport_new_with_streams (
+		g_io_stream_get_input_stream (G_IO_STREAM (conn_b)),
+		g_io_stream_get_output_stream (G_IO_STREAM (conn_b)));
+
+	run_framing_test (a, b);
+}
+
+static void
+test_unix_socket_server_framing_pipe (void)
+{
+	g_autoptr(GInputStream) in_a = NULL;
+	g_autoptr(GOutputStream) out_a = NULL;
+	g_autoptr(GInputStream) in_b = NULL;
+	g_autoptr(GOutputStream) out_b = NULL;
+	g_autoptr(McpStdioTransport) a = NULL;
+	g_autoptr(McpStdioTransport) b = NULL;
+	gint a_to_b[2];
+	gint b_to_a[2];
+
+	g_assert_cmpint (pipe (a_to_b), ==, 0);
+	g_assert_cmpint (pipe (b_to_a), ==, 0);
+
+	/*
+	 * io_uring only takes over blocking pipes.  GIO would block in
+	 * write() on one, and both ends live on this thread, so give the
+	 * GIO fallback non-blocking pipes instead.
+	 */
+	if (!mcp_uring_is_available ())
+	{
+		g_assert_true (g_unix_set_fd_nonblocking (a_to_b[0], TRUE, NULL));
+		g_assert_true (g_unix_set_fd_nonblocking (a_to_b[1], TRUE, NULL));
+		g_assert_true (g_unix_set_fd_nonblocking (b_to_a[0], TRUE, NULL));
+		g_assert_true (g_unix_set_fd_nonblocking (b_to_a[1], TRUE, NULL));
+	}
+
+	in_a  = g_unix_input_stream_new (b_to_a[0], TRUE);
+	out_a = g_unix_output_stream_new (a_to_b[1], TRUE);
+	in_b  = g_unix_input_stream_new (a_to_b[0], TRUE);
+	out_b = g_unix_output_stream_new (b_to_a[1], TRUE);
+
+	a = mcp_stdio_transport_new_with_streams (in_a, out_a);
+	b = mcp_stdio_transport_new_with_streams (in_b, out_b);
+
+	run_framing_test (a, b);
+}
+
 /* ============================================================================
  * Main
  * ========================================================================== */
@@ -743,6 +1064,8 @@ main (gint argc, gchar **argv)
 	                 test_unix_socket_server_session_count_after_connect);
 	g_test_add_func ("/mcp/unix-socket-server/session/multiple",
 	                 test_unix_socket_server_multiple_sessions);
+	g_test_add_func ("/mcp/unix-socket-server/session/coalesce-reads",
+	                 test_unix_socket_server_coalesce_reads);
 	g_test_add_func ("/mcp/unix-socket-server/session/instructions-applied",
 	                 test_unix_socket_server_instructions_applied);
 	g_test_add_func ("/mcp/unix-socket-server/session/stop-closes-all",
@@ -752,5 +1075,11 @@ main (gint argc, gchar **argv)
 	g_test_add_func ("/mcp/unix-socket-server/session/connect-disconnect-race",
 	                 test_unix_socket_server_connect_disconnect_race);
 
+	/* Stream backend tests */
+	g_test_add_func ("/mcp/unix-socket-server/framing/socket",
+	                 test_unix_socket_server_framing_socket);
+	g_test_add_func ("/mcp/unix-socket-server/framing/pipe",
+	                 test_unix_socket_server_framing_pipe);
+
 	return g_test_run ();
 }
@@ -290,6 +290,7 @@ test_websocket_server_transport_interface (void)
     g_assert_nonnull (iface->disconnect_finish);
     g_assert_nonnull (iface->send_message_async);
     g_assert_nonnull (iface->send_message_finish);
+    g_assert_nonnull (iface->send_raw_with_priority_async);
 }
 
 /* ============================================================================
@@ -0,0 +1,1473 @@
+/*
+ * mcp-broker.c - Persistent connection broker for MCP CLI tools
+ *
+ * Copyright (C) 2026 Copyleft Games
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * Keeps upstream MCP connections warm between CLI invocations.  Tools
+ * run with --broker connect to this daemon over a Unix socket, name the
+ * upstream they want in a one-line hello, and then speak plain NDJSON
+ * JSON-RPC.  The broker answers "initialize" from the upstream's cached
+ * handshake and forwards everything else with request IDs rewritten, so
+ * any number of short-lived CLI sessions share one upstream connection.
+ *
+ * The first CLI invocation with --broker starts the daemon; it exits on
+ * its own after --idle-timeout seconds without sessions.
+ *
+ * Usage:
+ *   mcp-broker [--socket PATH] [--idle-timeout SECONDS] [--daemon]
+ *   mcp-broker --status
+ *   mcp-broker --stop
+ */
+
+#include "mcp-common.h"
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ========================================================================== */
+/* Options                                                                     */
+/* ========================================================================== */
+
+static gchar    *opt_socket = NULL;
+static gint      opt_idle_timeout = 600;
+static gboolean  opt_daemon = FALSE;
+static gboolean  opt_status = FALSE;
+static gboolean  opt_stop = FALSE;
+
+static GOptionEntry broker_entries[] = {
+    { "socket", 0, 0, G_OPTION_ARG_FILENAME, &opt_socket,
+      "Listen on PATH (default: $XDG_RUNTIME_DIR/mcp-glib/broker.sock)", "PATH" },
+    { "idle-timeout", 0, 0, G_OPTION_ARG_INT, &opt_idle_timeout,
+      "Exit after SECONDS without sessions (default: 600)", "SECONDS" },
+    { "daemon", 'd', 0, G_OPTION_ARG_NONE, &opt_daemon,
+      "Detach from the controlling terminal", NULL },
+    { "status", 0, 0, G_OPTION_ARG_NONE, &opt_status,
+      "Print the running broker's upstreams and exit", NULL },
+    { "stop", 0, 0, G_OPTION_ARG_NONE, &opt_stop,
+      "Ask the running broker to exit", NULL },
+    { "license", 0, 0, G_OPTION_ARG_NONE, &mcp_cli_opt_license,
+      "Show license information", NULL },
+    { NULL }
+};
+
+/* ========================================================================== */
+/* Types                                                                       */
+/* ========================================================================== */
+
+typedef struct _Broker   Broker;
+typedef struct _Upstream Upstream;
+typedef struct _Session  Session;
+
+struct _Broker
+{
+    GMainLoop      *loop;
+    GSocketService *service;
+    gchar          *socket_path;
+    GHashTable     *upstreams;      /* key -> Upstream* */
+    GList          *sessions;       /* Session* */
+    guint           idle_source_id;
+};
+
+/*
+ * Upstream:
+ *
+ * One warm connection to an MCP server, shared by every session whose
+ * hello named the same transport spec.
+ */
+struct _Upstream
+{
+    Broker       *broker;
+    gchar        *key;
+    McpTransport *transport;
+    GCancellable *cancellable;
+    gulong        message_handler_id;
+    gulong        state_handler_id;
+
+    gboolean      connected;
+    JsonNode     *init_params;      /* params for the pending initialize */
+    guint         init_id;          /* 0 unless initialize is in flight */
+    JsonNode     *init_result;      /* cached initialize result */
+    GList        *init_waiters;     /* Route* waiting for init_result */
+
+    guint         next_id;
+    GHashTable   *routes;           /* upstream id -> Route* */
+};
+
+struct _Session
+{
+    Broker            *broker;
+    GSocketConnection *connection;
+    GDataInputStream  *input;
+    McpStdioTransport *transport;
+    gulong             message_handler_id;
+    gulong             state_handler_id;
+    Upstream          *upstream;
+    GHashTable        *subscriptions;   /* resource URIs, or NULL */
+    gboolean           closed;
+};
+
+/*
+ * Route:
+ *
+ * Where to deliver the response to a forwarded request: the session it
+ * came from and the ID that session used.  @session is cleared if the
+ * session goes away first.  A request asking for progress is sent with
+ * its upstream ID as the progress token; @progress_token is the one the
+ * session chose.
+ */
+typedef struct
+{
+    Session  *session;
+    JsonNode *id;
+    JsonNode *progress_token;
+} Route;
+
+static void session_close (Session *session);
+
+static gboolean
+free_later_cb (gpointer user_data)
+{
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * free_later:
+ *
+ * Frees @data with @destroy once the current signal emission unwinds.
+ */
+static void
+free_later (gpointer       data,
+            GDestroyNotify destroy)
+{
+    g_idle_add_full (G_PRIORITY_DEFAULT, free_later_cb, data, destroy);
+}
+
+static void
+route_free (Route *route)
+{
+    json_node_unref (route->id);
+    g_clear_pointer (&route->progress_token, json_node_unref);
+    g_free (route);
+}
+
+/* ========================================================================== */
+/* JSON-RPC helpers                                                            */
+/* ========================================================================== */
+
+static const gchar *
+get_string_member (JsonObject  *obj,
+                   const gchar *name)
+{
+    JsonNode *node;
+
+    node = json_object_get_member (obj, name);
+    if (node == NULL || !JSON_NODE_HOLDS_VALUE (node) ||
+        json_node_get_value_type (node) != G_TYPE_STRING)
+    {
+        return NULL;
+    }
+
+    return json_node_get_string (node);
+}
+
+static JsonObject *
+get_object_member (JsonObject  *obj,
+                   const gchar *name)
+{
+    JsonNode *node;
+
+    node = json_object_get_member (obj, name);
+    if (node == NULL || !JSON_NODE_HOLDS_OBJECT (node))
+    {
+        return NULL;
+    }
+
+    return json_node_get_object (node);
+}
+
+static void
+on_message_sent (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+    g_autoptr(GError) error = NULL;
+
+    if (!mcp_transport_send_message_finish (MCP_TRANSPORT (source), result, &error))
+    {
+        g_debug ("mcp-broker: send failed: %s", error->message);
+    }
+}
+
+static void
+send_message (McpTransport *transport,
+              JsonNode     *message)
+{
+    mcp_transport_send_message_async (transport, message, NULL,
+                                      on_message_sent, NULL);
+}
+
+/*
+ * send_reply:
+ *
+ * Sends a JSON-RPC response carrying either @result or @error_object
+ * (both transfer none).
+ */
+static void
+send_reply (McpTransport *transport,
+            JsonNode     *id,
+            JsonNode     *result,
+            JsonNode     *error_object)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    g_autoptr(JsonNode) message = NULL;
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "jsonrpc");
+    json_builder_add_string_value (builder, "2.0");
+    json_builder_set_member_name (builder, "id");
+    json_builder_add_value (builder, json_node_copy (id));
+    if (error_object != NULL)
+    {
+        json_builder_set_member_name (builder, "error");
+        json_builder_add_value (builder, json_node_copy (error_object));
+    }
+    else
+    {
+        json_builder_set_member_name (builder, "result");
+        json_builder_add_value (builder, json_node_copy (result));
+    }
+    json_builder_end_object (builder);
+
+    message = json_builder_get_root (builder);
+    send_message (transport, message);
+}
+
+static JsonNode *
+build_error_object (gint         code,
+                    const gchar *message)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "code");
+    json_builder_add_int_value (builder, code);
+    json_builder_set_member_name (builder, "message");
+    json_builder_add_string_value (builder, message);
+    json_builder_end_object (builder);
+
+    return json_builder_get_root (builder);
+}
+
+static void
+send_error (McpTransport *transport,
+            JsonNode     *id,
+            gint          code,
+            const gchar  *message)
+{
+    g_autoptr(JsonNode) error_object = build_error_object (code, message);
+
+    send_reply (transport, id, NULL, error_object);
+}
+
+/* ========================================================================== */
+/* Idle shutdown                                                               */
+/* ========================================================================== */
+
+static gboolean
+on_idle_timeout (gpointer user_data)
+{
+    Broker *broker = user_data;
+
+    broker->idle_source_id = 0;
+    g_debug ("mcp-broker: idle, exiting");
+    g_main_loop_quit (broker->loop);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+broker_update_idle (Broker *broker)
+{
+    if (broker->sessions != NULL)
+    {
+        if (broker->idle_source_id != 0)
+        {
+            g_source_remove (broker->idle_source_id);
+            broker->idle_source_id = 0;
+        }
+        return;
+    }
+
+    if (broker->idle_source_id == 0 && opt_idle_timeout > 0)
+    {
+        broker->idle_source_id = g_timeout_add_seconds ((guint)opt_idle_timeout,
+                                                        on_idle_timeout, broker);
+    }
+}
+
+/* ========================================================================== */
+/* Upstream connections                                                        */
+/* ========================================================================== */
+
+static void
+upstream_free (Upstream *upstream)
+{
+    g_cancellable_cancel (upstream->cancellable);
+    g_clear_object (&upstream->cancellable);
+    g_clear_signal_handler (&upstream->message_handler_id, upstream->transport);
+    g_clear_signal_handler (&upstream->state_handler_id, upstream->transport);
+    g_clear_object (&upstream->transport);
+    g_clear_pointer (&upstream->init_params, json_node_unref);
+    g_clear_pointer (&upstream->init_result, json_node_unref);
+    g_list_free_full (upstream->init_waiters, (GDestroyNotify)route_free);
+    g_hash_table_unref (upstream->routes);
+    g_free (upstream->key);
+    g_free (upstream);
+}
+
+/*
+ * upstream_fail:
+ *
+ * Fails every outstanding request, detaches the sessions using this
+ * upstream and drops it from the table so the next hello reconnects.
+ * The upstream is freed later because this runs inside its own
+ * transport's signal emission.
+ */
+static void
+upstream_fail (Upstream    *upstream,
+               const gchar *reason)
+{
+    Broker *broker = upstream->broker;
+    GHashTableIter iter;
+    gpointer value;
+    GList *l;
+
+    if (!g_hash_table_steal (broker->upstreams, upstream->key))
+    {
+        return;
+    }
+
+    g_debug ("mcp-broker: upstream %s failed: %s", upstream->key, reason);
+
+    for (l = upstream->init_waiters; l != NULL; l = l->next)
+    {
+        Route *route = l->data;
+
+        if (route->session != NULL)
+        {
+            send_error (MCP_TRANSPORT (route->session->transport), route->id,
+                        MCP_ERROR_CONNECTION_CLOSED, reason);
+        }
+    }
+
+    g_hash_table_iter_init (&iter, upstream->routes);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        Route *route = value;
+
+        if (route->session != NULL)
+        {
+            send_error (MCP_TRANSPORT (route->session->transport), route->id,
+                        MCP_ERROR_CONNECTION_CLOSED, reason);
+        }
+    }
+
+    for (l = broker->sessions; l != NULL; l = l->next)
+    {
+        Session *session = l->data;
+
+        if (session->upstream == upstream)
+        {
+            session->upstream = NULL;
+        }
+    }
+
+    free_later (upstream, (GDestroyNotify)upstream_free);
+}
+
+static void
+upstream_send_initialize (Upstream *upstream)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    g_autoptr(JsonNode) message = NULL;
+
+    upstream->init_id = ++upstream->next_id;
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "jsonrpc");
+    json_builder_add_string_value (builder, "2.0");
+    json_builder_set_member_name (builder, "id");
+    json_builder_add_int_value (builder, upstream->init_id);
+    json_builder_set_member_name (builder, "method");
+    json_builder_add_string_value (builder, "initialize");
+    json_builder_set_member_name (builder, "params");
+    json_builder_add_value (builder, json_node_copy (upstream->init_params));
+    json_builder_end_object (builder);
+
+    message = json_builder_get_root (builder);
+    send_message (upstream->transport, message);
+}
+
+/*
+ * upstream_handle_initialized:
+ *
+ * Caches the server's initialize response and answers every session
+ * that was waiting for it.
+ */
+static void
+upstream_handle_initialized (Upstream   *upstream,
+                             JsonObject *response)
+{
+    JsonNode *result;
+    JsonNode *error_object;
+    GList *waiters;
+    GList *l;
+
+    upstream->init_id = 0;
+    g_clear_pointer (&upstream->init_params, json_node_unref);
+
+    result = json_object_get_member (response, "result");
+    error_object = json_object_get_member (response, "error");
+
+    if (result != NULL)
+    {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+        g_autoptr(JsonNode) notification = NULL;
+
+        upstream->init_result = json_node_copy (result);
+
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "jsonrpc");
+        json_builder_add_string_value (builder, "2.0");
+        json_builder_set_member_name (builder, "method");
+        json_builder_add_string_value (builder, "notifications/initialized");
+        json_builder_end_object (builder);
+
+        notification = json_builder_get_root (builder);
+        send_message (upstream->transport, notification);
+    }
+
+    waiters = g_steal_pointer (&upstream->init_waiters);
+    for (l = waiters; l != NULL; l = l->next)
+    {
+        Route *route = l->data;
+
+        if (route->session == NULL)
+        {
+            continue;
+        }
+
+        if (result != NULL)
+        {
+            send_reply (MCP_TRANSPORT (route->session->transport), route->id,
+                        upstream->init_result, NULL);
+        }
+        else if (error_object != NULL)
+        {
+            send_reply (MCP_TRANSPORT (route->session->transport), route->id,
+                        NULL, error_object);
+        }
+        else
+        {
+            send_error (MCP_TRANSPORT (route->session->transport), route->id,
+                        MCP_ERROR_INTERNAL_ERROR, "Invalid initialize response");
+        }
+    }
+    g_list_free_full (waiters, (GDestroyNotify)route_free);
+}
+
+/*
+ * upstream_owner:
+ *
+ * Gets the only session with requests in flight on @upstream, or %NULL
+ * if there are none or several.
+ */
+static Session *
+upstream_owner (Upstream *upstream)
+{
+    GHashTableIter iter;
+    gpointer value;
+    Session *owner = NULL;
+
+    g_hash_table_iter_init (&iter, upstream->routes);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        Route *route = value;
+
+        if (route->session == NULL)
+        {
+            continue;
+        }
+        if (owner != NULL && owner != route->session)
+        {
+            return NULL;
+        }
+        owner = route->session;
+    }
+
+    return owner;
+}
+
+/*
+ * upstream_route_notification:
+ *
+ * Delivers a notification from the server only to the sessions it
+ * concerns, since they may belong to different users:
+ *
+ * - progress goes to the session whose request carried the token, with
+ *   the token it chose;
+ * - log messages go to the session with requests in flight, and are
+ *   dropped while several sessions have;
+ * - resource updates go to the sessions subscribed to the URI;
+ * - cancellations refer to server requests the broker has already
+ *   answered, and are dropped;
+ * - anything else, such as list changes, is about the server as a
+ *   whole and goes to every session.
+ */
+static void
+upstream_route_notification (Upstream    *upstream,
+                             JsonNode    *message,
+                             const gchar *method)
+{
+    JsonObject *params;
+    GList *l;
+
+    params = get_object_member (json_node_get_object (message), "params");
+
+    if (g_strcmp0 (method, "notifications/progress") == 0)
+    {
+        JsonNode *token = params != NULL ? json_object_get_member (params, "progressToken") : NULL;
+        g_autoptr(JsonNode) copy = NULL;
+        Route *route;
+
+        if (token == NULL || !JSON_NODE_HOLDS_VALUE (token) ||
+            json_node_get_value_type (token) != G_TYPE_INT64)
+        {
+            return;
+        }
+
+        route = g_hash_table_lookup (upstream->routes,
+                                     GUINT_TO_POINTER ((guint)json_node_get_int (token)));
+        if (route == NULL || route->session == NULL || route->progress_token == NULL)
+        {
+            return;
+        }
+
+        copy = json_node_copy (message);
+        json_object_set_member (get_object_member (json_node_get_object (copy), "params"),
+                                "progressToken", json_node_copy (route->progress_token));
+        send_message (MCP_TRANSPORT (route->session->transport), copy);
+        return;
+    }
+
+    if (g_strcmp0 (method, "notifications/message") == 0)
+    {
+        Session *owner = upstream_owner (upstream);
+
+        if (owner != NULL)
+        {
+            send_message (MCP_TRANSPORT (owner->transport), message);
+        }
+        return;
+    }
+
+    if (g_strcmp0 (method, "notifications/cancelled") == 0)
+    {
+        return;
+    }
+
+    for (l = upstream->broker->sessions; l != NULL; l = l->next)
+    {
+        Session *session = l->data;
+
+        if (session->upstream != upstream)
+        {
+            continue;
+        }
+
+        if (g_strcmp0 (method, "notifications/resources/updated") == 0)
+        {
+            const gchar *uri = params != NULL ? get_string_member (params, "uri") : NULL;
+
+            if (uri == NULL || session->subscriptions == NULL ||
+                !g_hash_table_contains (session->subscriptions, uri))
+            {
+                continue;
+            }
+        }
+
+        send_message (MCP_TRANSPORT (session->transport), message);
+    }
+}
+
+static void
+on_upstream_message (McpTransport *transport,
+                     JsonNode     *message,
+                     gpointer      user_data)
+{
+    Upstream *upstream = user_data;
+    JsonObject *obj;
+    JsonNode *id;
+    const gchar *method;
+
+    if (!JSON_NODE_HOLDS_OBJECT (message))
+    {
+        return;
+    }
+
+    obj = json_node_get_object (message);
+    id = json_object_get_member (obj, "id");
+    method = get_string_member (obj, "method");
+
+    /* Response to a request we forwarded */
+    if (method == NULL && id != NULL)
+    {
+        Route *route;
+        guint uid;
+
+        if (!JSON_NODE_HOLDS_VALUE (id) || json_node_get_value_type (id) != G_TYPE_INT64)
+        {
+            return;
+        }
+        uid = (guint)json_node_get_int (id);
+
+        if (uid != 0 && uid == upstream->init_id)
+        {
+            upstream_handle_initialized (upstream, obj);
+            return;
+        }
+
+        route = g_hash_table_lookup (upstream->routes, GUINT_TO_POINTER (uid));
+        if (route == NULL)
+        {
+            return;
+        }
+
+        if (route->session != NULL)
+        {
+            g_autoptr(JsonNode) copy = json_node_copy (message);
+
+            json_object_set_member (json_node_get_object (copy), "id",
+                                    json_node_copy (route->id));
+            send_message (MCP_TRANSPORT (route->session->transport), copy);
+        }
+        g_hash_table_remove (upstream->routes, GUINT_TO_POINTER (uid));
+        return;
+    }
+
+    /* Server-to-client request: no single session owns it */
+    if (method != NULL && id != NULL)
+    {
+        if (g_strcmp0 (method, "ping") == 0)
+        {
+            g_autoptr(JsonNode) empty = json_node_new (JSON_NODE_OBJECT);
+
+            json_node_take_object (empty, json_object_new ());
+            send_reply (transport, id, empty, NULL);
+        }
+        else
+        {
+            send_error (transport, id, MCP_ERROR_METHOD_NOT_FOUND,
+                        "Not supported through mcp-broker");
+        }
+        return;
+    }
+
+    if (method != NULL)
+    {
+        upstream_route_notification (upstream, message, method);
+    }
+}
+
+static void
+on_upstream_state_changed (McpTransport      *transport,
+                           McpTransportState  old_state,
+                           McpTransportState  new_state,
+                           gpointer           user_data)
+{
+    Upstream *upstream = user_data;
+
+    if (new_state == MCP_TRANSPORT_STATE_DISCONNECTED ||
+        new_state == MCP_TRANSPORT_STATE_ERROR)
+    {
+        upstream_fail (upstream, "Upstream connection lost");
+    }
+}
+
+static void
+on_upstream_connected (GObject      *source,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+    Upstream *upstream = user_data;
+    g_autoptr(GError) error = NULL;
+
+    if (!mcp_transport_connect_finish (MCP_TRANSPORT (source), result, &error))
+    {
+        /* Cancelled means the upstream has already been freed */
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            upstream_fail (upstream, error->message);
+        }
+        return;
+    }
+
+    upstream->connected = TRUE;
+    if (upstream->init_params != NULL)
+    {
+        upstream_send_initialize (upstream);
+    }
+}
+
+/*
+ * upstream_key:
+ *
+ * Builds the table key for a hello.  Stdio upstreams are also keyed by
+ * working directory since relative commands depend on it.  Upstreams
+ * are keyed by a digest of the token, so a session is only handed an
+ * upstream opened with the same credentials, and --status does not
+ * show the token itself.
+ */
+static gchar *
+upstream_key (JsonObject *hello)
+{
+    const gchar *stdio = get_string_member (hello, "stdio");
+    const gchar *cwd = get_string_member (hello, "cwd");
+    const gchar *http = get_string_member (hello, "http");
+    const gchar *ws = get_string_member (hello, "ws");
+    const gchar *token = get_string_member (hello, "token");
+    g_autofree gchar *digest = NULL;
+
+    if (token != NULL)
+    {
+        digest = g_compute_checksum_for_string (G_CHECKSUM_SHA256, token, -1);
+    }
+
+    return g_strdup_printf ("stdio=%s cwd=%s http=%s ws=%s token=%s",
+                            stdio != NULL ? stdio : "",
+                            (stdio != NULL && cwd != NULL) ? cwd : "",
+                            http != NULL ? http : "",
+                            ws != NULL ? ws : "",
+                            digest != NULL ? digest : "");
+}
+
+/*
+ * upstream_lookup:
+ *
+ * Returns the warm upstream for @hello, creating and connecting it on
+ * first use.  Stdio servers are spawned in the caller's working
+ * directory so relative commands behave as they would without the
+ * broker.
+ */
+static Upstream *
+upstream_lookup (Broker      *broker,
+                 JsonObject  *hello,
+                 GError     **error)
+{
+    g_autofree gchar *key = upstream_key (hello);
+    McpTransport *transport;
+    Upstream *upstream;
+    gint64 timeout = 0;
+
+    upstream = g_hash_table_lookup (broker->upstreams, key);
+    if (upstream != NULL)
+    {
+        return upstream;
+    }
+
+    if (json_object_has_member (hello, "timeout"))
+    {
+        timeout = json_object_get_int_member (hello, "timeout");
+    }
+
+    transport = mcp_cli_create_direct_transport (get_string_member (hello, "stdio"),
+                                                 get_string_member (hello, "cwd"),
+                                                 get_string_member (hello, "http"),
+                                                 get_string_member (hello, "ws"),
+                                                 get_string_member (hello, "token"),
+                                                 (gint)timeout,
+                                                 error);
+    if (transport == NULL)
+    {
+        return NULL;
+    }
+
+    upstream = g_new0 (Upstream, 1);
+    upstream->broker = broker;
+    upstream->key = g_steal_pointer (&key);
+    upstream->transport = transport;
+    upstream->cancellable = g_cancellable_new ();
+    upstream->routes = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              NULL, (GDestroyNotify)route_free);
+
+    upstream->message_handler_id =
+        g_signal_connect (transport, "message-received",
+                          G_CALLBACK (on_upstream_message), upstream);
+    upstream->state_handler_id =
+        g_signal_connect (transport, "state-changed",
+                          G_CALLBACK (on_upstream_state_changed), upstream);
+
+    g_hash_table_insert (broker->upstreams, upstream->key, upstream);
+
+    mcp_transport_connect_async (transport, upstream->cancellable,
+                                 on_upstream_connected, upstream);
+
+    return upstream;
+}
+
+/* ========================================================================== */
+/* Sessions                                                                    */
+/* ========================================================================== */
+
+/*
+ * session_initialize:
+ *
+ * Answers a session's initialize from the cached handshake, or queues
+ * it until the upstream handshake completes.  The first session's
+ * params are used for the upstream handshake with its capabilities
+ * cleared, since the broker cannot serve sampling or roots requests
+ * on behalf of a particular session.
+ */
+static void
+session_initialize (Session  *session,
+                    JsonNode *id,
+                    JsonNode *params)
+{
+    Upstream *upstream = session->upstream;
+    Route *route;
+
+    if (upstream->init_result != NULL)
+    {
+        send_reply (MCP_TRANSPORT (session->transport), id,
+                    upstream->init_result, NULL);
+        return;
+    }
+
+    route = g_new0 (Route, 1);
+    route->session = session;
+    route->id = json_node_copy (id);
+    upstream->init_waiters = g_list_append (upstream->init_waiters, route);
+
+    if (upstream->init_params != NULL)
+    {
+        return;
+    }
+
+    if (params != NULL && JSON_NODE_HOLDS_OBJECT (params))
+    {
+        upstream->init_params = json_node_copy (params);
+    }
+    else
+    {
+        upstream->init_params = json_node_new (JSON_NODE_OBJECT);
+        json_node_take_object (upstream->init_params, json_object_new ());
+    }
+    json_object_set_object_member (json_node_get_object (upstream->init_params),
+                                   "capabilities", json_object_new ());
+
+    if (upstream->connected)
+    {
+        upstream_send_initialize (upstream);
+    }
+}
+
+static void
+session_forward_request (Session  *session,
+                         JsonNode *message,
+                         JsonNode *id)
+{
+    Upstream *upstream = session->upstream;
+    g_autoptr(JsonNode) copy = NULL;
+    JsonObject *params;
+    JsonObject *meta;
+    const gchar *method;
+    Route *route;
+    guint uid;
+
+    if (upstream->init_result == NULL)
+    {
+        send_error (MCP_TRANSPORT (session->transport), id,
+                    MCP_ERROR_INVALID_REQUEST, "Session is not initialized");
+        return;
+    }
+
+    uid = ++upstream->next_id;
+
+    route = g_new0 (Route, 1);
+    route->session = session;
+    route->id = json_node_copy (id);
+    g_hash_table_insert (upstream->routes, GUINT_TO_POINTER (uid), route);
+
+    copy = json_node_copy (message);
+    json_object_set_int_member (json_node_get_object (copy), "id", uid);
+
+    /* Progress tokens are chosen per session and could collide */
+    params = get_object_member (json_node_get_object (copy), "params");
+    meta = params != NULL ? get_object_member (params, "_meta") : NULL;
+    if (meta != NULL && json_object_has_member (meta, "progressToken"))
+    {
+        route->progress_token = json_node_copy (json_object_get_member (meta, "progressToken"));
+        json_object_set_int_member (meta, "progressToken", uid);
+    }
+
+    /* Remembered so resource updates only reach subscribers */
+    method = get_string_member (json_node_get_object (copy), "method");
+    if (params != NULL && get_string_member (params, "uri") != NULL)
+    {
+        const gchar *uri = get_string_member (params, "uri");
+
+        if (g_strcmp0 (method, "resources/subscribe") == 0)
+        {
+            if (session->subscriptions == NULL)
+            {
+                session->subscriptions = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                                g_free, NULL);
+            }
+            g_hash_table_add (session->subscriptions, g_strdup (uri));
+        }
+        else if (g_strcmp0 (method, "resources/unsubscribe") == 0 &&
+                 session->subscriptions != NULL)
+        {
+            g_hash_table_remove (session->subscriptions, uri);
+        }
+    }
+
+    send_message (upstream->transport, copy);
+}
+
+/*
+ * session_forward_cancel:
+ *
+ * Forwards a session's notifications/cancelled with the request ID
+ * rewritten to the one the upstream knows.  Cancellations of requests
+ * that are no longer in flight are dropped.
+ */
+static void
+session_forward_cancel (Session  *session,
+                        JsonNode *message)
+{
+    Upstream *upstream = session->upstream;
+    g_autoptr(JsonNode) copy = NULL;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    JsonObject *params;
+    JsonNode *request_id;
+
+    params = get_object_member (json_node_get_object (message), "params");
+    request_id = params != NULL ? json_object_get_member (params, "requestId") : NULL;
+    if (request_id == NULL)
+    {
+        return;
+    }
+
+    g_hash_table_iter_init (&iter, upstream->routes);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        Route *route = value;
+
+        if (route->session == session && json_node_equal (route->id, request_id))
+        {
+            copy = json_node_copy (message);
+            json_object_set_int_member (get_object_member (json_node_get_object (copy), "params"),
+                                        "requestId", GPOINTER_TO_UINT (key));
+            send_message (upstream->transport, copy);
+            return;
+        }
+    }
+}
+
+static void
+on_session_message (McpTransport *transport,
+                    JsonNode     *message,
+                    gpointer      user_data)
+{
+    Session *session = user_data;
+    JsonObject *obj;
+    JsonNode *id;
+    const gchar *method;
+
+    if (!JSON_NODE_HOLDS_OBJECT (message))
+    {
+        return;
+    }
+
+    obj = json_node_get_object (message);
+    id = json_object_get_member (obj, "id");
+    method = get_string_member (obj, "method");
+
+    /* Responses to server requests are answered by the broker itself */
+    if (method == NULL)
+    {
+        return;
+    }
+
+    if (session->upstream == NULL)
+    {
+        if (id != NULL)
+        {
+            send_error (transport, id, MCP_ERROR_CONNECTION_CLOSED,
+                        "Upstream connection lost");
+        }
+        return;
+    }
+
+    if (id == NULL)
+    {
+        /* The upstream was initialized once already */
+        if (g_strcmp0 (method, "notifications/cancelled") == 0)
+        {
+            session_forward_cancel (session, message);
+        }
+        else if (g_strcmp0 (method, "notifications/initialized") != 0)
+        {
+            send_message (session->upstream->transport, message);
+        }
+        return;
+    }
+
+    if (g_strcmp0 (method, "initialize") == 0)
+    {
+        session_initialize (session, id, json_object_get_member (obj, "params"));
+    }
+    else
+    {
+        session_forward_request (session, message, id);
+    }
+}
+
+static void
+on_session_state_changed (McpTransport      *transport,
+                          McpTransportState  old_state,
+                          McpTransportState  new_state,
+                          gpointer           user_data)
+{
+    if (new_state == MCP_TRANSPORT_STATE_DISCONNECTED ||
+        new_state == MCP_TRANSPORT_STATE_ERROR)
+    {
+        session_close (user_data);
+    }
+}
+
+static void
+session_free (Session *session)
+{
+    if (session->transport != NULL)
+    {
+        g_clear_signal_handler (&session->message_handler_id, session->transport);
+        g_clear_signal_handler (&session->state_handler_id, session->transport);
+        g_object_unref (session->transport);
+    }
+    g_clear_pointer (&session->subscriptions, g_hash_table_unref);
+    g_clear_object (&session->input);
+    g_clear_object (&session->connection);
+    g_free (session);
+}
+
+static void
+forget_session (Route   *route,
+                Session *session)
+{
+    if (route->session == session)
+    {
+        route->session = NULL;
+    }
+}
+
+/*
+ * session_close:
+ *
+ * Detaches a session from the broker.  Requests it still has in flight
+ * keep their upstream IDs reserved; their responses are dropped.
+ */
+static void
+session_close (Session *session)
+{
+    Broker *broker = session->broker;
+
+    if (session->closed)
+    {
+        return;
+    }
+    session->closed = TRUE;
+
+    if (session->upstream != NULL)
+    {
+        GHashTableIter iter;
+        gpointer value;
+
+        g_list_foreach (session->upstream->init_waiters, (GFunc)forget_session, session);
+        g_hash_table_iter_init (&iter, session->upstream->routes);
+        while (g_hash_table_iter_next (&iter, NULL, &value))
+        {
+            forget_session (value, session);
+        }
+        session->upstream = NULL;
+    }
+
+    broker->sessions = g_list_remove (broker->sessions, session);
+    broker_update_idle (broker);
+
+    free_later (session, (GDestroyNotify)session_free);
+}
+
+static void
+session_write_line (Session     *session,
+                    JsonBuilder *builder)
+{
+    g_autoptr(JsonGenerator) gen = json_generator_new ();
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    g_autofree gchar *data = NULL;
+    g_autofree gchar *line = NULL;
+    GOutputStream *output;
+
+    json_generator_set_root (gen, root);
+    data = json_generator_to_data (gen, NULL);
+    line = g_strconcat (data, "\n", NULL);
+
+    output = g_io_stream_get_output_stream (G_IO_STREAM (session->connection));
+    g_output_stream_write_all (output, line, strlen (line), NULL, NULL, NULL);
+}
+
+static void
+session_reply_error (Session     *session,
+                     const gchar *message)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "ok");
+    json_builder_add_boolean_value (builder, FALSE);
+    json_builder_set_member_name (builder, "error");
+    json_builder_add_string_value (builder, message);
+    json_builder_end_object (builder);
+
+    session_write_line (session, builder);
+}
+
+static void
+session_reply_status (Session *session)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    GHashTableIter iter;
+    gpointer value;
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "ok");
+    json_builder_add_boolean_value (builder, TRUE);
+    json_builder_set_member_name (builder, "sessions");
+    json_builder_add_int_value (builder, g_list_length (session->broker->sessions));
+    json_builder_set_member_name (builder, "upstreams");
+    json_builder_begin_array (builder);
+    g_hash_table_iter_init (&iter, session->broker->upstreams);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        Upstream *upstream = value;
+
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "key");
+        json_builder_add_string_value (builder, upstream->key);
+        json_builder_set_member_name (builder, "initialized");
+        json_builder_add_boolean_value (builder, upstream->init_result != NULL);
+        json_builder_set_member_name (builder, "pending");
+        json_builder_add_int_value (builder, g_hash_table_size (upstream->routes));
+        json_builder_end_object (builder);
+    }
+    json_builder_end_array (builder);
+    json_builder_end_object (builder);
+
+    session_write_line (session, builder);
+}
+
+/*
+ * session_attach:
+ *
+ * Acknowledges the hello and switches the socket over to NDJSON
+ * JSON-RPC.  The hello reader is reused as the transport's input so
+ * nothing it buffered is lost.
+ */
+static void
+session_attach (Session  *session,
+                Upstream *upstream)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    GOutputStream *output;
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "ok");
+    json_builder_add_boolean_value (builder, TRUE);
+    json_builder_end_object (builder);
+    session_write_line (session, builder);
+
+    session->upstream = upstream;
+
+    output = g_io_stream_get_output_stream (G_IO_STREAM (session->connection));
+    session->transport = mcp_stdio_transport_new_with_streams (G_INPUT_STREAM (session->input),
+                                                               output);
+    session->message_handler_id =
+        g_signal_connect (session->transport, "message-received",
+                          G_CALLBACK (on_session_message), session);
+    session->state_handler_id =
+        g_signal_connect (session->transport, "state-changed",
+                          G_CALLBACK (on_session_state_changed), session);
+
+    mcp_transport_connect_async (MCP_TRANSPORT (session->transport), NULL, NULL, NULL);
+}
+
+static void
+on_hello_read (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+    Session *session = user_data;
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *line = NULL;
+    JsonObject *hello = NULL;
+    const gchar *command;
+    Upstream *upstream;
+
+    line = g_data_input_stream_read_line_finish (G_DATA_INPUT_STREAM (source),
+                                                 result, NULL, &error);
+    if (line == NULL)
+    {
+        session_close (session);
+        return;
+    }
+
+    if (json_parser_load_from_data (parser, line, -1, NULL))
+    {
+        JsonNode *root = json_parser_get_root (parser);
+
+        if (root != NULL && JSON_NODE_HOLDS_OBJECT (root))
+        {
+            hello = json_node_get_object (root);
+        }
+    }
+
+    if (hello == NULL || !json_object_has_member (hello, "mcpBroker") ||
+        json_object_get_int_member (hello, "mcpBroker") != MCP_CLI_BROKER_PROTOCOL)
+    {
+        session_reply_error (session, "Unsupported hello");
+        session_close (session);
+        return;
+    }
+
+    command = get_string_member (hello, "command");
+    if (g_strcmp0 (command, "status") == 0)
+    {
+        session_reply_status (session);
+        session_close (session);
+        return;
+    }
+    if (g_strcmp0 (command, "stop") == 0)
+    {
+        session_reply_status (session);
+        session_close (session);
+        g_main_loop_quit (session->broker->loop);
+        return;
+    }
+
+    upstream = upstream_lookup (session->broker, hello, &error);
+    if (upstream == NULL)
+    {
+        session_reply_error (session, error->message);
+        session_close (session);
+        return;
+    }
+
+    session_attach (session, upstream);
+}
+
+static gboolean
+on_incoming (GSocketService    *service,
+             GSocketConnection *connection,
+             GObject           *source_object,
+             gpointer           user_data)
+{
+    Broker *broker = user_data;
+    Session *session;
+
+    session = g_new0 (Session, 1);
+    session->broker = broker;
+    session->connection = g_object_ref (connection);
+    session->input = g_data_input_stream_new (
+        g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+    g_data_input_stream_set_newline_type (session->input, G_DATA_STREAM_NEWLINE_TYPE_LF);
+
+    broker->sessions = g_list_prepend (broker->sessions, session);
+    broker_update_idle (broker);
+
+    g_data_input_stream_read_line_async (session->input, G_PRIORITY_DEFAULT, NULL,
+                                         on_hello_read, session);
+
+    return TRUE;
+}
+
+/* ========================================================================== */
+/* Control commands                                                            */
+/* ========================================================================== */
+
+/*
+ * run_control:
+ *
+ * Sends a control command to a running broker and prints its reply.
+ */
+static gint
+run_control (const gchar *path,
+             const gchar *command)
+{
+    g_autoptr(GSocketClient) client = g_socket_client_new ();
+    g_autoptr(GSocketAddress) address = NULL;
+    g_autoptr(GSocketConnection) connection = NULL;
+    g_autoptr(GDataInputStream) input = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *request = NULL;
+    g_autofree gchar *reply = NULL;
+    GOutputStream *output;
+
+    address = g_unix_socket_address_new (path);
+    connection = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (address),
+                                          NULL, &error);
+    if (connection == NULL)
+    {
+        g_printerr ("No broker running at %s\n", path);
+        return MCP_CLI_EXIT_NOT_FOUND;
+    }
+
+    request = g_strdup_printf ("{\"mcpBroker\": %d, \"command\": \"%s\"}\n",
+                               MCP_CLI_BROKER_PROTOCOL, command);
+    output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+    if (!g_output_stream_write_all (output, request, strlen (request), NULL, NULL, &error))
+    {
+        g_printerr ("Error: %s\n", error->message);
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+    reply = g_data_input_stream_read_line (input, NULL, NULL, &error);
+    if (reply == NULL)
+    {
+        g_printerr ("Error: %s\n", error != NULL ? error->message : "no reply");
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    g_print ("%s\n", reply);
+    return MCP_CLI_EXIT_SUCCESS;
+}
+
+/* ========================================================================== */
+/* Main entry point                                                            */
+/* ========================================================================== */
+
+static const gchar *description =
+    "Keep MCP server connections warm for the CLI tools.\n"
+    "\n"
+    "CLI tools run with --broker (or MCP_CLI_BROKER=1) start this daemon on\n"
+    "first use and reuse its connections afterwards, skipping the server\n"
+    "spawn and handshake on every invocation.\n"
+    "\n"
+    "Examples:\n"
+    "  mcp-call --broker -s ./server -- echo '{\"message\": \"hi\"}'\n"
+    "  mcp-broker --status\n"
+    "  mcp-broker --stop\n"
+    "\n"
+    "Report bugs to: " MCP_CLI_BUG_URL;
+
+int
+main (int    argc,
+      char **argv)
+{
+    g_autoptr(GOptionContext) context = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GSocketAddress) address = NULL;
+    g_autofree gchar *dir = NULL;
+    Broker broker;
+
+    context = g_option_context_new (NULL);
+    g_option_context_set_description (context, description);
+    g_option_context_add_main_entries (context, broker_entries, NULL);
+
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        g_printerr ("Option parsing failed: %s\n", error->message);
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    if (mcp_cli_opt_license)
+    {
+        mcp_cli_print_license ();
+        return MCP_CLI_EXIT_SUCCESS;
+    }
+
+    if (opt_socket == NULL)
+    {
+        opt_socket = mcp_cli_broker_socket_path ();
+    }
+
+    if (opt_status || opt_stop)
+    {
+        return run_control (opt_socket, opt_stop ? "stop" : "status");
+    }
+
+    if (opt_daemon)
+    {
+        setsid ();
+        if (g_chdir ("/") != 0)
+        {
+            g_printerr ("Error: cannot change directory to /\n");
+        }
+    }
+
+    memset (&broker, 0, sizeof (broker));
+    broker.loop = g_main_loop_new (NULL, FALSE);
+    broker.socket_path = opt_socket;
+    broker.upstreams = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              NULL, (GDestroyNotify)upstream_free);
+
+    dir = g_path_get_dirname (opt_socket);
+    g_mkdir_with_parents (dir, 0700);
+
+    /* A socket that refuses connections is left over from a dead broker */
+    if (g_file_test (opt_socket, G_FILE_TEST_EXISTS))
+    {
+        if (run_control (opt_socket, "status") == MCP_CLI_EXIT_SUCCESS)
+        {
+            g_printerr ("A broker is already running at %s\n", opt_socket);
+            return MCP_CLI_EXIT_ERROR;
+        }
+        g_unlink (opt_socket);
+    }
+
+    broker.service = g_socket_service_new ();
+    address = g_unix_socket_address_new (opt_socket);
+    if (!g_socket_listener_add_address (G_SOCKET_LISTENER (broker.service), address,
+                                        G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                        NULL, NULL, &error))
+    {
+        g_printerr ("Error: cannot listen on %s: %s\n", opt_socket, error->message);
+        return MCP_CLI_EXIT_ERROR;
+    }
+    g_chmod (opt_socket, 0600);
+
+    g_signal_connect (broker.service, "incoming", G_CALLBACK (on_incoming), &broker);
+    g_socket_service_start (broker.service);
+    broker_update_idle (&broker);
+
+    g_main_loop_run (broker.loop);
+
+    g_socket_service_stop (broker.service);
+    g_socket_listener_close (G_SOCKET_LISTENER (broker.service));
+    g_unlink (opt_socket);
+
+    /* Dropping the upstreams terminates any stdio servers */
+    g_hash_table_unref (broker.upstreams);
+    g_list_free_full (g_steal_pointer (&broker.sessions), (GDestroyNotify)session_free);
+    g_object_unref (broker.service);
+    g_main_loop_unref (broker.loop);
+    g_free (opt_socket);
+
+    return MCP_CLI_EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@
  * Usage:
  *   mcp-call --stdio ./server -- tool-name '{"arg": "value"}'
  *   mcp-call --http https://api.example.com/mcp -- add '{"a": 5, "b": 3}'
+ *   mcp-call --stdio ./server --batch calls.ndjson --concurrency 32
  *
  * Exit codes:
  *   0 - Success
@@ -18,7 +19,24 @@
  */
 
 #include "mcp-common.h"
+#include <gio/gunixinputstream.h>
 #include <string.h>
+#include <unistd.h>
+
+/* Tool-specific options */
+static gchar    *opt_batch = NULL;
+static gint      opt_concurrency = 16;
+static gboolean  opt_ordered = FALSE;
+
+static GOptionEntry call_entries[] = {
+    { "batch", 'b', 0, G_OPTION_ARG_FILENAME, &opt_batch,
+      "Read NDJSON call specs from FILE ('-' for stdin)", "FILE" },
+    { "concurrency", 'c', 0, G_OPTION_ARG_INT, &opt_concurrency,
+      "Maximum calls in flight in batch mode (default: 16)", "N" },
+    { "ordered", 0, 0, G_OPTION_ARG_NONE, &opt_ordered,
+      "Print batch results in input order instead of completion order", NULL },
+    { NULL }
+};
 
 /* ========================================================================== */
 /* Async operation context                                                     */
@@ -42,6 +60,458 @@ on_call_tool_complete (GObject      *source,
     g_main_loop_quit (ctx->loop);
 }
 
+/* ========================================================================== */
+/* Batch mode                                                                  */
+/* ========================================================================== */
+
+/*
+ * Batch mode reads one call spec per line:
+ *
+ *   {"id": <any>, "name": "tool", "arguments": {...}}
+ *
+ * and keeps up to --concurrency calls in flight over the single
+ * connection.  Each finished call is written to stdout as one NDJSON
+ * line; "id" is echoed back verbatim so callers can correlate results
+ * when printing in completion order.
+ *
+ * With --ordered a finished result waits for every earlier one, so a
+ * slow call holds back everything read after it.  Reading stops once
+ * the calls from the oldest unprinted one on would exceed the window
+ * plus BATCH_REORDER_FACTOR windows of held results.
+ */
+
+#define BATCH_REORDER_FACTOR 4
+
+typedef struct
+{
+    GMainLoop        *loop;
+    McpClient        *client;
+    GDataInputStream *input;
+    gboolean          input_done;
+    gboolean          reading;         /* a read_line_async is pending */
+    guint             concurrency;
+    gboolean          ordered;
+    guint             max_pending;     /* in flight or held (ordered) */
+
+    guint             next_index;      /* index of the next spec read */
+    guint             next_emit;       /* next index to print (ordered) */
+    guint             in_flight;
+    GHashTable       *held_lines;      /* index -> gchar* (ordered) */
+
+    guint             n_ok;
+    guint             n_tool_errors;
+    guint             n_failed;
+    GArray           *latencies;       /* gdouble, milliseconds */
+} BatchContext;
+
+typedef struct
+{
+    BatchContext *batch;
+    guint         index;
+    JsonNode     *id;
+    gchar        *name;
+    gint64        start_us;
+} BatchCall;
+
+static void
+batch_call_free (BatchCall *call)
+{
+    g_clear_pointer (&call->id, json_node_unref);
+    g_free (call->name);
+    g_free (call);
+}
+
+static void batch_fill_window (BatchContext *batch);
+
+/*
+ * batch_emit_line:
+ *
+ * Prints a finished result line, either immediately (completion order)
+ * or once every earlier input line has been printed (input order).
+ * Takes ownership of @line.
+ */
+static void
+batch_emit_line (BatchContext *batch,
+                 guint         index,
+                 gchar        *line)
+{
+    gchar *held;
+
+    if (!batch->ordered)
+    {
+        g_print ("%s\n", line);
+        g_free (line);
+        return;
+    }
+
+    g_hash_table_insert (batch->held_lines, GUINT_TO_POINTER (index), line);
+
+    while ((held = g_hash_table_lookup (batch->held_lines,
+                                        GUINT_TO_POINTER (batch->next_emit))) != NULL)
+    {
+        g_print ("%s\n", held);
+        g_hash_table_remove (batch->held_lines, GUINT_TO_POINTER (batch->next_emit));
+        batch->next_emit++;
+    }
+}
+
+/*
+ * batch_build_line:
+ *
+ * Serializes one result line.  Exactly one of @result and @error is set.
+ */
+static gchar *
+batch_build_line (guint          index,
+                  JsonNode      *id,
+                  const gchar   *name,
+                  gdouble        latency_ms,
+                  McpToolResult *result,
+                  const GError  *error)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    g_autoptr(JsonGenerator) gen = json_generator_new ();
+    g_autoptr(JsonNode) root = NULL;
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "index");
+    json_builder_add_int_value (builder, index);
+    if (id != NULL)
+    {
+        json_builder_set_member_name (builder, "id");
+        json_builder_add_value (builder, json_node_copy (id));
+    }
+    if (name != NULL)
+    {
+        json_builder_set_member_name (builder, "name");
+        json_builder_add_string_value (builder, name);
+    }
+    json_builder_set_member_name (builder, "latencyMs");
+    json_builder_add_double_value (builder, latency_ms);
+
+    if (result != NULL)
+    {
+        json_builder_set_member_name (builder, "result");
+        json_builder_add_value (builder, mcp_tool_result_to_json (result));
+    }
+    else
+    {
+        json_builder_set_member_name (builder, "error");
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "code");
+        json_builder_add_int_value (builder, error->domain == MCP_ERROR ? error->code : MCP_ERROR_INTERNAL_ERROR);
+        json_builder_set_member_name (builder, "message");
+        json_builder_add_string_value (builder, error->message);
+        json_builder_end_object (builder);
+    }
+    json_builder_end_object (builder);
+
+    root = json_builder_get_root (builder);
+    json_generator_set_root (gen, root);
+    return json_generator_to_data (gen, NULL);
+}
+
+static void
+on_batch_call_complete (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+    BatchCall *call = user_data;
+    BatchContext *batch = call->batch;
+    g_autoptr(McpToolResult) tool_result = NULL;
+    g_autoptr(GError) error = NULL;
+    gdouble latency_ms;
+
+    tool_result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &error);
+    latency_ms = (g_get_monotonic_time () - call->start_us) / 1000.0;
+    g_array_append_val (batch->latencies, latency_ms);
+
+    if (tool_result == NULL)
+    {
+        if (error == NULL)
+        {
+            error = g_error_new (MCP_ERROR, MCP_ERROR_INTERNAL_ERROR,
+                                 "No result received");
+        }
+        batch->n_failed++;
+    }
+    else if (mcp_tool_result_get_is_error (tool_result))
+    {
+        batch->n_tool_errors++;
+    }
+    else
+    {
+        batch->n_ok++;
+    }
+
+    batch_emit_line (batch, call->index,
+                     batch_build_line (call->index, call->id, call->name,
+                                       latency_ms, tool_result, error));
+
+    batch_call_free (call);
+    batch->in_flight--;
+    batch_fill_window (batch);
+}
+
+/*
+ * batch_start_call:
+ *
+ * Parses one spec line and issues the call.  Malformed specs are
+ * reported as failed result lines rather than aborting the batch.
+ */
+static void
+batch_start_call (BatchContext *batch,
+                  const gchar  *line)
+{
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    g_autoptr(GError) error = NULL;
+    JsonObject *spec = NULL;
+    JsonObject *arguments = NULL;
+    JsonNode *id = NULL;
+    const gchar *name = NULL;
+    BatchCall *call;
+    guint index;
+
+    index = batch->next_index++;
+
+    if (json_parser_load_from_data (parser, line, -1, &error))
+    {
+        JsonNode *root = json_parser_get_root (parser);
+
+        if (root != NULL && JSON_NODE_HOLDS_OBJECT (root))
+        {
+            spec = json_node_get_object (root);
+        }
+    }
+
+    if (spec != NULL)
+    {
+        JsonNode *node;
+
+        id = json_object_get_member (spec, "id");
+
+        node = json_object_get_member (spec, "name");
+        if (node != NULL && JSON_NODE_HOLDS_VALUE (node) &&
+            json_node_get_value_type (node) == G_TYPE_STRING)
+        {
+            name = json_node_get_string (node);
+        }
+
+        node = json_object_get_member (spec, "arguments");
+        if (node != NULL && JSON_NODE_HOLDS_OBJECT (node))
+        {
+            arguments = json_node_get_object (node);
+        }
+    }
+
+    if (name == NULL)
+    {
+        if (error == NULL)
+        {
+            error = g_error_new (MCP_ERROR, MCP_ERROR_INVALID_PARAMS,
+                                 "Call spec must be an object with a \"name\" member");
+        }
+        batch->n_failed++;
+        batch_emit_line (batch, index,
+                         batch_build_line (index, id, NULL, 0.0, NULL, error));
+        return;
+    }
+
+    call = g_new0 (BatchCall, 1);
+    call->batch = batch;
+    call->index = index;
+    call->id = (id != NULL) ? json_node_copy (id) : NULL;
+    call->name = g_strdup (name);
+    call->start_us = g_get_monotonic_time ();
+
+    batch->in_flight++;
+    mcp_client_call_tool_async (batch->client, name, arguments, NULL,
+                                on_batch_call_complete, call);
+}
+
+static void
+on_batch_line_read (GObject      *source,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+    BatchContext *batch = user_data;
+    g_autofree gchar *line = NULL;
+    g_autoptr(GError) error = NULL;
+    gsize length;
+
+    batch->reading = FALSE;
+
+    line = g_data_input_stream_read_line_finish (G_DATA_INPUT_STREAM (source), result,
+                                                 &length, &error);
+    if (line == NULL)
+    {
+        if (error != NULL)
+        {
+            g_printerr ("Error reading batch input: %s\n", error->message);
+            batch->n_failed++;
+        }
+        batch->input_done = TRUE;
+    }
+    else
+    {
+        g_strstrip (line);
+        if (line[0] != '\0')
+        {
+            batch_start_call (batch, line);
+        }
+    }
+
+    batch_fill_window (batch);
+}
+
+/*
+ * batch_fill_window:
+ *
+ * Asks for the next spec line while the concurrency window (and, in
+ * input order, the reorder window) has room,
+ * and quits the loop once the input is exhausted and nothing is left
+ * in flight.  Lines are read asynchronously so that a slow producer
+ * on stdin does not stop responses from being processed.
+ */
+static gboolean
+batch_has_room (BatchContext *batch)
+{
+    if (batch->in_flight >= batch->concurrency)
+    {
+        return FALSE;
+    }
+
+    /* Every index from next_emit on is in flight or held */
+    return !batch->ordered ||
+           batch->next_index - batch->next_emit < batch->max_pending;
+}
+
+static void
+batch_fill_window (BatchContext *batch)
+{
+    if (!batch->input_done && !batch->reading && batch_has_room (batch))
+    {
+        batch->reading = TRUE;
+        g_data_input_stream_read_line_async (batch->input, G_PRIORITY_DEFAULT, NULL,
+                                             on_batch_line_read, batch);
+    }
+
+    if (batch->input_done && !batch->reading && batch->in_flight == 0)
+    {
+        g_main_loop_quit (batch->loop);
+    }
+}
+
+static GInputStream *
+batch_open_input (const gchar  *path,
+                  GError      **error)
+{
+    g_autoptr(GFile) file = NULL;
+
+    if (g_strcmp0 (path, "-") == 0)
+    {
+        return g_unix_input_stream_new (STDIN_FILENO, FALSE);
+    }
+
+    file = g_file_new_for_commandline_arg (path);
+    return G_INPUT_STREAM (g_file_read (file, NULL, error));
+}
+
+static void
+batch_print_summary (BatchContext *batch,
+                     gdouble       elapsed_s)
+{
+    guint total;
+
+    total = batch->n_ok + batch->n_tool_errors + batch->n_failed;
+    mcp_cli_sort_samples (batch->latencies);
+
+    g_printerr ("\nBatch: %u calls (%u ok, %u tool errors, %u failed) in %.3f s",
+                total, batch->n_ok, batch->n_tool_errors, batch->n_failed,
+                elapsed_s);
+    if (elapsed_s > 0.0)
+    {
+        g_printerr (", %.1f calls/s", total / elapsed_s);
+    }
+    g_printerr ("\n");
+
+    if (batch->latencies->len > 0)
+    {
+        g_printerr ("Latency (ms): p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+                    mcp_cli_latency_percentile (batch->latencies, 50.0),
+                    mcp_cli_latency_percentile (batch->latencies, 90.0),
+                    mcp_cli_latency_percentile (batch->latencies, 99.0),
+                    mcp_cli_latency_percentile (batch->latencies, 100.0));
+    }
+}
+
+/*
+ * run_batch:
+ *
+ * Pipelines every call spec in @path over the already-connected
+ * @client and returns the process exit code.
+ */
+static gint
+run_batch (McpClient   *client,
+           const gchar *path)
+{
+    g_autoptr(GInputStream) stream = NULL;
+    g_autoptr(GError) error = NULL;
+    BatchContext batch;
+    gint64 start_us;
+    gint exit_code;
+
+    stream = batch_open_input (path, &error);
+    if (stream == NULL)
+    {
+        g_printerr ("Error opening batch input '%s': %s\n", path, error->message);
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    memset (&batch, 0, sizeof (batch));
+    batch.loop = g_main_loop_new (NULL, FALSE);
+    batch.client = client;
+    batch.input = g_data_input_stream_new (stream);
+    g_data_input_stream_set_newline_type (batch.input, G_DATA_STREAM_NEWLINE_TYPE_ANY);
+    batch.concurrency = (opt_concurrency > 0) ? (guint)opt_concurrency : 1;
+    batch.max_pending = (batch.concurrency <= G_MAXUINT / (BATCH_REORDER_FACTOR + 1))
+                        ? batch.concurrency * (BATCH_REORDER_FACTOR + 1)
+                        : G_MAXUINT;
+    batch.ordered = opt_ordered;
+    batch.held_lines = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              NULL, g_free);
+    batch.latencies = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+    start_us = g_get_monotonic_time ();
+
+    batch_fill_window (&batch);
+    g_main_loop_run (batch.loop);
+
+    if (!mcp_cli_opt_quiet)
+    {
+        batch_print_summary (&batch, (g_get_monotonic_time () - start_us) / 1e6);
+    }
+
+    if (batch.n_failed > 0)
+    {
+        exit_code = MCP_CLI_EXIT_ERROR;
+    }
+    else if (batch.n_tool_errors > 0)
+    {
+        exit_code = MCP_CLI_EXIT_TOOL_ERROR;
+    }
+    else
+    {
+        exit_code = MCP_CLI_EXIT_SUCCESS;
+    }
+
+    g_main_loop_unref (batch.loop);
+    g_object_unref (batch.input);
+    g_hash_table_unref (batch.held_lines);
+    g_array_unref (batch.latencies);
+
+    return exit_code;
+}
+
 /* ========================================================================== */
 /* Main entry point                                                            */
 /* ========================================================================== */
@@ -57,6 +527,11 @@ static const gchar *description =
     "  mcp-call --http https://api.example.com/mcp -- add '{\"a\": 5, \"b\": 3}'\n"
     "  mcp-call -s ./calculator-server -- sqrt '{\"n\": 16}'\n"
     "\n"
+    "Batch mode (--batch FILE, or '-' for stdin) reads one call per line:\n"
+    "  {\"id\": 1, \"name\": \"add\", \"arguments\": {\"a\": 5, \"b\": 3}}\n"
+    "Calls are pipelined over one connection, results are printed as NDJSON\n"
+    "and a throughput/latency summary is written to stderr.\n"
+    "\n"
     "Exit codes:\n"
     "  0  Success\n"
     "  1  Connection/transport error\n"
@@ -75,7 +550,7 @@ main (int    argc,
     g_autoptr(McpTransport) transport = NULL;
     g_autoptr(JsonObject) args = NULL;
     CallContext ctx;
-    const gchar *tool_name;
+    const gchar *tool_name = NULL;
     const gchar *json_args;
     gint exit_code;
 
@@ -83,6 +558,7 @@ main (int    argc,
     context = g_option_context_new ("-- TOOL_NAME [JSON_ARGUMENTS]");
     g_option_context_set_description (context, description);
     g_option_context_add_main_entries (context, mcp_cli_get_common_options (), NULL);
+    g_option_context_add_main_entries (context, call_entries, NULL);
 
     if (!g_option_context_parse (context, &argc, &argv, &error))
     {
@@ -98,22 +574,25 @@ main (int    argc,
     }
 
     /* Get tool name and arguments from remaining args */
-    if (argc < 2)
+    if (opt_batch == NULL)
     {
-        g_printerr ("Error: Tool name required\n");
-        g_printerr ("Usage: mcp-call [OPTIONS] -- TOOL_NAME [JSON_ARGUMENTS]\n");
-        return MCP_CLI_EXIT_ERROR;
-    }
+        if (argc < 2)
+        {
+            g_printerr ("Error: Tool name required\n");
+            g_printerr ("Usage: mcp-call [OPTIONS] -- TOOL_NAME [JSON_ARGUMENTS]\n");
+            return MCP_CLI_EXIT_ERROR;
+        }
 
-    tool_name = argv[1];
-    json_args = (argc >= 3) ? argv[2] : NULL;
+        tool_name = argv[1];
+        json_args = (argc >= 3) ? argv[2] : NULL;
 
-    /* Parse JSON arguments if provided */
-    args = mcp_cli_parse_json_args (json_args, &error);
-    if (args == NULL)
-    {
-        g_printerr ("Error parsing arguments: %s\n", error->message);
-        return MCP_CLI_EXIT_ERROR;
+        /* Parse JSON arguments if provided */
+        args = mcp_cli_parse_json_args (json_args, &error);
+        if (args == NULL)
+        {
+            g_printerr ("Error parsing arguments: %s\n", error->message);
+            return MCP_CLI_EXIT_ERROR;
+        }
     }
 
     /* Create transport */
@@ -128,7 +607,7 @@ main (int    argc,
     client = mcp_client_new ("mcp-call", "1.0.0");
     mcp_client_set_transport (client, transport);
 
-    if (!mcp_cli_opt_quiet && !mcp_cli_opt_json)
+    if (!mcp_cli_opt_quiet && !mcp_cli_opt_json && opt_batch == NULL)
     {
         g_print ("Connecting...\n");
     }
@@ -139,6 +618,14 @@ main (int    argc,
         return MCP_CLI_EXIT_ERROR;
     }
 
+    /* Batch mode: stdout carries NDJSON results only */
+    if (opt_batch != NULL)
+    {
+        exit_code = run_batch (client, opt_batch);
+        mcp_cli_disconnect_sync (client, NULL);
+        return exit_code;
+    }
+
     /* Initialize call context */
     memset (&ctx, 0, sizeof (ctx));
     ctx.loop = g_main_loop_new (NULL, FALSE);
@@ -6,6 +6,7 @@
  */
 
 #include "mcp-common.h"
+#include <gio/gunixsocketaddress.h>
 #include <string.h>
 
 /* ========================================================================== */
@@ -20,6 +21,7 @@ gint      mcp_cli_opt_timeout = 30;
 gboolean  mcp_cli_opt_json    = FALSE;
 gboolean  mcp_cli_opt_quiet   = FALSE;
 gboolean  mcp_cli_opt_license = FALSE;
+gboolean  mcp_cli_opt_broker  = FALSE;
 
 /* ========================================================================== */
 /* Common option entries                                                       */
@@ -40,6 +42,8 @@ static GOptionEntry common_entries[] = {
       "Output in JSON format", NULL },
     { "quiet", 'q', 0, G_OPTION_ARG_NONE, &mcp_cli_opt_quiet,
       "Suppress non-essential output", NULL },
+    { "broker", 'B', 0, G_OPTION_ARG_NONE, &mcp_cli_opt_broker,
+      "Reuse a warm connection held by mcp-broker", NULL },
     { "license", 0, 0, G_OPTION_ARG_NONE, &mcp_cli_opt_license,
       "Show license information", NULL },
     { NULL }
@@ -62,21 +66,289 @@ mcp_cli_reset_options (void)
     mcp_cli_opt_json    = FALSE;
     mcp_cli_opt_quiet   = FALSE;
     mcp_cli_opt_license = FALSE;
+    mcp_cli_opt_broker  = FALSE;
+}
+
+/* ========================================================================== */
+/* Connection broker client                                                    */
+/* ========================================================================== */
+
+/*
+ * A CLI run with --broker (or MCP_CLI_BROKER=1) connects to mcp-broker
+ * over a Unix socket instead of spawning the server itself.  It sends
+ * one hello line naming the upstream, waits for {"ok": true}, and from
+ * then on the socket carries ordinary NDJSON JSON-RPC, so the returned
+ * transport is a plain McpStdioTransport over the socket streams.
+ */
+
+#define BROKER_SPAWN_ATTEMPTS   (100)
+#define BROKER_SPAWN_DELAY_US   (20000)
+
+gchar *
+mcp_cli_broker_socket_path (void)
+{
+    const gchar *env_path;
+
+    env_path = g_getenv ("MCP_BROKER_SOCKET");
+    if (env_path != NULL && env_path[0] != '\0')
+    {
+        return g_strdup (env_path);
+    }
+
+    return g_build_filename (g_get_user_runtime_dir (), "mcp-glib",
+                             "broker.sock", NULL);
+}
+
+static GSocketConnection *
+broker_try_connect (const gchar  *path,
+                    GError      **error)
+{
+    g_autoptr(GSocketClient) client = g_socket_client_new ();
+    g_autoptr(GSocketAddress) address = NULL;
+
+    address = g_unix_socket_address_new (path);
+    return g_socket_client_connect (client, G_SOCKET_CONNECTABLE (address),
+                                    NULL, error);
+}
+
+/*
+ * broker_spawn:
+ *
+ * Starts a detached mcp-broker.  A binary next to the running tool is
+ * preferred so an uninstalled build tree uses its own broker.
+ */
+static gboolean
+broker_spawn (const gchar  *path,
+              GError      **error)
+{
+    g_autofree gchar *self_exe = NULL;
+    g_autofree gchar *sibling = NULL;
+    const gchar *argv[5];
+    GSpawnFlags flags;
+
+    flags = G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL;
+
+    self_exe = g_file_read_link ("/proc/self/exe", NULL);
+    if (self_exe != NULL)
+    {
+        g_autofree gchar *dir = g_path_get_dirname (self_exe);
+
+        sibling = g_build_filename (dir, "mcp-broker", NULL);
+    }
+
+    if (sibling != NULL && g_file_test (sibling, G_FILE_TEST_IS_EXECUTABLE))
+    {
+        argv[0] = sibling;
+    }
+    else
+    {
+        argv[0] = "mcp-broker";
+        flags |= G_SPAWN_SEARCH_PATH;
+    }
+    argv[1] = "--daemon";
+    argv[2] = "--socket";
+    argv[3] = path;
+    argv[4] = NULL;
+
+    return g_spawn_async (NULL, (gchar **)argv, NULL, flags,
+                          NULL, NULL, NULL, error);
+}
+
+static gchar *
+broker_build_hello (void)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    g_autoptr(JsonGenerator) gen = json_generator_new ();
+    g_autoptr(JsonNode) root = NULL;
+    g_autofree gchar *cwd = g_get_current_dir ();
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "mcpBroker");
+    json_builder_add_int_value (builder, MCP_CLI_BROKER_PROTOCOL);
+    if (mcp_cli_opt_stdio != NULL)
+    {
+        json_builder_set_member_name (builder, "stdio");
+        json_builder_add_string_value (builder, mcp_cli_opt_stdio);
+        json_builder_set_member_name (builder, "cwd");
+        json_builder_add_string_value (builder, cwd);
+    }
+    if (mcp_cli_opt_http != NULL)
+    {
+        json_builder_set_member_name (builder, "http");
+        json_builder_add_string_value (builder, mcp_cli_opt_http);
+    }
+    if (mcp_cli_opt_ws != NULL)
+    {
+        json_builder_set_member_name (builder, "ws");
+        json_builder_add_string_value (builder, mcp_cli_opt_ws);
+    }
+    if (mcp_cli_opt_token != NULL)
+    {
+        json_builder_set_member_name (builder, "token");
+        json_builder_add_string_value (builder, mcp_cli_opt_token);
+    }
+    json_builder_set_member_name (builder, "timeout");
+    json_builder_add_int_value (builder, mcp_cli_opt_timeout);
+    json_builder_end_object (builder);
+
+    root = json_builder_get_root (builder);
+    json_generator_set_root (gen, root);
+    return json_generator_to_data (gen, NULL);
+}
+
+/*
+ * broker_check_reply:
+ *
+ * Parses the broker's reply to the hello line.
+ */
+static gboolean
+broker_check_reply (const gchar  *line,
+                    GError      **error)
+{
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    JsonNode *root;
+    JsonObject *obj;
+
+    if (line == NULL || !json_parser_load_from_data (parser, line, -1, NULL))
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                     "Invalid reply from mcp-broker");
+        return FALSE;
+    }
+
+    root = json_parser_get_root (parser);
+    if (root == NULL || !JSON_NODE_HOLDS_OBJECT (root))
+    {
+        g_set_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                     "Invalid reply from mcp-broker");
+        return FALSE;
+    }
+
+    obj = json_node_get_object (root);
+    if (!json_object_has_member (obj, "ok") ||
+        !json_object_get_boolean_member (obj, "ok"))
+    {
+        const gchar *message = NULL;
+
+        if (json_object_has_member (obj, "error"))
+        {
+            message = json_object_get_string_member (obj, "error");
+        }
+
+        g_set_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                     "mcp-broker: %s",
+                     message != NULL ? message : "request refused");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * broker_transport_new:
+ *
+ * Connects to the broker (starting it on first use), performs the hello
+ * exchange and returns a transport over the socket.
+ */
+static McpTransport *
+broker_transport_new (GError **error)
+{
+    g_autofree gchar *path = mcp_cli_broker_socket_path ();
+    g_autofree gchar *hello = NULL;
+    g_autofree gchar *reply = NULL;
+    g_autoptr(GSocketConnection) connection = NULL;
+    g_autoptr(GDataInputStream) input = NULL;
+    g_autoptr(GError) local_error = NULL;
+    McpStdioTransport *transport;
+    GOutputStream *output;
+    GSocket *socket;
+    guint attempt;
+
+    connection = broker_try_connect (path, NULL);
+    if (connection == NULL)
+    {
+        g_autofree gchar *dir = g_path_get_dirname (path);
+
+        g_mkdir_with_parents (dir, 0700);
+        if (!broker_spawn (path, error))
+        {
+            return NULL;
+        }
+
+        for (attempt = 0; connection == NULL && attempt < BROKER_SPAWN_ATTEMPTS; attempt++)
+        {
+            g_usleep (BROKER_SPAWN_DELAY_US);
+            g_clear_error (&local_error);
+            connection = broker_try_connect (path, &local_error);
+        }
+
+        if (connection == NULL)
+        {
+            g_set_error (error, MCP_ERROR, MCP_ERROR_CONNECTION_CLOSED,
+                         "Could not reach mcp-broker at %s: %s", path,
+                         local_error != NULL ? local_error->message : "timed out");
+            return NULL;
+        }
+    }
+
+    /* Bound the hello exchange; the session itself has no timeout */
+    socket = g_socket_connection_get_socket (connection);
+    g_socket_set_timeout (socket, mcp_cli_opt_timeout > 0 ? (guint)mcp_cli_opt_timeout : 0);
+
+    hello = broker_build_hello ();
+    output = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+    if (!g_output_stream_write_all (output, hello, strlen (hello), NULL, NULL, error) ||
+        !g_output_stream_write_all (output, "\n", 1, NULL, NULL, error))
+    {
+        return NULL;
+    }
+
+    /* The same buffered stream is handed to the transport, so nothing
+     * the broker sends after the reply can be lost. */
+    input = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (connection)));
+    g_data_input_stream_set_newline_type (input, G_DATA_STREAM_NEWLINE_TYPE_LF);
+
+    reply = g_data_input_stream_read_line (input, NULL, NULL, &local_error);
+    if (local_error != NULL)
+    {
+        g_propagate_error (error, g_steal_pointer (&local_error));
+        return NULL;
+    }
+    if (!broker_check_reply (reply, error))
+    {
+        return NULL;
+    }
+
+    g_socket_set_timeout (socket, 0);
+
+    transport = mcp_stdio_transport_new_with_streams (G_INPUT_STREAM (input), output);
+    g_object_set_data_full (G_OBJECT (transport), "mcp-cli-broker-connection",
+                            g_steal_pointer (&connection), g_object_unref);
+
+    return MCP_TRANSPORT (transport);
 }
 
 /* ========================================================================== */
 /* Transport creation                                                          */
 /* ========================================================================== */
 
-McpTransport *
-mcp_cli_create_transport (GError **error)
+/*
+ * check_transport_options:
+ *
+ * Verifies that exactly one transport was requested.
+ */
+static gboolean
+check_transport_options (const gchar  *stdio,
+                         const gchar  *http,
+                         const gchar  *ws,
+                         GError      **error)
 {
     gint transport_count;
 
     transport_count = 0;
-    if (mcp_cli_opt_stdio != NULL) transport_count++;
-    if (mcp_cli_opt_http != NULL) transport_count++;
-    if (mcp_cli_opt_ws != NULL) transport_count++;
+    if (stdio != NULL) transport_count++;
+    if (http != NULL) transport_count++;
+    if (ws != NULL) transport_count++;
 
     if (transport_count == 0)
     {
@@ -84,7 +356,7 @@ mcp_cli_create_transport (GError **error)
                      MCP_ERROR,
                      MCP_ERROR_INVALID_PARAMS,
                      "No transport specified. Use --stdio, --http, or --ws");
-        return NULL;
+        return FALSE;
     }
 
     if (transport_count > 1)
@@ -93,15 +365,66 @@ mcp_cli_create_transport (GError **error)
                      MCP_ERROR,
                      MCP_ERROR_INVALID_PARAMS,
                      "Multiple transports specified. Use only one of --stdio, --http, or --ws");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+McpTransport *
+mcp_cli_create_transport (GError **error)
+{
+    const gchar *env_broker;
+
+    if (!check_transport_options (mcp_cli_opt_stdio, mcp_cli_opt_http,
+                                  mcp_cli_opt_ws, error))
+    {
+        return NULL;
+    }
+
+    env_broker = g_getenv ("MCP_CLI_BROKER");
+    if (mcp_cli_opt_broker ||
+        (env_broker != NULL && env_broker[0] != '\0' && g_strcmp0 (env_broker, "0") != 0))
+    {
+        return broker_transport_new (error);
+    }
+
+    return mcp_cli_create_direct_transport (mcp_cli_opt_stdio,
+                                            NULL,
+                                            mcp_cli_opt_http,
+                                            mcp_cli_opt_ws,
+                                            mcp_cli_opt_token,
+                                            mcp_cli_opt_timeout,
+                                            error);
+}
+
+McpTransport *
+mcp_cli_create_direct_transport (const gchar  *stdio,
+                                 const gchar  *cwd,
+                                 const gchar  *http,
+                                 const gchar  *ws,
+                                 const gchar  *token,
+                                 gint          timeout_seconds,
+                                 GError      **error)
+{
+    if (!check_transport_options (stdio, http, ws, error))
+    {
         return NULL;
     }
 
     /* Create stdio transport */
-    if (mcp_cli_opt_stdio != NULL)
+    if (stdio != NULL)
     {
         McpStdioTransport *transport;
+        g_auto(GStrv) argv = NULL;
 
-        transport = mcp_stdio_transport_new_subprocess_simple (mcp_cli_opt_stdio, error);
+        if (!g_shell_parse_argv (stdio, NULL, &argv, error))
+        {
+            return NULL;
+        }
+
+        transport = mcp_stdio_transport_new_subprocess_full ((const gchar * const *)argv,
+                                                             cwd, error);
         if (transport == NULL)
         {
             return NULL;
@@ -111,46 +434,38 @@ mcp_cli_create_transport (GError **error)
     }
 
     /* Create HTTP transport */
-    if (mcp_cli_opt_http != NULL)
+    if (http != NULL)
     {
         McpHttpTransport *transport;
 
-        transport = mcp_http_transport_new (mcp_cli_opt_http);
+        transport = mcp_http_transport_new (http);
 
-        if (mcp_cli_opt_token != NULL)
+        if (token != NULL)
         {
-            mcp_http_transport_set_auth_token (transport, mcp_cli_opt_token);
+            mcp_http_transport_set_auth_token (transport, token);
         }
 
-        if (mcp_cli_opt_timeout > 0)
+        if (timeout_seconds > 0)
         {
-            mcp_http_transport_set_timeout (transport, (guint)mcp_cli_opt_timeout);
+            mcp_http_transport_set_timeout (transport, (guint)timeout_seconds);
         }
 
         return MCP_TRANSPORT (transport);
     }
 
     /* Create WebSocket transport */
-    if (mcp_cli_opt_ws != NULL)
     {
         McpWebSocketTransport *transport;
 
-        transport = mcp_websocket_transport_new (mcp_cli_opt_ws);
+        transport = mcp_websocket_transport_new (ws);
 
-        if (mcp_cli_opt_token != NULL)
+        if (token != NULL)
         {
-            mcp_websocket_transport_set_auth_token (transport, mcp_cli_opt_token);
+            mcp_websocket_transport_set_auth_token (transport, token);
         }
 
         return MCP_TRANSPORT (transport);
     }
-
-    /* Should not reach here */
-    g_set_error (error,
-                 MCP_ERROR,
-                 MCP_ERROR_INTERNAL_ERROR,
-                 "Internal error: no transport created");
-    return NULL;
 }
 
 /* ========================================================================== */
@@ -514,6 +829,81 @@ mcp_cli_print_resource_contents (GList    *contents,
     }
 }
 
+/*
+ * BLOB_CHUNK_SIZE:
+ *
+ * Base64 characters decoded per write.  A multiple of 4 so each chunk
+ * decodes to whole bytes; 64 KiB of input yields 48 KiB of output.
+ */
+#define BLOB_CHUNK_SIZE (64 * 1024)
+
+gboolean
+mcp_cli_write_resource_contents (GList         *contents,
+                                 GOutputStream *stream,
+                                 gsize         *bytes_written,
+                                 GCancellable  *cancellable,
+                                 GError       **error)
+{
+    g_autofree guchar *buffer = NULL;
+    gsize total = 0;
+    GList *l;
+
+    for (l = contents; l != NULL; l = l->next)
+    {
+        McpResourceContents *c = l->data;
+        const gchar *text = mcp_resource_contents_get_text (c);
+        const gchar *blob = mcp_resource_contents_get_blob (c);
+
+        if (text != NULL)
+        {
+            gsize len = strlen (text);
+
+            if (!g_output_stream_write_all (stream, text, len, NULL,
+                                            cancellable, error))
+            {
+                return FALSE;
+            }
+            total += len;
+        }
+        else if (blob != NULL)
+        {
+            gsize remaining = strlen (blob);
+            gint state = 0;
+            guint save = 0;
+
+            if (buffer == NULL)
+            {
+                buffer = g_malloc ((BLOB_CHUNK_SIZE / 4) * 3 + 3);
+            }
+
+            while (remaining > 0)
+            {
+                gsize chunk = MIN (remaining, BLOB_CHUNK_SIZE);
+                gsize decoded;
+
+                decoded = g_base64_decode_step (blob, chunk, buffer, &state, &save);
+                if (decoded > 0 &&
+                    !g_output_stream_write_all (stream, buffer, decoded, NULL,
+                                                cancellable, error))
+                {
+                    return FALSE;
+                }
+
+                total += decoded;
+                blob += chunk;
+                remaining -= chunk;
+            }
+        }
+    }
+
+    if (bytes_written != NULL)
+    {
+        *bytes_written = total;
+    }
+
+    return TRUE;
+}
+
 void
 mcp_cli_print_prompt_result (McpPromptResult *result,
                              gboolean         json_mode)
@@ -943,3 +1333,231 @@ mcp_cli_parse_prompt_args (gchar **args,
 
     return table;
 }
+
+static JsonObject *sample_object (JsonObject *schema);
+
+/*
+ * first_array_element:
+ *
+ * Returns a copy of the first element of array member @name, if any.
+ */
+static JsonNode *
+first_array_element (JsonObject  *obj,
+                     const gchar *name)
+{
+    JsonNode *node;
+    JsonArray *array;
+
+    node = json_object_get_member (obj, name);
+    if (node == NULL || !JSON_NODE_HOLDS_ARRAY (node))
+    {
+        return NULL;
+    }
+
+    array = json_node_get_array (node);
+    if (json_array_get_length (array) == 0)
+    {
+        return NULL;
+    }
+
+    return json_node_copy (json_array_get_element (array, 0));
+}
+
+static const gchar *
+schema_type (JsonObject *prop)
+{
+    JsonNode *node;
+
+    node = json_object_get_member (prop, "type");
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    /* "type": ["string", "null"] - take the first listed type */
+    if (JSON_NODE_HOLDS_ARRAY (node))
+    {
+        JsonArray *types = json_node_get_array (node);
+
+        if (json_array_get_length (types) == 0)
+        {
+            return NULL;
+        }
+        node = json_array_get_element (types, 0);
+    }
+
+    if (!JSON_NODE_HOLDS_VALUE (node) || json_node_get_value_type (node) != G_TYPE_STRING)
+    {
+        return NULL;
+    }
+
+    return json_node_get_string (node);
+}
+
+static JsonNode *
+sample_value (JsonObject *prop)
+{
+    JsonNode *value;
+    const gchar *type;
+
+    if (json_object_has_member (prop, "default"))
+    {
+        return json_node_copy (json_object_get_member (prop, "default"));
+    }
+    if ((value = first_array_element (prop, "enum")) != NULL ||
+        (value = first_array_element (prop, "examples")) != NULL)
+    {
+        return value;
+    }
+
+    type = schema_type (prop);
+    value = json_node_new (JSON_NODE_VALUE);
+
+    if (g_strcmp0 (type, "integer") == 0)
+    {
+        json_node_set_int (value, 1);
+    }
+    else if (g_strcmp0 (type, "number") == 0)
+    {
+        json_node_set_double (value, 1.0);
+    }
+    else if (g_strcmp0 (type, "boolean") == 0)
+    {
+        json_node_set_boolean (value, FALSE);
+    }
+    else if (g_strcmp0 (type, "array") == 0)
+    {
+        json_node_unref (value);
+        value = json_node_new (JSON_NODE_ARRAY);
+        json_node_take_array (value, json_array_new ());
+    }
+    else if (g_strcmp0 (type, "object") == 0)
+    {
+        json_node_unref (value);
+        value = json_node_new (JSON_NODE_OBJECT);
+        json_node_take_object (value, sample_object (prop));
+    }
+    else if (g_strcmp0 (type, "null") == 0)
+    {
+        json_node_unref (value);
+        value = json_node_new (JSON_NODE_NULL);
+    }
+    else
+    {
+        json_node_set_string (value, "sample");
+    }
+
+    return value;
+}
+
+static JsonObject *
+sample_object (JsonObject *schema)
+{
+    JsonObject *args;
+    JsonObject *properties;
+    JsonArray *required;
+    JsonNode *node;
+    guint i;
+
+    args = json_object_new ();
+
+    node = json_object_get_member (schema, "properties");
+    if (node == NULL || !JSON_NODE_HOLDS_OBJECT (node))
+    {
+        return args;
+    }
+    properties = json_node_get_object (node);
+
+    node = json_object_get_member (schema, "required");
+    if (node == NULL || !JSON_NODE_HOLDS_ARRAY (node))
+    {
+        return args;
+    }
+    required = json_node_get_array (node);
+
+    for (i = 0; i < json_array_get_length (required); i++)
+    {
+        JsonNode *name_node = json_array_get_element (required, i);
+        JsonNode *prop;
+        const gchar *name;
+
+        if (!JSON_NODE_HOLDS_VALUE (name_node) ||
+            json_node_get_value_type (name_node) != G_TYPE_STRING)
+        {
+            continue;
+        }
+        name = json_node_get_string (name_node);
+
+        prop = json_object_get_member (properties, name);
+        if (prop != NULL && JSON_NODE_HOLDS_OBJECT (prop))
+        {
+            json_object_set_member (args, name, sample_value (json_node_get_object (prop)));
+        }
+        else
+        {
+            json_object_set_string_member (args, name, "sample");
+        }
+    }
+
+    return args;
+}
+
+JsonObject *
+mcp_cli_sample_arguments (JsonNode *schema)
+{
+    if (schema == NULL || !JSON_NODE_HOLDS_OBJECT (schema))
+    {
+        return json_object_new ();
+    }
+
+    return sample_object (json_node_get_object (schema));
+}
+
+/* ========================================================================== */
+/* Latency statistics                                                          */
+/* ========================================================================== */
+
+static gint
+compare_samples (gconstpointer a,
+                 gconstpointer b)
+{
+    gdouble da = *(const gdouble *)a;
+    gdouble db = *(const gdouble *)b;
+
+    return (da > db) - (da < db);
+}
+
+void
+mcp_cli_sort_samples (GArray *samples)
+{
+    g_return_if_fail (samples != NULL);
+
+    g_array_sort (samples, compare_samples);
+}
+
+gdouble
+mcp_cli_latency_percentile (GArray  *samples,
+                            gdouble  percentile)
+{
+    gdouble exact;
+    guint rank;
+
+    g_return_val_if_fail (samples != NULL, 0.0);
+
+    if (samples->len == 0)
+    {
+        return 0.0;
+    }
+
+    /* Nearest-rank method: the smallest sample such that at least
+     * @percentile percent of the samples are less than or equal to it. */
+    exact = CLAMP (percentile, 0.0, 100.0) / 100.0 * samples->len;
+    rank = (guint)exact;
+    if ((gdouble)rank < exact)
+    {
+        rank++;
+    }
+    rank = CLAMP (rank, 1, samples->len);
+
+    return g_array_index (samples, gdouble, rank - 1);
+}
@@ -7,8 +7,10 @@
  * This file provides common functionality shared across all MCP CLI tools:
  * - Command-line option parsing helpers
  * - Transport creation from parsed options
+ * - Connection broker client (--broker)
  * - Synchronous client connection
  * - Output formatting for tools, resources, prompts
+ * - Latency statistics for batch and benchmark modes
  * - License display
  */
 
@@ -56,6 +58,13 @@ G_BEGIN_DECLS
 #define MCP_CLI_EXIT_NOT_FOUND      (2)
 #define MCP_CLI_EXIT_TOOL_ERROR     (3)
 
+/*
+ * MCP_CLI_BROKER_PROTOCOL:
+ *
+ * Version of the hello line exchanged with mcp-broker.
+ */
+#define MCP_CLI_BROKER_PROTOCOL     (1)
+
 /*
  * Common option variables.
  * Declare these as extern in each tool and define in mcp-common.c.
@@ -68,6 +77,7 @@ extern gint      mcp_cli_opt_timeout;
 extern gboolean  mcp_cli_opt_json;
 extern gboolean  mcp_cli_opt_quiet;
 extern gboolean  mcp_cli_opt_license;
+extern gboolean  mcp_cli_opt_broker;
 
 /*
  * mcp_cli_get_common_options:
@@ -98,6 +108,40 @@ void mcp_cli_reset_options (void);
  */
 McpTransport *mcp_cli_create_transport (GError **error);
 
+/*
+ * mcp_cli_create_direct_transport:
+ * @stdio: (nullable): command line for a stdio subprocess
+ * @cwd: (nullable): working directory for @stdio, or %NULL for ours
+ * @http: (nullable): URL for an HTTP transport
+ * @ws: (nullable): URL for a WebSocket transport
+ * @token: (nullable): bearer token for HTTP/WebSocket
+ * @timeout_seconds: HTTP request timeout (0 for default)
+ * @error: (nullable): return location for a #GError
+ *
+ * Creates a transport straight to the server, bypassing the broker.
+ * Exactly one of @stdio, @http, or @ws must be non-%NULL.
+ *
+ * Returns: (transfer full) (nullable): a new #McpTransport, or %NULL on error
+ */
+McpTransport *mcp_cli_create_direct_transport (const gchar  *stdio,
+                                               const gchar  *cwd,
+                                               const gchar  *http,
+                                               const gchar  *ws,
+                                               const gchar  *token,
+                                               gint          timeout_seconds,
+                                               GError      **error);
+
+/*
+ * mcp_cli_broker_socket_path:
+ *
+ * Gets the Unix socket path of the connection broker.  This is
+ * $MCP_BROKER_SOCKET if set, otherwise mcp-glib/broker.sock in the
+ * user runtime directory.
+ *
+ * Returns: (transfer full): the socket path
+ */
+gchar *mcp_cli_broker_socket_path (void);
+
 /*
  * mcp_cli_connect_sync:
  * @client: an #McpClient with transport already set
@@ -162,6 +206,27 @@ void mcp_cli_print_tool_result (McpToolResult *result,
 void mcp_cli_print_resource_contents (GList    *contents,
                                       gboolean  json_mode);
 
+/*
+ * mcp_cli_write_resource_contents:
+ * @contents: (element-type McpResourceContents): list of contents
+ * @stream: the #GOutputStream to write to
+ * @bytes_written: (out) (optional): total bytes written
+ * @cancellable: (nullable): a #GCancellable
+ * @error: (nullable): return location for a #GError
+ *
+ * Writes the raw payload of each content item to @stream in order.
+ * Text is written as-is; blobs are base64-decoded in fixed-size chunks
+ * straight into the stream, so no decoded copy of a blob is held in
+ * memory next to @contents.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ */
+gboolean mcp_cli_write_resource_contents (GList         *contents,
+                                          GOutputStream *stream,
+                                          gsize         *bytes_written,
+                                          GCancellable  *cancellable,
+                                          GError       **error);
+
 /*
  * mcp_cli_print_prompt_result:
  * @result: (transfer none): the #McpPromptResult to print
@@ -238,6 +303,40 @@ JsonObject *mcp_cli_parse_json_args (const gchar  *json_str,
 GHashTable *mcp_cli_parse_prompt_args (gchar **args,
                                        gint    n_args);
 
+/*
+ * mcp_cli_sample_arguments:
+ * @schema: (nullable): a tool input schema
+ *
+ * Builds placeholder arguments that satisfy the required properties of
+ * a JSON Schema object.  Each value comes from the property's "default",
+ * first "enum" or "examples" entry, or else a fixed value for its type.
+ * Used by benchmark mode to call tools without user input.
+ *
+ * Returns: (transfer full): a #JsonObject of sample arguments
+ */
+JsonObject *mcp_cli_sample_arguments (JsonNode *schema);
+
+/*
+ * mcp_cli_sort_samples:
+ * @samples: (element-type gdouble): latency samples
+ *
+ * Sorts a sample array in ascending order, as required by
+ * mcp_cli_latency_percentile().
+ */
+void mcp_cli_sort_samples (GArray *samples);
+
+/*
+ * mcp_cli_latency_percentile:
+ * @samples: (element-type gdouble): latency samples, sorted ascending
+ * @percentile: the percentile to compute (0.0 to 100.0)
+ *
+ * Computes the nearest-rank percentile of a sorted sample array.
+ *
+ * Returns: the percentile value, or 0.0 if @samples is empty
+ */
+gdouble mcp_cli_latency_percentile (GArray  *samples,
+                                    gdouble  percentile);
+
 G_END_DECLS
 
 #endif /* MCP_COMMON_H */
@@ -11,9 +11,53 @@
  *   mcp-inspect --stdio ./my-server
  *   mcp-inspect --http https://api.example.com/mcp --token "secret"
  *   mcp-inspect --ws wss://example.com/mcp --json
+ *   mcp-inspect --stdio ./my-server --bench --iterations 50
+ *   mcp-inspect --bench-sessions 10000
+ *   mcp-inspect --bench-parse --iterations 20
+ *   mcp-inspect --bench-dispatch --bench-transport shm --iterations 10000
  */
 
 #include "mcp-common.h"
+#include <string.h>
+
+#ifndef MCP_NO_STDIO_TRANSPORT
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#if __GLIBC_PREREQ (2, 33)
+#define HAVE_MALLINFO2 1
+#endif
+#endif
+
+/* Tool-specific options */
+static gboolean opt_bench = FALSE;
+static gint     opt_iterations = 10;
+static gint     opt_bench_sessions = 0;
+static gboolean opt_bench_parse = FALSE;
+static gboolean opt_bench_dispatch = FALSE;
+static gchar   *opt_bench_transport = NULL;
+static gboolean opt_bench_no_arena = FALSE;
+
+static GOptionEntry inspect_entries[] = {
+    { "bench", 'b', 0, G_OPTION_ARG_NONE, &opt_bench,
+      "Time read-only tools, resources and prompts", NULL },
+    { "iterations", 'n', 0, G_OPTION_ARG_INT, &opt_iterations,
+      "Calls per item in benchmark mode (default: 10)", "K" },
+    { "bench-sessions", 0, 0, G_OPTION_ARG_INT, &opt_bench_sessions,
+      "Measure the heap used by N idle in-process servers, then exit", "N" },
+    { "bench-parse", 0, 0, G_OPTION_ARG_NONE, &opt_bench_parse,
+      "Measure JSON parse throughput of each parser backend, then exit", NULL },
+    { "bench-dispatch", 0, 0, G_OPTION_ARG_NONE, &opt_bench_dispatch,
+      "Time K tool calls to an in-process server, then exit", NULL },
+    { "bench-transport", 0, 0, G_OPTION_ARG_STRING, &opt_bench_transport,
+      "Transport for --bench-dispatch: socket (default), shm or seqpacket", "NAME" },
+    { "bench-no-arena", 0, 0, G_OPTION_ARG_NONE, &opt_bench_no_arena,
+      "Dispatch --bench-dispatch requests without the per-message arena", NULL },
+    { NULL }
+};
 
 /* ========================================================================== */
 /* Async operation context                                                     */
@@ -95,6 +139,968 @@ on_list_prompts_complete (GObject      *source,
     }
 }
 
+/* ========================================================================== */
+/* Benchmark mode                                                              */
+/* ========================================================================== */
+
+/*
+ * Benchmark mode calls every read-only tool (readOnlyHint), every static
+ * resource and every prompt K times, one call at a time so each sample
+ * measures server latency rather than queueing.  Tools get placeholder
+ * arguments built from their input schema and prompts get "sample" for
+ * each required argument.  Payload size is the length of the compact
+ * JSON encoding of each result.
+ */
+
+typedef enum
+{
+    BENCH_TOOL,
+    BENCH_RESOURCE,
+    BENCH_PROMPT
+} BenchKind;
+
+typedef struct
+{
+    BenchKind   kind;
+    gchar      *name;
+    JsonObject *tool_args;      /* BENCH_TOOL */
+    GHashTable *prompt_args;    /* BENCH_PROMPT */
+    GArray     *latencies;      /* gdouble, milliseconds */
+    guint64     total_bytes;
+    guint       n_errors;
+    gchar      *last_error;
+} BenchItem;
+
+typedef struct
+{
+    GMainLoop *loop;
+    McpClient *client;
+    GPtrArray *items;
+    guint      item_index;
+    guint      iteration;
+    guint      iterations;
+    gint64     start_us;
+    guint      skipped_tools;
+} BenchContext;
+
+static const gchar *
+bench_kind_to_string (BenchKind kind)
+{
+    switch (kind)
+    {
+    case BENCH_TOOL:
+        return "tool";
+    case BENCH_RESOURCE:
+        return "resource";
+    case BENCH_PROMPT:
+        return "prompt";
+    default:
+        return "unknown";
+    }
+}
+
+static void
+bench_item_free (BenchItem *item)
+{
+    g_free (item->name);
+    g_clear_pointer (&item->tool_args, json_object_unref);
+    g_clear_pointer (&item->prompt_args, g_hash_table_unref);
+    g_array_unref (item->latencies);
+    g_free (item->last_error);
+    g_free (item);
+}
+
+static BenchItem *
+bench_item_new (BenchKind    kind,
+                const gchar *name)
+{
+    BenchItem *item;
+
+    item = g_new0 (BenchItem, 1);
+    item->kind = kind;
+    item->name = g_strdup (name);
+    item->latencies = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+    return item;
+}
+
+static gsize
+json_payload_size (JsonNode *node)
+{
+    g_autoptr(JsonGenerator) gen = json_generator_new ();
+    gsize length = 0;
+    g_autofree gchar *data = NULL;
+
+    json_generator_set_root (gen, node);
+    data = json_generator_to_data (gen, &length);
+
+    return length;
+}
+
+static void bench_next (BenchContext *bench);
+
+/*
+ * bench_record:
+ *
+ * Records one finished call.  @payload is the JSON form of the result
+ * (transfer full), or %NULL if the call failed with @error.
+ */
+static void
+bench_record (BenchContext *bench,
+              JsonNode     *payload,
+              GError       *error)
+{
+    BenchItem *item = g_ptr_array_index (bench->items, bench->item_index);
+    gdouble latency_ms;
+
+    latency_ms = (g_get_monotonic_time () - bench->start_us) / 1000.0;
+
+    if (payload != NULL)
+    {
+        g_array_append_val (item->latencies, latency_ms);
+        item->total_bytes += json_payload_size (payload);
+        json_node_unref (payload);
+    }
+    else
+    {
+        item->n_errors++;
+        g_free (item->last_error);
+        item->last_error = g_strdup (error != NULL ? error->message : "no result");
+    }
+
+    bench->iteration++;
+    if (bench->iteration >= bench->iterations)
+    {
+        bench->iteration = 0;
+        bench->item_index++;
+    }
+
+    bench_next (bench);
+}
+
+static void
+on_bench_tool_complete (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+    g_autoptr(McpToolResult) tool_result = NULL;
+    g_autoptr(GError) error = NULL;
+
+    tool_result = mcp_client_call_tool_finish (MCP_CLIENT (source), result, &error);
+    bench_record (user_data,
+                  tool_result != NULL ? mcp_tool_result_to_json (tool_result) : NULL,
+                  error);
+}
+
+static void
+on_bench_resource_complete (GObject      *source,
+                            GAsyncResult *result,
+                            gpointer      user_data)
+{
+    g_autoptr(GError) error = NULL;
+    JsonNode *payload = NULL;
+    GList *contents;
+
+    contents = mcp_client_read_resource_finish (MCP_CLIENT (source), result, &error);
+    if (error == NULL)
+    {
+        JsonArray *array = json_array_new ();
+        GList *l;
+
+        for (l = contents; l != NULL; l = l->next)
+        {
+            json_array_add_element (array, mcp_resource_contents_to_json (l->data));
+        }
+
+        payload = json_node_new (JSON_NODE_ARRAY);
+        json_node_take_array (payload, array);
+    }
+    g_list_free_full (contents, (GDestroyNotify)mcp_resource_contents_unref);
+
+    bench_record (user_data, payload, error);
+}
+
+static void
+on_bench_prompt_complete (GObject      *source,
+                          GAsyncResult *result,
+                          gpointer      user_data)
+{
+    g_autoptr(McpPromptResult) prompt_result = NULL;
+    g_autoptr(GError) error = NULL;
+
+    prompt_result = mcp_client_get_prompt_finish (MCP_CLIENT (source), result, &error);
+    bench_record (user_data,
+                  prompt_result != NULL ? mcp_prompt_result_to_json (prompt_result) : NULL,
+                  error);
+}
+
+/*
+ * bench_next:
+ *
+ * Issues the next call, or quits the loop when every item is done.
+ */
+static void
+bench_next (BenchContext *bench)
+{
+    BenchItem *item;
+
+    if (bench->item_index >= bench->items->len)
+    {
+        g_main_loop_quit (bench->loop);
+        return;
+    }
+
+    item = g_ptr_array_index (bench->items, bench->item_index);
+    bench->start_us = g_get_monotonic_time ();
+
+    switch (item->kind)
+    {
+    case BENCH_TOOL:
+        mcp_client_call_tool_async (bench->client, item->name, item->tool_args,
+                                    NULL, on_bench_tool_complete, bench);
+        break;
+    case BENCH_RESOURCE:
+        mcp_client_read_resource_async (bench->client, item->name,
+                                        NULL, on_bench_resource_complete, bench);
+        break;
+    case BENCH_PROMPT:
+        mcp_client_get_prompt_async (bench->client, item->name, item->prompt_args,
+                                     NULL, on_bench_prompt_complete, bench);
+        break;
+    default:
+        g_assert_not_reached ();
+    }
+}
+
+static void
+bench_collect_items (BenchContext   *bench,
+                     InspectContext *ctx)
+{
+    GList *l;
+
+    for (l = ctx->tools; l != NULL; l = l->next)
+    {
+        McpTool *tool = l->data;
+        BenchItem *item;
+
+        if (!mcp_tool_get_read_only_hint (tool))
+        {
+            bench->skipped_tools++;
+            continue;
+        }
+
+        item = bench_item_new (BENCH_TOOL, mcp_tool_get_name (tool));
+        item->tool_args = mcp_cli_sample_arguments (mcp_tool_get_input_schema (tool));
+        g_ptr_array_add (bench->items, item);
+    }
+
+    for (l = ctx->resources; l != NULL; l = l->next)
+    {
+        g_ptr_array_add (bench->items,
+                         bench_item_new (BENCH_RESOURCE,
+                                         mcp_resource_get_uri (l->data)));
+    }
+
+    for (l = ctx->prompts; l != NULL; l = l->next)
+    {
+        McpPrompt *prompt = l->data;
+        BenchItem *item;
+        GList *a;
+
+        item = bench_item_new (BENCH_PROMPT, mcp_prompt_get_name (prompt));
+        item->prompt_args = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   g_free, g_free);
+        for (a = mcp_prompt_get_arguments (prompt); a != NULL; a = a->next)
+        {
+            McpPromptArgument *arg = a->data;
+
+            if (mcp_prompt_argument_get_required (arg))
+            {
+                g_hash_table_insert (item->prompt_args,
+                                     g_strdup (mcp_prompt_argument_get_name (arg)),
+                                     g_strdup ("sample"));
+            }
+        }
+        g_ptr_array_add (bench->items, item);
+    }
+}
+
+static void
+bench_print_json (BenchContext *bench)
+{
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    g_autoptr(JsonGenerator) gen = json_generator_new ();
+    g_autoptr(JsonNode) root = NULL;
+    g_autofree gchar *json = NULL;
+    guint i;
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "iterations");
+    json_builder_add_int_value (builder, bench->iterations);
+    json_builder_set_member_name (builder, "skippedTools");
+    json_builder_add_int_value (builder, bench->skipped_tools);
+    json_builder_set_member_name (builder, "items");
+    json_builder_begin_array (builder);
+
+    for (i = 0; i < bench->items->len; i++)
+    {
+        BenchItem *item = g_ptr_array_index (bench->items, i);
+        guint ok = item->latencies->len;
+
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "kind");
+        json_builder_add_string_value (builder, bench_kind_to_string (item->kind));
+        json_builder_set_member_name (builder, "name");
+        json_builder_add_string_value (builder, item->name);
+        json_builder_set_member_name (builder, "calls");
+        json_builder_add_int_value (builder, ok + item->n_errors);
+        json_builder_set_member_name (builder, "errors");
+        json_builder_add_int_value (builder, item->n_errors);
+        if (item->last_error != NULL)
+        {
+            json_builder_set_member_name (builder, "lastError");
+            json_builder_add_string_value (builder, item->last_error);
+        }
+        if (ok > 0)
+        {
+            json_builder_set_member_name (builder, "latencyMs");
+            json_builder_begin_object (builder);
+            json_builder_set_member_name (builder, "min");
+            json_builder_add_double_value (builder, mcp_cli_latency_percentile (item->latencies, 0.0));
+            json_builder_set_member_name (builder, "p50");
+            json_builder_add_double_value (builder, mcp_cli_latency_percentile (item->latencies, 50.0));
+            json_builder_set_member_name (builder, "p90");
+            json_builder_add_double_value (builder, mcp_cli_latency_percentile (item->latencies, 90.0));
+            json_builder_set_member_name (builder, "p99");
+            json_builder_add_double_value (builder, mcp_cli_latency_percentile (item->latencies, 99.0));
+            json_builder_set_member_name (builder, "max");
+            json_builder_add_double_value (builder, mcp_cli_latency_percentile (item->latencies, 100.0));
+            json_builder_end_object (builder);
+            json_builder_set_member_name (builder, "payloadBytes");
+            json_builder_add_int_value (builder, item->total_bytes / ok);
+        }
+        json_builder_end_object (builder);
+    }
+
+    json_builder_end_array (builder);
+    json_builder_end_object (builder);
+
+    root = json_builder_get_root (builder);
+    json_generator_set_root (gen, root);
+    json_generator_set_pretty (gen, TRUE);
+    json = json_generator_to_data (gen, NULL);
+    g_print ("%s\n", json);
+}
+
+static void
+bench_print_human (BenchContext *bench)
+{
+    guint i;
+
+    g_print ("Benchmark (%u iterations per item):\n\n", bench->iterations);
+    g_print ("  %-8s %-32s %9s %9s %9s %9s %10s %6s\n",
+             "KIND", "NAME", "p50 ms", "p90 ms", "p99 ms", "max ms", "bytes", "errors");
+
+    for (i = 0; i < bench->items->len; i++)
+    {
+        BenchItem *item = g_ptr_array_index (bench->items, i);
+        guint ok = item->latencies->len;
+
+        if (ok > 0)
+        {
+            g_print ("  %-8s %-32s %9.3f %9.3f %9.3f %9.3f %10" G_GUINT64_FORMAT " %6u\n",
+                     bench_kind_to_string (item->kind), item->name,
+                     mcp_cli_latency_percentile (item->latencies, 50.0),
+                     mcp_cli_latency_percentile (item->latencies, 90.0),
+                     mcp_cli_latency_percentile (item->latencies, 99.0),
+                     mcp_cli_latency_percentile (item->latencies, 100.0),
+                     item->total_bytes / ok, item->n_errors);
+        }
+        else
+        {
+            g_print ("  %-8s %-32s %9s %9s %9s %9s %10s %6u\n",
+                     bench_kind_to_string (item->kind), item->name,
+                     "-", "-", "-", "-", "-", item->n_errors);
+        }
+
+        if (item->last_error != NULL && !mcp_cli_opt_quiet)
+        {
+            g_print ("           last error: %s\n", item->last_error);
+        }
+    }
+
+    if (bench->items->len == 0)
+    {
+        g_print ("  (nothing to benchmark)\n");
+    }
+
+    if (bench->skipped_tools > 0 && !mcp_cli_opt_quiet)
+    {
+        g_print ("\nSkipped %u tool(s) without readOnlyHint.\n", bench->skipped_tools);
+    }
+}
+
+/*
+ * run_bench:
+ *
+ * Benchmarks the items found by the listing pass and prints the report.
+ */
+static gint
+run_bench (McpClient      *client,
+           InspectContext *ctx)
+{
+    BenchContext bench;
+    guint i;
+
+    memset (&bench, 0, sizeof (bench));
+    bench.loop = g_main_loop_new (NULL, FALSE);
+    bench.client = client;
+    bench.items = g_ptr_array_new_with_free_func ((GDestroyNotify)bench_item_free);
+    bench.iterations = (opt_iterations > 0) ? (guint)opt_iterations : 1;
+
+    bench_collect_items (&bench, ctx);
+
+    if (bench.items->len > 0)
+    {
+        bench_next (&bench);
+        g_main_loop_run (bench.loop);
+    }
+
+    for (i = 0; i < bench.items->len; i++)
+    {
+        BenchItem *item = g_ptr_array_index (bench.items, i);
+
+        mcp_cli_sort_samples (item->latencies);
+    }
+
+    if (mcp_cli_opt_json)
+    {
+        bench_print_json (&bench);
+    }
+    else
+    {
+        bench_print_human (&bench);
+    }
+
+    g_ptr_array_unref (bench.items);
+    g_main_loop_unref (bench.loop);
+
+    return MCP_CLI_EXIT_SUCCESS;
+}
+
+/* ========================================================================== */
+/* Local benchmarks                                                            */
+/* ========================================================================== */
+
+/*
+ * Local benchmarks measure the library inside this process instead of
+ * a server at the other end of a transport, so they connect to nothing.
+ */
+
+static void
+print_json (JsonBuilder *builder)
+{
+    g_autoptr(JsonGenerator) gen = json_generator_new ();
+    g_autoptr(JsonNode) root = NULL;
+    g_autofree gchar *json = NULL;
+
+    root = json_builder_get_root (builder);
+    json_generator_set_root (gen, root);
+    json_generator_set_pretty (gen, TRUE);
+    json = json_generator_to_data (gen, NULL);
+    g_print ("%s\n", json);
+}
+
+/* Bytes allocated from the heap, or -1 where the C library cannot say */
+static gint64
+heap_in_use (void)
+{
+#ifdef HAVE_MALLINFO2
+    struct mallinfo2 info = mallinfo2 ();
+
+    return (gint64) (info.uordblks + info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+/*
+ * run_bench_sessions:
+ *
+ * Creates @n_sessions idle servers, as McpUnixSocketServer does for
+ * connections that have not sent anything yet, and reports the heap
+ * each one holds.  Tools and other registry data are left out: every
+ * server would share them.
+ */
+static gint
+run_bench_sessions (guint n_sessions)
+{
+    g_autoptr(GPtrArray) servers = NULL;
+    gint64 before;
+    gint64 after;
+    gdouble per_session;
+    guint i;
+
+    if (heap_in_use () < 0)
+    {
+        g_printerr ("Error: --bench-sessions needs mallinfo2() (glibc 2.33 or later)\n");
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    /* Leave out what only the first server of a process allocates:
+     * type registration, the shared empty registry, scratch buffers */
+    g_object_unref (mcp_server_new ("warm-up", "1.0.0"));
+
+    servers = g_ptr_array_new_full (n_sessions, g_object_unref);
+
+    before = heap_in_use ();
+    for (i = 0; i < n_sessions; i++)
+    {
+        g_ptr_array_add (servers, mcp_server_new ("idle", "1.0.0"));
+    }
+    after = heap_in_use ();
+
+    per_session = (gdouble) (after - before) / n_sessions;
+
+    if (mcp_cli_opt_json)
+    {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "sessions");
+        json_builder_add_int_value (builder, n_sessions);
+        json_builder_set_member_name (builder, "bytesPerSession");
+        json_builder_add_int_value (builder, (gint64) per_session);
+        json_builder_end_object (builder);
+        print_json (builder);
+    }
+    else
+    {
+        g_print ("Idle sessions: %u\n", n_sessions);
+        g_print ("Heap per session: %.0f bytes\n", per_session);
+    }
+
+    return MCP_CLI_EXIT_SUCCESS;
+}
+
+/* Message sizes --bench-parse measures, 1KB to 10MB */
+static const gsize bench_parse_sizes[] = {
+    1024, 10 * 1024, 100 * 1024, 1024 * 1024, 10 * 1024 * 1024
+};
+
+static const gchar *bench_parse_backends[] = {
+    MCP_JSON_PARSER_BACKEND_NATIVE,
+    MCP_JSON_PARSER_BACKEND_JSON_GLIB
+};
+
+/*
+ * Builds a tools/call response of at least @size bytes: an array of
+ * content items with escapes, non-ASCII text and nested objects, the
+ * shape most large messages have.
+ */
+static gchar *
+bench_parse_message (gsize size)
+{
+    GString *json;
+    guint i;
+
+    json = g_string_sized_new (size + 256);
+    g_string_append (json, "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":{\"content\":[");
+    for (i = 0; json->len < size; i++)
+    {
+        if (i > 0)
+        {
+            g_string_append_c (json, ',');
+        }
+        g_string_append_printf (json,
+                                "{\"type\":\"text\",\"text\":\"line %u: caf\xc3\xa9 "
+                                "\\\"quoted\\\" \\u2713\\n\",\"annotations\":"
+                                "{\"priority\":%u.5,\"audience\":[\"user\",\"assistant\"]}}",
+                                i, i % 10);
+    }
+    g_string_append (json, "],\"isError\":false}}");
+
+    return g_string_free (json, FALSE);
+}
+
+/*
+ * run_bench_parse:
+ *
+ * Parses messages of each size with each backend and reports the
+ * median throughput.  The backend in use beforehand is restored.
+ */
+static gint
+run_bench_parse (guint iterations)
+{
+    g_autofree gchar *saved_backend = g_strdup (mcp_json_parse_get_backend ());
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    guint s;
+    guint b;
+    guint i;
+
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "iterations");
+    json_builder_add_int_value (builder, iterations);
+    json_builder_set_member_name (builder, "sizes");
+    json_builder_begin_array (builder);
+
+    if (!mcp_cli_opt_json)
+    {
+        g_print ("Parse throughput (median of %u parses, MB/s):\n\n", iterations);
+        g_print ("  %10s", "BYTES");
+        for (b = 0; b < G_N_ELEMENTS (bench_parse_backends); b++)
+        {
+            g_print (" %10s", bench_parse_backends[b]);
+        }
+        g_print ("\n");
+    }
+
+    for (s = 0; s < G_N_ELEMENTS (bench_parse_sizes); s++)
+    {
+        g_autofree gchar *message = bench_parse_message (bench_parse_sizes[s]);
+        gsize length = strlen (message);
+
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "bytes");
+        json_builder_add_int_value (builder, length);
+        if (!mcp_cli_opt_json)
+        {
+            g_print ("  %10" G_GSIZE_FORMAT, length);
+        }
+
+        for (b = 0; b < G_N_ELEMENTS (bench_parse_backends); b++)
+        {
+            g_autoptr(GArray) seconds = g_array_new (FALSE, FALSE, sizeof (gdouble));
+            gdouble mb_per_second;
+
+            mcp_json_parse_set_backend (bench_parse_backends[b]);
+            for (i = 0; i < iterations; i++)
+            {
+                g_autoptr(JsonNode) root = NULL;
+                g_autoptr(GError) error = NULL;
+                gint64 start;
+                gdouble elapsed;
+
+                start = g_get_monotonic_time ();
+                root = mcp_json_parse (message, length, &error);
+                elapsed = (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC;
+                if (root == NULL)
+                {
+                    g_printerr ("Error: %s backend: %s\n",
+                                bench_parse_backends[b], error->message);
+                    mcp_json_parse_set_backend (saved_backend);
+                    return MCP_CLI_EXIT_ERROR;
+                }
+                g_array_append_val (seconds, elapsed);
+            }
+
+            mcp_cli_sort_samples (seconds);
+            mb_per_second = length / MAX (mcp_cli_latency_percentile (seconds, 50.0), 1e-9) / 1e6;
+
+            json_builder_set_member_name (builder, bench_parse_backends[b]);
+            json_builder_add_double_value (builder, mb_per_second);
+            if (!mcp_cli_opt_json)
+            {
+                g_print (" %10.1f", mb_per_second);
+            }
+        }
+
+        json_builder_end_object (builder);
+        if (!mcp_cli_opt_json)
+        {
+            g_print ("\n");
+        }
+    }
+
+    json_builder_end_array (builder);
+    json_builder_end_object (builder);
+    if (mcp_cli_opt_json)
+    {
+        print_json (builder);
+    }
+
+    mcp_json_parse_set_backend (saved_backend);
+
+    return MCP_CLI_EXIT_SUCCESS;
+}
+
+#ifndef MCP_NO_STDIO_TRANSPORT
+
+typedef struct
+{
+    GMainLoop *loop;
+    gboolean   ok;
+    gchar     *error;
+} DispatchCall;
+
+static McpToolResult *
+bench_echo_handler (McpServer   *server,
+                    const gchar *name,
+                    JsonObject  *arguments,
+                    gpointer     user_data)
+{
+    McpToolResult *result;
+
+    result = mcp_tool_result_new (FALSE);
+    mcp_tool_result_add_text (result, json_object_get_string_member (arguments, "text"));
+    return result;
+}
+
+static void
+on_dispatch_call_done (GObject      *source,
+                       GAsyncResult *res,
+                       gpointer      user_data)
+{
+    DispatchCall *call = user_data;
+    g_autoptr(GError) error = NULL;
+    McpToolResult *result;
+
+    result = mcp_client_call_tool_finish (MCP_CLIENT (source), res, &error);
+    call->ok = (result != NULL);
+    if (result != NULL)
+    {
+        mcp_tool_result_unref (result);
+    }
+    else
+    {
+        call->error = g_strdup (error->message);
+    }
+
+    g_main_loop_quit (call->loop);
+}
+
+static void
+on_bench_session_created (McpUnixSocketServer *socket_server,
+                          McpServer           *server,
+                          gpointer             user_data)
+{
+    mcp_server_add_tool (server, MCP_TOOL (user_data), bench_echo_handler, NULL, NULL);
+    mcp_server_set_use_arena (server, !opt_bench_no_arena);
+}
+
+/*
+ * Makes the client end of a connection to the McpUnixSocketServer at
+ * @path.  For "socket" the connection is made here and kept in
+ * @connection for as long as the transport is used.
+ */
+static McpTransport *
+bench_client_transport (const gchar        *transport_name,
+                        const gchar        *path,
+                        GSocketConnection **connection,
+                        GError            **error)
+{
+    g_autoptr(GSocketClient) socket_client = NULL;
+    g_autoptr(GSocketAddress) address = NULL;
+
+    if (g_strcmp0 (transport_name, "shm") == 0)
+    {
+        return MCP_TRANSPORT (mcp_shm_transport_new_client (path));
+    }
+    if (g_strcmp0 (transport_name, "seqpacket") == 0)
+    {
+        return MCP_TRANSPORT (mcp_seqpacket_transport_new_client (path));
+    }
+
+    /* Newline-delimited JSON over a stream socket */
+    socket_client = g_socket_client_new ();
+    address = g_unix_socket_address_new (path);
+    *connection = g_socket_client_connect (socket_client, G_SOCKET_CONNECTABLE (address),
+                                           NULL, error);
+    if (*connection == NULL)
+    {
+        return NULL;
+    }
+
+    return MCP_TRANSPORT (mcp_stdio_transport_new_with_streams (
+        g_io_stream_get_input_stream (G_IO_STREAM (*connection)),
+        g_io_stream_get_output_stream (G_IO_STREAM (*connection))));
+}
+
+/*
+ * run_bench_dispatch:
+ *
+ * Serves an echo tool from an McpUnixSocketServer in this process and
+ * calls it @iterations times, one call at a time, from an McpClient
+ * connected over @transport_name: "socket" (newline-delimited JSON on
+ * a stream socket, as McpStdioTransport), "shm" (the shared-memory
+ * upgrade) or "seqpacket".  Reports the round-trip latency, with or
+ * without the server's per-message arena (--bench-no-arena).
+ * When the io_uring backend carries the socket, also reports the
+ * io_uring_enter() and eventfd read() calls per message sent.
+ */
+static gint
+run_bench_dispatch (const gchar *transport_name,
+                    guint        iterations)
+{
+    g_autoptr(McpUnixSocketServer) socket_server = NULL;
+    g_autoptr(GSocketConnection) connection = NULL;
+    g_autoptr(McpClient) client = NULL;
+    g_autoptr(McpTool) tool = NULL;
+    g_autoptr(McpTransport) client_transport = NULL;
+    g_autoptr(JsonObject) arguments = NULL;
+    g_autoptr(GMainLoop) loop = NULL;
+    g_autoptr(GArray) latencies = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *dir = NULL;
+    g_autofree gchar *path = NULL;
+    guint64 syscalls_start = 0;
+    guint64 sends_start = 0;
+    guint64 syscalls = 0;
+    guint64 sends = 0;
+    gint exit_code = MCP_CLI_EXIT_ERROR;
+    guint i;
+
+    if (g_strcmp0 (transport_name, "socket") != 0 &&
+        g_strcmp0 (transport_name, "shm") != 0 &&
+        g_strcmp0 (transport_name, "seqpacket") != 0)
+    {
+        g_printerr ("Error: unknown transport '%s' (use socket, shm or seqpacket)\n",
+                    transport_name);
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    dir = g_dir_make_tmp ("mcp-inspect-XXXXXX", &error);
+    if (dir == NULL)
+    {
+        g_printerr ("Error: %s\n", error->message);
+        return MCP_CLI_EXIT_ERROR;
+    }
+    path = g_build_filename (dir, "bench.sock", NULL);
+
+    tool = mcp_tool_new ("echo", "Echoes its text argument");
+    mcp_tool_set_read_only_hint (tool, TRUE);
+
+    socket_server = mcp_unix_socket_server_new ("bench", "1.0.0", path);
+    if (g_strcmp0 (transport_name, "seqpacket") == 0)
+    {
+        mcp_unix_socket_server_set_socket_type (socket_server, G_SOCKET_TYPE_SEQPACKET);
+    }
+    else if (g_strcmp0 (transport_name, "shm") == 0)
+    {
+        mcp_unix_socket_server_set_shm_ring_size (socket_server,
+                                                  MCP_SHM_TRANSPORT_DEFAULT_RING_SIZE);
+    }
+    g_signal_connect (socket_server, "session-created",
+                      G_CALLBACK (on_bench_session_created), tool);
+    if (!mcp_unix_socket_server_start (socket_server, &error))
+    {
+        g_printerr ("Error: %s\n", error->message);
+        goto out;
+    }
+
+    client_transport = bench_client_transport (transport_name, path, &connection, &error);
+    if (client_transport == NULL)
+    {
+        g_printerr ("Connection failed: %s\n", error->message);
+        goto out;
+    }
+    client = mcp_client_new ("mcp-inspect", "1.0.0");
+    mcp_client_set_transport (client, client_transport);
+    if (!mcp_cli_connect_sync (client, mcp_cli_opt_timeout, &error))
+    {
+        g_printerr ("Connection failed: %s\n", error->message);
+        goto out;
+    }
+
+    arguments = json_object_new ();
+    json_object_set_string_member (arguments, "text", "hello");
+    loop = g_main_loop_new (NULL, FALSE);
+    latencies = g_array_sized_new (FALSE, FALSE, sizeof (gdouble), iterations);
+
+    /* The first call fills caches and scratch buffers; it is not counted */
+    for (i = 0; i <= iterations; i++)
+    {
+        DispatchCall call = { loop, FALSE, NULL };
+        gint64 start;
+        gdouble latency_ms;
+
+        if (i == 1)
+        {
+            mcp_uring_get_stats (&syscalls_start, &sends_start, NULL);
+        }
+        start = g_get_monotonic_time ();
+        mcp_client_call_tool_async (client, "echo", arguments, NULL,
+                                    on_dispatch_call_done, &call);
+        g_main_loop_run (loop);
+        latency_ms = (g_get_monotonic_time () - start) / 1000.0;
+
+        if (!call.ok)
+        {
+            g_printerr ("Error: %s\n", call.error);
+            g_free (call.error);
+            goto out;
+        }
+        if (i > 0)
+        {
+            g_array_append_val (latencies, latency_ms);
+        }
+    }
+
+    mcp_uring_get_stats (&syscalls, &sends, NULL);
+    syscalls -= syscalls_start;
+    sends -= sends_start;
+
+    mcp_cli_disconnect_sync (client, NULL);
+    mcp_cli_sort_samples (latencies);
+
+    if (mcp_cli_opt_json)
+    {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "transport");
+        json_builder_add_string_value (builder, transport_name);
+        json_builder_set_member_name (builder, "arena");
+        json_builder_add_boolean_value (builder, !opt_bench_no_arena);
+        json_builder_set_member_name (builder, "calls");
+        json_builder_add_int_value (builder, iterations);
+        json_builder_set_member_name (builder, "latencyMs");
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "p50");
+        json_builder_add_double_value (builder, mcp_cli_latency_percentile (latencies, 50.0));
+        json_builder_set_member_name (builder, "p90");
+        json_builder_add_double_value (builder, mcp_cli_latency_percentile (latencies, 90.0));
+        json_builder_set_member_name (builder, "p99");
+        json_builder_add_double_value (builder, mcp_cli_latency_percentile (latencies, 99.0));
+        json_builder_set_member_name (builder, "max");
+        json_builder_add_double_value (builder, mcp_cli_latency_percentile (latencies, 100.0));
+        json_builder_end_object (builder);
+        if (sends > 0)
+        {
+            json_builder_set_member_name (builder, "uringSyscallsPerMessage");
+            json_builder_add_double_value (builder, (gdouble) syscalls / sends);
+        }
+        json_builder_end_object (builder);
+        print_json (builder);
+    }
+    else
+    {
+        g_print ("Dispatch (%u calls to an in-process server over %s, arena %s):\n\n",
+                 iterations, transport_name, opt_bench_no_arena ? "off" : "on");
+        g_print ("  p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                 mcp_cli_latency_percentile (latencies, 50.0),
+                 mcp_cli_latency_percentile (latencies, 90.0),
+                 mcp_cli_latency_percentile (latencies, 99.0),
+                 mcp_cli_latency_percentile (latencies, 100.0));
+        if (sends > 0)
+        {
+            g_print ("  %.2f io_uring syscalls per message (%" G_GUINT64_FORMAT
+                     " messages)\n",
+                     (gdouble) syscalls / sends, sends);
+        }
+    }
+    exit_code = MCP_CLI_EXIT_SUCCESS;
+
+out:
+    mcp_unix_socket_server_stop (socket_server);
+    g_unlink (path);
+    g_rmdir (dir);
+
+    return exit_code;
+}
+
+#endif /* MCP_NO_STDIO_TRANSPORT */
+
 /* ========================================================================== */
 /* Main entry point                                                            */
 /* ========================================================================== */
@@ -107,6 +1113,19 @@ static const gchar *description =
     "  mcp-inspect --stdio ./my-server\n"
     "  mcp-inspect --http https://api.example.com/mcp --token \"secret\"\n"
     "  mcp-inspect -s './server --debug' --json\n"
+    "  mcp-inspect -s ./my-server --bench --iterations 50\n"
+    "\n"
+    "With --bench, every read-only tool, static resource and prompt is\n"
+    "called K times with placeholder arguments, and per-item latency\n"
+    "percentiles and payload sizes are reported.\n"
+    "\n"
+    "With --bench-sessions N, no server is contacted: N idle McpServer\n"
+    "objects are created in this process and the heap each one holds is\n"
+    "reported.  With --bench-parse, messages of 1KB to 10MB are parsed\n"
+    "K times with each JSON parser backend and the throughput reported.\n"
+    "With --bench-dispatch, an in-process server is called K times over a\n"
+    "Unix socket (or --bench-transport shm or seqpacket) and the latency\n"
+    "reported; add --bench-no-arena to compare without the request arena.\n"
     "\n"
     "Report bugs to: " MCP_CLI_BUG_URL;
 
@@ -125,6 +1144,7 @@ main (int    argc,
     context = g_option_context_new ("- Inspect MCP server capabilities");
     g_option_context_set_description (context, description);
     g_option_context_add_main_entries (context, mcp_cli_get_common_options (), NULL);
+    g_option_context_add_main_entries (context, inspect_entries, NULL);
 
     if (!g_option_context_parse (context, &argc, &argv, &error))
     {
@@ -139,6 +1159,23 @@ main (int    argc,
         return MCP_CLI_EXIT_SUCCESS;
     }
 
+    /* Local benchmarks need no server */
+    if (opt_bench_sessions > 0)
+    {
+        return run_bench_sessions ((guint) opt_bench_sessions);
+    }
+    if (opt_bench_parse)
+    {
+        return run_bench_parse ((opt_iterations > 0) ? (guint) opt_iterations : 1);
+    }
+#ifndef MCP_NO_STDIO_TRANSPORT
+    if (opt_bench_dispatch)
+    {
+        return run_bench_dispatch (opt_bench_transport != NULL ? opt_bench_transport : "socket",
+                                   (opt_iterations > 0) ? (guint) opt_iterations : 1);
+    }
+#endif
+
     /* Create transport */
     transport = mcp_cli_create_transport (&error);
     if (transport == NULL)
@@ -214,6 +1251,22 @@ main (int    argc,
         return MCP_CLI_EXIT_ERROR;
     }
 
+    /* Benchmark instead of listing */
+    if (opt_bench)
+    {
+        gint exit_code;
+
+        exit_code = run_bench (client, &ctx);
+
+        g_list_free_full (ctx.tools, g_object_unref);
+        g_list_free_full (ctx.resources, g_object_unref);
+        g_list_free_full (ctx.templates, g_object_unref);
+        g_list_free_full (ctx.prompts, g_object_unref);
+        mcp_cli_disconnect_sync (client, NULL);
+
+        return exit_code;
+    }
+
     /* Print results */
     if (mcp_cli_opt_json)
     {
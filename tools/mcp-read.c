@@ -10,17 +10,20 @@
  *   mcp-read --stdio ./server -- file:///path/to/file
  *   mcp-read --http https://api.example.com/mcp -- config://app/settings
  *   mcp-read -s ./fs-server --output data.bin -- binary://file
+ *   mcp-read -s ./fs-server --output - -- binary://file | sha256sum
  */
 
 #include "mcp-common.h"
+#include <gio/gunixoutputstream.h>
 #include <string.h>
+#include <unistd.h>
 
 /* Tool-specific option */
 static gchar *opt_output = NULL;
 
 static GOptionEntry read_entries[] = {
     { "output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output,
-      "Write content to FILE (for binary)", "FILE" },
+      "Write raw content to FILE ('-' for stdout)", "FILE" },
     { NULL }
 };
 
@@ -46,6 +49,83 @@ on_read_resource_complete (GObject      *source,
     g_main_loop_quit (ctx->loop);
 }
 
+/* ========================================================================== */
+/* Raw output                                                                  */
+/* ========================================================================== */
+
+/*
+ * write_raw_output:
+ *
+ * Writes the decoded payload to @path ('-' for stdout) through a single
+ * sequential output stream.  Files are written via g_file_replace(); if
+ * writing fails the stream is closed cancelled, which keeps the old
+ * file, and a file that did not exist before is removed, so a failed
+ * write never leaves a truncated file behind.
+ */
+static gint
+write_raw_output (GList       *contents,
+                  const gchar *path)
+{
+    g_autoptr(GOutputStream) stream = NULL;
+    g_autoptr(GFile) file = NULL;
+    g_autoptr(GError) error = NULL;
+    gboolean to_stdout;
+    gboolean existed = FALSE;
+    gsize written = 0;
+
+    to_stdout = (g_strcmp0 (path, "-") == 0);
+
+    if (to_stdout)
+    {
+        stream = g_unix_output_stream_new (STDOUT_FILENO, FALSE);
+    }
+    else
+    {
+        file = g_file_new_for_commandline_arg (path);
+        existed = g_file_query_exists (file, NULL);
+
+        stream = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE,
+                                                  G_FILE_CREATE_REPLACE_DESTINATION,
+                                                  NULL, &error));
+        if (stream == NULL)
+        {
+            g_printerr ("Error writing to '%s': %s\n", path, error->message);
+            return MCP_CLI_EXIT_ERROR;
+        }
+    }
+
+    if (!mcp_cli_write_resource_contents (contents, stream, &written, NULL, &error))
+    {
+        g_printerr ("Error writing to '%s': %s\n", path, error->message);
+
+        if (file != NULL)
+        {
+            g_autoptr(GCancellable) cancelled = g_cancellable_new ();
+
+            g_cancellable_cancel (cancelled);
+            g_output_stream_close (stream, cancelled, NULL);
+            if (!existed)
+            {
+                g_file_delete (file, NULL, NULL);
+            }
+        }
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    if (!g_output_stream_close (stream, NULL, &error))
+    {
+        g_printerr ("Error writing to '%s': %s\n", path, error->message);
+        return MCP_CLI_EXIT_ERROR;
+    }
+
+    if (!mcp_cli_opt_quiet && !to_stdout)
+    {
+        g_print ("Wrote %lu bytes to '%s'\n", (unsigned long)written, path);
+    }
+
+    return MCP_CLI_EXIT_SUCCESS;
+}
+
 /* ========================================================================== */
 /* Main entry point                                                            */
 /* ========================================================================== */
@@ -60,6 +140,11 @@ static const gchar *description =
     "  mcp-read --stdio ./server -- file:///etc/hostname\n"
     "  mcp-read --http https://api.example.com/mcp -- config://app/settings\n"
     "  mcp-read -s ./fs-server --output data.bin -- binary://file\n"
+    "  mcp-read -s ./fs-server --output - -- binary://file > data.bin\n"
+    "\n"
+    "With --output, text is written verbatim and blobs are decoded in\n"
+    "chunks straight to the destination rather than into a buffer.  The\n"
+    "response itself is still received in full first.\n"
     "\n"
     "Report bugs to: " MCP_CLI_BUG_URL;
 
@@ -73,6 +158,7 @@ main (int    argc,
     g_autoptr(McpTransport) transport = NULL;
     ReadContext ctx;
     const gchar *uri;
+    gboolean raw_stdout;
     gint exit_code;
 
     /* Parse command line options */
@@ -116,7 +202,10 @@ main (int    argc,
     client = mcp_client_new ("mcp-read", "1.0.0");
     mcp_client_set_transport (client, transport);
 
-    if (!mcp_cli_opt_quiet && !mcp_cli_opt_json)
+    /* Status messages must not mix with raw content on stdout */
+    raw_stdout = (g_strcmp0 (opt_output, "-") == 0);
+
+    if (!mcp_cli_opt_quiet && !mcp_cli_opt_json && !raw_stdout)
     {
         g_print ("Connecting...\n");
     }
@@ -132,7 +221,7 @@ main (int    argc,
     ctx.loop = g_main_loop_new (NULL, FALSE);
 
     /* Read the resource */
-    if (!mcp_cli_opt_quiet && !mcp_cli_opt_json)
+    if (!mcp_cli_opt_quiet && !mcp_cli_opt_json && !raw_stdout)
     {
         g_print ("Reading '%s'...\n", uri);
     }
@@ -160,45 +249,10 @@ main (int    argc,
     }
     else if (ctx.contents != NULL)
     {
-        /* Handle output to file if specified */
+        /* Stream raw content to a file or stdout if requested */
         if (opt_output != NULL)
         {
-            GList *l;
-            g_autoptr(GString) output = g_string_new (NULL);
-
-            for (l = ctx.contents; l != NULL; l = l->next)
-            {
-                McpResourceContents *c = l->data;
-                const gchar *text = mcp_resource_contents_get_text (c);
-                const gchar *blob = mcp_resource_contents_get_blob (c);
-
-                if (text != NULL)
-                {
-                    g_string_append (output, text);
-                }
-                else if (blob != NULL)
-                {
-                    gsize blob_len;
-                    g_autofree guchar *decoded = NULL;
-
-                    decoded = g_base64_decode (blob, &blob_len);
-                    g_string_append_len (output, (const gchar *)decoded, blob_len);
-                }
-            }
-
-            if (!g_file_set_contents (opt_output, output->str, output->len, &error))
-            {
-                g_printerr ("Error writing to '%s': %s\n", opt_output, error->message);
-                exit_code = MCP_CLI_EXIT_ERROR;
-            }
-            else
-            {
-                if (!mcp_cli_opt_quiet)
-                {
-                    g_print ("Wrote %lu bytes to '%s'\n", (unsigned long)output->len, opt_output);
-                }
-                exit_code = MCP_CLI_EXIT_SUCCESS;
-            }
+            exit_code = write_raw_output (ctx.contents, opt_output);
         }
         else
         {
@@ -8,6 +8,12 @@
  * MCP server via HTTP or WebSocket. This allows tools that only support
  * stdio MCP servers to connect to remote HTTP/WS MCP servers.
  *
+ * Messages from stdin are forwarded verbatim: only the JSON-RPC
+ * envelope is scanned (for "id" and "method") to route them, so the
+ * local leg never builds a JSON tree.  With --connections N the proxy
+ * opens N upstream sessions, replays the client's initialize on each,
+ * spreads requests across them and routes replies by request ID.
+ *
  * Usage:
  *   mcp-remote-client --http https://api.example.com/mcp
  *   mcp-remote-client --ws wss://api.example.com/mcp
@@ -23,7 +29,10 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 #include <json-glib/json-glib.h>
+#include <gio/gunixinputstream.h>
+#include <gio/gunixoutputstream.h>
 #include <string.h>
+#include <unistd.h>
 
 /* ========================================================================== */
 /* License text                                                                */
@@ -55,6 +64,8 @@
 #define EXIT_SUCCESS_CODE   (0)
 #define EXIT_ERROR_CODE     (1)
 
+#define MAX_CONNECTIONS     (64)
+
 /* ========================================================================== */
 /* Command-line options                                                        */
 /* ========================================================================== */
@@ -62,6 +73,7 @@
 static gchar    *opt_http = NULL;
 static gchar    *opt_ws = NULL;
 static gchar    *opt_token = NULL;
+static gint      opt_connections = 1;
 static gboolean  opt_license = FALSE;
 static gboolean  opt_quiet = FALSE;
 
@@ -79,6 +91,10 @@ static GOptionEntry entries[] =
         "token", 't', 0, G_OPTION_ARG_STRING, &opt_token,
         "Authorization token for remote server", "TOKEN"
     },
+    {
+        "connections", 'c', 0, G_OPTION_ARG_INT, &opt_connections,
+        "Number of upstream sessions to spread requests over (default: 1)", "N"
+    },
     {
         "quiet", 'q', 0, G_OPTION_ARG_NONE, &opt_quiet,
         "Suppress status messages on stderr", NULL
@@ -94,155 +110,962 @@ static GOptionEntry entries[] =
 /* Proxy context                                                               */
 /* ========================================================================== */
 
+typedef enum
+{
+    UPSTREAM_CONNECTING,
+    UPSTREAM_IDLE,           /* connected, client has not initialized yet */
+    UPSTREAM_INITIALIZING,   /* replayed initialize is in flight */
+    UPSTREAM_READY,
+    UPSTREAM_DEAD
+} UpstreamState;
+
+typedef struct _ProxyContext ProxyContext;
+
 typedef struct
 {
-    GMainLoop      *loop;
-    McpTransport   *stdio_transport;
-    McpTransport   *remote_transport;
-    gboolean        remote_connected;
-    gboolean        shutting_down;
-    gint            exit_code;
-} ProxyContext;
+    ProxyContext  *ctx;
+    McpTransport  *transport;
+    guint          index;
+    UpstreamState  state;
+    gchar         *init_id;  /* id of the replayed initialize (index > 0) */
+} Upstream;
+
+/*
+ * Route:
+ *
+ * Where to send the client's answer to a server-initiated request.
+ * @raw_id is the upstream's original id when the proxy had to rename
+ * it to keep ids from different upstreams apart, or %NULL.
+ */
+typedef struct
+{
+    Upstream *upstream;
+    gchar    *raw_id;
+} Route;
+
+struct _ProxyContext
+{
+    GMainLoop        *loop;
+    GCancellable     *cancellable;
+    GPtrArray        *upstreams;      /* Upstream* */
+    guint             next_upstream;
+    guint             seq;
+
+    GDataInputStream *stdin_data;
+    GOutputStream    *stdout_stream;
+    GString          *out_pending;    /* serialized lines not yet written */
+    GBytes           *out_flight;     /* lines being written */
+    guint             flush_id;
+
+    GPtrArray        *session_log;    /* GBytes: initialize + session-scoped requests */
+    GHashTable       *routes;         /* raw id -> Route* */
+    GHashTable       *swallowed;      /* ids of replayed requests */
+
+    gboolean          shutting_down;
+    gint              exit_code;
+};
+
+static const gchar *session_methods[] =
+{
+    "logging/setLevel",
+    "resources/subscribe",
+    "resources/unsubscribe",
+    NULL
+};
+
+#define INITIALIZED_NOTIFICATION \
+    "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}"
+
+#define PARSE_ERROR_REPLY \
+    "{\"jsonrpc\":\"2.0\",\"id\":null," \
+    "\"error\":{\"code\":-32700,\"message\":\"Parse error\"}}"
+
+static void
+route_free (gpointer data)
+{
+    Route *route = data;
+
+    g_free (route->raw_id);
+    g_free (route);
+}
+
+static void
+upstream_free (gpointer data)
+{
+    Upstream *up = data;
+
+    g_signal_handlers_disconnect_by_data (up->transport, up);
+    g_clear_object (&up->transport);
+    g_free (up->init_id);
+    g_free (up);
+}
+
+static void
+proxy_shutdown (ProxyContext *ctx,
+                gint          exit_code)
+{
+    if (ctx->shutting_down)
+    {
+        return;
+    }
+
+    ctx->shutting_down = TRUE;
+    ctx->exit_code = exit_code;
+    g_cancellable_cancel (ctx->cancellable);
+    g_main_loop_quit (ctx->loop);
+}
 
 /* ========================================================================== */
-/* Forward message helper                                                      */
+/* Envelope scanning                                                           */
 /* ========================================================================== */
 
+/*
+ * Envelope:
+ *
+ * The members of a JSON-RPC message the proxy routes on, located as
+ * byte spans in the raw line.  The method span excludes the quotes.
+ */
 typedef struct
 {
-    ProxyContext *ctx;
-    McpTransport *target;
-    gchar        *direction;  /* "local->remote" or "remote->local" */
-} ForwardData;
+    gboolean has_id;
+    gsize    id_start;
+    gsize    id_len;
+    gboolean has_method;
+    gsize    method_start;
+    gsize    method_len;
+} Envelope;
+
+static gsize
+skip_ws (const gchar *s,
+         gsize        len,
+         gsize        pos)
+{
+    while (pos < len &&
+           (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\r' || s[pos] == '\n'))
+    {
+        pos++;
+    }
+
+    return pos;
+}
+
+static gboolean
+skip_string (const gchar *s,
+             gsize        len,
+             gsize       *pos)
+{
+    gsize i = *pos + 1;
+
+    while (i < len)
+    {
+        if (s[i] == '\\')
+        {
+            i += 2;
+            continue;
+        }
+        if (s[i] == '"')
+        {
+            *pos = i + 1;
+            return TRUE;
+        }
+        if ((guchar) s[i] < 0x20)
+        {
+            return FALSE;
+        }
+        i++;
+    }
+
+    return FALSE;
+}
+
+/*
+ * skip_value:
+ *
+ * Advances past one JSON value.  Containers are only checked for
+ * balanced brackets; their contents belong to the server to validate.
+ */
+static gboolean
+skip_value (const gchar *s,
+            gsize        len,
+            gsize       *pos)
+{
+    gsize i = *pos;
+    guint depth = 0;
+
+    if (i >= len)
+    {
+        return FALSE;
+    }
+
+    if (s[i] == '"')
+    {
+        return skip_string (s, len, pos);
+    }
+
+    if (s[i] != '{' && s[i] != '[')
+    {
+        /* number, true, false or null */
+        while (i < len && (g_ascii_isalnum (s[i]) || s[i] == '-' ||
+                           s[i] == '+' || s[i] == '.'))
+        {
+            i++;
+        }
+        if (i == *pos)
+        {
+            return FALSE;
+        }
+        *pos = i;
+        return TRUE;
+    }
+
+    while (i < len)
+    {
+        if (s[i] == '"')
+        {
+            if (!skip_string (s, len, &i))
+            {
+                return FALSE;
+            }
+            continue;
+        }
+        if (s[i] == '{' || s[i] == '[')
+        {
+            depth++;
+        }
+        else if (s[i] == '}' || s[i] == ']')
+        {
+            if (--depth == 0)
+            {
+                *pos = i + 1;
+                return TRUE;
+            }
+        }
+        i++;
+    }
+
+    return FALSE;
+}
+
+static gboolean
+key_is (const gchar *s,
+        gsize        start,
+        gsize        len,
+        const gchar *key)
+{
+    return strlen (key) == len && memcmp (s + start, key, len) == 0;
+}
+
+/*
+ * scan_envelope:
+ *
+ * Checks that @s is a single JSON object with a "jsonrpc" member and
+ * an "id" or "method", and records where those live.
+ */
+static gboolean
+scan_envelope (const gchar *s,
+               gsize        len,
+               Envelope    *env)
+{
+    gboolean has_jsonrpc = FALSE;
+    gsize pos;
+
+    memset (env, 0, sizeof (*env));
+
+    pos = skip_ws (s, len, 0);
+    if (pos >= len || s[pos] != '{')
+    {
+        return FALSE;
+    }
+    pos = skip_ws (s, len, pos + 1);
+
+    for (;;)
+    {
+        gsize key_start;
+        gsize key_len;
+        gsize value_start;
+
+        if (pos >= len || s[pos] != '"')
+        {
+            return FALSE;
+        }
+        key_start = pos + 1;
+        if (!skip_string (s, len, &pos))
+        {
+            return FALSE;
+        }
+        key_len = pos - key_start - 1;
+
+        pos = skip_ws (s, len, pos);
+        if (pos >= len || s[pos] != ':')
+        {
+            return FALSE;
+        }
+        pos = skip_ws (s, len, pos + 1);
+
+        value_start = pos;
+        if (!skip_value (s, len, &pos))
+        {
+            return FALSE;
+        }
+
+        if (key_is (s, key_start, key_len, "id"))
+        {
+            env->has_id = TRUE;
+            env->id_start = value_start;
+            env->id_len = pos - value_start;
+        }
+        else if (key_is (s, key_start, key_len, "method"))
+        {
+            if (s[value_start] != '"')
+            {
+                return FALSE;
+            }
+            env->has_method = TRUE;
+            env->method_start = value_start + 1;
+            env->method_len = pos - value_start - 2;
+        }
+        else if (key_is (s, key_start, key_len, "jsonrpc"))
+        {
+            has_jsonrpc = TRUE;
+        }
+
+        pos = skip_ws (s, len, pos);
+        if (pos < len && s[pos] == ',')
+        {
+            pos = skip_ws (s, len, pos + 1);
+            continue;
+        }
+        if (pos < len && s[pos] == '}')
+        {
+            break;
+        }
+        return FALSE;
+    }
+
+    pos = skip_ws (s, len, pos + 1);
+
+    return pos == len && has_jsonrpc && (env->has_id || env->has_method);
+}
+
+static gboolean
+method_is (const gchar    *s,
+           const Envelope *env,
+           const gchar    *method)
+{
+    return env->has_method &&
+           key_is (s, env->method_start, env->method_len, method);
+}
+
+/*
+ * splice_id:
+ *
+ * Returns a copy of @line with its id replaced by @raw_id, which must
+ * already be JSON text (e.g. a quoted string).
+ */
+static GBytes *
+splice_id (GBytes         *line,
+           const Envelope *env,
+           const gchar    *raw_id)
+{
+    const gchar *s;
+    gsize len;
+    GString *out;
+
+    s = g_bytes_get_data (line, &len);
+    out = g_string_sized_new (len + strlen (raw_id));
+    g_string_append_len (out, s, env->id_start);
+    g_string_append (out, raw_id);
+    g_string_append_len (out, s + env->id_start + env->id_len,
+                         len - env->id_start - env->id_len);
+
+    return g_string_free_to_bytes (out);
+}
+
+/* ========================================================================== */
+/* Local (stdout) writer                                                       */
+/* ========================================================================== */
+
+static void flush_stdout (ProxyContext *ctx);
+
+static void
+on_stdout_written (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+    ProxyContext *ctx = user_data;
+    g_autoptr(GError) error = NULL;
+
+    if (!g_output_stream_write_all_finish (G_OUTPUT_STREAM (source), result,
+                                           NULL, &error))
+    {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_printerr ("Failed to write to stdout: %s\n", error->message);
+            proxy_shutdown (ctx, EXIT_ERROR_CODE);
+        }
+        return;
+    }
+
+    g_clear_pointer (&ctx->out_flight, g_bytes_unref);
+    flush_stdout (ctx);
+}
+
+static void
+flush_stdout (ProxyContext *ctx)
+{
+    gconstpointer data;
+    gsize size;
+
+    if (ctx->out_flight != NULL || ctx->out_pending->len == 0)
+    {
+        return;
+    }
+
+    /* Everything queued since the last write goes out in one call */
+    ctx->out_flight = g_string_free_to_bytes (ctx->out_pending);
+    ctx->out_pending = g_string_new (NULL);
+
+    data = g_bytes_get_data (ctx->out_flight, &size);
+    g_output_stream_write_all_async (ctx->stdout_stream, data, size,
+                                     G_PRIORITY_DEFAULT, ctx->cancellable,
+                                     on_stdout_written, ctx);
+}
+
+static gboolean
+flush_stdout_idle (gpointer user_data)
+{
+    ProxyContext *ctx = user_data;
+
+    ctx->flush_id = 0;
+    flush_stdout (ctx);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+queue_stdout (ProxyContext *ctx,
+              const gchar  *json,
+              gsize         len)
+{
+    g_string_append_len (ctx->out_pending, json, len);
+    g_string_append_c (ctx->out_pending, '\n');
+
+    if (ctx->out_flight == NULL && ctx->flush_id == 0)
+    {
+        ctx->flush_id = g_idle_add (flush_stdout_idle, ctx);
+    }
+}
+
+/* ========================================================================== */
+/* Forwarding to upstreams                                                     */
+/* ========================================================================== */
 
 static void
 on_forward_complete (GObject      *source,
                      GAsyncResult *result,
                      gpointer      user_data)
 {
-    ForwardData *data = user_data;
+    Upstream *up = user_data;
     g_autoptr(GError) error = NULL;
 
-    if (!mcp_transport_send_message_finish (MCP_TRANSPORT (source), result, &error))
+    if (!mcp_transport_send_raw_finish (MCP_TRANSPORT (source), result, &error))
     {
-        if (!data->ctx->shutting_down)
+        if (!up->ctx->shutting_down)
         {
-            g_printerr ("Failed to forward message (%s): %s\n",
-                        data->direction, error->message);
+            g_printerr ("Failed to forward message (local->remote %u): %s\n",
+                        up->index, error->message);
         }
     }
+}
 
-    g_free (data->direction);
-    g_free (data);
+static void
+send_to_upstream (Upstream *up,
+                  GBytes   *line)
+{
+    mcp_transport_send_raw_async (up->transport, line, NULL,
+                                  on_forward_complete, up);
 }
 
+/*
+ * send_replayed:
+ *
+ * Sends a copy of a logged client request to @up under a proxy-owned
+ * id, so the upstream's answer can be recognized and dropped.
+ */
 static void
-forward_message (ProxyContext *ctx,
-                 McpTransport *target,
-                 JsonNode     *message,
-                 const gchar  *direction)
+send_replayed (Upstream *up,
+               GBytes   *line)
 {
-    ForwardData *data;
+    ProxyContext *ctx = up->ctx;
+    const gchar *s;
+    gsize len;
+    Envelope env;
+    gchar *id;
+    g_autofree gchar *raw_id = NULL;
+    g_autoptr(GBytes) copy = NULL;
+
+    s = g_bytes_get_data (line, &len);
+    if (!scan_envelope (s, len, &env))
+    {
+        return;
+    }
 
-    data = g_new0 (ForwardData, 1);
-    data->ctx = ctx;
-    data->target = target;
-    data->direction = g_strdup (direction);
+    id = g_strdup_printf ("mcp-remote-client-%u-%u", up->index, ++ctx->seq);
+    raw_id = g_strdup_printf ("\"%s\"", id);
+    g_hash_table_add (ctx->swallowed, id);
 
-    mcp_transport_send_message_async (target, message, NULL,
-                                      on_forward_complete, data);
+    copy = splice_id (line, &env, raw_id);
+    send_to_upstream (up, copy);
 }
 
-/* ========================================================================== */
-/* Transport signal handlers                                                   */
-/* ========================================================================== */
+static void
+start_replay (Upstream *up)
+{
+    ProxyContext *ctx = up->ctx;
+    GBytes *initialize;
+    const gchar *s;
+    gsize len;
+    Envelope env;
+    g_autofree gchar *raw_id = NULL;
+    g_autoptr(GBytes) copy = NULL;
+
+    initialize = g_ptr_array_index (ctx->session_log, 0);
+    s = g_bytes_get_data (initialize, &len);
+    if (!scan_envelope (s, len, &env))
+    {
+        return;
+    }
+
+    up->init_id = g_strdup_printf ("mcp-remote-client-init-%u", up->index);
+    raw_id = g_strdup_printf ("\"%s\"", up->init_id);
+    up->state = UPSTREAM_INITIALIZING;
+
+    copy = splice_id (initialize, &env, raw_id);
+    send_to_upstream (up, copy);
+}
 
 static void
-on_stdio_message_received (McpTransport *transport,
-                           JsonNode     *message,
-                           ProxyContext *ctx)
+finish_replay (Upstream *up,
+               gboolean  failed)
 {
-    /* Forward messages from local (stdio) to remote */
-    if (ctx->remote_connected && !ctx->shutting_down)
+    ProxyContext *ctx = up->ctx;
+    g_autoptr(GBytes) initialized = NULL;
+    guint i;
+
+    if (failed)
     {
-        forward_message (ctx, ctx->remote_transport, message, "local->remote");
+        g_printerr ("Upstream %u rejected initialize, not using it\n", up->index);
+        up->state = UPSTREAM_DEAD;
+        return;
     }
+
+    initialized = g_bytes_new_static (INITIALIZED_NOTIFICATION,
+                                      strlen (INITIALIZED_NOTIFICATION));
+    send_to_upstream (up, initialized);
+
+    /* Bring the session up to date with anything set since initialize */
+    for (i = 1; i < ctx->session_log->len; i++)
+    {
+        send_replayed (up, g_ptr_array_index (ctx->session_log, i));
+    }
+
+    up->state = UPSTREAM_READY;
+}
+
+static Upstream *
+next_ready_upstream (ProxyContext *ctx)
+{
+    guint n = ctx->upstreams->len;
+    guint i;
+
+    for (i = 0; i < n; i++)
+    {
+        guint index = (ctx->next_upstream + i) % n;
+        Upstream *up = g_ptr_array_index (ctx->upstreams, index);
+
+        if (up->state == UPSTREAM_READY)
+        {
+            ctx->next_upstream = (index + 1) % n;
+            return up;
+        }
+    }
+
+    return g_ptr_array_index (ctx->upstreams, 0);
+}
+
+static gboolean
+is_session_method (const gchar    *s,
+                   const Envelope *env)
+{
+    guint i;
+
+    for (i = 0; session_methods[i] != NULL; i++)
+    {
+        if (method_is (s, env, session_methods[i]))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
 }
 
 static void
-on_remote_message_received (McpTransport *transport,
-                            JsonNode     *message,
-                            ProxyContext *ctx)
+forward_client_request (ProxyContext   *ctx,
+                        GBytes         *line,
+                        const gchar    *s,
+                        const Envelope *env)
 {
-    /* Forward messages from remote to local (stdio) */
-    if (!ctx->shutting_down)
+    Upstream *primary = g_ptr_array_index (ctx->upstreams, 0);
+    guint i;
+
+    if (method_is (s, env, "initialize"))
     {
-        forward_message (ctx, ctx->stdio_transport, message, "remote->local");
+        g_ptr_array_set_size (ctx->session_log, 0);
+        g_ptr_array_add (ctx->session_log, g_bytes_ref (line));
+        send_to_upstream (primary, line);
+
+        for (i = 1; i < ctx->upstreams->len; i++)
+        {
+            Upstream *up = g_ptr_array_index (ctx->upstreams, i);
+
+            if (up->state == UPSTREAM_IDLE)
+            {
+                start_replay (up);
+            }
+        }
+        return;
+    }
+
+    if (is_session_method (s, env))
+    {
+        /* Per-session state: the client sees upstream 0's answer, the
+         * others get a replayed copy so notifications stay consistent. */
+        g_ptr_array_add (ctx->session_log, g_bytes_ref (line));
+        send_to_upstream (primary, line);
+
+        for (i = 1; i < ctx->upstreams->len; i++)
+        {
+            Upstream *up = g_ptr_array_index (ctx->upstreams, i);
+
+            if (up->state == UPSTREAM_READY)
+            {
+                send_replayed (up, line);
+            }
+        }
+        return;
     }
+
+    send_to_upstream (next_ready_upstream (ctx), line);
 }
 
 static void
-on_stdio_state_changed (McpTransport      *transport,
-                        McpTransportState  old_state,
-                        McpTransportState  new_state,
-                        ProxyContext      *ctx)
+forward_client_response (ProxyContext   *ctx,
+                         GBytes         *line,
+                         const gchar    *s,
+                         const Envelope *env)
 {
-    if (new_state == MCP_TRANSPORT_STATE_DISCONNECTED && !ctx->shutting_down)
+    g_autofree gchar *key = NULL;
+    Route *route;
+
+    key = g_strndup (s + env->id_start, env->id_len);
+    route = g_hash_table_lookup (ctx->routes, key);
+
+    if (route == NULL)
     {
-        if (!opt_quiet)
+        send_to_upstream (g_ptr_array_index (ctx->upstreams, 0), line);
+        return;
+    }
+
+    if (route->upstream->state != UPSTREAM_DEAD)
+    {
+        if (route->raw_id != NULL)
         {
-            g_printerr ("Local transport disconnected, shutting down\n");
+            g_autoptr(GBytes) copy = splice_id (line, env, route->raw_id);
+
+            send_to_upstream (route->upstream, copy);
+        }
+        else
+        {
+            send_to_upstream (route->upstream, line);
         }
-        ctx->shutting_down = TRUE;
-        g_main_loop_quit (ctx->loop);
     }
+
+    g_hash_table_remove (ctx->routes, key);
 }
 
 static void
-on_remote_state_changed (McpTransport      *transport,
-                         McpTransportState  old_state,
-                         McpTransportState  new_state,
-                         ProxyContext      *ctx)
+handle_client_line (ProxyContext *ctx,
+                    GBytes       *line)
 {
-    if (new_state == MCP_TRANSPORT_STATE_CONNECTED)
+    const gchar *s;
+    gsize len;
+    Envelope env;
+    guint i;
+
+    s = g_bytes_get_data (line, &len);
+    if (skip_ws (s, len, 0) == len)
+    {
+        return;
+    }
+
+    if (!scan_envelope (s, len, &env))
     {
-        ctx->remote_connected = TRUE;
         if (!opt_quiet)
         {
-            g_printerr ("Connected to remote server\n");
+            g_printerr ("Rejecting malformed message from stdin\n");
         }
+        queue_stdout (ctx, PARSE_ERROR_REPLY, strlen (PARSE_ERROR_REPLY));
+        return;
+    }
+
+    if (env.has_method && env.has_id)
+    {
+        forward_client_request (ctx, line, s, &env);
     }
-    else if (new_state == MCP_TRANSPORT_STATE_DISCONNECTED && !ctx->shutting_down)
+    else if (env.has_method)
     {
-        if (!opt_quiet)
+        /* Notifications (initialized, cancelled, ...) go to every
+         * session; upstreams still initializing get theirs on replay. */
+        for (i = 0; i < ctx->upstreams->len; i++)
         {
-            g_printerr ("Remote transport disconnected, shutting down\n");
+            Upstream *up = g_ptr_array_index (ctx->upstreams, i);
+
+            if (up->state == UPSTREAM_READY)
+            {
+                send_to_upstream (up, line);
+            }
         }
-        ctx->shutting_down = TRUE;
-        ctx->exit_code = EXIT_ERROR_CODE;
-        g_main_loop_quit (ctx->loop);
     }
+    else
+    {
+        forward_client_response (ctx, line, s, &env);
+    }
+}
+
+/* ========================================================================== */
+/* Local (stdin) reader                                                        */
+/* ========================================================================== */
+
+static void read_next_line (ProxyContext *ctx);
+
+static gboolean
+has_buffered_line (GDataInputStream *in)
+{
+    gconstpointer buffer;
+    gsize available;
+
+    buffer = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (in),
+                                                  &available);
+
+    return available > 0 && memchr (buffer, '\n', available) != NULL;
 }
 
 static void
-on_remote_error (McpTransport *transport,
-                 GError       *error,
-                 ProxyContext *ctx)
+on_stdin_line (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
 {
+    ProxyContext *ctx = user_data;
+    GDataInputStream *in = G_DATA_INPUT_STREAM (source);
+    g_autoptr(GError) error = NULL;
+    gchar *line;
+    gsize length;
+
+    line = g_data_input_stream_read_line_finish (in, result, &length, &error);
+    if (line == NULL)
+    {
+        if (error != NULL)
+        {
+            if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            {
+                return;
+            }
+            g_printerr ("Local transport error: %s\n", error->message);
+            proxy_shutdown (ctx, EXIT_ERROR_CODE);
+            return;
+        }
+
+        if (!opt_quiet)
+        {
+            g_printerr ("Local transport disconnected, shutting down\n");
+        }
+        proxy_shutdown (ctx, EXIT_SUCCESS_CODE);
+        return;
+    }
+
+    /*
+     * Forward the whole batch that arrived with this wakeup: every
+     * complete line already buffered is handled before going back to
+     * the main loop, so a burst costs one iteration, not one per line.
+     */
+    for (;;)
+    {
+        g_autoptr(GBytes) bytes = g_bytes_new_take (line, length);
+
+        handle_client_line (ctx, bytes);
+
+        if (ctx->shutting_down || !has_buffered_line (in))
+        {
+            break;
+        }
+
+        line = g_data_input_stream_read_line (in, &length, NULL, &error);
+        if (line == NULL)
+        {
+            break;
+        }
+    }
+
     if (!ctx->shutting_down)
     {
-        g_printerr ("Remote transport error: %s\n", error->message);
+        read_next_line (ctx);
     }
 }
 
 static void
-on_stdio_error (McpTransport *transport,
-                GError       *error,
-                ProxyContext *ctx)
+read_next_line (ProxyContext *ctx)
 {
-    if (!ctx->shutting_down)
+    g_data_input_stream_read_line_async (ctx->stdin_data, G_PRIORITY_DEFAULT,
+                                         ctx->cancellable, on_stdin_line, ctx);
+}
+
+/* ========================================================================== */
+/* Transport signal handlers                                                   */
+/* ========================================================================== */
+
+/*
+ * route_server_request:
+ *
+ * Remembers which upstream a server-initiated request came from.
+ * Secondary upstreams get their ids renamed, since their counters
+ * overlap with upstream 0's.  Returns the message to forward.
+ */
+static JsonNode *
+route_server_request (Upstream *up,
+                      JsonNode *message,
+                      JsonNode *id_node)
+{
+    ProxyContext *ctx = up->ctx;
+    Route *route;
+    JsonNode *copy;
+    g_autofree gchar *proxy_id = NULL;
+
+    route = g_new0 (Route, 1);
+    route->upstream = up;
+
+    if (up->index == 0)
     {
-        g_printerr ("Local transport error: %s\n", error->message);
+        g_hash_table_replace (ctx->routes, json_to_string (id_node, FALSE), route);
+        return json_node_ref (message);
+    }
+
+    route->raw_id = json_to_string (id_node, FALSE);
+    proxy_id = g_strdup_printf ("mcp-remote-client-%u-%u", up->index, ++ctx->seq);
+    g_hash_table_replace (ctx->routes, g_strdup_printf ("\"%s\"", proxy_id), route);
+
+    copy = json_node_copy (message);
+    json_object_set_string_member (json_node_get_object (copy), "id", proxy_id);
+
+    return copy;
+}
+
+static void
+on_remote_message_received (McpTransport *transport,
+                            JsonNode     *message,
+                            Upstream     *up)
+{
+    ProxyContext *ctx = up->ctx;
+    g_autoptr(JsonNode) forward = NULL;
+    g_autofree gchar *json = NULL;
+    JsonObject *obj;
+    JsonNode *id_node;
+    const gchar *method = NULL;
+
+    if (ctx->shutting_down || !JSON_NODE_HOLDS_OBJECT (message))
+    {
+        return;
+    }
+
+    obj = json_node_get_object (message);
+    id_node = json_object_get_member (obj, "id");
+    if (json_object_has_member (obj, "method"))
+    {
+        method = json_object_get_string_member (obj, "method");
+    }
+
+    if (method == NULL && id_node != NULL &&
+        JSON_NODE_HOLDS_VALUE (id_node) &&
+        json_node_get_value_type (id_node) == G_TYPE_STRING)
+    {
+        const gchar *id = json_node_get_string (id_node);
+
+        if (up->state == UPSTREAM_INITIALIZING && g_strcmp0 (id, up->init_id) == 0)
+        {
+            finish_replay (up, json_object_has_member (obj, "error"));
+            return;
+        }
+        if (g_hash_table_remove (ctx->swallowed, id))
+        {
+            return;
+        }
+    }
+
+    if (method != NULL && id_node != NULL)
+    {
+        forward = route_server_request (up, message, id_node);
+    }
+    else if (method != NULL && up->index > 0 &&
+             g_str_has_suffix (method, "/list_changed"))
+    {
+        /* Every session reports the same change; upstream 0's is enough */
+        return;
+    }
+    else
+    {
+        forward = json_node_ref (message);
+    }
+
+    json = json_to_string (forward, FALSE);
+    queue_stdout (ctx, json, strlen (json));
+}
+
+static void
+on_remote_state_changed (McpTransport      *transport,
+                         McpTransportState  old_state,
+                         McpTransportState  new_state,
+                         Upstream          *up)
+{
+    if (up->ctx->shutting_down ||
+        (new_state != MCP_TRANSPORT_STATE_DISCONNECTED &&
+         new_state != MCP_TRANSPORT_STATE_ERROR) ||
+        up->state == UPSTREAM_CONNECTING)
+    {
+        return;
+    }
+
+    if (up->index > 0)
+    {
+        g_printerr ("Upstream %u disconnected, continuing without it\n", up->index);
+        up->state = UPSTREAM_DEAD;
+        return;
+    }
+
+    if (!opt_quiet)
+    {
+        g_printerr ("Remote transport disconnected, shutting down\n");
+    }
+    proxy_shutdown (up->ctx, EXIT_ERROR_CODE);
+}
+
+static void
+on_remote_error (McpTransport *transport,
+                 GError       *error,
+                 Upstream     *up)
+{
+    if (!up->ctx->shutting_down)
+    {
+        g_printerr ("Remote transport error: %s\n", error->message);
     }
 }
 
@@ -255,24 +1078,43 @@ on_remote_connect_complete (GObject      *source,
                             GAsyncResult *result,
                             gpointer      user_data)
 {
-    ProxyContext *ctx = user_data;
+    Upstream *up = user_data;
+    ProxyContext *ctx = up->ctx;
     g_autoptr(GError) error = NULL;
 
     if (!mcp_transport_connect_finish (MCP_TRANSPORT (source), result, &error))
     {
+        if (up->index > 0)
+        {
+            g_printerr ("Failed to open upstream %u: %s\n", up->index, error->message);
+            up->state = UPSTREAM_DEAD;
+            return;
+        }
+
         g_printerr ("Failed to connect to remote server: %s\n", error->message);
-        ctx->exit_code = EXIT_ERROR_CODE;
-        g_main_loop_quit (ctx->loop);
+        proxy_shutdown (ctx, EXIT_ERROR_CODE);
         return;
     }
 
-    /* Remote is connected, now start the stdio transport */
+    if (up->index > 0)
+    {
+        up->state = UPSTREAM_IDLE;
+        if (ctx->session_log->len > 0)
+        {
+            start_replay (up);
+        }
+        return;
+    }
+
+    /* Remote is connected, now start reading stdin */
+    up->state = UPSTREAM_READY;
+
     if (!opt_quiet)
     {
-        g_printerr ("Remote connected, starting local stdio transport\n");
+        g_printerr ("Connected to remote server\n");
     }
 
-    mcp_transport_connect_async (ctx->stdio_transport, NULL, NULL, NULL);
+    read_next_line (ctx);
 }
 
 /* ========================================================================== */
@@ -327,6 +1169,7 @@ static const gchar *description =
     "  mcp-remote-client --http https://api.example.com/mcp\n"
     "  mcp-remote-client --ws wss://api.example.com/mcp\n"
     "  mcp-remote-client -h https://api.example.com/mcp -t \"Bearer token\"\n"
+    "  mcp-remote-client --http https://api.example.com/mcp --connections 4\n"
     "\n"
     "Exit codes:\n"
     "  0  Clean shutdown\n"
@@ -340,9 +1183,9 @@ main (int    argc,
 {
     g_autoptr(GOptionContext) context = NULL;
     g_autoptr(GError) error = NULL;
-    g_autoptr(McpTransport) stdio_transport = NULL;
-    g_autoptr(McpTransport) remote_transport = NULL;
+    g_autoptr(GInputStream) stdin_stream = NULL;
     ProxyContext ctx;
+    gint i;
 
     /* Parse command line options */
     context = g_option_context_new (NULL);
@@ -378,47 +1221,72 @@ main (int    argc,
         return EXIT_ERROR_CODE;
     }
 
-    /* Create remote transport */
-    remote_transport = create_remote_transport (&error);
-    if (remote_transport == NULL)
+    if (opt_connections < 1 || opt_connections > MAX_CONNECTIONS)
     {
-        g_printerr ("Error: %s\n", error->message);
+        g_printerr ("Error: --connections must be between 1 and %d\n",
+                    MAX_CONNECTIONS);
         return EXIT_ERROR_CODE;
     }
 
-    /* Create stdio transport for local side */
-    stdio_transport = MCP_TRANSPORT (mcp_stdio_transport_new ());
-
     /* Initialize context */
     memset (&ctx, 0, sizeof (ctx));
     ctx.loop = g_main_loop_new (NULL, FALSE);
-    ctx.stdio_transport = stdio_transport;
-    ctx.remote_transport = remote_transport;
+    ctx.cancellable = g_cancellable_new ();
+    ctx.upstreams = g_ptr_array_new_with_free_func (upstream_free);
+    ctx.out_pending = g_string_new (NULL);
+    ctx.session_log = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+    ctx.routes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, route_free);
+    ctx.swallowed = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
     ctx.exit_code = EXIT_SUCCESS_CODE;
 
-    /* Connect signal handlers */
-    g_signal_connect (stdio_transport, "message-received",
-                      G_CALLBACK (on_stdio_message_received), &ctx);
-    g_signal_connect (stdio_transport, "state-changed",
-                      G_CALLBACK (on_stdio_state_changed), &ctx);
-    g_signal_connect (stdio_transport, "error",
-                      G_CALLBACK (on_stdio_error), &ctx);
-
-    g_signal_connect (remote_transport, "message-received",
-                      G_CALLBACK (on_remote_message_received), &ctx);
-    g_signal_connect (remote_transport, "state-changed",
-                      G_CALLBACK (on_remote_state_changed), &ctx);
-    g_signal_connect (remote_transport, "error",
-                      G_CALLBACK (on_remote_error), &ctx);
-
-    /* Start connection to remote server first */
+    /* Local side: raw lines in, coalesced writes out */
+    stdin_stream = g_unix_input_stream_new (STDIN_FILENO, FALSE);
+    ctx.stdin_data = g_data_input_stream_new (stdin_stream);
+    g_data_input_stream_set_newline_type (ctx.stdin_data,
+                                          G_DATA_STREAM_NEWLINE_TYPE_LF);
+    ctx.stdout_stream = g_unix_output_stream_new (STDOUT_FILENO, FALSE);
+
+    /* Create remote transports */
+    for (i = 0; i < opt_connections; i++)
+    {
+        Upstream *up;
+        McpTransport *transport;
+
+        transport = create_remote_transport (&error);
+        if (transport == NULL)
+        {
+            g_printerr ("Error: %s\n", error->message);
+            return EXIT_ERROR_CODE;
+        }
+
+        up = g_new0 (Upstream, 1);
+        up->ctx = &ctx;
+        up->transport = transport;
+        up->index = (guint) i;
+        up->state = UPSTREAM_CONNECTING;
+        g_ptr_array_add (ctx.upstreams, up);
+
+        g_signal_connect (transport, "message-received",
+                          G_CALLBACK (on_remote_message_received), up);
+        g_signal_connect (transport, "state-changed",
+                          G_CALLBACK (on_remote_state_changed), up);
+        g_signal_connect (transport, "error",
+                          G_CALLBACK (on_remote_error), up);
+    }
+
+    /* Connect all upstreams; stdin is read once upstream 0 is up */
     if (!opt_quiet)
     {
         g_printerr ("Connecting to remote server...\n");
     }
 
-    mcp_transport_connect_async (remote_transport, NULL,
-                                 on_remote_connect_complete, &ctx);
+    for (i = 0; i < opt_connections; i++)
+    {
+        Upstream *up = g_ptr_array_index (ctx.upstreams, i);
+
+        mcp_transport_connect_async (up->transport, ctx.cancellable,
+                                     on_remote_connect_complete, up);
+    }
 
     /* Run main loop */
     g_main_loop_run (ctx.loop);
@@ -426,16 +1294,30 @@ main (int    argc,
     /* Cleanup */
     ctx.shutting_down = TRUE;
 
-    if (mcp_transport_is_connected (remote_transport))
+    for (i = 0; i < opt_connections; i++)
     {
-        mcp_transport_disconnect_async (remote_transport, NULL, NULL, NULL);
+        Upstream *up = g_ptr_array_index (ctx.upstreams, i);
+
+        if (mcp_transport_is_connected (up->transport))
+        {
+            mcp_transport_disconnect_async (up->transport, NULL, NULL, NULL);
+        }
     }
 
-    if (mcp_transport_is_connected (stdio_transport))
+    if (ctx.flush_id != 0)
     {
-        mcp_transport_disconnect_async (stdio_transport, NULL, NULL, NULL);
+        g_source_remove (ctx.flush_id);
     }
 
+    g_hash_table_unref (ctx.swallowed);
+    g_hash_table_unref (ctx.routes);
+    g_ptr_array_unref (ctx.session_log);
+    g_clear_pointer (&ctx.out_flight, g_bytes_unref);
+    g_string_free (ctx.out_pending, TRUE);
+    g_object_unref (ctx.stdout_stream);
+    g_object_unref (ctx.stdin_data);
+    g_ptr_array_unref (ctx.upstreams);
+    g_object_unref (ctx.cancellable);
     g_main_loop_unref (ctx.loop);
 
     return ctx.exit_code;